@@ -0,0 +1,96 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file   iothub_client_callback_queue.h
+*    @brief  The @c callback_queue is a bounded ring of fixed-size items drained by a dedicated dispatch thread.
+*            Droppable items (messages, method calls) are held to the queue depth according to the overflow policy;
+*            other items (completions) are always accepted and grow the ring past the depth if they have to.
+*/
+
+#ifndef IOTHUB_CLIENT_CALLBACK_QUEUE_H
+#define IOTHUB_CLIENT_CALLBACK_QUEUE_H
+
+#include "umock_c/umock_c_prod.h"
+#include "azure_macro_utils/macro_utils.h"
+
+#include "iothub_client_core_common.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+extern "C" {
+#else
+#include <stddef.h>
+#include <stdbool.h>
+#endif
+
+typedef struct CALLBACK_QUEUE_TAG* CALLBACK_QUEUE_HANDLE;
+
+#define CALLBACK_QUEUE_PUSH_RESULT_VALUES   \
+    CALLBACK_QUEUE_PUSH_OK,                 \
+    CALLBACK_QUEUE_PUSH_REJECTED,           \
+    CALLBACK_QUEUE_PUSH_ERROR
+
+MU_DEFINE_ENUM_WITHOUT_INVALID(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_RESULT_VALUES);
+
+/**
+    * @brief    Receives the items of the queue, in order, on the dispatch thread.  @p is_dropped is true for items evicted
+    *           under IOTHUB_CLIENT_CALLBACK_QUEUE_DROP_OLDEST and for items still queued when the queue is destroyed, which the
+    *           owner settles without invoking the application.  The item is only valid for the duration of the call.
+    */
+typedef void(*CALLBACK_QUEUE_DISPATCH)(void* context, void* item, bool is_dropped);
+
+/**
+    * @brief    Creates the queue and starts its dispatch thread.
+    *
+    * @param    item_size   Size of an item.
+    * @param    depth       Number of droppable items the queue holds before @p overflow applies.
+    * @param    overflow    What @c callback_queue_push does with a droppable item when the queue is full.
+    * @param    dispatch    Invoked on the dispatch thread for every item.
+    * @param    context     Passed to @p dispatch.
+    *
+    * @return   A handle to the queue, or NULL on failure.
+    */
+MOCKABLE_FUNCTION(, CALLBACK_QUEUE_HANDLE, callback_queue_create, size_t, item_size, size_t, depth, IOTHUB_CLIENT_CALLBACK_QUEUE_OVERFLOW, overflow, CALLBACK_QUEUE_DISPATCH, dispatch, void*, context);
+
+/**
+    * @brief    Stops the dispatch thread once the item it is dispatching returns, passes the items still queued to the
+    *           dispatch function as dropped, on the calling thread, and frees the queue.
+    */
+MOCKABLE_FUNCTION(, void, callback_queue_destroy, CALLBACK_QUEUE_HANDLE, queue);
+
+/**
+    * @brief    Changes the overflow policy for items pushed from now on.
+    */
+MOCKABLE_FUNCTION(, int, callback_queue_set_overflow, CALLBACK_QUEUE_HANDLE, queue, IOTHUB_CLIENT_CALLBACK_QUEUE_OVERFLOW, overflow);
+
+/**
+    * @brief    Copies an item at the tail of the queue.  Never blocks: under IOTHUB_CLIENT_CALLBACK_QUEUE_BLOCK a full queue
+    *           accepts the item and the producer is expected to hold off with @c callback_queue_wait_for_room before
+    *           producing more.
+    *
+    * @param    queue           Handle to the queue.
+    * @param    item            The item, @c item_size bytes.
+    * @param    is_droppable    Whether the overflow policy applies to the item.
+    *
+    * @return   @c CALLBACK_QUEUE_PUSH_OK when the item was queued, @c CALLBACK_QUEUE_PUSH_REJECTED when a droppable item found the
+    *           queue full under IOTHUB_CLIENT_CALLBACK_QUEUE_REJECT, @c CALLBACK_QUEUE_PUSH_ERROR otherwise.
+    */
+MOCKABLE_FUNCTION(, CALLBACK_QUEUE_PUSH_RESULT, callback_queue_push, CALLBACK_QUEUE_HANDLE, queue, const void*, item, bool, is_droppable);
+
+/**
+    * @brief    Waits up to @p timeout_ms for the queue to drop below its depth.  Returns true right away when it already is.
+    *
+    * @return   true when there is room in the queue, false when the wait timed out or failed.
+    */
+MOCKABLE_FUNCTION(, bool, callback_queue_wait_for_room, CALLBACK_QUEUE_HANDLE, queue, unsigned int, timeout_ms);
+
+/**
+    * @brief    Gets the counters of the queue.
+    */
+MOCKABLE_FUNCTION(, int, callback_queue_get_statistics, CALLBACK_QUEUE_HANDLE, queue, IOTHUB_CLIENT_CALLBACK_QUEUE_STATISTICS*, statistics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTHUB_CLIENT_CALLBACK_QUEUE_H */
@@ -0,0 +1,55 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file   iothub_client_compression.h
+*    @brief  The @c compression stage deflates the body of device-to-cloud messages between
+*            IoTHubClientCore_LL_SendEventAsync and the transport, and labels them with the matching content encoding.
+*            It is only built with use_compression, since it needs zlib.
+*/
+
+#ifndef IOTHUB_CLIENT_COMPRESSION_H
+#define IOTHUB_CLIENT_COMPRESSION_H
+
+#include "umock_c/umock_c_prod.h"
+
+#include "iothub_message.h"
+#include "iothub_client_core_common.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+extern "C" {
+#else
+#include <stddef.h>
+#endif
+
+typedef struct COMPRESSION_TAG* COMPRESSION_HANDLE;
+
+/**
+    * @brief    Creates the stage with compression turned off (IOTHUB_CLIENT_COMPRESSION_NONE).
+    *
+    * @return   A handle to the stage, or NULL on failure.
+    */
+MOCKABLE_FUNCTION(, COMPRESSION_HANDLE, compression_create);
+
+MOCKABLE_FUNCTION(, void, compression_destroy, COMPRESSION_HANDLE, handle);
+
+/**
+    * @brief    Applies OPTION_COMPRESSION, OPTION_COMPRESSION_THRESHOLD, OPTION_COMPRESSION_LEVEL or OPTION_COMPRESSION_DICTIONARY.
+    *
+    * @return   0 upon success, non-zero for an unknown option or an invalid value.
+    */
+MOCKABLE_FUNCTION(, int, compression_set_option, COMPRESSION_HANDLE, handle, const char*, option_name, const void*, value);
+
+/**
+    * @brief    Compresses the body of @p message if compression is on, the message has no content encoding yet, its body
+    *           is at least the threshold and the compressed body is smaller.  The message is left unchanged otherwise.
+    *
+    * @return   0 upon success (whether or not the body was compressed), non-zero on failure.
+    */
+MOCKABLE_FUNCTION(, int, compression_compress_message, COMPRESSION_HANDLE, handle, IOTHUB_MESSAGE_HANDLE, message);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTHUB_CLIENT_COMPRESSION_H */
@@ -0,0 +1,82 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file   iothub_client_metrics.h
+*    @brief  The @c metrics registry counts what a client sends, receives and retries, and keeps a histogram of the time
+*            between IoTHubClientCore_LL_SendEventAsync and the confirmation of each message.  It is created by OPTION_METRICS;
+*            the core and the transports skip the accounting when the client has none.
+*/
+
+#ifndef IOTHUB_CLIENT_METRICS_H
+#define IOTHUB_CLIENT_METRICS_H
+
+#include "umock_c/umock_c_prod.h"
+
+#include "azure_c_shared_utility/tickcounter.h"
+
+#include "iothub_client_core_common.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+extern "C" {
+#else
+#include <stddef.h>
+#endif
+
+typedef struct METRICS_TAG* METRICS_HANDLE;
+
+#define METRICS_COUNTER_VALUES              \
+    METRICS_MESSAGES_ENQUEUED,              \
+    METRICS_MESSAGES_SENT,                  \
+    METRICS_MESSAGES_ACKNOWLEDGED,          \
+    METRICS_MESSAGES_FAILED,                \
+    METRICS_MESSAGES_TIMED_OUT,             \
+    METRICS_MESSAGES_DROPPED,               \
+    METRICS_MESSAGES_RECEIVED,              \
+    METRICS_BYTES_SENT,                     \
+    METRICS_BYTES_RECEIVED,                 \
+    METRICS_SEND_RETRIES,                   \
+    METRICS_RECONNECT_ATTEMPTS,             \
+    METRICS_DISCONNECTS
+
+MU_DEFINE_ENUM_WITHOUT_INVALID(METRICS_COUNTER, METRICS_COUNTER_VALUES);
+
+/**
+    * @brief    Creates the registry with all counters at zero.
+    *
+    * @return   A handle to the registry, or NULL on failure.
+    */
+MOCKABLE_FUNCTION(, METRICS_HANDLE, metrics_create);
+
+MOCKABLE_FUNCTION(, void, metrics_destroy, METRICS_HANDLE, handle);
+
+/**
+    * @brief    Adds @p value to @p counter.  Counters are updated without a lock and wrap around.
+    */
+MOCKABLE_FUNCTION(, void, metrics_add, METRICS_HANDLE, handle, METRICS_COUNTER, counter, size_t, value);
+
+/**
+    * @brief    Gets the time to stamp an enqueued message with, for metrics_record_send_complete.
+    *
+    * @return   Milliseconds since the registry was created, never 0.
+    */
+MOCKABLE_FUNCTION(, tickcounter_ms_t, metrics_get_current_ms, METRICS_HANDLE, handle);
+
+/**
+    * @brief    Counts the confirmation of a device-to-cloud message, and adds the time since @p enqueued_ms to the
+    *           latency histogram.  Messages enqueued before the registry existed (@p enqueued_ms 0) are only counted.
+    */
+MOCKABLE_FUNCTION(, void, metrics_record_send_complete, METRICS_HANDLE, handle, IOTHUB_CLIENT_CONFIRMATION_RESULT, result, tickcounter_ms_t, enqueued_ms);
+
+/**
+    * @brief    Copies the counters and the latency histogram into @p metrics.  The queue gauges are left to the caller.
+    *
+    * @return   0 upon success, non-zero otherwise.
+    */
+MOCKABLE_FUNCTION(, int, metrics_get_snapshot, METRICS_HANDLE, handle, IOTHUB_CLIENT_METRICS*, metrics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTHUB_CLIENT_METRICS_H */
@@ -46,6 +46,10 @@ typedef struct IOTHUB_MESSAGE_LIST_TAG
     DLIST_ENTRY entry;
     tickcounter_ms_t ms_timesOutAfter; /* a value of "0" means "no timeout", if the IOTHUBCLIENT_LL's handle tickcounter > msTimesOutAfer then the message shall timeout*/
     tickcounter_ms_t message_timeout_value;
+    tickcounter_ms_t ms_enqueued; /* metrics_get_current_ms at SendEventAsync, for the latency histogram; "0" when OPTION_METRICS was off */
+#ifdef USE_TRACING
+    uint64_t trace_id; /* iothub_client_trace_begin at SendEventAsync; "0" when no trace callback was set */
+#endif
 }IOTHUB_MESSAGE_LIST;
 
 typedef struct IOTHUB_DEVICE_TWIN_TAG
@@ -0,0 +1,113 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file   iothub_client_reported_aggregator.h
+*    @brief  The @c reported_aggregator coalesces reported property PATCHes.  PATCHes added during a flush
+*            interval are merged into a single document (last writer wins per key), members that would not
+*            change the last acknowledged reported state are dropped, and every original callback is completed
+*            with the status of the merged PATCH.  A PATCH setting an object where a pending PATCH deletes the member is
+*            not merged; it starts a new document, sent after the pending one.
+*/
+
+#ifndef IOTHUB_CLIENT_REPORTED_AGGREGATOR_H
+#define IOTHUB_CLIENT_REPORTED_AGGREGATOR_H
+
+#include "umock_c/umock_c_prod.h"
+#include "azure_macro_utils/macro_utils.h"
+#include "azure_c_shared_utility/tickcounter.h"
+
+#include "iothub_client_core_common.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+extern "C" {
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+typedef struct REPORTED_AGGREGATOR_TAG* REPORTED_AGGREGATOR_HANDLE;
+
+#define REPORTED_AGGREGATOR_FLUSH_RESULT_VALUES \
+    REPORTED_AGGREGATOR_FLUSH_IDLE,             \
+    REPORTED_AGGREGATOR_FLUSH_PATCH_READY,      \
+    REPORTED_AGGREGATOR_FLUSH_ERROR
+
+MU_DEFINE_ENUM_WITHOUT_INVALID(REPORTED_AGGREGATOR_FLUSH_RESULT, REPORTED_AGGREGATOR_FLUSH_RESULT_VALUES);
+
+/**
+    * @brief    Creates an empty aggregator.
+    *
+    * @param    flush_interval_ms   Time, in milliseconds, a PATCH may wait for others to be merged with it.
+    *
+    * @return   A handle to the aggregator, or NULL on failure.
+    */
+MOCKABLE_FUNCTION(, REPORTED_AGGREGATOR_HANDLE, reported_aggregator_create, uint32_t, flush_interval_ms);
+
+/**
+    * @brief    Completes the callbacks of PATCHes that were not flushed yet with @p status_code and frees the aggregator.
+    *           A merged PATCH still in flight remains valid and can be completed after the aggregator is destroyed.
+    */
+MOCKABLE_FUNCTION(, void, reported_aggregator_destroy, REPORTED_AGGREGATOR_HANDLE, handle, int, status_code);
+
+/**
+    * @brief    Changes the flush interval.  Takes effect on the next call to @c reported_aggregator_flush.
+    */
+MOCKABLE_FUNCTION(, int, reported_aggregator_set_flush_interval, REPORTED_AGGREGATOR_HANDLE, handle, uint32_t, flush_interval_ms);
+
+/**
+    * @brief    Merges a reported properties PATCH into the pending document.
+    *
+    * @param    handle          Handle to the aggregator.
+    * @param    reported_state  JSON object with the reported properties, not necessarily NULL terminated.
+    * @param    size            Size of @p reported_state.
+    * @param    callback        Invoked once the merged PATCH containing this one completes.  May be NULL.
+    * @param    context         Passed to @p callback.
+    * @param    now             Current time, used to start the flush interval of the first pending PATCH.
+    *
+    * @return   0 upon success, non-zero if @p reported_state is not a JSON object or on allocation failure.
+    */
+MOCKABLE_FUNCTION(, int, reported_aggregator_add, REPORTED_AGGREGATOR_HANDLE, handle, const unsigned char*, reported_state, size_t, size, IOTHUB_CLIENT_REPORTED_STATE_CALLBACK, callback, void*, context, tickcounter_ms_t, now);
+
+/**
+    * @brief    Produces the merged PATCH once the flush interval of the oldest pending PATCH has elapsed.  Only one merged
+    *           PATCH is in flight at a time; PATCHes added meanwhile keep being merged until it completes.
+    *
+    * @param    handle          Handle to the aggregator.
+    * @param    now             Current time.
+    * @param    patch           Set to the serialized PATCH when @c REPORTED_AGGREGATOR_FLUSH_PATCH_READY is returned.  The buffer is
+    *                           owned by the aggregator and valid until @c reported_aggregator_on_patch_complete is called.
+    * @param    size            Set to the size of @p patch.
+    * @param    batch_context   Set to the context to pass to @c reported_aggregator_on_patch_complete.
+    *
+    * @return   @c REPORTED_AGGREGATOR_FLUSH_PATCH_READY when a PATCH must be sent, @c REPORTED_AGGREGATOR_FLUSH_IDLE when there is
+    *           nothing to send yet (when every pending value was already acknowledged the callbacks are completed right away),
+    *           @c REPORTED_AGGREGATOR_FLUSH_ERROR otherwise.
+    */
+MOCKABLE_FUNCTION(, REPORTED_AGGREGATOR_FLUSH_RESULT, reported_aggregator_flush, REPORTED_AGGREGATOR_HANDLE, handle, tickcounter_ms_t, now, const unsigned char**, patch, size_t*, size, void**, batch_context);
+
+/**
+    * @brief    Completes a merged PATCH.  On a 2xx @p status_code the PATCH becomes part of the acknowledged state.  Every callback
+    *           merged into the PATCH is invoked with @p status_code.  Matches @c IOTHUB_CLIENT_REPORTED_STATE_CALLBACK.
+    */
+MOCKABLE_FUNCTION(, void, reported_aggregator_on_patch_complete, int, status_code, void*, batch_context);
+
+/**
+    * @brief    Returns true when there are no pending PATCHes and no merged PATCH in flight.
+    */
+MOCKABLE_FUNCTION(, bool, reported_aggregator_is_idle, REPORTED_AGGREGATOR_HANDLE, handle);
+
+/**
+    * @brief    Gets the time until @c reported_aggregator_flush produces the merged PATCH.
+    *
+    * @return   @c true with @p timeout_ms set (0 when the flush is due) while PATCHes are pending and no merged PATCH is in
+    *           flight, @c false otherwise.
+    */
+MOCKABLE_FUNCTION(, bool, reported_aggregator_get_flush_timeout, REPORTED_AGGREGATOR_HANDLE, handle, tickcounter_ms_t, now, tickcounter_ms_t*, timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTHUB_CLIENT_REPORTED_AGGREGATOR_H */
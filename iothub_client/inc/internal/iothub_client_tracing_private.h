@@ -0,0 +1,54 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file   iothub_client_tracing_private.h
+*    @brief  The trace points used along the device-to-cloud path.  Without USE_TRACING they expand to nothing, and
+*            IOTHUB_MESSAGE_LIST has no trace id.
+*/
+
+#ifndef IOTHUB_CLIENT_TRACING_PRIVATE_H
+#define IOTHUB_CLIENT_TRACING_PRIVATE_H
+
+#include "umock_c/umock_c_prod.h"
+
+#include "iothub_client_tracing.h"
+
+#ifdef __cplusplus
+#include <cstdint>
+extern "C" {
+#else
+#include <stdint.h>
+#endif
+
+#ifdef USE_TRACING
+
+/**
+    * @brief    Reports ENQUEUED for a new message.
+    *
+    * @return   The id to report the message's next trace points with, or 0 (not traced) when no callback is set.
+    */
+MOCKABLE_FUNCTION(, uint64_t, iothub_client_trace_begin);
+
+/**
+    * @brief    Reports @p point for the message @p message_id, unless it is 0.
+    */
+MOCKABLE_FUNCTION(, void, iothub_client_trace, IOTHUB_CLIENT_TRACE_POINT, point, uint64_t, message_id);
+
+#define IOTHUB_CLIENT_TRACE_BEGIN(message_list)             ((message_list)->trace_id = iothub_client_trace_begin())
+#define IOTHUB_CLIENT_TRACE(point, message_list)            iothub_client_trace((point), (message_list)->trace_id)
+#define IOTHUB_CLIENT_TRACE_COMPLETE(message_list, result)  \
+    iothub_client_trace(((result) == IOTHUB_CLIENT_CONFIRMATION_OK) ? IOTHUB_CLIENT_TRACE_ACKNOWLEDGED : IOTHUB_CLIENT_TRACE_ABANDONED, (message_list)->trace_id)
+
+#else
+
+#define IOTHUB_CLIENT_TRACE_BEGIN(message_list)             ((void)0)
+#define IOTHUB_CLIENT_TRACE(point, message_list)            ((void)0)
+#define IOTHUB_CLIENT_TRACE_COMPLETE(message_list, result)  ((void)0)
+
+#endif /* USE_TRACING */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTHUB_CLIENT_TRACING_PRIVATE_H */
@@ -0,0 +1,95 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file   iothub_client_twin_cache.h
+*    @brief  The @c twin_cache keeps a local copy of the device twin.  Desired property
+*            PATCHes are applied incrementally in $version order and properties can be looked up
+*            by component and name without re-parsing the document.
+*/
+
+#ifndef IOTHUB_CLIENT_TWIN_CACHE_H
+#define IOTHUB_CLIENT_TWIN_CACHE_H
+
+#include "umock_c/umock_c_prod.h"
+#include "azure_macro_utils/macro_utils.h"
+
+#include "iothub_client_core_common.h"
+#include "iothub_client_properties.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+extern "C" {
+#else
+#include <stddef.h>
+#endif
+
+typedef struct TWIN_CACHE_TAG* TWIN_CACHE_HANDLE;
+
+#define TWIN_CACHE_UPDATE_RESULT_VALUES \
+    TWIN_CACHE_UPDATE_OK,               \
+    TWIN_CACHE_UPDATE_VERSION_GAP,      \
+    TWIN_CACHE_UPDATE_ERROR
+
+MU_DEFINE_ENUM_WITHOUT_INVALID(TWIN_CACHE_UPDATE_RESULT, TWIN_CACHE_UPDATE_RESULT_VALUES);
+
+/**
+    * @brief    Creates an empty twin cache.  The cache is not populated until a complete twin is passed to @c twin_cache_update.
+    *
+    * @return   A handle to the cache, or NULL on failure.
+    */
+MOCKABLE_FUNCTION(, TWIN_CACHE_HANDLE, twin_cache_create);
+
+/**
+    * @brief    Frees the cached document and its index.
+    */
+MOCKABLE_FUNCTION(, void, twin_cache_destroy, TWIN_CACHE_HANDLE, handle);
+
+/**
+    * @brief    Applies a twin payload received from IoT Hub to the cache.
+    *
+    * @param    handle          Handle to the twin cache.
+    * @param    update_state    @c DEVICE_TWIN_UPDATE_COMPLETE replaces the cached document; @c DEVICE_TWIN_UPDATE_PARTIAL merges
+    *                           a desired properties PATCH into it.
+    * @param    payload         The JSON payload, not necessarily NULL terminated.
+    * @param    size            Size of @p payload.
+    *
+    * @return   @c TWIN_CACHE_UPDATE_OK when the cache is current (PATCHes older than the cached version are ignored),
+    *           @c TWIN_CACHE_UPDATE_VERSION_GAP when a PATCH cannot be applied because the cache is empty or one or more
+    *           PATCHes were missed and the complete twin must be fetched again, @c TWIN_CACHE_UPDATE_ERROR otherwise.
+    */
+MOCKABLE_FUNCTION(, TWIN_CACHE_UPDATE_RESULT, twin_cache_update, TWIN_CACHE_HANDLE, handle, DEVICE_TWIN_UPDATE_STATE, update_state, const unsigned char*, payload, size_t, size);
+
+/**
+    * @brief    Merges a reported properties PATCH acknowledged by IoT Hub into the reported section of the cache.
+    *
+    * @return   0 upon success (including when the cache is not yet populated), non-zero otherwise.
+    */
+MOCKABLE_FUNCTION(, int, twin_cache_apply_reported, TWIN_CACHE_HANDLE, handle, const unsigned char*, payload, size_t, size);
+
+/**
+    * @brief    Retrieves the desired properties $version of the cached twin.
+    *
+    * @return   0 upon success, non-zero if the cache is not populated.
+    */
+MOCKABLE_FUNCTION(, int, twin_cache_get_version, TWIN_CACHE_HANDLE, handle, int*, version);
+
+/**
+    * @brief    Looks up a single property in the cache.
+    *
+    * @param    handle              Handle to the twin cache.
+    * @param    propertyType        @c IOTHUB_CLIENT_PROPERTY_TYPE_WRITABLE for desired properties, @c IOTHUB_CLIENT_PROPERTY_TYPE_REPORTED_FROM_CLIENT for reported.
+    * @param    componentName       Name of the component, or NULL for the root component.
+    * @param    propertyName        Name of the property.
+    * @param    property            Filled in on success.  @c componentName and @c name point to the caller's strings and @c value.str is
+    *                               allocated; release it with @c IoTHubClient_Properties_DeserializerProperty_Destroy.
+    * @param    propertySpecified   Set to false if the property is not in the cache.
+    *
+    * @return   IOTHUB_CLIENT_OK upon success or an error code upon failure.
+    */
+MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, twin_cache_get_property, TWIN_CACHE_HANDLE, handle, IOTHUB_CLIENT_PROPERTY_TYPE, propertyType, const char*, componentName, const char*, propertyName, IOTHUB_CLIENT_PROPERTY_PARSED*, property, bool*, propertySpecified);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTHUB_CLIENT_TWIN_CACHE_H */
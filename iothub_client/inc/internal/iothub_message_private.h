@@ -11,6 +11,7 @@
 #include "azure_macro_utils/macro_utils.h"
 #include "umock_c/umock_c_prod.h"
 #include "iothub_message.h"
+#include "azure_c_shared_utility/buffer_.h"
 
 #ifdef __cplusplus
 #include <cstddef>
@@ -46,6 +47,40 @@ MOCKABLE_FUNCTION(, IOTHUB_MESSAGE_RESULT, IoTHubMessage_SetDispositionContext,
 */
 MOCKABLE_FUNCTION(, IOTHUB_MESSAGE_RESULT, IoTHubMessage_GetDispositionContext, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle, MESSAGE_DISPOSITION_CONTEXT_HANDLE*, dispositionContext);
 
+/**
+* @brief   Replaces the body of a message, which becomes an #IOTHUBMESSAGE_BYTEARRAY message.
+*
+* @param   iotHubMessageHandle                The message whose body is replaced.
+* @param   body                               The new body.  The message owns it once the call succeeds.
+*
+* @return  An #IOTHUB_MESSAGE_RESULT with the result of the operation.
+*/
+MOCKABLE_FUNCTION(, IOTHUB_MESSAGE_RESULT, IoTHubMessage_SetBody, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle, BUFFER_HANDLE, body);
+
+/**
+* @brief   Gets the number of application properties of a message, without going through IoTHubMessage_Properties.
+*
+* @param   iotHubMessageHandle                The message.
+* @param   count                              Receives the number of properties.
+*
+* @return  An #IOTHUB_MESSAGE_RESULT with the result of the operation.
+*/
+MOCKABLE_FUNCTION(, IOTHUB_MESSAGE_RESULT, IoTHubMessage_GetPropertyCount, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle, size_t*, count);
+
+/**
+* @brief   Gets the application properties of a message one by one, in the order they were set, without going through
+*          IoTHubMessage_Properties.  Start with *cursor set to 0 and call once per property reported by
+*          IoTHubMessage_GetPropertyCount.  The key and value stay valid until the properties of the message change.
+*
+* @param   iotHubMessageHandle                The message.
+* @param   cursor                             Where the iteration is; advanced past the property returned.
+* @param   key                                Receives the key of the property.
+* @param   value                              Receives the value of the property.
+*
+* @return  An #IOTHUB_MESSAGE_RESULT with the result of the operation; IOTHUB_MESSAGE_INVALID_ARG past the last property.
+*/
+MOCKABLE_FUNCTION(, IOTHUB_MESSAGE_RESULT, IoTHubMessage_GetNextProperty, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle, size_t*, cursor, const char**, key, const char**, value);
+
 #ifdef __cplusplus
 }
 #endif
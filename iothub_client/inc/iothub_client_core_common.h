@@ -128,6 +128,32 @@ typedef struct IOTHUB_CLIENT_LL_UPLOADTOBLOB_CONTEXT_STRUCT* IOTHUB_CLIENT_LL_UP
     */
     MU_DEFINE_ENUM_WITHOUT_INVALID(IOTHUBMESSAGE_DISPOSITION_RESULT, IOTHUBMESSAGE_DISPOSITION_RESULT_VALUES);
 
+#define IOTHUB_CLIENT_CALLBACK_QUEUE_OVERFLOW_VALUES    \
+    IOTHUB_CLIENT_CALLBACK_QUEUE_BLOCK,                 \
+    IOTHUB_CLIENT_CALLBACK_QUEUE_REJECT,                \
+    IOTHUB_CLIENT_CALLBACK_QUEUE_DROP_OLDEST
+
+    /** @brief Enumeration set with OPTION_CALLBACK_QUEUE_OVERFLOW to choose what the convenience layer does with a
+    *          cloud-to-device message or method call that arrives while its callback queue is full.
+    *   @remark @c IOTHUB_CLIENT_CALLBACK_QUEUE_BLOCK stops reading from the network until the application callbacks
+    *           catch up. @c IOTHUB_CLIENT_CALLBACK_QUEUE_REJECT refuses the new arrival: the transport settles a message
+    *           as it does when the message callback fails, and a method call gets an error response.
+    *           @c IOTHUB_CLIENT_CALLBACK_QUEUE_DROP_OLDEST evicts the oldest queued message or method call: the message is
+    *           abandoned and the method call answered with status 503, without invoking the application.
+    */
+    MU_DEFINE_ENUM_WITHOUT_INVALID(IOTHUB_CLIENT_CALLBACK_QUEUE_OVERFLOW, IOTHUB_CLIENT_CALLBACK_QUEUE_OVERFLOW_VALUES);
+
+#define IOTHUB_CLIENT_COMPRESSION_VALUES    \
+    IOTHUB_CLIENT_COMPRESSION_NONE,         \
+    IOTHUB_CLIENT_COMPRESSION_DEFLATE,      \
+    IOTHUB_CLIENT_COMPRESSION_GZIP
+
+    /** @brief Enumeration set with OPTION_COMPRESSION to choose how the bodies of device-to-cloud messages are compressed.
+    *   @remark @c IOTHUB_CLIENT_COMPRESSION_DEFLATE produces the zlib format (RFC 1950) and sets the content encoding of the
+    *           message to "deflate"; @c IOTHUB_CLIENT_COMPRESSION_GZIP produces the gzip format (RFC 1952) and sets it to "gzip".
+    */
+    MU_DEFINE_ENUM_WITHOUT_INVALID(IOTHUB_CLIENT_COMPRESSION, IOTHUB_CLIENT_COMPRESSION_VALUES);
+
 #define IOTHUB_CLIENT_IOTHUB_METHOD_STATUS_VALUES \
     IOTHUB_CLIENT_IOTHUB_METHOD_STATUS_SUCCESS,   \
     IOTHUB_CLIENT_IOTHUB_METHOD_STATUS_ERROR      \
@@ -387,6 +413,131 @@ typedef struct IOTHUB_CLIENT_LL_UPLOADTOBLOB_CONTEXT_STRUCT* IOTHUB_CLIENT_LL_UP
         const char* protocolGatewayHostName;
     } IOTHUB_CLIENT_CONFIG;
 
+    /** @brief    Preset dictionary set with OPTION_COMPRESSION_DICTIONARY.  The consumer of the messages needs the same bytes
+    *             to inflate them; the zlib header of every message carries the Adler-32 checksum of the dictionary.
+    */
+    typedef struct IOTHUB_CLIENT_COMPRESSION_DICTIONARY_TAG
+    {
+        const unsigned char* data;
+        size_t size;
+    } IOTHUB_CLIENT_COMPRESSION_DICTIONARY;
+
+    /** @brief    Counters of the callback queue of the convenience layer, see OPTION_CALLBACK_QUEUE_DEPTH. */
+    typedef struct IOTHUB_CLIENT_CALLBACK_QUEUE_STATISTICS_TAG
+    {
+        /** @brief    The depth set with OPTION_CALLBACK_QUEUE_DEPTH. */
+        size_t depth;
+
+        /** @brief    Callbacks waiting for the dispatch thread. */
+        size_t queued;
+
+        /** @brief    Highest value of @p queued seen. */
+        size_t peakQueued;
+
+        /** @brief    Callbacks accepted into the queue. */
+        size_t callbacksQueued;
+
+        /** @brief    Callbacks handed to the application. */
+        size_t callbacksDispatched;
+
+        /** @brief    Messages and method calls refused under IOTHUB_CLIENT_CALLBACK_QUEUE_REJECT. */
+        size_t callbacksRejected;
+
+        /** @brief    Messages and method calls evicted under IOTHUB_CLIENT_CALLBACK_QUEUE_DROP_OLDEST. */
+        size_t callbacksDropped;
+
+        /** @brief    Times the worker thread stopped reading from the network under IOTHUB_CLIENT_CALLBACK_QUEUE_BLOCK. */
+        size_t ioPauses;
+    } IOTHUB_CLIENT_CALLBACK_QUEUE_STATISTICS;
+
+    /** @brief    Number of buckets of the acknowledgement latency histogram of IOTHUB_CLIENT_METRICS.  Their upper bounds are
+    *             5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000 and 10000 milliseconds; the last bucket holds anything slower.
+    */
+#define IOTHUB_CLIENT_METRICS_LATENCY_BUCKET_COUNT 12
+
+    /** @brief    Counters of a client with OPTION_METRICS enabled, see IoTHubDeviceClient_LL_GetMetrics.  Counters only
+    *             grow (wrapping around at SIZE_MAX) from the time metrics were enabled.
+    */
+    typedef struct IOTHUB_CLIENT_METRICS_TAG
+    {
+        /** @brief    Device-to-cloud messages accepted by SendEventAsync. */
+        size_t messagesEnqueued;
+
+        /** @brief    Device-to-cloud messages handed to the network by the transport. */
+        size_t messagesSent;
+
+        /** @brief    Device-to-cloud messages confirmed with IOTHUB_CLIENT_CONFIRMATION_OK. */
+        size_t messagesAcknowledged;
+
+        /** @brief    Device-to-cloud messages confirmed with IOTHUB_CLIENT_CONFIRMATION_ERROR. */
+        size_t messagesFailed;
+
+        /** @brief    Device-to-cloud messages confirmed with IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT. */
+        size_t messagesTimedOut;
+
+        /** @brief    Device-to-cloud messages confirmed with IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY. */
+        size_t messagesDropped;
+
+        /** @brief    Cloud-to-device messages handed to the application. */
+        size_t messagesReceived;
+
+        /** @brief    Body bytes of the device-to-cloud messages counted in @p messagesSent. */
+        size_t bytesSent;
+
+        /** @brief    Body bytes of the cloud-to-device messages counted in @p messagesReceived. */
+        size_t bytesReceived;
+
+        /** @brief    Device-to-cloud messages sent again after a failed or unacknowledged attempt. */
+        size_t sendRetries;
+
+        /** @brief    Connection attempts made after the first one. */
+        size_t reconnectAttempts;
+
+        /** @brief    Times the client went from authenticated to unauthenticated. */
+        size_t disconnects;
+
+        /** @brief    Device-to-cloud messages waiting for the transport to pick them up, at the time of the snapshot. */
+        size_t messagesWaiting;
+
+        /** @brief    Device-to-cloud messages picked up by the transport and not confirmed yet, at the time of the snapshot. */
+        size_t messagesInFlight;
+
+        /** @brief    Confirmations added to the latency histogram. */
+        size_t ackLatencyCount;
+
+        /** @brief    Sum of the latencies in the histogram, in milliseconds. */
+        size_t ackLatencyTotalMs;
+
+        /** @brief    Confirmations per latency bucket, see IOTHUB_CLIENT_METRICS_LATENCY_BUCKET_COUNT. */
+        size_t ackLatencyBuckets[IOTHUB_CLIENT_METRICS_LATENCY_BUCKET_COUNT];
+    } IOTHUB_CLIENT_METRICS;
+
+    /** @brief    Receives a snapshot of the metrics every OPTION_METRICS_EXPORT interval, from the thread running DoWork. */
+    typedef void(*IOTHUB_CLIENT_METRICS_CALLBACK)(const IOTHUB_CLIENT_METRICS* metrics, void* userContextCallback);
+
+    /** @brief    Periodic export of the metrics, set with OPTION_METRICS_EXPORT. */
+    typedef struct IOTHUB_CLIENT_METRICS_EXPORT_TAG
+    {
+        /** @brief    Called with each snapshot; NULL stops the export. */
+        IOTHUB_CLIENT_METRICS_CALLBACK callback;
+
+        /** @brief    Passed to @p callback. */
+        void* userContextCallback;
+
+        /** @brief    Time between snapshots, in milliseconds. */
+        size_t intervalMs;
+    } IOTHUB_CLIENT_METRICS_EXPORT;
+
+    /** @brief    When the DoWork of a client has to run next, see IoTHubDeviceClient_LL_GetPollInfo. */
+    typedef struct IOTHUB_CLIENT_POLL_INFO_TAG
+    {
+        /** @brief    Milliseconds until DoWork has to run for the timers of the client: keep-alive, reconnection, token
+        *             renewal, flushes and time-outs.  0 when DoWork has work it can do right away, such as messages to send,
+        *             SIZE_MAX when no timer is running.
+        */
+        size_t timeoutMs;
+    } IOTHUB_CLIENT_POLL_INFO;
+
     /** @brief    This struct specifies  IoT Hub client device configuration. */
     typedef struct IOTHUB_CLIENT_DEVICE_CONFIG_TAG
     {
@@ -0,0 +1,113 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file iothub_client_group.h
+*    @brief Runs many device clients of the LL layer on a small, fixed pool of threads.
+*
+*    @details The convenience layer gives every client a thread of its own, which does not scale to a gateway that
+*             represents thousands of devices.  A group instead spreads its clients over threadCount worker threads;
+*             each worker keeps its clients ordered by when their IoTHubDeviceClient_LL_DoWork is next due and sleeps
+*             until then.  Any transport can be used, and each client keeps its own connection.
+*
+*             A client only ever runs on the worker it was assigned to, so its callbacks come from that one thread and
+*             may call its LL API directly.  Anywhere else, the LL API of a member must only be called through
+*             IoTHubClientGroup_Invoke, which serializes the call with the worker.
+*/
+
+#ifndef IOTHUB_CLIENT_GROUP_H
+#define IOTHUB_CLIENT_GROUP_H
+
+#include "umock_c/umock_c_prod.h"
+
+#include "iothub_client_core_common.h"
+#include "iothub_device_client_ll.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+extern "C"
+{
+#else
+#include <stddef.h>
+#endif
+
+/** @brief Handle representing a group of clients and its worker threads */
+typedef struct IOTHUB_CLIENT_GROUP_TAG* IOTHUB_CLIENT_GROUP_HANDLE;
+
+/** @brief Handle representing a client added to a group */
+typedef struct IOTHUB_CLIENT_GROUP_MEMBER_TAG* IOTHUB_CLIENT_GROUP_MEMBER_HANDLE;
+
+/** @brief Configuration of a group of clients */
+typedef struct IOTHUB_CLIENT_GROUP_CONFIG_TAG
+{
+    /** @brief Number of worker threads; the clients are spread evenly over them. */
+    size_t threadCount;
+    /** @brief How often each client's DoWork runs, in milliseconds (OPTION_DO_WORK_FREQUENCY_IN_MS of the
+     *         convenience layer).  IoTHubClientGroup_Invoke runs it again right away, so sends do not wait for it, and
+     *         clients whose IoTHubDeviceClient_LL_GetPollInfo reports an earlier time run then instead. */
+    unsigned int doWorkFrequencyInMs;
+} IOTHUB_CLIENT_GROUP_CONFIG;
+
+/** @brief Called by IoTHubClientGroup_Invoke with the member's client, while no worker is running it. */
+typedef void(*IOTHUB_CLIENT_GROUP_INVOKE_CALLBACK)(IOTHUB_DEVICE_CLIENT_LL_HANDLE iotHubClientHandle, void* context);
+
+/**
+* @brief    Creates a group and starts its worker threads.
+*
+* @param    config  The number of threads and the DoWork frequency; both must be greater than 0.
+*
+* @return   A non-NULL @c IOTHUB_CLIENT_GROUP_HANDLE value that is used when invoking other functions of the group,
+*           or NULL on failure.
+*/
+MOCKABLE_FUNCTION(, IOTHUB_CLIENT_GROUP_HANDLE, IoTHubClientGroup_Create, const IOTHUB_CLIENT_GROUP_CONFIG*, config);
+
+/**
+* @brief    Stops the worker threads and removes the remaining members; their clients are not destroyed.
+*
+* @remarks  Must not be called from a callback of a member.
+*
+* @param    groupHandle The handle created by a call to IoTHubClientGroup_Create.
+*/
+MOCKABLE_FUNCTION(, void, IoTHubClientGroup_Destroy, IOTHUB_CLIENT_GROUP_HANDLE, groupHandle);
+
+/**
+* @brief    Adds a client to the worker with the fewest clients, which starts running its DoWork.
+*
+* @remarks  The client must not belong to another group or be given to DoWork by the application while it is a member.
+*
+* @param    groupHandle         The handle created by a call to IoTHubClientGroup_Create.
+* @param    iotHubClientHandle  The client to add.
+*
+* @return   A non-NULL @c IOTHUB_CLIENT_GROUP_MEMBER_HANDLE for IoTHubClientGroup_Invoke and
+*           IoTHubClientGroup_RemoveDeviceClient, or NULL on failure.
+*/
+MOCKABLE_FUNCTION(, IOTHUB_CLIENT_GROUP_MEMBER_HANDLE, IoTHubClientGroup_AddDeviceClient, IOTHUB_CLIENT_GROUP_HANDLE, groupHandle, IOTHUB_DEVICE_CLIENT_LL_HANDLE, iotHubClientHandle);
+
+/**
+* @brief    Removes a member from its group, waiting for its DoWork to finish if it is running.  The client can then be
+*           destroyed, or used on its own again.
+*
+* @remarks  Must not be called from a callback of a member.
+*
+* @param    memberHandle    The handle returned by IoTHubClientGroup_AddDeviceClient; it is freed.
+*/
+MOCKABLE_FUNCTION(, void, IoTHubClientGroup_RemoveDeviceClient, IOTHUB_CLIENT_GROUP_MEMBER_HANDLE, memberHandle);
+
+/**
+* @brief    Calls @p callback with the member's client while its worker is not running it, then has the worker run its
+*           DoWork right away, so that whatever the callback queued is sent without waiting for the next DoWork.
+*
+* @remarks  Must not be called from a callback of a member: callbacks run on a worker and call the LL API directly.
+*
+* @param    memberHandle    The handle returned by IoTHubClientGroup_AddDeviceClient.
+* @param    callback        Calls the LL API of the client, e.g. IoTHubDeviceClient_LL_SendEventAsync.
+* @param    context         Passed to @p callback.
+*
+* @return   IOTHUB_CLIENT_OK upon success or an error code upon failure.
+*/
+MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubClientGroup_Invoke, IOTHUB_CLIENT_GROUP_MEMBER_HANDLE, memberHandle, IOTHUB_CLIENT_GROUP_INVOKE_CALLBACK, callback, void*, context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTHUB_CLIENT_GROUP_H */
@@ -47,6 +47,8 @@ extern "C"
     static STATIC_VAR_UNUSED const char* OPTION_CBS_REQUEST_TIMEOUT = "cbs_request_timeout";
 
     static STATIC_VAR_UNUSED const char* OPTION_MIN_POLLING_TIME = "MinimumPollingTime";
+    static STATIC_VAR_UNUSED const char* OPTION_MAX_POLLING_TIME = "MaximumPollingTime";
+    static STATIC_VAR_UNUSED const char* OPTION_MESSAGES_PER_POLL = "MessagesPerPoll";
     static STATIC_VAR_UNUSED const char* OPTION_BATCHING = "Batching";
 
     /* DEPRECATED:: OPTION_MESSAGE_TIMEOUT is DEPRECATED! Use OPTION_SERVICE_SIDE_KEEP_ALIVE_FREQ_SECS for AMQP; MQTT has no option available. OPTION_MESSAGE_TIMEOUT legacy variable will be kept for back-compat.  */
@@ -105,6 +107,78 @@ extern "C"
 
     static STATIC_VAR_UNUSED const char* OPTION_DO_WORK_FREQUENCY_IN_MS = "do_work_freq_ms";
 
+    /*
+    * @brief    Number of application callbacks (size_t) the convenience layer queues for a dedicated dispatch thread, so a slow
+    *           callback no longer holds up the worker thread that does the network I/O.  0 (default) runs the callbacks on the
+    *           worker thread.  Cloud-to-device messages and method calls that find the queue full are handled according to
+    *           OPTION_CALLBACK_QUEUE_OVERFLOW; completions (send confirmations, twin and connection status updates) are always
+    *           queued.  Can only be set once.
+    */
+    static STATIC_VAR_UNUSED const char* OPTION_CALLBACK_QUEUE_DEPTH = "callback_queue_depth";
+
+    /*
+    * @brief    What to do when the callback queue is full (IOTHUB_CLIENT_CALLBACK_QUEUE_OVERFLOW, default IOTHUB_CLIENT_CALLBACK_QUEUE_BLOCK).
+    *           Clients sharing a transport cannot pause its worker thread, so they treat IOTHUB_CLIENT_CALLBACK_QUEUE_BLOCK as
+    *           IOTHUB_CLIENT_CALLBACK_QUEUE_REJECT.
+    */
+    static STATIC_VAR_UNUSED const char* OPTION_CALLBACK_QUEUE_OVERFLOW = "callback_queue_overflow";
+
+    /*
+    * @brief    Compresses the body of device-to-cloud messages before they reach the transport (IOTHUB_CLIENT_COMPRESSION,
+    *           default IOTHUB_CLIENT_COMPRESSION_NONE) and sets their content encoding to match.  Messages that already have a
+    *           content encoding, are smaller than OPTION_COMPRESSION_THRESHOLD or do not get smaller are sent unchanged.
+    *           Messages are compressed one by one, also when the transport batches them, since IoT Hub reads the batch itself.
+    *           HTTP batches (OPTION_BATCHING) do not carry the content encoding, so turning on one of the two fails while
+    *           the other is on.
+    *           Only available when the SDK is built with use_compression.
+    */
+    static STATIC_VAR_UNUSED const char* OPTION_COMPRESSION = "compression";
+
+    /*
+    * @brief    Smallest body (size_t, bytes) OPTION_COMPRESSION compresses.  Default 256.
+    */
+    static STATIC_VAR_UNUSED const char* OPTION_COMPRESSION_THRESHOLD = "compression_threshold";
+
+    /*
+    * @brief    zlib compression level (int, 1 fastest to 9 smallest) of OPTION_COMPRESSION.  Default 6.
+    */
+    static STATIC_VAR_UNUSED const char* OPTION_COMPRESSION_LEVEL = "compression_level";
+
+    /*
+    * @brief    Preset dictionary (IOTHUB_CLIENT_COMPRESSION_DICTIONARY*, copied) for IOTHUB_CLIENT_COMPRESSION_DEFLATE, so that
+    *           small messages sharing keys and values with it compress well.  The gzip format has no dictionary.
+    */
+    static STATIC_VAR_UNUSED const char* OPTION_COMPRESSION_DICTIONARY = "compression_dictionary";
+
+    /*
+    * @brief    Keeps a local copy of the device twin (bool).  Desired property PATCHes are applied to it as they arrive,
+    *           and the complete twin is only requested again when a PATCH $version shows that updates were missed.
+    *           Cached properties are read with IoTHubDeviceClient_LL_GetCachedProperty.  While it is enabled, setting a NULL
+    *           twin callback stops the callbacks but keeps the twin subscription.
+    */
+    static STATIC_VAR_UNUSED const char* OPTION_TWIN_CACHE = "twin_cache";
+
+    /*
+    * @brief    Merges reported property PATCHes sent within the given interval (unsigned int, milliseconds) into a single PATCH.
+    *           Values that did not change since the last acknowledged report are left out, and the callback of every merged
+    *           IoTHubDeviceClient_LL_SendReportedState call is invoked with the status of the combined PATCH.  0 (default) sends
+    *           each report as its own PATCH.
+    */
+    static STATIC_VAR_UNUSED const char* OPTION_REPORTED_STATE_FLUSH_INTERVAL_MS = "reported_state_flush_interval_ms";
+
+    /*
+    * @brief    Counts messages, bytes, retries and reconnects, and the time it takes device-to-cloud messages to be confirmed (bool).
+    *           Read the counters with IoTHubDeviceClient_LL_GetMetrics.  Turning it off discards them.  Off by default, in which
+    *           case the client does no accounting.
+    */
+    static STATIC_VAR_UNUSED const char* OPTION_METRICS = "metrics";
+
+    /*
+    * @brief    Hands a snapshot of the metrics to a callback at a fixed interval (IOTHUB_CLIENT_METRICS_EXPORT*, copied), from DoWork.
+    *           Turns OPTION_METRICS on.  A NULL callback stops the export and leaves the metrics on.
+    */
+    static STATIC_VAR_UNUSED const char* OPTION_METRICS_EXPORT = "metrics_export";
+
 // Minimum percentage (in the 0 to 1 range) of multiplexed registered devices that must be failing for a transport-wide reconnection to be triggered.
 // A value of zero results in a single registered device to be able to cause a general transport reconnection 
 // (thus causing all other multiplexed registered devices to be also reconnected, meaning an agressive reconnection strategy).
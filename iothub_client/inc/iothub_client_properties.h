@@ -246,6 +246,34 @@ typedef struct IOTHUB_CLIENT_PROPERTIES_DESERIALIZER_TAG* IOTHUB_CLIENT_PROPERTI
 */
 MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubClient_Properties_Deserializer_Create,  IOTHUB_CLIENT_PROPERTY_PAYLOAD_TYPE, payloadType, const unsigned char*, payload, size_t, payloadLength, IOTHUB_CLIENT_PROPERTIES_DESERIALIZER_HANDLE*, propertiesDeserializerHandle);
 
+/**
+* @brief   Setup a deserialization handle that reads Plug and Play properties directly from @p payload, without copying it
+*          or parsing it into a DOM.
+*
+* @param[in]  payloadType                    Whether the payload is a full set of properties or only a set of updated 
+*                                            writable properties.
+* @param[in]  payload                        Payload containing properties from Azure IoT that is to be deserialized. 
+* @param[in]  payloadLength                  Length of @p payload.
+* @param[out] propertiesDeserializerHandle   Returned handle used for subsequent iteration calls.
+*
+* @remarks  This is a lower memory alternative to @p IoTHubClient_Properties_Deserializer_Create() for large twins.  The 
+*           returned handle is used with the same @p IoTHubClient_Properties_Deserializer_GetVersion(), 
+*           @p IoTHubClient_Properties_Deserializer_GetNext() and @p IoTHubClient_Properties_Deserializer_Destroy() calls and
+*           enumerates the same properties in the same order.  Memory use is bounded by the largest single property 
+*           rather than the size of the payload.  The differences are:
+*
+*           - @p payload is not copied.  It must remain valid and unmodified until 
+*             @p IoTHubClient_Properties_Deserializer_Destroy() is called.
+*           - The @c componentName and @c name fields of a property returned by 
+*             @p IoTHubClient_Properties_Deserializer_GetNext() are only valid until the next call to 
+*             @p IoTHubClient_Properties_Deserializer_GetNext().  Applications that need them longer must copy them.
+*           - Creation validates the overall structure of the JSON, but a malformed property value is only reported when 
+*             @p IoTHubClient_Properties_Deserializer_GetNext() reaches it.
+*
+* @return   IOTHUB_CLIENT_OK upon success or an error code upon failure.
+*/
+MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubClient_Properties_Deserializer_CreateStreaming,  IOTHUB_CLIENT_PROPERTY_PAYLOAD_TYPE, payloadType, const unsigned char*, payload, size_t, payloadLength, IOTHUB_CLIENT_PROPERTIES_DESERIALIZER_HANDLE*, propertiesDeserializerHandle);
+
 /**
 * @brief   Retrieves the version associated with the properties payload.
 *
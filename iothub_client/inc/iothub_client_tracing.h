@@ -0,0 +1,71 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file iothub_client_tracing.h
+*    @brief Trace points along the path of a device-to-cloud message, for breaking its latency down by stage.
+*
+*    @details The trace points are only compiled in when the SDK is built with -Duse_tracing=ON (USE_TRACING);
+*             otherwise they are empty macros and IoTHubClient_SetTraceCallback fails.
+*/
+
+#ifndef IOTHUB_CLIENT_TRACING_H
+#define IOTHUB_CLIENT_TRACING_H
+
+#include "umock_c/umock_c_prod.h"
+
+#include "iothub_client_core_common.h"
+
+#ifdef __cplusplus
+#include <cstdint>
+extern "C"
+{
+#else
+#include <stdint.h>
+#endif
+
+/**
+* @brief    The points a device-to-cloud message passes.
+*
+* @remarks  ENQUEUED is IoTHub*Client*_SendEventAsync; DEQUEUED is the transport taking the message off the client's
+*           queue; WRITTEN is the transport handing the encoded message to MQTT or to the AMQP link, which write it to
+*           the socket; ACKNOWLEDGED and ABANDONED are the confirmation, OK or otherwise.  The HTTP transport sends
+*           and confirms in one blocking request, so its messages only have ENQUEUED and their confirmation.
+*/
+#define IOTHUB_CLIENT_TRACE_POINT_VALUES        \
+    IOTHUB_CLIENT_TRACE_ENQUEUED,               \
+    IOTHUB_CLIENT_TRACE_DEQUEUED,               \
+    IOTHUB_CLIENT_TRACE_WRITTEN,                \
+    IOTHUB_CLIENT_TRACE_ACKNOWLEDGED,           \
+    IOTHUB_CLIENT_TRACE_ABANDONED
+
+MU_DEFINE_ENUM_WITHOUT_INVALID(IOTHUB_CLIENT_TRACE_POINT, IOTHUB_CLIENT_TRACE_POINT_VALUES);
+
+/**
+* @brief    Called on the thread that runs DoWork (or SendEventAsync, for ENQUEUED) each time a message passes a
+*           trace point.  It must not block and must not call into the client.
+*
+* @param    point           The trace point.
+* @param    messageId       Identifies the message across its trace points; ids are unique within the process.
+* @param    timestampNs     Monotonic clock reading in nanoseconds.  Only differences between readings are meaningful.
+* @param    userContext     The context given to IoTHubClient_SetTraceCallback.
+*/
+typedef void(*IOTHUB_CLIENT_TRACE_CALLBACK)(IOTHUB_CLIENT_TRACE_POINT point, uint64_t messageId, uint64_t timestampNs, void* userContext);
+
+/**
+* @brief    Sets the callback that receives the trace points of all the clients in the process.
+*
+* @remarks  Set it before creating the clients to trace, and clear it (NULL) only after destroying them: the trace
+*           points read the callback without a lock.  Messages enqueued while no callback is set are not traced.
+*
+* @param    traceCallback   The callback, or NULL to stop tracing.
+* @param    userContext     Passed back to @p traceCallback.
+*
+* @return   IOTHUB_CLIENT_OK upon success, IOTHUB_CLIENT_ERROR if the SDK was built without USE_TRACING.
+*/
+MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubClient_SetTraceCallback, IOTHUB_CLIENT_TRACE_CALLBACK, traceCallback, void*, userContext);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTHUB_CLIENT_TRACING_H */
@@ -610,6 +610,27 @@ extern "C"
     */
     MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubDeviceClient_GetPropertiesAndSubscribeToUpdatesAsync, IOTHUB_DEVICE_CLIENT_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_PROPERTIES_RECEIVED_CALLBACK, propertyUpdateCallback, void*, userContextCallback);
 
+    /**
+    * @brief    Gets the counters of the callback queue set up with OPTION_CALLBACK_QUEUE_DEPTH.
+    *
+    * @param    iotHubClientHandleThe handle created by a call to the create function.
+    * @param    statistics              Receives the counters; all zero when the callback queue is not in use.
+    *
+    * @return   IOTHUB_CLIENT_OK upon success or an error code upon failure.
+    */
+    MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubDeviceClient_GetCallbackQueueStatistics, IOTHUB_DEVICE_CLIENT_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_CALLBACK_QUEUE_STATISTICS*, statistics);
+
+    /**
+    * @brief    Gets a snapshot of the counters collected with OPTION_METRICS.
+    *
+    * @param    iotHubClientHandle      The handle created by a call to the create function.
+    * @param    metrics                 Receives the snapshot.
+    *
+    * @return   IOTHUB_CLIENT_OK upon success or an error code upon failure.  IOTHUB_CLIENT_ERROR is returned if
+    *           metrics are not enabled.
+    */
+    MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubDeviceClient_GetMetrics, IOTHUB_DEVICE_CLIENT_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_METRICS*, metrics);
+
 #ifdef __cplusplus
 }
 #endif
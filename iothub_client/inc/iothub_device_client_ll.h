@@ -263,6 +263,22 @@ typedef IOTHUB_CLIENT_LL_UPLOADTOBLOB_CONTEXT_HANDLE IOTHUB_CLIENT_LL_AZURE_STOR
     */
      MOCKABLE_FUNCTION(, void, IoTHubDeviceClient_LL_DoWork, IOTHUB_DEVICE_CLIENT_LL_HANDLE, iotHubClientHandle);
 
+    /**
+    * @brief      Tells when IoTHubDeviceClient_LL_DoWork has to run next, so that an application running its own event
+    *             loop can sleep until then instead of calling DoWork at a fixed rate.
+    *
+    * @param[in]  iotHubClientHandle   The handle created by a call to the create function.
+    * @param[out] pollInfo             Receives the time until DoWork is due, 0 right after anything was queued.
+    *
+    * @remarks    Call it after DoWork and after queuing anything, from the thread running DoWork.  The client does not get to
+    *             see the socket underneath its transport, so data arriving from IoT Hub is not accounted for: an application
+    *             receiving messages, methods or twin updates should not sleep longer than it can wait for them.
+    *
+    * @return     IOTHUB_CLIENT_OK upon success or an error code upon failure.  IOTHUB_CLIENT_ERROR is returned if the
+    *             transport cannot tell; only the MQTT transports can.
+    */
+     MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubDeviceClient_LL_GetPollInfo, IOTHUB_DEVICE_CLIENT_LL_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_POLL_INFO*, pollInfo);
+
     /**
     * @brief    This API sets a runtime option identified by parameter @p optionName
     *           to a value pointed to by @p value. @p optionName and the data type
@@ -635,6 +651,41 @@ typedef IOTHUB_CLIENT_LL_UPLOADTOBLOB_CONTEXT_HANDLE IOTHUB_CLIENT_LL_AZURE_STOR
     */
     MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubDeviceClient_LL_GetPropertiesAndSubscribeToUpdatesAsync, IOTHUB_DEVICE_CLIENT_LL_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_PROPERTIES_RECEIVED_CALLBACK, propertyUpdateCallback, void*, userContextCallback);
 
+    /**
+    * @brief      Looks up a property in the local twin cache enabled with OPTION_TWIN_CACHE, without any network traffic.
+    *
+    * @param[in]  iotHubClientHandle   The handle created by a call to the create function.
+    * @param[in]  propertyType         IOTHUB_CLIENT_PROPERTY_TYPE_WRITABLE to read a writable (desired) property or
+    *                                  IOTHUB_CLIENT_PROPERTY_TYPE_REPORTED_FROM_CLIENT to read a property reported by this device.
+    * @param[in]  componentName        Name of the component the property belongs to, or @c NULL for the root component.
+    * @param[in]  propertyName         Name of the property.
+    * @param[out] property             Initialized by the caller with structVersion set to IOTHUB_CLIENT_PROPERTY_PARSED_STRUCT_VERSION_1.
+    *                                  On success it holds the property value as JSON.  @c componentName and @c name point to the
+    *                                  strings passed in.  Free the value with IoTHubClient_Properties_DeserializerProperty_Destroy().
+    * @param[out] propertySpecified    Set to @c false if the property is not in the cache.
+    *
+    * @remarks    The cache is filled from the complete twin and then kept current by applying writable property updates
+    *             and acknowledged reported properties.  If an update is missed the complete twin is requested again
+    *             and lookups return the previous values until it arrives.
+    *
+    * @return     IOTHUB_CLIENT_OK upon success or an error code upon failure.  IOTHUB_CLIENT_ERROR is returned if the
+    *             twin cache is not enabled.
+    */
+    MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubDeviceClient_LL_GetCachedProperty, IOTHUB_DEVICE_CLIENT_LL_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_PROPERTY_TYPE, propertyType, const char*, componentName, const char*, propertyName, IOTHUB_CLIENT_PROPERTY_PARSED*, property, bool*, propertySpecified);
+
+    /**
+    * @brief      Gets a snapshot of the counters collected with OPTION_METRICS.
+    *
+    * @param[in]  iotHubClientHandle   The handle created by a call to the create function.
+    * @param[out] metrics              Receives the snapshot.  The counters are lock-free and may be read from any thread,
+    *                                  but the queue gauges are computed by this call, so call it from the thread running
+    *                                  IoTHubDeviceClient_LL_DoWork, or use OPTION_METRICS_EXPORT.
+    *
+    * @return     IOTHUB_CLIENT_OK upon success or an error code upon failure.  IOTHUB_CLIENT_ERROR is returned if
+    *             metrics are not enabled.
+    */
+    MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubDeviceClient_LL_GetMetrics, IOTHUB_DEVICE_CLIENT_LL_HANDLE, iotHubClientHandle, IOTHUB_CLIENT_METRICS*, metrics);
+
 #ifdef __cplusplus
 }
 #endif
@@ -52,6 +52,10 @@ typedef struct IOTHUB_MESSAGE_DIAGNOSTIC_PROPERTY_DATA_TAG
     char* diagnosticCreationTimeUtc;
 }IOTHUB_MESSAGE_DIAGNOSTIC_PROPERTY_DATA, *IOTHUB_MESSAGE_DIAGNOSTIC_PROPERTY_DATA_HANDLE;
 
+/** @brief The longest diagnosticId and diagnosticCreationTimeUtc a message can hold; they are stored inline in the message. */
+#define IOTHUB_MESSAGE_DIAGNOSTIC_ID_MAX_LENGTH                 15
+#define IOTHUB_MESSAGE_DIAGNOSTIC_CREATION_TIME_MAX_LENGTH      23
+
 static const char DIAG_CREATION_TIME_UTC_PROPERTY_NAME[] = "diag_creation_time_utc";
 
 /**
@@ -275,8 +279,9 @@ MOCKABLE_FUNCTION(, const IOTHUB_MESSAGE_DIAGNOSTIC_PROPERTY_DATA*, IoTHubMessag
 * @param   iotHubMessageHandle Handle to the message.
 * @param   diagnosticData Pointer to the memory location of the diagnosticData
 *
-* @return  Returns IOTHUB_MESSAGE_OK if the DiagnosticData was set successfully
-*          or an error code otherwise.
+* @return  Returns IOTHUB_MESSAGE_OK if the DiagnosticData was set successfully, IOTHUB_MESSAGE_INVALID_ARG if
+*          either string is longer than IOTHUB_MESSAGE_DIAGNOSTIC_ID_MAX_LENGTH or
+*          IOTHUB_MESSAGE_DIAGNOSTIC_CREATION_TIME_MAX_LENGTH, or an error code otherwise.
 */
 MOCKABLE_FUNCTION(, IOTHUB_MESSAGE_RESULT, IoTHubMessage_SetDiagnosticPropertyData, IOTHUB_MESSAGE_HANDLE, iotHubMessageHandle, const IOTHUB_MESSAGE_DIAGNOSTIC_PROPERTY_DATA*, diagnosticData);
 
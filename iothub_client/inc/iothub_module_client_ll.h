@@ -33,6 +33,7 @@
 
 #include "iothub_transport_ll.h"
 #include "iothub_client_core_common.h"
+#include "iothub_client_properties.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -209,6 +210,22 @@ extern "C"
     */
      MOCKABLE_FUNCTION(, void, IoTHubModuleClient_LL_DoWork, IOTHUB_MODULE_CLIENT_LL_HANDLE, iotHubModuleClientHandle);
 
+    /**
+    * @brief      Tells when IoTHubModuleClient_LL_DoWork has to run next, so that an application running its own event
+    *             loop can sleep until then instead of calling DoWork at a fixed rate.
+    *
+    * @param[in]  iotHubModuleClientHandle The handle created by a call to the create function.
+    * @param[out] pollInfo                 Receives the time until DoWork is due, 0 right after anything was queued.
+    *
+    * @remarks    Call it after DoWork and after queuing anything, from the thread running DoWork.  The client does not get to
+    *             see the socket underneath its transport, so data arriving from IoT Hub or Edge is not accounted for: a module
+    *             receiving input messages, methods or twin updates should not sleep longer than it can wait for them.
+    *
+    * @return     IOTHUB_CLIENT_OK upon success or an error code upon failure.  IOTHUB_CLIENT_ERROR is returned if the
+    *             transport cannot tell; only the MQTT transports can.
+    */
+     MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubModuleClient_LL_GetPollInfo, IOTHUB_MODULE_CLIENT_LL_HANDLE, iotHubModuleClientHandle, IOTHUB_CLIENT_POLL_INFO*, pollInfo);
+
     /**
     * @brief    This API sets a runtime option identified by parameter @p optionName
     *             to a value pointed to by @p value. @p optionName and the data type
@@ -494,6 +511,40 @@ extern "C"
     */
     MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubModuleClient_LL_GetPropertiesAndSubscribeToUpdatesAsync, IOTHUB_MODULE_CLIENT_LL_HANDLE, iotHubModuleClientHandle, IOTHUB_CLIENT_PROPERTIES_RECEIVED_CALLBACK, propertyUpdateCallback, void*, userContextCallback);
 
+    /**
+    * @brief      Looks up a property in the local twin cache enabled with OPTION_TWIN_CACHE, without any network traffic.
+    *
+    * @param[in]  iotHubModuleClientHandle The handle created by a call to the create function.
+    * @param[in]  propertyType             IOTHUB_CLIENT_PROPERTY_TYPE_WRITABLE to read a writable (desired) property or
+    *                                      IOTHUB_CLIENT_PROPERTY_TYPE_REPORTED_FROM_CLIENT to read a property reported by this module.
+    * @param[in]  componentName            Name of the component the property belongs to, or @c NULL for the root component.
+    * @param[in]  propertyName             Name of the property.
+    * @param[out] property                 Initialized by the caller with structVersion set to IOTHUB_CLIENT_PROPERTY_PARSED_STRUCT_VERSION_1.
+    *                                      On success it holds the property value as JSON.  @c componentName and @c name point to the
+    *                                      strings passed in.  Free the value with IoTHubClient_Properties_DeserializerProperty_Destroy().
+    * @param[out] propertySpecified        Set to @c false if the property is not in the cache.
+    *
+    * @remarks    The cache is filled from the complete twin and then kept current by applying writable property updates
+    *             and acknowledged reported properties.  If an update is missed the complete twin is requested again
+    *             and lookups return the previous values until it arrives.
+    *
+    * @return     IOTHUB_CLIENT_OK upon success or an error code upon failure.  IOTHUB_CLIENT_ERROR is returned if the
+    *             twin cache is not enabled.
+    */
+    MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubModuleClient_LL_GetCachedProperty, IOTHUB_MODULE_CLIENT_LL_HANDLE, iotHubModuleClientHandle, IOTHUB_CLIENT_PROPERTY_TYPE, propertyType, const char*, componentName, const char*, propertyName, IOTHUB_CLIENT_PROPERTY_PARSED*, property, bool*, propertySpecified);
+
+    /**
+    * @brief      Gets a snapshot of the counters collected with OPTION_METRICS.
+    *
+    * @param[in]  iotHubModuleClientHandle The handle created by a call to the create function.
+    * @param[out] metrics                  Receives the snapshot.  Call it from the thread running IoTHubModuleClient_LL_DoWork,
+    *                                      which also walks the queue for the gauges, or use OPTION_METRICS_EXPORT.
+    *
+    * @return     IOTHUB_CLIENT_OK upon success or an error code upon failure.  IOTHUB_CLIENT_ERROR is returned if
+    *             metrics are not enabled.
+    */
+    MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, IoTHubModuleClient_LL_GetMetrics, IOTHUB_MODULE_CLIENT_LL_HANDLE, iotHubModuleClientHandle, IOTHUB_CLIENT_METRICS*, metrics);
+
 #ifdef __cplusplus
 }
 #endif
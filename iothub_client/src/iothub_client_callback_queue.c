@@ -0,0 +1,486 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/condition.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/vector.h"
+
+#include "internal/iothub_client_callback_queue.h"
+
+MU_DEFINE_ENUM_STRINGS_WITHOUT_INVALID(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_RESULT_VALUES);
+
+typedef struct CALLBACK_QUEUE_TAG
+{
+    size_t item_size;
+    size_t depth;
+    IOTHUB_CLIENT_CALLBACK_QUEUE_OVERFLOW overflow;
+    CALLBACK_QUEUE_DISPATCH dispatch;
+    void* context;
+
+    LOCK_HANDLE lock;
+    COND_HANDLE item_added;
+    COND_HANDLE room_made;
+    THREAD_HANDLE thread;
+    bool stop;
+
+    // Ring of capacity items starting at head; droppable[i] tells whether items[i] may be rejected or evicted.
+    // The ring only grows past depth for items that are not droppable.
+    unsigned char* items;
+    bool* droppable;
+    size_t capacity;
+    size_t head;
+    size_t count;
+
+    // Items evicted under IOTHUB_CLIENT_CALLBACK_QUEUE_DROP_OLDEST, settled by the dispatch thread ahead of the ring
+    VECTOR_HANDLE dropped;
+    // Item being dispatched, copied out of the ring so that pushes can reuse its slot
+    unsigned char* current;
+
+    IOTHUB_CLIENT_CALLBACK_QUEUE_STATISTICS statistics;
+} CALLBACK_QUEUE;
+
+static unsigned char* get_slot(CALLBACK_QUEUE* queue, size_t index)
+{
+    return queue->items + (((queue->head + index) % queue->capacity) * queue->item_size);
+}
+
+static bool* get_droppable(CALLBACK_QUEUE* queue, size_t index)
+{
+    return &queue->droppable[(queue->head + index) % queue->capacity];
+}
+
+// Doubles the ring, moving its items to the start of the new buffers
+static int grow_ring(CALLBACK_QUEUE* queue)
+{
+    int result;
+    size_t new_capacity = queue->capacity * 2;
+    unsigned char* new_items;
+    bool* new_droppable;
+
+    if ((new_items = (unsigned char*)malloc(new_capacity * queue->item_size)) == NULL)
+    {
+        LogError("Failed allocating %lu callback queue items", (unsigned long)new_capacity);
+        result = MU_FAILURE;
+    }
+    else if ((new_droppable = (bool*)malloc(new_capacity * sizeof(bool))) == NULL)
+    {
+        LogError("Failed allocating %lu callback queue flags", (unsigned long)new_capacity);
+        free(new_items);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        size_t i;
+
+        for (i = 0; i < queue->count; i++)
+        {
+            (void)memcpy(new_items + (i * queue->item_size), get_slot(queue, i), queue->item_size);
+            new_droppable[i] = *get_droppable(queue, i);
+        }
+
+        free(queue->items);
+        free(queue->droppable);
+        queue->items = new_items;
+        queue->droppable = new_droppable;
+        queue->capacity = new_capacity;
+        queue->head = 0;
+        result = 0;
+    }
+
+    return result;
+}
+
+// Moves the oldest droppable item of the ring to the dropped items.  Returns false when every item queued is a completion.
+static bool evict_oldest(CALLBACK_QUEUE* queue)
+{
+    bool result = false;
+    size_t i;
+
+    for (i = 0; i < queue->count; i++)
+    {
+        if (*get_droppable(queue, i))
+        {
+            if (VECTOR_push_back(queue->dropped, get_slot(queue, i), 1) != 0)
+            {
+                LogError("Failed keeping an evicted callback");
+            }
+            else
+            {
+                // Close the gap so the ring keeps the order of the items
+                for (; i + 1 < queue->count; i++)
+                {
+                    (void)memcpy(get_slot(queue, i), get_slot(queue, i + 1), queue->item_size);
+                    *get_droppable(queue, i) = *get_droppable(queue, i + 1);
+                }
+                queue->count--;
+                queue->statistics.queued = queue->count;
+                queue->statistics.callbacksDropped++;
+                result = true;
+            }
+            break;
+        }
+    }
+
+    return result;
+}
+
+static void dispatch_dropped(CALLBACK_QUEUE* queue, VECTOR_HANDLE dropped)
+{
+    size_t count = VECTOR_size(dropped);
+    size_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        queue->dispatch(queue->context, VECTOR_element(dropped, i), true);
+    }
+}
+
+static int dispatch_thread(void* userContextCallback)
+{
+    CALLBACK_QUEUE* queue = (CALLBACK_QUEUE*)userContextCallback;
+
+    if (Lock(queue->lock) != LOCK_OK)
+    {
+        LogError("Lock failed, callback queue dispatch thread exiting");
+    }
+    else
+    {
+        bool is_locked = true;
+
+        while (!queue->stop)
+        {
+            if (queue->count == 0 && VECTOR_size(queue->dropped) == 0)
+            {
+                if (Condition_Wait(queue->item_added, queue->lock, 0) != COND_OK)
+                {
+                    LogError("Condition_Wait failed, callback queue dispatch thread exiting");
+                    break;
+                }
+            }
+            else
+            {
+                VECTOR_HANDLE dropped = NULL;
+                bool has_current = false;
+
+                if (VECTOR_size(queue->dropped) > 0 && (dropped = VECTOR_move(queue->dropped)) == NULL)
+                {
+                    LogError("VECTOR_move failed, evicted callbacks settled at destroy");
+                }
+
+                if (queue->count > 0)
+                {
+                    (void)memcpy(queue->current, get_slot(queue, 0), queue->item_size);
+                    queue->head = (queue->head + 1) % queue->capacity;
+                    queue->count--;
+                    queue->statistics.queued = queue->count;
+                    has_current = true;
+                    (void)Condition_Post(queue->room_made);
+                }
+                (void)Unlock(queue->lock);
+
+                if (dropped != NULL)
+                {
+                    dispatch_dropped(queue, dropped);
+                    VECTOR_destroy(dropped);
+                }
+                if (has_current)
+                {
+                    queue->dispatch(queue->context, queue->current, false);
+                }
+
+                if (Lock(queue->lock) != LOCK_OK)
+                {
+                    LogError("Lock failed, callback queue dispatch thread exiting");
+                    is_locked = false;
+                    break;
+                }
+                if (has_current)
+                {
+                    queue->statistics.callbacksDispatched++;
+                }
+            }
+        }
+
+        if (is_locked)
+        {
+            (void)Unlock(queue->lock);
+        }
+    }
+
+    return 0;
+}
+
+static void free_queue(CALLBACK_QUEUE* queue)
+{
+    if (queue->dropped != NULL)
+    {
+        VECTOR_destroy(queue->dropped);
+    }
+    if (queue->room_made != NULL)
+    {
+        Condition_Deinit(queue->room_made);
+    }
+    if (queue->item_added != NULL)
+    {
+        Condition_Deinit(queue->item_added);
+    }
+    if (queue->lock != NULL)
+    {
+        Lock_Deinit(queue->lock);
+    }
+    free(queue->current);
+    free(queue->droppable);
+    free(queue->items);
+    free(queue);
+}
+
+CALLBACK_QUEUE_HANDLE callback_queue_create(size_t item_size, size_t depth, IOTHUB_CLIENT_CALLBACK_QUEUE_OVERFLOW overflow, CALLBACK_QUEUE_DISPATCH dispatch, void* context)
+{
+    CALLBACK_QUEUE* result;
+
+    if (item_size == 0 || depth == 0 || dispatch == NULL)
+    {
+        LogError("Invalid argument (item_size=%lu, depth=%lu, dispatch=%p)", (unsigned long)item_size, (unsigned long)depth, dispatch);
+        result = NULL;
+    }
+    else if ((result = (CALLBACK_QUEUE*)malloc(sizeof(CALLBACK_QUEUE))) == NULL)
+    {
+        LogError("Failed allocating the callback queue");
+    }
+    else
+    {
+        (void)memset(result, 0, sizeof(CALLBACK_QUEUE));
+        result->item_size = item_size;
+        result->depth = depth;
+        result->overflow = overflow;
+        result->dispatch = dispatch;
+        result->context = context;
+        result->capacity = depth;
+        result->statistics.depth = depth;
+
+        if ((result->items = (unsigned char*)malloc(depth * item_size)) == NULL ||
+            (result->droppable = (bool*)malloc(depth * sizeof(bool))) == NULL ||
+            (result->current = (unsigned char*)malloc(item_size)) == NULL)
+        {
+            LogError("Failed allocating %lu callback queue items", (unsigned long)depth);
+            free_queue(result);
+            result = NULL;
+        }
+        else if ((result->dropped = VECTOR_create(item_size)) == NULL)
+        {
+            LogError("VECTOR_create failed");
+            free_queue(result);
+            result = NULL;
+        }
+        else if ((result->lock = Lock_Init()) == NULL)
+        {
+            LogError("Lock_Init failed");
+            free_queue(result);
+            result = NULL;
+        }
+        else if ((result->item_added = Condition_Init()) == NULL ||
+            (result->room_made = Condition_Init()) == NULL)
+        {
+            LogError("Condition_Init failed");
+            free_queue(result);
+            result = NULL;
+        }
+        else if (ThreadAPI_Create(&result->thread, dispatch_thread, result) != THREADAPI_OK)
+        {
+            LogError("ThreadAPI_Create failed");
+            free_queue(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+void callback_queue_destroy(CALLBACK_QUEUE_HANDLE queue)
+{
+    if (queue == NULL)
+    {
+        LogError("Invalid argument queue (NULL)");
+    }
+    else
+    {
+        int thread_result;
+
+        if (Lock(queue->lock) != LOCK_OK)
+        {
+            LogError("Lock failed, stopping the dispatch thread without it");
+            queue->stop = true;
+        }
+        else
+        {
+            queue->stop = true;
+            (void)Unlock(queue->lock);
+        }
+        (void)Condition_Post(queue->item_added);
+        (void)Condition_Post(queue->room_made);
+
+        if (ThreadAPI_Join(queue->thread, &thread_result) != THREADAPI_OK)
+        {
+            LogError("ThreadAPI_Join failed");
+        }
+
+        // The dispatch thread is gone; settle what it did not get to on this thread
+        dispatch_dropped(queue, queue->dropped);
+        while (queue->count > 0)
+        {
+            queue->dispatch(queue->context, get_slot(queue, 0), true);
+            queue->head = (queue->head + 1) % queue->capacity;
+            queue->count--;
+        }
+
+        free_queue(queue);
+    }
+}
+
+int callback_queue_set_overflow(CALLBACK_QUEUE_HANDLE queue, IOTHUB_CLIENT_CALLBACK_QUEUE_OVERFLOW overflow)
+{
+    int result;
+
+    if (queue == NULL)
+    {
+        LogError("Invalid argument queue (NULL)");
+        result = MU_FAILURE;
+    }
+    else if (Lock(queue->lock) != LOCK_OK)
+    {
+        LogError("Lock failed");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        queue->overflow = overflow;
+        (void)Unlock(queue->lock);
+        result = 0;
+    }
+
+    return result;
+}
+
+CALLBACK_QUEUE_PUSH_RESULT callback_queue_push(CALLBACK_QUEUE_HANDLE queue, const void* item, bool is_droppable)
+{
+    CALLBACK_QUEUE_PUSH_RESULT result;
+
+    if (queue == NULL || item == NULL)
+    {
+        LogError("Invalid argument (queue=%p, item=%p)", queue, item);
+        result = CALLBACK_QUEUE_PUSH_ERROR;
+    }
+    else if (Lock(queue->lock) != LOCK_OK)
+    {
+        LogError("Lock failed");
+        result = CALLBACK_QUEUE_PUSH_ERROR;
+    }
+    else
+    {
+        if (is_droppable && queue->count >= queue->depth && queue->overflow == IOTHUB_CLIENT_CALLBACK_QUEUE_REJECT)
+        {
+            queue->statistics.callbacksRejected++;
+            result = CALLBACK_QUEUE_PUSH_REJECTED;
+        }
+        else if (is_droppable && queue->count >= queue->depth && queue->overflow == IOTHUB_CLIENT_CALLBACK_QUEUE_DROP_OLDEST && !evict_oldest(queue))
+        {
+            // Only completions are queued; the new arrival is the oldest droppable item
+            if (VECTOR_push_back(queue->dropped, item, 1) != 0)
+            {
+                LogError("Failed keeping an evicted callback");
+                result = CALLBACK_QUEUE_PUSH_ERROR;
+            }
+            else
+            {
+                queue->statistics.callbacksDropped++;
+                (void)Condition_Post(queue->item_added);
+                result = CALLBACK_QUEUE_PUSH_OK;
+            }
+        }
+        else if (queue->count == queue->capacity && grow_ring(queue) != 0)
+        {
+            result = CALLBACK_QUEUE_PUSH_ERROR;
+        }
+        else
+        {
+            (void)memcpy(get_slot(queue, queue->count), item, queue->item_size);
+            *get_droppable(queue, queue->count) = is_droppable;
+            queue->count++;
+
+            queue->statistics.callbacksQueued++;
+            queue->statistics.queued = queue->count;
+            if (queue->count > queue->statistics.peakQueued)
+            {
+                queue->statistics.peakQueued = queue->count;
+            }
+
+            (void)Condition_Post(queue->item_added);
+            result = CALLBACK_QUEUE_PUSH_OK;
+        }
+
+        (void)Unlock(queue->lock);
+    }
+
+    return result;
+}
+
+bool callback_queue_wait_for_room(CALLBACK_QUEUE_HANDLE queue, unsigned int timeout_ms)
+{
+    bool result;
+
+    if (queue == NULL)
+    {
+        LogError("Invalid argument queue (NULL)");
+        result = false;
+    }
+    else if (Lock(queue->lock) != LOCK_OK)
+    {
+        LogError("Lock failed");
+        result = false;
+    }
+    else
+    {
+        // Condition_Wait takes 0 as no timeout, which must not stall the caller
+        if (queue->count >= queue->depth && !queue->stop && timeout_ms > 0)
+        {
+            queue->statistics.ioPauses++;
+            (void)Condition_Wait(queue->room_made, queue->lock, (int)timeout_ms);
+        }
+        result = (queue->count < queue->depth);
+        (void)Unlock(queue->lock);
+    }
+
+    return result;
+}
+
+int callback_queue_get_statistics(CALLBACK_QUEUE_HANDLE queue, IOTHUB_CLIENT_CALLBACK_QUEUE_STATISTICS* statistics)
+{
+    int result;
+
+    if (queue == NULL || statistics == NULL)
+    {
+        LogError("Invalid argument (queue=%p, statistics=%p)", queue, statistics);
+        result = MU_FAILURE;
+    }
+    else if (Lock(queue->lock) != LOCK_OK)
+    {
+        LogError("Lock failed");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        *statistics = queue->statistics;
+        (void)Unlock(queue->lock);
+        result = 0;
+    }
+
+    return result;
+}
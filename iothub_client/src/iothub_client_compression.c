@@ -0,0 +1,353 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+
+#include "zlib.h"
+
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/buffer_.h"
+
+#include "iothub_client_options.h"
+#include "internal/iothub_message_private.h"
+#include "internal/iothub_client_compression.h"
+
+#define DEFAULT_COMPRESSION_THRESHOLD   256
+#define DEFAULT_COMPRESSION_LEVEL       6
+#define ZLIB_WINDOW_BITS                15
+#define GZIP_WINDOW_BITS                (ZLIB_WINDOW_BITS + 16)
+#define ZLIB_MEMORY_LEVEL               8
+
+static const char* CONTENT_ENCODING_DEFLATE = "deflate";
+static const char* CONTENT_ENCODING_GZIP = "gzip";
+
+typedef struct COMPRESSION_TAG
+{
+    IOTHUB_CLIENT_COMPRESSION algorithm;
+    size_t threshold;
+    int level;
+    unsigned char* dictionary;
+    size_t dictionary_size;
+
+    // Reused from message to message with deflateReset; torn down when a setting changes and set up again on the next message
+    z_stream stream;
+    bool is_stream_initialized;
+} COMPRESSION;
+
+// Routes zlib's allocations through gballoc, so they are accounted for with the rest of the SDK
+static voidpf zlib_alloc(voidpf opaque, uInt items, uInt size)
+{
+    (void)opaque;
+    return malloc((size_t)items * size);
+}
+
+static void zlib_free(voidpf opaque, voidpf address)
+{
+    (void)opaque;
+    free(address);
+}
+
+static void end_stream(COMPRESSION* compression)
+{
+    if (compression->is_stream_initialized)
+    {
+        (void)deflateEnd(&compression->stream);
+        compression->is_stream_initialized = false;
+    }
+}
+
+// Readies the stream for a new message: set up on first use, reset afterwards.  zlib drops the dictionary on reset.
+static int prepare_stream(COMPRESSION* compression)
+{
+    int result;
+
+    if (compression->is_stream_initialized)
+    {
+        result = deflateReset(&compression->stream);
+    }
+    else
+    {
+        int window_bits = (compression->algorithm == IOTHUB_CLIENT_COMPRESSION_GZIP) ? GZIP_WINDOW_BITS : ZLIB_WINDOW_BITS;
+
+        (void)memset(&compression->stream, 0, sizeof(compression->stream));
+        compression->stream.zalloc = zlib_alloc;
+        compression->stream.zfree = zlib_free;
+
+        if ((result = deflateInit2(&compression->stream, compression->level, Z_DEFLATED, window_bits, ZLIB_MEMORY_LEVEL, Z_DEFAULT_STRATEGY)) == Z_OK)
+        {
+            compression->is_stream_initialized = true;
+        }
+    }
+
+    if (result != Z_OK)
+    {
+        LogError("Failed preparing the deflate stream (%d)", result);
+        result = MU_FAILURE;
+    }
+    else if (compression->dictionary != NULL &&
+        (result = deflateSetDictionary(&compression->stream, compression->dictionary, (uInt)compression->dictionary_size)) != Z_OK)
+    {
+        LogError("deflateSetDictionary failed (%d)", result);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static int get_body(IOTHUB_MESSAGE_HANDLE message, const unsigned char** body, size_t* size)
+{
+    int result;
+    IOTHUBMESSAGE_CONTENT_TYPE content_type = IoTHubMessage_GetContentType(message);
+
+    if (content_type == IOTHUBMESSAGE_BYTEARRAY)
+    {
+        if (IoTHubMessage_GetByteArray(message, body, size) != IOTHUB_MESSAGE_OK)
+        {
+            LogError("Failed getting the message body");
+            result = MU_FAILURE;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+    else if (content_type == IOTHUBMESSAGE_STRING)
+    {
+        const char* string = IoTHubMessage_GetString(message);
+        if (string == NULL)
+        {
+            LogError("Failed getting the message body");
+            result = MU_FAILURE;
+        }
+        else
+        {
+            *body = (const unsigned char*)string;
+            *size = strlen(string);
+            result = 0;
+        }
+    }
+    else
+    {
+        LogError("Unknown message content type %d", (int)content_type);
+        result = MU_FAILURE;
+    }
+
+    return result;
+}
+
+COMPRESSION_HANDLE compression_create(void)
+{
+    COMPRESSION* result;
+
+    if ((result = (COMPRESSION*)malloc(sizeof(COMPRESSION))) == NULL)
+    {
+        LogError("Failed allocating the compression stage");
+    }
+    else
+    {
+        (void)memset(result, 0, sizeof(COMPRESSION));
+        result->algorithm = IOTHUB_CLIENT_COMPRESSION_NONE;
+        result->threshold = DEFAULT_COMPRESSION_THRESHOLD;
+        result->level = DEFAULT_COMPRESSION_LEVEL;
+    }
+
+    return result;
+}
+
+void compression_destroy(COMPRESSION_HANDLE handle)
+{
+    if (handle != NULL)
+    {
+        end_stream(handle);
+        free(handle->dictionary);
+        free(handle);
+    }
+}
+
+int compression_set_option(COMPRESSION_HANDLE handle, const char* option_name, const void* value)
+{
+    int result;
+
+    if (handle == NULL || option_name == NULL || value == NULL)
+    {
+        LogError("Invalid argument (handle=%p, option_name=%p, value=%p)", handle, option_name, value);
+        result = MU_FAILURE;
+    }
+    else if (strcmp(option_name, OPTION_COMPRESSION) == 0)
+    {
+        IOTHUB_CLIENT_COMPRESSION algorithm = *(const IOTHUB_CLIENT_COMPRESSION*)value;
+
+        if (algorithm != IOTHUB_CLIENT_COMPRESSION_NONE && algorithm != IOTHUB_CLIENT_COMPRESSION_DEFLATE && algorithm != IOTHUB_CLIENT_COMPRESSION_GZIP)
+        {
+            LogError("Invalid compression %d", (int)algorithm);
+            result = MU_FAILURE;
+        }
+        else if (algorithm == IOTHUB_CLIENT_COMPRESSION_GZIP && handle->dictionary != NULL)
+        {
+            LogError("The gzip format has no preset dictionary");
+            result = MU_FAILURE;
+        }
+        else
+        {
+            end_stream(handle);
+            handle->algorithm = algorithm;
+            result = 0;
+        }
+    }
+    else if (strcmp(option_name, OPTION_COMPRESSION_THRESHOLD) == 0)
+    {
+        handle->threshold = *(const size_t*)value;
+        result = 0;
+    }
+    else if (strcmp(option_name, OPTION_COMPRESSION_LEVEL) == 0)
+    {
+        int level = *(const int*)value;
+
+        if (level < Z_BEST_SPEED || level > Z_BEST_COMPRESSION)
+        {
+            LogError("Compression level %d is out of range [%d, %d]", level, Z_BEST_SPEED, Z_BEST_COMPRESSION);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            end_stream(handle);
+            handle->level = level;
+            result = 0;
+        }
+    }
+    else if (strcmp(option_name, OPTION_COMPRESSION_DICTIONARY) == 0)
+    {
+        const IOTHUB_CLIENT_COMPRESSION_DICTIONARY* dictionary = (const IOTHUB_CLIENT_COMPRESSION_DICTIONARY*)value;
+        unsigned char* copy = NULL;
+
+        if (dictionary->size > 0 && dictionary->data == NULL)
+        {
+            LogError("Invalid dictionary (data=NULL, size=%lu)", (unsigned long)dictionary->size);
+            result = MU_FAILURE;
+        }
+        else if (dictionary->size > 0 && handle->algorithm == IOTHUB_CLIENT_COMPRESSION_GZIP)
+        {
+            LogError("The gzip format has no preset dictionary");
+            result = MU_FAILURE;
+        }
+        else if (dictionary->size > 0 && (copy = (unsigned char*)malloc(dictionary->size)) == NULL)
+        {
+            LogError("Failed allocating the %lu bytes dictionary", (unsigned long)dictionary->size);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            if (copy != NULL)
+            {
+                (void)memcpy(copy, dictionary->data, dictionary->size);
+            }
+            free(handle->dictionary);
+            handle->dictionary = copy;
+            handle->dictionary_size = dictionary->size;
+            result = 0;
+        }
+    }
+    else
+    {
+        LogError("Unknown option %s", option_name);
+        result = MU_FAILURE;
+    }
+
+    return result;
+}
+
+int compression_compress_message(COMPRESSION_HANDLE handle, IOTHUB_MESSAGE_HANDLE message)
+{
+    int result;
+    const unsigned char* body;
+    size_t size;
+
+    if (handle == NULL || message == NULL)
+    {
+        LogError("Invalid argument (handle=%p, message=%p)", handle, message);
+        result = MU_FAILURE;
+    }
+    else if (handle->algorithm == IOTHUB_CLIENT_COMPRESSION_NONE || IoTHubMessage_GetContentEncodingSystemProperty(message) != NULL)
+    {
+        // Off, or the application encoded the body itself
+        result = 0;
+    }
+    else if (get_body(message, &body, &size) != 0)
+    {
+        result = MU_FAILURE;
+    }
+    // zlib takes the input size as an unsigned int
+    else if (size == 0 || size < handle->threshold || size > UINT_MAX)
+    {
+        result = 0;
+    }
+    else if (prepare_stream(handle) != 0)
+    {
+        result = MU_FAILURE;
+    }
+    else
+    {
+        // The output is capped one byte short of the input: a body that does not get smaller runs out of room and is sent as is
+        BUFFER_HANDLE compressed;
+
+        if ((compressed = BUFFER_create_with_size(size - 1)) == NULL)
+        {
+            LogError("Failed allocating %lu bytes for the compressed body", (unsigned long)(size - 1));
+            result = MU_FAILURE;
+        }
+        else
+        {
+            int deflate_result;
+
+            handle->stream.next_in = (Bytef*)body;
+            handle->stream.avail_in = (uInt)size;
+            handle->stream.next_out = BUFFER_u_char(compressed);
+            handle->stream.avail_out = (uInt)(size - 1);
+
+            if ((deflate_result = deflate(&handle->stream, Z_FINISH)) == Z_OK || deflate_result == Z_BUF_ERROR)
+            {
+                BUFFER_delete(compressed);
+                result = 0;
+            }
+            else if (deflate_result != Z_STREAM_END)
+            {
+                LogError("deflate failed (%d)", deflate_result);
+                BUFFER_delete(compressed);
+                result = MU_FAILURE;
+            }
+            else if (handle->stream.avail_out > 0 && BUFFER_shrink(compressed, handle->stream.avail_out, true) != 0)
+            {
+                LogError("Failed trimming the compressed body");
+                BUFFER_delete(compressed);
+                result = MU_FAILURE;
+            }
+            else if (IoTHubMessage_SetBody(message, compressed) != IOTHUB_MESSAGE_OK)
+            {
+                LogError("Failed setting the compressed body");
+                BUFFER_delete(compressed);
+                result = MU_FAILURE;
+            }
+            else if (IoTHubMessage_SetContentEncodingSystemProperty(message,
+                (handle->algorithm == IOTHUB_CLIENT_COMPRESSION_GZIP) ? CONTENT_ENCODING_GZIP : CONTENT_ENCODING_DEFLATE) != IOTHUB_MESSAGE_OK)
+            {
+                LogError("Failed setting the content encoding of the compressed body");
+                result = MU_FAILURE;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
@@ -13,6 +13,7 @@
 #include "iothub_client_core_ll.h"
 #include "internal/iothubtransport.h"
 #include "internal/iothub_client_private.h"
+#include "internal/iothub_client_callback_queue.h"
 #include "internal/iothubtransport.h"
 #include "azure_c_shared_utility/threadapi.h"
 #include "azure_c_shared_utility/lock.h"
@@ -29,6 +30,8 @@
 #define CLIENT_CORE_METHOD_EMPTY_PAYLOAD "{}"
 
 static const int DEFAULT_COMMAND_RESPONSE_STATUS_CODE = 500;
+// Status of the response sent for a method call evicted from a full callback queue
+static const int DROPPED_METHOD_RESPONSE_STATUS_CODE = 503;
 
 struct IOTHUB_QUEUE_CONTEXT_TAG;
 
@@ -54,6 +57,8 @@ typedef struct IOTHUB_CLIENT_CORE_INSTANCE_TAG
     struct IOTHUB_QUEUE_CONTEXT_TAG* method_user_context;
     tickcounter_ms_t do_work_freq_ms;
     tickcounter_ms_t currentMessageTimeout;
+    CALLBACK_QUEUE_HANDLE callback_queue; /*NULL unless OPTION_CALLBACK_QUEUE_DEPTH was set*/
+    IOTHUB_CLIENT_CALLBACK_QUEUE_OVERFLOW callback_queue_overflow;
 } IOTHUB_CLIENT_CORE_INSTANCE;
 
 typedef enum HTTPWORKER_THREAD_TYPE_TAG
@@ -274,6 +279,36 @@ static void garbageCollectorImpl(IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientInstan
     }
 }
 
+// Hands a callback of the LL layer over to the thread that invokes the application: the callback queue when
+// OPTION_CALLBACK_QUEUE_DEPTH was set, the list the worker thread dispatches otherwise.  Fails when the full queue
+// rejects a droppable callback.
+static int queue_user_callback(IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientInstance, USER_CALLBACK_INFO* queue_cb_info, bool is_droppable)
+{
+    int result;
+
+    if (iotHubClientInstance->callback_queue == NULL)
+    {
+        result = VECTOR_push_back(iotHubClientInstance->saved_user_callback_list, queue_cb_info, 1);
+    }
+    else
+    {
+        CALLBACK_QUEUE_PUSH_RESULT push_result = callback_queue_push(iotHubClientInstance->callback_queue, queue_cb_info, is_droppable);
+        if (push_result == CALLBACK_QUEUE_PUSH_OK)
+        {
+            result = 0;
+        }
+        else
+        {
+            if (push_result == CALLBACK_QUEUE_PUSH_REJECTED)
+            {
+                LogError("callback queue full, rejecting callback type '%s'", MU_ENUM_TO_STRING(USER_CALLBACK_TYPE, queue_cb_info->type));
+            }
+            result = MU_FAILURE;
+        }
+    }
+
+    return result;
+}
 
 static bool iothub_ll_message_callback(IOTHUB_MESSAGE_HANDLE messageHandle, void* userContextCallback)
 {
@@ -290,7 +325,7 @@ static bool iothub_ll_message_callback(IOTHUB_MESSAGE_HANDLE messageHandle, void
         queue_cb_info.type = CALLBACK_TYPE_MESSAGE;
         queue_cb_info.userContextCallback = queue_context->userContextCallback;
         queue_cb_info.iothub_callback.message_handle = messageHandle;
-        if (VECTOR_push_back(queue_context->iotHubClientHandle->saved_user_callback_list, &queue_cb_info, 1) == 0)
+        if (queue_user_callback(queue_context->iotHubClientHandle, &queue_cb_info, true) == 0)
         {
             result = true;
         }
@@ -320,7 +355,7 @@ static bool iothub_ll_inputmessage_callback(IOTHUB_MESSAGE_HANDLE message_handle
         queue_cb_info.iothub_callback.inputmessage_cb_info.eventHandlerCallback = inputMessageCallbackContext->eventHandlerCallback;
         queue_cb_info.iothub_callback.inputmessage_cb_info.message_handle = message_handle;
 
-        if (VECTOR_push_back(inputMessageCallbackContext->iotHubClientHandle->saved_user_callback_list, &queue_cb_info, 1) == 0)
+        if (queue_user_callback(inputMessageCallbackContext->iotHubClientHandle, &queue_cb_info, true) == 0)
         {
             result = true;
         }
@@ -354,7 +389,7 @@ static int make_method_calback_queue_context(USER_CALLBACK_INFO* queue_cb_info,
         }
         else
         {
-            if (VECTOR_push_back(queue_context->iotHubClientHandle->saved_user_callback_list, queue_cb_info, 1) == 0)
+            if (queue_user_callback(queue_context->iotHubClientHandle, queue_cb_info, true) == 0)
             {
                 result = 0;
             }
@@ -362,7 +397,7 @@ static int make_method_calback_queue_context(USER_CALLBACK_INFO* queue_cb_info,
             {
                 STRING_delete(queue_cb_info->iothub_callback.method_cb_info.method_name);
                 BUFFER_delete(queue_cb_info->iothub_callback.method_cb_info.payload);
-                LogError("VECTOR_push_back failed");
+                LogError("queue_user_callback failed");
                 result = MU_FAILURE;
             }
         }
@@ -465,7 +500,7 @@ static void iothub_ll_connection_status_callback(IOTHUB_CLIENT_CONNECTION_STATUS
         queue_cb_info.userContextCallback = queue_context->userContextCallback;
         queue_cb_info.iothub_callback.connection_status_cb_info.status_reason = reason;
         queue_cb_info.iothub_callback.connection_status_cb_info.connection_status = result;
-        if (VECTOR_push_back(queue_context->iotHubClientHandle->saved_user_callback_list, &queue_cb_info, 1) != 0)
+        if (queue_user_callback(queue_context->iotHubClientHandle, &queue_cb_info, false) != 0)
         {
             LogError("connection status callback vector push failed.");
         }
@@ -482,7 +517,7 @@ static void iothub_ll_event_confirm_callback(IOTHUB_CLIENT_CONFIRMATION_RESULT r
         queue_cb_info.userContextCallback = queue_context->userContextCallback;
         queue_cb_info.iothub_callback.event_confirm_cb_info.confirm_result = result;
         queue_cb_info.iothub_callback.event_confirm_cb_info.eventConfirmationCallback = queue_context->callbackFunction.eventConfirmationCallback;
-        if (VECTOR_push_back(queue_context->iotHubClientHandle->saved_user_callback_list, &queue_cb_info, 1) != 0)
+        if (queue_user_callback(queue_context->iotHubClientHandle, &queue_cb_info, false) != 0)
         {
             LogError("event confirm callback vector push failed.");
         }
@@ -500,7 +535,7 @@ static void iothub_ll_reported_state_callback(int status_code, void* userContext
         queue_cb_info.userContextCallback = queue_context->userContextCallback;
         queue_cb_info.iothub_callback.reported_state_cb_info.status_code = status_code;
         queue_cb_info.iothub_callback.reported_state_cb_info.reportedStateCallback = queue_context->callbackFunction.reportedStateCallback;
-        if (VECTOR_push_back(queue_context->iotHubClientHandle->saved_user_callback_list, &queue_cb_info, 1) != 0)
+        if (queue_user_callback(queue_context->iotHubClientHandle, &queue_cb_info, false) != 0)
         {
             LogError("reported state callback vector push failed.");
         }
@@ -546,7 +581,7 @@ static void iothub_ll_device_twin_callback(DEVICE_TWIN_UPDATE_STATE update_state
         }
         if (push_to_vector == 0)
         {
-            if (VECTOR_push_back(queue_context->iotHubClientHandle->saved_user_callback_list, &queue_cb_info, 1) != 0)
+            if (queue_user_callback(queue_context->iotHubClientHandle, &queue_cb_info, false) != 0)
             {
                 if (queue_cb_info.iothub_callback.dev_twin_cb_info.payLoad != NULL)
                 {
@@ -596,7 +631,7 @@ static void iothub_ll_get_device_twin_async_callback(DEVICE_TWIN_UPDATE_STATE up
             }
         }
 
-        if (VECTOR_push_back(queue_context->iotHubClientHandle->saved_user_callback_list, &queue_cb_info, 1) != 0)
+        if (queue_user_callback(queue_context->iotHubClientHandle, &queue_cb_info, false) != 0)
         {
             LogError("device twin callback userContextCallback vector push failed.");
 
@@ -665,19 +700,21 @@ static void invoke_application_command_callback(IOTHUB_CLIENT_CORE_HANDLE method
     STRING_delete(queued_cb->iothub_callback.method_cb_info.method_name);
 }
 
-static void dispatch_user_callbacks(IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientInstance, VECTOR_HANDLE call_backs)
+typedef struct USER_CALLBACK_SNAPSHOT_TAG
 {
-    size_t callbacks_length = VECTOR_size(call_backs);
-    size_t index;
+    IOTHUB_CLIENT_DEVICE_TWIN_CALLBACK desired_state_callback;
+    IOTHUB_CLIENT_CONNECTION_STATUS_CALLBACK connection_status_callback;
+    IOTHUB_CLIENT_DEVICE_METHOD_CALLBACK_ASYNC device_method_callback;
+    IOTHUB_CLIENT_INBOUND_DEVICE_METHOD_CALLBACK inbound_device_method_callback;
+    IOTHUB_CLIENT_COMMAND_CALLBACK_ASYNC command_callback;
+    IOTHUB_CLIENT_MESSAGE_CALLBACK_ASYNC message_callback;
+    IOTHUB_CLIENT_CORE_HANDLE message_user_context_handle;
+    IOTHUB_CLIENT_CORE_HANDLE method_user_context_handle;
+} USER_CALLBACK_SNAPSHOT;
 
-    IOTHUB_CLIENT_DEVICE_TWIN_CALLBACK desired_state_callback = NULL;
-    IOTHUB_CLIENT_CONNECTION_STATUS_CALLBACK connection_status_callback = NULL;
-    IOTHUB_CLIENT_DEVICE_METHOD_CALLBACK_ASYNC device_method_callback = NULL;
-    IOTHUB_CLIENT_INBOUND_DEVICE_METHOD_CALLBACK inbound_device_method_callback = NULL;
-    IOTHUB_CLIENT_COMMAND_CALLBACK_ASYNC command_callback = NULL;
-    IOTHUB_CLIENT_MESSAGE_CALLBACK_ASYNC message_callback = NULL;
-    IOTHUB_CLIENT_CORE_HANDLE message_user_context_handle = NULL;
-    IOTHUB_CLIENT_CORE_HANDLE method_user_context_handle = NULL;
+static void take_user_callback_snapshot(IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientInstance, USER_CALLBACK_SNAPSHOT* snapshot)
+{
+    memset(snapshot, 0, sizeof(USER_CALLBACK_SNAPSHOT));
 
     // Make a local copy of these callbacks, as we don't run with a lock held and iotHubClientInstance may change mid-run.
     if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
@@ -686,185 +723,287 @@ static void dispatch_user_callbacks(IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientIns
     }
     else
     {
-        desired_state_callback = iotHubClientInstance->desired_state_callback;
-        connection_status_callback = iotHubClientInstance->connection_status_callback;
-        device_method_callback = iotHubClientInstance->device_method_callback;
-        inbound_device_method_callback = iotHubClientInstance->inbound_device_method_callback;
-        command_callback = iotHubClientInstance->command_callback;
-        message_callback = iotHubClientInstance->message_callback;
+        snapshot->desired_state_callback = iotHubClientInstance->desired_state_callback;
+        snapshot->connection_status_callback = iotHubClientInstance->connection_status_callback;
+        snapshot->device_method_callback = iotHubClientInstance->device_method_callback;
+        snapshot->inbound_device_method_callback = iotHubClientInstance->inbound_device_method_callback;
+        snapshot->command_callback = iotHubClientInstance->command_callback;
+        snapshot->message_callback = iotHubClientInstance->message_callback;
         if (iotHubClientInstance->method_user_context)
         {
-            method_user_context_handle = iotHubClientInstance->method_user_context->iotHubClientHandle;
+            snapshot->method_user_context_handle = iotHubClientInstance->method_user_context->iotHubClientHandle;
         }
         if (iotHubClientInstance->message_user_context)
         {
-            message_user_context_handle = iotHubClientInstance->message_user_context->iotHubClientHandle;
+            snapshot->message_user_context_handle = iotHubClientInstance->message_user_context->iotHubClientHandle;
         }
 
         (void)Unlock(iotHubClientInstance->LockHandle);
     }
+}
 
-
-    for (index = 0; index < callbacks_length; index++)
+static void dispatch_user_callback(IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientInstance, const USER_CALLBACK_SNAPSHOT* snapshot, USER_CALLBACK_INFO* queued_cb)
+{
+    switch (queued_cb->type)
     {
-        USER_CALLBACK_INFO* queued_cb = (USER_CALLBACK_INFO*)VECTOR_element(call_backs, index);
-        if (queued_cb == NULL)
+    case CALLBACK_TYPE_DEVICE_TWIN:
+    {
+        // Callback if for GetTwinAsync
+        if (queued_cb->iothub_callback.dev_twin_cb_info.userCallback)
         {
-            LogError("VECTOR_element at index %zd is NULL.", index);
+            queued_cb->iothub_callback.dev_twin_cb_info.userCallback(
+                queued_cb->iothub_callback.dev_twin_cb_info.update_state,
+                queued_cb->iothub_callback.dev_twin_cb_info.payLoad,
+                queued_cb->iothub_callback.dev_twin_cb_info.size,
+                queued_cb->iothub_callback.dev_twin_cb_info.userContext
+            );
         }
-        else
+        // Callback if for Desired properties.
+        else if (snapshot->desired_state_callback)
         {
-            switch (queued_cb->type)
-            {
-            case CALLBACK_TYPE_DEVICE_TWIN:
+            snapshot->desired_state_callback(queued_cb->iothub_callback.dev_twin_cb_info.update_state, queued_cb->iothub_callback.dev_twin_cb_info.payLoad, queued_cb->iothub_callback.dev_twin_cb_info.size, queued_cb->userContextCallback);
+        }
+
+        if (queued_cb->iothub_callback.dev_twin_cb_info.payLoad)
+        {
+            free(queued_cb->iothub_callback.dev_twin_cb_info.payLoad);
+        }
+        break;
+    }
+    case CALLBACK_TYPE_EVENT_CONFIRM:
+        if (queued_cb->iothub_callback.event_confirm_cb_info.eventConfirmationCallback)
+        {
+            queued_cb->iothub_callback.event_confirm_cb_info.eventConfirmationCallback(queued_cb->iothub_callback.event_confirm_cb_info.confirm_result, queued_cb->userContextCallback);
+        }
+        break;
+    case CALLBACK_TYPE_REPORTED_STATE:
+        if (queued_cb->iothub_callback.reported_state_cb_info.reportedStateCallback)
+        {
+            queued_cb->iothub_callback.reported_state_cb_info.reportedStateCallback(queued_cb->iothub_callback.reported_state_cb_info.status_code, queued_cb->userContextCallback);
+        }
+        break;
+    case CALLBACK_TYPE_CONNECTION_STATUS:
+        if (snapshot->connection_status_callback)
+        {
+            snapshot->connection_status_callback(queued_cb->iothub_callback.connection_status_cb_info.connection_status, queued_cb->iothub_callback.connection_status_cb_info.status_reason, queued_cb->userContextCallback);
+        }
+        break;
+    case CALLBACK_TYPE_DEVICE_METHOD:
+        if (snapshot->device_method_callback)
+        {
+            const char* method_name = STRING_c_str(queued_cb->iothub_callback.method_cb_info.method_name);
+            const unsigned char* payload = BUFFER_u_char(queued_cb->iothub_callback.method_cb_info.payload);
+            size_t payload_len = BUFFER_length(queued_cb->iothub_callback.method_cb_info.payload);
+
+            unsigned char* payload_resp = NULL;
+            size_t response_size = 0;
+            int status = snapshot->device_method_callback(method_name, payload, payload_len, &payload_resp, &response_size, queued_cb->userContextCallback);
+
+            if (payload_resp && (response_size > 0))
             {
-                // Callback if for GetTwinAsync
-                if (queued_cb->iothub_callback.dev_twin_cb_info.userCallback)
-                {
-                    queued_cb->iothub_callback.dev_twin_cb_info.userCallback(
-                        queued_cb->iothub_callback.dev_twin_cb_info.update_state,
-                        queued_cb->iothub_callback.dev_twin_cb_info.payLoad,
-                        queued_cb->iothub_callback.dev_twin_cb_info.size,
-                        queued_cb->iothub_callback.dev_twin_cb_info.userContext
-                    );
-                }
-                // Callback if for Desired properties.
-                else if (desired_state_callback)
+                IOTHUB_CLIENT_RESULT result = IoTHubClientCore_DeviceMethodResponse(snapshot->method_user_context_handle, queued_cb->iothub_callback.method_cb_info.method_id, (const unsigned char*)payload_resp, response_size, status);
+                if (result != IOTHUB_CLIENT_OK)
                 {
-                    desired_state_callback(queued_cb->iothub_callback.dev_twin_cb_info.update_state, queued_cb->iothub_callback.dev_twin_cb_info.payLoad, queued_cb->iothub_callback.dev_twin_cb_info.size, queued_cb->userContextCallback);
+                    LogError("IoTHubClientCore_LL_DeviceMethodResponse failed");
                 }
+            }
 
-                if (queued_cb->iothub_callback.dev_twin_cb_info.payLoad)
-                {
-                    free(queued_cb->iothub_callback.dev_twin_cb_info.payLoad);
-                }
-                break;
+            BUFFER_delete(queued_cb->iothub_callback.method_cb_info.payload);
+            STRING_delete(queued_cb->iothub_callback.method_cb_info.method_name);
+
+            if (payload_resp)
+            {
+                free(payload_resp);
             }
-            case CALLBACK_TYPE_EVENT_CONFIRM:
-                if (queued_cb->iothub_callback.event_confirm_cb_info.eventConfirmationCallback)
-                {
-                    queued_cb->iothub_callback.event_confirm_cb_info.eventConfirmationCallback(queued_cb->iothub_callback.event_confirm_cb_info.confirm_result, queued_cb->userContextCallback);
-                }
-                break;
-            case CALLBACK_TYPE_REPORTED_STATE:
-                if (queued_cb->iothub_callback.reported_state_cb_info.reportedStateCallback)
-                {
-                    queued_cb->iothub_callback.reported_state_cb_info.reportedStateCallback(queued_cb->iothub_callback.reported_state_cb_info.status_code, queued_cb->userContextCallback);
-                }
-                break;
-            case CALLBACK_TYPE_CONNECTION_STATUS:
-                if (connection_status_callback)
-                {
-                    connection_status_callback(queued_cb->iothub_callback.connection_status_cb_info.connection_status, queued_cb->iothub_callback.connection_status_cb_info.status_reason, queued_cb->userContextCallback);
-                }
-                break;
-            case CALLBACK_TYPE_DEVICE_METHOD:
-                if (device_method_callback)
-                {
-                    const char* method_name = STRING_c_str(queued_cb->iothub_callback.method_cb_info.method_name);
-                    const unsigned char* payload = BUFFER_u_char(queued_cb->iothub_callback.method_cb_info.payload);
-                    size_t payload_len = BUFFER_length(queued_cb->iothub_callback.method_cb_info.payload);
+        }
+        break;
 
-                    unsigned char* payload_resp = NULL;
-                    size_t response_size = 0;
-                    int status = device_method_callback(method_name, payload, payload_len, &payload_resp, &response_size, queued_cb->userContextCallback);
+    case CALLBACK_TYPE_COMMAND:
+        if (snapshot->command_callback)
+        {
+            invoke_application_command_callback(snapshot->method_user_context_handle, snapshot->command_callback, queued_cb);
+        }
+        break;
+        
+    case CALLBACK_TYPE_INBOUND_DEVICE_METHOD:
+        if (snapshot->inbound_device_method_callback)
+        {
+            const char* method_name = STRING_c_str(queued_cb->iothub_callback.method_cb_info.method_name);
+            const unsigned char* payload = BUFFER_u_char(queued_cb->iothub_callback.method_cb_info.payload);
+            size_t payload_len = BUFFER_length(queued_cb->iothub_callback.method_cb_info.payload);
 
-                    if (payload_resp && (response_size > 0))
-                    {
-                        IOTHUB_CLIENT_RESULT result = IoTHubClientCore_DeviceMethodResponse(method_user_context_handle, queued_cb->iothub_callback.method_cb_info.method_id, (const unsigned char*)payload_resp, response_size, status);
-                        if (result != IOTHUB_CLIENT_OK)
-                        {
-                            LogError("IoTHubClientCore_LL_DeviceMethodResponse failed");
-                        }
-                    }
+            snapshot->inbound_device_method_callback(method_name, payload, payload_len, queued_cb->iothub_callback.method_cb_info.method_id, queued_cb->userContextCallback);
 
-                    BUFFER_delete(queued_cb->iothub_callback.method_cb_info.payload);
-                    STRING_delete(queued_cb->iothub_callback.method_cb_info.method_name);
+            BUFFER_delete(queued_cb->iothub_callback.method_cb_info.payload);
+            STRING_delete(queued_cb->iothub_callback.method_cb_info.method_name);
+        }
+        break;
+    case CALLBACK_TYPE_MESSAGE:
+        if (snapshot->message_callback && snapshot->message_user_context_handle)
+        {
+            IOTHUBMESSAGE_DISPOSITION_RESULT disposition = snapshot->message_callback(queued_cb->iothub_callback.message_handle, queued_cb->userContextCallback);
 
-                    if (payload_resp)
+            if (disposition != IOTHUBMESSAGE_ASYNC_ACK)
+            {
+                if (Lock(snapshot->message_user_context_handle->LockHandle) == LOCK_OK)
+                {
+                    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SendMessageDisposition(snapshot->message_user_context_handle->IoTHubClientLLHandle, queued_cb->iothub_callback.message_handle, disposition);
+                    (void)Unlock(snapshot->message_user_context_handle->LockHandle);
+                    if (result != IOTHUB_CLIENT_OK)
                     {
-                        free(payload_resp);
+                        LogError("IoTHubClientCore_LL_SendMessageDisposition failed");
                     }
                 }
-                break;
-
-            case CALLBACK_TYPE_COMMAND:
-                if (command_callback)
+                else
                 {
-                    invoke_application_command_callback(method_user_context_handle, command_callback, queued_cb);
+                    LogError("Lock failed");
                 }
-                break;
-                
-            case CALLBACK_TYPE_INBOUND_DEVICE_METHOD:
-                if (inbound_device_method_callback)
-                {
-                    const char* method_name = STRING_c_str(queued_cb->iothub_callback.method_cb_info.method_name);
-                    const unsigned char* payload = BUFFER_u_char(queued_cb->iothub_callback.method_cb_info.payload);
-                    size_t payload_len = BUFFER_length(queued_cb->iothub_callback.method_cb_info.payload);
+            }
+        }
+        break;
 
-                    inbound_device_method_callback(method_name, payload, payload_len, queued_cb->iothub_callback.method_cb_info.method_id, queued_cb->userContextCallback);
+    case CALLBACK_TYPE_INPUTMESSAGE:
+        {
+            const INPUTMESSAGE_CALLBACK_INFO *inputmessage_cb_info = &queued_cb->iothub_callback.inputmessage_cb_info;
+            IOTHUBMESSAGE_DISPOSITION_RESULT disposition = inputmessage_cb_info->eventHandlerCallback(inputmessage_cb_info->message_handle, queued_cb->userContextCallback);
 
-                    BUFFER_delete(queued_cb->iothub_callback.method_cb_info.payload);
-                    STRING_delete(queued_cb->iothub_callback.method_cb_info.method_name);
-                }
-                break;
-            case CALLBACK_TYPE_MESSAGE:
-                if (message_callback && message_user_context_handle)
+            if (disposition != IOTHUBMESSAGE_ASYNC_ACK)
+            {
+                if (Lock(iotHubClientInstance->LockHandle) == LOCK_OK)
                 {
-                    IOTHUBMESSAGE_DISPOSITION_RESULT disposition = message_callback(queued_cb->iothub_callback.message_handle, queued_cb->userContextCallback);
-
-                    if (disposition != IOTHUBMESSAGE_ASYNC_ACK)
+                    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SendMessageDisposition(iotHubClientInstance->IoTHubClientLLHandle, inputmessage_cb_info->message_handle, disposition);
+                    (void)Unlock(iotHubClientInstance->LockHandle);
+                    if (result != IOTHUB_CLIENT_OK)
                     {
-                        if (Lock(message_user_context_handle->LockHandle) == LOCK_OK)
-                        {
-                            IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SendMessageDisposition(message_user_context_handle->IoTHubClientLLHandle, queued_cb->iothub_callback.message_handle, disposition);
-                            (void)Unlock(message_user_context_handle->LockHandle);
-                            if (result != IOTHUB_CLIENT_OK)
-                            {
-                                LogError("IoTHubClientCore_LL_SendMessageDisposition failed");
-                            }
-                        }
-                        else
-                        {
-                            LogError("Lock failed");
-                        }
+                        LogError("IoTHubClient_LL_SendMessageDisposition failed");
                     }
                 }
-                break;
-
-            case CALLBACK_TYPE_INPUTMESSAGE:
+                else
                 {
-                    const INPUTMESSAGE_CALLBACK_INFO *inputmessage_cb_info = &queued_cb->iothub_callback.inputmessage_cb_info;
-                    IOTHUBMESSAGE_DISPOSITION_RESULT disposition = inputmessage_cb_info->eventHandlerCallback(inputmessage_cb_info->message_handle, queued_cb->userContextCallback);
-
-                    if (disposition != IOTHUBMESSAGE_ASYNC_ACK)
-                    {
-                        if (Lock(iotHubClientInstance->LockHandle) == LOCK_OK)
-                        {
-                            IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SendMessageDisposition(iotHubClientInstance->IoTHubClientLLHandle, inputmessage_cb_info->message_handle, disposition);
-                            (void)Unlock(iotHubClientInstance->LockHandle);
-                            if (result != IOTHUB_CLIENT_OK)
-                            {
-                                LogError("IoTHubClient_LL_SendMessageDisposition failed");
-                            }
-                        }
-                        else
-                        {
-                            LogError("Lock failed");
-                        }
-                    }
+                    LogError("Lock failed");
                 }
-                break;
-
-            default:
-                LogError("Invalid callback type '%s'", MU_ENUM_TO_STRING(USER_CALLBACK_TYPE, queued_cb->type));
-                break;
             }
         }
+        break;
+
+    default:
+        LogError("Invalid callback type '%s'", MU_ENUM_TO_STRING(USER_CALLBACK_TYPE, queued_cb->type));
+        break;
+    }
+}
+
+static void dispatch_user_callbacks(IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientInstance, VECTOR_HANDLE call_backs)
+{
+    size_t callbacks_length = VECTOR_size(call_backs);
+    size_t index;
+    USER_CALLBACK_SNAPSHOT snapshot;
+
+    take_user_callback_snapshot(iotHubClientInstance, &snapshot);
+
+    for (index = 0; index < callbacks_length; index++)
+    {
+        USER_CALLBACK_INFO* queued_cb = (USER_CALLBACK_INFO*)VECTOR_element(call_backs, index);
+        if (queued_cb == NULL)
+        {
+            LogError("VECTOR_element at index %zd is NULL.", index);
+        }
+        else
+        {
+            dispatch_user_callback(iotHubClientInstance, &snapshot, queued_cb);
+        }
     }
     VECTOR_destroy(call_backs);
 }
 
+// Releases a callback that is never going to be dispatched, completing the calls that the application waits on.
+static void release_user_callback(USER_CALLBACK_INFO* queue_cb_info)
+{
+    if ((queue_cb_info->type == CALLBACK_TYPE_DEVICE_METHOD) || (queue_cb_info->type == CALLBACK_TYPE_INBOUND_DEVICE_METHOD))
+    {
+        STRING_delete(queue_cb_info->iothub_callback.method_cb_info.method_name);
+        BUFFER_delete(queue_cb_info->iothub_callback.method_cb_info.payload);
+    }
+    else if (queue_cb_info->type == CALLBACK_TYPE_DEVICE_TWIN)
+    {
+        if (queue_cb_info->iothub_callback.dev_twin_cb_info.userCallback)
+        {
+            queue_cb_info->iothub_callback.dev_twin_cb_info.userCallback(
+                queue_cb_info->iothub_callback.dev_twin_cb_info.update_state,
+                queue_cb_info->iothub_callback.dev_twin_cb_info.payLoad,
+                queue_cb_info->iothub_callback.dev_twin_cb_info.size,
+                queue_cb_info->iothub_callback.dev_twin_cb_info.userContext
+            );
+        }
+
+        if (queue_cb_info->iothub_callback.dev_twin_cb_info.payLoad != NULL)
+        {
+            free(queue_cb_info->iothub_callback.dev_twin_cb_info.payLoad);
+        }
+    }
+    else if (queue_cb_info->type == CALLBACK_TYPE_EVENT_CONFIRM)
+    {
+        if (queue_cb_info->iothub_callback.event_confirm_cb_info.eventConfirmationCallback)
+        {
+            queue_cb_info->iothub_callback.event_confirm_cb_info.eventConfirmationCallback(queue_cb_info->iothub_callback.event_confirm_cb_info.confirm_result, queue_cb_info->userContextCallback);
+        }
+    }
+    else if (queue_cb_info->type == CALLBACK_TYPE_REPORTED_STATE)
+    {
+        if (queue_cb_info->iothub_callback.reported_state_cb_info.reportedStateCallback)
+        {
+            queue_cb_info->iothub_callback.reported_state_cb_info.reportedStateCallback(queue_cb_info->iothub_callback.reported_state_cb_info.status_code, queue_cb_info->userContextCallback);
+        }
+    }
+}
+
+// Invoked on the dispatch thread of the callback queue.  Messages and method calls evicted from the full queue are
+// settled without the application: the message is abandoned so that it is delivered again, the method call answered
+// with DROPPED_METHOD_RESPONSE_STATUS_CODE.
+static void on_callback_queue_dispatch(void* context, void* item, bool is_dropped)
+{
+    IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_CORE_INSTANCE*)context;
+    USER_CALLBACK_INFO* queued_cb = (USER_CALLBACK_INFO*)item;
+
+    if (!is_dropped)
+    {
+        USER_CALLBACK_SNAPSHOT snapshot;
+        take_user_callback_snapshot(iotHubClientInstance, &snapshot);
+        dispatch_user_callback(iotHubClientInstance, &snapshot, queued_cb);
+    }
+    else if (queued_cb->type == CALLBACK_TYPE_MESSAGE || queued_cb->type == CALLBACK_TYPE_INPUTMESSAGE)
+    {
+        IOTHUB_MESSAGE_HANDLE message_handle = (queued_cb->type == CALLBACK_TYPE_MESSAGE) ?
+            queued_cb->iothub_callback.message_handle : queued_cb->iothub_callback.inputmessage_cb_info.message_handle;
+
+        if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
+        {
+            LogError("Lock failed");
+        }
+        else
+        {
+            if (IoTHubClientCore_LL_SendMessageDisposition(iotHubClientInstance->IoTHubClientLLHandle, message_handle, IOTHUBMESSAGE_ABANDONED) != IOTHUB_CLIENT_OK)
+            {
+                LogError("IoTHubClientCore_LL_SendMessageDisposition failed");
+            }
+            (void)Unlock(iotHubClientInstance->LockHandle);
+        }
+    }
+    else if (queued_cb->type == CALLBACK_TYPE_DEVICE_METHOD || queued_cb->type == CALLBACK_TYPE_INBOUND_DEVICE_METHOD || queued_cb->type == CALLBACK_TYPE_COMMAND)
+    {
+        if (IoTHubClientCore_DeviceMethodResponse(iotHubClientInstance, queued_cb->iothub_callback.method_cb_info.method_id,
+            (const unsigned char*)CLIENT_CORE_METHOD_EMPTY_PAYLOAD, sizeof(CLIENT_CORE_METHOD_EMPTY_PAYLOAD) - 1, DROPPED_METHOD_RESPONSE_STATUS_CODE) != IOTHUB_CLIENT_OK)
+        {
+            LogError("IoTHubClientCore_DeviceMethodResponse failed");
+        }
+        STRING_delete(queued_cb->iothub_callback.method_cb_info.method_name);
+        BUFFER_delete(queued_cb->iothub_callback.method_cb_info.payload);
+    }
+    else
+    {
+        release_user_callback(queued_cb);
+    }
+}
+
 static void ScheduleWork_Thread_ForMultiplexing(void* iotHubClientHandle)
 {
     IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_CORE_INSTANCE*)iotHubClientHandle;
@@ -894,11 +1033,15 @@ static int ScheduleWork_Thread(void* threadArgument)
 {
     IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_CORE_INSTANCE*)threadArgument;
     unsigned int sleeptime_in_ms = DO_WORK_FREQ_DEFAULT;
+    CALLBACK_QUEUE_HANDLE blocking_callback_queue = NULL;
 
     srand((unsigned int)get_time(NULL));
 
     while (1)
     {
+        // Under IOTHUB_CLIENT_CALLBACK_QUEUE_BLOCK nothing more is read from the network until the application callbacks catch up
+        bool has_callback_room = (blocking_callback_queue == NULL) || callback_queue_wait_for_room(blocking_callback_queue, sleeptime_in_ms);
+
         if (Lock(iotHubClientInstance->LockHandle) == LOCK_OK)
         {
             if (iotHubClientInstance->StopThread)
@@ -906,6 +1049,11 @@ static int ScheduleWork_Thread(void* threadArgument)
                 (void)Unlock(iotHubClientInstance->LockHandle);
                 break; /*gets out of the thread*/
             }
+            else if (!has_callback_room)
+            {
+                (void)Unlock(iotHubClientInstance->LockHandle);
+                continue; /*already waited sleeptime_in_ms for room*/
+            }
             else
             {
                 IoTHubClientCore_LL_DoWork(iotHubClientInstance->IoTHubClientLLHandle);
@@ -913,6 +1061,7 @@ static int ScheduleWork_Thread(void* threadArgument)
                 garbageCollectorImpl(iotHubClientInstance);
                 VECTOR_HANDLE call_backs = VECTOR_move(iotHubClientInstance->saved_user_callback_list);
                 sleeptime_in_ms = (unsigned int)iotHubClientInstance->do_work_freq_ms; // Update the sleepval within the locked thread.
+                blocking_callback_queue = (iotHubClientInstance->callback_queue_overflow == IOTHUB_CLIENT_CALLBACK_QUEUE_BLOCK) ? iotHubClientInstance->callback_queue : NULL;
                 (void)Unlock(iotHubClientInstance->LockHandle);
                 if (call_backs == NULL)
                 {
@@ -1227,6 +1376,7 @@ void IoTHubClientCore_Destroy(IOTHUB_CLIENT_CORE_HANDLE iotHubClientHandle)
         bool joinClientThread;
         bool joinTransportThread;
         size_t vector_size;
+        CALLBACK_QUEUE_HANDLE callback_queue;
 
         IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_CORE_INSTANCE*)iotHubClientHandle;
 
@@ -1278,6 +1428,26 @@ void IoTHubClientCore_Destroy(IOTHUB_CLIENT_CORE_HANDLE iotHubClientHandle)
             LogError("unable to Lock - - will still proceed to try to end the thread without locking");
         }
 
+        /*a shared transport can still run DoWork for this client: detach the queue under the lock, so callbacks the
+        LL layer completes from here on go to saved_user_callback_list, and destroy it once the lock is released*/
+        callback_queue = iotHubClientInstance->callback_queue;
+        iotHubClientInstance->callback_queue = NULL;
+
+        if (callback_queue != NULL)
+        {
+            if (Unlock(iotHubClientInstance->LockHandle) != LOCK_OK)
+            {
+                LogError("unable to Unlock");
+            }
+
+            callback_queue_destroy(callback_queue);
+
+            if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
+            {
+                LogError("unable to Lock - - will still proceed to try to end the thread without locking");
+            }
+        }
+
         /*wait for all uploading threads to finish*/
         while (singlylinkedlist_get_head_item(iotHubClientInstance->httpWorkerThreadInfoList) != NULL)
         {
@@ -1315,42 +1485,7 @@ void IoTHubClientCore_Destroy(IOTHUB_CLIENT_CORE_HANDLE iotHubClientHandle)
             USER_CALLBACK_INFO* queue_cb_info = (USER_CALLBACK_INFO*)VECTOR_element(iotHubClientInstance->saved_user_callback_list, index);
             if (queue_cb_info != NULL)
             {
-                if ((queue_cb_info->type == CALLBACK_TYPE_DEVICE_METHOD) || (queue_cb_info->type == CALLBACK_TYPE_INBOUND_DEVICE_METHOD))
-                {
-                    STRING_delete(queue_cb_info->iothub_callback.method_cb_info.method_name);
-                    BUFFER_delete(queue_cb_info->iothub_callback.method_cb_info.payload);
-                }
-                else if (queue_cb_info->type == CALLBACK_TYPE_DEVICE_TWIN)
-                {
-                    if (queue_cb_info->iothub_callback.dev_twin_cb_info.userCallback)
-                    {
-                        queue_cb_info->iothub_callback.dev_twin_cb_info.userCallback(
-                            queue_cb_info->iothub_callback.dev_twin_cb_info.update_state,
-                            queue_cb_info->iothub_callback.dev_twin_cb_info.payLoad,
-                            queue_cb_info->iothub_callback.dev_twin_cb_info.size,
-                            queue_cb_info->iothub_callback.dev_twin_cb_info.userContext
-                        );
-                    }
-
-                    if (queue_cb_info->iothub_callback.dev_twin_cb_info.payLoad != NULL)
-                    {
-                        free(queue_cb_info->iothub_callback.dev_twin_cb_info.payLoad);
-                    }
-                }
-                else if (queue_cb_info->type == CALLBACK_TYPE_EVENT_CONFIRM)
-                {
-                    if (queue_cb_info->iothub_callback.event_confirm_cb_info.eventConfirmationCallback)
-                    {
-                        queue_cb_info->iothub_callback.event_confirm_cb_info.eventConfirmationCallback(queue_cb_info->iothub_callback.event_confirm_cb_info.confirm_result, queue_cb_info->userContextCallback);
-                    }
-                }
-                else if (queue_cb_info->type == CALLBACK_TYPE_REPORTED_STATE)
-                {
-                    if (queue_cb_info->iothub_callback.reported_state_cb_info.reportedStateCallback)
-                    {
-                        queue_cb_info->iothub_callback.reported_state_cb_info.reportedStateCallback(queue_cb_info->iothub_callback.reported_state_cb_info.status_code, queue_cb_info->userContextCallback);
-                    }
-                }
+                release_user_callback(queue_cb_info);
             }
         }
         VECTOR_destroy(iotHubClientInstance->saved_user_callback_list);
@@ -1715,6 +1850,17 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_GetLastMessageReceiveTime(IOTHUB_CLIENT_CO
     return result;
 }
 
+// Clients sharing a transport cannot hold up its worker thread, which serves the other clients too
+static IOTHUB_CLIENT_CALLBACK_QUEUE_OVERFLOW get_effective_callback_queue_overflow(IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientInstance)
+{
+    IOTHUB_CLIENT_CALLBACK_QUEUE_OVERFLOW result = iotHubClientInstance->callback_queue_overflow;
+    if (iotHubClientInstance->TransportHandle != NULL && result == IOTHUB_CLIENT_CALLBACK_QUEUE_BLOCK)
+    {
+        result = IOTHUB_CLIENT_CALLBACK_QUEUE_REJECT;
+    }
+    return result;
+}
+
 IOTHUB_CLIENT_RESULT IoTHubClientCore_SetOption(IOTHUB_CLIENT_CORE_HANDLE iotHubClientHandle, const char* optionName, const void* value)
 {
     IOTHUB_CLIENT_RESULT result;
@@ -1759,6 +1905,53 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_SetOption(IOTHUB_CLIENT_CORE_HANDLE iotHub
                     LogError("Invalid value: OPTION_DO_WORK_FREQUENCY_IN_MS cannot exceed %d ms. If you wish to reduce the frequency further, consider using the LL layer.", DO_WORK_MAXIMUM_ALLOWED_FREQUENCY);
                 }
             }
+            else if (strcmp(OPTION_CALLBACK_QUEUE_DEPTH, optionName) == 0)
+            {
+                size_t depth = *(const size_t*)value;
+
+                if (iotHubClientInstance->callback_queue != NULL)
+                {
+                    result = IOTHUB_CLIENT_INVALID_ARG;
+                    LogError("Invalid value: OPTION_CALLBACK_QUEUE_DEPTH can only be set once.");
+                }
+                else if (depth == 0)
+                {
+                    result = IOTHUB_CLIENT_OK;
+                }
+                else if ((iotHubClientInstance->callback_queue = callback_queue_create(sizeof(USER_CALLBACK_INFO), depth, get_effective_callback_queue_overflow(iotHubClientInstance), on_callback_queue_dispatch, iotHubClientInstance)) == NULL)
+                {
+                    result = IOTHUB_CLIENT_ERROR;
+                    LogError("callback_queue_create failed");
+                }
+                else
+                {
+                    result = IOTHUB_CLIENT_OK;
+                }
+            }
+            else if (strcmp(OPTION_CALLBACK_QUEUE_OVERFLOW, optionName) == 0)
+            {
+                IOTHUB_CLIENT_CALLBACK_QUEUE_OVERFLOW overflow = *(const IOTHUB_CLIENT_CALLBACK_QUEUE_OVERFLOW*)value;
+
+                if (overflow != IOTHUB_CLIENT_CALLBACK_QUEUE_BLOCK && overflow != IOTHUB_CLIENT_CALLBACK_QUEUE_REJECT && overflow != IOTHUB_CLIENT_CALLBACK_QUEUE_DROP_OLDEST)
+                {
+                    result = IOTHUB_CLIENT_INVALID_ARG;
+                    LogError("Invalid value: %d is not an IOTHUB_CLIENT_CALLBACK_QUEUE_OVERFLOW.", (int)overflow);
+                }
+                else
+                {
+                    iotHubClientInstance->callback_queue_overflow = overflow;
+                    if (iotHubClientInstance->callback_queue != NULL &&
+                        callback_queue_set_overflow(iotHubClientInstance->callback_queue, get_effective_callback_queue_overflow(iotHubClientInstance)) != 0)
+                    {
+                        result = IOTHUB_CLIENT_ERROR;
+                        LogError("callback_queue_set_overflow failed");
+                    }
+                    else
+                    {
+                        result = IOTHUB_CLIENT_OK;
+                    }
+                }
+            }
             else if (strcmp(OPTION_MESSAGE_TIMEOUT, optionName) == 0)
             {
                 iotHubClientInstance->currentMessageTimeout = * (tickcounter_ms_t *)value;
@@ -2808,3 +3001,74 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_SendMessageDisposition(IOTHUB_CLIENT_CORE_
 
     return result;
 }
+
+IOTHUB_CLIENT_RESULT IoTHubClientCore_GetCallbackQueueStatistics(IOTHUB_CLIENT_CORE_HANDLE iotHubClientHandle, IOTHUB_CLIENT_CALLBACK_QUEUE_STATISTICS* statistics)
+{
+    IOTHUB_CLIENT_RESULT result;
+
+    if (iotHubClientHandle == NULL || statistics == NULL)
+    {
+        LogError("Invalid argument (iotHubClientHandle=%p, statistics=%p)", iotHubClientHandle, statistics);
+        result = IOTHUB_CLIENT_INVALID_ARG;
+    }
+    else
+    {
+        IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_CORE_INSTANCE*)iotHubClientHandle;
+
+        if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
+        {
+            result = IOTHUB_CLIENT_ERROR;
+            LogError("Could not acquire lock");
+        }
+        else
+        {
+            if (iotHubClientInstance->callback_queue == NULL)
+            {
+                memset(statistics, 0, sizeof(IOTHUB_CLIENT_CALLBACK_QUEUE_STATISTICS));
+                result = IOTHUB_CLIENT_OK;
+            }
+            else if (callback_queue_get_statistics(iotHubClientInstance->callback_queue, statistics) != 0)
+            {
+                result = IOTHUB_CLIENT_ERROR;
+                LogError("callback_queue_get_statistics failed");
+            }
+            else
+            {
+                result = IOTHUB_CLIENT_OK;
+            }
+            (void)Unlock(iotHubClientInstance->LockHandle);
+        }
+    }
+
+    return result;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClientCore_GetMetrics(IOTHUB_CLIENT_CORE_HANDLE iotHubClientHandle, IOTHUB_CLIENT_METRICS* metrics)
+{
+    IOTHUB_CLIENT_RESULT result;
+
+    if (iotHubClientHandle == NULL)
+    {
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LogError("NULL iothubClientHandle");
+    }
+    else
+    {
+        IOTHUB_CLIENT_CORE_INSTANCE* iotHubClientInstance = (IOTHUB_CLIENT_CORE_INSTANCE*)iotHubClientHandle;
+
+        // The lock keeps the worker thread from changing the queues while they are walked for the gauges
+        if (Lock(iotHubClientInstance->LockHandle) != LOCK_OK)
+        {
+            result = IOTHUB_CLIENT_ERROR;
+            LogError("Could not acquire lock");
+        }
+        else
+        {
+            result = IoTHubClientCore_LL_GetMetrics(iotHubClientInstance->IoTHubClientLLHandle, metrics);
+
+            (void)Unlock(iotHubClientInstance->LockHandle);
+        }
+    }
+
+    return result;
+}
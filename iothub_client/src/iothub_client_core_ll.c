@@ -26,12 +26,20 @@
 #include "internal/iothub_client_authorization.h"
 #include "internal/iothub_client_private.h"
 #include "internal/iothub_client_diagnostic.h"
+#include "internal/iothub_client_twin_cache.h"
+#include "internal/iothub_client_reported_aggregator.h"
+#include "internal/iothub_client_metrics.h"
+#include "internal/iothub_client_tracing_private.h"
 #include "internal/iothubtransport.h"
 
 #ifndef DONT_USE_UPLOADTOBLOB
 #include "internal/iothub_client_ll_uploadtoblob.h"
 #endif
 
+#ifdef USE_COMPRESSION
+#include "internal/iothub_client_compression.h"
+#endif
+
 #include "azure_c_shared_utility/envvariable.h"
 #include "azure_prov_client/iothub_security_factory.h"
 #include "internal/iothub_client_edge.h"
@@ -39,6 +47,8 @@
 #define LOG_ERROR_RESULT LogError("result = %s", MU_ENUM_TO_STRING(IOTHUB_CLIENT_RESULT, result));
 #define INDEFINITE_TIME ((time_t)(-1))
 #define ERROR_CODE_BECAUSE_DESTROY 0
+// Status given to reported state callbacks when a merged reported state PATCH could not be queued.
+#define ERROR_CODE_REPORTED_STATE_NOT_QUEUED 500
 
 MU_DEFINE_ENUM_STRINGS_WITHOUT_INVALID(IOTHUB_CLIENT_FILE_UPLOAD_RESULT, IOTHUB_CLIENT_FILE_UPLOAD_RESULT_VALUES);
 MU_DEFINE_ENUM_STRINGS_WITHOUT_INVALID(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_RESULT_VALUES);
@@ -100,6 +110,7 @@ typedef struct GET_TWIN_CONTEXT_TAG
 {
     IOTHUB_CLIENT_DEVICE_TWIN_CALLBACK callback;
     void* context;
+    struct IOTHUB_CLIENT_CORE_LL_HANDLE_DATA_TAG* handleData;
 } GET_TWIN_CONTEXT;
 
 typedef struct IOTHUB_CLIENT_CORE_LL_HANDLE_DATA_TAG
@@ -135,6 +146,20 @@ typedef struct IOTHUB_CLIENT_CORE_LL_HANDLE_DATA_TAG
     IOTHUB_DIAGNOSTIC_SETTING_DATA diagnostic_setting;
     SINGLYLINKEDLIST_HANDLE event_callbacks;  // List of IOTHUB_EVENT_CALLBACK's
     STRING_HANDLE model_id;
+    TWIN_CACHE_HANDLE twin_cache; // Only created when OPTION_TWIN_CACHE is enabled
+    bool twin_cache_refetch_pending;
+    REPORTED_AGGREGATOR_HANDLE reported_aggregator; // Only exists while OPTION_REPORTED_STATE_FLUSH_INTERVAL_MS is in use
+    unsigned int reported_state_flush_interval_ms;
+    METRICS_HANDLE metrics; // Only created when OPTION_METRICS or OPTION_METRICS_EXPORT is set
+    bool metrics_authenticated; // Last connection status seen, so that only the loss of a connection counts as a disconnect
+    IOTHUB_CLIENT_METRICS_EXPORT metrics_export;
+    tickcounter_ms_t metrics_last_export_ms;
+#ifdef USE_COMPRESSION
+    COMPRESSION_HANDLE compression; // Only created when one of the OPTION_COMPRESSION* options is set
+#endif
+    // HTTP batches drop the content encoding, so OPTION_BATCHING and OPTION_COMPRESSION exclude each other
+    bool is_batching_on;
+    bool is_compression_on;
 }IOTHUB_CLIENT_CORE_LL_HANDLE_DATA;
 
 static const char HOSTNAME_TOKEN[] = "HostName";
@@ -298,6 +323,7 @@ static void setTransportProtocol(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData,
     handleData->IoTHubTransport_Unsubscribe_InputQueue = protocol->IoTHubTransport_Unsubscribe_InputQueue;
     handleData->IoTHubTransport_SetCallbackContext = protocol->IoTHubTransport_SetCallbackContext;
     handleData->IoTHubTransport_GetSupportedPlatformInfo = protocol->IoTHubTransport_GetSupportedPlatformInfo;
+    handleData->IoTHubTransport_GetPollInfo = protocol->IoTHubTransport_GetPollInfo;
 }
 
 static bool is_event_equal(IOTHUB_EVENT_CALLBACK *event_callback, const char *input_name)
@@ -450,10 +476,34 @@ static void destroy_module_method_module(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* hand
     IoTHubClient_EdgeHandle_Destroy(handle_data->methodHandle);
 }
 
+// record_message_received counts a cloud-to-device message and its body before the application gets to take the message.
+static void record_message_received(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData, IOTHUB_MESSAGE_HANDLE messageHandle)
+{
+    if (handleData->metrics != NULL)
+    {
+        const unsigned char* body;
+        size_t size;
+
+        if (IoTHubMessage_GetContentType(messageHandle) == IOTHUBMESSAGE_STRING)
+        {
+            const char* string = IoTHubMessage_GetString(messageHandle);
+            size = (string == NULL) ? 0 : strlen(string);
+        }
+        else if (IoTHubMessage_GetByteArray(messageHandle, &body, &size) != IOTHUB_MESSAGE_OK)
+        {
+            size = 0;
+        }
+
+        metrics_add(handleData->metrics, METRICS_MESSAGES_RECEIVED, 1);
+        metrics_add(handleData->metrics, METRICS_BYTES_RECEIVED, size);
+    }
+}
+
 static bool invoke_message_callback(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData, IOTHUB_MESSAGE_HANDLE messageHandle)
 {
     bool result;
     handleData->lastMessageReceiveTime = get_time(NULL);
+    record_message_received(handleData, messageHandle);
 
     switch (handleData->messageCallback.type)
     {
@@ -534,10 +584,16 @@ static void IoTHubClientCore_LL_SendComplete(PDLIST_ENTRY completed, IOTHUB_CLIE
     }
     else
     {
+        IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_CORE_LL_HANDLE_DATA*)ctx;
         PDLIST_ENTRY oldest;
         while ((oldest = DList_RemoveHeadList(completed)) != completed)
         {
             IOTHUB_MESSAGE_LIST* messageList = (IOTHUB_MESSAGE_LIST*)containingRecord(oldest, IOTHUB_MESSAGE_LIST, entry);
+            if (handleData->metrics != NULL)
+            {
+                metrics_record_send_complete(handleData->metrics, result, messageList->ms_enqueued);
+            }
+            IOTHUB_CLIENT_TRACE_COMPLETE(messageList, result);
             if (messageList->callback != NULL)
             {
                 messageList->callback(result, messageList->context);
@@ -548,6 +604,46 @@ static void IoTHubClientCore_LL_SendComplete(PDLIST_ENTRY completed, IOTHUB_CLIE
     }
 }
 
+static void on_twin_cache_refetch_completed(DEVICE_TWIN_UPDATE_STATE update_state, const unsigned char* payLoad, size_t size, void* userContextCallback);
+
+// update_twin_cache feeds a twin payload to the cache.  When a PATCH cannot be applied because one or more
+// PATCHes were missed, the complete twin is fetched again (at most one such request is outstanding).
+static void update_twin_cache(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData, DEVICE_TWIN_UPDATE_STATE update_state, const unsigned char* payLoad, size_t size)
+{
+    if ((handleData->twin_cache != NULL) && (payLoad != NULL) && (size > 0))
+    {
+        TWIN_CACHE_UPDATE_RESULT result = twin_cache_update(handleData->twin_cache, update_state, payLoad, size);
+
+        if ((result != TWIN_CACHE_UPDATE_OK) && (handleData->twin_cache_refetch_pending == false))
+        {
+            if (handleData->IoTHubTransport_GetTwinAsync(handleData->deviceHandle, on_twin_cache_refetch_completed, handleData) != IOTHUB_CLIENT_OK)
+            {
+                LogError("Failed requesting the complete twin to refresh the twin cache");
+            }
+            else
+            {
+                handleData->twin_cache_refetch_pending = true;
+            }
+        }
+    }
+}
+
+static void on_twin_cache_refetch_completed(DEVICE_TWIN_UPDATE_STATE update_state, const unsigned char* payLoad, size_t size, void* userContextCallback)
+{
+    IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_CORE_LL_HANDLE_DATA*)userContextCallback;
+
+    // A NULL payload means the request timed out or the transport is being destroyed; the next PATCH
+    // that cannot be applied will trigger a new request.
+    handleData->twin_cache_refetch_pending = false;
+    if ((handleData->twin_cache != NULL) && (payLoad != NULL) && (size > 0))
+    {
+        if (twin_cache_update(handleData->twin_cache, update_state, payLoad, size) != TWIN_CACHE_UPDATE_OK)
+        {
+            LogError("Failed refreshing the twin cache");
+        }
+    }
+}
+
 static void IoTHubClientCore_LL_RetrievePropertyComplete(DEVICE_TWIN_UPDATE_STATE update_state, const unsigned char* payLoad, size_t size, void* ctx)
 {
     if (ctx == NULL)
@@ -557,6 +653,11 @@ static void IoTHubClientCore_LL_RetrievePropertyComplete(DEVICE_TWIN_UPDATE_STAT
     else
     {
         IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_CORE_LL_HANDLE_DATA*)ctx;
+
+        // The cache is updated before the application is called back so that lookups made from
+        // within the callback already see this update.
+        update_twin_cache(handleData, update_state, payLoad, size);
+
         if (handleData->deviceTwinCallback)
         {
             if (update_state == DEVICE_TWIN_UPDATE_COMPLETE)
@@ -589,6 +690,15 @@ static void IoTHubClientCore_LL_ReportedStateComplete(uint32_t item_id, int stat
             IOTHUB_DEVICE_TWIN* queue_data = containingRecord(client_item, IOTHUB_DEVICE_TWIN, entry);
             if (queue_data->item_id == item_id)
             {
+                if ((handleData->twin_cache != NULL) && (status_code >= 200) && (status_code < 300))
+                {
+                    const CONSTBUFFER* report_data = CONSTBUFFER_GetContent(queue_data->report_data_handle);
+                    if ((report_data != NULL) && (twin_cache_apply_reported(handleData->twin_cache, report_data->buffer, report_data->size) != 0))
+                    {
+                        LogError("Failed applying reported properties to the twin cache");
+                    }
+                }
+
                 if (queue_data->reported_state_callback != NULL)
                 {
                     queue_data->reported_state_callback(status_code, queue_data->context);
@@ -613,6 +723,12 @@ static void IoTHubClientCore_LL_ConnectionStatusCallBack(IOTHUB_CLIENT_CONNECTIO
     {
         IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_CORE_LL_HANDLE_DATA*)ctx;
 
+        if (handleData->metrics != NULL && handleData->metrics_authenticated && status == IOTHUB_CLIENT_CONNECTION_UNAUTHENTICATED)
+        {
+            metrics_add(handleData->metrics, METRICS_DISCONNECTS, 1);
+        }
+        handleData->metrics_authenticated = (status == IOTHUB_CLIENT_CONNECTION_AUTHENTICATED);
+
         if (handleData->conStatusCallback != NULL)
         {
             handleData->conStatusCallback(status, reason, handleData->conStatusUserContextCallback);
@@ -653,6 +769,22 @@ static const char* IoTHubClientCore_LL_GetModelId(void* ctx)
     return result;
 }
 
+static METRICS_HANDLE IoTHubClientCore_LL_GetMetricsHandle(void* ctx)
+{
+    METRICS_HANDLE result;
+    if (ctx == NULL)
+    {
+        result = NULL;
+        LogError("invalid argument ctx %p", ctx);
+    }
+    else
+    {
+        IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* iothub_data = (IOTHUB_CLIENT_CORE_LL_HANDLE_DATA*)ctx;
+        result = iothub_data->metrics;
+    }
+    return result;
+}
+
 static bool IoTHubClientCore_LL_MessageCallbackFromInput(IOTHUB_MESSAGE_HANDLE messageHandle, void* ctx)
 {
     bool result;
@@ -697,6 +829,7 @@ static bool IoTHubClientCore_LL_MessageCallbackFromInput(IOTHUB_MESSAGE_HANDLE m
             else
             {
                 clientHandleData->lastMessageReceiveTime = get_time(NULL);
+                record_message_received(clientHandleData, messageHandle);
 
                 if (event_callback->callbackAsyncEx != NULL)
                 {
@@ -943,6 +1076,7 @@ static IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* initialize_iothub_client(const IOTHUB_
             transport_cb.msg_cb = IoTHubClientCore_LL_MessageCallback;
             transport_cb.method_complete_cb = IoTHubClientCore_LL_DeviceMethodComplete;
             transport_cb.get_model_id_cb = IoTHubClientCore_LL_GetModelId;
+            transport_cb.get_metrics_cb = IoTHubClientCore_LL_GetMetricsHandle;
 
             if (client_config != NULL)
             {
@@ -1240,6 +1374,7 @@ static void on_get_device_twin_completed(DEVICE_TWIN_UPDATE_STATE update_state,
     else
     {
         GET_TWIN_CONTEXT* getTwinCtx = (GET_TWIN_CONTEXT*)userContextCallback;
+        update_twin_cache(getTwinCtx->handleData, update_state, payLoad, size);
         getTwinCtx->callback(update_state, payLoad, size, getTwinCtx->context);
         free(getTwinCtx);
     }
@@ -1789,6 +1924,7 @@ void IoTHubClientCore_LL_Destroy(IOTHUB_CLIENT_CORE_LL_HANDLE iotHubClientHandle
         while ((unsend = DList_RemoveHeadList(&(handleData->waitingToSend))) != &(handleData->waitingToSend))
         {
             IOTHUB_MESSAGE_LIST* temp = containingRecord(unsend, IOTHUB_MESSAGE_LIST, entry);
+            IOTHUB_CLIENT_TRACE_COMPLETE(temp, IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY);
             if (temp->callback != NULL)
             {
                 temp->callback(IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY, temp->context);
@@ -1838,6 +1974,21 @@ void IoTHubClientCore_LL_Destroy(IOTHUB_CLIENT_CORE_LL_HANDLE iotHubClientHandle
 
         STRING_delete(handleData->product_info);
         STRING_delete(handleData->model_id);
+        if (handleData->twin_cache != NULL)
+        {
+            twin_cache_destroy(handleData->twin_cache);
+        }
+        if (handleData->reported_aggregator != NULL)
+        {
+            reported_aggregator_destroy(handleData->reported_aggregator, ERROR_CODE_BECAUSE_DESTROY);
+        }
+        if (handleData->metrics != NULL)
+        {
+            metrics_destroy(handleData->metrics);
+        }
+#ifdef USE_COMPRESSION
+        compression_destroy(handleData->compression);
+#endif
         free(handleData);
     }
 }
@@ -1913,10 +2064,30 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_SendEventAsync(IOTHUB_CLIENT_CORE_LL_HA
                     free(newEntry);
                     LOG_ERROR_RESULT;
                 }
+#ifdef USE_COMPRESSION
+                // Compresses the clone, the application keeps its message as it was
+                else if (handleData->compression != NULL && compression_compress_message(handleData->compression, newEntry->messageHandle) != 0)
+                {
+                    result = IOTHUB_CLIENT_ERROR;
+                    IoTHubMessage_Destroy(newEntry->messageHandle);
+                    free(newEntry);
+                    LOG_ERROR_RESULT;
+                }
+#endif
                 else
                 {
                     newEntry->callback = eventConfirmationCallback;
                     newEntry->context = userContextCallback;
+                    if (handleData->metrics != NULL)
+                    {
+                        newEntry->ms_enqueued = metrics_get_current_ms(handleData->metrics);
+                        metrics_add(handleData->metrics, METRICS_MESSAGES_ENQUEUED, 1);
+                    }
+                    else
+                    {
+                        newEntry->ms_enqueued = 0;
+                    }
+                    IOTHUB_CLIENT_TRACE_BEGIN(newEntry);
                     DList_InsertTailList(&(iotHubClientHandle->waitingToSend), &(newEntry->entry));
                     result = IOTHUB_CLIENT_OK;
                 }
@@ -2092,6 +2263,11 @@ static void DoTimeouts(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData)
             {
                 PDLIST_ENTRY theNext = currentItemInWaitingToSend->Flink; /*need to save the next item, because the below operations are destructive*/
                 DList_RemoveEntryList(currentItemInWaitingToSend);
+                if (handleData->metrics != NULL)
+                {
+                    metrics_record_send_complete(handleData->metrics, IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT, fullEntry->ms_enqueued);
+                }
+                IOTHUB_CLIENT_TRACE_COMPLETE(fullEntry, IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT);
                 if (fullEntry->callback != NULL)
                 {
                     fullEntry->callback(IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT, fullEntry->context);
@@ -2108,6 +2284,100 @@ static void DoTimeouts(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData)
     }
 }
 
+// flush_reported_aggregator queues the merged reported state PATCH once its flush interval has elapsed.  The
+// PATCH completes through reported_aggregator_on_patch_complete, which invokes every callback merged into it.
+static void flush_reported_aggregator(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData)
+{
+    tickcounter_ms_t nowTick;
+
+    if (tickcounter_get_current_ms(handleData->tickCounter, &nowTick) != 0)
+    {
+        LogError("unable to get the current ms, reported state not flushed");
+    }
+    else
+    {
+        const unsigned char* patch;
+        size_t size;
+        void* batch_context;
+        REPORTED_AGGREGATOR_FLUSH_RESULT flush_result = reported_aggregator_flush(handleData->reported_aggregator, nowTick, &patch, &size, &batch_context);
+
+        if (flush_result == REPORTED_AGGREGATOR_FLUSH_PATCH_READY)
+        {
+            IOTHUB_DEVICE_TWIN* client_data = dev_twin_data_create(handleData, get_next_item_id(handleData), patch, size, reported_aggregator_on_patch_complete, batch_context);
+            if (client_data == NULL)
+            {
+                LogError("Failure constructing device twin data for merged reported state");
+                reported_aggregator_on_patch_complete(ERROR_CODE_REPORTED_STATE_NOT_QUEUED, batch_context);
+            }
+            else
+            {
+                DList_InsertTailList(&(handleData->iot_msg_queue), &(client_data->entry));
+            }
+        }
+        else if (flush_result == REPORTED_AGGREGATOR_FLUSH_ERROR)
+        {
+            LogError("Failure flushing merged reported state");
+        }
+    }
+
+    // Aggregation was turned off; keep the aggregator until what it already holds has been sent so reports are not reordered.
+    if ((handleData->reported_state_flush_interval_ms == 0) && reported_aggregator_is_idle(handleData->reported_aggregator))
+    {
+        reported_aggregator_destroy(handleData->reported_aggregator, ERROR_CODE_BECAUSE_DESTROY);
+        handleData->reported_aggregator = NULL;
+    }
+}
+
+// get_metrics_snapshot adds the queue gauges, which only this thread may walk, to the counters of the registry.
+static int get_metrics_snapshot(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData, IOTHUB_CLIENT_METRICS* metrics)
+{
+    int result;
+
+    if (metrics_get_snapshot(handleData->metrics, metrics) != 0)
+    {
+        LogError("metrics_get_snapshot failed");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        size_t completed = metrics->messagesAcknowledged + metrics->messagesFailed + metrics->messagesTimedOut + metrics->messagesDropped;
+        size_t pending = (metrics->messagesEnqueued > completed) ? metrics->messagesEnqueued - completed : 0;
+        PDLIST_ENTRY entry;
+
+        for (entry = handleData->waitingToSend.Flink; entry != &(handleData->waitingToSend); entry = entry->Flink)
+        {
+            metrics->messagesWaiting++;
+        }
+
+        // Messages enqueued before metrics were turned on may complete after, so the difference can run short
+        metrics->messagesInFlight = (pending > metrics->messagesWaiting) ? pending - metrics->messagesWaiting : 0;
+        result = 0;
+    }
+
+    return result;
+}
+
+static void export_metrics(IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData)
+{
+    tickcounter_ms_t nowTick;
+
+    if (tickcounter_get_current_ms(handleData->tickCounter, &nowTick) != 0)
+    {
+        LogError("unable to get the current ms, metrics not exported");
+    }
+    else if ((nowTick - handleData->metrics_last_export_ms) >= handleData->metrics_export.intervalMs)
+    {
+        IOTHUB_CLIENT_METRICS metrics;
+
+        handleData->metrics_last_export_ms = nowTick;
+
+        if (get_metrics_snapshot(handleData, &metrics) == 0)
+        {
+            handleData->metrics_export.callback(&metrics, handleData->metrics_export.userContextCallback);
+        }
+    }
+}
+
 void IoTHubClientCore_LL_DoWork(IOTHUB_CLIENT_CORE_LL_HANDLE iotHubClientHandle)
 {
     if (iotHubClientHandle != NULL)
@@ -2115,6 +2385,11 @@ void IoTHubClientCore_LL_DoWork(IOTHUB_CLIENT_CORE_LL_HANDLE iotHubClientHandle)
         IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_CORE_LL_HANDLE_DATA*)iotHubClientHandle;
         DoTimeouts(handleData);
 
+        if (handleData->reported_aggregator != NULL)
+        {
+            flush_reported_aggregator(handleData);
+        }
+
         DLIST_ENTRY* client_item = handleData->iot_msg_queue.Flink;
         while (client_item != &(handleData->iot_msg_queue)) /*while we are not at the end of the list*/
         {
@@ -2146,9 +2421,81 @@ void IoTHubClientCore_LL_DoWork(IOTHUB_CLIENT_CORE_LL_HANDLE iotHubClientHandle)
         }
 
         handleData->IoTHubTransport_DoWork(handleData->transportHandle);
+
+        if (handleData->metrics != NULL && handleData->metrics_export.callback != NULL)
+        {
+            export_metrics(handleData);
+        }
     }
 }
 
+// Lowers timeout_ms to the time left until deadline_ms, which is 0 once it has passed
+static size_t lower_timeout_to_deadline(size_t timeout_ms, tickcounter_ms_t now_ms, tickcounter_ms_t deadline_ms)
+{
+    tickcounter_ms_t time_left = (deadline_ms > now_ms) ? (deadline_ms - now_ms) : 0;
+    return (time_left < timeout_ms) ? (size_t)time_left : timeout_ms;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_GetPollInfo(IOTHUB_CLIENT_CORE_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_POLL_INFO* pollInfo)
+{
+    IOTHUB_CLIENT_RESULT result;
+    IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_CORE_LL_HANDLE_DATA*)iotHubClientHandle;
+    tickcounter_ms_t nowTick;
+
+    if (handleData == NULL || pollInfo == NULL)
+    {
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LOG_ERROR_RESULT;
+    }
+    else if (handleData->IoTHubTransport_GetPollInfo == NULL)
+    {
+        LogError("The transport does not tell when DoWork is due");
+        result = IOTHUB_CLIENT_ERROR;
+    }
+    else if (handleData->IoTHubTransport_GetPollInfo(handleData->transportHandle, !DList_IsListEmpty(&(handleData->iot_msg_queue)), pollInfo) != IOTHUB_CLIENT_OK)
+    {
+        LogError("Failure getting the poll info of the transport");
+        result = IOTHUB_CLIENT_ERROR;
+    }
+    else if (tickcounter_get_current_ms(handleData->tickCounter, &nowTick) != 0)
+    {
+        LogError("unable to get the current ms");
+        result = IOTHUB_CLIENT_ERROR;
+    }
+    else
+    {
+        // The deadlines of DoTimeouts, flush_reported_aggregator and export_metrics
+        DLIST_ENTRY* currentItemInWaitingToSend = handleData->waitingToSend.Flink;
+        while (currentItemInWaitingToSend != &(handleData->waitingToSend))
+        {
+            IOTHUB_MESSAGE_LIST* fullEntry = containingRecord(currentItemInWaitingToSend, IOTHUB_MESSAGE_LIST, entry);
+            if (fullEntry->ms_timesOutAfter != 0)
+            {
+                pollInfo->timeoutMs = lower_timeout_to_deadline(pollInfo->timeoutMs, nowTick, fullEntry->ms_timesOutAfter + fullEntry->message_timeout_value + 1);
+            }
+            currentItemInWaitingToSend = currentItemInWaitingToSend->Flink;
+        }
+
+        if (handleData->reported_aggregator != NULL)
+        {
+            tickcounter_ms_t flushTimeout;
+            if (reported_aggregator_get_flush_timeout(handleData->reported_aggregator, nowTick, &flushTimeout))
+            {
+                pollInfo->timeoutMs = lower_timeout_to_deadline(pollInfo->timeoutMs, nowTick, nowTick + flushTimeout);
+            }
+        }
+
+        if (handleData->metrics != NULL && handleData->metrics_export.callback != NULL)
+        {
+            pollInfo->timeoutMs = lower_timeout_to_deadline(pollInfo->timeoutMs, nowTick, handleData->metrics_last_export_ms + handleData->metrics_export.intervalMs);
+        }
+
+        result = IOTHUB_CLIENT_OK;
+    }
+
+    return result;
+}
+
 IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_GetSendStatus(IOTHUB_CLIENT_CORE_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_STATUS *iotHubClientStatus)
 {
     IOTHUB_CLIENT_RESULT result;
@@ -2243,6 +2590,34 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_GetRetryPolicy(IOTHUB_CLIENT_CORE_LL_HA
     return result;
 }
 
+IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_GetMetrics(IOTHUB_CLIENT_CORE_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_METRICS* metrics)
+{
+    IOTHUB_CLIENT_RESULT result;
+    IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_CORE_LL_HANDLE_DATA*)iotHubClientHandle;
+
+    if (handleData == NULL || metrics == NULL)
+    {
+        result = IOTHUB_CLIENT_INVALID_ARG;
+        LOG_ERROR_RESULT;
+    }
+    else if (handleData->metrics == NULL)
+    {
+        LogError("Metrics are not enabled, see OPTION_METRICS");
+        result = IOTHUB_CLIENT_ERROR;
+    }
+    else if (get_metrics_snapshot(handleData, metrics) != 0)
+    {
+        result = IOTHUB_CLIENT_ERROR;
+        LOG_ERROR_RESULT;
+    }
+    else
+    {
+        result = IOTHUB_CLIENT_OK;
+    }
+
+    return result;
+}
+
 IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_GetLastMessageReceiveTime(IOTHUB_CLIENT_CORE_LL_HANDLE iotHubClientHandle, time_t* lastMessageReceiveTime)
 {
     IOTHUB_CLIENT_RESULT result;
@@ -2364,6 +2739,147 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_SetOption(IOTHUB_CLIENT_CORE_LL_HANDLE
                 result = IOTHUB_CLIENT_OK;
             }
         }
+        else if (strcmp(optionName, OPTION_TWIN_CACHE) == 0)
+        {
+            bool enable = *(const bool*)value;
+            if (enable && (handleData->twin_cache == NULL))
+            {
+                if ((handleData->twin_cache = twin_cache_create()) == NULL)
+                {
+                    LogError("twin_cache_create failed");
+                    result = IOTHUB_CLIENT_ERROR;
+                }
+                // The cache needs the twin topics even when the application has no twin callback.  If the complete
+                // twin was already delivered, the first PATCH is reported as a version gap and the twin is fetched again.
+                else if (handleData->IoTHubTransport_Subscribe_DeviceTwin(handleData->transportHandle) != 0)
+                {
+                    LogError("Failure subscribing to device twin for the twin cache");
+                    twin_cache_destroy(handleData->twin_cache);
+                    handleData->twin_cache = NULL;
+                    result = IOTHUB_CLIENT_ERROR;
+                }
+                else
+                {
+                    result = IOTHUB_CLIENT_OK;
+                }
+            }
+            else
+            {
+                if (!enable)
+                {
+                    twin_cache_destroy(handleData->twin_cache);
+                    handleData->twin_cache = NULL;
+                }
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        else if (strcmp(optionName, OPTION_METRICS) == 0)
+        {
+            bool enable = *(const bool*)value;
+            if (enable && (handleData->metrics == NULL) && ((handleData->metrics = metrics_create()) == NULL))
+            {
+                LogError("metrics_create failed");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                if (!enable && (handleData->metrics != NULL))
+                {
+                    metrics_destroy(handleData->metrics);
+                    handleData->metrics = NULL;
+                    memset(&handleData->metrics_export, 0, sizeof(IOTHUB_CLIENT_METRICS_EXPORT));
+                }
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        else if (strcmp(optionName, OPTION_METRICS_EXPORT) == 0)
+        {
+            const IOTHUB_CLIENT_METRICS_EXPORT* metricsExport = (const IOTHUB_CLIENT_METRICS_EXPORT*)value;
+            if (metricsExport->callback != NULL && metricsExport->intervalMs == 0)
+            {
+                LogError("The metrics export interval cannot be 0");
+                result = IOTHUB_CLIENT_INVALID_ARG;
+            }
+            else if ((handleData->metrics == NULL) && ((handleData->metrics = metrics_create()) == NULL))
+            {
+                LogError("metrics_create failed");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else if (tickcounter_get_current_ms(handleData->tickCounter, &handleData->metrics_last_export_ms) != 0)
+            {
+                LogError("unable to get the current ms, metrics export not set");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                handleData->metrics_export = *metricsExport;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+        else if ((strcmp(optionName, OPTION_COMPRESSION) == 0) ||
+                 (strcmp(optionName, OPTION_COMPRESSION_THRESHOLD) == 0) ||
+                 (strcmp(optionName, OPTION_COMPRESSION_LEVEL) == 0) ||
+                 (strcmp(optionName, OPTION_COMPRESSION_DICTIONARY) == 0))
+        {
+#ifdef USE_COMPRESSION
+            bool isCompressionOption = (strcmp(optionName, OPTION_COMPRESSION) == 0);
+
+            if (isCompressionOption && handleData->is_batching_on && *(const IOTHUB_CLIENT_COMPRESSION*)value != IOTHUB_CLIENT_COMPRESSION_NONE)
+            {
+                LogError("%s cannot be used with %s, HTTP batches do not carry the content encoding", OPTION_COMPRESSION, OPTION_BATCHING);
+                result = IOTHUB_CLIENT_INVALID_ARG;
+            }
+            else if ((handleData->compression == NULL) && ((handleData->compression = compression_create()) == NULL))
+            {
+                LogError("compression_create failed");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else if (compression_set_option(handleData->compression, optionName, value) != 0)
+            {
+                LogError("Invalid value for option %s", optionName);
+                result = IOTHUB_CLIENT_INVALID_ARG;
+            }
+            else
+            {
+                if (isCompressionOption)
+                {
+                    handleData->is_compression_on = (*(const IOTHUB_CLIENT_COMPRESSION*)value != IOTHUB_CLIENT_COMPRESSION_NONE);
+                }
+                result = IOTHUB_CLIENT_OK;
+            }
+#else
+            LogError("%s option being set without the USE_COMPRESSION compiler switch", optionName);
+            result = IOTHUB_CLIENT_ERROR;
+#endif /*USE_COMPRESSION*/
+        }
+        else if (strcmp(optionName, OPTION_REPORTED_STATE_FLUSH_INTERVAL_MS) == 0)
+        {
+            unsigned int flushIntervalMs = *(const unsigned int*)value;
+            if (handleData->reported_aggregator == NULL)
+            {
+                if ((flushIntervalMs != 0) && ((handleData->reported_aggregator = reported_aggregator_create(flushIntervalMs)) == NULL))
+                {
+                    LogError("reported_aggregator_create failed");
+                    result = IOTHUB_CLIENT_ERROR;
+                }
+                else
+                {
+                    handleData->reported_state_flush_interval_ms = flushIntervalMs;
+                    result = IOTHUB_CLIENT_OK;
+                }
+            }
+            // A zero interval flushes on the next DoWork, after which the aggregator is released.
+            else if (reported_aggregator_set_flush_interval(handleData->reported_aggregator, flushIntervalMs) != 0)
+            {
+                LogError("reported_aggregator_set_flush_interval failed");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                handleData->reported_state_flush_interval_ms = flushIntervalMs;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
         else if (strcmp(optionName, OPTION_MODEL_ID) == 0)
         {
             if (handleData->model_id != NULL)
@@ -2381,6 +2897,24 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_SetOption(IOTHUB_CLIENT_CORE_LL_HANDLE
                 result = IOTHUB_CLIENT_OK;
             }
         }
+        else if (strcmp(optionName, OPTION_BATCHING) == 0)
+        {
+            bool isBatchingOn = *(const bool*)value;
+
+            if (isBatchingOn && handleData->is_compression_on)
+            {
+                LogError("%s cannot be used with %s, HTTP batches do not carry the content encoding", OPTION_BATCHING, OPTION_COMPRESSION);
+                result = IOTHUB_CLIENT_INVALID_ARG;
+            }
+            else if ((result = handleData->IoTHubTransport_SetOption(handleData->transportHandle, optionName, value)) != IOTHUB_CLIENT_OK)
+            {
+                LogError("unable to IoTHubTransport_SetOption");
+            }
+            else
+            {
+                handleData->is_batching_on = isBatchingOn;
+            }
+        }
         else
         {
             // This section is unusual for SetOption calls because it attempts to pass unhandled options
@@ -2415,7 +2949,11 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_SetDeviceTwinCallback(IOTHUB_CLIENT_COR
         IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_CORE_LL_HANDLE_DATA*)iotHubClientHandle;
         if (deviceTwinCallback == NULL)
         {
-            handleData->IoTHubTransport_Unsubscribe_DeviceTwin(handleData->transportHandle);
+            // The twin cache still needs the twin topics.
+            if (handleData->twin_cache == NULL)
+            {
+                handleData->IoTHubTransport_Unsubscribe_DeviceTwin(handleData->transportHandle);
+            }
             handleData->deviceTwinCallback = NULL;
             result = IOTHUB_CLIENT_OK;
         }
@@ -2444,6 +2982,30 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_SendReportedState(IOTHUB_CLIENT_CORE_LL
         result = IOTHUB_CLIENT_INVALID_ARG;
         LogError("Invalid argument specified iothubClientHandle=%p, reportedState=%p, size=%lu", iotHubClientHandle, reportedState, (unsigned long)size);
     }
+    else if (iotHubClientHandle->reported_aggregator != NULL)
+    {
+        tickcounter_ms_t nowTick;
+
+        if (tickcounter_get_current_ms(iotHubClientHandle->tickCounter, &nowTick) != 0)
+        {
+            LogError("unable to get the current ms");
+            result = IOTHUB_CLIENT_ERROR;
+        }
+        else if (iotHubClientHandle->IoTHubTransport_Subscribe_DeviceTwin(iotHubClientHandle->transportHandle) != 0)
+        {
+            LogError("Failure subscribing to device twin");
+            result = IOTHUB_CLIENT_ERROR;
+        }
+        else if (reported_aggregator_add(iotHubClientHandle->reported_aggregator, reportedState, size, reportedStateCallback, userContextCallback, nowTick) != 0)
+        {
+            LogError("Failure merging reported state");
+            result = IOTHUB_CLIENT_ERROR;
+        }
+        else
+        {
+            result = IOTHUB_CLIENT_OK;
+        }
+    }
     else
     {
         IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_CORE_LL_HANDLE_DATA*)iotHubClientHandle;
@@ -2502,6 +3064,7 @@ IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_GetTwinAsync(IOTHUB_CLIENT_CORE_LL_HAND
                 IOTHUB_CLIENT_CORE_LL_HANDLE_DATA* handleData = (IOTHUB_CLIENT_CORE_LL_HANDLE_DATA*)iotHubClientHandle;
 
                 getTwinCtx->callback = deviceTwinCallback;
+                getTwinCtx->handleData = handleData;
                 getTwinCtx->context = userContextCallback;
 
                 if (handleData->IoTHubTransport_GetTwinAsync(handleData->deviceHandle, on_get_device_twin_completed, getTwinCtx) != IOTHUB_CLIENT_OK)
@@ -2572,6 +3135,28 @@ static IOTHUB_CLIENT_RESULT VerifyMethodCallbackType(IOTHUB_CLIENT_CORE_LL_HANDL
     return result;
 }
 
+IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_GetCachedProperty(IOTHUB_CLIENT_CORE_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_PROPERTY_TYPE propertyType, const char* componentName, const char* propertyName, IOTHUB_CLIENT_PROPERTY_PARSED* property, bool* propertySpecified)
+{
+    IOTHUB_CLIENT_RESULT result;
+
+    if (iotHubClientHandle == NULL)
+    {
+        LogError("Invalid argument iothubClientHandle=NULL");
+        result = IOTHUB_CLIENT_INVALID_ARG;
+    }
+    else if (iotHubClientHandle->twin_cache == NULL)
+    {
+        LogError("%s option is not enabled", OPTION_TWIN_CACHE);
+        result = IOTHUB_CLIENT_ERROR;
+    }
+    else
+    {
+        result = twin_cache_get_property(iotHubClientHandle->twin_cache, propertyType, componentName, propertyName, property, propertySpecified);
+    }
+
+    return result;
+}
+
 IOTHUB_CLIENT_RESULT IoTHubClientCore_LL_SetDeviceMethodCallback(IOTHUB_CLIENT_CORE_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_DEVICE_METHOD_CALLBACK_ASYNC deviceMethodCallback, void* userContextCallback)
 {
     IOTHUB_CLIENT_RESULT result;
@@ -3293,6 +3878,7 @@ int IoTHubClientCore_LL_GetTransportCallbacks(TRANSPORT_CALLBACKS_INFO* transpor
         transport_cb->msg_cb = IoTHubClientCore_LL_MessageCallback;
         transport_cb->method_complete_cb = IoTHubClientCore_LL_DeviceMethodComplete;
         transport_cb->get_model_id_cb = IoTHubClientCore_LL_GetModelId;
+        transport_cb->get_metrics_cb = IoTHubClientCore_LL_GetMetricsHandle;
         result = 0;
     }
     return result;
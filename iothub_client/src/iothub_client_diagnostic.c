@@ -2,17 +2,17 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #include <stdlib.h>
-#include <inttypes.h>
-#include <math.h>
+#include <stdint.h>
 #include "azure_c_shared_utility/optimize_size.h"
-#include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/agenttime.h"
-#include "azure_c_shared_utility/buffer_.h"
 
 #include "internal/iothub_client_diagnostic.h"
 
-#define TIME_STRING_BUFFER_LEN 30
+#define DIAGNOSTIC_ID_LENGTH 8
+
+// Room for the decimal digits of any 64 bit time_t
+#define TIME_STRING_BUFFER_LEN 21
 
 static const int BASE_36 = 36;
 
@@ -22,41 +22,24 @@ static char* get_epoch_time(char* timeBuffer)
 {
     char* result;
     time_t epochTime;
-    int timeLen = sizeof(time_t);
 
-    if ((epochTime = get_time(NULL)) == INDEFINITE_TIME)
+    if ((epochTime = get_time(NULL)) == INDEFINITE_TIME || epochTime < 0)
     {
         LogError("Failed getting current time");
         result = NULL;
     }
-    else if (timeLen == sizeof(int64_t))
-    {
-        if (sprintf(timeBuffer, "%"PRIu64, (int64_t)epochTime) < 0)
-        {
-            LogError("Failed sprintf to timeBuffer with 8 bytes of time_t");
-            result = NULL;
-        }
-        else
-        {
-            result = timeBuffer;
-        }
-    }
-    else if (timeLen == sizeof(int32_t))
-    {
-        if (sprintf(timeBuffer, "%"PRIu32, (int32_t)epochTime) < 0)
-        {
-            LogError("Failed sprintf to timeBuffer with 4 bytes of time_t");
-            result = NULL;
-        }
-        else
-        {
-            result = timeBuffer;
-        }
-    }
     else
     {
-        LogError("Unknown size of time_t");
-        result = NULL;
+        // The digits are written backwards from the end of the buffer, which saves formatting with sprintf
+        uint64_t value = (uint64_t)epochTime;
+        result = timeBuffer + TIME_STRING_BUFFER_LEN - 1;
+        *result = '\0';
+
+        do
+        {
+            *--result = (char)('0' + (value % 10));
+            value /= 10;
+        } while (value != 0);
     }
 
     return result;
@@ -89,66 +72,15 @@ static bool should_add_diagnostic_info(IOTHUB_DIAGNOSTIC_SETTING_DATA* diagSetti
     bool result = false;
     if (diagSetting->diagSamplingPercentage > 0)
     {
-        double number;
-        double percentage;
-
         if (diagSetting->currentMessageNumber == UINT32_MAX)
         {
             diagSetting->currentMessageNumber %= diagSetting->diagSamplingPercentage * 100;
         }
         ++diagSetting->currentMessageNumber;
 
-        number = diagSetting->currentMessageNumber;
-        percentage = diagSetting->diagSamplingPercentage;
-        result = (floor((number - 2) * percentage / 100.0) < floor((number - 1) * percentage / 100.0));
-    }
-    return result;
-}
-
-static IOTHUB_MESSAGE_DIAGNOSTIC_PROPERTY_DATA* prepare_message_diagnostic_data(void)
-{
-    IOTHUB_MESSAGE_DIAGNOSTIC_PROPERTY_DATA* result = (IOTHUB_MESSAGE_DIAGNOSTIC_PROPERTY_DATA*)malloc(sizeof(IOTHUB_MESSAGE_DIAGNOSTIC_PROPERTY_DATA));
-    if (result == NULL)
-    {
-        LogError("malloc for DiagnosticData failed");
-    }
-    else
-    {
-        char* diagId = (char*)malloc(9);
-        if (diagId == NULL)
-        {
-            LogError("malloc for diagId failed");
-            free(result);
-            result = NULL;
-        }
-        else
-        {
-            char* timeBuffer;
-
-            (void)generate_eight_random_characters(diagId);
-            result->diagnosticId = diagId;
-
-            timeBuffer = (char*)malloc(TIME_STRING_BUFFER_LEN);
-            if (timeBuffer == NULL)
-            {
-                LogError("malloc for timeBuffer failed");
-                free(result->diagnosticId);
-                free(result);
-                result = NULL;
-            }
-            else if (get_epoch_time(timeBuffer) == NULL)
-            {
-                LogError("Failed getting current time");
-                free(result->diagnosticId);
-                free(result);
-                free(timeBuffer);
-                result = NULL;
-            }
-            else
-            {
-                result->diagnosticCreationTimeUtc = timeBuffer;
-            }
-        }
+        // Message n is sampled when (n - 1) * percentage crosses a multiple of 100, which spreads the sampled
+        // messages evenly and is the same choice as floor((n - 2) * percentage / 100) < floor((n - 1) * percentage / 100)
+        result = (((uint64_t)(diagSetting->currentMessageNumber - 1) * diagSetting->diagSamplingPercentage) % 100) < diagSetting->diagSamplingPercentage;
     }
     return result;
 }
@@ -162,27 +94,24 @@ int IoTHubClient_Diagnostic_AddIfNecessary(IOTHUB_DIAGNOSTIC_SETTING_DATA* diagS
     }
     else if (should_add_diagnostic_info(diagSetting))
     {
+        // The message copies the fields into its own inline storage, so they are only needed for the call
+        char diagnosticId[DIAGNOSTIC_ID_LENGTH + 1];
+        char timeBuffer[TIME_STRING_BUFFER_LEN];
+        IOTHUB_MESSAGE_DIAGNOSTIC_PROPERTY_DATA diagnosticData;
 
-        IOTHUB_MESSAGE_DIAGNOSTIC_PROPERTY_DATA* diagnosticData;
-        if ((diagnosticData = prepare_message_diagnostic_data()) == NULL)
+        diagnosticData.diagnosticId = generate_eight_random_characters(diagnosticId);
+
+        if ((diagnosticData.diagnosticCreationTimeUtc = get_epoch_time(timeBuffer)) == NULL)
+        {
+            result = MU_FAILURE;
+        }
+        else if (IoTHubMessage_SetDiagnosticPropertyData(messageHandle, &diagnosticData) != IOTHUB_MESSAGE_OK)
         {
             result = MU_FAILURE;
         }
         else
         {
-            if (IoTHubMessage_SetDiagnosticPropertyData(messageHandle, diagnosticData) != IOTHUB_MESSAGE_OK)
-            {
-                result = MU_FAILURE;
-            }
-            else
-            {
-                result = 0;
-            }
-
-            free(diagnosticData->diagnosticCreationTimeUtc);
-            free(diagnosticData->diagnosticId);
-            free(diagnosticData);
-            diagnosticData = NULL;
+            result = 0;
         }
     }
     else
@@ -0,0 +1,637 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/condition.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/tickcounter.h"
+
+#include "iothub_client_group.h"
+
+#define INITIAL_HEAP_CAPACITY 16
+
+#define NOT_IN_HEAP ((size_t)-1)
+
+typedef struct GROUP_WORKER_TAG GROUP_WORKER;
+
+typedef struct IOTHUB_CLIENT_GROUP_MEMBER_TAG
+{
+    IOTHUB_DEVICE_CLIENT_LL_HANDLE client;
+    GROUP_WORKER* worker;
+    // Held around every call into the client: DoWork on the worker, and IoTHubClientGroup_Invoke
+    LOCK_HANDLE client_lock;
+    // Set once IoTHubDeviceClient_LL_GetPollInfo fails, e.g. for transports that cannot tell; only used by the worker
+    bool no_poll_info;
+    // The rest is guarded by the worker's lock.  A member is in its worker's heap unless the worker is running it.
+    tickcounter_ms_t due_ms;
+    size_t heap_index;
+    bool is_running;
+    bool is_removing;
+} IOTHUB_CLIENT_GROUP_MEMBER;
+
+struct GROUP_WORKER_TAG
+{
+    struct IOTHUB_CLIENT_GROUP_TAG* group;
+    THREAD_HANDLE thread;
+    TICK_COUNTER_HANDLE tick_counter;
+    LOCK_HANDLE lock;
+    // Posted when a member becomes due earlier than the worker planned to wake up, and when stopping
+    COND_HANDLE wake;
+    // Posted when the worker puts back the member it ran, for IoTHubClientGroup_RemoveDeviceClient
+    COND_HANDLE member_done;
+    bool stop;
+    // Min-heap of the members on due_ms
+    IOTHUB_CLIENT_GROUP_MEMBER** heap;
+    size_t heap_count;
+    size_t heap_capacity;
+    // Members assigned to the worker, including the one it is running; guarded by the group's lock
+    size_t member_count;
+};
+
+typedef struct IOTHUB_CLIENT_GROUP_TAG
+{
+    tickcounter_ms_t do_work_frequency_ms;
+    LOCK_HANDLE lock;
+    GROUP_WORKER* workers;
+    size_t worker_count;
+} IOTHUB_CLIENT_GROUP;
+
+static void heap_swap(GROUP_WORKER* worker, size_t first, size_t second)
+{
+    IOTHUB_CLIENT_GROUP_MEMBER* member = worker->heap[first];
+
+    worker->heap[first] = worker->heap[second];
+    worker->heap[second] = member;
+    worker->heap[first]->heap_index = first;
+    worker->heap[second]->heap_index = second;
+}
+
+static void heap_sift_up(GROUP_WORKER* worker, size_t index)
+{
+    while (index > 0 && worker->heap[(index - 1) / 2]->due_ms > worker->heap[index]->due_ms)
+    {
+        heap_swap(worker, index, (index - 1) / 2);
+        index = (index - 1) / 2;
+    }
+}
+
+static void heap_sift_down(GROUP_WORKER* worker, size_t index)
+{
+    while (true)
+    {
+        size_t smallest = index;
+        size_t left = (2 * index) + 1;
+        size_t right = left + 1;
+
+        if (left < worker->heap_count && worker->heap[left]->due_ms < worker->heap[smallest]->due_ms)
+        {
+            smallest = left;
+        }
+        if (right < worker->heap_count && worker->heap[right]->due_ms < worker->heap[smallest]->due_ms)
+        {
+            smallest = right;
+        }
+
+        if (smallest == index)
+        {
+            break;
+        }
+
+        heap_swap(worker, index, smallest);
+        index = smallest;
+    }
+}
+
+// The capacity is reserved when the member is added, so putting a member back never fails
+static int heap_reserve(GROUP_WORKER* worker, size_t count)
+{
+    int result;
+
+    if (count <= worker->heap_capacity)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t new_capacity = (worker->heap_capacity == 0) ? INITIAL_HEAP_CAPACITY : worker->heap_capacity * 2;
+        IOTHUB_CLIENT_GROUP_MEMBER** new_heap;
+
+        while (new_capacity < count)
+        {
+            new_capacity *= 2;
+        }
+
+        if ((new_heap = (IOTHUB_CLIENT_GROUP_MEMBER**)realloc(worker->heap, new_capacity * sizeof(IOTHUB_CLIENT_GROUP_MEMBER*))) == NULL)
+        {
+            LogError("Failed growing the schedule of the worker to %lu members", (unsigned long)new_capacity);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            worker->heap = new_heap;
+            worker->heap_capacity = new_capacity;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void heap_push(GROUP_WORKER* worker, IOTHUB_CLIENT_GROUP_MEMBER* member)
+{
+    member->heap_index = worker->heap_count;
+    worker->heap[worker->heap_count++] = member;
+    heap_sift_up(worker, member->heap_index);
+}
+
+static void heap_remove(GROUP_WORKER* worker, IOTHUB_CLIENT_GROUP_MEMBER* member)
+{
+    size_t index = member->heap_index;
+
+    worker->heap_count--;
+    if (index != worker->heap_count)
+    {
+        heap_swap(worker, index, worker->heap_count);
+        heap_sift_down(worker, index);
+        heap_sift_up(worker, index);
+    }
+    member->heap_index = NOT_IN_HEAP;
+}
+
+static tickcounter_ms_t get_current_ms(GROUP_WORKER* worker)
+{
+    tickcounter_ms_t result;
+
+    if (tickcounter_get_current_ms(worker->tick_counter, &result) != 0)
+    {
+        LogError("Failed reading the tick counter of the worker");
+        result = 0;
+    }
+
+    return result;
+}
+
+static int worker_thread(void* context)
+{
+    GROUP_WORKER* worker = (GROUP_WORKER*)context;
+
+    if (Lock(worker->lock) != LOCK_OK)
+    {
+        LogError("Failed locking the worker, worker thread exiting");
+    }
+    else
+    {
+        bool is_locked = true;
+
+        while (!worker->stop)
+        {
+            tickcounter_ms_t now_ms = get_current_ms(worker);
+
+            if (worker->heap_count == 0 || worker->heap[0]->due_ms > now_ms)
+            {
+                // Condition_Wait takes 0 as no timeout
+                int timeout_ms = (worker->heap_count == 0) ? 0 : (int)(worker->heap[0]->due_ms - now_ms);
+
+                if (Condition_Wait(worker->wake, worker->lock, timeout_ms) == COND_ERROR)
+                {
+                    LogError("Condition_Wait failed, worker thread exiting");
+                    break;
+                }
+            }
+            else
+            {
+                IOTHUB_CLIENT_GROUP_MEMBER* member = worker->heap[0];
+                tickcounter_ms_t next_do_work_ms = worker->group->do_work_frequency_ms;
+
+                heap_remove(worker, member);
+                member->is_running = true;
+                // Left non-zero unless IoTHubClientGroup_Invoke asks for another DoWork while this one runs
+                member->due_ms = now_ms + worker->group->do_work_frequency_ms;
+                (void)Unlock(worker->lock);
+
+                if (Lock(member->client_lock) != LOCK_OK)
+                {
+                    LogError("Failed locking the client, skipping its DoWork");
+                }
+                else
+                {
+                    IoTHubDeviceClient_LL_DoWork(member->client);
+
+                    // The client may have work sooner than the frequency, e.g. the next step of connecting
+                    if (!member->no_poll_info)
+                    {
+                        IOTHUB_CLIENT_POLL_INFO poll_info;
+
+                        if (IoTHubDeviceClient_LL_GetPollInfo(member->client, &poll_info) != IOTHUB_CLIENT_OK)
+                        {
+                            member->no_poll_info = true;
+                        }
+                        else if (poll_info.timeoutMs < next_do_work_ms)
+                        {
+                            next_do_work_ms = poll_info.timeoutMs;
+                        }
+                    }
+
+                    (void)Unlock(member->client_lock);
+                }
+
+                if (Lock(worker->lock) != LOCK_OK)
+                {
+                    LogError("Failed locking the worker, worker thread exiting");
+                    is_locked = false;
+                    break;
+                }
+
+                member->is_running = false;
+
+                if (member->is_removing)
+                {
+                    (void)Condition_Post(worker->member_done);
+                }
+                else
+                {
+                    // The frequency counts from the end of DoWork, which may have taken a while
+                    if (member->due_ms != 0)
+                    {
+                        member->due_ms = get_current_ms(worker) + next_do_work_ms;
+                    }
+                    heap_push(worker, member);
+                }
+            }
+        }
+
+        if (is_locked)
+        {
+            (void)Unlock(worker->lock);
+        }
+    }
+
+    return 0;
+}
+
+static void stop_worker(GROUP_WORKER* worker)
+{
+    int thread_result;
+
+    if (Lock(worker->lock) != LOCK_OK)
+    {
+        LogError("Failed locking the worker");
+    }
+    else
+    {
+        worker->stop = true;
+        (void)Condition_Post(worker->wake);
+        (void)Unlock(worker->lock);
+    }
+
+    if (ThreadAPI_Join(worker->thread, &thread_result) != THREADAPI_OK)
+    {
+        LogError("ThreadAPI_Join failed");
+    }
+}
+
+static void free_member(IOTHUB_CLIENT_GROUP_MEMBER* member)
+{
+    Lock_Deinit(member->client_lock);
+    free(member);
+}
+
+static void deinit_worker(GROUP_WORKER* worker)
+{
+    size_t i;
+
+    for (i = 0; i < worker->heap_count; i++)
+    {
+        free_member(worker->heap[i]);
+    }
+
+    free(worker->heap);
+    Condition_Deinit(worker->member_done);
+    Condition_Deinit(worker->wake);
+    Lock_Deinit(worker->lock);
+    tickcounter_destroy(worker->tick_counter);
+}
+
+static int init_worker(IOTHUB_CLIENT_GROUP* group, GROUP_WORKER* worker)
+{
+    int result;
+
+    (void)memset(worker, 0, sizeof(GROUP_WORKER));
+    worker->group = group;
+
+    if ((worker->tick_counter = tickcounter_create()) == NULL)
+    {
+        LogError("Failed creating the tick counter of the worker");
+        result = MU_FAILURE;
+    }
+    else if ((worker->lock = Lock_Init()) == NULL)
+    {
+        LogError("Failed creating the lock of the worker");
+        tickcounter_destroy(worker->tick_counter);
+        result = MU_FAILURE;
+    }
+    else if ((worker->wake = Condition_Init()) == NULL)
+    {
+        LogError("Failed creating the wake condition of the worker");
+        Lock_Deinit(worker->lock);
+        tickcounter_destroy(worker->tick_counter);
+        result = MU_FAILURE;
+    }
+    else if ((worker->member_done = Condition_Init()) == NULL)
+    {
+        LogError("Failed creating the member condition of the worker");
+        Condition_Deinit(worker->wake);
+        Lock_Deinit(worker->lock);
+        tickcounter_destroy(worker->tick_counter);
+        result = MU_FAILURE;
+    }
+    else if (ThreadAPI_Create(&worker->thread, worker_thread, worker) != THREADAPI_OK)
+    {
+        LogError("ThreadAPI_Create failed");
+        Condition_Deinit(worker->member_done);
+        Condition_Deinit(worker->wake);
+        Lock_Deinit(worker->lock);
+        tickcounter_destroy(worker->tick_counter);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static void destroy_group(IOTHUB_CLIENT_GROUP* group, size_t started_workers)
+{
+    size_t i;
+
+    for (i = 0; i < started_workers; i++)
+    {
+        stop_worker(&group->workers[i]);
+    }
+
+    // With the threads gone every remaining member is back in a heap
+    for (i = 0; i < started_workers; i++)
+    {
+        deinit_worker(&group->workers[i]);
+    }
+
+    free(group->workers);
+    Lock_Deinit(group->lock);
+    free(group);
+}
+
+IOTHUB_CLIENT_GROUP_HANDLE IoTHubClientGroup_Create(const IOTHUB_CLIENT_GROUP_CONFIG* config)
+{
+    IOTHUB_CLIENT_GROUP* result;
+
+    if (config == NULL || config->threadCount == 0 || config->doWorkFrequencyInMs == 0)
+    {
+        LogError("Invalid argument (config=%p, threadCount=%lu, doWorkFrequencyInMs=%u)", config,
+            (unsigned long)(config == NULL ? 0 : config->threadCount), config == NULL ? 0 : config->doWorkFrequencyInMs);
+        result = NULL;
+    }
+    else if ((result = (IOTHUB_CLIENT_GROUP*)malloc(sizeof(IOTHUB_CLIENT_GROUP))) == NULL)
+    {
+        LogError("Failed allocating the client group");
+    }
+    else
+    {
+        (void)memset(result, 0, sizeof(IOTHUB_CLIENT_GROUP));
+        result->do_work_frequency_ms = config->doWorkFrequencyInMs;
+
+        if ((result->lock = Lock_Init()) == NULL)
+        {
+            LogError("Failed creating the lock of the client group");
+            free(result);
+            result = NULL;
+        }
+        else if ((result->workers = (GROUP_WORKER*)malloc(config->threadCount * sizeof(GROUP_WORKER))) == NULL)
+        {
+            LogError("Failed allocating %lu workers", (unsigned long)config->threadCount);
+            Lock_Deinit(result->lock);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            size_t i;
+
+            for (i = 0; i < config->threadCount; i++)
+            {
+                if (init_worker(result, &result->workers[i]) != 0)
+                {
+                    LogError("Failed starting worker %lu of the client group", (unsigned long)i);
+                    break;
+                }
+            }
+
+            if (i < config->threadCount)
+            {
+                destroy_group(result, i);
+                result = NULL;
+            }
+            else
+            {
+                result->worker_count = config->threadCount;
+            }
+        }
+    }
+
+    return result;
+}
+
+void IoTHubClientGroup_Destroy(IOTHUB_CLIENT_GROUP_HANDLE groupHandle)
+{
+    if (groupHandle == NULL)
+    {
+        LogError("Invalid argument (groupHandle=NULL)");
+    }
+    else
+    {
+        destroy_group(groupHandle, groupHandle->worker_count);
+    }
+}
+
+IOTHUB_CLIENT_GROUP_MEMBER_HANDLE IoTHubClientGroup_AddDeviceClient(IOTHUB_CLIENT_GROUP_HANDLE groupHandle, IOTHUB_DEVICE_CLIENT_LL_HANDLE iotHubClientHandle)
+{
+    IOTHUB_CLIENT_GROUP_MEMBER* result;
+
+    if (groupHandle == NULL || iotHubClientHandle == NULL)
+    {
+        LogError("Invalid argument (groupHandle=%p, iotHubClientHandle=%p)", groupHandle, iotHubClientHandle);
+        result = NULL;
+    }
+    else if ((result = (IOTHUB_CLIENT_GROUP_MEMBER*)malloc(sizeof(IOTHUB_CLIENT_GROUP_MEMBER))) == NULL)
+    {
+        LogError("Failed allocating the group member");
+    }
+    else
+    {
+        (void)memset(result, 0, sizeof(IOTHUB_CLIENT_GROUP_MEMBER));
+        result->client = iotHubClientHandle;
+
+        if ((result->client_lock = Lock_Init()) == NULL)
+        {
+            LogError("Failed creating the lock of the group member");
+            free(result);
+            result = NULL;
+        }
+        else if (Lock(groupHandle->lock) != LOCK_OK)
+        {
+            LogError("Failed locking the client group");
+            free_member(result);
+            result = NULL;
+        }
+        else
+        {
+            GROUP_WORKER* worker = &groupHandle->workers[0];
+            size_t i;
+
+            for (i = 1; i < groupHandle->worker_count; i++)
+            {
+                if (groupHandle->workers[i].member_count < worker->member_count)
+                {
+                    worker = &groupHandle->workers[i];
+                }
+            }
+
+            if (Lock(worker->lock) != LOCK_OK)
+            {
+                LogError("Failed locking the worker");
+                free_member(result);
+                result = NULL;
+            }
+            else
+            {
+                if (heap_reserve(worker, worker->member_count + 1) != 0)
+                {
+                    free_member(result);
+                    result = NULL;
+                }
+                else
+                {
+                    // Due at once, so the client starts connecting
+                    result->worker = worker;
+                    result->due_ms = 0;
+                    heap_push(worker, result);
+                    worker->member_count++;
+                    (void)Condition_Post(worker->wake);
+                }
+
+                (void)Unlock(worker->lock);
+            }
+
+            (void)Unlock(groupHandle->lock);
+        }
+    }
+
+    return result;
+}
+
+void IoTHubClientGroup_RemoveDeviceClient(IOTHUB_CLIENT_GROUP_MEMBER_HANDLE memberHandle)
+{
+    if (memberHandle == NULL)
+    {
+        LogError("Invalid argument (memberHandle=NULL)");
+    }
+    else
+    {
+        GROUP_WORKER* worker = memberHandle->worker;
+
+        if (Lock(worker->lock) != LOCK_OK)
+        {
+            LogError("Failed locking the worker");
+        }
+        else
+        {
+            memberHandle->is_removing = true;
+
+            if (memberHandle->heap_index != NOT_IN_HEAP)
+            {
+                heap_remove(worker, memberHandle);
+            }
+
+            // The worker posts member_done instead of putting the member back when it is done running it
+            while (memberHandle->is_running)
+            {
+                if (Condition_Wait(worker->member_done, worker->lock, 0) == COND_ERROR)
+                {
+                    LogError("Condition_Wait failed");
+                    break;
+                }
+            }
+
+            (void)Unlock(worker->lock);
+
+            if (memberHandle->is_running)
+            {
+                LogError("Leaking the group member, its worker may still be running it");
+            }
+            else
+            {
+                if (Lock(worker->group->lock) != LOCK_OK)
+                {
+                    LogError("Failed locking the client group");
+                }
+                else
+                {
+                    worker->member_count--;
+                    (void)Unlock(worker->group->lock);
+                }
+
+                free_member(memberHandle);
+            }
+        }
+    }
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClientGroup_Invoke(IOTHUB_CLIENT_GROUP_MEMBER_HANDLE memberHandle, IOTHUB_CLIENT_GROUP_INVOKE_CALLBACK callback, void* context)
+{
+    IOTHUB_CLIENT_RESULT result;
+
+    if (memberHandle == NULL || callback == NULL)
+    {
+        LogError("Invalid argument (memberHandle=%p, callback=%p)", memberHandle, callback);
+        result = IOTHUB_CLIENT_INVALID_ARG;
+    }
+    else if (Lock(memberHandle->client_lock) != LOCK_OK)
+    {
+        LogError("Failed locking the client");
+        result = IOTHUB_CLIENT_ERROR;
+    }
+    else
+    {
+        GROUP_WORKER* worker = memberHandle->worker;
+
+        callback(memberHandle->client, context);
+        (void)Unlock(memberHandle->client_lock);
+
+        if (Lock(worker->lock) != LOCK_OK)
+        {
+            LogError("Failed locking the worker, the client runs at its next DoWork");
+        }
+        else
+        {
+            memberHandle->due_ms = 0;
+            if (memberHandle->heap_index != NOT_IN_HEAP)
+            {
+                heap_sift_up(worker, memberHandle->heap_index);
+            }
+            (void)Condition_Post(worker->wake);
+            (void)Unlock(worker->lock);
+        }
+
+        result = IOTHUB_CLIENT_OK;
+    }
+
+    return result;
+}
@@ -0,0 +1,213 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/tickcounter.h"
+
+#include "internal/iothub_client_metrics.h"
+
+// The counters are bumped from the thread running DoWork and read from any thread, so they are updated with relaxed
+// atomics where the compiler has them; nothing orders one counter against another.
+#if defined(_MSC_VER)
+#include <windows.h>
+typedef volatile SIZE_T METRICS_COUNTER_VALUE;
+#define METRICS_ATOMIC_ADD(counter, value)  (void)InterlockedExchangeAddSizeT(&(counter), (SIZE_T)(value))
+#define METRICS_ATOMIC_LOAD(counter)        ((size_t)InterlockedExchangeAddSizeT(&(counter), 0))
+#elif defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) && !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+typedef atomic_size_t METRICS_COUNTER_VALUE;
+#define METRICS_ATOMIC_ADD(counter, value)  (void)atomic_fetch_add_explicit(&(counter), (value), memory_order_relaxed)
+#define METRICS_ATOMIC_LOAD(counter)        atomic_load_explicit(&(counter), memory_order_relaxed)
+#elif defined(__GNUC__)
+typedef size_t METRICS_COUNTER_VALUE;
+#define METRICS_ATOMIC_ADD(counter, value)  (void)__atomic_fetch_add(&(counter), (value), __ATOMIC_RELAXED)
+#define METRICS_ATOMIC_LOAD(counter)        __atomic_load_n(&(counter), __ATOMIC_RELAXED)
+#else
+typedef volatile size_t METRICS_COUNTER_VALUE;
+#define METRICS_ATOMIC_ADD(counter, value)  ((counter) += (value))
+#define METRICS_ATOMIC_LOAD(counter)        (counter)
+#endif
+
+#define METRICS_COUNTER_COUNT   (METRICS_DISCONNECTS + 1)
+
+static const tickcounter_ms_t LATENCY_BUCKET_BOUNDS_MS[IOTHUB_CLIENT_METRICS_LATENCY_BUCKET_COUNT - 1] = {
+    5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000
+};
+
+typedef struct METRICS_TAG
+{
+    TICK_COUNTER_HANDLE tick_counter;
+    METRICS_COUNTER_VALUE counters[METRICS_COUNTER_COUNT];
+    METRICS_COUNTER_VALUE latency_count;
+    METRICS_COUNTER_VALUE latency_total_ms;
+    METRICS_COUNTER_VALUE latency_buckets[IOTHUB_CLIENT_METRICS_LATENCY_BUCKET_COUNT];
+} METRICS;
+
+static size_t get_latency_bucket(tickcounter_ms_t latency_ms)
+{
+    size_t result = 0;
+
+    while (result < IOTHUB_CLIENT_METRICS_LATENCY_BUCKET_COUNT - 1 && latency_ms > LATENCY_BUCKET_BOUNDS_MS[result])
+    {
+        result++;
+    }
+
+    return result;
+}
+
+METRICS_HANDLE metrics_create(void)
+{
+    METRICS* result;
+
+    if ((result = (METRICS*)malloc(sizeof(METRICS))) == NULL)
+    {
+        LogError("Failed allocating the metrics");
+    }
+    else
+    {
+        (void)memset(result, 0, sizeof(METRICS));
+
+        if ((result->tick_counter = tickcounter_create()) == NULL)
+        {
+            LogError("Failed creating the tick counter of the metrics");
+            free(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+void metrics_destroy(METRICS_HANDLE handle)
+{
+    if (handle != NULL)
+    {
+        tickcounter_destroy(handle->tick_counter);
+        free(handle);
+    }
+}
+
+void metrics_add(METRICS_HANDLE handle, METRICS_COUNTER counter, size_t value)
+{
+    if (handle == NULL || (int)counter < 0 || counter >= METRICS_COUNTER_COUNT)
+    {
+        LogError("Invalid argument (handle=%p, counter=%d)", handle, (int)counter);
+    }
+    else
+    {
+        METRICS_ATOMIC_ADD(handle->counters[counter], value);
+    }
+}
+
+tickcounter_ms_t metrics_get_current_ms(METRICS_HANDLE handle)
+{
+    tickcounter_ms_t result;
+
+    if (handle == NULL)
+    {
+        LogError("Invalid argument (handle=NULL)");
+        result = 0;
+    }
+    else if (tickcounter_get_current_ms(handle->tick_counter, &result) != 0)
+    {
+        LogError("Failed reading the tick counter of the metrics");
+        result = 0;
+    }
+    else
+    {
+        // 0 marks messages enqueued without metrics, so the first millisecond is reported as the second
+        result++;
+    }
+
+    return result;
+}
+
+void metrics_record_send_complete(METRICS_HANDLE handle, IOTHUB_CLIENT_CONFIRMATION_RESULT result, tickcounter_ms_t enqueued_ms)
+{
+    if (handle == NULL)
+    {
+        LogError("Invalid argument (handle=NULL)");
+    }
+    else
+    {
+        METRICS_COUNTER counter;
+
+        switch (result)
+        {
+            case IOTHUB_CLIENT_CONFIRMATION_OK:
+                counter = METRICS_MESSAGES_ACKNOWLEDGED;
+                break;
+            case IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT:
+                counter = METRICS_MESSAGES_TIMED_OUT;
+                break;
+            case IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY:
+                counter = METRICS_MESSAGES_DROPPED;
+                break;
+            default:
+                counter = METRICS_MESSAGES_FAILED;
+                break;
+        }
+
+        METRICS_ATOMIC_ADD(handle->counters[counter], 1);
+
+        // Only acknowledgements say how long the hub took; the other outcomes would skew the histogram
+        if (result == IOTHUB_CLIENT_CONFIRMATION_OK && enqueued_ms != 0)
+        {
+            tickcounter_ms_t now_ms = metrics_get_current_ms(handle);
+
+            if (now_ms >= enqueued_ms)
+            {
+                tickcounter_ms_t latency_ms = now_ms - enqueued_ms;
+
+                METRICS_ATOMIC_ADD(handle->latency_buckets[get_latency_bucket(latency_ms)], 1);
+                METRICS_ATOMIC_ADD(handle->latency_total_ms, (size_t)latency_ms);
+                METRICS_ATOMIC_ADD(handle->latency_count, 1);
+            }
+        }
+    }
+}
+
+int metrics_get_snapshot(METRICS_HANDLE handle, IOTHUB_CLIENT_METRICS* metrics)
+{
+    int result;
+
+    if (handle == NULL || metrics == NULL)
+    {
+        LogError("Invalid argument (handle=%p, metrics=%p)", handle, metrics);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        size_t i;
+
+        (void)memset(metrics, 0, sizeof(IOTHUB_CLIENT_METRICS));
+        metrics->messagesEnqueued = METRICS_ATOMIC_LOAD(handle->counters[METRICS_MESSAGES_ENQUEUED]);
+        metrics->messagesSent = METRICS_ATOMIC_LOAD(handle->counters[METRICS_MESSAGES_SENT]);
+        metrics->messagesAcknowledged = METRICS_ATOMIC_LOAD(handle->counters[METRICS_MESSAGES_ACKNOWLEDGED]);
+        metrics->messagesFailed = METRICS_ATOMIC_LOAD(handle->counters[METRICS_MESSAGES_FAILED]);
+        metrics->messagesTimedOut = METRICS_ATOMIC_LOAD(handle->counters[METRICS_MESSAGES_TIMED_OUT]);
+        metrics->messagesDropped = METRICS_ATOMIC_LOAD(handle->counters[METRICS_MESSAGES_DROPPED]);
+        metrics->messagesReceived = METRICS_ATOMIC_LOAD(handle->counters[METRICS_MESSAGES_RECEIVED]);
+        metrics->bytesSent = METRICS_ATOMIC_LOAD(handle->counters[METRICS_BYTES_SENT]);
+        metrics->bytesReceived = METRICS_ATOMIC_LOAD(handle->counters[METRICS_BYTES_RECEIVED]);
+        metrics->sendRetries = METRICS_ATOMIC_LOAD(handle->counters[METRICS_SEND_RETRIES]);
+        metrics->reconnectAttempts = METRICS_ATOMIC_LOAD(handle->counters[METRICS_RECONNECT_ATTEMPTS]);
+        metrics->disconnects = METRICS_ATOMIC_LOAD(handle->counters[METRICS_DISCONNECTS]);
+        metrics->ackLatencyCount = METRICS_ATOMIC_LOAD(handle->latency_count);
+        metrics->ackLatencyTotalMs = METRICS_ATOMIC_LOAD(handle->latency_total_ms);
+
+        for (i = 0; i < IOTHUB_CLIENT_METRICS_LATENCY_BUCKET_COUNT; i++)
+        {
+            metrics->ackLatencyBuckets[i] = METRICS_ATOMIC_LOAD(handle->latency_buckets[i]);
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
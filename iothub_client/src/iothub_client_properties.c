@@ -21,6 +21,35 @@ typedef enum PROPERTY_PARSE_STATE_TAG
     PROPERTY_PARSE_STATE_REPORTED
 } PROPERTY_PARSE_STATE;
 
+// A run of bytes inside the application's payload.  Used by the streaming deserializer, which never copies the payload.
+typedef struct PROPERTIES_JSON_SPAN_TAG
+{
+    const char* start;
+    size_t length;
+} PROPERTIES_JSON_SPAN;
+
+// State of a deserializer created with IoTHubClient_Properties_Deserializer_CreateStreaming.  The cursors are offsets
+// into the application's payload.  The buffers are reused across calls to IoTHubClient_Properties_Deserializer_GetNext
+// and only ever grow to the size of the largest name or value seen, never to the size of the payload.
+typedef struct PROPERTIES_STREAM_READER_TAG
+{
+    const char* payload;
+    size_t payloadLength;
+    bool hasDesired;
+    size_t desiredOffset;
+    bool hasReported;
+    size_t reportedOffset;
+    bool isCompleted;
+    size_t sectionCursor;
+    size_t componentCursor;
+    char* componentName;
+    size_t componentNameSize;
+    char* propertyName;
+    size_t propertyNameSize;
+    char* value;
+    size_t valueSize;
+} PROPERTIES_STREAM_READER;
+
 typedef struct IOTHUB_CLIENT_PROPERTIES_DESERIALIZER_TAG {
     JSON_Value* rootValue;
     JSON_Object* desiredObject;
@@ -30,6 +59,8 @@ typedef struct IOTHUB_CLIENT_PROPERTIES_DESERIALIZER_TAG {
     size_t currentComponentIndex;
     size_t currentPropertyIndex;
     int propertiesVersion;
+    bool isStreaming;
+    PROPERTIES_STREAM_READER streamReader;
 } IOTHUB_CLIENT_PROPERTIES_DESERIALIZER;
 
 // sprintf format strings and string constants for writing properties.
@@ -674,6 +705,614 @@ static bool GetNextPropertyToEnumerate(IOTHUB_CLIENT_PROPERTIES_DESERIALIZER* pr
 }
 
 
+//
+// Streaming deserialization.  IoTHubClient_Properties_Deserializer_CreateStreaming does not copy the payload or build a
+// parson DOM of it.  Instead the helpers below walk the application's buffer in place with a small pull parser, and only
+// the value of the property being returned is handed to parson.  Memory use is therefore bounded by the largest single
+// property rather than by the size of the twin.
+//
+
+#define STREAM_MINIMUM_BUFFER_SIZE 64
+
+// StreamSkipWhitespace returns the offset of the first non-whitespace character at or after position.
+static size_t StreamSkipWhitespace(const PROPERTIES_STREAM_READER* streamReader, size_t position)
+{
+    while ((position < streamReader->payloadLength) &&
+           ((streamReader->payload[position] == ' ') || (streamReader->payload[position] == '\t') ||
+            (streamReader->payload[position] == '\r') || (streamReader->payload[position] == '\n')))
+    {
+        position++;
+    }
+
+    return position;
+}
+
+// StreamSkipString advances *position, which must be on an opening quote, past the matching closing quote.
+static bool StreamSkipString(const PROPERTIES_STREAM_READER* streamReader, size_t* position)
+{
+    bool result = false;
+    size_t current = *position + 1;
+
+    while (current < streamReader->payloadLength)
+    {
+        unsigned char c = (unsigned char)streamReader->payload[current];
+
+        if (c == '"')
+        {
+            *position = current + 1;
+            result = true;
+            break;
+        }
+        else if (c < 0x20)
+        {
+            // Control characters must be escaped inside JSON strings.
+            break;
+        }
+        else if (c == '\\')
+        {
+            // The escape sequence itself is validated when the string is decoded by parson.
+            current += 2;
+        }
+        else
+        {
+            current++;
+        }
+    }
+
+    return result;
+}
+
+// StreamIsLiteralCharacter returns true for characters that may appear in JSON numbers and in true, false and null.
+static bool StreamIsLiteralCharacter(char c)
+{
+    return (((c >= '0') && (c <= '9')) || ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) ||
+            (c == '-') || (c == '+') || (c == '.'));
+}
+
+// StreamSkipValue advances *position past the JSON value that starts there.  Nested objects and arrays are skipped by
+// tracking their depth, so no recursion or allocation is needed regardless of how deep the twin is.
+static bool StreamSkipValue(const PROPERTIES_STREAM_READER* streamReader, size_t* position)
+{
+    bool result = false;
+    size_t current = *position;
+
+    if (current >= streamReader->payloadLength)
+    {
+        LogError("Unexpected end of JSON");
+    }
+    else if (streamReader->payload[current] == '"')
+    {
+        result = StreamSkipString(streamReader, position);
+    }
+    else if ((streamReader->payload[current] == '{') || (streamReader->payload[current] == '['))
+    {
+        size_t depth = 0;
+
+        while (current < streamReader->payloadLength)
+        {
+            char c = streamReader->payload[current];
+
+            if (c == '"')
+            {
+                if (!StreamSkipString(streamReader, &current))
+                {
+                    break;
+                }
+                continue;
+            }
+            else if ((c == '{') || (c == '['))
+            {
+                depth++;
+            }
+            else if ((c == '}') || (c == ']'))
+            {
+                if (--depth == 0)
+                {
+                    *position = current + 1;
+                    result = true;
+                    break;
+                }
+            }
+            current++;
+        }
+    }
+    else
+    {
+        while ((current < streamReader->payloadLength) && StreamIsLiteralCharacter(streamReader->payload[current]))
+        {
+            current++;
+        }
+
+        if (current != *position)
+        {
+            *position = current;
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+// StreamReadMember reads the next "name":value member of the object whose members are being iterated at *cursor.  The
+// cursor starts right after the object's opening brace.  When there are no members left, memberFound is set to false
+// and the cursor stays on the closing brace so that subsequent reads keep reporting the end of the object.
+static bool StreamReadMember(const PROPERTIES_STREAM_READER* streamReader, size_t* cursor, PROPERTIES_JSON_SPAN* name, PROPERTIES_JSON_SPAN* value, bool* memberFound)
+{
+    bool result = false;
+    bool isFirstMember = (streamReader->payload[*cursor - 1] == '{');
+    size_t position = StreamSkipWhitespace(streamReader, *cursor);
+
+    *memberFound = false;
+
+    if ((position < streamReader->payloadLength) && (streamReader->payload[position] == '}'))
+    {
+        *cursor = position;
+        result = true;
+    }
+    else
+    {
+        if (!isFirstMember && (position < streamReader->payloadLength) && (streamReader->payload[position] == ','))
+        {
+            position = StreamSkipWhitespace(streamReader, position + 1);
+        }
+        else if (!isFirstMember)
+        {
+            position = streamReader->payloadLength;
+        }
+
+        if ((position >= streamReader->payloadLength) || (streamReader->payload[position] != '"'))
+        {
+            LogError("Expected a JSON member name at offset %lu", (unsigned long)position);
+        }
+        else
+        {
+            size_t nameStart = position + 1;
+
+            if (!StreamSkipString(streamReader, &position))
+            {
+                LogError("Unterminated JSON member name at offset %lu", (unsigned long)nameStart);
+            }
+            else
+            {
+                name->start = streamReader->payload + nameStart;
+                name->length = position - 1 - nameStart;
+                position = StreamSkipWhitespace(streamReader, position);
+
+                if ((position >= streamReader->payloadLength) || (streamReader->payload[position] != ':'))
+                {
+                    LogError("Expected ':' at offset %lu", (unsigned long)position);
+                }
+                else
+                {
+                    size_t valueStart = StreamSkipWhitespace(streamReader, position + 1);
+                    position = valueStart;
+
+                    if (!StreamSkipValue(streamReader, &position))
+                    {
+                        LogError("Unable to parse JSON value at offset %lu", (unsigned long)valueStart);
+                    }
+                    else
+                    {
+                        value->start = streamReader->payload + valueStart;
+                        value->length = position - valueStart;
+                        *cursor = position;
+                        *memberFound = true;
+                        result = true;
+                    }
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+// StreamSpanEquals compares the raw bytes of a span with a name that never needs JSON escaping.
+static bool StreamSpanEquals(const PROPERTIES_JSON_SPAN* span, const char* literal)
+{
+    size_t literalLength = strlen(literal);
+    return ((span->length == literalLength) && (memcmp(span->start, literal, literalLength) == 0));
+}
+
+// StreamFindMember looks up a member of the object starting at objectOffset without decoding anything else.
+static IOTHUB_CLIENT_RESULT StreamFindMember(const PROPERTIES_STREAM_READER* streamReader, size_t objectOffset, const char* memberName, PROPERTIES_JSON_SPAN* value, bool* memberFound)
+{
+    IOTHUB_CLIENT_RESULT result = IOTHUB_CLIENT_OK;
+    size_t cursor = objectOffset + 1;
+    PROPERTIES_JSON_SPAN name;
+
+    *memberFound = false;
+
+    while (true)
+    {
+        bool nextMemberFound;
+
+        if (!StreamReadMember(streamReader, &cursor, &name, value, &nextMemberFound))
+        {
+            result = IOTHUB_CLIENT_ERROR;
+            break;
+        }
+        else if (!nextMemberFound)
+        {
+            break;
+        }
+        else if (StreamSpanEquals(&name, memberName))
+        {
+            *memberFound = true;
+            break;
+        }
+    }
+
+    return result;
+}
+
+// StreamIsComponent is the streaming equivalent of IsJsonObjectAComponent.  It looks for "__t":"c" among the
+// top-level members of the value.
+static bool StreamIsComponent(const PROPERTIES_STREAM_READER* streamReader, const PROPERTIES_JSON_SPAN* value)
+{
+    bool result = false;
+
+    if (value->start[0] == '{')
+    {
+        PROPERTIES_JSON_SPAN markerValue;
+        bool markerFound;
+
+        if ((StreamFindMember(streamReader, (size_t)(value->start - streamReader->payload), TWIN_COMPONENT_MARKER_NAME, &markerValue, &markerFound) == IOTHUB_CLIENT_OK) &&
+            markerFound &&
+            (markerValue.length == sizeof(TWIN_COMPONENT_MARKER_VALUE) + 1) &&
+            (markerValue.start[0] == '"') &&
+            (memcmp(markerValue.start + 1, TWIN_COMPONENT_MARKER_VALUE, sizeof(TWIN_COMPONENT_MARKER_VALUE) - 1) == 0))
+        {
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+// StreamEnsureBufferSize grows a scratch buffer owned by the stream reader.  Its previous contents are not preserved.
+static int StreamEnsureBufferSize(char** buffer, size_t* bufferSize, size_t requiredSize)
+{
+    int result;
+
+    if (*bufferSize >= requiredSize)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t sizeToAllocate = (requiredSize < STREAM_MINIMUM_BUFFER_SIZE) ? STREAM_MINIMUM_BUFFER_SIZE : requiredSize;
+
+        free(*buffer);
+        *bufferSize = 0;
+
+        if ((*buffer = (char*)malloc(sizeToAllocate)) == NULL)
+        {
+            LogError("Unable to allocate %lu size buffer", (unsigned long)sizeToAllocate);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            *bufferSize = sizeToAllocate;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+// StreamParseValue hands a single JSON value from the payload to parson.  The value is copied into the reader's scratch
+// buffer since parson requires a null-terminated string.
+static JSON_Value* StreamParseValue(PROPERTIES_STREAM_READER* streamReader, const char* start, size_t length)
+{
+    JSON_Value* result;
+
+    if ((length + 1) == 0)
+    {
+        LogError("Value size exceeds maximum allocation");
+        result = NULL;
+    }
+    else if (StreamEnsureBufferSize(&streamReader->value, &streamReader->valueSize, length + 1) != 0)
+    {
+        result = NULL;
+    }
+    else
+    {
+        memcpy(streamReader->value, start, length);
+        streamReader->value[length] = '\0';
+
+        if ((result = json_parse_string(streamReader->value)) == NULL)
+        {
+            LogError("Unable to parse property value JSON");
+        }
+    }
+
+    return result;
+}
+
+// StreamDecodeName copies a member name into a null-terminated buffer owned by the stream reader.  Names almost never
+// contain escape sequences; those that do are decoded by parson so the result matches the DOM based deserializer.
+static int StreamDecodeName(PROPERTIES_STREAM_READER* streamReader, const PROPERTIES_JSON_SPAN* name, char** buffer, size_t* bufferSize)
+{
+    int result;
+
+    if (memchr(name->start, '\\', name->length) == NULL)
+    {
+        if (StreamEnsureBufferSize(buffer, bufferSize, name->length + 1) != 0)
+        {
+            result = MU_FAILURE;
+        }
+        else
+        {
+            memcpy(*buffer, name->start, name->length);
+            (*buffer)[name->length] = '\0';
+            result = 0;
+        }
+    }
+    else
+    {
+        // Include the surrounding quotes so parson sees a JSON string.
+        JSON_Value* nameValue = StreamParseValue(streamReader, name->start - 1, name->length + 2);
+        const char* decodedName = json_value_get_string(nameValue);
+
+        if (decodedName == NULL)
+        {
+            LogError("Unable to decode JSON member name");
+            result = MU_FAILURE;
+        }
+        else if (StreamEnsureBufferSize(buffer, bufferSize, strlen(decodedName) + 1) != 0)
+        {
+            result = MU_FAILURE;
+        }
+        else
+        {
+            memcpy(*buffer, decodedName, strlen(decodedName) + 1);
+            result = 0;
+        }
+
+        json_value_free(nameValue);
+    }
+
+    return result;
+}
+
+// StreamLocateSections validates the overall structure of the payload and records where the desired and reported
+// objects start.  This is the only pass over the complete payload.
+static IOTHUB_CLIENT_RESULT StreamLocateSections(IOTHUB_CLIENT_PROPERTY_PAYLOAD_TYPE payloadType, PROPERTIES_STREAM_READER* streamReader)
+{
+    IOTHUB_CLIENT_RESULT result;
+    size_t rootOffset = StreamSkipWhitespace(streamReader, 0);
+    size_t rootEnd = rootOffset;
+
+    if ((rootOffset >= streamReader->payloadLength) || (streamReader->payload[rootOffset] != '{'))
+    {
+        LogError("Root of properties JSON is not an object");
+        result = IOTHUB_CLIENT_ERROR;
+    }
+    else if (!StreamSkipValue(streamReader, &rootEnd))
+    {
+        LogError("Unable to parse properties JSON");
+        result = IOTHUB_CLIENT_ERROR;
+    }
+    else if (payloadType == IOTHUB_CLIENT_PROPERTY_PAYLOAD_WRITABLE_UPDATES)
+    {
+        // As in GetDesiredAndReportedTwinJson, the root of a PATCH is implicitly the desired section.
+        streamReader->hasDesired = true;
+        streamReader->desiredOffset = rootOffset;
+        result = IOTHUB_CLIENT_OK;
+    }
+    else
+    {
+        size_t cursor = rootOffset + 1;
+        PROPERTIES_JSON_SPAN name;
+        PROPERTIES_JSON_SPAN value;
+        bool memberFound;
+
+        result = IOTHUB_CLIENT_OK;
+
+        while (true)
+        {
+            if (!StreamReadMember(streamReader, &cursor, &name, &value, &memberFound))
+            {
+                result = IOTHUB_CLIENT_ERROR;
+                break;
+            }
+            else if (!memberFound)
+            {
+                break;
+            }
+            else if (value.start[0] != '{')
+            {
+                // Like json_object_get_object, sections that are not objects are treated as missing.
+                ;
+            }
+            else if (StreamSpanEquals(&name, TWIN_DESIRED_OBJECT_NAME))
+            {
+                streamReader->hasDesired = true;
+                streamReader->desiredOffset = (size_t)(value.start - streamReader->payload);
+            }
+            else if (StreamSpanEquals(&name, TWIN_REPORTED_OBJECT_NAME))
+            {
+                streamReader->hasReported = true;
+                streamReader->reportedOffset = (size_t)(value.start - streamReader->payload);
+            }
+        }
+    }
+
+    return result;
+}
+
+// StreamGetTwinVersion is the streaming equivalent of GetTwinVersion.
+static IOTHUB_CLIENT_RESULT StreamGetTwinVersion(IOTHUB_CLIENT_PROPERTIES_DESERIALIZER* propertiesDeserializer)
+{
+    IOTHUB_CLIENT_RESULT result;
+    PROPERTIES_STREAM_READER* streamReader = &propertiesDeserializer->streamReader;
+    PROPERTIES_JSON_SPAN versionSpan;
+    bool versionFound = false;
+    JSON_Value* versionValue;
+
+    if (!streamReader->hasDesired ||
+        (StreamFindMember(streamReader, streamReader->desiredOffset, TWIN_VERSION, &versionSpan, &versionFound) != IOTHUB_CLIENT_OK) ||
+        !versionFound)
+    {
+        LogError("Cannot retrieve %s field for twin", TWIN_VERSION);
+        result = IOTHUB_CLIENT_ERROR;
+    }
+    else if ((versionValue = StreamParseValue(streamReader, versionSpan.start, versionSpan.length)) == NULL)
+    {
+        LogError("Cannot parse %s field for twin", TWIN_VERSION);
+        result = IOTHUB_CLIENT_ERROR;
+    }
+    else
+    {
+        if (json_value_get_type(versionValue) != JSONNumber)
+        {
+            LogError("JSON field %s is not a number", TWIN_VERSION);
+            result = IOTHUB_CLIENT_ERROR;
+        }
+        else
+        {
+            propertiesDeserializer->propertiesVersion = (int)json_value_get_number(versionValue);
+            result = IOTHUB_CLIENT_OK;
+        }
+        json_value_free(versionValue);
+    }
+
+    return result;
+}
+
+// StreamFillProperty is the streaming equivalent of FillProperty.  The names returned point into the stream reader's
+// buffers and the value is re-serialized by parson, so the application sees exactly what the DOM based deserializer returns.
+static IOTHUB_CLIENT_RESULT StreamFillProperty(IOTHUB_CLIENT_PROPERTIES_DESERIALIZER* propertiesDeserializer, const PROPERTIES_JSON_SPAN* propertyName, const PROPERTIES_JSON_SPAN* propertyValue, IOTHUB_CLIENT_PROPERTY_PARSED* property)
+{
+    IOTHUB_CLIENT_RESULT result;
+    PROPERTIES_STREAM_READER* streamReader = &propertiesDeserializer->streamReader;
+    JSON_Value* value = NULL;
+    char* propertyStringJson;
+
+    if (StreamDecodeName(streamReader, propertyName, &streamReader->propertyName, &streamReader->propertyNameSize) != 0)
+    {
+        LogError("Unable to decode property name");
+        result = IOTHUB_CLIENT_ERROR;
+    }
+    else if ((value = StreamParseValue(streamReader, propertyValue->start, propertyValue->length)) == NULL)
+    {
+        LogError("Unable to parse property value");
+        result = IOTHUB_CLIENT_ERROR;
+    }
+    else if ((propertyStringJson = json_serialize_to_string(value)) == NULL)
+    {
+        LogError("Unable to retrieve JSON string for property value");
+        result = IOTHUB_CLIENT_ERROR;
+    }
+    else
+    {
+        property->propertyType = (propertiesDeserializer->propertyParseState == PROPERTY_PARSE_STATE_DESIRED) ?
+                                 IOTHUB_CLIENT_PROPERTY_TYPE_WRITABLE : IOTHUB_CLIENT_PROPERTY_TYPE_REPORTED_FROM_CLIENT;
+        property->componentName = (propertiesDeserializer->componentParseState == COMPONENT_PARSE_STATE_SUB_COMPONENT) ? streamReader->componentName : NULL;
+        property->name = streamReader->propertyName;
+        property->valueType = IOTHUB_CLIENT_PROPERTY_VALUE_STRING;
+        property->value.str = propertyStringJson;
+        property->valueLength = strlen(propertyStringJson);
+        result = IOTHUB_CLIENT_OK;
+    }
+
+    if (value != NULL)
+    {
+        json_value_free(value);
+    }
+
+    return result;
+}
+
+// StreamGetNextProperty is the streaming equivalent of GetNextPropertyToEnumerate.  It advances the section and component
+// cursors until it finds a property to return to the application, skipping the same metadata the DOM traversal skips.
+static IOTHUB_CLIENT_RESULT StreamGetNextProperty(IOTHUB_CLIENT_PROPERTIES_DESERIALIZER* propertiesDeserializer, IOTHUB_CLIENT_PROPERTY_PARSED* property, bool* propertySpecified)
+{
+    IOTHUB_CLIENT_RESULT result = IOTHUB_CLIENT_OK;
+    PROPERTIES_STREAM_READER* streamReader = &propertiesDeserializer->streamReader;
+    PROPERTIES_JSON_SPAN name;
+    PROPERTIES_JSON_SPAN value;
+    bool propertyFound = false;
+
+    while ((result == IOTHUB_CLIENT_OK) && !propertyFound && !streamReader->isCompleted)
+    {
+        bool memberFound;
+
+        if (propertiesDeserializer->componentParseState == COMPONENT_PARSE_STATE_SUB_COMPONENT)
+        {
+            if (!StreamReadMember(streamReader, &streamReader->componentCursor, &name, &value, &memberFound))
+            {
+                LogError("Unable to read component properties");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else if (!memberFound)
+            {
+                // We've parsed all the properties of this component.  Move onto the next top-level JSON element
+                propertiesDeserializer->componentParseState = COMPONENT_PARSE_STATE_ROOT;
+            }
+            else if (!StreamSpanEquals(&name, TWIN_COMPONENT_MARKER_NAME))
+            {
+                propertyFound = true;
+            }
+        }
+        else if (!StreamReadMember(streamReader, &streamReader->sectionCursor, &name, &value, &memberFound))
+        {
+            LogError("Unable to read properties");
+            result = IOTHUB_CLIENT_ERROR;
+        }
+        else if (!memberFound)
+        {
+            // If we can't find another desired property, then transition to start searching through reported.
+            if ((propertiesDeserializer->propertyParseState == PROPERTY_PARSE_STATE_DESIRED) && streamReader->hasReported)
+            {
+                propertiesDeserializer->propertyParseState = PROPERTY_PARSE_STATE_REPORTED;
+                streamReader->sectionCursor = streamReader->reportedOffset + 1;
+            }
+            else
+            {
+                streamReader->isCompleted = true;
+            }
+        }
+        else if (StreamIsComponent(streamReader, &value))
+        {
+            if (StreamDecodeName(streamReader, &name, &streamReader->componentName, &streamReader->componentNameSize) != 0)
+            {
+                LogError("Unable to decode component name");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                propertiesDeserializer->componentParseState = COMPONENT_PARSE_STATE_SUB_COMPONENT;
+                streamReader->componentCursor = (size_t)(value.start - streamReader->payload) + 1;
+            }
+        }
+        else if (!StreamSpanEquals(&name, TWIN_VERSION))
+        {
+            propertyFound = true;
+        }
+    }
+
+    if (result != IOTHUB_CLIENT_OK)
+    {
+        ;
+    }
+    else if (!propertyFound)
+    {
+        *propertySpecified = false;
+    }
+    else if ((result = StreamFillProperty(propertiesDeserializer, &name, &value, property)) != IOTHUB_CLIENT_OK)
+    {
+        LogError("Cannot Fill Properties");
+    }
+    else
+    {
+        *propertySpecified = true;
+    }
+
+    return result;
+}
+
 IOTHUB_CLIENT_RESULT IoTHubClient_Properties_Deserializer_Create(
     IOTHUB_CLIENT_PROPERTY_PAYLOAD_TYPE payloadType,
     const unsigned char* payload,
@@ -737,6 +1376,59 @@ IOTHUB_CLIENT_RESULT IoTHubClient_Properties_Deserializer_Create(
     return result;
 }
 
+IOTHUB_CLIENT_RESULT IoTHubClient_Properties_Deserializer_CreateStreaming(
+    IOTHUB_CLIENT_PROPERTY_PAYLOAD_TYPE payloadType,
+    const unsigned char* payload,
+    size_t payloadLength,
+    IOTHUB_CLIENT_PROPERTIES_DESERIALIZER_HANDLE* propertiesDeserializerHandle)
+{
+    IOTHUB_CLIENT_RESULT result;
+
+    IOTHUB_CLIENT_PROPERTIES_DESERIALIZER* propertiesDeserializer = NULL;
+
+    if ((result = ValidateDeserializerInputs(payloadType, payload, payloadLength, propertiesDeserializerHandle)) != IOTHUB_CLIENT_OK)
+    {
+        LogError("Invalid argument");
+    }
+    else if ((propertiesDeserializer = (IOTHUB_CLIENT_PROPERTIES_DESERIALIZER*)calloc(1, sizeof(IOTHUB_CLIENT_PROPERTIES_DESERIALIZER))) == NULL)
+    {
+        LogError("Cannot allocate IOTHUB_CLIENT_PROPERTIES_DESERIALIZER");
+        result = IOTHUB_CLIENT_ERROR;
+    }
+    else
+    {
+        // The payload is referenced, not copied.  The application keeps it alive until IoTHubClient_Properties_Deserializer_Destroy.
+        propertiesDeserializer->isStreaming = true;
+        propertiesDeserializer->streamReader.payload = (const char*)payload;
+        propertiesDeserializer->streamReader.payloadLength = payloadLength;
+
+        if ((result = StreamLocateSections(payloadType, &propertiesDeserializer->streamReader)) != IOTHUB_CLIENT_OK)
+        {
+            LogError("Cannot locate desired and/or reported object in JSON");
+        }
+        // As in IoTHubClient_Properties_Deserializer_Create, a twin without version info is rejected up front.
+        else if ((result = StreamGetTwinVersion(propertiesDeserializer)) != IOTHUB_CLIENT_OK)
+        {
+            LogError("Cannot retrieve properties version");
+        }
+        else
+        {
+            propertiesDeserializer->propertyParseState = PROPERTY_PARSE_STATE_DESIRED;
+            propertiesDeserializer->componentParseState = COMPONENT_PARSE_STATE_ROOT;
+            propertiesDeserializer->streamReader.sectionCursor = propertiesDeserializer->streamReader.desiredOffset + 1;
+            *propertiesDeserializerHandle = propertiesDeserializer;
+            result = IOTHUB_CLIENT_OK;
+        }
+    }
+
+    if (result != IOTHUB_CLIENT_OK)
+    {
+        IoTHubClient_Properties_Deserializer_Destroy(propertiesDeserializer);
+    }
+
+    return result;
+}
+
 IOTHUB_CLIENT_RESULT IoTHubClient_Properties_Deserializer_GetVersion(
     IOTHUB_CLIENT_PROPERTIES_DESERIALIZER_HANDLE propertiesDeserializerHandle,
     int* propertiesVersion)
@@ -775,6 +1467,10 @@ IOTHUB_CLIENT_RESULT IoTHubClient_Properties_Deserializer_GetNext(
         LogError("Invalid argument");
         result = IOTHUB_CLIENT_INVALID_ARG;
     }
+    else if (propertiesDeserializer->isStreaming)
+    {
+        result = StreamGetNextProperty(propertiesDeserializer, property, propertySpecified);
+    }
     else
     {
         if (propertiesDeserializer->propertyParseState == PROPERTY_PARSE_STATE_DESIRED)
@@ -831,7 +1527,16 @@ void IoTHubClient_Properties_Deserializer_Destroy(IOTHUB_CLIENT_PROPERTIES_DESER
     if (propertiesDeserializerHandle != NULL)
     {
         IOTHUB_CLIENT_PROPERTIES_DESERIALIZER* propertiesDeserializer = (IOTHUB_CLIENT_PROPERTIES_DESERIALIZER*)propertiesDeserializerHandle;
-        json_value_free(propertiesDeserializer->rootValue);
+        if (propertiesDeserializer->isStreaming)
+        {
+            free(propertiesDeserializer->streamReader.componentName);
+            free(propertiesDeserializer->streamReader.propertyName);
+            free(propertiesDeserializer->streamReader.value);
+        }
+        else
+        {
+            json_value_free(propertiesDeserializer->rootValue);
+        }
         free(propertiesDeserializer);
     }
 }
@@ -0,0 +1,485 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#include "internal/iothub_client_reported_aggregator.h"
+#include "parson.h"
+
+MU_DEFINE_ENUM_STRINGS_WITHOUT_INVALID(REPORTED_AGGREGATOR_FLUSH_RESULT, REPORTED_AGGREGATOR_FLUSH_RESULT_VALUES);
+
+// Status reported to the callbacks when every value in the merged document was already acknowledged
+// and nothing had to be sent.  Matches what IoT Hub returns for a successful reported properties PATCH.
+#define REPORTED_AGGREGATOR_STATUS_NOTHING_TO_SEND 204
+// Status reported to the callbacks when the merged document could not be produced locally.
+#define REPORTED_AGGREGATOR_STATUS_FAILED 500
+
+typedef struct REPORTED_CALLBACK_TAG
+{
+    struct REPORTED_CALLBACK_TAG* next;
+    IOTHUB_CLIENT_REPORTED_STATE_CALLBACK callback;
+    void* context;
+} REPORTED_CALLBACK;
+
+typedef struct REPORTED_AGGREGATOR_BATCH_TAG
+{
+    struct REPORTED_AGGREGATOR_BATCH_TAG* next; // next pending batch
+    struct REPORTED_AGGREGATOR_TAG* aggregator; // NULL once the aggregator is destroyed
+    JSON_Value* patchValue;
+    char* serializedPatch;
+    REPORTED_CALLBACK* callbacks;
+    REPORTED_CALLBACK* callbacksTail;
+    tickcounter_ms_t firstPendingTime;
+} REPORTED_AGGREGATOR_BATCH;
+
+typedef struct REPORTED_AGGREGATOR_TAG
+{
+    uint32_t flushIntervalMs;
+    // Batches not sent yet, oldest first.  PATCHes are merged into the last one unless that would lose a delete.
+    REPORTED_AGGREGATOR_BATCH* pendingHead;
+    REPORTED_AGGREGATOR_BATCH* pendingTail;
+    // Reported state known to IoT Hub.  Deleted members are kept as JSON null so that deleting them
+    // again can be recognized as unchanged; members never reported are simply absent.
+    JSON_Value* acknowledgedValue;
+    REPORTED_AGGREGATOR_BATCH* inFlightBatch;
+} REPORTED_AGGREGATOR;
+
+static void complete_callbacks(REPORTED_CALLBACK* callbacks, int status_code)
+{
+    while (callbacks != NULL)
+    {
+        REPORTED_CALLBACK* next = callbacks->next;
+        if (callbacks->callback != NULL)
+        {
+            callbacks->callback(status_code, callbacks->context);
+        }
+        free(callbacks);
+        callbacks = next;
+    }
+}
+
+// Merges patch into target following JSON merge patch (RFC 7386) rules, except that null members are kept
+// instead of removing the member from target.  A null followed by an object for the same member becomes the object
+// alone, so pending PATCHes must not be merged that way (see replaces_null_with_object).
+static int merge_patch(JSON_Object* target, const JSON_Object* patch)
+{
+    int result = 0;
+    size_t count = json_object_get_count(patch);
+    size_t i;
+
+    for (i = 0; (i < count) && (result == 0); i++)
+    {
+        const char* name = json_object_get_name(patch, i);
+        JSON_Value* value = json_object_get_value_at(patch, i);
+        JSON_Object* targetObject;
+
+        if ((json_value_get_type(value) == JSONObject) && ((targetObject = json_object_get_object(target, name)) != NULL))
+        {
+            result = merge_patch(targetObject, json_value_get_object(value));
+        }
+        else
+        {
+            JSON_Value* copy = json_value_deep_copy(value);
+            if (copy == NULL)
+            {
+                LogError("json_value_deep_copy failed for %s", name);
+                result = MU_FAILURE;
+            }
+            else if (json_object_set_value(target, name, copy) != JSONSuccess)
+            {
+                LogError("json_object_set_value failed for %s", name);
+                json_value_free(copy);
+                result = MU_FAILURE;
+            }
+        }
+    }
+
+    return result;
+}
+
+// Returns true when merging patch into target would turn a null member of target into an object.  Sent as one PATCH,
+// the object would be merged into the members the null deletes, so the two must go to IoT Hub separately.
+static bool replaces_null_with_object(const JSON_Object* target, const JSON_Object* patch)
+{
+    bool result = false;
+    size_t count = json_object_get_count(patch);
+    size_t i;
+
+    for (i = 0; (i < count) && !result; i++)
+    {
+        JSON_Value* value = json_object_get_value_at(patch, i);
+
+        if (json_value_get_type(value) == JSONObject)
+        {
+            JSON_Value* targetValue = json_object_get_value(target, json_object_get_name(patch, i));
+
+            if (json_value_get_type(targetValue) == JSONNull)
+            {
+                result = true;
+            }
+            else if (json_value_get_type(targetValue) == JSONObject)
+            {
+                result = replaces_null_with_object(json_value_get_object(targetValue), json_value_get_object(value));
+            }
+        }
+    }
+
+    return result;
+}
+
+// Removes from patch the members that would not change the acknowledged document.
+static void remove_unchanged(JSON_Object* patch, const JSON_Object* acknowledged)
+{
+    size_t i = json_object_get_count(patch);
+
+    // Walk backwards since parson fills a removed slot with the last member.
+    while (i > 0)
+    {
+        const char* name;
+        JSON_Value* value;
+        JSON_Value* acknowledgedValue;
+        bool unchanged;
+
+        i--;
+        name = json_object_get_name(patch, i);
+        value = json_object_get_value_at(patch, i);
+        acknowledgedValue = json_object_get_value(acknowledged, name);
+
+        if (acknowledgedValue == NULL)
+        {
+            unchanged = false;
+        }
+        else if ((json_value_get_type(value) == JSONObject) && (json_value_get_type(acknowledgedValue) == JSONObject))
+        {
+            remove_unchanged(json_value_get_object(value), json_value_get_object(acknowledgedValue));
+            unchanged = (json_object_get_count(json_value_get_object(value)) == 0);
+        }
+        else
+        {
+            unchanged = (json_value_equals(value, acknowledgedValue) != 0);
+        }
+
+        if (unchanged)
+        {
+            (void)json_object_remove(patch, name);
+        }
+    }
+}
+
+static REPORTED_AGGREGATOR_BATCH* batch_create(REPORTED_AGGREGATOR* aggregator, tickcounter_ms_t now)
+{
+    REPORTED_AGGREGATOR_BATCH* result;
+
+    if ((result = (REPORTED_AGGREGATOR_BATCH*)calloc(1, sizeof(REPORTED_AGGREGATOR_BATCH))) == NULL)
+    {
+        LogError("Failed allocating reported state batch");
+    }
+    else if ((result->patchValue = json_value_init_object()) == NULL)
+    {
+        LogError("json_value_init_object failed");
+        free(result);
+        result = NULL;
+    }
+    else
+    {
+        result->aggregator = aggregator;
+        result->firstPendingTime = now;
+    }
+
+    return result;
+}
+
+static void batch_destroy(REPORTED_AGGREGATOR_BATCH* batch)
+{
+    if (batch->serializedPatch != NULL)
+    {
+        json_free_serialized_string(batch->serializedPatch);
+    }
+    json_value_free(batch->patchValue);
+    free(batch);
+}
+
+REPORTED_AGGREGATOR_HANDLE reported_aggregator_create(uint32_t flush_interval_ms)
+{
+    REPORTED_AGGREGATOR* result;
+
+    if ((result = (REPORTED_AGGREGATOR*)calloc(1, sizeof(REPORTED_AGGREGATOR))) == NULL)
+    {
+        LogError("Failed allocating reported aggregator");
+    }
+    else if ((result->acknowledgedValue = json_value_init_object()) == NULL)
+    {
+        LogError("json_value_init_object failed");
+        free(result);
+        result = NULL;
+    }
+    else
+    {
+        result->flushIntervalMs = flush_interval_ms;
+    }
+
+    return result;
+}
+
+void reported_aggregator_destroy(REPORTED_AGGREGATOR_HANDLE handle, int status_code)
+{
+    if (handle != NULL)
+    {
+        REPORTED_AGGREGATOR_BATCH* batch = handle->pendingHead;
+
+        if (handle->inFlightBatch != NULL)
+        {
+            handle->inFlightBatch->aggregator = NULL;
+        }
+        json_value_free(handle->acknowledgedValue);
+        free(handle);
+
+        while (batch != NULL)
+        {
+            REPORTED_AGGREGATOR_BATCH* next = batch->next;
+            REPORTED_CALLBACK* callbacks = batch->callbacks;
+            batch_destroy(batch);
+            complete_callbacks(callbacks, status_code);
+            batch = next;
+        }
+    }
+}
+
+int reported_aggregator_set_flush_interval(REPORTED_AGGREGATOR_HANDLE handle, uint32_t flush_interval_ms)
+{
+    int result;
+
+    if (handle == NULL)
+    {
+        LogError("Invalid argument handle=NULL");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        handle->flushIntervalMs = flush_interval_ms;
+        result = 0;
+    }
+
+    return result;
+}
+
+int reported_aggregator_add(REPORTED_AGGREGATOR_HANDLE handle, const unsigned char* reported_state, size_t size, IOTHUB_CLIENT_REPORTED_STATE_CALLBACK callback, void* context, tickcounter_ms_t now)
+{
+    int result;
+
+    if ((handle == NULL) || (reported_state == NULL) || (size == 0))
+    {
+        LogError("Invalid argument handle=%p, reported_state=%p, size=%lu", handle, reported_state, (unsigned long)size);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        char* jsonString;
+        JSON_Value* patchValue = NULL;
+        REPORTED_CALLBACK* entry = NULL;
+        REPORTED_AGGREGATOR_BATCH* batch = handle->pendingTail;
+        REPORTED_AGGREGATOR_BATCH* newBatch = NULL;
+
+        if ((jsonString = (char*)malloc(size + 1)) == NULL)
+        {
+            LogError("Failed allocating %lu bytes", (unsigned long)(size + 1));
+            result = MU_FAILURE;
+        }
+        else
+        {
+            memcpy(jsonString, reported_state, size);
+            jsonString[size] = '\0';
+
+            if ((patchValue = json_parse_string(jsonString)) == NULL)
+            {
+                LogError("Reported state is not valid JSON");
+                result = MU_FAILURE;
+            }
+            else if (json_value_get_type(patchValue) != JSONObject)
+            {
+                LogError("Reported state must be a JSON object");
+                result = MU_FAILURE;
+            }
+            else if ((entry = (REPORTED_CALLBACK*)malloc(sizeof(REPORTED_CALLBACK))) == NULL)
+            {
+                LogError("Failed allocating callback entry");
+                result = MU_FAILURE;
+            }
+            else if (((batch == NULL) || replaces_null_with_object(json_value_get_object(batch->patchValue), json_value_get_object(patchValue))) &&
+                ((batch = newBatch = batch_create(handle, now)) == NULL))
+            {
+                LogError("Failed creating reported state batch");
+                result = MU_FAILURE;
+            }
+            else if (merge_patch(json_value_get_object(batch->patchValue), json_value_get_object(patchValue)) != 0)
+            {
+                // Members merged into a pending batch before the failure stay there; they are newer than what they replaced.
+                LogError("Failed merging reported state");
+                result = MU_FAILURE;
+            }
+            else
+            {
+                if (newBatch != NULL)
+                {
+                    if (handle->pendingTail == NULL)
+                    {
+                        handle->pendingHead = newBatch;
+                    }
+                    else
+                    {
+                        handle->pendingTail->next = newBatch;
+                    }
+                    handle->pendingTail = newBatch;
+                    newBatch = NULL;
+                }
+
+                entry->next = NULL;
+                entry->callback = callback;
+                entry->context = context;
+
+                if (batch->callbacksTail == NULL)
+                {
+                    batch->callbacks = entry;
+                }
+                else
+                {
+                    batch->callbacksTail->next = entry;
+                }
+                batch->callbacksTail = entry;
+                entry = NULL;
+
+                result = 0;
+            }
+
+            if (newBatch != NULL)
+            {
+                batch_destroy(newBatch);
+            }
+            free(entry);
+            json_value_free(patchValue);
+            free(jsonString);
+        }
+    }
+
+    return result;
+}
+
+REPORTED_AGGREGATOR_FLUSH_RESULT reported_aggregator_flush(REPORTED_AGGREGATOR_HANDLE handle, tickcounter_ms_t now, const unsigned char** patch, size_t* size, void** batch_context)
+{
+    REPORTED_AGGREGATOR_FLUSH_RESULT result;
+
+    if ((handle == NULL) || (patch == NULL) || (size == NULL) || (batch_context == NULL))
+    {
+        LogError("Invalid argument handle=%p, patch=%p, size=%p, batch_context=%p", handle, patch, size, batch_context);
+        result = REPORTED_AGGREGATOR_FLUSH_ERROR;
+    }
+    else if ((handle->pendingHead == NULL) || (handle->inFlightBatch != NULL) || ((now - handle->pendingHead->firstPendingTime) < handle->flushIntervalMs))
+    {
+        result = REPORTED_AGGREGATOR_FLUSH_IDLE;
+    }
+    else
+    {
+        REPORTED_AGGREGATOR_BATCH* batch = handle->pendingHead;
+        JSON_Object* patchObject = json_value_get_object(batch->patchValue);
+
+        handle->pendingHead = batch->next;
+        if (handle->pendingHead == NULL)
+        {
+            handle->pendingTail = NULL;
+        }
+        batch->next = NULL;
+
+        remove_unchanged(patchObject, json_value_get_object(handle->acknowledgedValue));
+
+        if (json_object_get_count(patchObject) == 0)
+        {
+            REPORTED_CALLBACK* callbacks = batch->callbacks;
+            batch_destroy(batch);
+            result = REPORTED_AGGREGATOR_FLUSH_IDLE;
+            // Callbacks run last since they may add new PATCHes.
+            complete_callbacks(callbacks, REPORTED_AGGREGATOR_STATUS_NOTHING_TO_SEND);
+        }
+        else if ((batch->serializedPatch = json_serialize_to_string(batch->patchValue)) == NULL)
+        {
+            LogError("Failed serializing merged reported state");
+            reported_aggregator_on_patch_complete(REPORTED_AGGREGATOR_STATUS_FAILED, batch);
+            result = REPORTED_AGGREGATOR_FLUSH_ERROR;
+        }
+        else
+        {
+            handle->inFlightBatch = batch;
+            *patch = (const unsigned char*)batch->serializedPatch;
+            *size = strlen(batch->serializedPatch);
+            *batch_context = batch;
+            result = REPORTED_AGGREGATOR_FLUSH_PATCH_READY;
+        }
+    }
+
+    return result;
+}
+
+void reported_aggregator_on_patch_complete(int status_code, void* batch_context)
+{
+    if (batch_context == NULL)
+    {
+        LogError("Invalid argument batch_context=NULL");
+    }
+    else
+    {
+        REPORTED_AGGREGATOR_BATCH* batch = (REPORTED_AGGREGATOR_BATCH*)batch_context;
+        REPORTED_CALLBACK* callbacks = batch->callbacks;
+
+        if (batch->aggregator != NULL)
+        {
+            if ((status_code >= 200) && (status_code < 300) &&
+                (merge_patch(json_value_get_object(batch->aggregator->acknowledgedValue), json_value_get_object(batch->patchValue)) != 0))
+            {
+                // Values that failed to merge are simply sent again the next time they are reported.
+                LogError("Failed updating acknowledged reported state");
+            }
+
+            if (batch->aggregator->inFlightBatch == batch)
+            {
+                batch->aggregator->inFlightBatch = NULL;
+            }
+        }
+
+        batch_destroy(batch);
+        complete_callbacks(callbacks, status_code);
+    }
+}
+
+bool reported_aggregator_is_idle(REPORTED_AGGREGATOR_HANDLE handle)
+{
+    return (handle == NULL) || ((handle->pendingHead == NULL) && (handle->inFlightBatch == NULL));
+}
+
+bool reported_aggregator_get_flush_timeout(REPORTED_AGGREGATOR_HANDLE handle, tickcounter_ms_t now, tickcounter_ms_t* timeout_ms)
+{
+    bool result;
+
+    if ((handle == NULL) || (timeout_ms == NULL))
+    {
+        LogError("Invalid argument handle=%p, timeout_ms=%p", handle, timeout_ms);
+        result = false;
+    }
+    // Same conditions as reported_aggregator_flush
+    else if ((handle->pendingHead == NULL) || (handle->inFlightBatch != NULL))
+    {
+        result = false;
+    }
+    else
+    {
+        tickcounter_ms_t elapsed = now - handle->pendingHead->firstPendingTime;
+        *timeout_ms = (elapsed < handle->flushIntervalMs) ? (handle->flushIntervalMs - elapsed) : 0;
+        result = true;
+    }
+
+    return result;
+}
@@ -0,0 +1,108 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef USE_TRACING
+#ifdef _WIN32
+#include <windows.h>
+#else
+#define _POSIX_C_SOURCE 200112L
+#include <time.h>
+#endif
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#include "iothub_client_tracing.h"
+#include "internal/iothub_client_tracing_private.h"
+
+MU_DEFINE_ENUM_STRINGS_WITHOUT_INVALID(IOTHUB_CLIENT_TRACE_POINT, IOTHUB_CLIENT_TRACE_POINT_VALUES);
+
+#ifdef USE_TRACING
+
+// Clients on different threads enqueue concurrently, so the ids are handed out atomically
+#if defined(_MSC_VER)
+typedef volatile LONG64 TRACE_ID_VALUE;
+#define TRACE_ID_NEXT(counter)  ((uint64_t)InterlockedIncrement64(&(counter)))
+#elif defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) && !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+typedef atomic_uint_fast64_t TRACE_ID_VALUE;
+#define TRACE_ID_NEXT(counter)  ((uint64_t)atomic_fetch_add_explicit(&(counter), 1, memory_order_relaxed) + 1)
+#elif defined(__GNUC__)
+typedef uint64_t TRACE_ID_VALUE;
+#define TRACE_ID_NEXT(counter)  __atomic_add_fetch(&(counter), 1, __ATOMIC_RELAXED)
+#else
+typedef volatile uint64_t TRACE_ID_VALUE;
+#define TRACE_ID_NEXT(counter)  (++(counter))
+#endif
+
+static IOTHUB_CLIENT_TRACE_CALLBACK g_trace_callback;
+static void* g_trace_context;
+static TRACE_ID_VALUE g_last_message_id;
+
+static uint64_t get_timestamp_ns(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+    (void)QueryPerformanceCounter(&counter);
+    (void)QueryPerformanceFrequency(&frequency);
+    return (uint64_t)((counter.QuadPart / frequency.QuadPart) * 1000000000) + (uint64_t)(((counter.QuadPart % frequency.QuadPart) * 1000000000) / frequency.QuadPart);
+#else
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000000) + (uint64_t)now.tv_nsec;
+#endif
+}
+
+uint64_t iothub_client_trace_begin(void)
+{
+    uint64_t result;
+    IOTHUB_CLIENT_TRACE_CALLBACK trace_callback = g_trace_callback;
+
+    if (trace_callback == NULL)
+    {
+        result = 0;
+    }
+    else
+    {
+        result = TRACE_ID_NEXT(g_last_message_id);
+        trace_callback(IOTHUB_CLIENT_TRACE_ENQUEUED, result, get_timestamp_ns(), g_trace_context);
+    }
+
+    return result;
+}
+
+void iothub_client_trace(IOTHUB_CLIENT_TRACE_POINT point, uint64_t message_id)
+{
+    IOTHUB_CLIENT_TRACE_CALLBACK trace_callback = g_trace_callback;
+
+    if (message_id != 0 && trace_callback != NULL)
+    {
+        trace_callback(point, message_id, get_timestamp_ns(), g_trace_context);
+    }
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_SetTraceCallback(IOTHUB_CLIENT_TRACE_CALLBACK traceCallback, void* userContext)
+{
+    g_trace_context = userContext;
+    g_trace_callback = traceCallback;
+
+    return IOTHUB_CLIENT_OK;
+}
+
+#else
+
+IOTHUB_CLIENT_RESULT IoTHubClient_SetTraceCallback(IOTHUB_CLIENT_TRACE_CALLBACK traceCallback, void* userContext)
+{
+    (void)traceCallback;
+    (void)userContext;
+    LogError("IoTHubClient_SetTraceCallback called without the USE_TRACING compiler switch");
+
+    return IOTHUB_CLIENT_ERROR;
+}
+
+#endif /* USE_TRACING */
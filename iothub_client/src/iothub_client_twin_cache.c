@@ -0,0 +1,798 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#include "internal/iothub_client_twin_cache.h"
+#include "parson.h"
+
+MU_DEFINE_ENUM_STRINGS_WITHOUT_INVALID(TWIN_CACHE_UPDATE_RESULT, TWIN_CACHE_UPDATE_RESULT_VALUES);
+
+static const char TWIN_DESIRED_OBJECT_NAME[] = "desired";
+static const char TWIN_REPORTED_OBJECT_NAME[] = "reported";
+static const char TWIN_VERSION[] = "$version";
+static const char TWIN_COMPONENT_MARKER_NAME[] = "__t";
+static const char TWIN_COMPONENT_MARKER_VALUE[] = "c";
+
+#define TWIN_CACHE_INITIAL_BUCKET_COUNT 32
+
+#define FNV_OFFSET_BASIS 2166136261u
+#define FNV_PRIME 16777619u
+
+// An index entry maps (propertyType, componentName, propertyName) to the JSON_Value in the cached document.
+// The names are copied into the same allocation as the entry (right after the structure), so that entries
+// do not depend on the lifetime of the keys inside the parson document.
+typedef struct TWIN_CACHE_ENTRY_TAG
+{
+    struct TWIN_CACHE_ENTRY_TAG* next;
+    uint32_t hash;
+    IOTHUB_CLIENT_PROPERTY_TYPE propertyType;
+    const char* componentName;
+    const char* propertyName;
+    JSON_Value* propertyValue;
+} TWIN_CACHE_ENTRY;
+
+typedef struct TWIN_CACHE_TAG
+{
+    JSON_Value* rootValue;
+    JSON_Object* desiredObject;
+    JSON_Object* reportedObject;
+    int version;
+    bool isPopulated;
+    TWIN_CACHE_ENTRY** buckets;
+    size_t bucketCount;
+    size_t entryCount;
+} TWIN_CACHE;
+
+static uint32_t hash_string(uint32_t hash, const char* value)
+{
+    while (*value != '\0')
+    {
+        hash = (hash ^ (uint8_t)*value) * FNV_PRIME;
+        value++;
+    }
+    return hash;
+}
+
+// FNV-1a over the section, component and name.  0xFF never appears in UTF-8 text, so it is safe
+// to use as a separator between the component and property name.
+static uint32_t hash_key(IOTHUB_CLIENT_PROPERTY_TYPE propertyType, const char* componentName, const char* propertyName)
+{
+    uint32_t hash = (FNV_OFFSET_BASIS ^ (uint32_t)propertyType) * FNV_PRIME;
+    if (componentName != NULL)
+    {
+        hash = hash_string(hash, componentName);
+    }
+    hash = (hash ^ 0xFFu) * FNV_PRIME;
+    return hash_string(hash, propertyName);
+}
+
+static bool entry_matches(const TWIN_CACHE_ENTRY* entry, uint32_t hash, IOTHUB_CLIENT_PROPERTY_TYPE propertyType, const char* componentName, const char* propertyName)
+{
+    bool result;
+
+    if ((entry->hash != hash) || (entry->propertyType != propertyType))
+    {
+        result = false;
+    }
+    else if ((entry->componentName == NULL) || (componentName == NULL))
+    {
+        result = (entry->componentName == componentName) && (strcmp(entry->propertyName, propertyName) == 0);
+    }
+    else
+    {
+        result = (strcmp(entry->componentName, componentName) == 0) && (strcmp(entry->propertyName, propertyName) == 0);
+    }
+
+    return result;
+}
+
+static TWIN_CACHE_ENTRY** find_entry(TWIN_CACHE* twinCache, IOTHUB_CLIENT_PROPERTY_TYPE propertyType, const char* componentName, const char* propertyName)
+{
+    uint32_t hash = hash_key(propertyType, componentName, propertyName);
+    TWIN_CACHE_ENTRY** current = &twinCache->buckets[hash % twinCache->bucketCount];
+
+    while ((*current != NULL) && !entry_matches(*current, hash, propertyType, componentName, propertyName))
+    {
+        current = &(*current)->next;
+    }
+
+    return current;
+}
+
+static void clear_index(TWIN_CACHE* twinCache)
+{
+    size_t i;
+    for (i = 0; i < twinCache->bucketCount; i++)
+    {
+        TWIN_CACHE_ENTRY* entry = twinCache->buckets[i];
+        while (entry != NULL)
+        {
+            TWIN_CACHE_ENTRY* next = entry->next;
+            free(entry);
+            entry = next;
+        }
+        twinCache->buckets[i] = NULL;
+    }
+    twinCache->entryCount = 0;
+}
+
+// grow_index doubles the number of buckets once the load factor passes 3/4.  Failing to grow is not fatal,
+// lookups only get slower.
+static void grow_index(TWIN_CACHE* twinCache)
+{
+    size_t newBucketCount = twinCache->bucketCount * 2;
+    TWIN_CACHE_ENTRY** newBuckets;
+
+    if ((newBucketCount < twinCache->bucketCount) || ((newBuckets = (TWIN_CACHE_ENTRY**)calloc(newBucketCount, sizeof(TWIN_CACHE_ENTRY*))) == NULL))
+    {
+        LogError("Unable to grow twin cache index to %lu buckets", (unsigned long)newBucketCount);
+    }
+    else
+    {
+        size_t i;
+        for (i = 0; i < twinCache->bucketCount; i++)
+        {
+            TWIN_CACHE_ENTRY* entry = twinCache->buckets[i];
+            while (entry != NULL)
+            {
+                TWIN_CACHE_ENTRY* next = entry->next;
+                entry->next = newBuckets[entry->hash % newBucketCount];
+                newBuckets[entry->hash % newBucketCount] = entry;
+                entry = next;
+            }
+        }
+
+        free(twinCache->buckets);
+        twinCache->buckets = newBuckets;
+        twinCache->bucketCount = newBucketCount;
+    }
+}
+
+static int add_entry(TWIN_CACHE* twinCache, IOTHUB_CLIENT_PROPERTY_TYPE propertyType, const char* componentName, const char* propertyName, JSON_Value* propertyValue)
+{
+    int result;
+    TWIN_CACHE_ENTRY** existing = find_entry(twinCache, propertyType, componentName, propertyName);
+
+    if (*existing != NULL)
+    {
+        (*existing)->propertyValue = propertyValue;
+        result = 0;
+    }
+    else
+    {
+        size_t componentNameLength = (componentName == NULL) ? 0 : strlen(componentName) + 1;
+        size_t propertyNameLength = strlen(propertyName) + 1;
+        TWIN_CACHE_ENTRY* entry;
+
+        if ((entry = (TWIN_CACHE_ENTRY*)malloc(sizeof(TWIN_CACHE_ENTRY) + componentNameLength + propertyNameLength)) == NULL)
+        {
+            LogError("Unable to allocate twin cache entry");
+            result = MU_FAILURE;
+        }
+        else
+        {
+            char* names = (char*)(entry + 1);
+
+            if (componentName != NULL)
+            {
+                (void)memcpy(names, componentName, componentNameLength);
+                entry->componentName = names;
+            }
+            else
+            {
+                entry->componentName = NULL;
+            }
+            (void)memcpy(names + componentNameLength, propertyName, propertyNameLength);
+            entry->propertyName = names + componentNameLength;
+            entry->propertyType = propertyType;
+            entry->propertyValue = propertyValue;
+            entry->hash = hash_key(propertyType, componentName, propertyName);
+            entry->next = twinCache->buckets[entry->hash % twinCache->bucketCount];
+            twinCache->buckets[entry->hash % twinCache->bucketCount] = entry;
+            twinCache->entryCount++;
+
+            if (twinCache->entryCount > (twinCache->bucketCount / 4) * 3)
+            {
+                grow_index(twinCache);
+            }
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void remove_entry(TWIN_CACHE* twinCache, IOTHUB_CLIENT_PROPERTY_TYPE propertyType, const char* componentName, const char* propertyName)
+{
+    TWIN_CACHE_ENTRY** existing = find_entry(twinCache, propertyType, componentName, propertyName);
+
+    if (*existing != NULL)
+    {
+        TWIN_CACHE_ENTRY* entry = *existing;
+        *existing = entry->next;
+        free(entry);
+        twinCache->entryCount--;
+    }
+}
+
+// Twin metadata such as $version is never handed to the application as a property.
+static bool is_reserved_name(const char* name)
+{
+    return (name == NULL) || (name[0] == '$');
+}
+
+// A top-level object is a component when it carries the "__t":"c" marker.
+static JSON_Object* get_component_object(JSON_Value* value)
+{
+    JSON_Object* componentObject = json_value_get_object(value);
+    const char* componentMarkerValue = json_object_get_string(componentObject, TWIN_COMPONENT_MARKER_NAME);
+
+    return ((componentMarkerValue != NULL) && (strcmp(componentMarkerValue, TWIN_COMPONENT_MARKER_VALUE) == 0)) ? componentObject : NULL;
+}
+
+// index_top_level adds the entries for the top-level key 'name' of a section: either the key itself for the
+// root component, or every child of the key when it is a component.
+static int index_top_level(TWIN_CACHE* twinCache, IOTHUB_CLIENT_PROPERTY_TYPE propertyType, JSON_Object* sectionObject, const char* name)
+{
+    int result;
+    JSON_Value* value = json_object_get_value(sectionObject, name);
+    JSON_Object* componentObject;
+
+    if ((value == NULL) || is_reserved_name(name))
+    {
+        result = 0;
+    }
+    else if ((componentObject = get_component_object(value)) != NULL)
+    {
+        size_t count = json_object_get_count(componentObject);
+        size_t i;
+
+        result = 0;
+        for (i = 0; i < count; i++)
+        {
+            const char* childName = json_object_get_name(componentObject, i);
+            if ((childName != NULL) && (strcmp(childName, TWIN_COMPONENT_MARKER_NAME) != 0) &&
+                (add_entry(twinCache, propertyType, name, childName, json_object_get_value_at(componentObject, i)) != 0))
+            {
+                result = MU_FAILURE;
+                break;
+            }
+        }
+    }
+    else
+    {
+        result = add_entry(twinCache, propertyType, NULL, name, value);
+    }
+
+    return result;
+}
+
+static void unindex_top_level(TWIN_CACHE* twinCache, IOTHUB_CLIENT_PROPERTY_TYPE propertyType, JSON_Object* sectionObject, const char* name)
+{
+    JSON_Value* value = json_object_get_value(sectionObject, name);
+    JSON_Object* componentObject;
+
+    if ((value != NULL) && !is_reserved_name(name))
+    {
+        if ((componentObject = get_component_object(value)) != NULL)
+        {
+            size_t count = json_object_get_count(componentObject);
+            size_t i;
+            for (i = 0; i < count; i++)
+            {
+                const char* childName = json_object_get_name(componentObject, i);
+                if (childName != NULL)
+                {
+                    remove_entry(twinCache, propertyType, name, childName);
+                }
+            }
+        }
+        else
+        {
+            remove_entry(twinCache, propertyType, NULL, name);
+        }
+    }
+}
+
+static int index_section(TWIN_CACHE* twinCache, IOTHUB_CLIENT_PROPERTY_TYPE propertyType, JSON_Object* sectionObject)
+{
+    int result = 0;
+    size_t count = json_object_get_count(sectionObject);
+    size_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        if (index_top_level(twinCache, propertyType, sectionObject, json_object_get_name(sectionObject, i)) != 0)
+        {
+            result = MU_FAILURE;
+            break;
+        }
+    }
+
+    return result;
+}
+
+static int merge_patch(JSON_Object* targetObject, const JSON_Object* patchObject);
+
+// merge_member applies a single member of a patch onto targetObject as described by RFC 7386 (JSON Merge Patch),
+// which is how IoT Hub describes twin updates: null removes a member, objects are merged recursively and anything
+// else replaces the existing value.
+static int merge_member(JSON_Object* targetObject, const char* name, JSON_Value* patchValue)
+{
+    int result;
+    JSON_Value_Type patchType = json_value_get_type(patchValue);
+
+    if (patchType == JSONNull)
+    {
+        // Removing a member that is not in the cache is not an error.
+        (void)json_object_remove(targetObject, name);
+        result = 0;
+    }
+    else if (patchType == JSONObject)
+    {
+        JSON_Object* existingObject = json_object_get_object(targetObject, name);
+
+        if (existingObject == NULL)
+        {
+            JSON_Value* newValue;
+
+            if ((newValue = json_value_init_object()) == NULL)
+            {
+                LogError("Unable to allocate JSON object for %s", name);
+            }
+            else if (json_object_set_value(targetObject, name, newValue) != JSONSuccess)
+            {
+                LogError("Unable to set JSON object for %s", name);
+                json_value_free(newValue);
+            }
+            else
+            {
+                existingObject = json_value_get_object(newValue);
+            }
+        }
+
+        if (existingObject == NULL)
+        {
+            result = MU_FAILURE;
+        }
+        else
+        {
+            result = merge_patch(existingObject, json_value_get_object(patchValue));
+        }
+    }
+    else
+    {
+        JSON_Value* newValue;
+
+        if ((newValue = json_value_deep_copy(patchValue)) == NULL)
+        {
+            LogError("Unable to copy JSON value for %s", name);
+            result = MU_FAILURE;
+        }
+        else if (json_object_set_value(targetObject, name, newValue) != JSONSuccess)
+        {
+            LogError("Unable to set JSON value for %s", name);
+            json_value_free(newValue);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int merge_patch(JSON_Object* targetObject, const JSON_Object* patchObject)
+{
+    int result = 0;
+    size_t count = json_object_get_count(patchObject);
+    size_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        if (merge_member(targetObject, json_object_get_name(patchObject, i), json_object_get_value_at(patchObject, i)) != 0)
+        {
+            result = MU_FAILURE;
+            break;
+        }
+    }
+
+    return result;
+}
+
+// merge_section re-indexes only the top-level keys touched by the patch, so the cost of an update is
+// proportional to the size of the patch and not to the size of the twin.
+static int merge_section(TWIN_CACHE* twinCache, IOTHUB_CLIENT_PROPERTY_TYPE propertyType, JSON_Object* sectionObject, const JSON_Object* patchObject)
+{
+    int result = 0;
+    size_t count = json_object_get_count(patchObject);
+    size_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        const char* name = json_object_get_name(patchObject, i);
+
+        unindex_top_level(twinCache, propertyType, sectionObject, name);
+
+        if (merge_member(sectionObject, name, json_object_get_value_at(patchObject, i)) != 0)
+        {
+            LogError("Unable to merge patch for %s", name);
+            result = MU_FAILURE;
+        }
+
+        // Re-index even on failure so that the index never points at values that were freed by the merge.
+        if (index_top_level(twinCache, propertyType, sectionObject, name) != 0)
+        {
+            result = MU_FAILURE;
+        }
+
+        if (result != 0)
+        {
+            break;
+        }
+    }
+
+    return result;
+}
+
+static JSON_Value* parse_payload(const unsigned char* payload, size_t size)
+{
+    JSON_Value* result;
+    char* jsonStr;
+
+    if ((size + 1) == 0)
+    {
+        LogError("Payload size exceeds maximum allocation");
+        result = NULL;
+    }
+    else if ((jsonStr = (char*)malloc(size + 1)) == NULL)
+    {
+        LogError("Unable to allocate %lu size buffer", (unsigned long)(size + 1));
+        result = NULL;
+    }
+    else
+    {
+        (void)memcpy(jsonStr, payload, size);
+        jsonStr[size] = '\0';
+        if ((result = json_parse_string(jsonStr)) == NULL)
+        {
+            LogError("Unable to parse twin JSON");
+        }
+        free(jsonStr);
+    }
+
+    return result;
+}
+
+static int get_version(JSON_Object* object, int* version)
+{
+    int result;
+    JSON_Value* versionValue = json_object_get_value(object, TWIN_VERSION);
+
+    if (json_value_get_type(versionValue) != JSONNumber)
+    {
+        LogError("JSON field %s is missing or not a number", TWIN_VERSION);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        *version = (int)json_value_get_number(versionValue);
+        result = 0;
+    }
+
+    return result;
+}
+
+static void reset_document(TWIN_CACHE* twinCache)
+{
+    clear_index(twinCache);
+    json_value_free(twinCache->rootValue);
+    twinCache->rootValue = NULL;
+    twinCache->desiredObject = NULL;
+    twinCache->reportedObject = NULL;
+    twinCache->isPopulated = false;
+}
+
+// Makes sure the root object has a 'sectionName' object, since a twin without desired or reported properties may omit it.
+static JSON_Object* get_or_add_section(JSON_Object* rootObject, const char* sectionName)
+{
+    JSON_Object* result = json_object_get_object(rootObject, sectionName);
+
+    if (result == NULL)
+    {
+        JSON_Value* sectionValue;
+
+        if ((sectionValue = json_value_init_object()) == NULL)
+        {
+            LogError("Unable to allocate %s object", sectionName);
+        }
+        else if (json_object_set_value(rootObject, sectionName, sectionValue) != JSONSuccess)
+        {
+            LogError("Unable to set %s object", sectionName);
+            json_value_free(sectionValue);
+        }
+        else
+        {
+            result = json_value_get_object(sectionValue);
+        }
+    }
+
+    return result;
+}
+
+static TWIN_CACHE_UPDATE_RESULT replace_document(TWIN_CACHE* twinCache, const unsigned char* payload, size_t size)
+{
+    TWIN_CACHE_UPDATE_RESULT result;
+    JSON_Value* rootValue;
+    JSON_Object* rootObject;
+
+    reset_document(twinCache);
+
+    if ((rootValue = parse_payload(payload, size)) == NULL)
+    {
+        result = TWIN_CACHE_UPDATE_ERROR;
+    }
+    else
+    {
+        twinCache->rootValue = rootValue;
+
+        if ((rootObject = json_value_get_object(rootValue)) == NULL)
+        {
+            LogError("Twin JSON root is not an object");
+            result = TWIN_CACHE_UPDATE_ERROR;
+        }
+        else if (((twinCache->desiredObject = get_or_add_section(rootObject, TWIN_DESIRED_OBJECT_NAME)) == NULL) ||
+                 ((twinCache->reportedObject = get_or_add_section(rootObject, TWIN_REPORTED_OBJECT_NAME)) == NULL))
+        {
+            result = TWIN_CACHE_UPDATE_ERROR;
+        }
+        else if (get_version(twinCache->desiredObject, &twinCache->version) != 0)
+        {
+            result = TWIN_CACHE_UPDATE_ERROR;
+        }
+        else if ((index_section(twinCache, IOTHUB_CLIENT_PROPERTY_TYPE_WRITABLE, twinCache->desiredObject) != 0) ||
+                 (index_section(twinCache, IOTHUB_CLIENT_PROPERTY_TYPE_REPORTED_FROM_CLIENT, twinCache->reportedObject) != 0))
+        {
+            LogError("Unable to index twin");
+            result = TWIN_CACHE_UPDATE_ERROR;
+        }
+        else
+        {
+            twinCache->isPopulated = true;
+            result = TWIN_CACHE_UPDATE_OK;
+        }
+
+        if (result != TWIN_CACHE_UPDATE_OK)
+        {
+            reset_document(twinCache);
+        }
+    }
+
+    return result;
+}
+
+static TWIN_CACHE_UPDATE_RESULT apply_desired_patch(TWIN_CACHE* twinCache, const unsigned char* payload, size_t size)
+{
+    TWIN_CACHE_UPDATE_RESULT result;
+    JSON_Value* patchValue;
+    JSON_Object* patchObject;
+    int patchVersion;
+
+    if (!twinCache->isPopulated)
+    {
+        result = TWIN_CACHE_UPDATE_VERSION_GAP;
+    }
+    else if ((patchValue = parse_payload(payload, size)) == NULL)
+    {
+        result = TWIN_CACHE_UPDATE_ERROR;
+    }
+    else
+    {
+        if (((patchObject = json_value_get_object(patchValue)) == NULL) || (get_version(patchObject, &patchVersion) != 0))
+        {
+            LogError("Twin patch is not an object with a %s", TWIN_VERSION);
+            result = TWIN_CACHE_UPDATE_ERROR;
+        }
+        else if (patchVersion <= twinCache->version)
+        {
+            // Already applied, e.g. a PATCH that raced with the complete twin that was fetched after a gap.
+            result = TWIN_CACHE_UPDATE_OK;
+        }
+        else if (patchVersion != twinCache->version + 1)
+        {
+            LogInfo("Twin patch version %d does not follow cached version %d", patchVersion, twinCache->version);
+            result = TWIN_CACHE_UPDATE_VERSION_GAP;
+        }
+        else if (merge_section(twinCache, IOTHUB_CLIENT_PROPERTY_TYPE_WRITABLE, twinCache->desiredObject, patchObject) != 0)
+        {
+            // The document may be partially updated at this point; report a gap so the caller fetches a consistent copy.
+            LogError("Unable to merge twin patch version %d", patchVersion);
+            twinCache->isPopulated = false;
+            result = TWIN_CACHE_UPDATE_VERSION_GAP;
+        }
+        else
+        {
+            twinCache->version = patchVersion;
+            result = TWIN_CACHE_UPDATE_OK;
+        }
+
+        json_value_free(patchValue);
+    }
+
+    return result;
+}
+
+TWIN_CACHE_HANDLE twin_cache_create(void)
+{
+    TWIN_CACHE* result;
+
+    if ((result = (TWIN_CACHE*)calloc(1, sizeof(TWIN_CACHE))) == NULL)
+    {
+        LogError("Unable to allocate TWIN_CACHE");
+    }
+    else if ((result->buckets = (TWIN_CACHE_ENTRY**)calloc(TWIN_CACHE_INITIAL_BUCKET_COUNT, sizeof(TWIN_CACHE_ENTRY*))) == NULL)
+    {
+        LogError("Unable to allocate twin cache index");
+        free(result);
+        result = NULL;
+    }
+    else
+    {
+        result->bucketCount = TWIN_CACHE_INITIAL_BUCKET_COUNT;
+    }
+
+    return result;
+}
+
+void twin_cache_destroy(TWIN_CACHE_HANDLE handle)
+{
+    if (handle != NULL)
+    {
+        reset_document(handle);
+        free(handle->buckets);
+        free(handle);
+    }
+}
+
+TWIN_CACHE_UPDATE_RESULT twin_cache_update(TWIN_CACHE_HANDLE handle, DEVICE_TWIN_UPDATE_STATE update_state, const unsigned char* payload, size_t size)
+{
+    TWIN_CACHE_UPDATE_RESULT result;
+
+    if ((handle == NULL) || (payload == NULL) || (size == 0))
+    {
+        LogError("Invalid argument handle=%p, payload=%p, size=%lu", handle, payload, (unsigned long)size);
+        result = TWIN_CACHE_UPDATE_ERROR;
+    }
+    else if (update_state == DEVICE_TWIN_UPDATE_COMPLETE)
+    {
+        result = replace_document(handle, payload, size);
+    }
+    else
+    {
+        result = apply_desired_patch(handle, payload, size);
+    }
+
+    return result;
+}
+
+int twin_cache_apply_reported(TWIN_CACHE_HANDLE handle, const unsigned char* payload, size_t size)
+{
+    int result;
+
+    if ((handle == NULL) || (payload == NULL) || (size == 0))
+    {
+        LogError("Invalid argument handle=%p, payload=%p, size=%lu", handle, payload, (unsigned long)size);
+        result = MU_FAILURE;
+    }
+    else if (!handle->isPopulated)
+    {
+        // Nothing to merge into; the next complete twin will carry the reported properties.
+        result = 0;
+    }
+    else
+    {
+        JSON_Value* patchValue;
+        JSON_Object* patchObject;
+
+        if ((patchValue = parse_payload(payload, size)) == NULL)
+        {
+            result = MU_FAILURE;
+        }
+        else
+        {
+            if ((patchObject = json_value_get_object(patchValue)) == NULL)
+            {
+                LogError("Reported properties patch is not an object");
+                result = MU_FAILURE;
+            }
+            else if (merge_section(handle, IOTHUB_CLIENT_PROPERTY_TYPE_REPORTED_FROM_CLIENT, handle->reportedObject, patchObject) != 0)
+            {
+                LogError("Unable to merge reported properties patch");
+                result = MU_FAILURE;
+            }
+            else
+            {
+                result = 0;
+            }
+            json_value_free(patchValue);
+        }
+    }
+
+    return result;
+}
+
+int twin_cache_get_version(TWIN_CACHE_HANDLE handle, int* version)
+{
+    int result;
+
+    if ((handle == NULL) || (version == NULL))
+    {
+        LogError("Invalid argument handle=%p, version=%p", handle, version);
+        result = MU_FAILURE;
+    }
+    else if (!handle->isPopulated)
+    {
+        result = MU_FAILURE;
+    }
+    else
+    {
+        *version = handle->version;
+        result = 0;
+    }
+
+    return result;
+}
+
+IOTHUB_CLIENT_RESULT twin_cache_get_property(TWIN_CACHE_HANDLE handle, IOTHUB_CLIENT_PROPERTY_TYPE propertyType, const char* componentName, const char* propertyName, IOTHUB_CLIENT_PROPERTY_PARSED* property, bool* propertySpecified)
+{
+    IOTHUB_CLIENT_RESULT result;
+
+    if ((handle == NULL) || (propertyName == NULL) || (property == NULL) || (propertySpecified == NULL) ||
+        (property->structVersion != IOTHUB_CLIENT_PROPERTY_PARSED_STRUCT_VERSION_1))
+    {
+        LogError("Invalid argument");
+        result = IOTHUB_CLIENT_INVALID_ARG;
+    }
+    else
+    {
+        TWIN_CACHE_ENTRY* entry = *find_entry(handle, propertyType, componentName, propertyName);
+
+        if (entry == NULL)
+        {
+            *propertySpecified = false;
+            result = IOTHUB_CLIENT_OK;
+        }
+        else
+        {
+            char* propertyStringJson;
+
+            if ((propertyStringJson = json_serialize_to_string(entry->propertyValue)) == NULL)
+            {
+                LogError("Unable to retrieve JSON string for property value");
+                result = IOTHUB_CLIENT_ERROR;
+            }
+            else
+            {
+                property->propertyType = propertyType;
+                property->componentName = componentName;
+                property->name = propertyName;
+                property->valueType = IOTHUB_CLIENT_PROPERTY_VALUE_STRING;
+                property->value.str = propertyStringJson;
+                property->valueLength = strlen(propertyStringJson);
+                *propertySpecified = true;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
+    }
+
+    return result;
+}
@@ -171,3 +171,13 @@ IOTHUB_CLIENT_RESULT IoTHubDeviceClient_GetPropertiesAndSubscribeToUpdatesAsync(
 {
     return IoTHubClientCore_SetDeviceTwinCallback((IOTHUB_CLIENT_CORE_HANDLE)iotHubClientHandle, (IOTHUB_CLIENT_DEVICE_TWIN_CALLBACK)propertiesCallback, userContextCallback);
 }
+
+IOTHUB_CLIENT_RESULT IoTHubDeviceClient_GetCallbackQueueStatistics(IOTHUB_DEVICE_CLIENT_HANDLE iotHubClientHandle, IOTHUB_CLIENT_CALLBACK_QUEUE_STATISTICS* statistics)
+{
+    return IoTHubClientCore_GetCallbackQueueStatistics((IOTHUB_CLIENT_CORE_HANDLE)iotHubClientHandle, statistics);
+}
+
+IOTHUB_CLIENT_RESULT IoTHubDeviceClient_GetMetrics(IOTHUB_DEVICE_CLIENT_HANDLE iotHubClientHandle, IOTHUB_CLIENT_METRICS* metrics)
+{
+    return IoTHubClientCore_GetMetrics((IOTHUB_CLIENT_CORE_HANDLE)iotHubClientHandle, metrics);
+}
@@ -91,6 +91,11 @@ void IoTHubDeviceClient_LL_DoWork(IOTHUB_DEVICE_CLIENT_LL_HANDLE iotHubClientHan
     IoTHubClientCore_LL_DoWork((IOTHUB_CLIENT_CORE_LL_HANDLE)iotHubClientHandle);
 }
 
+IOTHUB_CLIENT_RESULT IoTHubDeviceClient_LL_GetPollInfo(IOTHUB_DEVICE_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_POLL_INFO* pollInfo)
+{
+    return IoTHubClientCore_LL_GetPollInfo((IOTHUB_CLIENT_CORE_LL_HANDLE)iotHubClientHandle, pollInfo);
+}
+
 IOTHUB_CLIENT_RESULT IoTHubDeviceClient_LL_SetOption(IOTHUB_DEVICE_CLIENT_LL_HANDLE iotHubClientHandle, const char* optionName, const void* value)
 {
     return IoTHubClientCore_LL_SetOption((IOTHUB_CLIENT_CORE_LL_HANDLE)iotHubClientHandle, optionName, value);
@@ -192,3 +197,13 @@ IOTHUB_CLIENT_RESULT IoTHubDeviceClient_LL_GetPropertiesAndSubscribeToUpdatesAsy
 {
     return IoTHubClientCore_LL_SetDeviceTwinCallback((IOTHUB_CLIENT_CORE_LL_HANDLE)iotHubClientHandle, (IOTHUB_CLIENT_DEVICE_TWIN_CALLBACK)propertiesCallback, userContextCallback);
 }
+
+IOTHUB_CLIENT_RESULT IoTHubDeviceClient_LL_GetCachedProperty(IOTHUB_DEVICE_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_PROPERTY_TYPE propertyType, const char* componentName, const char* propertyName, IOTHUB_CLIENT_PROPERTY_PARSED* property, bool* propertySpecified)
+{
+    return IoTHubClientCore_LL_GetCachedProperty((IOTHUB_CLIENT_CORE_LL_HANDLE)iotHubClientHandle, propertyType, componentName, propertyName, property, propertySpecified);
+}
+
+IOTHUB_CLIENT_RESULT IoTHubDeviceClient_LL_GetMetrics(IOTHUB_DEVICE_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_METRICS* metrics)
+{
+    return IoTHubClientCore_LL_GetMetrics((IOTHUB_CLIENT_CORE_LL_HANDLE)iotHubClientHandle, metrics);
+}
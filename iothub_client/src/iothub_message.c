@@ -2,10 +2,12 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #include <stdlib.h>
+#include <stdint.h>
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/buffer_.h"
+#include "azure_c_shared_utility/refcount.h"
 
 #include "iothub_message.h"
 #include "internal/iothub_message_private.h"
@@ -15,6 +17,30 @@ MU_DEFINE_ENUM_STRINGS_WITHOUT_INVALID(IOTHUBMESSAGE_CONTENT_TYPE, IOTHUBMESSAGE
 
 static const char* SECURITY_CLIENT_JSON_ENCODING = "application/json";
 
+#define PROPERTY_BLOCK_INITIAL_CAPACITY     256
+#define PROPERTY_ENTRY_ALIGNMENT            sizeof(uint32_t)
+#define PROPERTY_ENTRY_ALIGN(size)          (((size) + PROPERTY_ENTRY_ALIGNMENT - 1) & ~(PROPERTY_ENTRY_ALIGNMENT - 1))
+
+// The application properties of a message, back to back in one buffer.  Each entry is a PROPERTY_ENTRY followed by
+// the key and the value, both NUL-terminated, padded to PROPERTY_ENTRY_ALIGNMENT.  Keys and values are checked to be
+// US-ASCII once, when they are set; a clone shares the block (and that check) until one of the messages writes to it.
+typedef struct PROPERTY_BLOCK_TAG
+{
+    size_t count;
+    size_t used;
+    size_t capacity;
+    unsigned char* entries;
+} PROPERTY_BLOCK;
+
+DEFINE_REFCOUNT_TYPE(PROPERTY_BLOCK);
+
+typedef struct PROPERTY_ENTRY_TAG
+{
+    uint32_t size;
+    uint32_t keyLength;
+    uint32_t valueLength;
+} PROPERTY_ENTRY;
+
 typedef struct IOTHUB_MESSAGE_HANDLE_DATA_TAG
 {
     IOTHUBMESSAGE_CONTENT_TYPE contentType;
@@ -23,7 +49,15 @@ typedef struct IOTHUB_MESSAGE_HANDLE_DATA_TAG
         BUFFER_HANDLE byteArray;
         STRING_HANDLE string;
     } value;
-    MAP_HANDLE properties;
+    // The properties are kept in propertyBlock until IoTHubMessage_Properties is called.  The caller may change the
+    // MAP_HANDLE it returns, so from then on the properties live in propertyMap instead.
+    PROPERTY_BLOCK* propertyBlock;
+    // Once a key or value of propertyBlock has been handed out, the block is not changed or freed again before
+    // IoTHubMessage_Destroy: it is kept in lentPropertyBlocks when the message moves on to another one.
+    bool isPropertyBlockLent;
+    PROPERTY_BLOCK** lentPropertyBlocks;
+    size_t lentPropertyBlockCount;
+    MAP_HANDLE propertyMap;
     char* messageId;
     char* correlationId;
     char* userDefinedContentType;
@@ -32,7 +66,12 @@ typedef struct IOTHUB_MESSAGE_HANDLE_DATA_TAG
     char* inputName;
     char* connectionModuleId;
     char* connectionDeviceId;
+    // diagnosticData is NULL, or points at diagnosticDataStorage whose strings are the two buffers below: sampled
+    // messages carry their diagnostic properties without any allocation.
     IOTHUB_MESSAGE_DIAGNOSTIC_PROPERTY_DATA_HANDLE diagnosticData;
+    IOTHUB_MESSAGE_DIAGNOSTIC_PROPERTY_DATA diagnosticDataStorage;
+    char diagnosticId[IOTHUB_MESSAGE_DIAGNOSTIC_ID_MAX_LENGTH + 1];
+    char diagnosticCreationTimeUtc[IOTHUB_MESSAGE_DIAGNOSTIC_CREATION_TIME_MAX_LENGTH + 1];
     bool is_security_message;
     char* creationTimeUtc;
     char* userId;
@@ -73,14 +112,241 @@ static int ValidateAsciiCharactersFilter(const char* mapKey, const char* mapValu
     return result;
 }
 
-static void DestroyDiagnosticPropertyData(IOTHUB_MESSAGE_DIAGNOSTIC_PROPERTY_DATA_HANDLE diagnosticHandle)
+static PROPERTY_ENTRY* GetPropertyEntry(const PROPERTY_BLOCK* block, size_t offset)
+{
+    return (PROPERTY_ENTRY*)(block->entries + offset);
+}
+
+static char* GetPropertyEntryKey(PROPERTY_ENTRY* entry)
 {
-    if (diagnosticHandle != NULL)
+    return (char*)entry + sizeof(PROPERTY_ENTRY);
+}
+
+static char* GetPropertyEntryValue(PROPERTY_ENTRY* entry)
+{
+    return GetPropertyEntryKey(entry) + entry->keyLength + 1;
+}
+
+// Returns the offset of the entry for key, or block->used if there is none
+static size_t FindPropertyEntry(const PROPERTY_BLOCK* block, const char* key)
+{
+    size_t offset = 0;
+
+    while (offset < block->used && strcmp(GetPropertyEntryKey(GetPropertyEntry(block, offset)), key) != 0)
     {
-        free(diagnosticHandle->diagnosticId);
-        free(diagnosticHandle->diagnosticCreationTimeUtc);
+        offset += GetPropertyEntry(block, offset)->size;
+    }
+
+    return offset;
+}
+
+static bool IsPropertyBlockShared(PROPERTY_BLOCK* block)
+{
+    // Only a holder of the block can add a reference to it, so a count of 1 cannot go up while we look at it
+    return ((REFCOUNT_TYPE(PROPERTY_BLOCK)*)block)->count > 1;
+}
+
+static void ReleasePropertyBlock(PROPERTY_BLOCK* block)
+{
+    if (block != NULL && DEC_REF(PROPERTY_BLOCK, block) == DEC_RETURN_ZERO)
+    {
+        free(block->entries);
+        REFCOUNT_TYPE_DESTROY(PROPERTY_BLOCK, block);
+    }
+}
+
+// Makes newBlock (which may be NULL) the properties of the message.  The previous block is released, unless the
+// message handed out strings from it, in which case it is kept until IoTHubMessage_Destroy.
+static int ReplacePropertyBlock(IOTHUB_MESSAGE_HANDLE_DATA* handleData, PROPERTY_BLOCK* newBlock)
+{
+    int result;
+
+    if (handleData->propertyBlock != NULL && handleData->isPropertyBlockLent)
+    {
+        PROPERTY_BLOCK** lentBlocks = (PROPERTY_BLOCK**)realloc(handleData->lentPropertyBlocks, sizeof(PROPERTY_BLOCK*) * (handleData->lentPropertyBlockCount + 1));
+
+        if (lentBlocks == NULL)
+        {
+            LogError("Failed keeping the previous properties");
+            result = MU_FAILURE;
+        }
+        else
+        {
+            lentBlocks[handleData->lentPropertyBlockCount++] = handleData->propertyBlock;
+            handleData->lentPropertyBlocks = lentBlocks;
+            result = 0;
+        }
+    }
+    else
+    {
+        ReleasePropertyBlock(handleData->propertyBlock);
+        result = 0;
+    }
+
+    if (result == 0)
+    {
+        handleData->propertyBlock = newBlock;
+        handleData->isPropertyBlockLent = false;
+    }
+
+    return result;
+}
+
+// Makes sure the message has a block it may change in place, with room for extraSize more bytes of entries
+static int EnsureWritablePropertyBlock(IOTHUB_MESSAGE_HANDLE_DATA* handleData, size_t extraSize)
+{
+    int result;
+    PROPERTY_BLOCK* block = handleData->propertyBlock;
+    size_t used = (block == NULL) ? 0 : block->used;
+
+    if (block != NULL && !handleData->isPropertyBlockLent && !IsPropertyBlockShared(block))
+    {
+        if (used + extraSize <= block->capacity)
+        {
+            result = 0;
+        }
+        else
+        {
+            size_t capacity = (block->capacity * 2 < used + extraSize) ? used + extraSize : block->capacity * 2;
+            unsigned char* entries = (unsigned char*)realloc(block->entries, capacity);
+
+            if (entries == NULL)
+            {
+                LogError("Failed growing the properties to %lu bytes", (unsigned long)capacity);
+                result = MU_FAILURE;
+            }
+            else
+            {
+                block->entries = entries;
+                block->capacity = capacity;
+                result = 0;
+            }
+        }
     }
-    free(diagnosticHandle);
+    else
+    {
+        // First property, a block still shared with a clone or one whose strings were handed out: take a copy
+        size_t capacity = (used + extraSize < PROPERTY_BLOCK_INITIAL_CAPACITY) ? PROPERTY_BLOCK_INITIAL_CAPACITY : used + extraSize;
+        PROPERTY_BLOCK* copy;
+
+        if ((copy = REFCOUNT_TYPE_CREATE(PROPERTY_BLOCK)) == NULL)
+        {
+            LogError("Failed allocating the properties");
+            result = MU_FAILURE;
+        }
+        else if ((copy->entries = (unsigned char*)malloc(capacity)) == NULL)
+        {
+            LogError("Failed allocating %lu bytes of properties", (unsigned long)capacity);
+            REFCOUNT_TYPE_DESTROY(PROPERTY_BLOCK, copy);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            if (block != NULL)
+            {
+                (void)memcpy(copy->entries, block->entries, used);
+            }
+            copy->count = (block == NULL) ? 0 : block->count;
+            copy->used = used;
+            copy->capacity = capacity;
+
+            if (ReplacePropertyBlock(handleData, copy) != 0)
+            {
+                ReleasePropertyBlock(copy);
+                result = MU_FAILURE;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+static IOTHUB_MESSAGE_RESULT SetBlockProperty(IOTHUB_MESSAGE_HANDLE_DATA* handleData, const char* key, const char* value)
+{
+    IOTHUB_MESSAGE_RESULT result;
+    size_t keyLength = strlen(key);
+    size_t valueLength = strlen(value);
+    size_t entrySize = PROPERTY_ENTRY_ALIGN(sizeof(PROPERTY_ENTRY) + keyLength + 1 + valueLength + 1);
+    size_t offset = (handleData->propertyBlock == NULL) ? 0 : FindPropertyEntry(handleData->propertyBlock, key);
+    size_t existingSize = (handleData->propertyBlock == NULL || offset == handleData->propertyBlock->used) ? 0 : GetPropertyEntry(handleData->propertyBlock, offset)->size;
+
+    if (!ContainsValidUsAscii(key) || !ContainsValidUsAscii(value))
+    {
+        LogError("Failure validating property as ASCII");
+        result = IOTHUB_MESSAGE_INVALID_TYPE;
+    }
+    else if (entrySize > UINT32_MAX)
+    {
+        LogError("Property %s is too large", key);
+        result = IOTHUB_MESSAGE_INVALID_ARG;
+    }
+    // key and value can only point into the block if it was lent, and a lent block is copied, not changed
+    else if (EnsureWritablePropertyBlock(handleData, (entrySize > existingSize) ? entrySize - existingSize : 0) != 0)
+    {
+        result = IOTHUB_MESSAGE_ERROR;
+    }
+    else
+    {
+        PROPERTY_BLOCK* block = handleData->propertyBlock;
+        PROPERTY_ENTRY* entry;
+
+        if (existingSize != 0)
+        {
+            // Updated in place, so the properties keep the order they were first set in
+            (void)memmove(block->entries + offset + entrySize, block->entries + offset + existingSize, block->used - offset - existingSize);
+            block->used = block->used - existingSize + entrySize;
+        }
+        else
+        {
+            offset = block->used;
+            block->used += entrySize;
+            block->count++;
+        }
+
+        entry = GetPropertyEntry(block, offset);
+        entry->size = (uint32_t)entrySize;
+        entry->keyLength = (uint32_t)keyLength;
+        entry->valueLength = (uint32_t)valueLength;
+        (void)memcpy(GetPropertyEntryKey(entry), key, keyLength + 1);
+        (void)memcpy(GetPropertyEntryValue(entry), value, valueLength + 1);
+        result = IOTHUB_MESSAGE_OK;
+    }
+
+    return result;
+}
+
+// Backs IoTHubMessage_Properties: the properties move to a MAP_HANDLE the caller can change
+static MAP_HANDLE CreatePropertyMap(const PROPERTY_BLOCK* block)
+{
+    MAP_HANDLE result;
+
+    if ((result = Map_Create(ValidateAsciiCharactersFilter)) == NULL)
+    {
+        LogError("Map_Create for properties failed");
+    }
+    else if (block != NULL)
+    {
+        size_t offset;
+
+        for (offset = 0; offset < block->used; offset += GetPropertyEntry(block, offset)->size)
+        {
+            PROPERTY_ENTRY* entry = GetPropertyEntry(block, offset);
+
+            if (Map_AddOrUpdate(result, GetPropertyEntryKey(entry), GetPropertyEntryValue(entry)) != MAP_OK)
+            {
+                LogError("Failure adding property to internal map");
+                Map_Destroy(result);
+                result = NULL;
+                break;
+            }
+        }
+    }
+
+    return result;
 }
 
 static void DestroyMessageData(IOTHUB_MESSAGE_HANDLE_DATA* handleData)
@@ -94,14 +360,22 @@ static void DestroyMessageData(IOTHUB_MESSAGE_HANDLE_DATA* handleData)
         STRING_delete(handleData->value.string);
     }
 
-    Map_Destroy(handleData->properties);
+    ReleasePropertyBlock(handleData->propertyBlock);
+    while (handleData->lentPropertyBlockCount > 0)
+    {
+        ReleasePropertyBlock(handleData->lentPropertyBlocks[--handleData->lentPropertyBlockCount]);
+    }
+    free(handleData->lentPropertyBlocks);
+    if (handleData->propertyMap != NULL)
+    {
+        Map_Destroy(handleData->propertyMap);
+    }
     free(handleData->messageId);
     handleData->messageId = NULL;
     free(handleData->correlationId);
     handleData->correlationId = NULL;
     free(handleData->userDefinedContentType);
     free(handleData->contentEncoding);
-    DestroyDiagnosticPropertyData(handleData->diagnosticData);
     free(handleData->outputName);
     free(handleData->inputName);
     free(handleData->connectionModuleId);
@@ -188,39 +462,28 @@ static int set_message_user_id(IOTHUB_MESSAGE_HANDLE_DATA* handleData, const cha
     return result;
 }
 
-static IOTHUB_MESSAGE_DIAGNOSTIC_PROPERTY_DATA_HANDLE CloneDiagnosticPropertyData(const IOTHUB_MESSAGE_DIAGNOSTIC_PROPERTY_DATA* source)
+static int StoreDiagnosticPropertyData(IOTHUB_MESSAGE_HANDLE_DATA* handleData, const IOTHUB_MESSAGE_DIAGNOSTIC_PROPERTY_DATA* source)
 {
-    IOTHUB_MESSAGE_DIAGNOSTIC_PROPERTY_DATA_HANDLE result = NULL;
-    if (source == NULL)
+    int result;
+    size_t idLength = strlen(source->diagnosticId);
+    size_t creationTimeLength = strlen(source->diagnosticCreationTimeUtc);
+
+    if (idLength > IOTHUB_MESSAGE_DIAGNOSTIC_ID_MAX_LENGTH || creationTimeLength > IOTHUB_MESSAGE_DIAGNOSTIC_CREATION_TIME_MAX_LENGTH)
     {
-        LogError("Invalid argument - source is NULL");
+        LogError("Diagnostic data too long (diagnosticId length=%lu, diagnosticCreationTimeUtc length=%lu)",
+            (unsigned long)idLength, (unsigned long)creationTimeLength);
+        result = MU_FAILURE;
     }
     else
     {
-        result = (IOTHUB_MESSAGE_DIAGNOSTIC_PROPERTY_DATA_HANDLE)malloc(sizeof(IOTHUB_MESSAGE_DIAGNOSTIC_PROPERTY_DATA));
-        if (result == NULL)
-        {
-            LogError("malloc failed");
-        }
-        else
-        {
-            result->diagnosticCreationTimeUtc = NULL;
-            result->diagnosticId = NULL;
-            if (source->diagnosticCreationTimeUtc != NULL && mallocAndStrcpy_s(&result->diagnosticCreationTimeUtc, source->diagnosticCreationTimeUtc) != 0)
-            {
-                LogError("mallocAndStrcpy_s for diagnosticCreationTimeUtc failed");
-                free(result);
-                result = NULL;
-            }
-            else if (source->diagnosticId != NULL && mallocAndStrcpy_s(&result->diagnosticId, source->diagnosticId) != 0)
-            {
-                LogError("mallocAndStrcpy_s for diagnosticId failed");
-                free(result->diagnosticCreationTimeUtc);
-                free(result);
-                result = NULL;
-            }
-        }
+        (void)memcpy(handleData->diagnosticId, source->diagnosticId, idLength + 1);
+        (void)memcpy(handleData->diagnosticCreationTimeUtc, source->diagnosticCreationTimeUtc, creationTimeLength + 1);
+        handleData->diagnosticDataStorage.diagnosticId = handleData->diagnosticId;
+        handleData->diagnosticDataStorage.diagnosticCreationTimeUtc = handleData->diagnosticCreationTimeUtc;
+        handleData->diagnosticData = &handleData->diagnosticDataStorage;
+        result = 0;
     }
+
     return result;
 }
 
@@ -274,12 +537,6 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromByteArray(const unsigned char* byt
                     DestroyMessageData(result);
                     result = NULL;
                 }
-                else if ((result->properties = Map_Create(ValidateAsciiCharactersFilter)) == NULL)
-                {
-                    LogError("Map_Create for properties failed");
-                    DestroyMessageData(result);
-                    result = NULL;
-                }
             }
         }
     }
@@ -313,12 +570,6 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromString(const char* source)
                 DestroyMessageData(result);
                 result = NULL;
             }
-            else if ((result->properties = Map_Create(ValidateAsciiCharactersFilter)) == NULL)
-            {
-                LogError("Map_Create for properties failed");
-                DestroyMessageData(result);
-                result = NULL;
-            }
         }
     }
     return result;
@@ -327,7 +578,7 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromString(const char* source)
 IOTHUB_MESSAGE_HANDLE IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
 {
     IOTHUB_MESSAGE_HANDLE_DATA* result;
-    const IOTHUB_MESSAGE_HANDLE_DATA* source = (const IOTHUB_MESSAGE_HANDLE_DATA*)iotHubMessageHandle;
+    IOTHUB_MESSAGE_HANDLE_DATA* source = (IOTHUB_MESSAGE_HANDLE_DATA*)iotHubMessageHandle;
     if (source == NULL)
     {
         result = NULL;
@@ -347,6 +598,13 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMessageHan
             result->contentType = source->contentType;
             result->is_security_message = source->is_security_message;
 
+            if (source->propertyBlock != NULL)
+            {
+                // Shared until either message sets a property
+                INC_REF(PROPERTY_BLOCK, source->propertyBlock);
+                result->propertyBlock = source->propertyBlock;
+            }
+
             if (source->messageId != NULL && mallocAndStrcpy_s(&result->messageId, source->messageId) != 0)
             {
                 LogError("unable to Copy messageId");
@@ -371,9 +629,9 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMessageHan
                 DestroyMessageData(result);
                 result = NULL;
             }
-            else if (source->diagnosticData != NULL && (result->diagnosticData = CloneDiagnosticPropertyData(source->diagnosticData)) == NULL)
+            else if (source->diagnosticData != NULL && StoreDiagnosticPropertyData(result, source->diagnosticData) != 0)
             {
-                LogError("unable to copy CloneDiagnosticPropertyData");
+                LogError("unable to copy diagnosticData");
                 DestroyMessageData(result);
                 result = NULL;
             }
@@ -427,7 +685,7 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMessageHan
                     DestroyMessageData(result);
                     result = NULL;
                 }
-                else if ((result->properties = Map_Clone(source->properties)) == NULL)
+                else if (source->propertyMap != NULL && (result->propertyMap = Map_Clone(source->propertyMap)) == NULL)
                 {
                     LogError("unable to Map_Clone");
                     DestroyMessageData(result);
@@ -442,7 +700,7 @@ IOTHUB_MESSAGE_HANDLE IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMessageHan
                     DestroyMessageData(result);
                     result = NULL;
                 }
-                else if ((result->properties = Map_Clone(source->properties)) == NULL)
+                else if (source->propertyMap != NULL && (result->propertyMap = Map_Clone(source->propertyMap)) == NULL)
                 {
                     LogError("unable to Map_Clone");
                     DestroyMessageData(result);
@@ -532,7 +790,16 @@ MAP_HANDLE IoTHubMessage_Properties(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
     else
     {
         IOTHUB_MESSAGE_HANDLE_DATA* handleData = (IOTHUB_MESSAGE_HANDLE_DATA*)iotHubMessageHandle;
-        result = handleData->properties;
+        if (handleData->propertyMap == NULL)
+        {
+            if ((handleData->propertyMap = CreatePropertyMap(handleData->propertyBlock)) != NULL &&
+                ReplacePropertyBlock(handleData, NULL) != 0)
+            {
+                Map_Destroy(handleData->propertyMap);
+                handleData->propertyMap = NULL;
+            }
+        }
+        result = handleData->propertyMap;
     }
     return result;
 }
@@ -545,9 +812,13 @@ IOTHUB_MESSAGE_RESULT IoTHubMessage_SetProperty(IOTHUB_MESSAGE_HANDLE msg_handle
         LogError("invalid parameter (NULL) to IoTHubMessage_SetProperty iotHubMessageHandle=%p, key=%p, value=%p", msg_handle, key, value);
         result = IOTHUB_MESSAGE_INVALID_ARG;
     }
+    else if (msg_handle->propertyMap == NULL)
+    {
+        result = SetBlockProperty(msg_handle, key, value);
+    }
     else
     {
-        MAP_RESULT map_result = Map_AddOrUpdate(msg_handle->properties, key, value);
+        MAP_RESULT map_result = Map_AddOrUpdate(msg_handle->propertyMap, key, value);
         if (map_result == MAP_FILTER_REJECT)
         {
             LogError("Failure validating property as ASCII");
@@ -574,13 +845,27 @@ const char* IoTHubMessage_GetProperty(IOTHUB_MESSAGE_HANDLE msg_handle, const ch
         LogError("invalid parameter (NULL) to IoTHubMessage_GetProperty iotHubMessageHandle=%p, key=%p", msg_handle, key);
         result = NULL;
     }
+    else if (msg_handle->propertyMap == NULL)
+    {
+        size_t offset;
+
+        if (msg_handle->propertyBlock == NULL || (offset = FindPropertyEntry(msg_handle->propertyBlock, key)) == msg_handle->propertyBlock->used)
+        {
+            result = NULL;
+        }
+        else
+        {
+            result = GetPropertyEntryValue(GetPropertyEntry(msg_handle->propertyBlock, offset));
+            msg_handle->isPropertyBlockLent = true;
+        }
+    }
     else
     {
         bool key_exists = false;
         // The return value is not necessary, just check the key_exist variable
-        if ((Map_ContainsKey(msg_handle->properties, key, &key_exists) == MAP_OK) && key_exists)
+        if ((Map_ContainsKey(msg_handle->propertyMap, key, &key_exists) == MAP_OK) && key_exists)
         {
-            result = Map_GetValueFromKey(msg_handle->properties, key);
+            result = Map_GetValueFromKey(msg_handle->propertyMap, key);
         }
         else
         {
@@ -590,6 +875,93 @@ const char* IoTHubMessage_GetProperty(IOTHUB_MESSAGE_HANDLE msg_handle, const ch
     return result;
 }
 
+IOTHUB_MESSAGE_RESULT IoTHubMessage_GetPropertyCount(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, size_t* count)
+{
+    IOTHUB_MESSAGE_RESULT result;
+    if (iotHubMessageHandle == NULL || count == NULL)
+    {
+        LogError("invalid parameter (NULL) to IoTHubMessage_GetPropertyCount iotHubMessageHandle=%p, count=%p", iotHubMessageHandle, count);
+        result = IOTHUB_MESSAGE_INVALID_ARG;
+    }
+    else if (iotHubMessageHandle->propertyMap == NULL)
+    {
+        *count = (iotHubMessageHandle->propertyBlock == NULL) ? 0 : iotHubMessageHandle->propertyBlock->count;
+        result = IOTHUB_MESSAGE_OK;
+    }
+    else
+    {
+        const char* const* keys;
+        const char* const* values;
+
+        if (Map_GetInternals(iotHubMessageHandle->propertyMap, &keys, &values, count) != MAP_OK)
+        {
+            LogError("Failed to get the internals of the property map.");
+            result = IOTHUB_MESSAGE_ERROR;
+        }
+        else
+        {
+            result = IOTHUB_MESSAGE_OK;
+        }
+    }
+    return result;
+}
+
+IOTHUB_MESSAGE_RESULT IoTHubMessage_GetNextProperty(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, size_t* cursor, const char** key, const char** value)
+{
+    IOTHUB_MESSAGE_RESULT result;
+    if (iotHubMessageHandle == NULL || cursor == NULL || key == NULL || value == NULL)
+    {
+        LogError("invalid parameter (NULL) to IoTHubMessage_GetNextProperty iotHubMessageHandle=%p, cursor=%p, key=%p, value=%p", iotHubMessageHandle, cursor, key, value);
+        result = IOTHUB_MESSAGE_INVALID_ARG;
+    }
+    else if (iotHubMessageHandle->propertyMap == NULL)
+    {
+        // The cursor is the offset of the next entry in the block
+        const PROPERTY_BLOCK* block = iotHubMessageHandle->propertyBlock;
+
+        if (block == NULL || *cursor >= block->used)
+        {
+            LogError("No property past the last one");
+            result = IOTHUB_MESSAGE_INVALID_ARG;
+        }
+        else
+        {
+            PROPERTY_ENTRY* entry = GetPropertyEntry(block, *cursor);
+            *key = GetPropertyEntryKey(entry);
+            *value = GetPropertyEntryValue(entry);
+            *cursor += entry->size;
+            iotHubMessageHandle->isPropertyBlockLent = true;
+            result = IOTHUB_MESSAGE_OK;
+        }
+    }
+    else
+    {
+        // The cursor is the index of the next key in the map
+        const char* const* keys;
+        const char* const* values;
+        size_t count;
+
+        if (Map_GetInternals(iotHubMessageHandle->propertyMap, &keys, &values, &count) != MAP_OK)
+        {
+            LogError("Failed to get the internals of the property map.");
+            result = IOTHUB_MESSAGE_ERROR;
+        }
+        else if (*cursor >= count)
+        {
+            LogError("No property past the last one");
+            result = IOTHUB_MESSAGE_INVALID_ARG;
+        }
+        else
+        {
+            *key = keys[*cursor];
+            *value = values[*cursor];
+            (*cursor)++;
+            result = IOTHUB_MESSAGE_OK;
+        }
+    }
+    return result;
+}
+
 const char* IoTHubMessage_GetCorrelationId(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
 {
     const char* result;
@@ -890,16 +1262,10 @@ IOTHUB_MESSAGE_RESULT IoTHubMessage_SetDiagnosticPropertyData(IOTHUB_MESSAGE_HAN
     }
     else
     {
-        if (iotHubMessageHandle->diagnosticData != NULL)
-        {
-            DestroyDiagnosticPropertyData(iotHubMessageHandle->diagnosticData);
-            iotHubMessageHandle->diagnosticData = NULL;
-        }
-
-        if ((iotHubMessageHandle->diagnosticData = CloneDiagnosticPropertyData(diagnosticData)) == NULL)
+        if (StoreDiagnosticPropertyData(iotHubMessageHandle, diagnosticData) != 0)
         {
             LogError("Failed saving a copy of diagnosticData");
-            result = IOTHUB_MESSAGE_ERROR;
+            result = IOTHUB_MESSAGE_INVALID_ARG;
         }
         else
         {
@@ -1238,3 +1604,31 @@ IOTHUB_MESSAGE_RESULT IoTHubMessage_GetDispositionContext(IOTHUB_MESSAGE_HANDLE
 
     return result;
 }
+
+IOTHUB_MESSAGE_RESULT IoTHubMessage_SetBody(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, BUFFER_HANDLE body)
+{
+    IOTHUB_MESSAGE_RESULT result;
+
+    if (iotHubMessageHandle == NULL || body == NULL)
+    {
+        LogError("Invalid argument (iotHubMessageHandle=%p, body=%p)", iotHubMessageHandle, body);
+        result = IOTHUB_MESSAGE_INVALID_ARG;
+    }
+    else
+    {
+        if (iotHubMessageHandle->contentType == IOTHUBMESSAGE_BYTEARRAY)
+        {
+            BUFFER_delete(iotHubMessageHandle->value.byteArray);
+        }
+        else if (iotHubMessageHandle->contentType == IOTHUBMESSAGE_STRING)
+        {
+            STRING_delete(iotHubMessageHandle->value.string);
+        }
+
+        iotHubMessageHandle->contentType = IOTHUBMESSAGE_BYTEARRAY;
+        iotHubMessageHandle->value.byteArray = body;
+        result = IOTHUB_MESSAGE_OK;
+    }
+
+    return result;
+}
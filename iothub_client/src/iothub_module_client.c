@@ -155,3 +155,13 @@ IOTHUB_CLIENT_RESULT IoTHubModuleClient_GetPropertiesAndSubscribeToUpdatesAsync(
 {
     return IoTHubClientCore_SetDeviceTwinCallback((IOTHUB_CLIENT_CORE_HANDLE)iotHubModuleClientHandle, (IOTHUB_CLIENT_DEVICE_TWIN_CALLBACK)propertiesCallback, userContextCallback);
 }
+
+IOTHUB_CLIENT_RESULT IoTHubModuleClient_GetCallbackQueueStatistics(IOTHUB_MODULE_CLIENT_HANDLE iotHubModuleClientHandle, IOTHUB_CLIENT_CALLBACK_QUEUE_STATISTICS* statistics)
+{
+    return IoTHubClientCore_GetCallbackQueueStatistics((IOTHUB_CLIENT_CORE_HANDLE)iotHubModuleClientHandle, statistics);
+}
+
+IOTHUB_CLIENT_RESULT IoTHubModuleClient_GetMetrics(IOTHUB_MODULE_CLIENT_HANDLE iotHubModuleClientHandle, IOTHUB_CLIENT_METRICS* metrics)
+{
+    return IoTHubClientCore_GetMetrics((IOTHUB_CLIENT_CORE_HANDLE)iotHubModuleClientHandle, metrics);
+}
@@ -186,6 +186,21 @@ void IoTHubModuleClient_LL_DoWork(IOTHUB_MODULE_CLIENT_LL_HANDLE iotHubModuleCli
     }
 }
 
+IOTHUB_CLIENT_RESULT IoTHubModuleClient_LL_GetPollInfo(IOTHUB_MODULE_CLIENT_LL_HANDLE iotHubModuleClientHandle, IOTHUB_CLIENT_POLL_INFO* pollInfo)
+{
+    IOTHUB_CLIENT_RESULT result;
+    if (iotHubModuleClientHandle != NULL)
+    {
+        result = IoTHubClientCore_LL_GetPollInfo(iotHubModuleClientHandle->coreHandle, pollInfo);
+    }
+    else
+    {
+        LogError("iotHubModuleClientHandle parameter cannot be NULL");
+        result = IOTHUB_CLIENT_INVALID_ARG;
+    }
+    return result;
+}
+
 IOTHUB_CLIENT_RESULT IoTHubModuleClient_LL_SetOption(IOTHUB_MODULE_CLIENT_LL_HANDLE iotHubModuleClientHandle, const char* optionName, const void* value)
 {
     IOTHUB_CLIENT_RESULT result;
@@ -444,3 +459,33 @@ IOTHUB_CLIENT_RESULT IoTHubModuleClient_LL_GetPropertiesAndSubscribeToUpdatesAsy
     }
     return result;
 }
+
+IOTHUB_CLIENT_RESULT IoTHubModuleClient_LL_GetCachedProperty(IOTHUB_MODULE_CLIENT_LL_HANDLE iotHubModuleClientHandle, IOTHUB_CLIENT_PROPERTY_TYPE propertyType, const char* componentName, const char* propertyName, IOTHUB_CLIENT_PROPERTY_PARSED* property, bool* propertySpecified)
+{
+    IOTHUB_CLIENT_RESULT result;
+    if (iotHubModuleClientHandle != NULL)
+    {
+        result = IoTHubClientCore_LL_GetCachedProperty(iotHubModuleClientHandle->coreHandle, propertyType, componentName, propertyName, property, propertySpecified);
+    }
+    else
+    {
+        LogError("iotHubModuleClientHandle parameter cannot be NULL");
+        result = IOTHUB_CLIENT_INVALID_ARG;
+    }
+    return result;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubModuleClient_LL_GetMetrics(IOTHUB_MODULE_CLIENT_LL_HANDLE iotHubModuleClientHandle, IOTHUB_CLIENT_METRICS* metrics)
+{
+    IOTHUB_CLIENT_RESULT result;
+    if (iotHubModuleClientHandle != NULL)
+    {
+        result = IoTHubClientCore_LL_GetMetrics(iotHubModuleClientHandle->coreHandle, metrics);
+    }
+    else
+    {
+        LogError("iotHubModuleClientHandle parameter cannot be NULL");
+        result = IOTHUB_CLIENT_INVALID_ARG;
+    }
+    return result;
+}
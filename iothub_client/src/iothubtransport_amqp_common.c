@@ -2,6 +2,7 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #include <stdlib.h>
+#include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <time.h>
@@ -39,6 +40,7 @@
 #include "internal/iothubtransport.h"
 #include "iothub_client_version.h"
 #include "internal/iothub_transport_ll_private.h"
+#include "internal/iothub_client_tracing_private.h"
 
 
 #define RESULT_OK                                 0
@@ -968,6 +970,14 @@ static void on_event_send_complete(IOTHUB_MESSAGE_LIST* message, D2C_EVENT_SEND_
         registered_device->is_quota_exceeded = true;
     }
 
+    // Events are confirmed here rather than through send_complete_cb, so they are also counted here
+    METRICS_HANDLE metrics = registered_device->transport_callbacks.get_metrics_cb(registered_device->transport_ctx);
+    if (metrics != NULL)
+    {
+        metrics_record_send_complete(metrics, get_iothub_client_confirmation_result_from(result), message->ms_enqueued);
+    }
+    IOTHUB_CLIENT_TRACE_COMPLETE(message, get_iothub_client_confirmation_result_from(result));
+
     if (message->callback != NULL)
     {
         IOTHUB_CLIENT_CONFIRMATION_RESULT iothub_send_result = get_iothub_client_confirmation_result_from(result);
@@ -979,6 +989,24 @@ static void on_event_send_complete(IOTHUB_MESSAGE_LIST* message, D2C_EVENT_SEND_
     free(message);
 }
 
+static size_t get_message_body_size(IOTHUB_MESSAGE_HANDLE message)
+{
+    size_t result;
+    const unsigned char* body;
+
+    if (IoTHubMessage_GetContentType(message) == IOTHUBMESSAGE_STRING)
+    {
+        const char* string = IoTHubMessage_GetString(message);
+        result = (string == NULL) ? 0 : strlen(string);
+    }
+    else if (IoTHubMessage_GetByteArray(message, &body, &result) != IOTHUB_MESSAGE_OK)
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
 // @brief
 //     Gets events from wait to send list and sends to service in the order they were added.
 // @returns
@@ -987,12 +1015,25 @@ static int send_pending_events(AMQP_TRANSPORT_DEVICE_INSTANCE* device_state)
 {
     int result;
     IOTHUB_MESSAGE_LIST* message;
+    METRICS_HANDLE metrics = device_state->transport_callbacks.get_metrics_cb(device_state->transport_ctx);
 
     result = RESULT_OK;
 
     while ((message = get_next_event_to_send(device_state)) != NULL)
     {
-        if (amqp_device_send_event_async(device_state->device_handle, message, on_event_send_complete, device_state) != RESULT_OK)
+        // Measured up front, since a failed send completes (and frees) the message
+        size_t body_size = (metrics != NULL) ? get_message_body_size(message->messageHandle) : 0;
+
+        IOTHUB_CLIENT_TRACE(IOTHUB_CLIENT_TRACE_DEQUEUED, message);
+        if (amqp_device_send_event_async(device_state->device_handle, message, on_event_send_complete, device_state) == RESULT_OK)
+        {
+            if (metrics != NULL)
+            {
+                metrics_add(metrics, METRICS_MESSAGES_SENT, 1);
+                metrics_add(metrics, METRICS_BYTES_SENT, body_size);
+            }
+        }
+        else
         {
             const char* device_id = STRING_c_str(device_state->device_id); // advoid MU_P_OR_NULL double call
             LogError("Device '%s' failed to send message (amqp_device_send_event_async failed)", MU_P_OR_NULL(device_id));
@@ -1346,6 +1387,7 @@ TRANSPORT_LL_HANDLE IoTHubTransport_AMQP_Common_Create(const IOTHUBTRANSPORT_CON
                 instance->transport_callbacks.twin_rpt_state_complete_cb = cb_info->twin_rpt_state_complete_cb;
                 instance->transport_callbacks.twin_retrieve_prop_complete_cb = cb_info->twin_retrieve_prop_complete_cb;
                 instance->transport_callbacks.method_complete_cb = cb_info->method_complete_cb;
+                instance->transport_callbacks.get_metrics_cb = cb_info->get_metrics_cb;
 
                 result = (TRANSPORT_LL_HANDLE)instance;
             }
@@ -1443,6 +1485,12 @@ void IoTHubTransport_AMQP_Common_DoWork(TRANSPORT_LL_HANDLE handle)
 
             if (retry_action == RETRY_ACTION_RETRY_NOW)
             {
+                METRICS_HANDLE metrics = transport_instance->transport_callbacks.get_metrics_cb(transport_instance->transport_ctx);
+                if (metrics != NULL)
+                {
+                    metrics_add(metrics, METRICS_RECONNECT_ATTEMPTS, 1);
+                }
+
                 prepare_for_connection_retry(transport_instance);
             }
             else if (retry_action == RETRY_ACTION_STOP_RETRYING)
@@ -18,6 +18,7 @@
 #include "azure_uamqp_c/message_receiver.h"
 #include "internal/uamqp_messaging.h"
 #include "internal/iothub_client_private.h"
+#include "internal/iothub_client_tracing_private.h"
 #include "iothub_client_version.h"
 #include "internal/iothubtransport_amqp_telemetry_messenger.h"
 
@@ -964,6 +965,17 @@ static void invoke_callback(const void* item, const void* action_context, bool*
     *continue_processing = true;
 }
 
+#ifdef USE_TRACING
+static void trace_event_written(const void* item, const void* action_context, bool* continue_processing)
+{
+    MESSENGER_SEND_EVENT_CALLER_INFORMATION *caller_info = (MESSENGER_SEND_EVENT_CALLER_INFORMATION*)item;
+    (void)action_context;
+
+    IOTHUB_CLIENT_TRACE(IOTHUB_CLIENT_TRACE_WRITTEN, caller_info->message);
+    *continue_processing = true;
+}
+#endif
+
 static void internal_on_event_send_complete_callback(void* context, MESSAGE_SEND_RESULT send_result, AMQP_VALUE delivery_state)
 {
     if (context != NULL)
@@ -1125,6 +1137,9 @@ static int send_batched_message_and_reset_state(TELEMETRY_MESSENGER_INSTANCE* in
     else
     {
         send_pending_events_state->task->send_time = get_time(NULL);
+#ifdef USE_TRACING
+        (void)singlylinkedlist_foreach(send_pending_events_state->task->callback_list, trace_event_written, NULL);
+#endif
         result = RESULT_OK;
     }
 
@@ -28,6 +28,7 @@
 #include "internal/iothubtransport.h"
 #include "internal/iothub_internal_consts.h"
 #include "internal/iothub_message_private.h"
+#include "internal/iothub_client_tracing_private.h"
 
 #include "azure_umqtt_c/mqtt_client.h"
 
@@ -64,6 +65,10 @@
 #define TWIN_REPORT_UPDATE_TIMEOUT_SECS           (60*5)
 #define MESSAGE_REPUBLISH_TIMEOUT_SECS             3
 
+// Reported by GetPollInfo while DoWork drives the connection, since the IO does not tell when bytes arrive
+#define POLL_INFO_HANDSHAKE_INTERVAL_MS            10
+#define POLL_INFO_RECONNECT_INTERVAL_MS            1000
+
 static const char TOPIC_DEVICE_TWIN_PREFIX[] = "$iothub/twin";
 static const char TOPIC_DEVICE_METHOD_PREFIX[] = "$iothub/methods";
 
@@ -107,6 +112,8 @@ static size_t REQUEST_ID_PROPERTY_LEN = sizeof(REQUEST_ID_PROPERTY) - 1;
 #define SYS_PROP_TO "to"
 #define SYS_COMPONENT_NAME "sub"
 
+static const char SYS_DIAGNOSTIC_CONTEXT_STRING_FORMAT[] = "%s%%24." SYS_PROP_DIAGNOSTIC_CONTEXT "=%s%%3D%s";
+
 static const char* DIAGNOSTIC_CONTEXT_CREATION_TIME_UTC_PROPERTY = "creationtimeutc";
 static const char DT_MODEL_ID_TOKEN[] = "model-id";
 static const char DEFAULT_IOTHUB_PRODUCT_IDENTIFIER[] = CLIENT_DEVICE_TYPE_PREFIX "/" IOTHUB_SDK_VERSION;
@@ -127,7 +134,7 @@ MU_DEFINE_ENUM_STRINGS_WITHOUT_INVALID(MQTT_CLIENT_EVENT_ERROR, MQTT_CLIENT_EVEN
 // we will pass into application callback.
 typedef enum IOTHUB_SYSTEM_PROPERTY_TYPE_TAG
 {
-    // Property that the application custom defined and will go into the propertyMap of IOTHUB_MESSAGE_HANDLE
+    // Property that the application custom defined and will go into the application properties of IOTHUB_MESSAGE_HANDLE
     IOTHUB_SYSTEM_PROPERTY_TYPE_APPLICATION_CUSTOM,
     // A "system" property we should silently ignore.  There are many %24.<property> that previous versions of the
     // SDK parsed out but did NOT add to the application custom list.  To maintain backward compat, and because
@@ -313,6 +320,10 @@ typedef struct MQTT_MESSAGE_DETAILS_LIST_TAG
     IOTHUB_MESSAGE_LIST* iotHubMessageEntry;
     void* context;
     uint16_t packet_id;
+    // The PUBLISH as first sent (topic with properties, payload referenced in place), kept for retransmits
+    MQTT_MESSAGE_HANDLE mqttMessage;
+    // Topic of mqttMessage, which only references it; released with the entry
+    STRING_HANDLE mqttTopic;
     DLIST_ENTRY entry;
 } MQTT_MESSAGE_DETAILS_LIST, *PMQTT_MESSAGE_DETAILS_LIST;
 
@@ -690,49 +701,50 @@ static void notifyApplicationOfSendMessageComplete(IOTHUB_MESSAGE_LIST* iothubMs
 static int addUserPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_message_handle, STRING_HANDLE topic_string, size_t* index_ptr, bool urlencode)
 {
     int result = 0;
-    const char* const* propertyKeys;
-    const char* const* propertyValues;
     size_t propertyCount;
+    size_t cursor = 0;
     size_t index = *index_ptr;
-    MAP_HANDLE properties_map = IoTHubMessage_Properties(iothub_message_handle);
-    if (properties_map != NULL)
+
+    if (IoTHubMessage_GetPropertyCount(iothub_message_handle, &propertyCount) != IOTHUB_MESSAGE_OK)
     {
-        if (Map_GetInternals(properties_map, &propertyKeys, &propertyValues, &propertyCount) != MAP_OK)
-        {
-            LogError("Failed to get the internals of the property map.");
-            result = MU_FAILURE;
-        }
-        else
+        LogError("Failed to get the number of message properties.");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        for (index = 0; index < propertyCount && result == 0; index++)
         {
-            if (propertyCount != 0)
+            const char* propertyKey;
+            const char* propertyValue;
+
+            if (IoTHubMessage_GetNextProperty(iothub_message_handle, &cursor, &propertyKey, &propertyValue) != IOTHUB_MESSAGE_OK)
+            {
+                LogError("Failed to get message property %lu.", (unsigned long)index);
+                result = MU_FAILURE;
+            }
+            else if (urlencode)
             {
-                for (index = 0; index < propertyCount && result == 0; index++)
+                STRING_HANDLE property_key = URL_EncodeString(propertyKey);
+                STRING_HANDLE property_value = URL_EncodeString(propertyValue);
+                if ((property_key == NULL) || (property_value == NULL))
                 {
-                    if (urlencode)
-                    {
-                        STRING_HANDLE property_key = URL_EncodeString(propertyKeys[index]);
-                        STRING_HANDLE property_value = URL_EncodeString(propertyValues[index]);
-                        if ((property_key == NULL) || (property_value == NULL))
-                        {
-                            LogError("Failed URL Encoding properties");
-                            result = MU_FAILURE;
-                        }
-                        else if (STRING_sprintf(topic_string, "%s=%s%s", STRING_c_str(property_key), STRING_c_str(property_value), propertyCount - 1 == index ? "" : PROPERTY_SEPARATOR) != 0)
-                        {
-                            LogError("Failed constructing property string.");
-                            result = MU_FAILURE;
-                        }
-                        STRING_delete(property_key);
-                        STRING_delete(property_value);
-                    }
-                    else
-                    {
-                        if (STRING_sprintf(topic_string, "%s=%s%s", propertyKeys[index], propertyValues[index], propertyCount - 1 == index ? "" : PROPERTY_SEPARATOR) != 0)
-                        {
-                            LogError("Failed constructing property string.");
-                            result = MU_FAILURE;
-                        }
-                    }
+                    LogError("Failed URL Encoding properties");
+                    result = MU_FAILURE;
+                }
+                else if (STRING_sprintf(topic_string, "%s=%s%s", STRING_c_str(property_key), STRING_c_str(property_value), propertyCount - 1 == index ? "" : PROPERTY_SEPARATOR) != 0)
+                {
+                    LogError("Failed constructing property string.");
+                    result = MU_FAILURE;
+                }
+                STRING_delete(property_key);
+                STRING_delete(property_value);
+            }
+            else
+            {
+                if (STRING_sprintf(topic_string, "%s=%s%s", propertyKey, propertyValue, propertyCount - 1 == index ? "" : PROPERTY_SEPARATOR) != 0)
+                {
+                    LogError("Failed constructing property string.");
+                    result = MU_FAILURE;
                 }
             }
         }
@@ -748,26 +760,29 @@ static int addUserPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_message_
 static bool isMqttMessageSfcType(IOTHUB_MESSAGE_HANDLE iothub_message_handle)
 {
     bool result = false;
-    const char* const* propertyKeys;
-    const char* const* propertyValues;
     size_t propertyCount;
+    size_t cursor = 0;
     size_t index;
-    MAP_HANDLE properties_map = IoTHubMessage_Properties(iothub_message_handle);
-    if (properties_map != NULL)
+    if (IoTHubMessage_GetPropertyCount(iothub_message_handle, &propertyCount) != IOTHUB_MESSAGE_OK)
     {
-        if (Map_GetInternals(properties_map, &propertyKeys, &propertyValues, &propertyCount) != MAP_OK)
-        {
-            LogError("Failed to get the internals of the property map.");
-        }
-        else
+        LogError("Failed to get the number of message properties.");
+    }
+    else
+    {
+        for (index = 0; index < propertyCount; index++)
         {
-            for (index = 0; index < propertyCount; index++)
+            const char* propertyKey;
+            const char* propertyValue;
+
+            if (IoTHubMessage_GetNextProperty(iothub_message_handle, &cursor, &propertyKey, &propertyValue) != IOTHUB_MESSAGE_OK)
             {
-                if (strncmp(propertyKeys[index], FAULT_OPERATION_TYPE , strlen(FAULT_OPERATION_TYPE )) == 0)
-                {
-                    result = true;
-                    break;
-                }
+                LogError("Failed to get message property %lu.", (unsigned long)index);
+                break;
+            }
+            else if (strncmp(propertyKey, FAULT_OPERATION_TYPE , strlen(FAULT_OPERATION_TYPE )) == 0)
+            {
+                result = true;
+                break;
             }
         }
     }
@@ -945,7 +960,18 @@ static int addDiagnosticPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_me
             }
             index++;
 
-            if (result == 0)
+            if (result == 0 && creation_time_utc[strspn(creation_time_utc, "0123456789")] == '\0')
+            {
+                // The client's own creation times are epoch seconds, which URL encoding leaves as they are; only the
+                // '=' of the context needs encoding, so it is written without building and encoding a copy
+                if (STRING_sprintf(topic_string, SYS_DIAGNOSTIC_CONTEXT_STRING_FORMAT, PROPERTY_SEPARATOR, DIAGNOSTIC_CONTEXT_CREATION_TIME_UTC_PROPERTY, creation_time_utc) != 0)
+                {
+                    LogError("Failed setting diagnostic context");
+                    result = MU_FAILURE;
+                }
+                index++;
+            }
+            else if (result == 0)
             {
                 //construct diagnostic context, it should be urlencode(key1=value1,key2=value2)
                 STRING_HANDLE diagContextHandle = STRING_construct_sprintf("%s=%s", DIAGNOSTIC_CONTEXT_CREATION_TIME_UTC_PROPERTY, creation_time_utc);
@@ -1027,9 +1053,54 @@ static STRING_HANDLE addPropertiesTouMqttMessage(IOTHUB_MESSAGE_HANDLE iothub_me
 }
 
 //
-// publishTelemetryMsg invokes the umqtt layer to send a PUBLISH message.
+// destroyMqttMessageDetails releases a telemetry message entry along with the PUBLISH kept for its retransmits.
+//
+static void destroyMqttMessageDetails(MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry)
+{
+    if (mqttMsgEntry->mqttMessage != NULL)
+    {
+        mqttmessage_destroy(mqttMsgEntry->mqttMessage);
+    }
+    if (mqttMsgEntry->mqttTopic != NULL)
+    {
+        STRING_delete(mqttMsgEntry->mqttTopic);
+    }
+    free(mqttMsgEntry);
+}
+
+//
+// sendTelemetryMsg invokes the umqtt layer to send the PUBLISH message kept on mqttMsgEntry.  A retransmit only
+// flips the DUP flag; the topic, properties and payload are those of the first attempt.
+//
+static int sendTelemetryMsg(PMQTTTRANSPORT_HANDLE_DATA transport_data, MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry, bool isDuplicate)
+{
+    int result;
+    if (mqttmessage_setIsDuplicateMsg(mqttMsgEntry->mqttMessage, isDuplicate) != 0)
+    {
+        LogError("Failed setting DUP flag");
+        result = MU_FAILURE;
+    }
+    else if (tickcounter_get_current_ms(transport_data->msgTickCounter, &mqttMsgEntry->msgPublishTime) != 0)
+    {
+        LogError("Failed retrieving tickcounter info");
+        result = MU_FAILURE;
+    }
+    else if (mqtt_client_publish(transport_data->mqttClient, mqttMsgEntry->mqttMessage) != 0)
+    {
+        LogError("Failed attempting to publish mqtt message");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        result = 0;
+    }
+    return result;
+}
+
+//
+// publishTelemetryMsg builds the PUBLISH message for a telemetry message, keeps it on mqttMsgEntry and sends it.
 //
-static int publishTelemetryMsg(PMQTTTRANSPORT_HANDLE_DATA transport_data, MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry, const unsigned char* payload, size_t len, bool isDuplicate)
+static int publishTelemetryMsg(PMQTTTRANSPORT_HANDLE_DATA transport_data, MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry, const unsigned char* payload, size_t len)
 {
     int result;
     STRING_HANDLE msgTopic = addPropertiesTouMqttMessage(mqttMsgEntry->iotHubMessageEntry->messageHandle, STRING_c_str(transport_data->topic_MqttEvent), transport_data->auto_url_encode_decode);
@@ -1040,39 +1111,25 @@ static int publishTelemetryMsg(PMQTTTRANSPORT_HANDLE_DATA transport_data, MQTT_M
     }
     else
     {
-        MQTT_MESSAGE_HANDLE mqttMsg = mqttmessage_create_in_place(mqttMsgEntry->packet_id, STRING_c_str(msgTopic), DELIVER_AT_LEAST_ONCE, payload, len);
-        if (mqttMsg == NULL)
+        // The payload is owned by the IoTHub message and the topic by the entry, both outlive the PUBLISH
+        mqttMsgEntry->mqttTopic = msgTopic;
+        mqttMsgEntry->mqttMessage = mqttmessage_create_in_place(mqttMsgEntry->packet_id, STRING_c_str(msgTopic), DELIVER_AT_LEAST_ONCE, payload, len);
+        if (mqttMsgEntry->mqttMessage == NULL)
         {
             LogError("Failed creating mqtt message");
             result = MU_FAILURE;
         }
-        else
+        else if ((result = sendTelemetryMsg(transport_data, mqttMsgEntry, MQTT_MESSAGE_DUP_FLAG_FALSE)) == 0)
         {
-            if (mqttmessage_setIsDuplicateMsg(mqttMsg, isDuplicate) != 0)
-            {
-                LogError("Failed setting DUP flag");
-                result = MU_FAILURE;
-            }
-            else if (tickcounter_get_current_ms(transport_data->msgTickCounter, &mqttMsgEntry->msgPublishTime) != 0)
+            IOTHUB_CLIENT_TRACE(IOTHUB_CLIENT_TRACE_WRITTEN, mqttMsgEntry->iotHubMessageEntry);
+
+            METRICS_HANDLE metrics = transport_data->transport_callbacks.get_metrics_cb(transport_data->transport_ctx);
+            if (metrics != NULL)
             {
-                LogError("Failed retrieving tickcounter info");
-                result = MU_FAILURE;
+                metrics_add(metrics, METRICS_MESSAGES_SENT, 1);
+                metrics_add(metrics, METRICS_BYTES_SENT, len);
             }
-            else
-            {
-                if (mqtt_client_publish(transport_data->mqttClient, mqttMsg) != 0)
-                {
-                    LogError("Failed attempting to publish mqtt message");
-                    result = MU_FAILURE;
-                }
-                else
-                {
-                    result = 0;
-                }
-            }
-            mqttmessage_destroy(mqttMsg);
         }
-        STRING_delete(msgTopic);
     }
     return result;
 }
@@ -1636,7 +1693,7 @@ static const char* findMessagePropertyStart(PMQTTTRANSPORT_HANDLE_DATA transport
 // AddApplicationProperty adds the custom key/value property name from the incoming MQTT PUBLISH to the iotHubMessage
 // we will ultimately deliver to the application on its callback.
 //
-static int addApplicationPropertyToMessage(MAP_HANDLE propertyMap, const char* propertyNameAndValue, size_t propertyNameLength, const char* propertyValue, bool auto_url_encode_decode)
+static int addApplicationPropertyToMessage(IOTHUB_MESSAGE_HANDLE iotHubMessage, const char* propertyNameAndValue, size_t propertyNameLength, const char* propertyValue, bool auto_url_encode_decode)
 {
     int result = 0;
 
@@ -1666,9 +1723,9 @@ static int addApplicationPropertyToMessage(MAP_HANDLE propertyMap, const char* p
                 LogError("Failed to URL decode property");
                 result = MU_FAILURE;
             }
-            else if (Map_AddOrUpdate(propertyMap, STRING_c_str(propName_decoded), STRING_c_str(propValue_decoded)) != MAP_OK)
+            else if (IoTHubMessage_SetProperty(iotHubMessage, STRING_c_str(propName_decoded), STRING_c_str(propValue_decoded)) != IOTHUB_MESSAGE_OK)
             {
-                LogError("Map_AddOrUpdate failed.");
+                LogError("IoTHubMessage_SetProperty failed.");
                 result = MU_FAILURE;
             }
             else
@@ -1678,9 +1735,9 @@ static int addApplicationPropertyToMessage(MAP_HANDLE propertyMap, const char* p
             STRING_delete(propValue_decoded);
             STRING_delete(propName_decoded);
         }
-        else if (Map_AddOrUpdate(propertyMap, propertyNameCopy, propertyValue) != MAP_OK)
+        else if (IoTHubMessage_SetProperty(iotHubMessage, propertyNameCopy, propertyValue) != IOTHUB_MESSAGE_OK)
         {
-            LogError("Map_AddOrUpdate failed.");
+            LogError("IoTHubMessage_SetProperty failed.");
             result = MU_FAILURE;
         }
     }
@@ -1739,7 +1796,6 @@ static int extractMqttProperties(PMQTTTRANSPORT_HANDLE_DATA transportData, IOTHU
     const char* propertiesStart;
     STRING_TOKENIZER_HANDLE tokenizer = NULL;
     STRING_HANDLE propertyToken = NULL;
-    MAP_HANDLE propertyMap;
 
     if ((propertiesStart = findMessagePropertyStart(transportData, topic_name, type)) == NULL)
     {
@@ -1766,11 +1822,6 @@ static int extractMqttProperties(PMQTTTRANSPORT_HANDLE_DATA transportData, IOTHU
         LogError("Failure to allocate STRING_new.");
         result = MU_FAILURE;
     }
-    else if ((propertyMap = IoTHubMessage_Properties(iotHubMessage)) == NULL)
-    {
-        LogError("Failure to retrieve IoTHubMessage_properties.");
-        result = MU_FAILURE;
-    }
     else
     {
         result = 0;
@@ -1809,7 +1860,7 @@ static int extractMqttProperties(PMQTTTRANSPORT_HANDLE_DATA transportData, IOTHU
                 }
                 else if (propertyType == IOTHUB_SYSTEM_PROPERTY_TYPE_APPLICATION_CUSTOM)
                 {
-                    result = addApplicationPropertyToMessage(propertyMap, propertyNameAndValue, propertyNameLength, propertyValue, transportData->auto_url_encode_decode);
+                    result = addApplicationPropertyToMessage(iotHubMessage, propertyNameAndValue, propertyNameLength, propertyValue, transportData->auto_url_encode_decode);
                 }
                 else
                 {
@@ -2093,7 +2144,7 @@ static void mqttOperationCompleteCallback(MQTT_CLIENT_HANDLE handle, MQTT_CLIENT
                         {
                             (void)DList_RemoveEntryList(currentListEntry); //First remove the item from Waiting for Ack List.
                             notifyApplicationOfSendMessageComplete(mqttMsgEntry->iotHubMessageEntry, transport_data, IOTHUB_CLIENT_CONFIRMATION_OK);
-                            free(mqttMsgEntry);
+                            destroyMqttMessageDetails(mqttMsgEntry);
                         }
                         currentListEntry = saveListEntry.Flink;
                     }
@@ -2500,7 +2551,7 @@ static void ProcessPendingTelemetryMessages(PMQTTTRANSPORT_HANDLE_DATA transport
             notifyApplicationOfSendMessageComplete(msg_detail_entry->iotHubMessageEntry, transport_data, IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT);
             (void)DList_RemoveEntryList(current_entry);
             LogError("Disconnecting MQTT connection because message PUBACK (%d) timeout.", msg_detail_entry->packet_id);
-            free(msg_detail_entry);
+            destroyMqttMessageDetails(msg_detail_entry);
 
             DisconnectFromClient(transport_data);
             transport_data->transport_callbacks.connection_status_cb(IOTHUB_CLIENT_CONNECTION_UNAUTHENTICATED, IOTHUB_CLIENT_CONNECTION_COMMUNICATION_ERROR, transport_data->transport_ctx);
@@ -2512,20 +2563,18 @@ static void ProcessPendingTelemetryMessages(PMQTTTRANSPORT_HANDLE_DATA transport
             if (transport_data->currPacketState == PUBLISH_TYPE)
             {
                 LogInfo("Publish MQTT packet timeout. current_ms:%" PRIu64 ", msgPublishTime:%" PRIu64 ", msgCreationTime:%" PRIu64 ", packet_id:%d", (uint64_t)current_ms, (uint64_t)msg_detail_entry->msgPublishTime, (uint64_t)msg_detail_entry->msgCreationTime, msg_detail_entry->packet_id);
-                size_t messageLength;
-                const unsigned char* messagePayload = NULL;
-                if (!RetrieveMessagePayload(msg_detail_entry->iotHubMessageEntry->messageHandle, &messagePayload, &messageLength))
+                if (sendTelemetryMsg(transport_data, msg_detail_entry, MQTT_MESSAGE_DUP_FLAG_TRUE) != 0)
                 {
                     (void)DList_RemoveEntryList(current_entry);
                     notifyApplicationOfSendMessageComplete(msg_detail_entry->iotHubMessageEntry, transport_data, IOTHUB_CLIENT_CONFIRMATION_ERROR);
+                    destroyMqttMessageDetails(msg_detail_entry);
                 }
                 else
                 {
-                    if (publishTelemetryMsg(transport_data, msg_detail_entry, messagePayload, messageLength, MQTT_MESSAGE_DUP_FLAG_TRUE) != 0)
+                    METRICS_HANDLE metrics = transport_data->transport_callbacks.get_metrics_cb(transport_data->transport_ctx);
+                    if (metrics != NULL)
                     {
-                        (void)DList_RemoveEntryList(current_entry);
-                        notifyApplicationOfSendMessageComplete(msg_detail_entry->iotHubMessageEntry, transport_data, IOTHUB_CLIENT_CONFIRMATION_ERROR);
-                        free(msg_detail_entry);
+                        metrics_add(metrics, METRICS_SEND_RETRIES, 1);
                     }
                 }
             }
@@ -2815,6 +2864,15 @@ static int UpdateMqttConnectionStateIfNeeded(PMQTTTRANSPORT_HANDLE_DATA transpor
                 }
                 else
                 {
+                    if (transport_data->conn_attempted)
+                    {
+                        METRICS_HANDLE metrics = transport_data->transport_callbacks.get_metrics_cb(transport_data->transport_ctx);
+                        if (metrics != NULL)
+                        {
+                            metrics_add(metrics, METRICS_RECONNECT_ATTEMPTS, 1);
+                        }
+                    }
+
                     ResetConnectionIfNecessary(transport_data);
 
                     if (SendMqttConnectMsg(transport_data) != 0)
@@ -3182,11 +3240,14 @@ static void ProcessPublishStateDoWork(PMQTTTRANSPORT_HANDLE_DATA transport_data)
                 mqttMsgEntry->msgCreationTime = current_ms;
                 mqttMsgEntry->iotHubMessageEntry = iothubMsgList;
                 mqttMsgEntry->packet_id = getNextPacketId(transport_data);
-                if (publishTelemetryMsg(transport_data, mqttMsgEntry, messagePayload, messageLength, MQTT_MESSAGE_DUP_FLAG_FALSE) != 0)
+                mqttMsgEntry->mqttMessage = NULL;
+                mqttMsgEntry->mqttTopic = NULL;
+                IOTHUB_CLIENT_TRACE(IOTHUB_CLIENT_TRACE_DEQUEUED, iothubMsgList);
+                if (publishTelemetryMsg(transport_data, mqttMsgEntry, messagePayload, messageLength) != 0)
                 {
                     (void)(DList_RemoveEntryList(currentListEntry));
                     notifyApplicationOfSendMessageComplete(iothubMsgList, transport_data, IOTHUB_CLIENT_CONFIRMATION_ERROR);
-                    free(mqttMsgEntry);
+                    destroyMqttMessageDetails(mqttMsgEntry);
                 }
                 else
                 {
@@ -3293,7 +3354,7 @@ void IoTHubTransport_MQTT_Common_Destroy(TRANSPORT_LL_HANDLE handle)
             PDLIST_ENTRY currentEntry = DList_RemoveHeadList(&transport_data->telemetry_waitingForAck);
             MQTT_MESSAGE_DETAILS_LIST* mqttMsgEntry = containingRecord(currentEntry, MQTT_MESSAGE_DETAILS_LIST, entry);
             notifyApplicationOfSendMessageComplete(mqttMsgEntry->iotHubMessageEntry, transport_data, IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY);
-            free(mqttMsgEntry);
+            destroyMqttMessageDetails(mqttMsgEntry);
         }
         while (!DList_IsListEmpty(&transport_data->ack_waiting_queue))
         {
@@ -3729,6 +3790,134 @@ IOTHUB_CLIENT_RESULT IoTHubTransport_MQTT_Common_GetSendStatus(TRANSPORT_LL_HAND
     return result;
 }
 
+// Lowers timeout_ms to the time left until deadline_ms, which is 0 once it has passed
+static tickcounter_ms_t lowerTimeoutToDeadline(tickcounter_ms_t timeout_ms, tickcounter_ms_t current_ms, tickcounter_ms_t deadline_ms)
+{
+    tickcounter_ms_t time_left = (deadline_ms > current_ms) ? (deadline_ms - current_ms) : 0;
+    return (time_left < timeout_ms) ? time_left : timeout_ms;
+}
+
+// The deadlines below match the checks of ProcessPendingTelemetryMessages, removeExpiredTwinRequestsFromList and
+// UpdateMqttConnectionStateIfNeeded, so that DoWork never runs before they are due.
+static tickcounter_ms_t getConnectedTimeout(PMQTTTRANSPORT_HANDLE_DATA transport_data, tickcounter_ms_t current_ms)
+{
+    tickcounter_ms_t result = (tickcounter_ms_t)SIZE_MAX;
+    PDLIST_ENTRY list_item;
+    IOTHUB_CREDENTIAL_TYPE cred_type;
+
+    // mqtt_client_dowork sends the PINGREQ once the keep-alive has elapsed, so check a few times per interval
+    if (transport_data->keepAliveValue > 0)
+    {
+        result = ((tickcounter_ms_t)transport_data->keepAliveValue * 1000) / 4;
+    }
+
+    for (list_item = transport_data->telemetry_waitingForAck.Flink; list_item != &transport_data->telemetry_waitingForAck; list_item = list_item->Flink)
+    {
+        MQTT_MESSAGE_DETAILS_LIST* msg_detail_entry = containingRecord(list_item, MQTT_MESSAGE_DETAILS_LIST, entry);
+        result = lowerTimeoutToDeadline(result, current_ms, msg_detail_entry->msgCreationTime + (TELEMETRY_MSG_TIMEOUT_MIN * 1000));
+        result = lowerTimeoutToDeadline(result, current_ms, msg_detail_entry->msgPublishTime + ((RESEND_TIMEOUT_VALUE_MIN + 1) * 1000));
+    }
+
+    for (list_item = transport_data->ack_waiting_queue.Flink; list_item != &transport_data->ack_waiting_queue; list_item = list_item->Flink)
+    {
+        MQTT_DEVICE_TWIN_ITEM* msg_entry = containingRecord(list_item, MQTT_DEVICE_TWIN_ITEM, entry);
+        if (msg_entry->device_twin_msg_type == RETRIEVE_PROPERTIES)
+        {
+            result = lowerTimeoutToDeadline(result, current_ms, msg_entry->msgCreationTime + (ON_DEMAND_GET_TWIN_REQUEST_TIMEOUT_SECS * 1000));
+        }
+        else if (msg_entry->device_twin_msg_type == REPORTED_STATE)
+        {
+            result = lowerTimeoutToDeadline(result, current_ms, msg_entry->msgCreationTime + (TWIN_REPORT_UPDATE_TIMEOUT_SECS * 1000));
+        }
+    }
+
+    cred_type = IoTHubClient_Auth_Get_Credential_Type(transport_data->authorization_module);
+    if (cred_type != IOTHUB_CREDENTIAL_TYPE_X509 && cred_type != IOTHUB_CREDENTIAL_TYPE_X509_ECC)
+    {
+        uint64_t sas_token_expiry = IoTHubClient_Auth_Get_SasToken_Expiry(transport_data->authorization_module);
+        tickcounter_ms_t refresh_after_secs = (tickcounter_ms_t)(sas_token_expiry * SAS_REFRESH_MULTIPLIER) + 1;
+        result = lowerTimeoutToDeadline(result, current_ms, transport_data->mqtt_connect_time + (refresh_after_secs * 1000));
+    }
+
+    return result;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubTransport_MQTT_Common_GetPollInfo(TRANSPORT_LL_HANDLE handle, bool hasQueuedItems, IOTHUB_CLIENT_POLL_INFO* pollInfo)
+{
+    IOTHUB_CLIENT_RESULT result;
+    tickcounter_ms_t current_ms;
+
+    if (handle == NULL || pollInfo == NULL)
+    {
+        LogError("Invalid argument (handle=%p, pollInfo=%p)", handle, pollInfo);
+        result = IOTHUB_CLIENT_INVALID_ARG;
+    }
+    else if (tickcounter_get_current_ms(((PMQTTTRANSPORT_HANDLE_DATA)handle)->msgTickCounter, &current_ms) != 0)
+    {
+        LogError("Failed getting the current time");
+        result = IOTHUB_CLIENT_ERROR;
+    }
+    else
+    {
+        PMQTTTRANSPORT_HANDLE_DATA transport_data = (PMQTTTRANSPORT_HANDLE_DATA)handle;
+        tickcounter_ms_t timeout_ms;
+
+        if (transport_data->isDestroyCalled)
+        {
+            timeout_ms = (tickcounter_ms_t)SIZE_MAX;
+        }
+        else if (transport_data->mqttClientStatus == MQTT_CLIENT_STATUS_NOT_CONNECTED)
+        {
+            if (!transport_data->isRecoverableError)
+            {
+                timeout_ms = (tickcounter_ms_t)SIZE_MAX;
+            }
+            else if (!transport_data->conn_attempted)
+            {
+                timeout_ms = 0;
+            }
+            else
+            {
+                // The retry control only answers whether to retry now
+                timeout_ms = POLL_INFO_RECONNECT_INTERVAL_MS;
+            }
+        }
+        else if (transport_data->mqttClientStatus == MQTT_CLIENT_STATUS_PENDING_CLOSE ||
+                 transport_data->mqttClientStatus == MQTT_CLIENT_STATUS_EXECUTE_DISCONNECT)
+        {
+            timeout_ms = 0;
+        }
+        else if (transport_data->mqttClientStatus == MQTT_CLIENT_STATUS_CONNECTED && transport_data->currPacketState == CONNACK_TYPE)
+        {
+            // Subscribing is next
+            timeout_ms = 0;
+        }
+        else if (transport_data->mqttClientStatus == MQTT_CLIENT_STATUS_CONNECTED && transport_data->currPacketState == PUBLISH_TYPE)
+        {
+            // Twin requests wait for the SUBACK of the twin responses, which DoWork cannot speed up
+            if (!DList_IsListEmpty(transport_data->waitingToSend) ||
+                (transport_data->twin_resp_sub_recv && (!DList_IsListEmpty(&transport_data->pending_get_twin_queue) || hasQueuedItems)))
+            {
+                timeout_ms = 0;
+            }
+            else
+            {
+                timeout_ms = getConnectedTimeout(transport_data, current_ms);
+            }
+        }
+        else
+        {
+            // Waiting for the handshake, the CONNACK or the SUBACK; subscribing is retried from here too
+            timeout_ms = POLL_INFO_HANDSHAKE_INTERVAL_MS;
+        }
+
+        pollInfo->timeoutMs = (timeout_ms < (tickcounter_ms_t)SIZE_MAX) ? (size_t)timeout_ms : SIZE_MAX;
+        result = IOTHUB_CLIENT_OK;
+    }
+
+    return result;
+}
+
 IOTHUB_CLIENT_RESULT IoTHubTransport_MQTT_Common_SetOption(TRANSPORT_LL_HANDLE handle, const char* option, const void* value)
 {
     IOTHUB_CLIENT_RESULT result;
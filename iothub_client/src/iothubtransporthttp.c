@@ -50,6 +50,10 @@ static const char* IOTHUB_AUTH_HEADER_VALUE = "Authorization";
 /*DEFAULT_GETMINIMUMPOLLINGTIME is the minimum time in seconds allowed between 2 consecutive GET issues to the service (GET=fetch messages)*/
 /*the default is 25 minutes*/
 #define DEFAULT_GETMINIMUMPOLLINGTIME ((unsigned int)25*60)
+/*DEFAULT_GETMAXIMUMPOLLINGTIME of 0 turns off the adaptive polling: the GETs are getMinimumPollingTime apart*/
+#define DEFAULT_GETMAXIMUMPOLLINGTIME ((unsigned int)0)
+/*by default a poll fetches a single message, the next one waits for the next poll*/
+#define DEFAULT_MESSAGESPERPOLL ((unsigned int)1)
 
 #define MAXIMUM_MESSAGE_SIZE (255*1024-1)
 #define MAXIMUM_PAYLOAD_OVERHEAD 384
@@ -64,6 +68,8 @@ typedef struct HTTPTRANSPORT_HANDLE_DATA_TAG
     HTTPAPIEX_HANDLE httpApiExHandle;
     bool doBatchedTransfers;
     unsigned int getMinimumPollingTime;
+    unsigned int getMaximumPollingTime;
+    unsigned int messagesPerPoll;
     VECTOR_HANDLE perDeviceList;
 
     TRANSPORT_CALLBACKS_INFO transport_callbacks;
@@ -87,6 +93,9 @@ typedef struct HTTPTRANSPORT_PERDEVICE_DATA_TAG
     bool DoWork_PullMessage;
     time_t lastPollTime;
     bool isFirstPoll;
+    /*adaptive polling only: the backed off interval and the jittered one the next GET waits for*/
+    unsigned int pollingBackoff;
+    unsigned int pollingTime;
 
     void* device_transport_ctx;
     PDLIST_ENTRY waitingToSend;
@@ -781,6 +790,8 @@ static IOTHUB_DEVICE_HANDLE IoTHubTransportHttp_Register(TRANSPORT_LL_HANDLE han
             {
                 result->DoWork_PullMessage = false;
                 result->isFirstPoll = true;
+                result->pollingBackoff = 0;
+                result->pollingTime = 0;
                 result->waitingToSend = waitingToSend;
                 DList_InitializeListHead(&(result->eventConfirmations));
                 result->transportHandle = (HTTPTRANSPORT_HANDLE_DATA *)handle;
@@ -1006,6 +1017,8 @@ static TRANSPORT_LL_HANDLE IoTHubTransportHttp_Create(const IOTHUBTRANSPORT_CONF
             {
                 result->doBatchedTransfers = false;
                 result->getMinimumPollingTime = DEFAULT_GETMINIMUMPOLLINGTIME;
+                result->getMaximumPollingTime = DEFAULT_GETMAXIMUMPOLLINGTIME;
+                result->messagesPerPoll = DEFAULT_MESSAGESPERPOLL;
 
                 result->transport_ctx = ctx;
                 memcpy(&result->transport_callbacks, cb_info, sizeof(TRANSPORT_CALLBACKS_INFO));
@@ -1494,8 +1507,39 @@ static void reversePutListBackIn(PDLIST_ENTRY source, PDLIST_ENTRY destination)
     DList_InitializeListHead(source);
 }
 
+/*counts a batch that went out in one request: every message of it is sent, or, when the hub turned it down and it goes back to waitingToSend, also retried*/
+static void recordBatchSent(METRICS_HANDLE metrics, PDLIST_ENTRY batch, bool isRetried)
+{
+    PDLIST_ENTRY entry;
+    for (entry = batch->Flink; entry != batch; entry = entry->Flink)
+    {
+        IOTHUB_MESSAGE_LIST* message = containingRecord(entry, IOTHUB_MESSAGE_LIST, entry);
+        const unsigned char* body;
+        size_t size;
+
+        if (IoTHubMessage_GetContentType(message->messageHandle) == IOTHUBMESSAGE_STRING)
+        {
+            const char* string = IoTHubMessage_GetString(message->messageHandle);
+            size = (string == NULL) ? 0 : strlen(string);
+        }
+        else if (IoTHubMessage_GetByteArray(message->messageHandle, &body, &size) != IOTHUB_MESSAGE_OK)
+        {
+            size = 0;
+        }
+
+        metrics_add(metrics, METRICS_MESSAGES_SENT, 1);
+        metrics_add(metrics, METRICS_BYTES_SENT, size);
+        if (isRetried)
+        {
+            metrics_add(metrics, METRICS_SEND_RETRIES, 1);
+        }
+    }
+}
+
 static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVICE_DATA* deviceData)
 {
+    METRICS_HANDLE metrics = handleData->transport_callbacks.get_metrics_cb(deviceData->device_transport_ctx);
+
 
     if (DList_IsListEmpty(deviceData->waitingToSend))
     {
@@ -1550,6 +1594,11 @@ static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVI
                             }
                             else
                             {
+                                if (metrics != NULL)
+                                {
+                                    recordBatchSent(metrics, &(deviceData->eventConfirmations), statusCode >= 300);
+                                }
+
                                 if (statusCode < 300)
                                 {
                                     handleData->transport_callbacks.send_complete_cb(&(deviceData->eventConfirmations), IOTHUB_CLIENT_CONFIRMATION_OK, deviceData->device_transport_ctx);
@@ -1685,6 +1734,17 @@ static void DoEvent(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVI
                                         }
                                         if (r == HTTPAPIEX_OK)
                                         {
+                                            if (metrics != NULL)
+                                            {
+                                                metrics_add(metrics, METRICS_MESSAGES_SENT, 1);
+                                                metrics_add(metrics, METRICS_BYTES_SENT, originalMessageSize);
+                                                if (statusCode >= 300)
+                                                {
+                                                    /*the message stays first in waitingToSend and goes out again on the next DoWork*/
+                                                    metrics_add(metrics, METRICS_SEND_RETRIES, 1);
+                                                }
+                                            }
+
                                             if (statusCode < 300)
                                             {
                                                 PDLIST_ENTRY justSent = DList_RemoveHeadList(deviceData->waitingToSend); /*actually this is the same as "actual", but now it is removed*/
@@ -1903,173 +1963,236 @@ static MESSAGE_DISPOSITION_CONTEXT* CreateMessageDispositionContext(const char*
     return result;
 }
 
-static void DoMessages(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVICE_DATA* deviceData)
+/*issues one GET for a message; returns true when a message was received and handed over, so that the next one can be fetched right away*/
+static bool DoMessage(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVICE_DATA* deviceData, time_t timeNow)
 {
-    if (deviceData->DoWork_PullMessage)
+    bool result = false;
+    HTTP_HEADERS_HANDLE responseHTTPHeaders = HTTPHeaders_Alloc();
+    if (responseHTTPHeaders == NULL)
     {
-        time_t timeNow = get_time(NULL);
-        bool isPollingAllowed = deviceData->isFirstPoll || (timeNow == (time_t)(-1)) || (get_difftime(timeNow, deviceData->lastPollTime) > handleData->getMinimumPollingTime);
-        if (isPollingAllowed)
+        LogError("unable to HTTPHeaders_Alloc");
+    }
+    else
+    {
+        BUFFER_HANDLE responseContent = BUFFER_new();
+        if (responseContent == NULL)
         {
-            HTTP_HEADERS_HANDLE responseHTTPHeaders = HTTPHeaders_Alloc();
-            if (responseHTTPHeaders == NULL)
+            LogError("unable to BUFFER_new");
+        }
+        else
+        {
+            unsigned int statusCode = 0;
+            HTTPAPIEX_RESULT r;
+            if (deviceData->deviceSasToken != NULL)
             {
-                LogError("unable to HTTPHeaders_Alloc");
+                if (HTTPHeaders_ReplaceHeaderNameValuePair(deviceData->messageHTTPrequestHeaders, IOTHUB_AUTH_HEADER_VALUE, STRING_c_str(deviceData->deviceSasToken)) != HTTP_HEADERS_OK)
+                {
+                    r = HTTPAPIEX_ERROR;
+                    LogError("Unable to replace the old SAS Token.");
+                }
+                else if ((r = HTTPAPIEX_ExecuteRequest(
+                    handleData->httpApiExHandle,
+                    HTTPAPI_REQUEST_GET,                                            /*requestType: GET*/
+                    STRING_c_str(deviceData->messageHTTPrelativePath),         /*relativePath: the message HTTP relative path*/
+                    deviceData->messageHTTPrequestHeaders,                     /*requestHttpHeadersHandle: message HTTP request headers created by _Create*/
+                    NULL,                                                           /*requestContent: NULL*/
+                    &statusCode,                                                    /*statusCode: a pointer to unsigned int which shall be later examined*/
+                    responseHTTPHeaders,                                            /*responseHeadearsHandle: a new instance of HTTP headers*/
+                    responseContent                                                 /*responseContent: a new instance of buffer*/
+                )) != HTTPAPIEX_OK)
+                {
+                    LogError("Unable to HTTPAPIEX_ExecuteRequest.");
+                }
             }
-            else
+            else if ((r = HTTPAPIEX_SAS_ExecuteRequest(
+                deviceData->sasObject,
+                handleData->httpApiExHandle,
+                HTTPAPI_REQUEST_GET,                                            /*requestType: GET*/
+                STRING_c_str(deviceData->messageHTTPrelativePath),         /*relativePath: the message HTTP relative path*/
+                deviceData->messageHTTPrequestHeaders,                     /*requestHttpHeadersHandle: message HTTP request headers created by _Create*/
+                NULL,                                                           /*requestContent: NULL*/
+                &statusCode,                                                    /*statusCode: a pointer to unsigned int which shall be later examined*/
+                responseHTTPHeaders,                                            /*responseHeadearsHandle: a new instance of HTTP headers*/
+                responseContent                                                 /*responseContent: a new instance of buffer*/
+            )) != HTTPAPIEX_OK)
             {
-                BUFFER_HANDLE responseContent = BUFFER_new();
-                if (responseContent == NULL)
+                LogError("unable to HTTPAPIEX_SAS_ExecuteRequest");
+            }
+            if (r == HTTPAPIEX_OK)
+            {
+                /*HTTP dialogue was succesfull*/
+                if (timeNow == (time_t)(-1))
                 {
-                    LogError("unable to BUFFER_new");
+                    deviceData->isFirstPoll = true;
                 }
                 else
                 {
-                    unsigned int statusCode = 0;
-                    HTTPAPIEX_RESULT r;
-                    if (deviceData->deviceSasToken != NULL)
-                    {
-                        if (HTTPHeaders_ReplaceHeaderNameValuePair(deviceData->messageHTTPrequestHeaders, IOTHUB_AUTH_HEADER_VALUE, STRING_c_str(deviceData->deviceSasToken)) != HTTP_HEADERS_OK)
-                        {
-                            r = HTTPAPIEX_ERROR;
-                            LogError("Unable to replace the old SAS Token.");
-                        }
-                        else if ((r = HTTPAPIEX_ExecuteRequest(
-                            handleData->httpApiExHandle,
-                            HTTPAPI_REQUEST_GET,                                            /*requestType: GET*/
-                            STRING_c_str(deviceData->messageHTTPrelativePath),         /*relativePath: the message HTTP relative path*/
-                            deviceData->messageHTTPrequestHeaders,                     /*requestHttpHeadersHandle: message HTTP request headers created by _Create*/
-                            NULL,                                                           /*requestContent: NULL*/
-                            &statusCode,                                                    /*statusCode: a pointer to unsigned int which shall be later examined*/
-                            responseHTTPHeaders,                                            /*responseHeadearsHandle: a new instance of HTTP headers*/
-                            responseContent                                                 /*responseContent: a new instance of buffer*/
-                        )) != HTTPAPIEX_OK)
-                        {
-                            LogError("Unable to HTTPAPIEX_ExecuteRequest.");
-                        }
-                    }
-                    else if ((r = HTTPAPIEX_SAS_ExecuteRequest(
-                        deviceData->sasObject,
-                        handleData->httpApiExHandle,
-                        HTTPAPI_REQUEST_GET,                                            /*requestType: GET*/
-                        STRING_c_str(deviceData->messageHTTPrelativePath),         /*relativePath: the message HTTP relative path*/
-                        deviceData->messageHTTPrequestHeaders,                     /*requestHttpHeadersHandle: message HTTP request headers created by _Create*/
-                        NULL,                                                           /*requestContent: NULL*/
-                        &statusCode,                                                    /*statusCode: a pointer to unsigned int which shall be later examined*/
-                        responseHTTPHeaders,                                            /*responseHeadearsHandle: a new instance of HTTP headers*/
-                        responseContent                                                 /*responseContent: a new instance of buffer*/
-                    )) != HTTPAPIEX_OK)
+                    deviceData->isFirstPoll = false;
+                    deviceData->lastPollTime = timeNow;
+                }
+                if (statusCode == 204)
+                {
+                    /*this is an expected status code, means "no commands", but logging that creates panic*/
+
+                    /*do nothing, advance to next action*/
+                }
+                else if (statusCode != 200)
+                {
+                    LogError("expected status code was 200, but actually was received %u... moving on", statusCode);
+                }
+                else
+                {
+                    const char* etagValue = HTTPHeaders_FindHeaderValue(responseHTTPHeaders, "ETag");
+                    if (etagValue == NULL)
                     {
-                        LogError("unable to HTTPAPIEX_SAS_ExecuteRequest");
+                        LogError("unable to find a received header called \"E-Tag\"");
                     }
-                    if (r == HTTPAPIEX_OK)
+                    else
                     {
-                        /*HTTP dialogue was succesfull*/
-                        if (timeNow == (time_t)(-1))
+                        size_t etagsize = strlen(etagValue);
+                        if (
+                            (etagsize < 2) ||
+                            (etagValue[0] != '"') ||
+                            (etagValue[etagsize - 1] != '"')
+                            )
                         {
-                            deviceData->isFirstPoll = true;
+                            LogError("ETag is not a valid quoted string");
                         }
                         else
                         {
-                            deviceData->isFirstPoll = false;
-                            deviceData->lastPollTime = timeNow;
-                        }
-                        if (statusCode == 204)
-                        {
-                            /*this is an expected status code, means "no commands", but logging that creates panic*/
-
-                            /*do nothing, advance to next action*/
-                        }
-                        else if (statusCode != 200)
-                        {
-                            LogError("expected status code was 200, but actually was received %u... moving on", statusCode);
-                        }
-                        else
-                        {
-                            const char* etagValue = HTTPHeaders_FindHeaderValue(responseHTTPHeaders, "ETag");
-                            if (etagValue == NULL)
+                            const unsigned char* resp_content;
+                            size_t resp_len;
+                            resp_content = BUFFER_u_char(responseContent);
+                            resp_len = BUFFER_length(responseContent);
+                            IOTHUB_MESSAGE_HANDLE receivedMessage = IoTHubMessage_CreateFromByteArray(resp_content, resp_len);
+                            bool abandon = false;
+                            if (receivedMessage == NULL)
                             {
-                                LogError("unable to find a received header called \"E-Tag\"");
+                                LogError("unable to IoTHubMessage_CreateFromByteArray, trying to abandon the message... ");
+                                abandon = true;
                             }
                             else
                             {
-                                size_t etagsize = strlen(etagValue);
-                                if (
-                                    (etagsize < 2) ||
-                                    (etagValue[0] != '"') ||
-                                    (etagValue[etagsize - 1] != '"')
-                                    )
+                                if (retrieve_message_properties(responseHTTPHeaders, receivedMessage) != 0)
                                 {
-                                    LogError("ETag is not a valid quoted string");
+                                    LogError("Failed retrieving message properties");
+                                    abandon = true;
                                 }
                                 else
                                 {
-                                    const unsigned char* resp_content;
-                                    size_t resp_len;
-                                    resp_content = BUFFER_u_char(responseContent);
-                                    resp_len = BUFFER_length(responseContent);
-                                    IOTHUB_MESSAGE_HANDLE receivedMessage = IoTHubMessage_CreateFromByteArray(resp_content, resp_len);
-                                    bool abandon = false;
-                                    if (receivedMessage == NULL)
+                                    MESSAGE_DISPOSITION_CONTEXT* dispositionContext = CreateMessageDispositionContext(etagValue);
+
+                                    if (dispositionContext == NULL)
                                     {
-                                        LogError("unable to IoTHubMessage_CreateFromByteArray, trying to abandon the message... ");
+                                        LogError("failed to create disposition context");
                                         abandon = true;
                                     }
                                     else
                                     {
-                                        if (retrieve_message_properties(responseHTTPHeaders, receivedMessage) != 0)
+                                        if (IoTHubMessage_SetDispositionContext(receivedMessage, dispositionContext, DestroyMessageDispositionContext) != IOTHUB_MESSAGE_OK)
                                         {
-                                            LogError("Failed retrieving message properties");
+                                            LogError("Failed setting disposition context in IOTHUB_MESSAGE_HANDLE");
+                                            DestroyMessageDispositionContext(dispositionContext);
                                             abandon = true;
                                         }
-                                        else
+                                        else if (!handleData->transport_callbacks.msg_cb(receivedMessage, deviceData->device_transport_ctx))
                                         {
-                                            MESSAGE_DISPOSITION_CONTEXT* dispositionContext = CreateMessageDispositionContext(etagValue);
-
-                                            if (dispositionContext == NULL)
-                                            {
-                                                LogError("failed to create disposition context");
-                                                abandon = true;
-                                            }
-                                            else
-                                            {
-                                                if (IoTHubMessage_SetDispositionContext(receivedMessage, dispositionContext, DestroyMessageDispositionContext) != IOTHUB_MESSAGE_OK)
-                                                {
-                                                    LogError("Failed setting disposition context in IOTHUB_MESSAGE_HANDLE");
-                                                    DestroyMessageDispositionContext(dispositionContext);
-                                                    abandon = true;
-                                                }
-                                                else if (!handleData->transport_callbacks.msg_cb(receivedMessage, deviceData->device_transport_ctx))
-                                                {
-                                                    LogError("IoTHubClientCore_LL_MessageCallback failed");
-                                                    abandon = true;
-                                                }
-                                            }
-                                        }
-
-                                        if (abandon)
-                                        {
-                                            // If IoTHubMessage_SetDispositionContext succeeds above, it transitions ownership of 
-                                            // dispositionContext to the receivedMessage.
-                                            // IoTHubMessage_Destroy() below will handle freeing it.
-                                            IoTHubMessage_Destroy(receivedMessage);
+                                            LogError("IoTHubClientCore_LL_MessageCallback failed");
+                                            abandon = true;
                                         }
                                     }
+                                }
 
-                                    if (abandon)
-                                    {
-                                        if (!abandonOrAcceptMessage(handleData, deviceData, etagValue, IOTHUBMESSAGE_ABANDONED))
-                                        {
-                                            LogError("HTTP Transport layer failed to report ABANDON disposition");
-                                        }
-                                    }
+                                if (abandon)
+                                {
+                                    // If IoTHubMessage_SetDispositionContext succeeds above, it transitions ownership of 
+                                    // dispositionContext to the receivedMessage.
+                                    // IoTHubMessage_Destroy() below will handle freeing it.
+                                    IoTHubMessage_Destroy(receivedMessage);
                                 }
                             }
+
+                            if (abandon)
+                            {
+                                if (!abandonOrAcceptMessage(handleData, deviceData, etagValue, IOTHUBMESSAGE_ABANDONED))
+                                {
+                                    LogError("HTTP Transport layer failed to report ABANDON disposition");
+                                }
+                            }
+                            else
+                            {
+                                result = true;
+                            }
                         }
                     }
-                    BUFFER_delete(responseContent);
                 }
-                HTTPHeaders_Free(responseHTTPHeaders);
+            }
+            BUFFER_delete(responseContent);
+        }
+        HTTPHeaders_Free(responseHTTPHeaders);
+    }
+
+    return result;
+}
+
+/*the time in seconds the next GET waits for since the last one*/
+static unsigned int getPollingTime(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVICE_DATA* deviceData)
+{
+    unsigned int result;
+    if ((handleData->getMaximumPollingTime <= handleData->getMinimumPollingTime) || (deviceData->pollingTime < handleData->getMinimumPollingTime))
+    {
+        result = handleData->getMinimumPollingTime;
+    }
+    else
+    {
+        result = deviceData->pollingTime;
+    }
+    return result;
+}
+
+/*adaptive polling: a received message brings the interval back to the minimum, an empty poll doubles it up to the maximum*/
+static void updatePollingTime(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVICE_DATA* deviceData, bool wasMessageReceived)
+{
+    unsigned int backoff;
+    if (wasMessageReceived || (deviceData->pollingBackoff < handleData->getMinimumPollingTime))
+    {
+        backoff = handleData->getMinimumPollingTime;
+    }
+    else if (deviceData->pollingBackoff == 0)
+    {
+        backoff = 1;
+    }
+    else if (deviceData->pollingBackoff > handleData->getMaximumPollingTime / 2)
+    {
+        backoff = handleData->getMaximumPollingTime;
+    }
+    else
+    {
+        backoff = deviceData->pollingBackoff * 2;
+    }
+    deviceData->pollingBackoff = backoff;
+
+    /*up to a quarter earlier, so that devices that started together do not keep polling together*/
+    deviceData->pollingTime = backoff - (unsigned int)(rand() % (backoff / 4 + 1));
+}
+
+static void DoMessages(HTTPTRANSPORT_HANDLE_DATA* handleData, HTTPTRANSPORT_PERDEVICE_DATA* deviceData)
+{
+    if (deviceData->DoWork_PullMessage)
+    {
+        time_t timeNow = get_time(NULL);
+        bool isPollingAllowed = deviceData->isFirstPoll || (timeNow == (time_t)(-1)) || (get_difftime(timeNow, deviceData->lastPollTime) > getPollingTime(handleData, deviceData));
+        if (isPollingAllowed)
+        {
+            unsigned int messagesReceived = 0;
+            while ((messagesReceived < handleData->messagesPerPoll) && DoMessage(handleData, deviceData, timeNow))
+            {
+                messagesReceived++;
+            }
+
+            if (handleData->getMaximumPollingTime > handleData->getMinimumPollingTime)
+            {
+                updatePollingTime(handleData, deviceData, messagesReceived > 0);
             }
         }
         else
@@ -2175,6 +2298,24 @@ static IOTHUB_CLIENT_RESULT IoTHubTransportHttp_SetOption(TRANSPORT_LL_HANDLE ha
             handleData->getMinimumPollingTime = *(unsigned int*)value;
             result = IOTHUB_CLIENT_OK;
         }
+        else if (strcmp(OPTION_MAX_POLLING_TIME, option) == 0)
+        {
+            handleData->getMaximumPollingTime = *(unsigned int*)value;
+            result = IOTHUB_CLIENT_OK;
+        }
+        else if (strcmp(OPTION_MESSAGES_PER_POLL, option) == 0)
+        {
+            if (*(unsigned int*)value == 0)
+            {
+                result = IOTHUB_CLIENT_INVALID_ARG;
+                LogError("%s must be at least 1", OPTION_MESSAGES_PER_POLL);
+            }
+            else
+            {
+                handleData->messagesPerPoll = *(unsigned int*)value;
+                result = IOTHUB_CLIENT_OK;
+            }
+        }
         else
         {
             HTTPAPIEX_RESULT HTTPAPIEX_result = HTTPAPIEX_SetOption(handleData->httpApiExHandle, option, value);
@@ -2296,7 +2437,8 @@ static TRANSPORT_PROVIDER thisTransportProvider =
     IotHubTransportHttp_Unsubscribe_InputQueue,     /*pfIoTHubTransport_Unsubscribe_InputQueue IoTHubTransport_Unsubscribe_InputQueue; */
     IoTHubTransportHttp_SetCallbackContext,         /*pfIoTHubTransport_SetTransportCallbacks IoTHubTransport_SetTransportCallbacks; */
     IoTHubTransportHttp_GetTwinAsync,               /*pfIoTHubTransport_GetTwinAsync IoTHubTransport_GetTwinAsync;*/
-    IoTHubTransportHttp_GetSupportedPlatformInfo      /*pfIoTHubTransport_GetSupportedPlatformInfo IoTHubTransport_GetSupportedPlatformInfo;*/
+    IoTHubTransportHttp_GetSupportedPlatformInfo,     /*pfIoTHubTransport_GetSupportedPlatformInfo IoTHubTransport_GetSupportedPlatformInfo;*/
+    NULL                                            /*pfIoTHubTransport_GetPollInfo IoTHubTransport_GetPollInfo;*/
 };
 
 const TRANSPORT_PROVIDER* HTTP_Protocol(void)
@@ -195,6 +195,11 @@ static int IotHubTransportMqtt_WS_GetSupportedPlatformInfo(TRANSPORT_LL_HANDLE h
     return IoTHubTransport_MQTT_GetSupportedPlatformInfo(handle, info);
 }
 
+static IOTHUB_CLIENT_RESULT IotHubTransportMqtt_WS_GetPollInfo(TRANSPORT_LL_HANDLE handle, bool hasQueuedItems, IOTHUB_CLIENT_POLL_INFO* pollInfo)
+{
+    return IoTHubTransport_MQTT_Common_GetPollInfo(handle, hasQueuedItems, pollInfo);
+}
+
 static TRANSPORT_PROVIDER thisTransportProvider_WebSocketsOverTls = {
     IoTHubTransportMqtt_WS_SendMessageDisposition,
     IoTHubTransportMqtt_WS_Subscribe_DeviceMethod,
@@ -218,7 +223,8 @@ static TRANSPORT_PROVIDER thisTransportProvider_WebSocketsOverTls = {
     IoTHubTransportMqtt_WS_Unsubscribe_InputQueue,
     IotHubTransportMqtt_WS_SetCallbackContext,
     IoTHubTransportMqtt_WS_GetTwinAsync,
-    IotHubTransportMqtt_WS_GetSupportedPlatformInfo
+    IotHubTransportMqtt_WS_GetSupportedPlatformInfo,
+    IotHubTransportMqtt_WS_GetPollInfo
 };
 
 const TRANSPORT_PROVIDER* MQTT_WebSocket_Protocol(void)
@@ -22,6 +22,7 @@
 #include "iothub_message.h"
 
 #include "internal/iothub_internal_consts.h"
+#include "internal/iothub_message_private.h"
 
 #ifndef RESULT_OK
 #define RESULT_OK 0
@@ -29,6 +30,12 @@
 
 #define MESSAGE_ID_MAX_SIZE 128
 
+// Encoding of the amqp:data:binary descriptor: described type constructor followed by smallulong 0x75.
+static const unsigned char AMQP_DATA_SECTION_DESCRIPTOR[] = { 0x00, 0x53, 0x75 };
+#define AMQP_VBIN8_CONSTRUCTOR 0xA0
+#define AMQP_VBIN32_CONSTRUCTOR 0xB0
+#define AMQP_VBIN8_MAX_LENGTH 255
+
 #define AMQP_DIAGNOSTIC_ID_KEY "Diagnostic-Id"
 #define AMQP_DIAGNOSTIC_CONTEXT_KEY "Correlation-Context"
 #define AMQP_DIAGNOSTIC_CREATION_TIME_UTC_KEY "creationtimeutc"
@@ -221,7 +228,7 @@ static int create_message_properties_to_encode(IOTHUB_MESSAGE_HANDLE messageHand
 }
 
 // Adds fault injection properties to an AMQP message.
-static int add_fault_injection_properties(MESSAGE_HANDLE message_batch_container, const char* const* property_keys, const char* const* property_values, size_t property_count)
+static int add_fault_injection_properties(MESSAGE_HANDLE message_batch_container, IOTHUB_MESSAGE_HANDLE messageHandle, size_t property_count)
 {
     int result;
     AMQP_VALUE uamqp_map;
@@ -233,19 +240,27 @@ static int add_fault_injection_properties(MESSAGE_HANDLE message_batch_container
     }
     else
     {
+        size_t cursor = 0;
         result = RESULT_OK;
 
         for (size_t i = 0; result == RESULT_OK && i < property_count; i++)
         {
+            const char* property_key;
+            const char* property_value;
             AMQP_VALUE map_key_value = NULL;
             AMQP_VALUE map_value_value = NULL;
 
-            if ((map_key_value = amqpvalue_create_string(property_keys[i])) == NULL)
+            if (IoTHubMessage_GetNextProperty(messageHandle, &cursor, &property_key, &property_value) != IOTHUB_MESSAGE_OK)
+            {
+                LogError("Failed reading the message properties.");
+                result = MU_FAILURE;
+            }
+            else if ((map_key_value = amqpvalue_create_string(property_key)) == NULL)
             {
                 LogError("Failed to create uAMQP property key name.");
                 result = MU_FAILURE;
             }
-            else if ((map_value_value = amqpvalue_create_string(property_values[i])) == NULL)
+            else if ((map_value_value = amqpvalue_create_string(property_value)) == NULL)
             {
                 LogError("Failed to create uAMQP property key value.");
                 result = MU_FAILURE;
@@ -284,11 +299,11 @@ static int add_fault_injection_properties(MESSAGE_HANDLE message_batch_container
 // To test AMQP fault injection, we currently must have the error properties be specified on the batch_container
 // (not one of the messages sent in this container).  As the SDK layer does not support options for configuring
 // this envelope (this is AMQP/batching specific), we will instead intercept fault messages and apply to the container.
-static int override_fault_injection_properties_if_needed(MESSAGE_HANDLE message_batch_container,  const char* const* property_keys, const char* const* property_values, size_t property_count, bool *override_for_fault_injection)
+static int override_fault_injection_properties_if_needed(MESSAGE_HANDLE message_batch_container, IOTHUB_MESSAGE_HANDLE messageHandle, const char* first_property_key, size_t property_count, bool *override_for_fault_injection)
 {
     int result;
 
-    if ((property_count == 0) || (strcmp(property_keys[0], "AzIoTHub_FaultOperationType") != 0))
+    if ((property_count == 0) || (strcmp(first_property_key, "AzIoTHub_FaultOperationType") != 0))
     {
         *override_for_fault_injection = false;
         result = RESULT_OK;
@@ -296,7 +311,7 @@ static int override_fault_injection_properties_if_needed(MESSAGE_HANDLE message_
     else
     {
         *override_for_fault_injection = true;
-        result = add_fault_injection_properties(message_batch_container,  property_keys, property_values, property_count);
+        result = add_fault_injection_properties(message_batch_container, messageHandle, property_count);
     }
 
     return result;
@@ -304,24 +319,14 @@ static int override_fault_injection_properties_if_needed(MESSAGE_HANDLE message_
 
 static int create_application_properties_to_encode(MESSAGE_HANDLE message_batch_container, IOTHUB_MESSAGE_HANDLE messageHandle, AMQP_VALUE *application_properties, size_t *application_properties_length)
 {
-    MAP_HANDLE properties_map;
-    const char* const* property_keys = NULL;
-    const char* const* property_values = NULL;
     const char* message_creation_time_utc;
     size_t property_count = 0;
     AMQP_VALUE uamqp_properties_map = NULL;
     int result = RESULT_OK;
 
-    if ((properties_map = IoTHubMessage_Properties(messageHandle)) == NULL)
-    {
-        LogError("Failed to get property map from IoTHub message.");
-        result = MU_FAILURE;
-    }
-
-    if (RESULT_OK == result &&
-        NULL != (message_creation_time_utc = IoTHubMessage_GetMessageCreationTimeUtcSystemProperty(messageHandle)))
+    if (NULL != (message_creation_time_utc = IoTHubMessage_GetMessageCreationTimeUtcSystemProperty(messageHandle)))
     {
-        if (Map_AddOrUpdate(properties_map, AMQP_IOTHUB_CREATION_TIME_UTC, message_creation_time_utc) != MAP_OK)
+        if (IoTHubMessage_SetProperty(messageHandle, AMQP_IOTHUB_CREATION_TIME_UTC, message_creation_time_utc) != IOTHUB_MESSAGE_OK)
         {
             LogError("Failed to add/update application message property map.");
             result = MU_FAILURE;
@@ -329,23 +334,32 @@ static int create_application_properties_to_encode(MESSAGE_HANDLE message_batch_
     }
 
     if (RESULT_OK == result &&
-        Map_GetInternals(properties_map, &property_keys, &property_values, &property_count) != MAP_OK)
+        IoTHubMessage_GetPropertyCount(messageHandle, &property_count) != IOTHUB_MESSAGE_OK)
     {
-        LogError("Failed reading the incoming uAMQP message properties");
+        LogError("Failed reading the message properties");
         result = MU_FAILURE;
     }
     else if (property_count > 0)
     {
         size_t i;
+        size_t cursor = 0;
+        const char* property_key;
+        const char* property_value;
+
         if ((uamqp_properties_map = amqpvalue_create_map()) == NULL)
         {
             LogError("amqpvalue_create_map failed");
             result = MU_FAILURE;
         }
+        else if (IoTHubMessage_GetNextProperty(messageHandle, &cursor, &property_key, &property_value) != IOTHUB_MESSAGE_OK)
+        {
+            LogError("Failed reading the message properties");
+            result = MU_FAILURE;
+        }
         else
         {
             bool override_for_fault_injection = false;
-            result = override_fault_injection_properties_if_needed(message_batch_container, property_keys, property_values, property_count, &override_for_fault_injection);
+            result = override_fault_injection_properties_if_needed(message_batch_container, messageHandle, property_key, property_count, &override_for_fault_injection);
 
             if (override_for_fault_injection == false)
             {
@@ -354,14 +368,21 @@ static int create_application_properties_to_encode(MESSAGE_HANDLE message_batch_
                     AMQP_VALUE map_property_key;
                     AMQP_VALUE map_property_value;
 
-                    if ((map_property_key = amqpvalue_create_string(property_keys[i])) == NULL)
+                    if (i > 0 && IoTHubMessage_GetNextProperty(messageHandle, &cursor, &property_key, &property_value) != IOTHUB_MESSAGE_OK)
+                    {
+                        LogError("Failed reading the message properties");
+                        result = MU_FAILURE;
+                        break;
+                    }
+
+                    if ((map_property_key = amqpvalue_create_string(property_key)) == NULL)
                     {
                         LogError("Failed amqpvalue_create_string for key");
                         result = MU_FAILURE;
                         break;
                     }
 
-                    if ((map_property_value = amqpvalue_create_string(property_values[i])) == NULL)
+                    if ((map_property_value = amqpvalue_create_string(property_value)) == NULL)
                     {
                         LogError("Failed amqpvalue_create_string for value");
                         amqpvalue_destroy(map_property_key);
@@ -478,7 +499,10 @@ static int create_diagnostic_message_annotations(IOTHUB_MESSAGE_HANDLE messageHa
 
         if (result == RESULT_OK)
         {
-            char* diagContextBuffer = NULL;
+            // The message bounds the creation time, so the context fits on the stack
+            char diagContextBuffer[sizeof(AMQP_DIAGNOSTIC_CREATION_TIME_UTC_KEY) + 1 + IOTHUB_MESSAGE_DIAGNOSTIC_CREATION_TIME_MAX_LENGTH];
+            size_t creationTimeLength = strlen(diagnosticData->diagnosticCreationTimeUtc);
+
             if (add_map_item(*message_annotations_map, AMQP_DIAGNOSTIC_ID_KEY, diagnosticData->diagnosticId) != RESULT_OK)
             {
                 LogError("Failed adding diagnostic id");
@@ -489,10 +513,9 @@ static int create_diagnostic_message_annotations(IOTHUB_MESSAGE_HANDLE messageHa
                     *message_annotations_map = NULL;
                 }
             }
-            else if ((diagContextBuffer = (char*)malloc(strlen(AMQP_DIAGNOSTIC_CREATION_TIME_UTC_KEY) + 1
-                + strlen(diagnosticData->diagnosticCreationTimeUtc) + 1)) == NULL)
+            else if (creationTimeLength > IOTHUB_MESSAGE_DIAGNOSTIC_CREATION_TIME_MAX_LENGTH)
             {
-                LogError("Failed malloc for diagnostic context");
+                LogError("Diagnostic creation time too long (%lu)", (unsigned long)creationTimeLength);
                 result = MU_FAILURE;
                 if (annotation_created)
                 {
@@ -500,27 +523,23 @@ static int create_diagnostic_message_annotations(IOTHUB_MESSAGE_HANDLE messageHa
                     *message_annotations_map = NULL;
                 }
             }
-            else if (sprintf(diagContextBuffer, "%s=%s", AMQP_DIAGNOSTIC_CREATION_TIME_UTC_KEY, diagnosticData->diagnosticCreationTimeUtc) < 0)
-            {
-                LogError("Failed sprintf diagnostic context");
-                result = MU_FAILURE;
-                if (annotation_created)
-                {
-                    amqpvalue_destroy(*message_annotations_map);
-                    *message_annotations_map = NULL;
-                }
-            }
-            else if (add_map_item(*message_annotations_map, AMQP_DIAGNOSTIC_CONTEXT_KEY, diagContextBuffer) != RESULT_OK)
+            else
             {
-                LogError("Failed adding diagnostic context");
-                result = MU_FAILURE;
-                if (annotation_created)
+                (void)memcpy(diagContextBuffer, AMQP_DIAGNOSTIC_CREATION_TIME_UTC_KEY, sizeof(AMQP_DIAGNOSTIC_CREATION_TIME_UTC_KEY) - 1);
+                diagContextBuffer[sizeof(AMQP_DIAGNOSTIC_CREATION_TIME_UTC_KEY) - 1] = '=';
+                (void)memcpy(diagContextBuffer + sizeof(AMQP_DIAGNOSTIC_CREATION_TIME_UTC_KEY), diagnosticData->diagnosticCreationTimeUtc, creationTimeLength + 1);
+
+                if (add_map_item(*message_annotations_map, AMQP_DIAGNOSTIC_CONTEXT_KEY, diagContextBuffer) != RESULT_OK)
                 {
-                    amqpvalue_destroy(*message_annotations_map);
-                    *message_annotations_map = NULL;
+                    LogError("Failed adding diagnostic context");
+                    result = MU_FAILURE;
+                    if (annotation_created)
+                    {
+                        amqpvalue_destroy(*message_annotations_map);
+                        *message_annotations_map = NULL;
+                    }
                 }
             }
-            free(diagContextBuffer);
         }
     }
     return result;
@@ -601,7 +620,7 @@ static int create_message_annotations_to_encode(IOTHUB_MESSAGE_HANDLE messageHan
     return result;
 }
 
-static int create_data_to_encode(IOTHUB_MESSAGE_HANDLE messageHandle, AMQP_VALUE *data_value, size_t *data_length)
+static int get_message_body(IOTHUB_MESSAGE_HANDLE messageHandle, const unsigned char** body, size_t* body_length)
 {
     int result;
 
@@ -633,22 +652,17 @@ static int create_data_to_encode(IOTHUB_MESSAGE_HANDLE messageHandle, AMQP_VALUE
             messageContentSize = messageContent != NULL ? strlen(messageContent) : 0;
         }
 
-        data bin_data;
-        bin_data.bytes = (const unsigned char *)messageContent;
-        bin_data.length = (uint32_t)messageContentSize;
-
-        if ((*data_value = amqpvalue_create_data(bin_data)) == NULL)
-        {
-            LogError("amqpvalue_create_data failed");
-            result = MU_FAILURE;
-        }
-        else if (amqpvalue_get_encoded_size(*data_value, data_length) != 0)
+#if SIZE_MAX > UINT32_MAX
+        if (messageContentSize > UINT32_MAX)
         {
-            LogError("amqpvalue_get_encoded_size failed");
+            LogError("Message body of %lu bytes is too large", (unsigned long)messageContentSize);
             result = MU_FAILURE;
         }
         else
+#endif
         {
+            *body = (const unsigned char*)messageContent;
+            *body_length = messageContentSize;
             result = RESULT_OK;
         }
     }
@@ -656,6 +670,52 @@ static int create_data_to_encode(IOTHUB_MESSAGE_HANDLE messageHandle, AMQP_VALUE
     return result;
 }
 
+// The body is encoded as an amqp:data:binary section (a binary described by ulong 0x75) written straight into the
+// encoded message, so it is copied once.  Going through amqpvalue_create_data would first copy it into the AMQP_VALUE.
+static size_t get_data_section_encoded_size(size_t body_length)
+{
+    return sizeof(AMQP_DATA_SECTION_DESCRIPTOR) + ((body_length <= AMQP_VBIN8_MAX_LENGTH) ? 2 : 5) + body_length;
+}
+
+static int encode_data_section(BINARY_DATA* message_body_binary, const unsigned char* body, size_t body_length)
+{
+    int result;
+    unsigned char header[sizeof(AMQP_DATA_SECTION_DESCRIPTOR) + 5];
+    size_t header_length = sizeof(AMQP_DATA_SECTION_DESCRIPTOR);
+
+    (void)memcpy(header, AMQP_DATA_SECTION_DESCRIPTOR, sizeof(AMQP_DATA_SECTION_DESCRIPTOR));
+    if (body_length <= AMQP_VBIN8_MAX_LENGTH)
+    {
+        header[header_length++] = AMQP_VBIN8_CONSTRUCTOR;
+        header[header_length++] = (unsigned char)body_length;
+    }
+    else
+    {
+        header[header_length++] = AMQP_VBIN32_CONSTRUCTOR;
+        header[header_length++] = (unsigned char)((body_length >> 24) & 0xFF);
+        header[header_length++] = (unsigned char)((body_length >> 16) & 0xFF);
+        header[header_length++] = (unsigned char)((body_length >> 8) & 0xFF);
+        header[header_length++] = (unsigned char)(body_length & 0xFF);
+    }
+
+    if (encode_callback(message_body_binary, header, header_length) != 0)
+    {
+        LogError("Failed encoding the data section header");
+        result = MU_FAILURE;
+    }
+    else if ((body_length > 0) && (encode_callback(message_body_binary, body, body_length) != 0))
+    {
+        LogError("Failed encoding the data section body");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        result = RESULT_OK;
+    }
+
+    return result;
+}
+
 int message_create_uamqp_encoding_from_iothub_message(MESSAGE_HANDLE message_batch_container, IOTHUB_MESSAGE_HANDLE message_handle, BINARY_DATA* body_binary_data)
 {
     int result;
@@ -663,7 +723,8 @@ int message_create_uamqp_encoding_from_iothub_message(MESSAGE_HANDLE message_bat
     AMQP_VALUE message_properties = NULL;
     AMQP_VALUE application_properties = NULL;
     AMQP_VALUE message_annotations = NULL;
-    AMQP_VALUE data_value = NULL;
+    const unsigned char* body = NULL;
+    size_t body_length = 0;
     size_t message_properties_length = 0;
     size_t application_properties_length = 0;
     size_t message_annotations_length = 0;
@@ -688,15 +749,20 @@ int message_create_uamqp_encoding_from_iothub_message(MESSAGE_HANDLE message_bat
         LogError("create_message_annotations_to_encode() failed");
         result = MU_FAILURE;
     }
-    else if (create_data_to_encode(message_handle, &data_value, &data_length) != RESULT_OK)
+    else if (get_message_body(message_handle, &body, &body_length) != RESULT_OK)
     {
-        LogError("create_data_to_encode() failed");
+        LogError("get_message_body() failed");
+        result = MU_FAILURE;
+    }
+    else if ((data_length = get_data_section_encoded_size(body_length)) < body_length)
+    {
+        LogError("Message body of %lu bytes is too large", (unsigned long)body_length);
         result = MU_FAILURE;
     }
     else if ((malloc_size = safe_add_size_t(safe_add_size_t(safe_add_size_t(message_properties_length, application_properties_length), data_length), message_annotations_length)) == SIZE_MAX ||
         (body_binary_data->bytes = malloc(malloc_size)) == NULL)
     {
-        LogError("malloc of %zu bytes failed", malloc_size);
+        LogError("malloc of %lu bytes failed", (unsigned long)malloc_size);
         result = MU_FAILURE;
     }
     else if (amqpvalue_encode(message_properties, &encode_callback, body_binary_data) != RESULT_OK)
@@ -714,9 +780,9 @@ int message_create_uamqp_encoding_from_iothub_message(MESSAGE_HANDLE message_bat
         LogError("amqpvalue_encode() for message annotations failed");
         result = MU_FAILURE;
     }
-    else if (RESULT_OK != amqpvalue_encode(data_value, &encode_callback, body_binary_data))
+    else if (encode_data_section(body_binary_data, body, body_length) != RESULT_OK)
     {
-        LogError("amqpvalue_encode() for data value failed");
+        LogError("encode_data_section() failed");
         result = MU_FAILURE;
     }
     else
@@ -725,11 +791,6 @@ int message_create_uamqp_encoding_from_iothub_message(MESSAGE_HANDLE message_bat
         result = RESULT_OK;
     }
 
-    if (NULL != data_value)
-    {
-        amqpvalue_destroy(data_value);
-    }
-
     if (NULL != application_properties)
     {
         amqpvalue_destroy(application_properties);
@@ -1055,14 +1116,8 @@ static int readApplicationPropertiesFromuAMQPMessage(IOTHUB_MESSAGE_HANDLE iothu
     AMQP_VALUE uamqp_app_properties = NULL;
     AMQP_VALUE uamqp_app_properties_ipdv = NULL;
     uint32_t property_count = 0;
-    MAP_HANDLE iothub_message_properties_map;
 
-    if ((iothub_message_properties_map = IoTHubMessage_Properties(iothub_message_handle)) == NULL)
-    {
-        LogError("Failed to get property map from IoTHub message.");
-        result = MU_FAILURE;
-    }
-    else if ((result = message_get_application_properties(uamqp_message, &uamqp_app_properties)) != 0)
+    if ((result = message_get_application_properties(uamqp_message, &uamqp_app_properties)) != 0)
     {
         LogError("Failed reading the incoming uAMQP message properties (return code %d).", result);
         result = MU_FAILURE;
@@ -1113,9 +1168,9 @@ static int readApplicationPropertiesFromuAMQPMessage(IOTHUB_MESSAGE_HANDLE iothu
                             LogError("Failed parsing the uAMQP property value (return code %d).", result);
                             result = MU_FAILURE;
                         }
-                        else if (Map_AddOrUpdate(iothub_message_properties_map, key_name, key_value) != MAP_OK)
+                        else if (IoTHubMessage_SetProperty(iothub_message_handle, key_name, key_value) != IOTHUB_MESSAGE_OK)
                         {
-                            LogError("Failed to add/update IoTHub message property map.");
+                            LogError("Failed to add/update IoTHub message property.");
                             result = MU_FAILURE;
                         }
 
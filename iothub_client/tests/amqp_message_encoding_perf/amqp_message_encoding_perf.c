@@ -0,0 +1,172 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// Measures the throughput of encoding large telemetry messages for the AMQP transport.  "amqpvalue_data" encodes the
+// body the way uAMQP would on its own (amqpvalue_create_data takes a copy of the body, which is then encoded into the
+// output buffer); "uamqp_messaging" runs message_create_uamqp_encoding_from_iothub_message, which writes the data
+// section straight from the message body.
+//
+// Output is CSV on stdout, one line per encoder and body size:
+//     encoder,body_bytes,iterations,elapsed_ms,mb_per_sec
+//
+// Usage: amqp_message_encoding_perf [iterations]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "azure_c_shared_utility/platform.h"
+#include "azure_uamqp_c/amqpvalue.h"
+#include "iothub_message.h"
+#include "internal/uamqp_messaging.h"
+
+static const size_t BODY_SIZES[] = { 16 * 1024, 64 * 1024, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024 };
+
+static const int DEFAULT_ITERATIONS = 100;
+
+typedef int(*ENCODE_FUNCTION)(IOTHUB_MESSAGE_HANDLE message, BINARY_DATA* encoded);
+
+static int encode_callback(void* context, const unsigned char* bytes, size_t length)
+{
+    BINARY_DATA* encoded = (BINARY_DATA*)context;
+    (void)memcpy((unsigned char*)encoded->bytes + encoded->length, bytes, length);
+    encoded->length += length;
+    return 0;
+}
+
+static int encode_with_amqpvalue_data(IOTHUB_MESSAGE_HANDLE message, BINARY_DATA* encoded)
+{
+    int result;
+    const unsigned char* body;
+    size_t bodyLength;
+    size_t encodedSize;
+    data bodyData;
+    AMQP_VALUE dataValue;
+
+    encoded->bytes = NULL;
+    encoded->length = 0;
+
+    if (IoTHubMessage_GetByteArray(message, &body, &bodyLength) != IOTHUB_MESSAGE_OK)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        bodyData.bytes = body;
+        bodyData.length = (uint32_t)bodyLength;
+
+        if ((dataValue = amqpvalue_create_data(bodyData)) == NULL)
+        {
+            result = __LINE__;
+        }
+        else
+        {
+            if ((amqpvalue_get_encoded_size(dataValue, &encodedSize) != 0) ||
+                ((encoded->bytes = (const unsigned char*)malloc(encodedSize)) == NULL) ||
+                (amqpvalue_encode(dataValue, encode_callback, encoded) != 0))
+            {
+                result = __LINE__;
+            }
+            else
+            {
+                result = 0;
+            }
+            amqpvalue_destroy(dataValue);
+        }
+    }
+
+    return result;
+}
+
+static int encode_with_uamqp_messaging(IOTHUB_MESSAGE_HANDLE message, BINARY_DATA* encoded)
+{
+    return message_create_uamqp_encoding_from_iothub_message(NULL, message, encoded);
+}
+
+static void run_benchmark(const char* name, ENCODE_FUNCTION encode, IOTHUB_MESSAGE_HANDLE message, size_t bodyLength, int iterations)
+{
+    clock_t start;
+    double elapsedMs;
+    int i;
+
+    start = clock();
+
+    for (i = 0; i < iterations; i++)
+    {
+        BINARY_DATA encoded;
+        if (encode(message, &encoded) != 0)
+        {
+            (void)printf("%s failed encoding a %lu byte message\r\n", name, (unsigned long)bodyLength);
+            free((void*)encoded.bytes);
+            return;
+        }
+        free((void*)encoded.bytes);
+    }
+
+    elapsedMs = ((double)(clock() - start) * 1000.0) / CLOCKS_PER_SEC;
+
+    (void)printf("%s,%lu,%d,%.3f,%.1f\r\n", name, (unsigned long)bodyLength, iterations, elapsedMs / iterations,
+        (elapsedMs > 0) ? (((double)bodyLength * iterations) / (1024.0 * 1024.0)) / (elapsedMs / 1000.0) : 0.0);
+}
+
+int main(int argc, char* argv[])
+{
+    int result;
+    int iterations = (argc > 1) ? atoi(argv[1]) : DEFAULT_ITERATIONS;
+
+    if (iterations <= 0)
+    {
+        (void)printf("usage: amqp_message_encoding_perf [iterations]\r\n");
+        result = EXIT_FAILURE;
+    }
+    else if (platform_init() != 0)
+    {
+        (void)printf("platform_init failed\r\n");
+        result = EXIT_FAILURE;
+    }
+    else
+    {
+        size_t i;
+
+        result = EXIT_SUCCESS;
+
+        (void)printf("encoder,body_bytes,iterations,elapsed_ms,mb_per_sec\r\n");
+
+        for (i = 0; i < sizeof(BODY_SIZES) / sizeof(BODY_SIZES[0]); i++)
+        {
+            unsigned char* body;
+            IOTHUB_MESSAGE_HANDLE message;
+
+            if ((body = (unsigned char*)malloc(BODY_SIZES[i])) == NULL)
+            {
+                (void)printf("Unable to allocate %lu bytes for the message body\r\n", (unsigned long)BODY_SIZES[i]);
+                result = EXIT_FAILURE;
+                break;
+            }
+
+            (void)memset(body, 0xA5, BODY_SIZES[i]);
+
+            if ((message = IoTHubMessage_CreateFromByteArray(body, BODY_SIZES[i])) == NULL)
+            {
+                (void)printf("Unable to create the message\r\n");
+                free(body);
+                result = EXIT_FAILURE;
+                break;
+            }
+
+            (void)IoTHubMessage_SetContentTypeSystemProperty(message, "application/octet-stream");
+            (void)IoTHubMessage_SetProperty(message, "frame", "1");
+
+            run_benchmark("amqpvalue_data", encode_with_amqpvalue_data, message, BODY_SIZES[i], iterations);
+            run_benchmark("uamqp_messaging", encode_with_uamqp_messaging, message, BODY_SIZES[i], iterations);
+
+            IoTHubMessage_Destroy(message);
+            free(body);
+        }
+
+        platform_deinit();
+    }
+
+    return result;
+}
@@ -0,0 +1,343 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// HTTP stand-in: replaces the platform HTTPAPI adapter (these definitions take precedence over the one linked from the
+// shared utility library) with the devicebound endpoint of IoT Hub.  Each device has a queue; a GET hands out the
+// oldest queued message with 200 and its id as ETag, or answers 204 when the queue is empty, a DELETE completes the
+// message and a POST .../abandon puts it back at the front.  Every other request is answered with 204.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "azure_c_shared_utility/httpapi.h"
+#include "azure_c_shared_utility/httpheaders.h"
+#include "azure_c_shared_utility/buffer_.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#include "c2d_httpapi.h"
+
+#define HTTP_STATUS_OK              200
+#define HTTP_STATUS_NO_CONTENT      204
+#define HTTP_STATUS_NOT_FOUND       404
+
+#define DEVICEBOUND_ENDPOINT        "/messages/devicebound"
+
+typedef struct C2D_MESSAGE_TAG
+{
+    time_t enqueued;
+    size_t device_index;
+    struct C2D_MESSAGE_TAG* next;
+    /* Handed out by a GET and not completed or abandoned yet. */
+    int is_locked;
+} C2D_MESSAGE;
+
+typedef struct DEVICE_QUEUE_TAG
+{
+    C2D_MESSAGE* head;
+    C2D_MESSAGE* tail;
+} DEVICE_QUEUE;
+
+typedef struct HTTP_HANDLE_DATA_TAG
+{
+    int unused;
+} HTTP_HANDLE_DATA;
+
+static size_t device_count;
+static DEVICE_QUEUE* queues;
+static size_t max_messages;
+static size_t message_count;
+static C2D_MESSAGE* messages;
+static double* latencies;
+static C2D_HTTPAPI_STATS stats;
+
+int c2d_httpapi_reset(size_t devices, size_t messages_capacity)
+{
+    int result;
+
+    c2d_httpapi_deinit();
+
+    if ((queues = (DEVICE_QUEUE*)calloc(devices, sizeof(DEVICE_QUEUE))) == NULL ||
+        (messages = (C2D_MESSAGE*)calloc(messages_capacity, sizeof(C2D_MESSAGE))) == NULL ||
+        (latencies = (double*)calloc(messages_capacity, sizeof(double))) == NULL)
+    {
+        LogError("Failed allocating the devicebound queues");
+        c2d_httpapi_deinit();
+        result = __LINE__;
+    }
+    else
+    {
+        device_count = devices;
+        max_messages = messages_capacity;
+        message_count = 0;
+        memset(&stats, 0, sizeof(stats));
+        stats.latencies = latencies;
+        result = 0;
+    }
+
+    return result;
+}
+
+void c2d_httpapi_deinit(void)
+{
+    free(queues);
+    free(messages);
+    free(latencies);
+    queues = NULL;
+    messages = NULL;
+    latencies = NULL;
+    device_count = 0;
+    max_messages = 0;
+    message_count = 0;
+}
+
+int c2d_httpapi_enqueue(size_t device_index)
+{
+    int result;
+
+    if (device_index >= device_count || message_count >= max_messages)
+    {
+        LogError("Invalid device %lu or too many messages", (unsigned long)device_index);
+        result = __LINE__;
+    }
+    else
+    {
+        C2D_MESSAGE* message = &messages[message_count++];
+        DEVICE_QUEUE* queue = &queues[device_index];
+
+        message->enqueued = virtual_clock_get();
+        message->device_index = device_index;
+        message->next = NULL;
+        message->is_locked = 0;
+
+        if (queue->tail == NULL)
+        {
+            queue->head = message;
+        }
+        else
+        {
+            queue->tail->next = message;
+        }
+        queue->tail = message;
+        result = 0;
+    }
+
+    return result;
+}
+
+void c2d_httpapi_get_stats(C2D_HTTPAPI_STATS* result)
+{
+    *result = stats;
+}
+
+/* Reads the device index from the digits ending the device id, that is right before the devicebound endpoint. */
+static int get_device_index(const char* relativePath, const char* endpoint, size_t* device_index)
+{
+    int result;
+    const char* end = endpoint;
+    const char* begin = end;
+
+    while (begin > relativePath && isdigit((unsigned char)begin[-1]))
+    {
+        begin--;
+    }
+
+    if (begin == end)
+    {
+        result = __LINE__;
+    }
+    else
+    {
+        *device_index = (size_t)strtoul(begin, NULL, 10);
+        result = (*device_index < device_count) ? 0 : __LINE__;
+    }
+
+    return result;
+}
+
+static unsigned int get_message(size_t device_index, HTTP_HEADERS_HANDLE responseHeadersHandle, BUFFER_HANDLE responseContent)
+{
+    unsigned int result;
+    DEVICE_QUEUE* queue = &queues[device_index];
+
+    stats.polls++;
+
+    if (queue->head == NULL)
+    {
+        stats.empty_polls++;
+        result = HTTP_STATUS_NO_CONTENT;
+    }
+    else
+    {
+        C2D_MESSAGE* message = queue->head;
+        size_t id = (size_t)(message - messages);
+        char etag[32];
+        char body[48];
+
+        (void)sprintf(etag, "\"%lu\"", (unsigned long)id);
+        (void)sprintf(body, "c2d message %lu", (unsigned long)id);
+
+        if (HTTPHeaders_AddHeaderNameValuePair(responseHeadersHandle, "ETag", etag) != HTTP_HEADERS_OK ||
+            BUFFER_build(responseContent, (const unsigned char*)body, strlen(body)) != 0)
+        {
+            LogError("Failed building the response");
+            result = HTTP_STATUS_NO_CONTENT;
+        }
+        else
+        {
+            queue->head = message->next;
+            if (queue->head == NULL)
+            {
+                queue->tail = NULL;
+            }
+            message->next = NULL;
+            message->is_locked = 1;
+
+            latencies[stats.delivered++] = difftime(virtual_clock_get(), message->enqueued);
+            result = HTTP_STATUS_OK;
+        }
+    }
+
+    return result;
+}
+
+static unsigned int settle_message(HTTPAPI_REQUEST_TYPE requestType, const char* lock_token)
+{
+    unsigned int result;
+    char* end;
+    unsigned long id = strtoul(lock_token, &end, 10);
+
+    if (end == lock_token || id >= message_count || !messages[id].is_locked)
+    {
+        result = HTTP_STATUS_NOT_FOUND;
+    }
+    else
+    {
+        C2D_MESSAGE* message = &messages[id];
+
+        message->is_locked = 0;
+
+        if (requestType == HTTPAPI_REQUEST_DELETE)
+        {
+            stats.completed++;
+        }
+        else
+        {
+            DEVICE_QUEUE* queue = &queues[message->device_index];
+
+            message->next = queue->head;
+            queue->head = message;
+            if (queue->tail == NULL)
+            {
+                queue->tail = message;
+            }
+            stats.abandoned++;
+        }
+
+        result = HTTP_STATUS_NO_CONTENT;
+    }
+
+    return result;
+}
+
+HTTPAPI_RESULT HTTPAPI_Init(void)
+{
+    return HTTPAPI_OK;
+}
+
+void HTTPAPI_Deinit(void)
+{
+}
+
+HTTP_HANDLE HTTPAPI_CreateConnection(const char* hostName)
+{
+    HTTP_HANDLE_DATA* result;
+
+    (void)hostName;
+
+    if ((result = (HTTP_HANDLE_DATA*)calloc(1, sizeof(HTTP_HANDLE_DATA))) == NULL)
+    {
+        LogError("Failed allocating the HTTP stand-in connection");
+    }
+
+    return result;
+}
+
+void HTTPAPI_CloseConnection(HTTP_HANDLE handle)
+{
+    free(handle);
+}
+
+HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+    HTTP_HEADERS_HANDLE httpHeadersHandle, const unsigned char* content,
+    size_t contentLength, unsigned int* statusCode,
+    HTTP_HEADERS_HANDLE responseHeadersHandle, BUFFER_HANDLE responseContent)
+{
+    HTTPAPI_RESULT result;
+
+    (void)httpHeadersHandle;
+    (void)content;
+    (void)contentLength;
+
+    if (handle == NULL || relativePath == NULL)
+    {
+        result = HTTPAPI_INVALID_ARG;
+    }
+    else
+    {
+        const char* endpoint = strstr(relativePath, DEVICEBOUND_ENDPOINT);
+        size_t device_index;
+        unsigned int status;
+
+        if (endpoint == NULL)
+        {
+            /* Telemetry and anything else the transport sends. */
+            status = HTTP_STATUS_NO_CONTENT;
+        }
+        else if (get_device_index(relativePath, endpoint, &device_index) != 0)
+        {
+            LogError("Unknown device in %s", relativePath);
+            status = HTTP_STATUS_NOT_FOUND;
+        }
+        else if (endpoint[sizeof(DEVICEBOUND_ENDPOINT) - 1] == '/')
+        {
+            /* .../devicebound/{lock token}?api-version=... completes, .../devicebound/{lock token}/abandon?... abandons. */
+            status = settle_message(requestType, &endpoint[sizeof(DEVICEBOUND_ENDPOINT)]);
+        }
+        else if (requestType == HTTPAPI_REQUEST_GET)
+        {
+            status = get_message(device_index, responseHeadersHandle, responseContent);
+        }
+        else
+        {
+            status = HTTP_STATUS_NO_CONTENT;
+        }
+
+        if (statusCode != NULL)
+        {
+            *statusCode = status;
+        }
+
+        result = HTTPAPI_OK;
+    }
+
+    return result;
+}
+
+HTTPAPI_RESULT HTTPAPI_SetOption(HTTP_HANDLE handle, const char* optionName, const void* value)
+{
+    (void)handle;
+    (void)optionName;
+    (void)value;
+    return HTTPAPI_OK;
+}
+
+HTTPAPI_RESULT HTTPAPI_CloneOption(const char* optionName, const void* value, const void** savedValue)
+{
+    (void)optionName;
+    (void)value;
+    /* Nothing to keep: options set on the stand-in are ignored. */
+    *savedValue = NULL;
+    return HTTPAPI_OK;
+}
@@ -0,0 +1,48 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// HTTP stand-in of the devicebound endpoint of IoT Hub for c2d_poll_perf, with a virtual clock in place of agenttime so
+// hours of polling run in a fraction of a second.
+
+#ifndef C2D_HTTPAPI_H
+#define C2D_HTTPAPI_H
+
+#include <stddef.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct C2D_HTTPAPI_STATS_TAG
+{
+    /* GETs on the devicebound endpoint, and those answered 204 because the queue of the device was empty. */
+    size_t polls;
+    size_t empty_polls;
+    /* Messages handed out by a GET, and completed (DELETE) or abandoned (POST .../abandon) afterwards. */
+    size_t delivered;
+    size_t completed;
+    size_t abandoned;
+    /* Seconds from c2d_httpapi_enqueue to the GET that handed the message out, one per delivered message. */
+    const double* latencies;
+} C2D_HTTPAPI_STATS;
+
+/* Empties the queues and clears the counters.  The device ids the clients use must end with the device index (0 to
+   device_count - 1); at most max_messages can be enqueued until the next reset. */
+extern int c2d_httpapi_reset(size_t device_count, size_t max_messages);
+extern void c2d_httpapi_deinit(void);
+
+/* Queues a message for the device, stamped with the current virtual time. */
+extern int c2d_httpapi_enqueue(size_t device_index);
+
+extern void c2d_httpapi_get_stats(C2D_HTTPAPI_STATS* stats);
+
+/* Time returned by get_time from now on (see virtual_clock.c). */
+extern void virtual_clock_set(time_t now);
+extern time_t virtual_clock_get(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* C2D_HTTPAPI_H */
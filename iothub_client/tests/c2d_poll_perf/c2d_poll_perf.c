@@ -0,0 +1,325 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// Compares the fixed interval C2D polling of the HTTP transport with the adaptive one (OPTION_MAX_POLLING_TIME and
+// OPTION_MESSAGES_PER_POLL), against an in-process stand-in of the devicebound endpoint of IoT Hub (see c2d_httpapi.c).
+// The transport and the clients are the real ones; the HTTPAPI adapter is replaced by the stand-in and agenttime by a
+// virtual clock, so an hour of polling by many devices runs in well under a second and runs are reproducible.
+//
+// The same traffic is replayed in each mode: messages arrive in bursts of 1 to burst_size for a random device at random
+// times during duration_s.  Every device client gets a DoWork each virtual second, and the run goes on after duration_s
+// until every message has been received or max_polling_s has passed twice with nothing received.
+//
+// Output is CSV on stdout, one line per mode:
+//     mode,devices,messages,duration_s,min_polling_s,max_polling_s,messages_per_poll,polls,empty_polls,polls_per_device_hour,delivered,mean_latency_s,p50_latency_s,p99_latency_s,max_latency_s
+//
+// polls counts the GETs on the devicebound endpoint.  Latency is measured from the arrival of a message in the queue of
+// its device to the GET that hands it to the device, in virtual seconds.
+//
+// Usage: c2d_poll_perf [devices [messages [duration_s [min_polling_s [max_polling_s [messages_per_poll [burst_size]]]]]]]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "iothub.h"
+#include "iothub_device_client_ll.h"
+#include "iothub_client_options.h"
+#include "iothub_message.h"
+#include "iothubtransporthttp.h"
+
+#include "c2d_httpapi.h"
+
+static const long DEFAULT_DEVICES = 100;
+static const long DEFAULT_MESSAGES = 1000;
+static const long DEFAULT_DURATION_S = 3600;
+static const long DEFAULT_MIN_POLLING_S = 10;
+static const long DEFAULT_MAX_POLLING_S = 300;
+static const long DEFAULT_MESSAGES_PER_POLL = 5;
+static const long DEFAULT_BURST_SIZE = 5;
+
+// Start of the virtual clock, any date will do
+static const time_t VIRTUAL_EPOCH = 1700000000;
+static const uint32_t TRAFFIC_SEED = 12345;
+
+static const char* CONNECTION_STRING_FORMAT = "HostName=loopback.azure-devices.net;DeviceId=c2d-perf-%lu;x509=true";
+
+typedef struct ARRIVAL_TAG
+{
+    long second;
+    size_t device_index;
+} ARRIVAL;
+
+typedef struct POLLING_MODE_TAG
+{
+    const char* name;
+    unsigned int min_polling_s;
+    unsigned int max_polling_s;
+    unsigned int messages_per_poll;
+} POLLING_MODE;
+
+// Own generator for the traffic, so it does not depend on (nor shift) the rand() sequence the transport jitters with
+static uint32_t next_random(uint32_t* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+static int compare_arrivals(const void* left, const void* right)
+{
+    long left_second = ((const ARRIVAL*)left)->second;
+    long right_second = ((const ARRIVAL*)right)->second;
+    return (left_second < right_second) ? -1 : ((left_second > right_second) ? 1 : 0);
+}
+
+static int compare_latencies(const void* left, const void* right)
+{
+    double left_latency = *(const double*)left;
+    double right_latency = *(const double*)right;
+    return (left_latency < right_latency) ? -1 : ((left_latency > right_latency) ? 1 : 0);
+}
+
+static void make_traffic(ARRIVAL* arrivals, size_t message_count, size_t device_count, long duration_s, size_t burst_size)
+{
+    uint32_t state = TRAFFIC_SEED;
+    size_t i = 0;
+
+    while (i < message_count)
+    {
+        long second = (long)(next_random(&state) % (uint32_t)duration_s);
+        size_t device_index = next_random(&state) % device_count;
+        size_t burst = 1 + next_random(&state) % burst_size;
+
+        for (; burst > 0 && i < message_count; burst--, i++)
+        {
+            arrivals[i].second = second;
+            arrivals[i].device_index = device_index;
+        }
+    }
+
+    qsort(arrivals, message_count, sizeof(ARRIVAL), compare_arrivals);
+}
+
+static IOTHUBMESSAGE_DISPOSITION_RESULT on_c2d_message(IOTHUB_MESSAGE_HANDLE message, void* context)
+{
+    (void)message;
+    (*(size_t*)context)++;
+    return IOTHUBMESSAGE_ACCEPTED;
+}
+
+static int create_clients(IOTHUB_DEVICE_CLIENT_LL_HANDLE* clients, size_t device_count, const POLLING_MODE* mode, size_t* received)
+{
+    int result = 0;
+    size_t i;
+
+    for (i = 0; i < device_count && result == 0; i++)
+    {
+        char connection_string[128];
+
+        (void)snprintf(connection_string, sizeof(connection_string), CONNECTION_STRING_FORMAT, (unsigned long)i);
+
+        if ((clients[i] = IoTHubDeviceClient_LL_CreateFromConnectionString(connection_string, HTTP_Protocol)) == NULL)
+        {
+            (void)printf("Unable to create the client of device %lu\r\n", (unsigned long)i);
+            result = __LINE__;
+        }
+        else if (IoTHubDeviceClient_LL_SetOption(clients[i], OPTION_MIN_POLLING_TIME, &mode->min_polling_s) != IOTHUB_CLIENT_OK ||
+            IoTHubDeviceClient_LL_SetOption(clients[i], OPTION_MAX_POLLING_TIME, &mode->max_polling_s) != IOTHUB_CLIENT_OK ||
+            IoTHubDeviceClient_LL_SetOption(clients[i], OPTION_MESSAGES_PER_POLL, &mode->messages_per_poll) != IOTHUB_CLIENT_OK)
+        {
+            (void)printf("Unable to set the polling options of device %lu\r\n", (unsigned long)i);
+            result = __LINE__;
+        }
+        else if (IoTHubDeviceClient_LL_SetMessageCallback(clients[i], on_c2d_message, received) != IOTHUB_CLIENT_OK)
+        {
+            (void)printf("Unable to set the message callback of device %lu\r\n", (unsigned long)i);
+            result = __LINE__;
+        }
+    }
+
+    return result;
+}
+
+static void destroy_clients(IOTHUB_DEVICE_CLIENT_LL_HANDLE* clients, size_t device_count)
+{
+    size_t i;
+
+    for (i = 0; i < device_count; i++)
+    {
+        if (clients[i] != NULL)
+        {
+            IoTHubDeviceClient_LL_Destroy(clients[i]);
+            clients[i] = NULL;
+        }
+    }
+}
+
+static int run_mode(const POLLING_MODE* mode, const ARRIVAL* arrivals, size_t message_count, size_t device_count, long duration_s)
+{
+    int result;
+    IOTHUB_DEVICE_CLIENT_LL_HANDLE* clients = (IOTHUB_DEVICE_CLIENT_LL_HANDLE*)calloc(device_count, sizeof(IOTHUB_DEVICE_CLIENT_LL_HANDLE));
+    double* latencies = (double*)malloc(sizeof(double) * (message_count + 1));
+    size_t received = 0;
+
+    // The transport jitters its back-off with rand(); the same seed gives the same run
+    srand(1);
+    virtual_clock_set(VIRTUAL_EPOCH);
+
+    if (clients == NULL || latencies == NULL)
+    {
+        (void)printf("Unable to allocate the clients\r\n");
+        result = __LINE__;
+    }
+    else if (c2d_httpapi_reset(device_count, message_count) != 0)
+    {
+        (void)printf("Unable to reset the devicebound stand-in\r\n");
+        result = __LINE__;
+    }
+    else
+    {
+        if ((result = create_clients(clients, device_count, mode, &received)) == 0)
+        {
+            long quiet_limit_s = 2 * (long)((mode->max_polling_s > mode->min_polling_s) ? mode->max_polling_s : mode->min_polling_s) + 1;
+            long last_received_s = 0;
+            size_t next_arrival = 0;
+            long second;
+
+            for (second = 0; second < duration_s || (received < message_count && second - last_received_s <= quiet_limit_s); second++)
+            {
+                size_t received_before = received;
+                size_t i;
+
+                virtual_clock_set(VIRTUAL_EPOCH + second);
+
+                for (; next_arrival < message_count && arrivals[next_arrival].second <= second; next_arrival++)
+                {
+                    (void)c2d_httpapi_enqueue(arrivals[next_arrival].device_index);
+                }
+
+                for (i = 0; i < device_count; i++)
+                {
+                    IoTHubDeviceClient_LL_DoWork(clients[i]);
+                }
+
+                if (received != received_before || second < duration_s)
+                {
+                    last_received_s = second;
+                }
+            }
+
+            {
+                C2D_HTTPAPI_STATS stats;
+                double total = 0;
+                size_t i;
+
+                c2d_httpapi_get_stats(&stats);
+
+                for (i = 0; i < stats.delivered; i++)
+                {
+                    latencies[i] = stats.latencies[i];
+                    total += latencies[i];
+                }
+                if (stats.delivered == 0)
+                {
+                    latencies[0] = 0;
+                }
+                qsort(latencies, stats.delivered, sizeof(double), compare_latencies);
+
+                (void)printf("%s,%lu,%lu,%ld,%u,%u,%u,%lu,%lu,%.1f,%lu,%.1f,%.1f,%.1f,%.1f\r\n",
+                    mode->name,
+                    (unsigned long)device_count,
+                    (unsigned long)message_count,
+                    duration_s,
+                    mode->min_polling_s,
+                    mode->max_polling_s,
+                    mode->messages_per_poll,
+                    (unsigned long)stats.polls,
+                    (unsigned long)stats.empty_polls,
+                    stats.polls / (device_count * (second / 3600.0)),
+                    (unsigned long)stats.delivered,
+                    (stats.delivered == 0) ? 0 : total / stats.delivered,
+                    latencies[(stats.delivered == 0) ? 0 : (stats.delivered - 1) / 2],
+                    latencies[(stats.delivered == 0) ? 0 : ((stats.delivered - 1) * 99) / 100],
+                    latencies[(stats.delivered == 0) ? 0 : stats.delivered - 1]);
+
+                if (received != message_count)
+                {
+                    (void)printf("%lu of %lu messages were not received\r\n", (unsigned long)(message_count - received), (unsigned long)message_count);
+                    result = __LINE__;
+                }
+            }
+        }
+
+        destroy_clients(clients, device_count);
+        c2d_httpapi_deinit();
+    }
+
+    free(latencies);
+    free(clients);
+
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    int result;
+    long devices = (argc > 1) ? atol(argv[1]) : DEFAULT_DEVICES;
+    long messages = (argc > 2) ? atol(argv[2]) : DEFAULT_MESSAGES;
+    long duration_s = (argc > 3) ? atol(argv[3]) : DEFAULT_DURATION_S;
+    long min_polling_s = (argc > 4) ? atol(argv[4]) : DEFAULT_MIN_POLLING_S;
+    long max_polling_s = (argc > 5) ? atol(argv[5]) : DEFAULT_MAX_POLLING_S;
+    long messages_per_poll = (argc > 6) ? atol(argv[6]) : DEFAULT_MESSAGES_PER_POLL;
+    long burst_size = (argc > 7) ? atol(argv[7]) : DEFAULT_BURST_SIZE;
+    ARRIVAL* arrivals;
+
+    if (devices <= 0 || messages <= 0 || duration_s <= 0 || min_polling_s < 0 || max_polling_s <= min_polling_s || messages_per_poll <= 0 || burst_size <= 0)
+    {
+        (void)printf("usage: c2d_poll_perf [devices [messages [duration_s [min_polling_s [max_polling_s [messages_per_poll [burst_size]]]]]]]\r\n");
+        result = EXIT_FAILURE;
+    }
+    else if ((arrivals = (ARRIVAL*)malloc(sizeof(ARRIVAL) * (size_t)messages)) == NULL)
+    {
+        (void)printf("Unable to allocate the traffic\r\n");
+        result = EXIT_FAILURE;
+    }
+    else
+    {
+        if (IoTHub_Init() != 0)
+        {
+            (void)printf("IoTHub_Init failed\r\n");
+            result = EXIT_FAILURE;
+        }
+        else
+        {
+            const POLLING_MODE modes[] =
+            {
+                { "fixed", (unsigned int)min_polling_s, 0, 1 },
+                { "adaptive", (unsigned int)min_polling_s, (unsigned int)max_polling_s, (unsigned int)messages_per_poll }
+            };
+            size_t i;
+
+            make_traffic(arrivals, (size_t)messages, (size_t)devices, duration_s, (size_t)burst_size);
+
+            (void)printf("mode,devices,messages,duration_s,min_polling_s,max_polling_s,messages_per_poll,polls,empty_polls,polls_per_device_hour,delivered,mean_latency_s,p50_latency_s,p99_latency_s,max_latency_s\r\n");
+
+            result = EXIT_SUCCESS;
+            for (i = 0; i < sizeof(modes) / sizeof(modes[0]); i++)
+            {
+                if (run_mode(&modes[i], arrivals, (size_t)messages, (size_t)devices, duration_s) != 0)
+                {
+                    result = EXIT_FAILURE;
+                }
+            }
+
+            IoTHub_Deinit();
+        }
+
+        free(arrivals);
+    }
+
+    return result;
+}
@@ -0,0 +1,53 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// Virtual clock: replaces the platform agenttime adapter (these definitions take precedence over the one linked from
+// the shared utility library), so the time the HTTP transport sees between polls is the one set by c2d_poll_perf.
+
+#include <time.h>
+
+#include "azure_c_shared_utility/agenttime.h"
+
+#include "c2d_httpapi.h"
+
+static time_t virtual_now;
+
+void virtual_clock_set(time_t now)
+{
+    virtual_now = now;
+}
+
+time_t virtual_clock_get(void)
+{
+    return virtual_now;
+}
+
+time_t get_time(time_t* p)
+{
+    if (p != NULL)
+    {
+        *p = virtual_now;
+    }
+
+    return virtual_now;
+}
+
+struct tm* get_gmtime(time_t* currentTime)
+{
+    return gmtime(currentTime);
+}
+
+time_t get_mktime(struct tm* cal_time)
+{
+    return mktime(cal_time);
+}
+
+char* get_ctime(time_t* timeToGet)
+{
+    return ctime(timeToGet);
+}
+
+double get_difftime(time_t stopTime, time_t startTime)
+{
+    return difftime(stopTime, startTime);
+}
@@ -0,0 +1,366 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// Runs many device identities, each with its own IoTHubDeviceClient_LL and MQTT connection, on the few threads of an
+// IoTHubClientGroup, against the in-process MQTT stand-in of the hub of telemetry_perf (see loopback_io.c).
+//
+// Every identity first sends one message, which connects it; connect_ms is the time until all of them are confirmed.
+// Then every identity sends messages_per_identity messages through IoTHubClientGroup_Invoke, and the latency of each
+// message is the time from the send to its confirmation.  The stand-in answers on the next DoWork of the client, so the
+// latencies include up to one do_work_frequency_ms.
+//
+// Output is CSV on stdout:
+//     protocol,identities,threads,do_work_frequency_ms,messages,connect_ms,elapsed_ms,msgs_per_sec,p50_ms,p99_ms
+//
+// Usage: client_group_perf [identities [threads [messages_per_identity [do_work_frequency_ms]]]]
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/threadapi.h"
+
+#include "iothub.h"
+#include "iothub_device_client_ll.h"
+#include "iothub_client_group.h"
+#include "iothub_message.h"
+
+#include "loopback_io.h"
+#include "loopback_transport.h"
+
+static const long DEFAULT_IDENTITIES = 10000;
+static const long DEFAULT_THREADS = 4;
+static const long DEFAULT_MESSAGES_PER_IDENTITY = 1;
+static const long DEFAULT_DO_WORK_FREQUENCY_MS = 100;
+
+static const uint64_t STALL_TIMEOUT_US = 60 * 1000 * 1000;
+static const unsigned int POLL_INTERVAL_MS = 10;
+
+static const char* CONNECTION_STRING_FORMAT = "HostName=loopback.azure-devices.net;DeviceId=scale-%05lu;x509=true";
+static const char* MESSAGE_BODY = "client-group-perf";
+
+// One per message sent; the confirmation of a message only writes to its own record
+typedef struct MESSAGE_RECORD_TAG
+{
+    struct BENCHMARK_TAG* benchmark;
+    uint64_t sent_us;
+    uint64_t latency_us;
+} MESSAGE_RECORD;
+
+typedef struct BENCHMARK_TAG
+{
+    LOCK_HANDLE lock;
+    size_t confirmed;
+    size_t failed;
+} BENCHMARK;
+
+typedef struct IDENTITY_TAG
+{
+    IOTHUB_DEVICE_CLIENT_LL_HANDLE client;
+    IOTHUB_CLIENT_GROUP_MEMBER_HANDLE member;
+} IDENTITY;
+
+static uint64_t get_time_us(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+    (void)QueryPerformanceCounter(&counter);
+    (void)QueryPerformanceFrequency(&frequency);
+    return (uint64_t)((counter.QuadPart * 1000000.0) / frequency.QuadPart);
+#else
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000) + ((uint64_t)now.tv_nsec / 1000);
+#endif
+}
+
+// Runs on the worker of the identity
+static void on_send_confirmation(IOTHUB_CLIENT_CONFIRMATION_RESULT result, void* userContextCallback)
+{
+    MESSAGE_RECORD* record = (MESSAGE_RECORD*)userContextCallback;
+
+    record->latency_us = get_time_us() - record->sent_us;
+
+    (void)Lock(record->benchmark->lock);
+    if (result == IOTHUB_CLIENT_CONFIRMATION_OK)
+    {
+        record->benchmark->confirmed++;
+    }
+    else
+    {
+        record->benchmark->failed++;
+    }
+    (void)Unlock(record->benchmark->lock);
+}
+
+// Called through IoTHubClientGroup_Invoke, while the worker is not running the client
+static void send_message(IOTHUB_DEVICE_CLIENT_LL_HANDLE client, void* context)
+{
+    MESSAGE_RECORD* record = (MESSAGE_RECORD*)context;
+    IOTHUB_MESSAGE_HANDLE message;
+    bool is_queued = false;
+
+    record->sent_us = get_time_us();
+
+    if ((message = IoTHubMessage_CreateFromString(MESSAGE_BODY)) == NULL)
+    {
+        (void)printf("Unable to create the message\r\n");
+    }
+    else
+    {
+        if (IoTHubDeviceClient_LL_SendEventAsync(client, message, on_send_confirmation, record) != IOTHUB_CLIENT_OK)
+        {
+            (void)printf("Unable to send the message\r\n");
+        }
+        else
+        {
+            is_queued = true;
+        }
+
+        IoTHubMessage_Destroy(message);
+    }
+
+    if (!is_queued)
+    {
+        (void)Lock(record->benchmark->lock);
+        record->benchmark->failed++;
+        (void)Unlock(record->benchmark->lock);
+    }
+}
+
+static size_t get_completed(BENCHMARK* benchmark, size_t* failed)
+{
+    size_t result;
+
+    (void)Lock(benchmark->lock);
+    result = benchmark->confirmed + benchmark->failed;
+    *failed = benchmark->failed;
+    (void)Unlock(benchmark->lock);
+
+    return result;
+}
+
+// Sends one message per record, round-robin over the identities, and waits for all of them to complete
+static int send_and_wait(BENCHMARK* benchmark, IDENTITY* identities, size_t identity_count, MESSAGE_RECORD* records, size_t record_count)
+{
+    int result = 0;
+    size_t failed;
+    size_t i;
+    uint64_t start_us;
+
+    (void)Lock(benchmark->lock);
+    benchmark->confirmed = 0;
+    benchmark->failed = 0;
+    (void)Unlock(benchmark->lock);
+
+    for (i = 0; i < record_count && result == 0; i++)
+    {
+        records[i].benchmark = benchmark;
+        records[i].latency_us = 0;
+
+        if (IoTHubClientGroup_Invoke(identities[i % identity_count].member, send_message, &records[i]) != IOTHUB_CLIENT_OK)
+        {
+            (void)printf("Unable to invoke identity %lu\r\n", (unsigned long)(i % identity_count));
+            result = __LINE__;
+        }
+    }
+
+    start_us = get_time_us();
+    while (result == 0 && get_completed(benchmark, &failed) < record_count && get_time_us() - start_us < STALL_TIMEOUT_US)
+    {
+        ThreadAPI_Sleep(POLL_INTERVAL_MS);
+    }
+
+    if (result != 0)
+    {
+        // Reported above
+    }
+    else if (get_completed(benchmark, &failed) < record_count)
+    {
+        (void)printf("No confirmation of all %lu messages within %lu seconds\r\n", (unsigned long)record_count, (unsigned long)(STALL_TIMEOUT_US / 1000000));
+        result = __LINE__;
+    }
+    else if (failed != 0)
+    {
+        (void)printf("%lu of %lu messages failed\r\n", (unsigned long)failed, (unsigned long)record_count);
+        result = __LINE__;
+    }
+
+    return result;
+}
+
+static int compare_times(const void* left, const void* right)
+{
+    uint64_t left_time = *(const uint64_t*)left;
+    uint64_t right_time = *(const uint64_t*)right;
+    return (left_time < right_time) ? -1 : ((left_time > right_time) ? 1 : 0);
+}
+
+static void destroy_identities(IDENTITY* identities, size_t count)
+{
+    size_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        if (identities[i].member != NULL)
+        {
+            IoTHubClientGroup_RemoveDeviceClient(identities[i].member);
+        }
+        IoTHubDeviceClient_LL_Destroy(identities[i].client);
+    }
+}
+
+static int run_benchmark(size_t identity_count, size_t thread_count, size_t messages_per_identity, unsigned int do_work_frequency_ms)
+{
+    int result;
+    IOTHUB_CLIENT_GROUP_CONFIG config;
+    IOTHUB_CLIENT_GROUP_HANDLE group;
+    BENCHMARK benchmark = { NULL, 0, 0 };
+    size_t record_count = identity_count * messages_per_identity;
+    IDENTITY* identities = (IDENTITY*)calloc(identity_count, sizeof(IDENTITY));
+    MESSAGE_RECORD* records = (MESSAGE_RECORD*)calloc(record_count, sizeof(MESSAGE_RECORD));
+    uint64_t* latencies_us = (uint64_t*)malloc(sizeof(uint64_t) * record_count);
+
+    config.threadCount = thread_count;
+    config.doWorkFrequencyInMs = do_work_frequency_ms;
+
+    if (identities == NULL || records == NULL || latencies_us == NULL)
+    {
+        (void)printf("Unable to allocate the identities and messages\r\n");
+        result = __LINE__;
+    }
+    else if ((benchmark.lock = Lock_Init()) == NULL)
+    {
+        (void)printf("Unable to create the lock\r\n");
+        result = __LINE__;
+    }
+    else
+    {
+        if ((group = IoTHubClientGroup_Create(&config)) == NULL)
+        {
+            (void)printf("Unable to create the client group\r\n");
+            result = __LINE__;
+        }
+        else
+        {
+            uint64_t connect_start_us = get_time_us();
+            size_t created;
+
+            result = 0;
+            for (created = 0; created < identity_count && result == 0; created++)
+            {
+                char connection_string[128];
+
+                (void)snprintf(connection_string, sizeof(connection_string), CONNECTION_STRING_FORMAT, (unsigned long)created);
+
+                if ((identities[created].client = IoTHubDeviceClient_LL_CreateFromConnectionString(connection_string, Loopback_MQTT_Protocol)) == NULL)
+                {
+                    (void)printf("Unable to create the client of identity %lu\r\n", (unsigned long)created);
+                    result = __LINE__;
+                    break;
+                }
+                else if ((identities[created].member = IoTHubClientGroup_AddDeviceClient(group, identities[created].client)) == NULL)
+                {
+                    (void)printf("Unable to add identity %lu to the group\r\n", (unsigned long)created);
+                    result = __LINE__;
+                }
+            }
+
+            // The first message of each identity waits for its connection
+            if (result == 0 && send_and_wait(&benchmark, identities, identity_count, records, identity_count) != 0)
+            {
+                (void)printf("Connecting the identities failed\r\n");
+                result = __LINE__;
+            }
+            else if (result == 0)
+            {
+                uint64_t connect_us = get_time_us() - connect_start_us;
+                uint64_t start_us = get_time_us();
+
+                if (send_and_wait(&benchmark, identities, identity_count, records, record_count) != 0)
+                {
+                    (void)printf("Sending the messages failed\r\n");
+                    result = __LINE__;
+                }
+                else
+                {
+                    uint64_t elapsed_us = get_time_us() - start_us;
+                    size_t i;
+
+                    for (i = 0; i < record_count; i++)
+                    {
+                        latencies_us[i] = records[i].latency_us;
+                    }
+                    qsort(latencies_us, record_count, sizeof(uint64_t), compare_times);
+
+                    (void)printf("mqtt,%lu,%lu,%u,%lu,%.1f,%.1f,%.1f,%.1f,%.1f\r\n",
+                        (unsigned long)identity_count,
+                        (unsigned long)thread_count,
+                        do_work_frequency_ms,
+                        (unsigned long)record_count,
+                        connect_us / 1000.0,
+                        elapsed_us / 1000.0,
+                        record_count / (elapsed_us / 1000000.0),
+                        latencies_us[(record_count - 1) / 2] / 1000.0,
+                        latencies_us[((record_count - 1) * 99) / 100] / 1000.0);
+                }
+            }
+
+            // Removing waits for a running DoWork, so no callback touches the records after this
+            destroy_identities(identities, created);
+            IoTHubClientGroup_Destroy(group);
+        }
+
+        Lock_Deinit(benchmark.lock);
+    }
+
+    free(latencies_us);
+    free(records);
+    free(identities);
+
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    int result;
+    long identities = (argc > 1) ? atol(argv[1]) : DEFAULT_IDENTITIES;
+    long threads = (argc > 2) ? atol(argv[2]) : DEFAULT_THREADS;
+    long messages_per_identity = (argc > 3) ? atol(argv[3]) : DEFAULT_MESSAGES_PER_IDENTITY;
+    long do_work_frequency_ms = (argc > 4) ? atol(argv[4]) : DEFAULT_DO_WORK_FREQUENCY_MS;
+
+    if (identities <= 0 || threads <= 0 || messages_per_identity <= 0 || do_work_frequency_ms <= 0)
+    {
+        (void)printf("usage: client_group_perf [identities [threads [messages_per_identity [do_work_frequency_ms]]]]\r\n");
+        result = EXIT_FAILURE;
+    }
+    else if (IoTHub_Init() != 0)
+    {
+        (void)printf("IoTHub_Init failed\r\n");
+        result = EXIT_FAILURE;
+    }
+    else
+    {
+        // The clients create and destroy their IOs on the workers
+        loopback_io_set_multithreaded(true);
+
+        (void)printf("protocol,identities,threads,do_work_frequency_ms,messages,connect_ms,elapsed_ms,msgs_per_sec,p50_ms,p99_ms\r\n");
+
+        result = (run_benchmark((size_t)identities, (size_t)threads, (size_t)messages_per_identity, (unsigned int)do_work_frequency_ms) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+        loopback_io_set_multithreaded(false);
+        IoTHub_Deinit();
+    }
+
+    return result;
+}
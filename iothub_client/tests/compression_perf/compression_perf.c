@@ -0,0 +1,195 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// Measures the compression ratio and CPU cost of the device-to-cloud compression stage (OPTION_COMPRESSION) on
+// synthetic JSON telemetry of several sizes, for each algorithm, a few levels, and deflate with a shared dictionary.
+// The "none" rows time creating the message alone, which is the baseline the other rows add to.
+//
+// Output is CSV on stdout, one line per configuration and body size:
+//     algorithm,level,dictionary,body_bytes,compressed_bytes,ratio,us_per_message
+//
+// Usage: compression_perf [iterations]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "iothub_message.h"
+#include "iothub_client_options.h"
+#include "internal/iothub_client_compression.h"
+
+typedef struct COMPRESSION_CONFIG_TAG
+{
+    const char* name;
+    IOTHUB_CLIENT_COMPRESSION algorithm;
+    int level;
+    bool useDictionary;
+} COMPRESSION_CONFIG;
+
+static const COMPRESSION_CONFIG COMPRESSION_CONFIGS[] = {
+    { "none", IOTHUB_CLIENT_COMPRESSION_NONE, 6, false },
+    { "deflate", IOTHUB_CLIENT_COMPRESSION_DEFLATE, 1, false },
+    { "deflate", IOTHUB_CLIENT_COMPRESSION_DEFLATE, 6, false },
+    { "deflate", IOTHUB_CLIENT_COMPRESSION_DEFLATE, 9, false },
+    { "deflate", IOTHUB_CLIENT_COMPRESSION_DEFLATE, 6, true },
+    { "gzip", IOTHUB_CLIENT_COMPRESSION_GZIP, 6, false }
+};
+
+// Number of telemetry readings per body; one reading is roughly 130 bytes.
+static const size_t READING_COUNTS[] = { 1, 4, 16, 64 };
+
+// What the readings have in common, most frequent last as zlib prefers.
+static const char* TELEMETRY_DICTIONARY =
+    "\"status\":\"degraded\"\"status\":\"ok\"},{\"deviceId\":\"thermostat-\",\"sequence\":,\"temperature\":,\"humidity\":,\"pressure\":1013.,\"status\":\"ok\"}";
+
+static const int DEFAULT_ITERATIONS = 1000;
+
+// Builds a JSON array of readings whose values drift the way a sensor's would.
+static char* create_telemetry(size_t readingCount, size_t* length)
+{
+    char* telemetry;
+    size_t capacity = 160 * readingCount + 3;
+
+    if ((telemetry = (char*)malloc(capacity)) == NULL)
+    {
+        (void)printf("Unable to allocate %lu bytes for the synthetic telemetry\r\n", (unsigned long)capacity);
+        exit(EXIT_FAILURE);
+    }
+    else
+    {
+        size_t i;
+        size_t written = 0;
+
+        telemetry[written++] = '[';
+        for (i = 0; i < readingCount; i++)
+        {
+            written += (size_t)snprintf(telemetry + written, capacity - written,
+                "%s{\"deviceId\":\"thermostat-%04lu\",\"sequence\":%lu,\"temperature\":%.2f,\"humidity\":%.2f,\"pressure\":1013.%02lu,\"status\":\"%s\"}",
+                (i == 0) ? "" : ",", (unsigned long)(i % 8), (unsigned long)(1000 + i), 20.0 + (double)(i % 37) / 8.0,
+                40.0 + (double)(i % 23) / 4.0, (unsigned long)(i % 100), (i % 11 == 0) ? "degraded" : "ok");
+        }
+        telemetry[written++] = ']';
+        telemetry[written] = '\0';
+        *length = written;
+    }
+
+    return telemetry;
+}
+
+static COMPRESSION_HANDLE create_compression(const COMPRESSION_CONFIG* config)
+{
+    COMPRESSION_HANDLE compression;
+    size_t threshold = 0;
+
+    if ((compression = compression_create()) == NULL)
+    {
+        (void)printf("compression_create failed\r\n");
+        exit(EXIT_FAILURE);
+    }
+    else if (compression_set_option(compression, OPTION_COMPRESSION, &config->algorithm) != 0 ||
+        compression_set_option(compression, OPTION_COMPRESSION_LEVEL, &config->level) != 0 ||
+        compression_set_option(compression, OPTION_COMPRESSION_THRESHOLD, &threshold) != 0)
+    {
+        (void)printf("compression_set_option failed\r\n");
+        exit(EXIT_FAILURE);
+    }
+    else if (config->useDictionary)
+    {
+        IOTHUB_CLIENT_COMPRESSION_DICTIONARY dictionary;
+        dictionary.data = (const unsigned char*)TELEMETRY_DICTIONARY;
+        dictionary.size = strlen(TELEMETRY_DICTIONARY);
+
+        if (compression_set_option(compression, OPTION_COMPRESSION_DICTIONARY, &dictionary) != 0)
+        {
+            (void)printf("Setting the dictionary failed\r\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    return compression;
+}
+
+// Sends the body through the stage the way IoTHubClientCore_LL_SendEventAsync does, and returns the size it leaves.
+static size_t compress_telemetry(COMPRESSION_HANDLE compression, const char* telemetry, size_t length)
+{
+    IOTHUB_MESSAGE_HANDLE message;
+    const unsigned char* body;
+    size_t bodyLength;
+
+    if ((message = IoTHubMessage_CreateFromByteArray((const unsigned char*)telemetry, length)) == NULL)
+    {
+        (void)printf("IoTHubMessage_CreateFromByteArray failed\r\n");
+        exit(EXIT_FAILURE);
+    }
+    else if (compression_compress_message(compression, message) != 0 ||
+        IoTHubMessage_GetByteArray(message, &body, &bodyLength) != IOTHUB_MESSAGE_OK)
+    {
+        (void)printf("Compressing the telemetry failed\r\n");
+        exit(EXIT_FAILURE);
+    }
+
+    IoTHubMessage_Destroy(message);
+
+    return bodyLength;
+}
+
+static void run_benchmark(const COMPRESSION_CONFIG* config, const char* telemetry, size_t length, int iterations)
+{
+    COMPRESSION_HANDLE compression = create_compression(config);
+    size_t compressedLength = 0;
+    clock_t start;
+    double elapsedUs;
+    int i;
+
+    start = clock();
+
+    for (i = 0; i < iterations; i++)
+    {
+        compressedLength = compress_telemetry(compression, telemetry, length);
+    }
+
+    elapsedUs = ((double)(clock() - start) * 1000000.0) / CLOCKS_PER_SEC / iterations;
+
+    (void)printf("%s,%d,%s,%lu,%lu,%.3f,%.3f\r\n", config->name, config->level, config->useDictionary ? "yes" : "no",
+        (unsigned long)length, (unsigned long)compressedLength, (double)length / (double)compressedLength, elapsedUs);
+
+    compression_destroy(compression);
+}
+
+int main(int argc, char* argv[])
+{
+    int result;
+    int iterations = (argc > 1) ? atoi(argv[1]) : DEFAULT_ITERATIONS;
+
+    if (iterations <= 0)
+    {
+        (void)printf("usage: compression_perf [iterations]\r\n");
+        result = EXIT_FAILURE;
+    }
+    else
+    {
+        size_t i;
+
+        (void)printf("algorithm,level,dictionary,body_bytes,compressed_bytes,ratio,us_per_message\r\n");
+
+        for (i = 0; i < sizeof(READING_COUNTS) / sizeof(READING_COUNTS[0]); i++)
+        {
+            size_t length;
+            size_t j;
+            char* telemetry = create_telemetry(READING_COUNTS[i], &length);
+
+            for (j = 0; j < sizeof(COMPRESSION_CONFIGS) / sizeof(COMPRESSION_CONFIGS[0]); j++)
+            {
+                run_benchmark(&COMPRESSION_CONFIGS[j], telemetry, length, iterations);
+            }
+
+            free(telemetry);
+        }
+
+        result = EXIT_SUCCESS;
+    }
+
+    return result;
+}
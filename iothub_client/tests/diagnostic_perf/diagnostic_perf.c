@@ -0,0 +1,93 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// Measures what diagnostic sampling (OPTION_DIAGNOSTIC_SAMPLING_PERCENTAGE) adds to each device-to-cloud message:
+// deciding whether to sample it and, when it is sampled, generating and storing its diagnostic properties.  Each
+// iteration creates, samples and destroys a message; the 0% row is the baseline the other rows add to.
+//
+// Output is CSV on stdout, one line per sampling percentage:
+//     sampling_percentage,messages,sampled,ns_per_message
+//
+// Usage: diagnostic_perf [iterations]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "iothub_message.h"
+#include "internal/iothub_client_diagnostic.h"
+
+static const uint32_t SAMPLING_PERCENTAGES[] = { 0, 1, 10, 50, 100 };
+
+static const unsigned char TELEMETRY[] = "{\"temperature\":21.50,\"humidity\":43.25}";
+
+static const int DEFAULT_ITERATIONS = 1000000;
+
+static void run_benchmark(uint32_t samplingPercentage, int iterations)
+{
+    IOTHUB_DIAGNOSTIC_SETTING_DATA diagSetting;
+    unsigned long sampled = 0;
+    clock_t start;
+    double elapsedNs;
+    int i;
+
+    diagSetting.diagSamplingPercentage = samplingPercentage;
+    diagSetting.currentMessageNumber = 0;
+
+    start = clock();
+
+    for (i = 0; i < iterations; i++)
+    {
+        IOTHUB_MESSAGE_HANDLE message;
+
+        if ((message = IoTHubMessage_CreateFromByteArray(TELEMETRY, sizeof(TELEMETRY) - 1)) == NULL)
+        {
+            (void)printf("IoTHubMessage_CreateFromByteArray failed\r\n");
+            exit(EXIT_FAILURE);
+        }
+        else if (IoTHubClient_Diagnostic_AddIfNecessary(&diagSetting, message) != 0)
+        {
+            (void)printf("IoTHubClient_Diagnostic_AddIfNecessary failed\r\n");
+            exit(EXIT_FAILURE);
+        }
+
+        if (IoTHubMessage_GetDiagnosticPropertyData(message) != NULL)
+        {
+            sampled++;
+        }
+
+        IoTHubMessage_Destroy(message);
+    }
+
+    elapsedNs = ((double)(clock() - start) * 1000000000.0) / CLOCKS_PER_SEC / iterations;
+
+    (void)printf("%lu,%d,%lu,%.1f\r\n", (unsigned long)samplingPercentage, iterations, sampled, elapsedNs);
+}
+
+int main(int argc, char* argv[])
+{
+    int result;
+    int iterations = (argc > 1) ? atoi(argv[1]) : DEFAULT_ITERATIONS;
+
+    if (iterations <= 0)
+    {
+        (void)printf("usage: diagnostic_perf [iterations]\r\n");
+        result = EXIT_FAILURE;
+    }
+    else
+    {
+        size_t i;
+
+        (void)printf("sampling_percentage,messages,sampled,ns_per_message\r\n");
+
+        for (i = 0; i < sizeof(SAMPLING_PERCENTAGES) / sizeof(SAMPLING_PERCENTAGES[0]); i++)
+        {
+            run_benchmark(SAMPLING_PERCENTAGES[i], iterations);
+        }
+
+        result = EXIT_SUCCESS;
+    }
+
+    return result;
+}
@@ -0,0 +1,605 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#endif
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void* my_gballoc_realloc(void* ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#include "testrunnerswitcher.h"
+#include "azure_macro_utils/macro_utils.h"
+#include "umock_c/umock_c.h"
+#include "umock_c/umocktypes_bool.h"
+#include "umock_c/umock_c_negative_tests.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/condition.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/vector.h"
+#include "umock_c/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    extern VECTOR_HANDLE real_VECTOR_create(size_t elementSize);
+    extern VECTOR_HANDLE real_VECTOR_move(VECTOR_HANDLE handle);
+    extern void real_VECTOR_destroy(VECTOR_HANDLE handle);
+    extern int real_VECTOR_push_back(VECTOR_HANDLE handle, const void* elements, size_t numElements);
+    extern void* real_VECTOR_element(VECTOR_HANDLE handle, size_t index);
+    extern size_t real_VECTOR_size(VECTOR_HANDLE handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#undef ENABLE_MOCKS
+
+#include "internal/iothub_client_callback_queue.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+MU_DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", MU_ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+TEST_DEFINE_ENUM_TYPE(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_RESULT_VALUES);
+
+#define TEST_DEPTH 2
+#define TEST_MAX_DISPATCHED 16
+
+static LOCK_HANDLE TEST_LOCK_HANDLE = (LOCK_HANDLE)0x4242;
+static COND_HANDLE TEST_COND_HANDLE = (COND_HANDLE)0x4243;
+static THREAD_HANDLE TEST_THREAD_HANDLE = (THREAD_HANDLE)0x4244;
+static void* TEST_CONTEXT = (void*)0x4245;
+
+static THREAD_START_FUNC g_thread_func;
+static void* g_thread_func_arg;
+
+static size_t g_dispatchCount;
+static int g_dispatchedItems[TEST_MAX_DISPATCHED];
+static bool g_dispatchedDropped[TEST_MAX_DISPATCHED];
+static void* g_dispatchContext;
+
+static THREADAPI_RESULT my_ThreadAPI_Create(THREAD_HANDLE* threadHandle, THREAD_START_FUNC func, void* arg)
+{
+    *threadHandle = TEST_THREAD_HANDLE;
+    g_thread_func = func;
+    g_thread_func_arg = arg;
+    return THREADAPI_OK;
+}
+
+static void test_dispatch(void* context, void* item, bool is_dropped)
+{
+    ASSERT_IS_TRUE(g_dispatchCount < TEST_MAX_DISPATCHED);
+    g_dispatchedItems[g_dispatchCount] = *(int*)item;
+    g_dispatchedDropped[g_dispatchCount] = is_dropped;
+    g_dispatchContext = context;
+    g_dispatchCount++;
+}
+
+// Runs the dispatch thread on the test thread.  Condition_Wait fails once the queue is empty, which ends the thread.
+static void run_dispatch_thread(void)
+{
+    ASSERT_IS_NOT_NULL(g_thread_func);
+    (void)g_thread_func(g_thread_func_arg);
+}
+
+static CALLBACK_QUEUE_PUSH_RESULT push_item(CALLBACK_QUEUE_HANDLE queue, int item, bool is_droppable)
+{
+    return callback_queue_push(queue, &item, is_droppable);
+}
+
+static void register_global_mocks(void)
+{
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(COND_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(COND_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(THREAD_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREAD_START_FUNC, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREADAPI_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(VECTOR_HANDLE, void*);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_realloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock_Init, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock, LOCK_ERROR);
+    REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+
+    REGISTER_GLOBAL_MOCK_RETURN(Condition_Init, TEST_COND_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Condition_Init, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(Condition_Post, COND_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Condition_Wait, COND_ERROR);
+
+    REGISTER_GLOBAL_MOCK_HOOK(ThreadAPI_Create, my_ThreadAPI_Create);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(ThreadAPI_Create, THREADAPI_ERROR);
+    REGISTER_GLOBAL_MOCK_RETURN(ThreadAPI_Join, THREADAPI_OK);
+
+    REGISTER_GLOBAL_MOCK_HOOK(VECTOR_create, real_VECTOR_create);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(VECTOR_create, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(VECTOR_move, real_VECTOR_move);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(VECTOR_move, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(VECTOR_push_back, real_VECTOR_push_back);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(VECTOR_push_back, MU_FAILURE);
+    REGISTER_GLOBAL_MOCK_HOOK(VECTOR_element, real_VECTOR_element);
+    REGISTER_GLOBAL_MOCK_HOOK(VECTOR_destroy, real_VECTOR_destroy);
+    REGISTER_GLOBAL_MOCK_HOOK(VECTOR_size, real_VECTOR_size);
+}
+
+BEGIN_TEST_SUITE(iothub_client_callback_queue_ut)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+    umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, umocktypes_bool_register_types());
+    register_global_mocks();
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+    umock_c_reset_all_calls();
+    g_thread_func = NULL;
+    g_thread_func_arg = NULL;
+    g_dispatchCount = 0;
+    g_dispatchContext = NULL;
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+TEST_FUNCTION(callback_queue_create_succeeds)
+{
+    // arrange
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(TEST_DEPTH * sizeof(int)));
+    STRICT_EXPECTED_CALL(gballoc_malloc(TEST_DEPTH * sizeof(bool)));
+    STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(int)));
+    STRICT_EXPECTED_CALL(VECTOR_create(sizeof(int)));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(Condition_Init());
+    STRICT_EXPECTED_CALL(Condition_Init());
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG));
+
+    // act
+    CALLBACK_QUEUE_HANDLE queue = callback_queue_create(sizeof(int), TEST_DEPTH, IOTHUB_CLIENT_CALLBACK_QUEUE_BLOCK, test_dispatch, TEST_CONTEXT);
+
+    // assert
+    ASSERT_IS_NOT_NULL(queue);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NOT_NULL(g_thread_func);
+
+    // cleanup
+    callback_queue_destroy(queue);
+}
+
+TEST_FUNCTION(callback_queue_create_invalid_arguments_fail)
+{
+    // act
+    CALLBACK_QUEUE_HANDLE no_item_size = callback_queue_create(0, TEST_DEPTH, IOTHUB_CLIENT_CALLBACK_QUEUE_BLOCK, test_dispatch, NULL);
+    CALLBACK_QUEUE_HANDLE no_depth = callback_queue_create(sizeof(int), 0, IOTHUB_CLIENT_CALLBACK_QUEUE_BLOCK, test_dispatch, NULL);
+    CALLBACK_QUEUE_HANDLE no_dispatch = callback_queue_create(sizeof(int), TEST_DEPTH, IOTHUB_CLIENT_CALLBACK_QUEUE_BLOCK, NULL, NULL);
+
+    // assert
+    ASSERT_IS_NULL(no_item_size);
+    ASSERT_IS_NULL(no_depth);
+    ASSERT_IS_NULL(no_dispatch);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(callback_queue_create_negative_tests)
+{
+    // arrange
+    size_t i;
+    size_t count;
+
+    ASSERT_ARE_EQUAL(int, 0, umock_c_negative_tests_init());
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_ARG));
+    STRICT_EXPECTED_CALL(VECTOR_create(sizeof(int)));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(Condition_Init());
+    STRICT_EXPECTED_CALL(Condition_Init());
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_ARG, IGNORED_ARG, IGNORED_ARG));
+    umock_c_negative_tests_snapshot();
+
+    count = umock_c_negative_tests_call_count();
+    for (i = 0; i < count; i++)
+    {
+        CALLBACK_QUEUE_HANDLE queue;
+        char temp_str[64];
+
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(i);
+
+        // act
+        queue = callback_queue_create(sizeof(int), TEST_DEPTH, IOTHUB_CLIENT_CALLBACK_QUEUE_BLOCK, test_dispatch, NULL);
+
+        // assert
+        (void)sprintf(temp_str, "Failure in test %lu/%lu", (unsigned long)i, (unsigned long)count);
+        ASSERT_IS_NULL(queue, temp_str);
+    }
+
+    // cleanup
+    umock_c_negative_tests_deinit();
+}
+
+TEST_FUNCTION(callback_queue_destroy_NULL_does_nothing)
+{
+    // act
+    callback_queue_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(callback_queue_dispatch_thread_dispatches_in_order)
+{
+    // arrange
+    CALLBACK_QUEUE_HANDLE queue = callback_queue_create(sizeof(int), TEST_DEPTH, IOTHUB_CLIENT_CALLBACK_QUEUE_BLOCK, test_dispatch, TEST_CONTEXT);
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_OK, push_item(queue, 1, true));
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_OK, push_item(queue, 2, false));
+
+    // act
+    run_dispatch_thread();
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, g_dispatchCount);
+    ASSERT_ARE_EQUAL(int, 1, g_dispatchedItems[0]);
+    ASSERT_ARE_EQUAL(int, 2, g_dispatchedItems[1]);
+    ASSERT_IS_FALSE(g_dispatchedDropped[0]);
+    ASSERT_IS_FALSE(g_dispatchedDropped[1]);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_CONTEXT, g_dispatchContext);
+
+    // cleanup
+    callback_queue_destroy(queue);
+    ASSERT_ARE_EQUAL(size_t, 2, g_dispatchCount);
+}
+
+TEST_FUNCTION(callback_queue_push_NULL_arguments_fail)
+{
+    // arrange
+    int item = 1;
+    CALLBACK_QUEUE_HANDLE queue = callback_queue_create(sizeof(int), TEST_DEPTH, IOTHUB_CLIENT_CALLBACK_QUEUE_BLOCK, test_dispatch, NULL);
+
+    // act
+    CALLBACK_QUEUE_PUSH_RESULT no_queue = callback_queue_push(NULL, &item, true);
+    CALLBACK_QUEUE_PUSH_RESULT no_item = callback_queue_push(queue, NULL, true);
+
+    // assert
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_ERROR, no_queue);
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_ERROR, no_item);
+
+    // cleanup
+    callback_queue_destroy(queue);
+}
+
+TEST_FUNCTION(callback_queue_push_full_queue_under_reject_rejects_droppable_items)
+{
+    // arrange
+    IOTHUB_CLIENT_CALLBACK_QUEUE_STATISTICS statistics;
+    CALLBACK_QUEUE_HANDLE queue = callback_queue_create(sizeof(int), TEST_DEPTH, IOTHUB_CLIENT_CALLBACK_QUEUE_REJECT, test_dispatch, NULL);
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_OK, push_item(queue, 1, true));
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_OK, push_item(queue, 2, true));
+
+    // act
+    CALLBACK_QUEUE_PUSH_RESULT droppable = push_item(queue, 3, true);
+    CALLBACK_QUEUE_PUSH_RESULT completion = push_item(queue, 4, false);
+
+    // assert
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_REJECTED, droppable);
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_OK, completion);
+    ASSERT_ARE_EQUAL(int, 0, callback_queue_get_statistics(queue, &statistics));
+    ASSERT_ARE_EQUAL(size_t, 3, statistics.queued);
+    ASSERT_ARE_EQUAL(size_t, 3, statistics.callbacksQueued);
+    ASSERT_ARE_EQUAL(size_t, 1, statistics.callbacksRejected);
+
+    run_dispatch_thread();
+    ASSERT_ARE_EQUAL(size_t, 3, g_dispatchCount);
+    ASSERT_ARE_EQUAL(int, 1, g_dispatchedItems[0]);
+    ASSERT_ARE_EQUAL(int, 2, g_dispatchedItems[1]);
+    ASSERT_ARE_EQUAL(int, 4, g_dispatchedItems[2]);
+
+    // cleanup
+    callback_queue_destroy(queue);
+}
+
+TEST_FUNCTION(callback_queue_push_full_queue_under_drop_oldest_evicts_oldest_droppable_item)
+{
+    // arrange
+    IOTHUB_CLIENT_CALLBACK_QUEUE_STATISTICS statistics;
+    CALLBACK_QUEUE_HANDLE queue = callback_queue_create(sizeof(int), TEST_DEPTH, IOTHUB_CLIENT_CALLBACK_QUEUE_DROP_OLDEST, test_dispatch, NULL);
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_OK, push_item(queue, 1, false));
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_OK, push_item(queue, 2, true));
+
+    // act
+    CALLBACK_QUEUE_PUSH_RESULT result = push_item(queue, 3, true);
+
+    // assert
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_OK, result);
+    ASSERT_ARE_EQUAL(int, 0, callback_queue_get_statistics(queue, &statistics));
+    ASSERT_ARE_EQUAL(size_t, 2, statistics.queued);
+    ASSERT_ARE_EQUAL(size_t, 1, statistics.callbacksDropped);
+
+    run_dispatch_thread();
+    ASSERT_ARE_EQUAL(size_t, 3, g_dispatchCount);
+    ASSERT_ARE_EQUAL(int, 2, g_dispatchedItems[0]);
+    ASSERT_IS_TRUE(g_dispatchedDropped[0]);
+    ASSERT_ARE_EQUAL(int, 1, g_dispatchedItems[1]);
+    ASSERT_IS_FALSE(g_dispatchedDropped[1]);
+    ASSERT_ARE_EQUAL(int, 3, g_dispatchedItems[2]);
+    ASSERT_IS_FALSE(g_dispatchedDropped[2]);
+
+    // cleanup
+    callback_queue_destroy(queue);
+}
+
+TEST_FUNCTION(callback_queue_push_queue_full_of_completions_under_drop_oldest_drops_the_new_item)
+{
+    // arrange
+    CALLBACK_QUEUE_HANDLE queue = callback_queue_create(sizeof(int), TEST_DEPTH, IOTHUB_CLIENT_CALLBACK_QUEUE_DROP_OLDEST, test_dispatch, NULL);
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_OK, push_item(queue, 1, false));
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_OK, push_item(queue, 2, false));
+
+    // act
+    CALLBACK_QUEUE_PUSH_RESULT result = push_item(queue, 3, true);
+
+    // assert
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_OK, result);
+
+    run_dispatch_thread();
+    ASSERT_ARE_EQUAL(size_t, 3, g_dispatchCount);
+    ASSERT_ARE_EQUAL(int, 3, g_dispatchedItems[0]);
+    ASSERT_IS_TRUE(g_dispatchedDropped[0]);
+    ASSERT_ARE_EQUAL(int, 1, g_dispatchedItems[1]);
+    ASSERT_ARE_EQUAL(int, 2, g_dispatchedItems[2]);
+
+    // cleanup
+    callback_queue_destroy(queue);
+}
+
+TEST_FUNCTION(callback_queue_push_full_queue_under_block_grows_the_ring)
+{
+    // arrange
+    IOTHUB_CLIENT_CALLBACK_QUEUE_STATISTICS statistics;
+    CALLBACK_QUEUE_HANDLE queue = callback_queue_create(sizeof(int), TEST_DEPTH, IOTHUB_CLIENT_CALLBACK_QUEUE_BLOCK, test_dispatch, NULL);
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_OK, push_item(queue, 1, true));
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_OK, push_item(queue, 2, true));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_malloc(2 * TEST_DEPTH * sizeof(int)));
+    STRICT_EXPECTED_CALL(gballoc_malloc(2 * TEST_DEPTH * sizeof(bool)));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_ARG));
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    CALLBACK_QUEUE_PUSH_RESULT result = push_item(queue, 3, true);
+
+    // assert
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, callback_queue_get_statistics(queue, &statistics));
+    ASSERT_ARE_EQUAL(size_t, 3, statistics.peakQueued);
+
+    run_dispatch_thread();
+    ASSERT_ARE_EQUAL(size_t, 3, g_dispatchCount);
+    ASSERT_ARE_EQUAL(int, 1, g_dispatchedItems[0]);
+    ASSERT_ARE_EQUAL(int, 2, g_dispatchedItems[1]);
+    ASSERT_ARE_EQUAL(int, 3, g_dispatchedItems[2]);
+
+    // cleanup
+    callback_queue_destroy(queue);
+}
+
+TEST_FUNCTION(callback_queue_set_overflow_applies_to_later_pushes)
+{
+    // arrange
+    CALLBACK_QUEUE_HANDLE queue = callback_queue_create(sizeof(int), TEST_DEPTH, IOTHUB_CLIENT_CALLBACK_QUEUE_BLOCK, test_dispatch, NULL);
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_OK, push_item(queue, 1, true));
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_OK, push_item(queue, 2, true));
+
+    // act
+    int result = callback_queue_set_overflow(queue, IOTHUB_CLIENT_CALLBACK_QUEUE_REJECT);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_REJECTED, push_item(queue, 3, true));
+
+    // cleanup
+    callback_queue_destroy(queue);
+}
+
+TEST_FUNCTION(callback_queue_set_overflow_NULL_queue_fails)
+{
+    // act
+    int result = callback_queue_set_overflow(NULL, IOTHUB_CLIENT_CALLBACK_QUEUE_REJECT);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+TEST_FUNCTION(callback_queue_wait_for_room_with_room_does_not_wait)
+{
+    // arrange
+    CALLBACK_QUEUE_HANDLE queue = callback_queue_create(sizeof(int), TEST_DEPTH, IOTHUB_CLIENT_CALLBACK_QUEUE_BLOCK, test_dispatch, NULL);
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_OK, push_item(queue, 1, true));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    bool result = callback_queue_wait_for_room(queue, 100);
+
+    // assert
+    ASSERT_IS_TRUE(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    callback_queue_destroy(queue);
+}
+
+TEST_FUNCTION(callback_queue_wait_for_room_full_queue_waits_and_counts_the_pause)
+{
+    // arrange
+    IOTHUB_CLIENT_CALLBACK_QUEUE_STATISTICS statistics;
+    CALLBACK_QUEUE_HANDLE queue = callback_queue_create(sizeof(int), TEST_DEPTH, IOTHUB_CLIENT_CALLBACK_QUEUE_BLOCK, test_dispatch, NULL);
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_OK, push_item(queue, 1, true));
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_OK, push_item(queue, 2, true));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Condition_Wait(TEST_COND_HANDLE, TEST_LOCK_HANDLE, 100)).SetReturn(COND_TIMEOUT);
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    bool result = callback_queue_wait_for_room(queue, 100);
+
+    // assert
+    ASSERT_IS_FALSE(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, callback_queue_get_statistics(queue, &statistics));
+    ASSERT_ARE_EQUAL(size_t, 1, statistics.ioPauses);
+
+    // cleanup
+    callback_queue_destroy(queue);
+}
+
+TEST_FUNCTION(callback_queue_wait_for_room_zero_timeout_does_not_wait)
+{
+    // arrange
+    CALLBACK_QUEUE_HANDLE queue = callback_queue_create(sizeof(int), TEST_DEPTH, IOTHUB_CLIENT_CALLBACK_QUEUE_BLOCK, test_dispatch, NULL);
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_OK, push_item(queue, 1, true));
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_OK, push_item(queue, 2, true));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    bool result = callback_queue_wait_for_room(queue, 0);
+
+    // assert
+    ASSERT_IS_FALSE(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    callback_queue_destroy(queue);
+}
+
+TEST_FUNCTION(callback_queue_destroy_dispatches_queued_items_as_dropped)
+{
+    // arrange
+    CALLBACK_QUEUE_HANDLE queue = callback_queue_create(sizeof(int), TEST_DEPTH, IOTHUB_CLIENT_CALLBACK_QUEUE_BLOCK, test_dispatch, TEST_CONTEXT);
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_OK, push_item(queue, 1, true));
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_OK, push_item(queue, 2, false));
+
+    // act
+    callback_queue_destroy(queue);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, g_dispatchCount);
+    ASSERT_ARE_EQUAL(int, 1, g_dispatchedItems[0]);
+    ASSERT_IS_TRUE(g_dispatchedDropped[0]);
+    ASSERT_ARE_EQUAL(int, 2, g_dispatchedItems[1]);
+    ASSERT_IS_TRUE(g_dispatchedDropped[1]);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_CONTEXT, g_dispatchContext);
+}
+
+TEST_FUNCTION(callback_queue_get_statistics_NULL_arguments_fail)
+{
+    // arrange
+    IOTHUB_CLIENT_CALLBACK_QUEUE_STATISTICS statistics;
+    CALLBACK_QUEUE_HANDLE queue = callback_queue_create(sizeof(int), TEST_DEPTH, IOTHUB_CLIENT_CALLBACK_QUEUE_BLOCK, test_dispatch, NULL);
+
+    // act
+    int no_queue = callback_queue_get_statistics(NULL, &statistics);
+    int no_statistics = callback_queue_get_statistics(queue, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, no_queue);
+    ASSERT_ARE_NOT_EQUAL(int, 0, no_statistics);
+
+    // cleanup
+    callback_queue_destroy(queue);
+}
+
+TEST_FUNCTION(callback_queue_get_statistics_counts_dispatched_callbacks)
+{
+    // arrange
+    IOTHUB_CLIENT_CALLBACK_QUEUE_STATISTICS statistics;
+    CALLBACK_QUEUE_HANDLE queue = callback_queue_create(sizeof(int), TEST_DEPTH, IOTHUB_CLIENT_CALLBACK_QUEUE_BLOCK, test_dispatch, NULL);
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_OK, push_item(queue, 1, true));
+    ASSERT_ARE_EQUAL(CALLBACK_QUEUE_PUSH_RESULT, CALLBACK_QUEUE_PUSH_OK, push_item(queue, 2, true));
+    run_dispatch_thread();
+
+    // act
+    int result = callback_queue_get_statistics(queue, &statistics);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, TEST_DEPTH, statistics.depth);
+    ASSERT_ARE_EQUAL(size_t, 0, statistics.queued);
+    ASSERT_ARE_EQUAL(size_t, 2, statistics.peakQueued);
+    ASSERT_ARE_EQUAL(size_t, 2, statistics.callbacksQueued);
+    ASSERT_ARE_EQUAL(size_t, 2, statistics.callbacksDispatched);
+    ASSERT_ARE_EQUAL(size_t, 0, statistics.callbacksRejected);
+    ASSERT_ARE_EQUAL(size_t, 0, statistics.callbacksDropped);
+
+    // cleanup
+    callback_queue_destroy(queue);
+}
+
+END_TEST_SUITE(iothub_client_callback_queue_ut)
@@ -0,0 +1,633 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#endif
+
+#include "zlib.h"
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#include "testrunnerswitcher.h"
+#include "azure_macro_utils/macro_utils.h"
+#include "umock_c/umock_c.h"
+#include "umock_c/umocktypes_charptr.h"
+#include "umock_c/umocktypes_bool.h"
+#include "umock_c/umocktypes_stdint.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/buffer_.h"
+#include "iothub_message.h"
+#include "internal/iothub_message_private.h"
+#include "umock_c/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    extern BUFFER_HANDLE real_BUFFER_create_with_size(size_t buff_size);
+    extern void real_BUFFER_delete(BUFFER_HANDLE handle);
+    extern unsigned char* real_BUFFER_u_char(BUFFER_HANDLE handle);
+    extern size_t real_BUFFER_length(BUFFER_HANDLE handle);
+    extern int real_BUFFER_shrink(BUFFER_HANDLE handle, size_t decreaseSize, bool fromEnd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#undef ENABLE_MOCKS
+
+#include "iothub_client_options.h"
+#include "internal/iothub_client_compression.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+MU_DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", MU_ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+static IOTHUB_MESSAGE_HANDLE TEST_MESSAGE_HANDLE = (IOTHUB_MESSAGE_HANDLE)0x4242;
+
+#define TEST_BODY_SIZE 1024
+#define TEST_INFLATE_SIZE 4096
+
+static const char* TEST_TELEMETRY = "{\"deviceId\":\"thermostat-0001\",\"temperature\":21.5,\"humidity\":40.25,\"status\":\"ok\"}";
+static const char* TEST_DICTIONARY = "{\"deviceId\":\"thermostat-\",\"temperature\":,\"humidity\":,\"status\":\"ok\"}";
+
+// Body of the message under test, as the IoTHubMessage mocks report it
+static IOTHUBMESSAGE_CONTENT_TYPE g_contentType;
+static unsigned char g_body[TEST_BODY_SIZE + 1];
+static size_t g_bodySize;
+static const char* g_contentEncoding;
+// Body handed to IoTHubMessage_SetBody
+static BUFFER_HANDLE g_newBody;
+
+static IOTHUBMESSAGE_CONTENT_TYPE my_IoTHubMessage_GetContentType(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    (void)iotHubMessageHandle;
+    return g_contentType;
+}
+
+static IOTHUB_MESSAGE_RESULT my_IoTHubMessage_GetByteArray(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, const unsigned char** buffer, size_t* size)
+{
+    (void)iotHubMessageHandle;
+    *buffer = g_body;
+    *size = g_bodySize;
+    return IOTHUB_MESSAGE_OK;
+}
+
+static const char* my_IoTHubMessage_GetString(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    (void)iotHubMessageHandle;
+    return (const char*)g_body;
+}
+
+static const char* my_IoTHubMessage_GetContentEncodingSystemProperty(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    (void)iotHubMessageHandle;
+    return g_contentEncoding;
+}
+
+static IOTHUB_MESSAGE_RESULT my_IoTHubMessage_SetBody(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, BUFFER_HANDLE body)
+{
+    (void)iotHubMessageHandle;
+    g_newBody = body;
+    return IOTHUB_MESSAGE_OK;
+}
+
+// Fills the message body with telemetry records, each with a different sequence number
+static void set_telemetry_body(IOTHUBMESSAGE_CONTENT_TYPE contentType, size_t size)
+{
+    size_t i;
+
+    for (i = 0; i < size; i++)
+    {
+        g_body[i] = (unsigned char)TEST_TELEMETRY[i % strlen(TEST_TELEMETRY)];
+    }
+    g_body[size] = '\0';
+    g_bodySize = size;
+    g_contentType = contentType;
+}
+
+// Fills the message body with bytes that deflate cannot shrink
+static void set_random_body(size_t size)
+{
+    size_t i;
+    unsigned int seed = 12345;
+
+    for (i = 0; i < size; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        g_body[i] = (unsigned char)(seed >> 16);
+    }
+    g_bodySize = size;
+    g_contentType = IOTHUBMESSAGE_BYTEARRAY;
+}
+
+static COMPRESSION_HANDLE create_compression(IOTHUB_CLIENT_COMPRESSION algorithm)
+{
+    COMPRESSION_HANDLE handle = compression_create();
+    ASSERT_IS_NOT_NULL(handle);
+    ASSERT_ARE_EQUAL(int, 0, compression_set_option(handle, OPTION_COMPRESSION, &algorithm));
+    return handle;
+}
+
+// Inflates g_newBody with the given window bits (and dictionary) and checks it matches the original body
+static void assert_new_body_inflates_to_original(int windowBits, const char* dictionary)
+{
+    unsigned char inflated[TEST_INFLATE_SIZE];
+    z_stream stream;
+    int result;
+
+    ASSERT_IS_NOT_NULL(g_newBody);
+    ASSERT_IS_TRUE(real_BUFFER_length(g_newBody) < g_bodySize);
+
+    (void)memset(&stream, 0, sizeof(stream));
+    ASSERT_ARE_EQUAL(int, Z_OK, inflateInit2(&stream, windowBits));
+    stream.next_in = real_BUFFER_u_char(g_newBody);
+    stream.avail_in = (uInt)real_BUFFER_length(g_newBody);
+    stream.next_out = inflated;
+    stream.avail_out = sizeof(inflated);
+
+    result = inflate(&stream, Z_FINISH);
+    if (dictionary != NULL)
+    {
+        ASSERT_ARE_EQUAL(int, Z_NEED_DICT, result);
+        ASSERT_ARE_EQUAL(int, Z_OK, inflateSetDictionary(&stream, (const Bytef*)dictionary, (uInt)strlen(dictionary)));
+        result = inflate(&stream, Z_FINISH);
+    }
+
+    ASSERT_ARE_EQUAL(int, Z_STREAM_END, result);
+    ASSERT_ARE_EQUAL(size_t, g_bodySize, (size_t)stream.total_out);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(g_body, inflated, g_bodySize));
+
+    (void)inflateEnd(&stream);
+}
+
+BEGIN_TEST_SUITE(iothub_client_compression_ut)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+    umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, umocktypes_charptr_register_types());
+    ASSERT_ARE_EQUAL(int, 0, umocktypes_bool_register_types());
+    ASSERT_ARE_EQUAL(int, 0, umocktypes_stdint_register_types());
+
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_MESSAGE_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(BUFFER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_MESSAGE_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUBMESSAGE_CONTENT_TYPE, int);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+    REGISTER_GLOBAL_MOCK_HOOK(BUFFER_create_with_size, real_BUFFER_create_with_size);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(BUFFER_create_with_size, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(BUFFER_delete, real_BUFFER_delete);
+    REGISTER_GLOBAL_MOCK_HOOK(BUFFER_u_char, real_BUFFER_u_char);
+    REGISTER_GLOBAL_MOCK_HOOK(BUFFER_length, real_BUFFER_length);
+    REGISTER_GLOBAL_MOCK_HOOK(BUFFER_shrink, real_BUFFER_shrink);
+
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_GetContentType, my_IoTHubMessage_GetContentType);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_GetByteArray, my_IoTHubMessage_GetByteArray);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_GetString, my_IoTHubMessage_GetString);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_GetContentEncodingSystemProperty, my_IoTHubMessage_GetContentEncodingSystemProperty);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_SetBody, my_IoTHubMessage_SetBody);
+    REGISTER_GLOBAL_MOCK_RETURN(IoTHubMessage_SetContentEncodingSystemProperty, IOTHUB_MESSAGE_OK);
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+    umock_c_reset_all_calls();
+    set_telemetry_body(IOTHUBMESSAGE_BYTEARRAY, TEST_BODY_SIZE);
+    g_contentEncoding = NULL;
+    g_newBody = NULL;
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    if (g_newBody != NULL)
+    {
+        real_BUFFER_delete(g_newBody);
+    }
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+TEST_FUNCTION(compression_create_succeeds)
+{
+    // arrange
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_ARG));
+
+    // act
+    COMPRESSION_HANDLE handle = compression_create();
+
+    // assert
+    ASSERT_IS_NOT_NULL(handle);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    compression_destroy(handle);
+}
+
+TEST_FUNCTION(compression_create_allocation_fails)
+{
+    // arrange
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_ARG)).SetReturn(NULL);
+
+    // act
+    COMPRESSION_HANDLE handle = compression_create();
+
+    // assert
+    ASSERT_IS_NULL(handle);
+}
+
+TEST_FUNCTION(compression_destroy_NULL_does_nothing)
+{
+    // act
+    compression_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(compression_set_option_NULL_arguments_fail)
+{
+    // arrange
+    IOTHUB_CLIENT_COMPRESSION algorithm = IOTHUB_CLIENT_COMPRESSION_DEFLATE;
+    COMPRESSION_HANDLE handle = compression_create();
+
+    // act
+    int no_handle = compression_set_option(NULL, OPTION_COMPRESSION, &algorithm);
+    int no_name = compression_set_option(handle, NULL, &algorithm);
+    int no_value = compression_set_option(handle, OPTION_COMPRESSION, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, no_handle);
+    ASSERT_ARE_NOT_EQUAL(int, 0, no_name);
+    ASSERT_ARE_NOT_EQUAL(int, 0, no_value);
+
+    // cleanup
+    compression_destroy(handle);
+}
+
+TEST_FUNCTION(compression_set_option_unknown_option_fails)
+{
+    // arrange
+    int value = 1;
+    COMPRESSION_HANDLE handle = compression_create();
+
+    // act
+    int result = compression_set_option(handle, "unknown", &value);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    compression_destroy(handle);
+}
+
+TEST_FUNCTION(compression_set_option_invalid_compression_fails)
+{
+    // arrange
+    IOTHUB_CLIENT_COMPRESSION algorithm = (IOTHUB_CLIENT_COMPRESSION)42;
+    COMPRESSION_HANDLE handle = compression_create();
+
+    // act
+    int result = compression_set_option(handle, OPTION_COMPRESSION, &algorithm);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    compression_destroy(handle);
+}
+
+TEST_FUNCTION(compression_set_option_level_out_of_range_fails)
+{
+    // arrange
+    int too_low = 0;
+    int too_high = 10;
+    COMPRESSION_HANDLE handle = compression_create();
+
+    // act
+    int low_result = compression_set_option(handle, OPTION_COMPRESSION_LEVEL, &too_low);
+    int high_result = compression_set_option(handle, OPTION_COMPRESSION_LEVEL, &too_high);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, low_result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, high_result);
+
+    // cleanup
+    compression_destroy(handle);
+}
+
+TEST_FUNCTION(compression_set_option_dictionary_with_gzip_fails)
+{
+    // arrange
+    IOTHUB_CLIENT_COMPRESSION_DICTIONARY dictionary = { (const unsigned char*)TEST_DICTIONARY, strlen(TEST_DICTIONARY) };
+    IOTHUB_CLIENT_COMPRESSION gzip = IOTHUB_CLIENT_COMPRESSION_GZIP;
+    COMPRESSION_HANDLE gzip_handle = create_compression(IOTHUB_CLIENT_COMPRESSION_GZIP);
+    COMPRESSION_HANDLE deflate_handle = create_compression(IOTHUB_CLIENT_COMPRESSION_DEFLATE);
+    ASSERT_ARE_EQUAL(int, 0, compression_set_option(deflate_handle, OPTION_COMPRESSION_DICTIONARY, &dictionary));
+
+    // act
+    int dictionary_result = compression_set_option(gzip_handle, OPTION_COMPRESSION_DICTIONARY, &dictionary);
+    int gzip_result = compression_set_option(deflate_handle, OPTION_COMPRESSION, &gzip);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, dictionary_result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, gzip_result);
+
+    // cleanup
+    compression_destroy(gzip_handle);
+    compression_destroy(deflate_handle);
+}
+
+TEST_FUNCTION(compression_compress_message_NULL_arguments_fail)
+{
+    // arrange
+    COMPRESSION_HANDLE handle = create_compression(IOTHUB_CLIENT_COMPRESSION_DEFLATE);
+
+    // act
+    int no_handle = compression_compress_message(NULL, TEST_MESSAGE_HANDLE);
+    int no_message = compression_compress_message(handle, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, no_handle);
+    ASSERT_ARE_NOT_EQUAL(int, 0, no_message);
+
+    // cleanup
+    compression_destroy(handle);
+}
+
+TEST_FUNCTION(compression_compress_message_turned_off_leaves_message_unchanged)
+{
+    // arrange
+    COMPRESSION_HANDLE handle = compression_create();
+    umock_c_reset_all_calls();
+
+    // act
+    int result = compression_compress_message(handle, TEST_MESSAGE_HANDLE);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    compression_destroy(handle);
+}
+
+TEST_FUNCTION(compression_compress_message_deflate_succeeds)
+{
+    // arrange
+    COMPRESSION_HANDLE handle = create_compression(IOTHUB_CLIENT_COMPRESSION_DEFLATE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(IoTHubMessage_SetContentEncodingSystemProperty(TEST_MESSAGE_HANDLE, "deflate"));
+
+    // act
+    int result = compression_compress_message(handle, TEST_MESSAGE_HANDLE);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    assert_new_body_inflates_to_original(15, NULL);
+
+    // cleanup
+    compression_destroy(handle);
+}
+
+TEST_FUNCTION(compression_compress_message_gzip_succeeds)
+{
+    // arrange
+    COMPRESSION_HANDLE handle = create_compression(IOTHUB_CLIENT_COMPRESSION_GZIP);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(IoTHubMessage_SetContentEncodingSystemProperty(TEST_MESSAGE_HANDLE, "gzip"));
+
+    // act
+    int result = compression_compress_message(handle, TEST_MESSAGE_HANDLE);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    assert_new_body_inflates_to_original(15 + 16, NULL);
+
+    // cleanup
+    compression_destroy(handle);
+}
+
+TEST_FUNCTION(compression_compress_message_string_message_succeeds)
+{
+    // arrange
+    COMPRESSION_HANDLE handle = create_compression(IOTHUB_CLIENT_COMPRESSION_DEFLATE);
+    set_telemetry_body(IOTHUBMESSAGE_STRING, TEST_BODY_SIZE);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = compression_compress_message(handle, TEST_MESSAGE_HANDLE);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    assert_new_body_inflates_to_original(15, NULL);
+
+    // cleanup
+    compression_destroy(handle);
+}
+
+TEST_FUNCTION(compression_compress_message_reuses_the_stream)
+{
+    // arrange
+    COMPRESSION_HANDLE handle = create_compression(IOTHUB_CLIENT_COMPRESSION_DEFLATE);
+    ASSERT_ARE_EQUAL(int, 0, compression_compress_message(handle, TEST_MESSAGE_HANDLE));
+    real_BUFFER_delete(g_newBody);
+    g_newBody = NULL;
+
+    // act
+    int result = compression_compress_message(handle, TEST_MESSAGE_HANDLE);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    assert_new_body_inflates_to_original(15, NULL);
+
+    // cleanup
+    compression_destroy(handle);
+}
+
+TEST_FUNCTION(compression_compress_message_with_dictionary_succeeds)
+{
+    // arrange
+    IOTHUB_CLIENT_COMPRESSION_DICTIONARY dictionary = { (const unsigned char*)TEST_DICTIONARY, strlen(TEST_DICTIONARY) };
+    size_t threshold = 0;
+    size_t size_without_dictionary;
+    COMPRESSION_HANDLE handle = create_compression(IOTHUB_CLIENT_COMPRESSION_DEFLATE);
+    ASSERT_ARE_EQUAL(int, 0, compression_set_option(handle, OPTION_COMPRESSION_THRESHOLD, &threshold));
+    set_telemetry_body(IOTHUBMESSAGE_BYTEARRAY, strlen(TEST_TELEMETRY));
+
+    ASSERT_ARE_EQUAL(int, 0, compression_compress_message(handle, TEST_MESSAGE_HANDLE));
+    ASSERT_IS_NOT_NULL(g_newBody);
+    size_without_dictionary = real_BUFFER_length(g_newBody);
+    real_BUFFER_delete(g_newBody);
+    g_newBody = NULL;
+
+    ASSERT_ARE_EQUAL(int, 0, compression_set_option(handle, OPTION_COMPRESSION_DICTIONARY, &dictionary));
+
+    // act
+    int result = compression_compress_message(handle, TEST_MESSAGE_HANDLE);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    assert_new_body_inflates_to_original(15, TEST_DICTIONARY);
+    ASSERT_IS_TRUE(real_BUFFER_length(g_newBody) < size_without_dictionary);
+
+    // cleanup
+    compression_destroy(handle);
+}
+
+TEST_FUNCTION(compression_compress_message_below_threshold_leaves_message_unchanged)
+{
+    // arrange
+    size_t threshold = TEST_BODY_SIZE + 1;
+    COMPRESSION_HANDLE handle = create_compression(IOTHUB_CLIENT_COMPRESSION_DEFLATE);
+    ASSERT_ARE_EQUAL(int, 0, compression_set_option(handle, OPTION_COMPRESSION_THRESHOLD, &threshold));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetContentEncodingSystemProperty(TEST_MESSAGE_HANDLE));
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetContentType(TEST_MESSAGE_HANDLE));
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetByteArray(TEST_MESSAGE_HANDLE, IGNORED_ARG, IGNORED_ARG));
+
+    // act
+    int result = compression_compress_message(handle, TEST_MESSAGE_HANDLE);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NULL(g_newBody);
+
+    // cleanup
+    compression_destroy(handle);
+}
+
+#if SIZE_MAX > UINT_MAX
+TEST_FUNCTION(compression_compress_message_body_larger_than_zlib_takes_leaves_message_unchanged)
+{
+    // arrange
+    COMPRESSION_HANDLE handle = create_compression(IOTHUB_CLIENT_COMPRESSION_DEFLATE);
+    g_bodySize = (size_t)UINT_MAX + 1;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetContentEncodingSystemProperty(TEST_MESSAGE_HANDLE));
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetContentType(TEST_MESSAGE_HANDLE));
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetByteArray(TEST_MESSAGE_HANDLE, IGNORED_ARG, IGNORED_ARG));
+
+    // act
+    int result = compression_compress_message(handle, TEST_MESSAGE_HANDLE);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NULL(g_newBody);
+
+    // cleanup
+    compression_destroy(handle);
+}
+#endif
+
+TEST_FUNCTION(compression_compress_message_with_content_encoding_leaves_message_unchanged)
+{
+    // arrange
+    COMPRESSION_HANDLE handle = create_compression(IOTHUB_CLIENT_COMPRESSION_DEFLATE);
+    g_contentEncoding = "br";
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetContentEncodingSystemProperty(TEST_MESSAGE_HANDLE));
+
+    // act
+    int result = compression_compress_message(handle, TEST_MESSAGE_HANDLE);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NULL(g_newBody);
+
+    // cleanup
+    compression_destroy(handle);
+}
+
+TEST_FUNCTION(compression_compress_message_incompressible_body_leaves_message_unchanged)
+{
+    // arrange
+    COMPRESSION_HANDLE handle = create_compression(IOTHUB_CLIENT_COMPRESSION_DEFLATE);
+    set_random_body(TEST_BODY_SIZE);
+
+    // act
+    int result = compression_compress_message(handle, TEST_MESSAGE_HANDLE);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(g_newBody);
+
+    // cleanup
+    compression_destroy(handle);
+}
+
+TEST_FUNCTION(compression_compress_message_allocation_fails)
+{
+    // arrange
+    COMPRESSION_HANDLE handle = create_compression(IOTHUB_CLIENT_COMPRESSION_DEFLATE);
+    ASSERT_ARE_EQUAL(int, 0, compression_compress_message(handle, TEST_MESSAGE_HANDLE));
+    real_BUFFER_delete(g_newBody);
+    g_newBody = NULL;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(BUFFER_create_with_size(TEST_BODY_SIZE - 1)).SetReturn(NULL);
+
+    // act
+    int result = compression_compress_message(handle, TEST_MESSAGE_HANDLE);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(g_newBody);
+
+    // cleanup
+    compression_destroy(handle);
+}
+
+END_TEST_SUITE(iothub_client_compression_ut)
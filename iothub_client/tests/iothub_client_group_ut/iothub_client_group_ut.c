@@ -0,0 +1,639 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void* my_gballoc_realloc(void* ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#include "testrunnerswitcher.h"
+#include "azure_macro_utils/macro_utils.h"
+#include "umock_c/umock_c.h"
+#include "umock_c/umocktypes_stdint.h"
+#include "umock_c/umock_c_negative_tests.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/condition.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "iothub_device_client_ll.h"
+#undef ENABLE_MOCKS
+
+#include "iothub_client_group.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+MU_DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", MU_ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+TEST_DEFINE_ENUM_TYPE(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_RESULT_VALUES);
+
+#define TEST_DO_WORK_FREQUENCY_MS 100
+#define TEST_CURRENT_MS 1000
+
+static LOCK_HANDLE TEST_LOCK_HANDLE = (LOCK_HANDLE)0x4242;
+static COND_HANDLE TEST_COND_HANDLE = (COND_HANDLE)0x4243;
+static THREAD_HANDLE TEST_THREAD_HANDLE = (THREAD_HANDLE)0x4244;
+static TICK_COUNTER_HANDLE TEST_TICK_COUNTER_HANDLE = (TICK_COUNTER_HANDLE)0x4245;
+static IOTHUB_DEVICE_CLIENT_LL_HANDLE TEST_CLIENT_HANDLE = (IOTHUB_DEVICE_CLIENT_LL_HANDLE)0x4246;
+static void* TEST_CONTEXT = (void*)0x4247;
+
+static const IOTHUB_CLIENT_GROUP_CONFIG TEST_CONFIG = { 1, TEST_DO_WORK_FREQUENCY_MS };
+
+static THREAD_START_FUNC g_thread_func;
+static void* g_thread_func_arg;
+
+static size_t g_threadCreateCount;
+static size_t g_doWorkCount;
+static size_t g_lockDeinitCount;
+static size_t g_invokeCount;
+static IOTHUB_CLIENT_RESULT g_pollInfoResult;
+static size_t g_pollTimeoutMs;
+static IOTHUB_DEVICE_CLIENT_LL_HANDLE g_invokedClient;
+static void* g_invokeContext;
+
+static THREADAPI_RESULT my_ThreadAPI_Create(THREAD_HANDLE* threadHandle, THREAD_START_FUNC func, void* arg)
+{
+    *threadHandle = TEST_THREAD_HANDLE;
+    g_threadCreateCount++;
+    g_thread_func = func;
+    g_thread_func_arg = arg;
+    return THREADAPI_OK;
+}
+
+static int my_tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t* current_ms)
+{
+    (void)tick_counter;
+    *current_ms = TEST_CURRENT_MS;
+    return 0;
+}
+
+static void my_IoTHubDeviceClient_LL_DoWork(IOTHUB_DEVICE_CLIENT_LL_HANDLE iotHubClientHandle)
+{
+    (void)iotHubClientHandle;
+    g_doWorkCount++;
+}
+
+static IOTHUB_CLIENT_RESULT my_IoTHubDeviceClient_LL_GetPollInfo(IOTHUB_DEVICE_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_POLL_INFO* pollInfo)
+{
+    (void)iotHubClientHandle;
+    pollInfo->timeoutMs = g_pollTimeoutMs;
+    return g_pollInfoResult;
+}
+
+static void my_Lock_Deinit(LOCK_HANDLE handle)
+{
+    (void)handle;
+    g_lockDeinitCount++;
+}
+
+static void test_invoke_callback(IOTHUB_DEVICE_CLIENT_LL_HANDLE iotHubClientHandle, void* context)
+{
+    g_invokeCount++;
+    g_invokedClient = iotHubClientHandle;
+    g_invokeContext = context;
+}
+
+// Runs the last worker created on the test thread.  Condition_Wait fails once nothing is due, which ends the thread.
+static void run_worker_thread(void)
+{
+    ASSERT_IS_NOT_NULL(g_thread_func);
+    (void)g_thread_func(g_thread_func_arg);
+}
+
+static void register_global_mocks(void)
+{
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(COND_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(COND_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(THREAD_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREAD_START_FUNC, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREADAPI_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_DEVICE_CLIENT_LL_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_RESULT, int);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_realloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock_Init, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock, LOCK_ERROR);
+    REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_HOOK(Lock_Deinit, my_Lock_Deinit);
+
+    REGISTER_GLOBAL_MOCK_RETURN(Condition_Init, TEST_COND_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Condition_Init, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(Condition_Post, COND_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Condition_Wait, COND_ERROR);
+
+    REGISTER_GLOBAL_MOCK_HOOK(ThreadAPI_Create, my_ThreadAPI_Create);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(ThreadAPI_Create, THREADAPI_ERROR);
+    REGISTER_GLOBAL_MOCK_RETURN(ThreadAPI_Join, THREADAPI_OK);
+
+    REGISTER_GLOBAL_MOCK_RETURN(tickcounter_create, TEST_TICK_COUNTER_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(tickcounter_create, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, my_tickcounter_get_current_ms);
+
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubDeviceClient_LL_DoWork, my_IoTHubDeviceClient_LL_DoWork);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubDeviceClient_LL_GetPollInfo, my_IoTHubDeviceClient_LL_GetPollInfo);
+}
+
+static void set_expected_calls_for_create(void)
+{
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_create());
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(Condition_Init());
+    STRICT_EXPECTED_CALL(Condition_Init());
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+}
+
+BEGIN_TEST_SUITE(iothub_client_group_ut)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+    umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, umocktypes_stdint_register_types());
+    register_global_mocks();
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+    umock_c_reset_all_calls();
+    g_thread_func = NULL;
+    g_thread_func_arg = NULL;
+    g_pollInfoResult = IOTHUB_CLIENT_OK;
+    g_pollTimeoutMs = SIZE_MAX;
+    g_threadCreateCount = 0;
+    g_doWorkCount = 0;
+    g_lockDeinitCount = 0;
+    g_invokeCount = 0;
+    g_invokedClient = NULL;
+    g_invokeContext = NULL;
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+TEST_FUNCTION(IoTHubClientGroup_Create_NULL_config_fails)
+{
+    // act
+    IOTHUB_CLIENT_GROUP_HANDLE group = IoTHubClientGroup_Create(NULL);
+
+    // assert
+    ASSERT_IS_NULL(group);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(IoTHubClientGroup_Create_zero_threads_fails)
+{
+    // arrange
+    IOTHUB_CLIENT_GROUP_CONFIG config = { 0, TEST_DO_WORK_FREQUENCY_MS };
+
+    // act
+    IOTHUB_CLIENT_GROUP_HANDLE group = IoTHubClientGroup_Create(&config);
+
+    // assert
+    ASSERT_IS_NULL(group);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(IoTHubClientGroup_Create_zero_frequency_fails)
+{
+    // arrange
+    IOTHUB_CLIENT_GROUP_CONFIG config = { 1, 0 };
+
+    // act
+    IOTHUB_CLIENT_GROUP_HANDLE group = IoTHubClientGroup_Create(&config);
+
+    // assert
+    ASSERT_IS_NULL(group);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(IoTHubClientGroup_Create_succeeds)
+{
+    // arrange
+    set_expected_calls_for_create();
+
+    // act
+    IOTHUB_CLIENT_GROUP_HANDLE group = IoTHubClientGroup_Create(&TEST_CONFIG);
+
+    // assert
+    ASSERT_IS_NOT_NULL(group);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NOT_NULL(g_thread_func);
+
+    // cleanup
+    IoTHubClientGroup_Destroy(group);
+}
+
+TEST_FUNCTION(IoTHubClientGroup_Create_starts_one_thread_per_worker)
+{
+    // arrange
+    IOTHUB_CLIENT_GROUP_CONFIG config = { 3, TEST_DO_WORK_FREQUENCY_MS };
+
+    // act
+    IOTHUB_CLIENT_GROUP_HANDLE group = IoTHubClientGroup_Create(&config);
+
+    // assert
+    ASSERT_IS_NOT_NULL(group);
+    ASSERT_ARE_EQUAL(size_t, 3, g_threadCreateCount);
+
+    // cleanup
+    IoTHubClientGroup_Destroy(group);
+}
+
+TEST_FUNCTION(IoTHubClientGroup_Create_fails)
+{
+    // arrange
+    ASSERT_ARE_EQUAL(int, 0, umock_c_negative_tests_init());
+
+    set_expected_calls_for_create();
+    umock_c_negative_tests_snapshot();
+
+    for (size_t index = 0; index < umock_c_negative_tests_call_count(); index++)
+    {
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(index);
+
+        // act
+        IOTHUB_CLIENT_GROUP_HANDLE group = IoTHubClientGroup_Create(&TEST_CONFIG);
+
+        // assert
+        ASSERT_IS_NULL(group, "On failed call %lu", (unsigned long)index);
+    }
+
+    // cleanup
+    umock_c_negative_tests_deinit();
+}
+
+TEST_FUNCTION(IoTHubClientGroup_Destroy_stops_the_workers)
+{
+    // arrange
+    IOTHUB_CLIENT_GROUP_HANDLE group = IoTHubClientGroup_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Condition_Post(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(ThreadAPI_Join(TEST_THREAD_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Condition_Deinit(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Condition_Deinit(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock_Deinit(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock_Deinit(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    IoTHubClientGroup_Destroy(group);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(IoTHubClientGroup_AddDeviceClient_NULL_group_fails)
+{
+    // act
+    IOTHUB_CLIENT_GROUP_MEMBER_HANDLE member = IoTHubClientGroup_AddDeviceClient(NULL, TEST_CLIENT_HANDLE);
+
+    // assert
+    ASSERT_IS_NULL(member);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(IoTHubClientGroup_AddDeviceClient_NULL_client_fails)
+{
+    // arrange
+    IOTHUB_CLIENT_GROUP_HANDLE group = IoTHubClientGroup_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    // act
+    IOTHUB_CLIENT_GROUP_MEMBER_HANDLE member = IoTHubClientGroup_AddDeviceClient(group, NULL);
+
+    // assert
+    ASSERT_IS_NULL(member);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClientGroup_Destroy(group);
+}
+
+TEST_FUNCTION(IoTHubClientGroup_AddDeviceClient_succeeds)
+{
+    // arrange
+    IOTHUB_CLIENT_GROUP_HANDLE group = IoTHubClientGroup_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_ARG));
+    STRICT_EXPECTED_CALL(Condition_Post(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+
+    // act
+    IOTHUB_CLIENT_GROUP_MEMBER_HANDLE member = IoTHubClientGroup_AddDeviceClient(group, TEST_CLIENT_HANDLE);
+
+    // assert
+    ASSERT_IS_NOT_NULL(member);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClientGroup_Destroy(group);
+}
+
+TEST_FUNCTION(IoTHubClientGroup_worker_runs_DoWork_of_due_member)
+{
+    // arrange
+    IOTHUB_CLIENT_GROUP_HANDLE group = IoTHubClientGroup_Create(&TEST_CONFIG);
+    (void)IoTHubClientGroup_AddDeviceClient(group, TEST_CLIENT_HANDLE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(IoTHubDeviceClient_LL_DoWork(TEST_CLIENT_HANDLE));
+    STRICT_EXPECTED_CALL(IoTHubDeviceClient_LL_GetPollInfo(TEST_CLIENT_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    // Not due again before the DoWork frequency has passed
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Condition_Wait(IGNORED_PTR_ARG, IGNORED_PTR_ARG, TEST_DO_WORK_FREQUENCY_MS));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+
+    // act
+    run_worker_thread();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ASSERT_ARE_EQUAL(size_t, 1, g_doWorkCount);
+
+    // cleanup
+    IoTHubClientGroup_Destroy(group);
+}
+
+TEST_FUNCTION(IoTHubClientGroup_worker_runs_member_sooner_when_its_client_has_work)
+{
+    // arrange
+    IOTHUB_CLIENT_GROUP_HANDLE group = IoTHubClientGroup_Create(&TEST_CONFIG);
+    (void)IoTHubClientGroup_AddDeviceClient(group, TEST_CLIENT_HANDLE);
+    umock_c_reset_all_calls();
+
+    g_pollTimeoutMs = TEST_DO_WORK_FREQUENCY_MS / 10;
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(IoTHubDeviceClient_LL_DoWork(TEST_CLIENT_HANDLE));
+    STRICT_EXPECTED_CALL(IoTHubDeviceClient_LL_GetPollInfo(TEST_CLIENT_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Condition_Wait(IGNORED_PTR_ARG, IGNORED_PTR_ARG, TEST_DO_WORK_FREQUENCY_MS / 10));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+
+    // act
+    run_worker_thread();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClientGroup_Destroy(group);
+}
+
+TEST_FUNCTION(IoTHubClientGroup_worker_uses_the_frequency_when_GetPollInfo_fails)
+{
+    // arrange
+    IOTHUB_CLIENT_GROUP_HANDLE group = IoTHubClientGroup_Create(&TEST_CONFIG);
+    (void)IoTHubClientGroup_AddDeviceClient(group, TEST_CLIENT_HANDLE);
+    umock_c_reset_all_calls();
+
+    g_pollInfoResult = IOTHUB_CLIENT_ERROR;
+    g_pollTimeoutMs = 0;
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(IoTHubDeviceClient_LL_DoWork(TEST_CLIENT_HANDLE));
+    STRICT_EXPECTED_CALL(IoTHubDeviceClient_LL_GetPollInfo(TEST_CLIENT_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Condition_Wait(IGNORED_PTR_ARG, IGNORED_PTR_ARG, TEST_DO_WORK_FREQUENCY_MS));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+
+    // act
+    run_worker_thread();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClientGroup_Destroy(group);
+}
+
+TEST_FUNCTION(IoTHubClientGroup_worker_without_members_waits)
+{
+    // arrange
+    IOTHUB_CLIENT_GROUP_HANDLE group = IoTHubClientGroup_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Condition_Wait(IGNORED_PTR_ARG, IGNORED_PTR_ARG, 0));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+
+    // act
+    run_worker_thread();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClientGroup_Destroy(group);
+}
+
+TEST_FUNCTION(IoTHubClientGroup_Invoke_NULL_member_fails)
+{
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientGroup_Invoke(NULL, test_invoke_callback, TEST_CONTEXT);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(size_t, 0, g_invokeCount);
+}
+
+TEST_FUNCTION(IoTHubClientGroup_Invoke_NULL_callback_fails)
+{
+    // arrange
+    IOTHUB_CLIENT_GROUP_HANDLE group = IoTHubClientGroup_Create(&TEST_CONFIG);
+    IOTHUB_CLIENT_GROUP_MEMBER_HANDLE member = IoTHubClientGroup_AddDeviceClient(group, TEST_CLIENT_HANDLE);
+    umock_c_reset_all_calls();
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientGroup_Invoke(member, NULL, TEST_CONTEXT);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClientGroup_Destroy(group);
+}
+
+TEST_FUNCTION(IoTHubClientGroup_Invoke_calls_back_and_wakes_the_worker)
+{
+    // arrange
+    IOTHUB_CLIENT_GROUP_HANDLE group = IoTHubClientGroup_Create(&TEST_CONFIG);
+    IOTHUB_CLIENT_GROUP_MEMBER_HANDLE member = IoTHubClientGroup_AddDeviceClient(group, TEST_CLIENT_HANDLE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Condition_Post(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientGroup_Invoke(member, test_invoke_callback, TEST_CONTEXT);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, g_invokeCount);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_CLIENT_HANDLE, g_invokedClient);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_CONTEXT, g_invokeContext);
+
+    // cleanup
+    IoTHubClientGroup_Destroy(group);
+}
+
+TEST_FUNCTION(IoTHubClientGroup_Invoke_lock_fails)
+{
+    // arrange
+    IOTHUB_CLIENT_GROUP_HANDLE group = IoTHubClientGroup_Create(&TEST_CONFIG);
+    IOTHUB_CLIENT_GROUP_MEMBER_HANDLE member = IoTHubClientGroup_AddDeviceClient(group, TEST_CLIENT_HANDLE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG)).SetReturn(LOCK_ERROR);
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientGroup_Invoke(member, test_invoke_callback, TEST_CONTEXT);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, g_invokeCount);
+
+    // cleanup
+    IoTHubClientGroup_Destroy(group);
+}
+
+TEST_FUNCTION(IoTHubClientGroup_RemoveDeviceClient_stops_its_DoWork)
+{
+    // arrange
+    IOTHUB_CLIENT_GROUP_HANDLE group = IoTHubClientGroup_Create(&TEST_CONFIG);
+    IOTHUB_CLIENT_GROUP_MEMBER_HANDLE member = IoTHubClientGroup_AddDeviceClient(group, TEST_CLIENT_HANDLE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock_Deinit(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(member));
+
+    // act
+    IoTHubClientGroup_RemoveDeviceClient(member);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    umock_c_reset_all_calls();
+    run_worker_thread();
+    ASSERT_ARE_EQUAL(size_t, 0, g_doWorkCount);
+
+    // cleanup
+    IoTHubClientGroup_Destroy(group);
+}
+
+TEST_FUNCTION(IoTHubClientGroup_Destroy_removes_the_remaining_members)
+{
+    // arrange
+    IOTHUB_CLIENT_GROUP_HANDLE group = IoTHubClientGroup_Create(&TEST_CONFIG);
+    (void)IoTHubClientGroup_AddDeviceClient(group, TEST_CLIENT_HANDLE);
+    umock_c_reset_all_calls();
+
+    // act
+    IoTHubClientGroup_Destroy(group);
+
+    // assert
+    // The member's lock, the worker's and the group's; the client itself is left to the application
+    ASSERT_ARE_EQUAL(size_t, 3, g_lockDeinitCount);
+}
+
+END_TEST_SUITE(iothub_client_group_ut)
@@ -0,0 +1,302 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#endif
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#include "testrunnerswitcher.h"
+#include "azure_macro_utils/macro_utils.h"
+#include "umock_c/umock_c.h"
+#include "umock_c/umocktypes_stdint.h"
+#include "umock_c/umock_c_negative_tests.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "umock_c/umock_c_prod.h"
+#undef ENABLE_MOCKS
+
+#include "internal/iothub_client_metrics.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+MU_DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", MU_ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+static TICK_COUNTER_HANDLE TEST_TICK_COUNTER_HANDLE = (TICK_COUNTER_HANDLE)0x4246;
+
+static tickcounter_ms_t g_current_ms;
+
+static int my_tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t* current_ms)
+{
+    (void)tick_counter;
+    *current_ms = g_current_ms;
+    return 0;
+}
+
+static void register_global_mocks(void)
+{
+    REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+    REGISTER_GLOBAL_MOCK_RETURN(tickcounter_create, TEST_TICK_COUNTER_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(tickcounter_create, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, my_tickcounter_get_current_ms);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(tickcounter_get_current_ms, MU_FAILURE);
+}
+
+BEGIN_TEST_SUITE(iothub_client_metrics_ut)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+    umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, umocktypes_stdint_register_types());
+    register_global_mocks();
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+    umock_c_reset_all_calls();
+    g_current_ms = 0;
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+TEST_FUNCTION(metrics_create_succeeds)
+{
+    // arrange
+    IOTHUB_CLIENT_METRICS snapshot;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_create());
+
+    // act
+    METRICS_HANDLE metrics = metrics_create();
+
+    // assert
+    ASSERT_IS_NOT_NULL(metrics);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, metrics_get_snapshot(metrics, &snapshot));
+    ASSERT_ARE_EQUAL(size_t, 0, snapshot.messagesEnqueued);
+    ASSERT_ARE_EQUAL(size_t, 0, snapshot.ackLatencyCount);
+
+    // cleanup
+    metrics_destroy(metrics);
+}
+
+TEST_FUNCTION(metrics_create_negative_tests)
+{
+    // arrange
+    size_t i;
+    size_t count;
+
+    ASSERT_ARE_EQUAL(int, 0, umock_c_negative_tests_init());
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_create());
+    umock_c_negative_tests_snapshot();
+
+    count = umock_c_negative_tests_call_count();
+    for (i = 0; i < count; i++)
+    {
+        METRICS_HANDLE metrics;
+        char temp_str[64];
+
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(i);
+
+        // act
+        metrics = metrics_create();
+
+        // assert
+        (void)sprintf(temp_str, "Failure in test %lu/%lu", (unsigned long)i, (unsigned long)count);
+        ASSERT_IS_NULL(metrics, temp_str);
+    }
+
+    // cleanup
+    umock_c_negative_tests_deinit();
+}
+
+TEST_FUNCTION(metrics_destroy_NULL_does_nothing)
+{
+    // act
+    metrics_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(metrics_add_accumulates_into_the_counter)
+{
+    // arrange
+    IOTHUB_CLIENT_METRICS snapshot;
+    METRICS_HANDLE metrics = metrics_create();
+
+    // act
+    metrics_add(metrics, METRICS_BYTES_SENT, 100);
+    metrics_add(metrics, METRICS_BYTES_SENT, 28);
+    metrics_add(metrics, METRICS_SEND_RETRIES, 1);
+    metrics_add(metrics, METRICS_DISCONNECTS, 2);
+    metrics_add(NULL, METRICS_BYTES_SENT, 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, metrics_get_snapshot(metrics, &snapshot));
+    ASSERT_ARE_EQUAL(size_t, 128, snapshot.bytesSent);
+    ASSERT_ARE_EQUAL(size_t, 1, snapshot.sendRetries);
+    ASSERT_ARE_EQUAL(size_t, 2, snapshot.disconnects);
+    ASSERT_ARE_EQUAL(size_t, 0, snapshot.bytesReceived);
+
+    // cleanup
+    metrics_destroy(metrics);
+}
+
+TEST_FUNCTION(metrics_get_current_ms_is_never_zero)
+{
+    // arrange
+    METRICS_HANDLE metrics = metrics_create();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+
+    // act
+    tickcounter_ms_t result = metrics_get_current_ms(metrics);
+
+    // assert
+    ASSERT_ARE_EQUAL(uint64_t, 1, (uint64_t)result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    metrics_destroy(metrics);
+}
+
+TEST_FUNCTION(metrics_get_current_ms_tickcounter_fail_returns_zero)
+{
+    // arrange
+    METRICS_HANDLE metrics = metrics_create();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG)).SetReturn(MU_FAILURE);
+
+    // act
+    tickcounter_ms_t result = metrics_get_current_ms(metrics);
+
+    // assert
+    ASSERT_ARE_EQUAL(uint64_t, 0, (uint64_t)result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    metrics_destroy(metrics);
+}
+
+TEST_FUNCTION(metrics_record_send_complete_counts_each_result)
+{
+    // arrange
+    IOTHUB_CLIENT_METRICS snapshot;
+    METRICS_HANDLE metrics = metrics_create();
+
+    // act
+    metrics_record_send_complete(metrics, IOTHUB_CLIENT_CONFIRMATION_OK, 0);
+    metrics_record_send_complete(metrics, IOTHUB_CLIENT_CONFIRMATION_MESSAGE_TIMEOUT, 1);
+    metrics_record_send_complete(metrics, IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY, 1);
+    metrics_record_send_complete(metrics, IOTHUB_CLIENT_CONFIRMATION_ERROR, 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, metrics_get_snapshot(metrics, &snapshot));
+    ASSERT_ARE_EQUAL(size_t, 1, snapshot.messagesAcknowledged);
+    ASSERT_ARE_EQUAL(size_t, 1, snapshot.messagesTimedOut);
+    ASSERT_ARE_EQUAL(size_t, 1, snapshot.messagesDropped);
+    ASSERT_ARE_EQUAL(size_t, 1, snapshot.messagesFailed);
+    ASSERT_ARE_EQUAL(size_t, 0, snapshot.ackLatencyCount);
+
+    // cleanup
+    metrics_destroy(metrics);
+}
+
+TEST_FUNCTION(metrics_record_send_complete_adds_acknowledgements_to_the_histogram)
+{
+    // arrange
+    IOTHUB_CLIENT_METRICS snapshot;
+    METRICS_HANDLE metrics = metrics_create();
+    tickcounter_ms_t enqueued_ms = metrics_get_current_ms(metrics);
+
+    // act
+    g_current_ms = 3;
+    metrics_record_send_complete(metrics, IOTHUB_CLIENT_CONFIRMATION_OK, enqueued_ms);
+    g_current_ms = 40;
+    metrics_record_send_complete(metrics, IOTHUB_CLIENT_CONFIRMATION_OK, enqueued_ms);
+    g_current_ms = 60000;
+    metrics_record_send_complete(metrics, IOTHUB_CLIENT_CONFIRMATION_OK, enqueued_ms);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, metrics_get_snapshot(metrics, &snapshot));
+    ASSERT_ARE_EQUAL(size_t, 3, snapshot.messagesAcknowledged);
+    ASSERT_ARE_EQUAL(size_t, 3, snapshot.ackLatencyCount);
+    ASSERT_ARE_EQUAL(size_t, 3 + 40 + 60000, snapshot.ackLatencyTotalMs);
+    ASSERT_ARE_EQUAL(size_t, 1, snapshot.ackLatencyBuckets[0]);
+    ASSERT_ARE_EQUAL(size_t, 1, snapshot.ackLatencyBuckets[3]);
+    ASSERT_ARE_EQUAL(size_t, 1, snapshot.ackLatencyBuckets[IOTHUB_CLIENT_METRICS_LATENCY_BUCKET_COUNT - 1]);
+
+    // cleanup
+    metrics_destroy(metrics);
+}
+
+TEST_FUNCTION(metrics_get_snapshot_NULL_arguments_fail)
+{
+    // arrange
+    IOTHUB_CLIENT_METRICS snapshot;
+    METRICS_HANDLE metrics = metrics_create();
+    umock_c_reset_all_calls();
+
+    // act
+    int no_handle = metrics_get_snapshot(NULL, &snapshot);
+    int no_snapshot = metrics_get_snapshot(metrics, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, no_handle);
+    ASSERT_ARE_NOT_EQUAL(int, 0, no_snapshot);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    metrics_destroy(metrics);
+}
+
+END_TEST_SUITE(iothub_client_metrics_ut)
@@ -1653,6 +1653,258 @@ TEST_FUNCTION(IoTHubClient_Properties_Deserializer_GetNext_three_writable_and_re
     }
 }
 
+//
+// IoTHubClient_Properties_Deserializer_CreateStreaming tests.  The streaming deserializer must enumerate exactly
+// what IoTHubClient_Properties_Deserializer_Create does, so most tests reuse the JSON and expected results above.
+//
+
+// Names with JSON escapes and extra whitespace between tokens.
+static unsigned const char TEST_JSON_ESCAPED_NAMES_WRITABLE[] = "{ \"test\\\"Component\" : { \"__t\" : \"c\" , \"na\\u006De1\" : 1234 } ,\r\n \"$version\" : " STR(TEST_TWIN_VER_2) " }";
+// Structurally valid JSON, but the property value cannot be parsed.  Only IoTHubClient_Properties_Deserializer_GetNext detects this.
+static unsigned const char TEST_JSON_INVALID_VALUE_WRITABLE[] = "{\"name1\":tru,\"$version\":" STR(TEST_TWIN_VER_2) "}";
+// Truncated JSON.
+static unsigned const char TEST_JSON_TRUNCATED[] = "{ \"desired\": { \"name1\":1234, \"$version\":17 ";
+
+static IOTHUB_CLIENT_PROPERTIES_DESERIALIZER_HANDLE TestAllocateStreamingPropertiesReader(IOTHUB_CLIENT_PROPERTY_PAYLOAD_TYPE payloadType, const unsigned char* payload)
+{
+    IOTHUB_CLIENT_PROPERTIES_DESERIALIZER_HANDLE h = NULL;
+    size_t payloadLength = strlen((const char*)payload);
+
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_Properties_Deserializer_CreateStreaming(payloadType, payload, payloadLength, &h);
+
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_IS_NOT_NULL(h);
+
+    umock_c_reset_all_calls();
+
+    return h;
+}
+
+static void TestStreamingDeserializedProperties(IOTHUB_CLIENT_PROPERTY_PAYLOAD_TYPE payloadType, const unsigned char* payload, const IOTHUB_CLIENT_PROPERTY_PARSED* expectedProperties, size_t numExpectedProperties)
+{
+    // arrange
+    IOTHUB_CLIENT_PROPERTIES_DESERIALIZER_HANDLE h = TestAllocateStreamingPropertiesReader(payloadType, payload);
+    size_t numPropertiesVisited = 0;
+
+    // act|assert
+    while (true)
+    {
+        IOTHUB_CLIENT_PROPERTY_PARSED property;
+        bool propertySpecified;
+        ResetTestProperty(&property);
+
+        IOTHUB_CLIENT_RESULT result = IoTHubClient_Properties_Deserializer_GetNext(h, &property, &propertySpecified);
+        ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+
+        if (numPropertiesVisited == numExpectedProperties)
+        {
+            ASSERT_IS_FALSE(propertySpecified);
+            break;
+        }
+        ASSERT_IS_TRUE(propertySpecified);
+
+        CompareProperties(expectedProperties + numPropertiesVisited, &property);
+
+        IoTHubClient_Properties_DeserializerProperty_Destroy(&property);
+        numPropertiesVisited++;
+    }
+
+    // cleanup
+    IoTHubClient_Properties_Deserializer_Destroy(h);
+}
+
+static void test_IoTHubClient_Properties_Deserializer_CreateStreaming_invalid_json(IOTHUB_CLIENT_PROPERTY_PAYLOAD_TYPE payloadType, const unsigned char* invalidJson)
+{
+    // arrange
+    IOTHUB_CLIENT_PROPERTIES_DESERIALIZER_HANDLE h = NULL;
+    size_t invalidJsonLen = strlen((const char*)invalidJson);
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_Properties_Deserializer_CreateStreaming(payloadType, invalidJson, invalidJsonLen, &h);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_IS_NULL(h);
+}
+
+TEST_FUNCTION(IoTHubClient_Properties_Deserializer_CreateStreaming_invalid_payload_type)
+{
+    // arrange
+    IOTHUB_CLIENT_PROPERTIES_DESERIALIZER_HANDLE h = NULL;
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_Properties_Deserializer_CreateStreaming((IOTHUB_CLIENT_PROPERTY_PAYLOAD_TYPE)1234, TEST_JSON_ONE_PROPERTY_ALL, TEST_JSON_ONE_PROPERTY_ALL_LEN, &h);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_IS_NULL(h);
+}
+
+TEST_FUNCTION(IoTHubClient_Properties_Deserializer_CreateStreaming_NULL_payload)
+{
+    // arrange
+    IOTHUB_CLIENT_PROPERTIES_DESERIALIZER_HANDLE h = NULL;
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_Properties_Deserializer_CreateStreaming(IOTHUB_CLIENT_PROPERTY_PAYLOAD_ALL, NULL, TEST_JSON_ONE_PROPERTY_ALL_LEN, &h);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_IS_NULL(h);
+}
+
+TEST_FUNCTION(IoTHubClient_Properties_Deserializer_CreateStreaming_NULL_handle)
+{
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_Properties_Deserializer_CreateStreaming(IOTHUB_CLIENT_PROPERTY_PAYLOAD_ALL, TEST_JSON_ONE_PROPERTY_ALL, TEST_JSON_ONE_PROPERTY_ALL_LEN, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+}
+
+TEST_FUNCTION(IoTHubClient_Properties_Deserializer_CreateStreaming_does_not_copy_payload)
+{
+    // arrange
+    IOTHUB_CLIENT_PROPERTIES_DESERIALIZER_HANDLE h = NULL;
+    STRICT_EXPECTED_CALL(gballoc_calloc(IGNORED_NUM_ARG, IGNORED_NUM_ARG));
+    // Scratch buffer used to hand the $version value to parson.
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(json_parse_string(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(json_value_get_type(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(json_value_free(IGNORED_PTR_ARG));
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_Properties_Deserializer_CreateStreaming(IOTHUB_CLIENT_PROPERTY_PAYLOAD_ALL, TEST_JSON_ONE_PROPERTY_ALL, TEST_JSON_ONE_PROPERTY_ALL_LEN, &h);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_IS_NOT_NULL(h);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClient_Properties_Deserializer_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubClient_Properties_Deserializer_CreateStreaming_invalid_JSON_fail)
+{
+    test_IoTHubClient_Properties_Deserializer_CreateStreaming_invalid_json(IOTHUB_CLIENT_PROPERTY_PAYLOAD_ALL, TEST_INVALID_JSON);
+}
+
+TEST_FUNCTION(IoTHubClient_Properties_Deserializer_CreateStreaming_missing_version_fail)
+{
+    test_IoTHubClient_Properties_Deserializer_CreateStreaming_invalid_json(IOTHUB_CLIENT_PROPERTY_PAYLOAD_ALL, TEST_JSON_NO_VERSION);
+}
+
+TEST_FUNCTION(IoTHubClient_Properties_Deserializer_CreateStreaming_truncated_JSON_fail)
+{
+    test_IoTHubClient_Properties_Deserializer_CreateStreaming_invalid_json(IOTHUB_CLIENT_PROPERTY_PAYLOAD_ALL, TEST_JSON_TRUNCATED);
+}
+
+TEST_FUNCTION(IoTHubClient_Properties_Deserializer_CreateStreaming_GetVersion_success)
+{
+    // arrange
+    IOTHUB_CLIENT_PROPERTIES_DESERIALIZER_HANDLE h = TestAllocateStreamingPropertiesReader(IOTHUB_CLIENT_PROPERTY_PAYLOAD_WRITABLE_UPDATES, TEST_JSON_ONE_PROPERTY_WRITABLE);
+    int propertiesVersion = 0;
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_Properties_Deserializer_GetVersion(h, &propertiesVersion);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(int, TEST_TWIN_VER_2, propertiesVersion);
+
+    // cleanup
+    IoTHubClient_Properties_Deserializer_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubClient_Properties_Deserializer_CreateStreaming_GetNext_all_one_property_success)
+{
+    IOTHUB_CLIENT_PROPERTY_PARSED expectedPropList[] = { TEST_EXPECTED_PROPERTY1 };
+    TestStreamingDeserializedProperties(IOTHUB_CLIENT_PROPERTY_PAYLOAD_ALL, TEST_JSON_ONE_PROPERTY_ALL, expectedPropList, 1);
+}
+
+TEST_FUNCTION(IoTHubClient_Properties_Deserializer_CreateStreaming_GetNext_no_properties_success)
+{
+    TestStreamingDeserializedProperties(IOTHUB_CLIENT_PROPERTY_PAYLOAD_WRITABLE_UPDATES, TEST_JSON_NO_DESIRED, NULL, 0);
+}
+
+TEST_FUNCTION(IoTHubClient_Properties_Deserializer_CreateStreaming_GetNext_writable_three_properties)
+{
+    IOTHUB_CLIENT_PROPERTY_PARSED expectedPropList[] = { TEST_EXPECTED_PROPERTY1, TEST_EXPECTED_PROPERTY2, TEST_EXPECTED_PROPERTY3 };
+    TestStreamingDeserializedProperties(IOTHUB_CLIENT_PROPERTY_PAYLOAD_WRITABLE_UPDATES, TEST_JSON_THREE_PROPERTIES_WRITABLE, expectedPropList, 3);
+}
+
+TEST_FUNCTION(IoTHubClient_Properties_Deserializer_CreateStreaming_GetNext_three_reported_update_properties)
+{
+    IOTHUB_CLIENT_PROPERTY_PARSED expectedPropList[] = { TEST_EXPECTED_PROPERTY1, TEST_EXPECTED_PROPERTY2, TEST_EXPECTED_PROPERTY3, TEST_EXPECTED_PROPERTY4, TEST_EXPECTED_PROPERTY5, TEST_EXPECTED_PROPERTY6 };
+    TestStreamingDeserializedProperties(IOTHUB_CLIENT_PROPERTY_PAYLOAD_ALL, TEST_JSON_THREE_REPORTED_UPDATE_PROPERTIES_ALL, expectedPropList, 6);
+}
+
+TEST_FUNCTION(IoTHubClient_Properties_Deserializer_CreateStreaming_GetNext_three_writable_all_component)
+{
+    IOTHUB_CLIENT_PROPERTY_PARSED expectedPropList[] = { TEST_EXPECTED_PROPERTY1, TEST_EXPECTED_PROPERTY2, TEST_EXPECTED_PROPERTY3 };
+    expectedPropList[0].componentName = TEST_COMPONENT_NAME_1;
+    expectedPropList[1].componentName = TEST_COMPONENT_NAME_1;
+    expectedPropList[2].componentName = TEST_COMPONENT_NAME_1;
+    TestStreamingDeserializedProperties(IOTHUB_CLIENT_PROPERTY_PAYLOAD_ALL, TEST_JSON_THREE_PROPERTIES_COMPONENT_ALL, expectedPropList, 3);
+}
+
+TEST_FUNCTION(IoTHubClient_Properties_Deserializer_CreateStreaming_GetNext_three_writable_and_reported_properties)
+{
+    IOTHUB_CLIENT_PROPERTY_PARSED expectedPropList[] = { TEST_EXPECTED_PROPERTY1, TEST_EXPECTED_PROPERTY2, TEST_EXPECTED_PROPERTY3, TEST_EXPECTED_PROPERTY4, TEST_EXPECTED_PROPERTY5, TEST_EXPECTED_PROPERTY6 };
+    expectedPropList[0].componentName = TEST_COMPONENT_NAME_1;
+    expectedPropList[1].componentName = TEST_COMPONENT_NAME_2;
+    expectedPropList[2].componentName = TEST_COMPONENT_NAME_3;
+    expectedPropList[3].componentName = TEST_COMPONENT_NAME_4;
+    expectedPropList[4].componentName = TEST_COMPONENT_NAME_5;
+    expectedPropList[5].componentName = TEST_COMPONENT_NAME_6;
+
+    TestStreamingDeserializedProperties(IOTHUB_CLIENT_PROPERTY_PAYLOAD_ALL, TEST_JSON_THREE_WRITABLE_REPORTED_IN_SEPARATE_COMPONENTS, expectedPropList, 6);
+}
+
+TEST_FUNCTION(IoTHubClient_Properties_Deserializer_CreateStreaming_GetNext_escaped_names)
+{
+    IOTHUB_CLIENT_PROPERTY_PARSED expectedPropList[] = { TEST_EXPECTED_PROPERTY1 };
+    expectedPropList[0].componentName = "test\"Component";
+    TestStreamingDeserializedProperties(IOTHUB_CLIENT_PROPERTY_PAYLOAD_WRITABLE_UPDATES, TEST_JSON_ESCAPED_NAMES_WRITABLE, expectedPropList, 1);
+}
+
+TEST_FUNCTION(IoTHubClient_Properties_Deserializer_CreateStreaming_GetNext_invalid_value_fail)
+{
+    // arrange
+    IOTHUB_CLIENT_PROPERTIES_DESERIALIZER_HANDLE h = TestAllocateStreamingPropertiesReader(IOTHUB_CLIENT_PROPERTY_PAYLOAD_WRITABLE_UPDATES, TEST_JSON_INVALID_VALUE_WRITABLE);
+    IOTHUB_CLIENT_PROPERTY_PARSED property;
+    bool propertySpecified;
+    ResetTestProperty(&property);
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_Properties_Deserializer_GetNext(h, &property, &propertySpecified);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_IS_TRUE(0 == memcmp(&unfilledProperty, &property, sizeof(property)));
+
+    // cleanup
+    IoTHubClient_Properties_Deserializer_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubClient_Properties_Deserializer_CreateStreaming_Destroy_success)
+{
+    // arrange
+    IOTHUB_CLIENT_PROPERTIES_DESERIALIZER_HANDLE h = TestAllocateStreamingPropertiesReader(IOTHUB_CLIENT_PROPERTY_PAYLOAD_ALL, TEST_JSON_ONE_PROPERTY_ALL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    IoTHubClient_Properties_Deserializer_Destroy(h);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
 //
 // IoTHubClient_Properties_DeserializerProperty_Destroy tests
 //
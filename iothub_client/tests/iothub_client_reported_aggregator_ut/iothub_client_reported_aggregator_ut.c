@@ -0,0 +1,659 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#endif
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void* my_gballoc_calloc(size_t nmemb, size_t size)
+{
+    return calloc(nmemb, size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#include "testrunnerswitcher.h"
+#include "azure_macro_utils/macro_utils.h"
+#include "umock_c/umock_c.h"
+#include "umock_c/umock_c_negative_tests.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "umock_c/umock_c_prod.h"
+#undef ENABLE_MOCKS
+
+#include "internal/iothub_client_reported_aggregator.h"
+#include "parson.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+MU_DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", MU_ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+TEST_DEFINE_ENUM_TYPE(REPORTED_AGGREGATOR_FLUSH_RESULT, REPORTED_AGGREGATOR_FLUSH_RESULT_VALUES);
+
+#define TEST_FLUSH_INTERVAL_MS 100
+#define TEST_STATUS_OK 204
+#define TEST_STATUS_FAILED 400
+
+static int g_callbackCount;
+static int g_lastStatusCode;
+static void* g_lastContext;
+
+static void test_reported_state_callback(int status_code, void* userContextCallback)
+{
+    g_callbackCount++;
+    g_lastStatusCode = status_code;
+    g_lastContext = userContextCallback;
+}
+
+static void register_global_mocks(void)
+{
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_calloc, my_gballoc_calloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_calloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+}
+
+static int add_report(REPORTED_AGGREGATOR_HANDLE handle, const char* report, void* context, tickcounter_ms_t now)
+{
+    return reported_aggregator_add(handle, (const unsigned char*)report, strlen(report), test_reported_state_callback, context, now);
+}
+
+// Flushes the aggregator and checks that the merged PATCH is equivalent to expectedPatch.
+static void* flush_and_assert_patch(REPORTED_AGGREGATOR_HANDLE handle, tickcounter_ms_t now, const char* expectedPatch)
+{
+    const unsigned char* patch = NULL;
+    size_t size = 0;
+    void* batchContext = NULL;
+    char* patchString;
+    JSON_Value* patchValue;
+    JSON_Value* expectedValue;
+
+    REPORTED_AGGREGATOR_FLUSH_RESULT result = reported_aggregator_flush(handle, now, &patch, &size, &batchContext);
+    ASSERT_ARE_EQUAL(REPORTED_AGGREGATOR_FLUSH_RESULT, REPORTED_AGGREGATOR_FLUSH_PATCH_READY, result);
+    ASSERT_IS_NOT_NULL(patch);
+    ASSERT_IS_NOT_NULL(batchContext);
+
+    patchString = (char*)malloc(size + 1);
+    ASSERT_IS_NOT_NULL(patchString);
+    memcpy(patchString, patch, size);
+    patchString[size] = '\0';
+
+    patchValue = json_parse_string(patchString);
+    expectedValue = json_parse_string(expectedPatch);
+    ASSERT_IS_NOT_NULL(patchValue);
+    ASSERT_IS_NOT_NULL(expectedValue);
+    ASSERT_ARE_EQUAL(int, 1, json_value_equals(expectedValue, patchValue), patchString);
+
+    json_value_free(expectedValue);
+    json_value_free(patchValue);
+    free(patchString);
+
+    return batchContext;
+}
+
+static REPORTED_AGGREGATOR_FLUSH_RESULT flush(REPORTED_AGGREGATOR_HANDLE handle, tickcounter_ms_t now)
+{
+    const unsigned char* patch = NULL;
+    size_t size = 0;
+    void* batchContext = NULL;
+    return reported_aggregator_flush(handle, now, &patch, &size, &batchContext);
+}
+
+BEGIN_TEST_SUITE(iothub_client_reported_aggregator_ut)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+    umock_c_init(on_umock_c_error);
+    register_global_mocks();
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+    umock_c_reset_all_calls();
+    g_callbackCount = 0;
+    g_lastStatusCode = -1;
+    g_lastContext = NULL;
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+TEST_FUNCTION(reported_aggregator_create_succeeds)
+{
+    // act
+    REPORTED_AGGREGATOR_HANDLE handle = reported_aggregator_create(TEST_FLUSH_INTERVAL_MS);
+
+    // assert
+    ASSERT_IS_NOT_NULL(handle);
+    ASSERT_IS_TRUE(reported_aggregator_is_idle(handle));
+
+    // cleanup
+    reported_aggregator_destroy(handle, 0);
+}
+
+TEST_FUNCTION(reported_aggregator_create_allocation_fails)
+{
+    // arrange
+    STRICT_EXPECTED_CALL(gballoc_calloc(IGNORED_ARG, IGNORED_ARG)).SetReturn(NULL);
+
+    // act
+    REPORTED_AGGREGATOR_HANDLE handle = reported_aggregator_create(TEST_FLUSH_INTERVAL_MS);
+
+    // assert
+    ASSERT_IS_NULL(handle);
+}
+
+TEST_FUNCTION(reported_aggregator_destroy_NULL_handle_does_nothing)
+{
+    // act
+    reported_aggregator_destroy(NULL, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(reported_aggregator_destroy_completes_pending_callbacks)
+{
+    // arrange
+    REPORTED_AGGREGATOR_HANDLE handle = reported_aggregator_create(TEST_FLUSH_INTERVAL_MS);
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":1}", NULL, 0));
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"b\":1}", (void*)0x42, 0));
+
+    // act
+    reported_aggregator_destroy(handle, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 2, g_callbackCount);
+    ASSERT_ARE_EQUAL(int, 0, g_lastStatusCode);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x42, g_lastContext);
+}
+
+TEST_FUNCTION(reported_aggregator_destroy_completes_every_pending_batch)
+{
+    // arrange
+    REPORTED_AGGREGATOR_HANDLE handle = reported_aggregator_create(TEST_FLUSH_INTERVAL_MS);
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":null}", NULL, 0));
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":{\"b\":1}}", (void*)0x42, 0));
+
+    // act
+    reported_aggregator_destroy(handle, TEST_STATUS_FAILED);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 2, g_callbackCount);
+    ASSERT_ARE_EQUAL(int, TEST_STATUS_FAILED, g_lastStatusCode);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x42, g_lastContext);
+}
+
+TEST_FUNCTION(reported_aggregator_add_NULL_handle_fails)
+{
+    // act
+    int result = add_report(NULL, "{\"a\":1}", NULL, 0);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+TEST_FUNCTION(reported_aggregator_add_zero_size_fails)
+{
+    // arrange
+    REPORTED_AGGREGATOR_HANDLE handle = reported_aggregator_create(TEST_FLUSH_INTERVAL_MS);
+
+    // act
+    int result = reported_aggregator_add(handle, (const unsigned char*)"{}", 0, test_reported_state_callback, NULL, 0);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_TRUE(reported_aggregator_is_idle(handle));
+
+    // cleanup
+    reported_aggregator_destroy(handle, 0);
+}
+
+TEST_FUNCTION(reported_aggregator_add_invalid_json_fails)
+{
+    // arrange
+    REPORTED_AGGREGATOR_HANDLE handle = reported_aggregator_create(TEST_FLUSH_INTERVAL_MS);
+
+    // act
+    int result = add_report(handle, "{\"a\":", NULL, 0);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_TRUE(reported_aggregator_is_idle(handle));
+
+    // cleanup
+    reported_aggregator_destroy(handle, 0);
+    ASSERT_ARE_EQUAL(int, 0, g_callbackCount);
+}
+
+TEST_FUNCTION(reported_aggregator_add_not_an_object_fails)
+{
+    // arrange
+    REPORTED_AGGREGATOR_HANDLE handle = reported_aggregator_create(TEST_FLUSH_INTERVAL_MS);
+
+    // act
+    int result = add_report(handle, "[1,2]", NULL, 0);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_TRUE(reported_aggregator_is_idle(handle));
+
+    // cleanup
+    reported_aggregator_destroy(handle, 0);
+}
+
+TEST_FUNCTION(reported_aggregator_add_allocation_fails)
+{
+    // arrange
+    REPORTED_AGGREGATOR_HANDLE handle = reported_aggregator_create(TEST_FLUSH_INTERVAL_MS);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_ARG)).SetReturn(NULL);
+
+    // act
+    int result = add_report(handle, "{\"a\":1}", NULL, 0);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    reported_aggregator_destroy(handle, 0);
+}
+
+TEST_FUNCTION(reported_aggregator_flush_nothing_pending_is_idle)
+{
+    // arrange
+    REPORTED_AGGREGATOR_HANDLE handle = reported_aggregator_create(TEST_FLUSH_INTERVAL_MS);
+
+    // act
+    REPORTED_AGGREGATOR_FLUSH_RESULT result = flush(handle, 1000);
+
+    // assert
+    ASSERT_ARE_EQUAL(REPORTED_AGGREGATOR_FLUSH_RESULT, REPORTED_AGGREGATOR_FLUSH_IDLE, result);
+
+    // cleanup
+    reported_aggregator_destroy(handle, 0);
+}
+
+TEST_FUNCTION(reported_aggregator_flush_before_interval_is_idle)
+{
+    // arrange
+    REPORTED_AGGREGATOR_HANDLE handle = reported_aggregator_create(TEST_FLUSH_INTERVAL_MS);
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":1}", NULL, 1000));
+
+    // act
+    REPORTED_AGGREGATOR_FLUSH_RESULT result = flush(handle, 1000 + TEST_FLUSH_INTERVAL_MS - 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(REPORTED_AGGREGATOR_FLUSH_RESULT, REPORTED_AGGREGATOR_FLUSH_IDLE, result);
+    ASSERT_IS_FALSE(reported_aggregator_is_idle(handle));
+    ASSERT_ARE_EQUAL(int, 0, g_callbackCount);
+
+    // cleanup
+    reported_aggregator_destroy(handle, 0);
+}
+
+TEST_FUNCTION(reported_aggregator_flush_interval_starts_at_first_pending_report)
+{
+    // arrange
+    REPORTED_AGGREGATOR_HANDLE handle = reported_aggregator_create(TEST_FLUSH_INTERVAL_MS);
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":1}", NULL, 1000));
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"b\":1}", NULL, 1000 + TEST_FLUSH_INTERVAL_MS - 1));
+
+    // act
+    void* batchContext = flush_and_assert_patch(handle, 1000 + TEST_FLUSH_INTERVAL_MS, "{\"a\":1,\"b\":1}");
+
+    // cleanup
+    reported_aggregator_on_patch_complete(TEST_STATUS_OK, batchContext);
+    reported_aggregator_destroy(handle, 0);
+}
+
+TEST_FUNCTION(reported_aggregator_flush_last_writer_wins)
+{
+    // arrange
+    REPORTED_AGGREGATOR_HANDLE handle = reported_aggregator_create(TEST_FLUSH_INTERVAL_MS);
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":1,\"b\":{\"c\":1,\"d\":1},\"e\":\"x\"}", NULL, 0));
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":2,\"b\":{\"d\":2},\"e\":{\"f\":true}}", NULL, 0));
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":3,\"g\":null}", NULL, 0));
+
+    // act
+    void* batchContext = flush_and_assert_patch(handle, TEST_FLUSH_INTERVAL_MS, "{\"a\":3,\"b\":{\"c\":1,\"d\":2},\"e\":{\"f\":true},\"g\":null}");
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, g_callbackCount);
+    ASSERT_IS_FALSE(reported_aggregator_is_idle(handle));
+
+    // cleanup
+    reported_aggregator_on_patch_complete(TEST_STATUS_OK, batchContext);
+    reported_aggregator_destroy(handle, 0);
+}
+
+TEST_FUNCTION(reported_aggregator_on_patch_complete_invokes_every_callback)
+{
+    // arrange
+    REPORTED_AGGREGATOR_HANDLE handle = reported_aggregator_create(TEST_FLUSH_INTERVAL_MS);
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":1}", (void*)0x41, 0));
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":2}", (void*)0x42, 0));
+    ASSERT_ARE_EQUAL(int, 0, reported_aggregator_add(handle, (const unsigned char*)"{\"b\":1}", 7, NULL, NULL, 0));
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"c\":1}", (void*)0x43, 0));
+    void* batchContext = flush_and_assert_patch(handle, TEST_FLUSH_INTERVAL_MS, "{\"a\":2,\"b\":1,\"c\":1}");
+
+    // act
+    reported_aggregator_on_patch_complete(TEST_STATUS_OK, batchContext);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 3, g_callbackCount);
+    ASSERT_ARE_EQUAL(int, TEST_STATUS_OK, g_lastStatusCode);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x43, g_lastContext);
+    ASSERT_IS_TRUE(reported_aggregator_is_idle(handle));
+
+    // cleanup
+    reported_aggregator_destroy(handle, 0);
+}
+
+TEST_FUNCTION(reported_aggregator_flush_drops_acknowledged_values)
+{
+    // arrange
+    REPORTED_AGGREGATOR_HANDLE handle = reported_aggregator_create(TEST_FLUSH_INTERVAL_MS);
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":1,\"b\":{\"c\":1,\"d\":1},\"e\":[1,2]}", NULL, 0));
+    reported_aggregator_on_patch_complete(TEST_STATUS_OK, flush_and_assert_patch(handle, TEST_FLUSH_INTERVAL_MS, "{\"a\":1,\"b\":{\"c\":1,\"d\":1},\"e\":[1,2]}"));
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":1,\"b\":{\"c\":1,\"d\":2},\"e\":[1,2],\"f\":1}", NULL, TEST_FLUSH_INTERVAL_MS));
+
+    // act
+    void* batchContext = flush_and_assert_patch(handle, 2 * TEST_FLUSH_INTERVAL_MS, "{\"b\":{\"d\":2},\"f\":1}");
+
+    // cleanup
+    reported_aggregator_on_patch_complete(TEST_STATUS_OK, batchContext);
+    reported_aggregator_destroy(handle, 0);
+}
+
+TEST_FUNCTION(reported_aggregator_flush_with_nothing_changed_completes_callbacks)
+{
+    // arrange
+    REPORTED_AGGREGATOR_HANDLE handle = reported_aggregator_create(TEST_FLUSH_INTERVAL_MS);
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":1,\"b\":{\"c\":1}}", NULL, 0));
+    reported_aggregator_on_patch_complete(TEST_STATUS_OK, flush_and_assert_patch(handle, TEST_FLUSH_INTERVAL_MS, "{\"a\":1,\"b\":{\"c\":1}}"));
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":1}", NULL, TEST_FLUSH_INTERVAL_MS));
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"b\":{\"c\":1}}", (void*)0x42, TEST_FLUSH_INTERVAL_MS));
+    g_callbackCount = 0;
+
+    // act
+    REPORTED_AGGREGATOR_FLUSH_RESULT result = flush(handle, 2 * TEST_FLUSH_INTERVAL_MS);
+
+    // assert
+    ASSERT_ARE_EQUAL(REPORTED_AGGREGATOR_FLUSH_RESULT, REPORTED_AGGREGATOR_FLUSH_IDLE, result);
+    ASSERT_ARE_EQUAL(int, 2, g_callbackCount);
+    ASSERT_ARE_EQUAL(int, 204, g_lastStatusCode);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x42, g_lastContext);
+    ASSERT_IS_TRUE(reported_aggregator_is_idle(handle));
+
+    // cleanup
+    reported_aggregator_destroy(handle, 0);
+}
+
+TEST_FUNCTION(reported_aggregator_flush_drops_repeated_deletes)
+{
+    // arrange
+    REPORTED_AGGREGATOR_HANDLE handle = reported_aggregator_create(TEST_FLUSH_INTERVAL_MS);
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":1,\"b\":1}", NULL, 0));
+    reported_aggregator_on_patch_complete(TEST_STATUS_OK, flush_and_assert_patch(handle, TEST_FLUSH_INTERVAL_MS, "{\"a\":1,\"b\":1}"));
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":null}", NULL, TEST_FLUSH_INTERVAL_MS));
+    reported_aggregator_on_patch_complete(TEST_STATUS_OK, flush_and_assert_patch(handle, 2 * TEST_FLUSH_INTERVAL_MS, "{\"a\":null}"));
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":null,\"c\":null}", NULL, 2 * TEST_FLUSH_INTERVAL_MS));
+
+    // act
+    // "c" was never acknowledged, so whether it exists in the twin is unknown and the delete is kept.
+    void* batchContext = flush_and_assert_patch(handle, 3 * TEST_FLUSH_INTERVAL_MS, "{\"c\":null}");
+
+    // cleanup
+    reported_aggregator_on_patch_complete(TEST_STATUS_OK, batchContext);
+    reported_aggregator_destroy(handle, 0);
+}
+
+TEST_FUNCTION(reported_aggregator_flush_sends_object_after_pending_delete_separately)
+{
+    // arrange
+    REPORTED_AGGREGATOR_HANDLE handle = reported_aggregator_create(TEST_FLUSH_INTERVAL_MS);
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":null,\"b\":1}", (void*)0x41, 0));
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":{\"c\":1}}", (void*)0x42, 0));
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"b\":2}", (void*)0x43, 0));
+
+    // act
+    void* firstBatch = flush_and_assert_patch(handle, TEST_FLUSH_INTERVAL_MS, "{\"a\":null,\"b\":1}");
+    REPORTED_AGGREGATOR_FLUSH_RESULT result = flush(handle, TEST_FLUSH_INTERVAL_MS);
+    reported_aggregator_on_patch_complete(TEST_STATUS_OK, firstBatch);
+
+    // assert
+    ASSERT_ARE_EQUAL(REPORTED_AGGREGATOR_FLUSH_RESULT, REPORTED_AGGREGATOR_FLUSH_IDLE, result);
+    ASSERT_ARE_EQUAL(int, 1, g_callbackCount);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x41, g_lastContext);
+    void* secondBatch = flush_and_assert_patch(handle, TEST_FLUSH_INTERVAL_MS, "{\"a\":{\"c\":1},\"b\":2}");
+    reported_aggregator_on_patch_complete(TEST_STATUS_OK, secondBatch);
+    ASSERT_ARE_EQUAL(int, 3, g_callbackCount);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x43, g_lastContext);
+    ASSERT_IS_TRUE(reported_aggregator_is_idle(handle));
+
+    // cleanup
+    reported_aggregator_destroy(handle, 0);
+}
+
+TEST_FUNCTION(reported_aggregator_flush_sends_object_after_nested_pending_delete_separately)
+{
+    // arrange
+    REPORTED_AGGREGATOR_HANDLE handle = reported_aggregator_create(TEST_FLUSH_INTERVAL_MS);
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":{\"b\":null,\"c\":1}}", NULL, 0));
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":{\"b\":{\"d\":1}}}", NULL, 0));
+
+    // act
+    void* firstBatch = flush_and_assert_patch(handle, TEST_FLUSH_INTERVAL_MS, "{\"a\":{\"b\":null,\"c\":1}}");
+    reported_aggregator_on_patch_complete(TEST_STATUS_OK, firstBatch);
+    void* secondBatch = flush_and_assert_patch(handle, TEST_FLUSH_INTERVAL_MS, "{\"a\":{\"b\":{\"d\":1}}}");
+
+    // cleanup
+    reported_aggregator_on_patch_complete(TEST_STATUS_OK, secondBatch);
+    reported_aggregator_destroy(handle, 0);
+}
+
+TEST_FUNCTION(reported_aggregator_failed_patch_is_not_acknowledged)
+{
+    // arrange
+    REPORTED_AGGREGATOR_HANDLE handle = reported_aggregator_create(TEST_FLUSH_INTERVAL_MS);
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":1}", NULL, 0));
+    reported_aggregator_on_patch_complete(TEST_STATUS_FAILED, flush_and_assert_patch(handle, TEST_FLUSH_INTERVAL_MS, "{\"a\":1}"));
+    ASSERT_ARE_EQUAL(int, TEST_STATUS_FAILED, g_lastStatusCode);
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":1}", NULL, TEST_FLUSH_INTERVAL_MS));
+
+    // act
+    void* batchContext = flush_and_assert_patch(handle, 2 * TEST_FLUSH_INTERVAL_MS, "{\"a\":1}");
+
+    // cleanup
+    reported_aggregator_on_patch_complete(TEST_STATUS_OK, batchContext);
+    reported_aggregator_destroy(handle, 0);
+}
+
+TEST_FUNCTION(reported_aggregator_flush_waits_for_patch_in_flight)
+{
+    // arrange
+    REPORTED_AGGREGATOR_HANDLE handle = reported_aggregator_create(TEST_FLUSH_INTERVAL_MS);
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":1}", NULL, 0));
+    void* firstBatch = flush_and_assert_patch(handle, TEST_FLUSH_INTERVAL_MS, "{\"a\":1}");
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":2}", NULL, TEST_FLUSH_INTERVAL_MS));
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":1,\"b\":1}", NULL, TEST_FLUSH_INTERVAL_MS));
+
+    // act
+    REPORTED_AGGREGATOR_FLUSH_RESULT result = flush(handle, 10 * TEST_FLUSH_INTERVAL_MS);
+
+    // assert
+    ASSERT_ARE_EQUAL(REPORTED_AGGREGATOR_FLUSH_RESULT, REPORTED_AGGREGATOR_FLUSH_IDLE, result);
+    reported_aggregator_on_patch_complete(TEST_STATUS_OK, firstBatch);
+    ASSERT_ARE_EQUAL(int, 1, g_callbackCount);
+    void* secondBatch = flush_and_assert_patch(handle, 10 * TEST_FLUSH_INTERVAL_MS, "{\"b\":1}");
+
+    // cleanup
+    reported_aggregator_on_patch_complete(TEST_STATUS_OK, secondBatch);
+    reported_aggregator_destroy(handle, 0);
+}
+
+TEST_FUNCTION(reported_aggregator_on_patch_complete_after_destroy_invokes_callbacks)
+{
+    // arrange
+    REPORTED_AGGREGATOR_HANDLE handle = reported_aggregator_create(TEST_FLUSH_INTERVAL_MS);
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":1}", (void*)0x42, 0));
+    void* batchContext = flush_and_assert_patch(handle, TEST_FLUSH_INTERVAL_MS, "{\"a\":1}");
+    reported_aggregator_destroy(handle, 0);
+    ASSERT_ARE_EQUAL(int, 0, g_callbackCount);
+
+    // act
+    reported_aggregator_on_patch_complete(TEST_STATUS_OK, batchContext);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 1, g_callbackCount);
+    ASSERT_ARE_EQUAL(int, TEST_STATUS_OK, g_lastStatusCode);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x42, g_lastContext);
+}
+
+TEST_FUNCTION(reported_aggregator_set_flush_interval_zero_flushes_immediately)
+{
+    // arrange
+    REPORTED_AGGREGATOR_HANDLE handle = reported_aggregator_create(TEST_FLUSH_INTERVAL_MS);
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":1}", NULL, 1000));
+
+    // act
+    int result = reported_aggregator_set_flush_interval(handle, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    void* batchContext = flush_and_assert_patch(handle, 1000, "{\"a\":1}");
+
+    // cleanup
+    reported_aggregator_on_patch_complete(TEST_STATUS_OK, batchContext);
+    reported_aggregator_destroy(handle, 0);
+}
+
+TEST_FUNCTION(reported_aggregator_set_flush_interval_NULL_handle_fails)
+{
+    // act
+    int result = reported_aggregator_set_flush_interval(NULL, 0);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+TEST_FUNCTION(reported_aggregator_flush_NULL_arguments_fail)
+{
+    // arrange
+    const unsigned char* patch;
+    size_t size;
+    void* batchContext;
+    REPORTED_AGGREGATOR_HANDLE handle = reported_aggregator_create(TEST_FLUSH_INTERVAL_MS);
+
+    // act / assert
+    ASSERT_ARE_EQUAL(REPORTED_AGGREGATOR_FLUSH_RESULT, REPORTED_AGGREGATOR_FLUSH_ERROR, reported_aggregator_flush(NULL, 0, &patch, &size, &batchContext));
+    ASSERT_ARE_EQUAL(REPORTED_AGGREGATOR_FLUSH_RESULT, REPORTED_AGGREGATOR_FLUSH_ERROR, reported_aggregator_flush(handle, 0, NULL, &size, &batchContext));
+    ASSERT_ARE_EQUAL(REPORTED_AGGREGATOR_FLUSH_RESULT, REPORTED_AGGREGATOR_FLUSH_ERROR, reported_aggregator_flush(handle, 0, &patch, NULL, &batchContext));
+    ASSERT_ARE_EQUAL(REPORTED_AGGREGATOR_FLUSH_RESULT, REPORTED_AGGREGATOR_FLUSH_ERROR, reported_aggregator_flush(handle, 0, &patch, &size, NULL));
+
+    // cleanup
+    reported_aggregator_destroy(handle, 0);
+}
+
+TEST_FUNCTION(reported_aggregator_get_flush_timeout_nothing_pending_returns_false)
+{
+    // arrange
+    tickcounter_ms_t timeout;
+    REPORTED_AGGREGATOR_HANDLE handle = reported_aggregator_create(TEST_FLUSH_INTERVAL_MS);
+
+    // act / assert
+    ASSERT_IS_FALSE(reported_aggregator_get_flush_timeout(handle, 1000, &timeout));
+
+    // cleanup
+    reported_aggregator_destroy(handle, 0);
+}
+
+TEST_FUNCTION(reported_aggregator_get_flush_timeout_counts_from_first_pending_report)
+{
+    // arrange
+    tickcounter_ms_t timeout;
+    REPORTED_AGGREGATOR_HANDLE handle = reported_aggregator_create(TEST_FLUSH_INTERVAL_MS);
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":1}", NULL, 1000));
+
+    // act / assert
+    ASSERT_IS_TRUE(reported_aggregator_get_flush_timeout(handle, 1001, &timeout));
+    ASSERT_IS_TRUE(timeout == TEST_FLUSH_INTERVAL_MS - 1);
+    ASSERT_IS_TRUE(reported_aggregator_get_flush_timeout(handle, 1000 + 2 * TEST_FLUSH_INTERVAL_MS, &timeout));
+    ASSERT_IS_TRUE(timeout == 0);
+
+    // cleanup
+    reported_aggregator_destroy(handle, 0);
+}
+
+TEST_FUNCTION(reported_aggregator_get_flush_timeout_patch_in_flight_returns_false)
+{
+    // arrange
+    tickcounter_ms_t timeout;
+    REPORTED_AGGREGATOR_HANDLE handle = reported_aggregator_create(TEST_FLUSH_INTERVAL_MS);
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":1}", NULL, 0));
+    void* batchContext = flush_and_assert_patch(handle, TEST_FLUSH_INTERVAL_MS, "{\"a\":1}");
+    ASSERT_ARE_EQUAL(int, 0, add_report(handle, "{\"a\":2}", NULL, TEST_FLUSH_INTERVAL_MS));
+
+    // act / assert
+    ASSERT_IS_FALSE(reported_aggregator_get_flush_timeout(handle, 10 * TEST_FLUSH_INTERVAL_MS, &timeout));
+
+    // cleanup
+    reported_aggregator_on_patch_complete(TEST_STATUS_OK, batchContext);
+    reported_aggregator_destroy(handle, 0);
+}
+
+TEST_FUNCTION(reported_aggregator_get_flush_timeout_NULL_arguments_return_false)
+{
+    // arrange
+    tickcounter_ms_t timeout;
+    REPORTED_AGGREGATOR_HANDLE handle = reported_aggregator_create(TEST_FLUSH_INTERVAL_MS);
+
+    // act / assert
+    ASSERT_IS_FALSE(reported_aggregator_get_flush_timeout(NULL, 0, &timeout));
+    ASSERT_IS_FALSE(reported_aggregator_get_flush_timeout(handle, 0, NULL));
+
+    // cleanup
+    reported_aggregator_destroy(handle, 0);
+}
+
+END_TEST_SUITE(iothub_client_reported_aggregator_ut)
@@ -0,0 +1,160 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+#include "testrunnerswitcher.h"
+#include "azure_macro_utils/macro_utils.h"
+#include "umock_c/umock_c.h"
+
+#include "iothub_client_tracing.h"
+#include "internal/iothub_client_tracing_private.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+MU_DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", MU_ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+TEST_DEFINE_ENUM_TYPE(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_RESULT_VALUES);
+TEST_DEFINE_ENUM_TYPE(IOTHUB_CLIENT_TRACE_POINT, IOTHUB_CLIENT_TRACE_POINT_VALUES);
+
+#define TEST_MAX_TRACED 8
+
+static void* TEST_CONTEXT = (void*)0x4247;
+
+static size_t g_traceCount;
+static IOTHUB_CLIENT_TRACE_POINT g_tracedPoints[TEST_MAX_TRACED];
+static uint64_t g_tracedMessageIds[TEST_MAX_TRACED];
+static uint64_t g_tracedTimestamps[TEST_MAX_TRACED];
+static void* g_traceContext;
+
+static void test_trace_callback(IOTHUB_CLIENT_TRACE_POINT point, uint64_t messageId, uint64_t timestampNs, void* userContext)
+{
+    ASSERT_IS_TRUE(g_traceCount < TEST_MAX_TRACED);
+    g_tracedPoints[g_traceCount] = point;
+    g_tracedMessageIds[g_traceCount] = messageId;
+    g_tracedTimestamps[g_traceCount] = timestampNs;
+    g_traceContext = userContext;
+    g_traceCount++;
+}
+
+BEGIN_TEST_SUITE(iothub_client_tracing_ut)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+    umock_c_init(on_umock_c_error);
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+    umock_c_reset_all_calls();
+    g_traceCount = 0;
+    g_traceContext = NULL;
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    (void)IoTHubClient_SetTraceCallback(NULL, NULL);
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+TEST_FUNCTION(iothub_client_trace_begin_without_callback_does_not_trace)
+{
+    // act
+    uint64_t message_id = iothub_client_trace_begin();
+
+    // assert
+    ASSERT_ARE_EQUAL(uint64_t, 0, message_id);
+    ASSERT_ARE_EQUAL(size_t, 0, g_traceCount);
+}
+
+TEST_FUNCTION(iothub_client_trace_begin_reports_enqueued_with_a_new_id)
+{
+    // arrange
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, IoTHubClient_SetTraceCallback(test_trace_callback, TEST_CONTEXT));
+
+    // act
+    uint64_t first_id = iothub_client_trace_begin();
+    uint64_t second_id = iothub_client_trace_begin();
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(uint64_t, 0, first_id);
+    ASSERT_ARE_NOT_EQUAL(uint64_t, first_id, second_id);
+    ASSERT_ARE_EQUAL(size_t, 2, g_traceCount);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_TRACE_POINT, IOTHUB_CLIENT_TRACE_ENQUEUED, g_tracedPoints[0]);
+    ASSERT_ARE_EQUAL(uint64_t, first_id, g_tracedMessageIds[0]);
+    ASSERT_ARE_EQUAL(uint64_t, second_id, g_tracedMessageIds[1]);
+    ASSERT_IS_TRUE(g_tracedTimestamps[1] >= g_tracedTimestamps[0]);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_CONTEXT, g_traceContext);
+}
+
+TEST_FUNCTION(iothub_client_trace_reports_the_point)
+{
+    // arrange
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, IoTHubClient_SetTraceCallback(test_trace_callback, TEST_CONTEXT));
+    uint64_t message_id = iothub_client_trace_begin();
+
+    // act
+    iothub_client_trace(IOTHUB_CLIENT_TRACE_WRITTEN, message_id);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, g_traceCount);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_TRACE_POINT, IOTHUB_CLIENT_TRACE_WRITTEN, g_tracedPoints[1]);
+    ASSERT_ARE_EQUAL(uint64_t, message_id, g_tracedMessageIds[1]);
+    ASSERT_IS_TRUE(g_tracedTimestamps[1] >= g_tracedTimestamps[0]);
+}
+
+TEST_FUNCTION(iothub_client_trace_message_not_traced_does_nothing)
+{
+    // arrange
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, IoTHubClient_SetTraceCallback(test_trace_callback, TEST_CONTEXT));
+
+    // act
+    iothub_client_trace(IOTHUB_CLIENT_TRACE_ACKNOWLEDGED, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, g_traceCount);
+}
+
+TEST_FUNCTION(IoTHubClient_SetTraceCallback_NULL_stops_tracing)
+{
+    // arrange
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, IoTHubClient_SetTraceCallback(test_trace_callback, TEST_CONTEXT));
+    uint64_t message_id = iothub_client_trace_begin();
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClient_SetTraceCallback(NULL, NULL);
+    iothub_client_trace(IOTHUB_CLIENT_TRACE_ACKNOWLEDGED, message_id);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(size_t, 1, g_traceCount);
+}
+
+END_TEST_SUITE(iothub_client_tracing_ut)
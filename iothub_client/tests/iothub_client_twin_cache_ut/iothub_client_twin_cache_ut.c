@@ -0,0 +1,482 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#endif
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void* my_gballoc_calloc(size_t nmemb, size_t size)
+{
+    return calloc(nmemb, size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#include "testrunnerswitcher.h"
+#include "azure_macro_utils/macro_utils.h"
+#include "umock_c/umock_c.h"
+#include "umock_c/umock_c_negative_tests.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "umock_c/umock_c_prod.h"
+#undef ENABLE_MOCKS
+
+#include "internal/iothub_client_twin_cache.h"
+#include "parson.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+MU_DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", MU_ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+TEST_DEFINE_ENUM_TYPE(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_RESULT_VALUES);
+TEST_DEFINE_ENUM_TYPE(TWIN_CACHE_UPDATE_RESULT, TWIN_CACHE_UPDATE_RESULT_VALUES);
+
+#define TEST_COMPONENT_NAME "thermostat"
+
+static const char TEST_COMPLETE_TWIN[] =
+    "{\"desired\":{\"targetTemp\":20,\"" TEST_COMPONENT_NAME "\":{\"__t\":\"c\",\"mode\":\"heat\"},\"$version\":3},"
+    "\"reported\":{\"firmware\":\"1.0\",\"$version\":7}}";
+static const char TEST_PATCH_VERSION_4[] = "{\"targetTemp\":22,\"newProperty\":{\"a\":1},\"$version\":4}";
+static const char TEST_PATCH_VERSION_5_REMOVE[] = "{\"newProperty\":null,\"" TEST_COMPONENT_NAME "\":{\"__t\":\"c\",\"mode\":\"cool\"},\"$version\":5}";
+static const char TEST_PATCH_VERSION_3[] = "{\"targetTemp\":99,\"$version\":3}";
+static const char TEST_PATCH_VERSION_6[] = "{\"targetTemp\":30,\"$version\":6}";
+static const char TEST_REPORTED_PATCH[] = "{\"firmware\":\"2.0\",\"serial\":\"abc\"}";
+
+static void register_global_mocks(void)
+{
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_calloc, my_gballoc_calloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_calloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+}
+
+static TWIN_CACHE_UPDATE_RESULT update_cache(TWIN_CACHE_HANDLE handle, DEVICE_TWIN_UPDATE_STATE updateState, const char* payload)
+{
+    return twin_cache_update(handle, updateState, (const unsigned char*)payload, strlen(payload));
+}
+
+static TWIN_CACHE_HANDLE create_populated_cache(void)
+{
+    TWIN_CACHE_HANDLE handle = twin_cache_create();
+    ASSERT_IS_NOT_NULL(handle);
+    ASSERT_ARE_EQUAL(TWIN_CACHE_UPDATE_RESULT, TWIN_CACHE_UPDATE_OK, update_cache(handle, DEVICE_TWIN_UPDATE_COMPLETE, TEST_COMPLETE_TWIN));
+    return handle;
+}
+
+static void assert_cached_property(TWIN_CACHE_HANDLE handle, IOTHUB_CLIENT_PROPERTY_TYPE propertyType, const char* componentName, const char* propertyName, const char* expectedValue)
+{
+    IOTHUB_CLIENT_PROPERTY_PARSED property;
+    bool propertySpecified = false;
+    IOTHUB_CLIENT_RESULT result;
+
+    memset(&property, 0, sizeof(property));
+    property.structVersion = IOTHUB_CLIENT_PROPERTY_PARSED_STRUCT_VERSION_1;
+
+    result = twin_cache_get_property(handle, propertyType, componentName, propertyName, &property, &propertySpecified);
+
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    if (expectedValue == NULL)
+    {
+        ASSERT_IS_FALSE(propertySpecified);
+    }
+    else
+    {
+        ASSERT_IS_TRUE(propertySpecified);
+        ASSERT_ARE_EQUAL(int, propertyType, property.propertyType);
+        ASSERT_ARE_EQUAL(char_ptr, propertyName, property.name);
+        ASSERT_ARE_EQUAL(int, IOTHUB_CLIENT_PROPERTY_VALUE_STRING, property.valueType);
+        ASSERT_ARE_EQUAL(char_ptr, expectedValue, property.value.str);
+        ASSERT_ARE_EQUAL(size_t, strlen(expectedValue), property.valueLength);
+        json_free_serialized_string((char*)property.value.str);
+    }
+}
+
+static void assert_cached_version(TWIN_CACHE_HANDLE handle, int expectedVersion)
+{
+    int version = -1;
+    ASSERT_ARE_EQUAL(int, 0, twin_cache_get_version(handle, &version));
+    ASSERT_ARE_EQUAL(int, expectedVersion, version);
+}
+
+BEGIN_TEST_SUITE(iothub_client_twin_cache_ut)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+    umock_c_init(on_umock_c_error);
+    register_global_mocks();
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+TEST_FUNCTION(twin_cache_create_succeeds)
+{
+    // arrange
+    int version;
+
+    // act
+    TWIN_CACHE_HANDLE handle = twin_cache_create();
+
+    // assert
+    ASSERT_IS_NOT_NULL(handle);
+    ASSERT_ARE_NOT_EQUAL(int, 0, twin_cache_get_version(handle, &version));
+
+    // cleanup
+    twin_cache_destroy(handle);
+}
+
+TEST_FUNCTION(twin_cache_create_allocation_fails)
+{
+    // arrange
+    STRICT_EXPECTED_CALL(gballoc_calloc(IGNORED_ARG, IGNORED_ARG)).SetReturn(NULL);
+
+    // act
+    TWIN_CACHE_HANDLE handle = twin_cache_create();
+
+    // assert
+    ASSERT_IS_NULL(handle);
+}
+
+TEST_FUNCTION(twin_cache_destroy_NULL_handle_does_nothing)
+{
+    // act
+    twin_cache_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(twin_cache_update_NULL_handle_fails)
+{
+    // act
+    TWIN_CACHE_UPDATE_RESULT result = update_cache(NULL, DEVICE_TWIN_UPDATE_COMPLETE, TEST_COMPLETE_TWIN);
+
+    // assert
+    ASSERT_ARE_EQUAL(TWIN_CACHE_UPDATE_RESULT, TWIN_CACHE_UPDATE_ERROR, result);
+}
+
+TEST_FUNCTION(twin_cache_update_NULL_payload_fails)
+{
+    // arrange
+    TWIN_CACHE_HANDLE handle = twin_cache_create();
+
+    // act
+    TWIN_CACHE_UPDATE_RESULT result = twin_cache_update(handle, DEVICE_TWIN_UPDATE_COMPLETE, NULL, 10);
+
+    // assert
+    ASSERT_ARE_EQUAL(TWIN_CACHE_UPDATE_RESULT, TWIN_CACHE_UPDATE_ERROR, result);
+
+    // cleanup
+    twin_cache_destroy(handle);
+}
+
+TEST_FUNCTION(twin_cache_update_invalid_json_fails)
+{
+    // arrange
+    TWIN_CACHE_HANDLE handle = twin_cache_create();
+
+    // act
+    TWIN_CACHE_UPDATE_RESULT result = update_cache(handle, DEVICE_TWIN_UPDATE_COMPLETE, "{\"desired\":");
+
+    // assert
+    ASSERT_ARE_EQUAL(TWIN_CACHE_UPDATE_RESULT, TWIN_CACHE_UPDATE_ERROR, result);
+
+    // cleanup
+    twin_cache_destroy(handle);
+}
+
+TEST_FUNCTION(twin_cache_update_complete_twin_indexes_properties)
+{
+    // arrange
+    TWIN_CACHE_HANDLE handle = twin_cache_create();
+
+    // act
+    TWIN_CACHE_UPDATE_RESULT result = update_cache(handle, DEVICE_TWIN_UPDATE_COMPLETE, TEST_COMPLETE_TWIN);
+
+    // assert
+    ASSERT_ARE_EQUAL(TWIN_CACHE_UPDATE_RESULT, TWIN_CACHE_UPDATE_OK, result);
+    assert_cached_version(handle, 3);
+    assert_cached_property(handle, IOTHUB_CLIENT_PROPERTY_TYPE_WRITABLE, NULL, "targetTemp", "20");
+    assert_cached_property(handle, IOTHUB_CLIENT_PROPERTY_TYPE_WRITABLE, TEST_COMPONENT_NAME, "mode", "\"heat\"");
+    assert_cached_property(handle, IOTHUB_CLIENT_PROPERTY_TYPE_REPORTED_FROM_CLIENT, NULL, "firmware", "\"1.0\"");
+    assert_cached_property(handle, IOTHUB_CLIENT_PROPERTY_TYPE_WRITABLE, NULL, "$version", NULL);
+    assert_cached_property(handle, IOTHUB_CLIENT_PROPERTY_TYPE_WRITABLE, TEST_COMPONENT_NAME, "__t", NULL);
+    assert_cached_property(handle, IOTHUB_CLIENT_PROPERTY_TYPE_WRITABLE, NULL, TEST_COMPONENT_NAME, NULL);
+
+    // cleanup
+    twin_cache_destroy(handle);
+}
+
+TEST_FUNCTION(twin_cache_update_complete_twin_replaces_document)
+{
+    // arrange
+    TWIN_CACHE_HANDLE handle = create_populated_cache();
+
+    // act
+    TWIN_CACHE_UPDATE_RESULT result = update_cache(handle, DEVICE_TWIN_UPDATE_COMPLETE, "{\"desired\":{\"other\":true,\"$version\":10},\"reported\":{\"$version\":1}}");
+
+    // assert
+    ASSERT_ARE_EQUAL(TWIN_CACHE_UPDATE_RESULT, TWIN_CACHE_UPDATE_OK, result);
+    assert_cached_version(handle, 10);
+    assert_cached_property(handle, IOTHUB_CLIENT_PROPERTY_TYPE_WRITABLE, NULL, "other", "true");
+    assert_cached_property(handle, IOTHUB_CLIENT_PROPERTY_TYPE_WRITABLE, NULL, "targetTemp", NULL);
+    assert_cached_property(handle, IOTHUB_CLIENT_PROPERTY_TYPE_REPORTED_FROM_CLIENT, NULL, "firmware", NULL);
+
+    // cleanup
+    twin_cache_destroy(handle);
+}
+
+TEST_FUNCTION(twin_cache_update_patch_before_complete_twin_reports_gap)
+{
+    // arrange
+    TWIN_CACHE_HANDLE handle = twin_cache_create();
+
+    // act
+    TWIN_CACHE_UPDATE_RESULT result = update_cache(handle, DEVICE_TWIN_UPDATE_PARTIAL, TEST_PATCH_VERSION_4);
+
+    // assert
+    ASSERT_ARE_EQUAL(TWIN_CACHE_UPDATE_RESULT, TWIN_CACHE_UPDATE_VERSION_GAP, result);
+
+    // cleanup
+    twin_cache_destroy(handle);
+}
+
+TEST_FUNCTION(twin_cache_update_patches_in_order_are_merged)
+{
+    // arrange
+    TWIN_CACHE_HANDLE handle = create_populated_cache();
+
+    // act
+    TWIN_CACHE_UPDATE_RESULT result1 = update_cache(handle, DEVICE_TWIN_UPDATE_PARTIAL, TEST_PATCH_VERSION_4);
+    TWIN_CACHE_UPDATE_RESULT result2 = update_cache(handle, DEVICE_TWIN_UPDATE_PARTIAL, TEST_PATCH_VERSION_5_REMOVE);
+
+    // assert
+    ASSERT_ARE_EQUAL(TWIN_CACHE_UPDATE_RESULT, TWIN_CACHE_UPDATE_OK, result1);
+    ASSERT_ARE_EQUAL(TWIN_CACHE_UPDATE_RESULT, TWIN_CACHE_UPDATE_OK, result2);
+    assert_cached_version(handle, 5);
+    assert_cached_property(handle, IOTHUB_CLIENT_PROPERTY_TYPE_WRITABLE, NULL, "targetTemp", "22");
+    assert_cached_property(handle, IOTHUB_CLIENT_PROPERTY_TYPE_WRITABLE, NULL, "newProperty", NULL);
+    assert_cached_property(handle, IOTHUB_CLIENT_PROPERTY_TYPE_WRITABLE, TEST_COMPONENT_NAME, "mode", "\"cool\"");
+    assert_cached_property(handle, IOTHUB_CLIENT_PROPERTY_TYPE_REPORTED_FROM_CLIENT, NULL, "firmware", "\"1.0\"");
+
+    // cleanup
+    twin_cache_destroy(handle);
+}
+
+TEST_FUNCTION(twin_cache_update_nested_patch_is_merged)
+{
+    // arrange
+    TWIN_CACHE_HANDLE handle = create_populated_cache();
+    ASSERT_ARE_EQUAL(TWIN_CACHE_UPDATE_RESULT, TWIN_CACHE_UPDATE_OK, update_cache(handle, DEVICE_TWIN_UPDATE_PARTIAL, TEST_PATCH_VERSION_4));
+
+    // act
+    TWIN_CACHE_UPDATE_RESULT result = update_cache(handle, DEVICE_TWIN_UPDATE_PARTIAL, "{\"newProperty\":{\"b\":2},\"$version\":5}");
+
+    // assert
+    ASSERT_ARE_EQUAL(TWIN_CACHE_UPDATE_RESULT, TWIN_CACHE_UPDATE_OK, result);
+    assert_cached_property(handle, IOTHUB_CLIENT_PROPERTY_TYPE_WRITABLE, NULL, "newProperty", "{\"a\":1,\"b\":2}");
+
+    // cleanup
+    twin_cache_destroy(handle);
+}
+
+TEST_FUNCTION(twin_cache_update_stale_patch_is_ignored)
+{
+    // arrange
+    TWIN_CACHE_HANDLE handle = create_populated_cache();
+
+    // act
+    TWIN_CACHE_UPDATE_RESULT result = update_cache(handle, DEVICE_TWIN_UPDATE_PARTIAL, TEST_PATCH_VERSION_3);
+
+    // assert
+    ASSERT_ARE_EQUAL(TWIN_CACHE_UPDATE_RESULT, TWIN_CACHE_UPDATE_OK, result);
+    assert_cached_version(handle, 3);
+    assert_cached_property(handle, IOTHUB_CLIENT_PROPERTY_TYPE_WRITABLE, NULL, "targetTemp", "20");
+
+    // cleanup
+    twin_cache_destroy(handle);
+}
+
+TEST_FUNCTION(twin_cache_update_version_gap_is_reported)
+{
+    // arrange
+    TWIN_CACHE_HANDLE handle = create_populated_cache();
+
+    // act
+    TWIN_CACHE_UPDATE_RESULT result = update_cache(handle, DEVICE_TWIN_UPDATE_PARTIAL, TEST_PATCH_VERSION_6);
+
+    // assert
+    ASSERT_ARE_EQUAL(TWIN_CACHE_UPDATE_RESULT, TWIN_CACHE_UPDATE_VERSION_GAP, result);
+    assert_cached_property(handle, IOTHUB_CLIENT_PROPERTY_TYPE_WRITABLE, NULL, "targetTemp", "20");
+
+    // cleanup
+    twin_cache_destroy(handle);
+}
+
+TEST_FUNCTION(twin_cache_update_many_properties_grows_index)
+{
+    // arrange
+    char payload[4096];
+    size_t offset = 0;
+    int i;
+    TWIN_CACHE_HANDLE handle = twin_cache_create();
+
+    offset += snprintf(payload + offset, sizeof(payload) - offset, "{\"desired\":{");
+    for (i = 0; i < 100; i++)
+    {
+        offset += snprintf(payload + offset, sizeof(payload) - offset, "\"p%d\":%d,", i, i);
+    }
+    (void)snprintf(payload + offset, sizeof(payload) - offset, "\"$version\":1},\"reported\":{}}");
+
+    // act
+    TWIN_CACHE_UPDATE_RESULT result = update_cache(handle, DEVICE_TWIN_UPDATE_COMPLETE, payload);
+
+    // assert
+    ASSERT_ARE_EQUAL(TWIN_CACHE_UPDATE_RESULT, TWIN_CACHE_UPDATE_OK, result);
+    assert_cached_property(handle, IOTHUB_CLIENT_PROPERTY_TYPE_WRITABLE, NULL, "p0", "0");
+    assert_cached_property(handle, IOTHUB_CLIENT_PROPERTY_TYPE_WRITABLE, NULL, "p57", "57");
+    assert_cached_property(handle, IOTHUB_CLIENT_PROPERTY_TYPE_WRITABLE, NULL, "p99", "99");
+
+    // cleanup
+    twin_cache_destroy(handle);
+}
+
+TEST_FUNCTION(twin_cache_apply_reported_merges_into_reported_section)
+{
+    // arrange
+    TWIN_CACHE_HANDLE handle = create_populated_cache();
+
+    // act
+    int result = twin_cache_apply_reported(handle, (const unsigned char*)TEST_REPORTED_PATCH, strlen(TEST_REPORTED_PATCH));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    assert_cached_property(handle, IOTHUB_CLIENT_PROPERTY_TYPE_REPORTED_FROM_CLIENT, NULL, "firmware", "\"2.0\"");
+    assert_cached_property(handle, IOTHUB_CLIENT_PROPERTY_TYPE_REPORTED_FROM_CLIENT, NULL, "serial", "\"abc\"");
+    assert_cached_property(handle, IOTHUB_CLIENT_PROPERTY_TYPE_WRITABLE, NULL, "serial", NULL);
+    assert_cached_version(handle, 3);
+
+    // cleanup
+    twin_cache_destroy(handle);
+}
+
+TEST_FUNCTION(twin_cache_apply_reported_before_complete_twin_succeeds)
+{
+    // arrange
+    TWIN_CACHE_HANDLE handle = twin_cache_create();
+
+    // act
+    int result = twin_cache_apply_reported(handle, (const unsigned char*)TEST_REPORTED_PATCH, strlen(TEST_REPORTED_PATCH));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    assert_cached_property(handle, IOTHUB_CLIENT_PROPERTY_TYPE_REPORTED_FROM_CLIENT, NULL, "firmware", NULL);
+
+    // cleanup
+    twin_cache_destroy(handle);
+}
+
+TEST_FUNCTION(twin_cache_apply_reported_NULL_handle_fails)
+{
+    // act
+    int result = twin_cache_apply_reported(NULL, (const unsigned char*)TEST_REPORTED_PATCH, strlen(TEST_REPORTED_PATCH));
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+TEST_FUNCTION(twin_cache_get_version_NULL_version_fails)
+{
+    // arrange
+    TWIN_CACHE_HANDLE handle = create_populated_cache();
+
+    // act
+    int result = twin_cache_get_version(handle, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    twin_cache_destroy(handle);
+}
+
+TEST_FUNCTION(twin_cache_get_property_NULL_name_fails)
+{
+    // arrange
+    IOTHUB_CLIENT_PROPERTY_PARSED property;
+    bool propertySpecified;
+    TWIN_CACHE_HANDLE handle = create_populated_cache();
+    property.structVersion = IOTHUB_CLIENT_PROPERTY_PARSED_STRUCT_VERSION_1;
+
+    // act
+    IOTHUB_CLIENT_RESULT result = twin_cache_get_property(handle, IOTHUB_CLIENT_PROPERTY_TYPE_WRITABLE, NULL, NULL, &property, &propertySpecified);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+
+    // cleanup
+    twin_cache_destroy(handle);
+}
+
+TEST_FUNCTION(twin_cache_get_property_wrong_struct_version_fails)
+{
+    // arrange
+    IOTHUB_CLIENT_PROPERTY_PARSED property;
+    bool propertySpecified;
+    TWIN_CACHE_HANDLE handle = create_populated_cache();
+    property.structVersion = 2;
+
+    // act
+    IOTHUB_CLIENT_RESULT result = twin_cache_get_property(handle, IOTHUB_CLIENT_PROPERTY_TYPE_WRITABLE, NULL, "targetTemp", &property, &propertySpecified);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+
+    // cleanup
+    twin_cache_destroy(handle);
+}
+
+END_TEST_SUITE(iothub_client_twin_cache_ut)
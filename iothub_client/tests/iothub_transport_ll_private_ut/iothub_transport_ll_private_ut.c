@@ -56,6 +56,7 @@ MOCKABLE_FUNCTION(, const char*, Transport_GetOption_Product_Info_Callback, void
 MOCKABLE_FUNCTION(, void, Transport_Twin_ReportedStateComplete_Callback, uint32_t, item_id, int, status_code, void*, ctx);
 MOCKABLE_FUNCTION(, void, Transport_Twin_RetrievePropertyComplete_Callback, DEVICE_TWIN_UPDATE_STATE, update_state, const unsigned char*, payLoad, size_t, size, void*, ctx);
 MOCKABLE_FUNCTION(, int, Transport_DeviceMethod_Complete_Callback, const char*, method_name, const unsigned char*, payLoad, size_t, size, METHOD_HANDLE, response_id, void*, ctx);
+MOCKABLE_FUNCTION(, METRICS_HANDLE, Transport_GetMetrics_Callback, void*, ctx);
 
 #undef ENABLE_MOCKS
 
@@ -116,6 +117,7 @@ BEGIN_TEST_SUITE(iothub_transport_ll_private_ut)
         transport_cb_info.msg_input_cb = Transport_MessageCallbackFromInput;
         transport_cb_info.msg_cb = Transport_MessageCallback;
         transport_cb_info.method_complete_cb = Transport_DeviceMethod_Complete_Callback;
+        transport_cb_info.get_metrics_cb = Transport_GetMetrics_Callback;
 
         //act
         result = IoTHub_Transport_ValidateCallbacks(&transport_cb_info);
@@ -156,8 +158,9 @@ BEGIN_TEST_SUITE(iothub_transport_ll_private_ut)
         transport_cb_info.msg_input_cb = Transport_MessageCallbackFromInput;
         transport_cb_info.msg_cb = Transport_MessageCallback;
         transport_cb_info.method_complete_cb = Transport_DeviceMethod_Complete_Callback;
+        transport_cb_info.get_metrics_cb = Transport_GetMetrics_Callback;
 
-        for (size_t index = 0; index < 8; index++)
+        for (size_t index = 0; index < 10; index++)
         {
             memcpy(&fail_transport_cb, &transport_cb_info, sizeof(TRANSPORT_CALLBACKS_INFO));
             switch (index)
@@ -188,6 +191,9 @@ BEGIN_TEST_SUITE(iothub_transport_ll_private_ut)
                     break;
                 case 8:
                     fail_transport_cb.method_complete_cb = NULL;
+                    break;
+                case 9:
+                    fail_transport_cb.get_metrics_cb = NULL;
             }
 
             // act
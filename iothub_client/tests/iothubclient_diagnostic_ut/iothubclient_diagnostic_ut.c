@@ -5,10 +5,14 @@
 #include <cstdlib>
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
 #else
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <string.h>
 #endif
 
 static void* my_gballoc_malloc(size_t size)
@@ -56,6 +60,17 @@ static IOTHUB_MESSAGE_HANDLE TEST_MESSAGE_HANDLE = (IOTHUB_MESSAGE_HANDLE)0x12;
 #define INDEFINITE_TIME ((time_t)-1)
 static time_t g_current_time;
 
+static char g_diagnostic_id[16];
+static char g_diagnostic_creation_time_utc[32];
+
+static IOTHUB_MESSAGE_RESULT my_IoTHubMessage_SetDiagnosticPropertyData(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, const IOTHUB_MESSAGE_DIAGNOSTIC_PROPERTY_DATA* diagnosticData)
+{
+    (void)iotHubMessageHandle;
+    (void)snprintf(g_diagnostic_id, sizeof(g_diagnostic_id), "%s", diagnosticData->diagnosticId);
+    (void)snprintf(g_diagnostic_creation_time_utc, sizeof(g_diagnostic_creation_time_utc), "%s", diagnosticData->diagnosticCreationTimeUtc);
+    return IOTHUB_MESSAGE_OK;
+}
+
 BEGIN_TEST_SUITE(iothubclient_diagnostic_ut)
 
 TEST_SUITE_INITIALIZE(suite_init)
@@ -79,7 +94,7 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
 
-    REGISTER_GLOBAL_MOCK_RETURN(IoTHubMessage_SetDiagnosticPropertyData, IOTHUB_MESSAGE_OK);
+    REGISTER_GLOBAL_MOCK_HOOK(IoTHubMessage_SetDiagnosticPropertyData, my_IoTHubMessage_SetDiagnosticPropertyData);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubMessage_SetDiagnosticPropertyData, IOTHUB_MESSAGE_ERROR);
 
     REGISTER_GLOBAL_MOCK_RETURN(Map_Add, MAP_OK);
@@ -149,9 +164,7 @@ TEST_FUNCTION(IoTHubClient_Diagnostic_AddIfNecessary_fails)
 
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(get_time(NULL));
     STRICT_EXPECTED_CALL(IoTHubMessage_SetDiagnosticPropertyData(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
     umock_c_negative_tests_snapshot();
@@ -202,14 +215,8 @@ TEST_FUNCTION(IoTHubClient_Diagnostic_AddIfNecessary_no_diag_info_with_percentag
     umock_c_reset_all_calls();
 
 
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     EXPECTED_CALL(get_time(NULL));
     STRICT_EXPECTED_CALL(IoTHubMessage_SetDiagnosticPropertyData(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     //act
     int result = IoTHubClient_Diagnostic_AddIfNecessary(&diag_setting, TEST_MESSAGE_HANDLE);
@@ -231,14 +238,8 @@ TEST_FUNCTION(IoTHubClient_Diagnostic_AddIfNecessary_no_diag_info_with_normal_pe
 
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     EXPECTED_CALL(get_time(NULL));
     STRICT_EXPECTED_CALL(IoTHubMessage_SetDiagnosticPropertyData(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     //act
     for (uint32_t index = 0; index < 2; ++index)
@@ -252,4 +253,76 @@ TEST_FUNCTION(IoTHubClient_Diagnostic_AddIfNecessary_no_diag_info_with_normal_pe
     }
 }
 
+TEST_FUNCTION(IoTHubClient_Diagnostic_AddIfNecessary_sets_id_and_epoch_time)
+{
+    //arrange
+    IOTHUB_DIAGNOSTIC_SETTING_DATA diag_setting =
+    {
+        100,    /*diagnostic sampling percentage*/
+        0        /*message number*/
+    };
+    char expected_time[32];
+    (void)snprintf(expected_time, sizeof(expected_time), "%llu", (unsigned long long)g_current_time);
+
+    umock_c_reset_all_calls();
+
+    //act
+    int result = IoTHubClient_Diagnostic_AddIfNecessary(&diag_setting, TEST_MESSAGE_HANDLE);
+
+    //assert
+    ASSERT_IS_TRUE(result == 0);
+    ASSERT_ARE_EQUAL(size_t, 8, strlen(g_diagnostic_id));
+    ASSERT_ARE_EQUAL(char_ptr, expected_time, g_diagnostic_creation_time_utc);
+}
+
+TEST_FUNCTION(IoTHubClient_Diagnostic_AddIfNecessary_samples_evenly)
+{
+    //arrange
+    IOTHUB_DIAGNOSTIC_SETTING_DATA diag_setting =
+    {
+        25,        /*diagnostic sampling percentage*/
+        0        /*message number*/
+    };
+    size_t sampled = 0;
+
+    umock_c_reset_all_calls();
+
+    //act
+    for (uint32_t index = 0; index < 100; ++index)
+    {
+        int result = IoTHubClient_Diagnostic_AddIfNecessary(&diag_setting, TEST_MESSAGE_HANDLE);
+        ASSERT_IS_TRUE(result == 0);
+
+        // The first of every four messages is sampled
+        if (umock_c_get_actual_calls()[0] != '\0')
+        {
+            ASSERT_ARE_EQUAL(uint32_t, 0, index % 4);
+            sampled++;
+        }
+        umock_c_reset_all_calls();
+    }
+
+    //assert
+    ASSERT_ARE_EQUAL(size_t, 25, sampled);
+}
+
+TEST_FUNCTION(IoTHubClient_Diagnostic_AddIfNecessary_wraps_message_number)
+{
+    //arrange
+    IOTHUB_DIAGNOSTIC_SETTING_DATA diag_setting =
+    {
+        50,        /*diagnostic sampling percentage*/
+        UINT32_MAX        /*message number*/
+    };
+
+    umock_c_reset_all_calls();
+
+    //act
+    int result = IoTHubClient_Diagnostic_AddIfNecessary(&diag_setting, TEST_MESSAGE_HANDLE);
+
+    //assert
+    ASSERT_IS_TRUE(result == 0);
+    ASSERT_ARE_EQUAL(uint32_t, (UINT32_MAX % 5000) + 1, diag_setting.currentMessageNumber);
+}
+
 END_TEST_SUITE(iothubclient_diagnostic_ut)
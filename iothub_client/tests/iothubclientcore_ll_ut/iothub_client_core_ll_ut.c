@@ -55,6 +55,9 @@ void* my_gballoc_realloc(void* ptr, size_t size)
 #include "iothub_message.h"
 #include "internal/iothub_client_authorization.h"
 #include "internal/iothub_client_diagnostic.h"
+#include "internal/iothub_client_twin_cache.h"
+#include "internal/iothub_client_reported_aggregator.h"
+#include "internal/iothub_client_metrics.h"
 
 #ifndef DONT_USE_UPLOADTOBLOB
 #include "internal/iothub_client_ll_uploadtoblob.h"
@@ -83,6 +86,7 @@ void* my_gballoc_realloc(void* ptr, size_t size)
 #endif
 
 MOCKABLE_FUNCTION(, void, test_event_confirmation_callback, IOTHUB_CLIENT_CONFIRMATION_RESULT, result, void*, userContextCallback);
+MOCKABLE_FUNCTION(, void, test_metrics_export_callback, const IOTHUB_CLIENT_METRICS*, metrics, void*, userContextCallback);
 MOCKABLE_FUNCTION(, IOTHUBMESSAGE_DISPOSITION_RESULT, test_message_callback_async, IOTHUB_MESSAGE_HANDLE, message, void*, userContextCallback);
 MOCKABLE_FUNCTION(, void, iothub_reported_state_callback, int, status_code, void*, userContextCallback);
 MOCKABLE_FUNCTION(, void, iothub_device_twin_callback, DEVICE_TWIN_UPDATE_STATE, update_state, const unsigned char*, payLoad, size_t, size, void*, userContextCallback);
@@ -119,6 +123,7 @@ MOCKABLE_FUNCTION(, int, FAKE_IotHubTransport_Subscribe_InputQueue, IOTHUB_DEVIC
 MOCKABLE_FUNCTION(, void, FAKE_IotHubTransport_Unsubscribe_InputQueue, IOTHUB_DEVICE_HANDLE, handle);
 MOCKABLE_FUNCTION(, int, FAKE_IoTHubTransport_SetCallbackContext, TRANSPORT_LL_HANDLE, handle, void*, ctx);
 MOCKABLE_FUNCTION(, int, FAKE_IoTHubTransport_GetSupportedPlatformInfo, TRANSPORT_LL_HANDLE, handle, PLATFORM_INFO_OPTION*, info);
+MOCKABLE_FUNCTION(, IOTHUB_CLIENT_RESULT, FAKE_IoTHubTransport_GetPollInfo, TRANSPORT_LL_HANDLE, handle, bool, hasQueuedItems, IOTHUB_CLIENT_POLL_INFO*, pollInfo);
 MOCKABLE_FUNCTION(, bool, messageInputCallbackEx, IOTHUB_MESSAGE_HANDLE, message, void*, userContextCallback);
 
 MOCKABLE_FUNCTION(, bool, Transport_MessageCallbackFromInput, IOTHUB_MESSAGE_HANDLE, message, void*, ctx);
@@ -236,6 +241,10 @@ static const char* TEST_STRING_VALUE = "Test string value";
 
 #define TEST_METHOD_ID                      (METHOD_HANDLE)0x61
 #define TEST_IOTHUB_AUTH_HANDLE             (IOTHUB_AUTHORIZATION_HANDLE)0x62
+#define TEST_REPORTED_AGGREGATOR_HANDLE     (REPORTED_AGGREGATOR_HANDLE)0x63
+#define TEST_METRICS_HANDLE                 (METRICS_HANDLE)0x64
+#define TEST_TWIN_CACHE_HANDLE              (TWIN_CACHE_HANDLE)0x65
+#define TEST_METRICS_ENQUEUED_MS            (tickcounter_ms_t)42
 
 static const char* TEST_PROV_URI = "global.azure-devices-provisioning.net";
 
@@ -519,6 +528,7 @@ static TRANSPORT_LL_HANDLE my_FAKE_IoTHubTransport_Create(const IOTHUBTRANSPORT_
     g_transport_cb_info.twin_rpt_state_complete_cb = cb_info->twin_rpt_state_complete_cb;
     g_transport_cb_info.twin_retrieve_prop_complete_cb = cb_info->twin_retrieve_prop_complete_cb;
     g_transport_cb_info.method_complete_cb = cb_info->method_complete_cb;
+    g_transport_cb_info.get_metrics_cb = cb_info->get_metrics_cb;
 
     return TEST_TRANSPORT_LL_HANDLE;
 }
@@ -630,7 +640,8 @@ static TRANSPORT_PROVIDER FAKE_transport_provider =
     FAKE_IotHubTransport_Unsubscribe_InputQueue, /*pfIoTHubTransport_Unsubscribe_InputQueue IoTHubTransport_Unsubscribe_InputQueue; */
     FAKE_IoTHubTransport_SetCallbackContext,
     FAKE_IoTHubTransport_GetTwinAsync,   /*pfIoTHubTransport_GetTwinAsync IoTHubTransport_GetTwinAsync;*/
-    FAKE_IoTHubTransport_GetSupportedPlatformInfo
+    FAKE_IoTHubTransport_GetSupportedPlatformInfo,
+    FAKE_IoTHubTransport_GetPollInfo    /*pfIoTHubTransport_GetPollInfo IoTHubTransport_GetPollInfo;*/
 };
 
 static const TRANSPORT_PROVIDER* provideFAKE(void)
@@ -815,6 +826,14 @@ TEST_SUITE_INITIALIZE(suite_init)
 
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_EDGE_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_SECURITY_TYPE, int);
+    REGISTER_UMOCK_ALIAS_TYPE(REPORTED_AGGREGATOR_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(REPORTED_AGGREGATOR_FLUSH_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_REPORTED_STATE_CALLBACK, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(tickcounter_ms_t, uint64_t);
+    REGISTER_UMOCK_ALIAS_TYPE(METRICS_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(METRICS_COUNTER, int);
+    REGISTER_UMOCK_ALIAS_TYPE(TWIN_CACHE_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TWIN_CACHE_UPDATE_RESULT, int);
 
 
     REGISTER_GLOBAL_MOCK_RETURN(IoTHubClient_GetVersionString, "version 1.0");
@@ -827,6 +846,25 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_HOOK(FAKE_IoTHubTransport_GetTwinAsync, my_FAKE_IoTHubTransport_GetTwinAsync);
 
     REGISTER_GLOBAL_MOCK_RETURN(FAKE_IoTHubTransport_ProcessItem, IOTHUB_PROCESS_OK);
+
+    REGISTER_GLOBAL_MOCK_RETURN(reported_aggregator_create, TEST_REPORTED_AGGREGATOR_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(reported_aggregator_create, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(reported_aggregator_add, 0);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(reported_aggregator_add, MU_FAILURE);
+    REGISTER_GLOBAL_MOCK_RETURN(reported_aggregator_flush, REPORTED_AGGREGATOR_FLUSH_IDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(reported_aggregator_is_idle, false);
+
+    REGISTER_GLOBAL_MOCK_RETURN(twin_cache_create, TEST_TWIN_CACHE_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(twin_cache_create, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(twin_cache_update, TWIN_CACHE_UPDATE_OK);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(twin_cache_update, TWIN_CACHE_UPDATE_ERROR);
+    REGISTER_GLOBAL_MOCK_RETURN(twin_cache_apply_reported, 0);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(twin_cache_apply_reported, MU_FAILURE);
+    REGISTER_GLOBAL_MOCK_RETURN(metrics_create, TEST_METRICS_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(metrics_create, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(metrics_get_current_ms, TEST_METRICS_ENQUEUED_MS);
+    REGISTER_GLOBAL_MOCK_RETURN(metrics_get_snapshot, 0);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(metrics_get_snapshot, MU_FAILURE);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(FAKE_IoTHubTransport_ProcessItem, IOTHUB_PROCESS_ERROR);
 
     REGISTER_GLOBAL_MOCK_HOOK(FAKE_IoTHubTransport_GetHostname, my_FAKE_IoTHubTransport_GetHostname);
@@ -852,6 +890,8 @@ TEST_SUITE_INITIALIZE(suite_init)
 
     REGISTER_GLOBAL_MOCK_RETURN(FAKE_IoTHubTransport_SetCallbackContext, 0);
     REGISTER_GLOBAL_MOCK_RETURN(FAKE_IoTHubTransport_GetSupportedPlatformInfo, 0);
+    REGISTER_GLOBAL_MOCK_RETURN(FAKE_IoTHubTransport_GetPollInfo, IOTHUB_CLIENT_OK);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(FAKE_IoTHubTransport_GetPollInfo, IOTHUB_CLIENT_ERROR);
 
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(FAKE_IoTHubTransport_Subscribe_DeviceMethod, MU_FAILURE);
     REGISTER_GLOBAL_MOCK_RETURN(FAKE_IoTHubMessage_GetMessageId, "1");
@@ -3638,6 +3678,26 @@ TEST_FUNCTION(IoTHubClientCore_LL_SetOption_fails_when_underlying_transport_fail
 }
 #endif
 
+TEST_FUNCTION(IoTHubClientCore_LL_SetOption_batching_is_passed_to_the_transport_only)
+{
+    //arrange
+    bool batching = true;
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_SetOption(IGNORED_PTR_ARG, OPTION_BATCHING, &batching));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SetOption(handle, OPTION_BATCHING, &batching);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    IoTHubClientCore_LL_Destroy(handle);
+}
+
 TEST_FUNCTION(IoTHubClientCore_LL_SetOption_messageTimeout_to_zero_after_Create_succeeds)
 {
     //arrange
@@ -4375,6 +4435,130 @@ TEST_FUNCTION(IoTHubClientCore_LL_SendReportedState_succeeds)
     IoTHubClientCore_LL_Destroy(handle);
 }
 
+TEST_FUNCTION(IoTHubClientCore_LL_SetOption_reported_state_flush_interval_creates_aggregator)
+{
+    //arrange
+    unsigned int flushIntervalMs = 250;
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(reported_aggregator_create(250));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SetOption(handle, OPTION_REPORTED_STATE_FLUSH_INTERVAL_MS, &flushIntervalMs);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClientCore_LL_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_SetOption_reported_state_flush_interval_create_fails)
+{
+    //arrange
+    unsigned int flushIntervalMs = 250;
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(reported_aggregator_create(250)).SetReturn(NULL);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SetOption(handle, OPTION_REPORTED_STATE_FLUSH_INTERVAL_MS, &flushIntervalMs);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClientCore_LL_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_SendReportedState_with_aggregator_merges_report)
+{
+    //arrange
+    unsigned int flushIntervalMs = 250;
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClientCore_LL_SetOption(handle, OPTION_REPORTED_STATE_FLUSH_INTERVAL_MS, &flushIntervalMs);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_Subscribe_DeviceTwin(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(reported_aggregator_add(TEST_REPORTED_AGGREGATOR_HANDLE, TEST_REPORTED_STATE, TEST_REPORTED_SIZE, iothub_reported_state_callback, NULL, IGNORED_NUM_ARG));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SendReportedState(handle, TEST_REPORTED_STATE, TEST_REPORTED_SIZE, iothub_reported_state_callback, NULL);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClientCore_LL_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_SendReportedState_with_aggregator_add_fails)
+{
+    //arrange
+    unsigned int flushIntervalMs = 250;
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClientCore_LL_SetOption(handle, OPTION_REPORTED_STATE_FLUSH_INTERVAL_MS, &flushIntervalMs);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_Subscribe_DeviceTwin(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(reported_aggregator_add(TEST_REPORTED_AGGREGATOR_HANDLE, TEST_REPORTED_STATE, TEST_REPORTED_SIZE, iothub_reported_state_callback, NULL, IGNORED_NUM_ARG))
+        .SetReturn(MU_FAILURE);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SendReportedState(handle, TEST_REPORTED_STATE, TEST_REPORTED_SIZE, iothub_reported_state_callback, NULL);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClientCore_LL_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_DoWork_with_aggregator_queues_merged_report)
+{
+    //arrange
+    unsigned int flushIntervalMs = 250;
+    const unsigned char* mergedPatch = TEST_REPORTED_STATE;
+    size_t mergedPatchSize = TEST_REPORTED_SIZE;
+    void* batchContext = (void*)0x4545;
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClientCore_LL_SetOption(handle, OPTION_REPORTED_STATE_FLUSH_INTERVAL_MS, &flushIntervalMs);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(reported_aggregator_flush(TEST_REPORTED_AGGREGATOR_HANDLE, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_patch(&mergedPatch, sizeof(mergedPatch))
+        .CopyOutArgumentBuffer_size(&mergedPatchSize, sizeof(mergedPatchSize))
+        .CopyOutArgumentBuffer_batch_context(&batchContext, sizeof(batchContext))
+        .SetReturn(REPORTED_AGGREGATOR_FLUSH_PATCH_READY);
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_Create(TEST_REPORTED_STATE, TEST_REPORTED_SIZE));
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_ProcessItem(IGNORED_PTR_ARG, IOTHUB_TYPE_DEVICE_TWIN, IGNORED_PTR_ARG))
+        .IgnoreArgument_item_type();
+    STRICT_EXPECTED_CALL(DList_RemoveEntryList(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_DoWork(IGNORED_PTR_ARG));
+
+    //act
+    IoTHubClientCore_LL_DoWork(handle);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClientCore_LL_Destroy(handle);
+}
+
 TEST_FUNCTION(IoTHubClientCore_LL_Destroy_with_pending_reported_state_succeeds)
 {
     //arrange
@@ -4425,187 +4609,556 @@ TEST_FUNCTION(IoTHubClientCore_LL_Destroy_with_pending_reported_state_succeeds)
     //cleanup
 }
 
-TEST_FUNCTION(IoTHubClientCore_LL_SendReportedState_NULL_fails)
+TEST_FUNCTION(IoTHubClientCore_LL_SetOption_metrics_creates_registry)
 {
     //arrange
+    bool enable = true;
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(metrics_create());
+
     //act
-    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SendReportedState(NULL, TEST_REPORTED_STATE, TEST_REPORTED_SIZE, iothub_reported_state_callback, NULL);
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SetOption(handle, OPTION_METRICS, &enable);
 
-    ///assert
-    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(void_ptr, TEST_METRICS_HANDLE, g_transport_cb_info.get_metrics_cb(g_transport_cb_ctx));
 
-    ///cleanup
+    //cleanup
+    IoTHubClientCore_LL_Destroy(handle);
 }
 
-TEST_FUNCTION(IoTHubClientCore_LL_SendReportedState_reported_state_NULL_fail)
+TEST_FUNCTION(IoTHubClientCore_LL_SetOption_metrics_create_fails)
 {
     //arrange
+    bool enable = true;
     IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(metrics_create()).SetReturn(NULL);
+
     //act
-    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SendReportedState(handle, NULL, TEST_REPORTED_SIZE, iothub_reported_state_callback, NULL);
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SetOption(handle, OPTION_METRICS, &enable);
 
-    ///assert
-    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NULL(g_transport_cb_info.get_metrics_cb(g_transport_cb_ctx));
 
-    ///cleanup
+    //cleanup
     IoTHubClientCore_LL_Destroy(handle);
 }
 
-TEST_FUNCTION(IoTHubClientCore_LL_SendReportedState_reported_size_0_fail)
+TEST_FUNCTION(IoTHubClientCore_LL_SetOption_metrics_false_destroys_registry)
 {
     //arrange
+    bool enable = true;
+    bool disable = false;
     IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClientCore_LL_SetOption(handle, OPTION_METRICS, &enable);
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(metrics_destroy(TEST_METRICS_HANDLE));
 
     //act
-    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SendReportedState(handle, TEST_REPORTED_STATE, 0, iothub_reported_state_callback, NULL);
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SetOption(handle, OPTION_METRICS, &disable);
 
-    ///assert
-    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NULL(g_transport_cb_info.get_metrics_cb(g_transport_cb_ctx));
 
-    ///cleanup
+    //cleanup
     IoTHubClientCore_LL_Destroy(handle);
 }
 
-TEST_FUNCTION(IoTHubClientCore_LL_SendReportedState_fail)
+TEST_FUNCTION(IoTHubClientCore_LL_SetOption_metrics_export_with_0_interval_fails)
 {
     //arrange
-    int negativeTestsInitResult = umock_c_negative_tests_init();
-    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
-
+    IOTHUB_CLIENT_METRICS_EXPORT metricsExport;
+    metricsExport.callback = test_metrics_export_callback;
+    metricsExport.userContextCallback = NULL;
+    metricsExport.intervalMs = 0;
     IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
     umock_c_reset_all_calls();
 
-    setup_IoTHubClientCore_LL_sendreportedstate_mocks();
-
-    umock_c_negative_tests_snapshot();
-
-    size_t count = umock_c_negative_tests_call_count();
-    for (size_t index = 0; index < count; index++)
-    {
-        if (umock_c_negative_tests_can_call_fail(index))
-        {
-            umock_c_negative_tests_reset();
-            umock_c_negative_tests_fail_call(index);
-
-            char tmp_msg[128];
-            sprintf(tmp_msg, "IoTHubClientCore_LL_SendReportedState failure in test %zu/%zu", index, count);
-
-            //act
-            IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SendReportedState(handle, TEST_REPORTED_STATE, TEST_REPORTED_SIZE, iothub_reported_state_callback, NULL);
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SetOption(handle, OPTION_METRICS_EXPORT, &metricsExport);
 
-            //assert
-            ASSERT_ARE_NOT_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result, tmp_msg);
-        }
-    }
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     //cleanup
     IoTHubClientCore_LL_Destroy(handle);
 }
 
-
-TEST_FUNCTION(IoTHubClientCore_LL_DoWork_SendReportedState_succeed)
+TEST_FUNCTION(IoTHubClientCore_LL_SetOption_metrics_export_enables_metrics)
 {
     //arrange
-    IOTHUB_CLIENT_CORE_LL_HANDLE h = IoTHubClientCore_LL_Create(&TEST_CONFIG);
-    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SendReportedState(h, TEST_REPORTED_STATE, TEST_REPORTED_SIZE, iothub_reported_state_callback, NULL);
-    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    IOTHUB_CLIENT_METRICS_EXPORT metricsExport;
+    metricsExport.callback = test_metrics_export_callback;
+    metricsExport.userContextCallback = NULL;
+    metricsExport.intervalMs = 1000;
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG)); /*_DoWork will ask "what's the time"*/
-    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_ProcessItem(IGNORED_PTR_ARG, IOTHUB_TYPE_DEVICE_TWIN, IGNORED_PTR_ARG))
-        .IgnoreArgument_item_type();
-    STRICT_EXPECTED_CALL(DList_RemoveEntryList(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_DoWork(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(metrics_create());
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
     //act
-    IoTHubClientCore_LL_DoWork(h);
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SetOption(handle, OPTION_METRICS_EXPORT, &metricsExport);
 
     //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     //cleanup
-    IoTHubClientCore_LL_Destroy(h);
+    IoTHubClientCore_LL_Destroy(handle);
 }
 
-TEST_FUNCTION(IoTHubClientCore_LL_DoWork_SendReportedState_continue_processing_succeed)
+TEST_FUNCTION(IoTHubClientCore_LL_SendEventAsync_with_metrics_stamps_message)
 {
     //arrange
-    IOTHUB_CLIENT_CORE_LL_HANDLE h = IoTHubClientCore_LL_Create(&TEST_CONFIG);
-    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SendReportedState(h, TEST_REPORTED_STATE, TEST_REPORTED_SIZE, iothub_reported_state_callback, NULL);
-    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    bool enable = true;
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClientCore_LL_SetOption(handle, OPTION_METRICS, &enable);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*_DoWork will ask "what's the time"*/
-        .IgnoreArgument_tick_counter()
-        .IgnoreArgument_current_ms();
-
-    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_ProcessItem(IGNORED_PTR_ARG, IOTHUB_TYPE_DEVICE_TWIN, IGNORED_PTR_ARG))
-        .IgnoreArgument(1)
-        .IgnoreArgument_item_type()
-        .IgnoreArgument(3)
-        .SetReturn(IOTHUB_PROCESS_CONTINUE);
-
-    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_DoWork(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(IoTHubMessage_Clone(TEST_MESSAGE_HANDLE));
+    STRICT_EXPECTED_CALL(IoTHubClient_Diagnostic_AddIfNecessary(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(metrics_get_current_ms(TEST_METRICS_HANDLE));
+    STRICT_EXPECTED_CALL(metrics_add(TEST_METRICS_HANDLE, METRICS_MESSAGES_ENQUEUED, 1));
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
     //act
-    IoTHubClientCore_LL_DoWork(h);
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SendEventAsync(handle, TEST_MESSAGE_HANDLE, test_event_confirmation_callback, NULL);
 
-    ///assert
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-    ///cleanup
-    IoTHubClientCore_LL_Destroy(h);
+    //cleanup
+    IoTHubClientCore_LL_Destroy(handle);
 }
 
-TEST_FUNCTION(IoTHubClientCore_LL_SetDeviceMethodCallback_with_NULL_iotHubClientHandle_fails)
+TEST_FUNCTION(IoTHubClientCore_LL_SendComplete_with_metrics_records_completion)
 {
-    ///arrange
+    //arrange
+    bool enable = true;
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClientCore_LL_SetOption(handle, OPTION_METRICS, &enable);
+    DLIST_ENTRY temp;
+    DList_InitializeListHead(&temp);
+    IOTHUB_MESSAGE_LIST* one = (IOTHUB_MESSAGE_LIST*)malloc(sizeof(IOTHUB_MESSAGE_LIST));
+    one->messageHandle = (IOTHUB_MESSAGE_HANDLE)1;
+    one->callback = eventConfirmationCallback;
+    one->context = (void*)1;
+    one->ms_enqueued = TEST_METRICS_ENQUEUED_MS;
+    DList_InsertTailList(&temp, &(one->entry));
+    umock_c_reset_all_calls();
 
-    ///act
-    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SetDeviceMethodCallback(NULL, deviceMethodCallback, (void*)1);
+    STRICT_EXPECTED_CALL(DList_RemoveHeadList(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(metrics_record_send_complete(TEST_METRICS_HANDLE, IOTHUB_CLIENT_CONFIRMATION_OK, TEST_METRICS_ENQUEUED_MS));
+    STRICT_EXPECTED_CALL(eventConfirmationCallback(IOTHUB_CLIENT_CONFIRMATION_OK, (void*)1));
+    STRICT_EXPECTED_CALL(IoTHubMessage_Destroy((IOTHUB_MESSAGE_HANDLE)1));
+    STRICT_EXPECTED_CALL(gballoc_free(one));
+    STRICT_EXPECTED_CALL(DList_RemoveHeadList(IGNORED_PTR_ARG));
 
-    ///assert
-    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    //act
+    g_transport_cb_info.send_complete_cb(&temp, IOTHUB_CLIENT_CONFIRMATION_OK, g_transport_cb_ctx);
+
+    //assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClientCore_LL_Destroy(handle);
 }
 
-TEST_FUNCTION(IoTHubClientCore_LL_SetDeviceMethodCallback_with_NULL_callback_Unsubscribe_and_succeeds)
+TEST_FUNCTION(IoTHubClientCore_LL_ConnectionStatusCallBack_with_metrics_counts_disconnect)
 {
-    ///arrange
+    //arrange
+    bool enable = true;
     IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
-    (void)IoTHubClientCore_LL_SetDeviceMethodCallback(handle, deviceMethodCallback, (void*)1);
+    (void)IoTHubClientCore_LL_SetOption(handle, OPTION_METRICS, &enable);
+    g_transport_cb_info.connection_status_cb(IOTHUB_CLIENT_CONNECTION_AUTHENTICATED, IOTHUB_CLIENT_CONNECTION_OK, g_transport_cb_ctx);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_Unsubscribe_DeviceMethod(IGNORED_PTR_ARG))
-        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(metrics_add(TEST_METRICS_HANDLE, METRICS_DISCONNECTS, 1));
 
-    ///act
-    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SetDeviceMethodCallback(handle, NULL, (void*)1);
+    //act
+    g_transport_cb_info.connection_status_cb(IOTHUB_CLIENT_CONNECTION_UNAUTHENTICATED, IOTHUB_CLIENT_CONNECTION_NO_NETWORK, g_transport_cb_ctx);
+    g_transport_cb_info.connection_status_cb(IOTHUB_CLIENT_CONNECTION_UNAUTHENTICATED, IOTHUB_CLIENT_CONNECTION_NO_NETWORK, g_transport_cb_ctx);
 
-    ///assert
-    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    //assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-    ///cleanup
+    //cleanup
     IoTHubClientCore_LL_Destroy(handle);
 }
 
-TEST_FUNCTION(IoTHubClientCore_LL_SetDeviceMethodCallback_with_NULL_callback_Unsubscribe_After_SetDeviceMethodCallback_Ex_fail)
+TEST_FUNCTION(IoTHubClientCore_LL_GetPollInfo_with_NULL_handle_fails)
 {
-    ///arrange
-    IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
-    (void)IoTHubClientCore_LL_SetDeviceMethodCallback_Ex(handle, iothub_client_inbound_device_method_callback, (void*)1);
-    umock_c_reset_all_calls();
+    //arrange
+    IOTHUB_CLIENT_POLL_INFO pollInfo;
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_GetPollInfo(NULL, &pollInfo);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_GetPollInfo_with_NULL_pollInfo_fails)
+{
+    //arrange
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_GetPollInfo(handle, NULL);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClientCore_LL_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_GetPollInfo_returns_the_transport_timeout)
+{
+    //arrange
+    IOTHUB_CLIENT_POLL_INFO transportPollInfo;
+    IOTHUB_CLIENT_POLL_INFO pollInfo;
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    transportPollInfo.timeoutMs = 2500;
+    STRICT_EXPECTED_CALL(DList_IsListEmpty(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_GetPollInfo(IGNORED_PTR_ARG, false, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_pollInfo(&transportPollInfo, sizeof(transportPollInfo));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_GetPollInfo(handle, &pollInfo);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 2500, pollInfo.timeoutMs);
+
+    //cleanup
+    IoTHubClientCore_LL_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_GetPollInfo_transport_fails)
+{
+    //arrange
+    IOTHUB_CLIENT_POLL_INFO pollInfo;
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(DList_IsListEmpty(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_GetPollInfo(IGNORED_PTR_ARG, false, IGNORED_PTR_ARG))
+        .SetReturn(IOTHUB_CLIENT_ERROR);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_GetPollInfo(handle, &pollInfo);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClientCore_LL_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_GetMetrics_with_NULL_handle_fails)
+{
+    //arrange
+    IOTHUB_CLIENT_METRICS metrics;
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_GetMetrics(NULL, &metrics);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_GetMetrics_with_NULL_metrics_fails)
+{
+    //arrange
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_GetMetrics(handle, NULL);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClientCore_LL_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_GetMetrics_without_metrics_fails)
+{
+    //arrange
+    IOTHUB_CLIENT_METRICS metrics;
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_GetMetrics(handle, &metrics);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClientCore_LL_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_GetMetrics_computes_queue_gauges)
+{
+    //arrange
+    bool enable = true;
+    IOTHUB_CLIENT_METRICS snapshot;
+    IOTHUB_CLIENT_METRICS metrics;
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClientCore_LL_SetOption(handle, OPTION_METRICS, &enable);
+    (void)IoTHubClientCore_LL_SendEventAsync(handle, TEST_MESSAGE_HANDLE, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    memset(&snapshot, 0, sizeof(snapshot));
+    snapshot.messagesEnqueued = 5;
+    snapshot.messagesAcknowledged = 2;
+    STRICT_EXPECTED_CALL(metrics_get_snapshot(TEST_METRICS_HANDLE, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_metrics(&snapshot, sizeof(snapshot));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_GetMetrics(handle, &metrics);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, metrics.messagesWaiting);
+    ASSERT_ARE_EQUAL(size_t, 2, metrics.messagesInFlight);
+
+    //cleanup
+    IoTHubClientCore_LL_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_GetMetrics_snapshot_fails)
+{
+    //arrange
+    bool enable = true;
+    IOTHUB_CLIENT_METRICS metrics;
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClientCore_LL_SetOption(handle, OPTION_METRICS, &enable);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(metrics_get_snapshot(TEST_METRICS_HANDLE, IGNORED_PTR_ARG)).SetReturn(MU_FAILURE);
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_GetMetrics(handle, &metrics);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClientCore_LL_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_SendReportedState_NULL_fails)
+{
+    //arrange
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SendReportedState(NULL, TEST_REPORTED_STATE, TEST_REPORTED_SIZE, iothub_reported_state_callback, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_SendReportedState_reported_state_NULL_fail)
+{
+    //arrange
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SendReportedState(handle, NULL, TEST_REPORTED_SIZE, iothub_reported_state_callback, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    IoTHubClientCore_LL_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_SendReportedState_reported_size_0_fail)
+{
+    //arrange
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SendReportedState(handle, TEST_REPORTED_STATE, 0, iothub_reported_state_callback, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    IoTHubClientCore_LL_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_SendReportedState_fail)
+{
+    //arrange
+    int negativeTestsInitResult = umock_c_negative_tests_init();
+    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    setup_IoTHubClientCore_LL_sendreportedstate_mocks();
+
+    umock_c_negative_tests_snapshot();
+
+    size_t count = umock_c_negative_tests_call_count();
+    for (size_t index = 0; index < count; index++)
+    {
+        if (umock_c_negative_tests_can_call_fail(index))
+        {
+            umock_c_negative_tests_reset();
+            umock_c_negative_tests_fail_call(index);
+
+            char tmp_msg[128];
+            sprintf(tmp_msg, "IoTHubClientCore_LL_SendReportedState failure in test %zu/%zu", index, count);
+
+            //act
+            IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SendReportedState(handle, TEST_REPORTED_STATE, TEST_REPORTED_SIZE, iothub_reported_state_callback, NULL);
+
+            //assert
+            ASSERT_ARE_NOT_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result, tmp_msg);
+        }
+    }
+
+    //cleanup
+    IoTHubClientCore_LL_Destroy(handle);
+}
+
+
+TEST_FUNCTION(IoTHubClientCore_LL_DoWork_SendReportedState_succeed)
+{
+    //arrange
+    IOTHUB_CLIENT_CORE_LL_HANDLE h = IoTHubClientCore_LL_Create(&TEST_CONFIG);
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SendReportedState(h, TEST_REPORTED_STATE, TEST_REPORTED_SIZE, iothub_reported_state_callback, NULL);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG)); /*_DoWork will ask "what's the time"*/
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_ProcessItem(IGNORED_PTR_ARG, IOTHUB_TYPE_DEVICE_TWIN, IGNORED_PTR_ARG))
+        .IgnoreArgument_item_type();
+    STRICT_EXPECTED_CALL(DList_RemoveEntryList(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(DList_InsertTailList(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_DoWork(IGNORED_PTR_ARG));
+
+    //act
+    IoTHubClientCore_LL_DoWork(h);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClientCore_LL_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_DoWork_SendReportedState_continue_processing_succeed)
+{
+    //arrange
+    IOTHUB_CLIENT_CORE_LL_HANDLE h = IoTHubClientCore_LL_Create(&TEST_CONFIG);
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SendReportedState(h, TEST_REPORTED_STATE, TEST_REPORTED_SIZE, iothub_reported_state_callback, NULL);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*_DoWork will ask "what's the time"*/
+        .IgnoreArgument_tick_counter()
+        .IgnoreArgument_current_ms();
+
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_ProcessItem(IGNORED_PTR_ARG, IOTHUB_TYPE_DEVICE_TWIN, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument_item_type()
+        .IgnoreArgument(3)
+        .SetReturn(IOTHUB_PROCESS_CONTINUE);
+
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_DoWork(IGNORED_PTR_ARG));
+
+    //act
+    IoTHubClientCore_LL_DoWork(h);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    IoTHubClientCore_LL_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_SetDeviceMethodCallback_with_NULL_iotHubClientHandle_fails)
+{
+    ///arrange
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SetDeviceMethodCallback(NULL, deviceMethodCallback, (void*)1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_SetDeviceMethodCallback_with_NULL_callback_Unsubscribe_and_succeeds)
+{
+    ///arrange
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClientCore_LL_SetDeviceMethodCallback(handle, deviceMethodCallback, (void*)1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_Unsubscribe_DeviceMethod(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    ///act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SetDeviceMethodCallback(handle, NULL, (void*)1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    IoTHubClientCore_LL_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_SetDeviceMethodCallback_with_NULL_callback_Unsubscribe_After_SetDeviceMethodCallback_Ex_fail)
+{
+    ///arrange
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
+    (void)IoTHubClientCore_LL_SetDeviceMethodCallback_Ex(handle, iothub_client_inbound_device_method_callback, (void*)1);
+    umock_c_reset_all_calls();
 
     ///act
     IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SetDeviceMethodCallback(handle, NULL, (void*)1);
@@ -5035,6 +5588,202 @@ TEST_FUNCTION(IoTHubClientCore_LL_SetDeviceTwinCallback_subscribe_fail)
     IoTHubClientCore_LL_Destroy(h);
 }
 
+static IOTHUB_CLIENT_CORE_LL_HANDLE create_with_twin_cache(void)
+{
+    bool enable = true;
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SetOption(handle, OPTION_TWIN_CACHE, &enable);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    return handle;
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_SetOption_twin_cache_subscribes_to_the_twin)
+{
+    //arrange
+    bool enable = true;
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(twin_cache_create());
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_Subscribe_DeviceTwin(IGNORED_PTR_ARG));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SetOption(handle, OPTION_TWIN_CACHE, &enable);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClientCore_LL_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_SetOption_twin_cache_fails_when_the_subscription_fails)
+{
+    //arrange
+    bool enable = true;
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = IoTHubClientCore_LL_Create(&TEST_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(twin_cache_create());
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_Subscribe_DeviceTwin(IGNORED_PTR_ARG))
+        .SetReturn(MU_FAILURE);
+    STRICT_EXPECTED_CALL(twin_cache_destroy(TEST_TWIN_CACHE_HANDLE));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SetOption(handle, OPTION_TWIN_CACHE, &enable);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClientCore_LL_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_SetDeviceTwinCallback_NULL_with_twin_cache_keeps_the_subscription)
+{
+    //arrange
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = create_with_twin_cache();
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SetDeviceTwinCallback(handle, iothub_device_twin_callback, NULL);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(twin_cache_update(TEST_TWIN_CACHE_HANDLE, DEVICE_TWIN_UPDATE_COMPLETE, TEST_REPORTED_STATE, TEST_REPORTED_SIZE));
+
+    //act
+    result = IoTHubClientCore_LL_SetDeviceTwinCallback(handle, NULL, NULL);
+    g_transport_cb_info.twin_retrieve_prop_complete_cb(DEVICE_TWIN_UPDATE_COMPLETE, TEST_REPORTED_STATE, TEST_REPORTED_SIZE, handle);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClientCore_LL_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_RetrievePropertyComplete_with_twin_cache_updates_the_cache_before_the_callback)
+{
+    //arrange
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = create_with_twin_cache();
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SetDeviceTwinCallback(handle, iothub_device_twin_callback, NULL);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(twin_cache_update(TEST_TWIN_CACHE_HANDLE, DEVICE_TWIN_UPDATE_COMPLETE, TEST_REPORTED_STATE, TEST_REPORTED_SIZE));
+    STRICT_EXPECTED_CALL(iothub_device_twin_callback(DEVICE_TWIN_UPDATE_COMPLETE, TEST_REPORTED_STATE, TEST_REPORTED_SIZE, NULL));
+
+    //act
+    g_transport_cb_info.twin_retrieve_prop_complete_cb(DEVICE_TWIN_UPDATE_COMPLETE, TEST_REPORTED_STATE, TEST_REPORTED_SIZE, handle);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClientCore_LL_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_RetrievePropertyComplete_with_twin_cache_refetches_the_twin_on_a_version_gap)
+{
+    //arrange
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = create_with_twin_cache();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(twin_cache_update(TEST_TWIN_CACHE_HANDLE, DEVICE_TWIN_UPDATE_PARTIAL, TEST_REPORTED_STATE, TEST_REPORTED_SIZE))
+        .SetReturn(TWIN_CACHE_UPDATE_VERSION_GAP);
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_GetTwinAsync(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(twin_cache_update(TEST_TWIN_CACHE_HANDLE, DEVICE_TWIN_UPDATE_COMPLETE, TEST_REPORTED_STATE, TEST_REPORTED_SIZE));
+
+    //act
+    g_transport_cb_info.twin_retrieve_prop_complete_cb(DEVICE_TWIN_UPDATE_PARTIAL, TEST_REPORTED_STATE, TEST_REPORTED_SIZE, handle);
+    ASSERT_IS_NOT_NULL(my_FAKE_IoTHubTransport_GetTwinAsync_completionCallback);
+    my_FAKE_IoTHubTransport_GetTwinAsync_completionCallback(DEVICE_TWIN_UPDATE_COMPLETE, TEST_REPORTED_STATE, TEST_REPORTED_SIZE, my_FAKE_IoTHubTransport_GetTwinAsync_callbackContext);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClientCore_LL_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_RetrievePropertyComplete_with_twin_cache_requests_the_twin_once_while_a_refetch_is_pending)
+{
+    //arrange
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = create_with_twin_cache();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(twin_cache_update(TEST_TWIN_CACHE_HANDLE, DEVICE_TWIN_UPDATE_PARTIAL, TEST_REPORTED_STATE, TEST_REPORTED_SIZE))
+        .SetReturn(TWIN_CACHE_UPDATE_VERSION_GAP);
+    STRICT_EXPECTED_CALL(FAKE_IoTHubTransport_GetTwinAsync(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(twin_cache_update(TEST_TWIN_CACHE_HANDLE, DEVICE_TWIN_UPDATE_PARTIAL, TEST_REPORTED_STATE, TEST_REPORTED_SIZE))
+        .SetReturn(TWIN_CACHE_UPDATE_VERSION_GAP);
+
+    //act
+    g_transport_cb_info.twin_retrieve_prop_complete_cb(DEVICE_TWIN_UPDATE_PARTIAL, TEST_REPORTED_STATE, TEST_REPORTED_SIZE, handle);
+    g_transport_cb_info.twin_retrieve_prop_complete_cb(DEVICE_TWIN_UPDATE_PARTIAL, TEST_REPORTED_STATE, TEST_REPORTED_SIZE, handle);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClientCore_LL_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_ReportedStateComplete_with_twin_cache_merges_the_reported_properties)
+{
+    //arrange
+    CONSTBUFFER reportData;
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = create_with_twin_cache();
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SendReportedState(handle, TEST_REPORTED_STATE, TEST_REPORTED_SIZE, iothub_reported_state_callback, NULL);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    IoTHubClientCore_LL_DoWork(handle);
+    umock_c_reset_all_calls();
+
+    reportData.buffer = TEST_REPORTED_STATE;
+    reportData.size = TEST_REPORTED_SIZE;
+    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(IGNORED_PTR_ARG))
+        .SetReturn(&reportData);
+    STRICT_EXPECTED_CALL(twin_cache_apply_reported(TEST_TWIN_CACHE_HANDLE, TEST_REPORTED_STATE, TEST_REPORTED_SIZE));
+    STRICT_EXPECTED_CALL(iothub_reported_state_callback(TEST_DEVICE_STATUS_CODE, NULL));
+    STRICT_EXPECTED_CALL(DList_RemoveEntryList(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_DecRef(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    //act
+    g_transport_cb_info.twin_rpt_state_complete_cb(2, TEST_DEVICE_STATUS_CODE, handle);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClientCore_LL_Destroy(handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_LL_ReportedStateComplete_with_twin_cache_ignores_rejected_reports)
+{
+    //arrange
+    IOTHUB_CLIENT_CORE_LL_HANDLE handle = create_with_twin_cache();
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_LL_SendReportedState(handle, TEST_REPORTED_STATE, TEST_REPORTED_SIZE, iothub_reported_state_callback, NULL);
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    IoTHubClientCore_LL_DoWork(handle);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(iothub_reported_state_callback(400, NULL));
+    STRICT_EXPECTED_CALL(DList_RemoveEntryList(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_DecRef(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    //act
+    g_transport_cb_info.twin_rpt_state_complete_cb(2, 400, handle);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubClientCore_LL_Destroy(handle);
+}
+
 TEST_FUNCTION(IoTHubClientCore_LL_GetTwinAsync_succeed)
 {
     //arrange
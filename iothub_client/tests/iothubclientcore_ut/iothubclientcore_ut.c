@@ -66,6 +66,7 @@ void* my_gballoc_realloc(void* ptr, size_t size)
 #include "azure_c_shared_utility/agenttime.h"
 #include "iothub_client_core_ll.h"
 #include "internal/iothubtransport.h"
+#include "internal/iothub_client_callback_queue.h"
 
 #undef ENABLE_MOCKS
 
@@ -221,6 +222,7 @@ static IOTHUB_CLIENT_DEVICE_CONFIG* TEST_CLIENT_DEVICE_CONFIG = (IOTHUB_CLIENT_D
 static METHOD_HANDLE TEST_METHOD_ID = (METHOD_HANDLE)0x111B;
 static STRING_HANDLE TEST_STRING_HANDLE = (STRING_HANDLE)0x111C;
 static BUFFER_HANDLE TEST_BUFFER_HANDLE = (BUFFER_HANDLE)0x111D;
+static CALLBACK_QUEUE_HANDLE TEST_CALLBACK_QUEUE_HANDLE = (CALLBACK_QUEUE_HANDLE)0x111F;
 
 static const char* TEST_CONNECTION_STRING = "Test_connection_string";
 static const char* TEST_DEVICE_ID = "theidofTheDevice";
@@ -545,6 +547,10 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_CALLBACK, void*);
     REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_FILE_UPLOAD_GET_DATA_CALLBACK_EX, void*);
     REGISTER_UMOCK_ALIAS_TYPE(THREADAPI_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(CALLBACK_QUEUE_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(CALLBACK_QUEUE_DISPATCH, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(CALLBACK_QUEUE_PUSH_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_CLIENT_CALLBACK_QUEUE_OVERFLOW, int);
 
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
@@ -568,6 +574,8 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubClientCore_LL_GetLastMessageReceiveTime, IOTHUB_CLIENT_ERROR);
     REGISTER_GLOBAL_MOCK_RETURN(IoTHubClientCore_LL_SetOption, IOTHUB_CLIENT_OK);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubClientCore_LL_SetOption, IOTHUB_CLIENT_ERROR);
+    REGISTER_GLOBAL_MOCK_RETURN(IoTHubClientCore_LL_GetMetrics, IOTHUB_CLIENT_OK);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubClientCore_LL_GetMetrics, IOTHUB_CLIENT_ERROR);
     REGISTER_GLOBAL_MOCK_HOOK(IoTHubClientCore_LL_SetMessageCallback_Ex, my_IoTHubClientCore_LL_SetMessageCallback_Ex);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubClientCore_LL_SetMessageCallback_Ex, IOTHUB_CLIENT_ERROR);
     REGISTER_GLOBAL_MOCK_HOOK(IoTHubClientCore_LL_SetConnectionStatusCallback, my_IoTHubClient_LL_SetConnectionStatusCallback);
@@ -653,6 +661,16 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_HOOK(VECTOR_destroy, real_VECTOR_destroy);
     REGISTER_GLOBAL_MOCK_HOOK(VECTOR_size, real_VECTOR_size);
 
+    REGISTER_GLOBAL_MOCK_RETURN(callback_queue_create, TEST_CALLBACK_QUEUE_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(callback_queue_create, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(callback_queue_push, CALLBACK_QUEUE_PUSH_OK);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(callback_queue_push, CALLBACK_QUEUE_PUSH_ERROR);
+    REGISTER_GLOBAL_MOCK_RETURN(callback_queue_set_overflow, 0);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(callback_queue_set_overflow, MU_FAILURE);
+    REGISTER_GLOBAL_MOCK_RETURN(callback_queue_wait_for_room, true);
+    REGISTER_GLOBAL_MOCK_RETURN(callback_queue_get_statistics, 0);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(callback_queue_get_statistics, MU_FAILURE);
+
     REGISTER_GLOBAL_MOCK_RETURN(singlylinkedlist_create, TEST_SLL_HANDLE);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(singlylinkedlist_create, NULL);
     REGISTER_GLOBAL_MOCK_RETURN(singlylinkedlist_get_head_item, NULL);
@@ -1313,6 +1331,43 @@ TEST_FUNCTION(IoTHubClientCore_Destroy_succeed)
     // cleanup
 }
 
+TEST_FUNCTION(IoTHubClientCore_Destroy_detaches_callback_queue_under_lock_succeed)
+{
+    // arrange
+    size_t depth = 8;
+    IOTHUB_CLIENT_CORE_HANDLE iothub_handle = IoTHubClientCore_Create(TEST_CLIENT_CONFIG);
+    (void)IoTHubClientCore_SetOption(iothub_handle, "callback_queue_depth", &depth);
+    umock_c_reset_all_calls();
+
+    // signal threads to end
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+
+    // the queue is detached under the lock and destroyed outside of it
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(callback_queue_destroy(TEST_CALLBACK_QUEUE_HANDLE));
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+
+    // garbage collection
+    EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SLL_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SLL_HANDLE));
+    STRICT_EXPECTED_CALL(IoTHubClientCore_LL_Destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(VECTOR_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock_Deinit(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG) );
+
+    // act
+    IoTHubClientCore_Destroy(iothub_handle);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+}
+
 TEST_FUNCTION(IoTHubClientCore_Destroy_calls_IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK_succeed)
 {
     // arrange
@@ -2180,6 +2235,200 @@ TEST_FUNCTION(IoTHubClientCore_SetOption_DO_WORK_FREQUENCY_IN_MS_and_MESSAGE_TIM
     IoTHubClientCore_Destroy(iothub_handle);
 }
 
+TEST_FUNCTION(IoTHubClientCore_SetOption_CALLBACK_QUEUE_DEPTH_succeed)
+{
+    // arrange
+    IOTHUB_CLIENT_CORE_HANDLE iothub_handle = IoTHubClientCore_Create(TEST_CLIENT_CONFIG);
+    umock_c_reset_all_calls();
+
+    size_t depth = 8;
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(callback_queue_create(IGNORED_NUM_ARG, depth, IOTHUB_CLIENT_CALLBACK_QUEUE_BLOCK, IGNORED_PTR_ARG, iothub_handle));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_SetOption(iothub_handle, "callback_queue_depth", &depth);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClientCore_Destroy(iothub_handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_SetOption_CALLBACK_QUEUE_DEPTH_twice_fail)
+{
+    // arrange
+    size_t depth = 8;
+    IOTHUB_CLIENT_CORE_HANDLE iothub_handle = IoTHubClientCore_Create(TEST_CLIENT_CONFIG);
+    (void)IoTHubClientCore_SetOption(iothub_handle, "callback_queue_depth", &depth);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_SetOption(iothub_handle, "callback_queue_depth", &depth);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClientCore_Destroy(iothub_handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_SetOption_CALLBACK_QUEUE_OVERFLOW_shared_transport_rejects_instead_of_blocking)
+{
+    // arrange
+    size_t depth = 8;
+    IOTHUB_CLIENT_CALLBACK_QUEUE_OVERFLOW overflow = IOTHUB_CLIENT_CALLBACK_QUEUE_BLOCK;
+    IOTHUB_CLIENT_CONFIG client_config;
+    client_config.deviceId = TEST_DEVICE_ID;
+    client_config.deviceKey = TEST_DEVICE_KEY;
+    client_config.deviceSasToken = TEST_DEVICE_SAS;
+    client_config.protocol = TEST_TRANSPORT_PROVIDER;
+    IOTHUB_CLIENT_CORE_HANDLE iothub_handle = IoTHubClientCore_CreateWithTransport(TEST_TRANSPORT_HANDLE, &client_config);
+    (void)IoTHubClientCore_SetOption(iothub_handle, "callback_queue_depth", &depth);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(callback_queue_set_overflow(TEST_CALLBACK_QUEUE_HANDLE, IOTHUB_CLIENT_CALLBACK_QUEUE_REJECT));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_SetOption(iothub_handle, "callback_queue_overflow", &overflow);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClientCore_Destroy(iothub_handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_SetOption_CALLBACK_QUEUE_OVERFLOW_invalid_value_fail)
+{
+    // arrange
+    int overflow = 42;
+    IOTHUB_CLIENT_CORE_HANDLE iothub_handle = IoTHubClientCore_Create(TEST_CLIENT_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_SetOption(iothub_handle, "callback_queue_overflow", &overflow);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClientCore_Destroy(iothub_handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_message_callback_rejected_by_full_callback_queue_fails)
+{
+    // arrange
+    size_t depth = 1;
+    IOTHUB_CLIENT_CORE_HANDLE iothub_handle = IoTHubClientCore_Create(TEST_CLIENT_CONFIG);
+    (void)IoTHubClientCore_SetOption(iothub_handle, "callback_queue_depth", &depth);
+    (void)IoTHubClientCore_SetMessageCallback(iothub_handle, test_message_confirmation_callback, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(callback_queue_push(TEST_CALLBACK_QUEUE_HANDLE, IGNORED_PTR_ARG, true)).SetReturn(CALLBACK_QUEUE_PUSH_REJECTED);
+
+    // act
+    bool result = g_messageCallback_ex(TEST_MESSAGE_HANDLE, g_userContextCallback);
+
+    // assert
+    ASSERT_IS_FALSE(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClientCore_Destroy(iothub_handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_GetCallbackQueueStatistics_without_callback_queue_returns_zeros)
+{
+    // arrange
+    IOTHUB_CLIENT_CALLBACK_QUEUE_STATISTICS statistics;
+    IOTHUB_CLIENT_CORE_HANDLE iothub_handle = IoTHubClientCore_Create(TEST_CLIENT_CONFIG);
+    umock_c_reset_all_calls();
+    statistics.depth = 1;
+    statistics.callbacksQueued = 1;
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_GetCallbackQueueStatistics(iothub_handle, &statistics);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(size_t, 0, statistics.depth);
+    ASSERT_ARE_EQUAL(size_t, 0, statistics.callbacksQueued);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClientCore_Destroy(iothub_handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_GetCallbackQueueStatistics_NULL_statistics_fail)
+{
+    // arrange
+    IOTHUB_CLIENT_CORE_HANDLE iothub_handle = IoTHubClientCore_Create(TEST_CLIENT_CONFIG);
+    umock_c_reset_all_calls();
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_GetCallbackQueueStatistics(iothub_handle, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClientCore_Destroy(iothub_handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_GetMetrics_succeed)
+{
+    // arrange
+    IOTHUB_CLIENT_METRICS metrics;
+    IOTHUB_CLIENT_CORE_HANDLE iothub_handle = IoTHubClientCore_Create(TEST_CLIENT_CONFIG);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(IoTHubClientCore_LL_GetMetrics(TEST_IOTHUB_CLIENT_CORE_LL_HANDLE, &metrics));
+    STRICT_EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_GetMetrics(iothub_handle, &metrics);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    IoTHubClientCore_Destroy(iothub_handle);
+}
+
+TEST_FUNCTION(IoTHubClientCore_GetMetrics_client_handle_NULL_fail)
+{
+    // arrange
+    IOTHUB_CLIENT_METRICS metrics;
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IoTHubClientCore_GetMetrics(NULL, &metrics);
+
+    // assert
+    ASSERT_ARE_EQUAL(IOTHUB_CLIENT_RESULT, IOTHUB_CLIENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
 TEST_FUNCTION(IoTHubClient_ScheduleWork_Thread_DO_WORK_FREQ_IN_MS_success)
 {
     
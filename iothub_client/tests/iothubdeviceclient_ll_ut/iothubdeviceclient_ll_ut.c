@@ -111,6 +111,8 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_RETURN(IoTHubClientCore_LL_CreateFromDeviceAuth, TEST_IOTHUB_CLIENT_CORE_LL_HANDLE);
     REGISTER_GLOBAL_MOCK_RETURN(IoTHubClientCore_LL_SendEventAsync, IOTHUB_CLIENT_OK);
     REGISTER_GLOBAL_MOCK_RETURN(IoTHubClientCore_LL_GetSendStatus, IOTHUB_CLIENT_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(IoTHubClientCore_LL_GetMetrics, IOTHUB_CLIENT_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(IoTHubClientCore_LL_GetPollInfo, IOTHUB_CLIENT_OK);
     REGISTER_GLOBAL_MOCK_RETURN(IoTHubClientCore_LL_SetMessageCallback, IOTHUB_CLIENT_OK);
     REGISTER_GLOBAL_MOCK_RETURN(IoTHubClientCore_LL_SetConnectionStatusCallback, IOTHUB_CLIENT_OK);
     REGISTER_GLOBAL_MOCK_RETURN(IoTHubClientCore_LL_SetRetryPolicy, IOTHUB_CLIENT_OK);
@@ -233,6 +235,34 @@ TEST_FUNCTION(IoTHubDeviceClient_LL_GetSendStatus_Test)
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
+TEST_FUNCTION(IoTHubDeviceClient_LL_GetMetrics_Test)
+{
+    //arrange
+    IOTHUB_CLIENT_METRICS metrics;
+    STRICT_EXPECTED_CALL(IoTHubClientCore_LL_GetMetrics(TEST_IOTHUB_CLIENT_CORE_LL_HANDLE, &metrics));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubDeviceClient_LL_GetMetrics(TEST_IOTHUB_DEVICE_CLIENT_LL_HANDLE, &metrics);
+
+    //assert
+    ASSERT_IS_TRUE(result == IOTHUB_CLIENT_OK);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(IoTHubDeviceClient_LL_GetPollInfo_Test)
+{
+    //arrange
+    IOTHUB_CLIENT_POLL_INFO pollInfo;
+    STRICT_EXPECTED_CALL(IoTHubClientCore_LL_GetPollInfo(TEST_IOTHUB_CLIENT_CORE_LL_HANDLE, &pollInfo));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubDeviceClient_LL_GetPollInfo(TEST_IOTHUB_DEVICE_CLIENT_LL_HANDLE, &pollInfo);
+
+    //assert
+    ASSERT_IS_TRUE(result == IOTHUB_CLIENT_OK);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
 TEST_FUNCTION(IoTHubDeviceClient_LL_SetMessageCallback_Test)
 {
     //arrange
@@ -122,6 +122,8 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_RETURN(IoTHubClientCore_SubscribeToCommands, IOTHUB_CLIENT_OK);
     REGISTER_GLOBAL_MOCK_RETURN(IoTHubClientCore_DeviceMethodResponse, IOTHUB_CLIENT_OK);
     REGISTER_GLOBAL_MOCK_RETURN(IoTHubClientCore_GetTwinAsync, IOTHUB_CLIENT_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(IoTHubClientCore_GetCallbackQueueStatistics, IOTHUB_CLIENT_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(IoTHubClientCore_GetMetrics, IOTHUB_CLIENT_OK);
 #ifndef DONT_USE_UPLOADTOBLOB
     REGISTER_GLOBAL_MOCK_RETURN(IoTHubClientCore_UploadToBlobAsync, IOTHUB_CLIENT_OK);
     REGISTER_GLOBAL_MOCK_RETURN(IoTHubClientCore_UploadMultipleBlocksToBlobAsync, IOTHUB_CLIENT_OK);
@@ -486,4 +488,32 @@ TEST_FUNCTION(IoTHubDeviceClient_GetPropertiesAndSubscribeToUpdatesAsync_Test)
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
+TEST_FUNCTION(IoTHubDeviceClient_GetCallbackQueueStatistics_Test)
+{
+    //arrange
+    IOTHUB_CLIENT_CALLBACK_QUEUE_STATISTICS statistics;
+    STRICT_EXPECTED_CALL(IoTHubClientCore_GetCallbackQueueStatistics(TEST_IOTHUB_CLIENT_CORE_HANDLE, &statistics));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubDeviceClient_GetCallbackQueueStatistics(TEST_IOTHUB_DEVICE_CLIENT_HANDLE, &statistics);
+
+    //assert
+    ASSERT_IS_TRUE(result == IOTHUB_CLIENT_OK);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(IoTHubDeviceClient_GetMetrics_Test)
+{
+    //arrange
+    IOTHUB_CLIENT_METRICS metrics;
+    STRICT_EXPECTED_CALL(IoTHubClientCore_GetMetrics(TEST_IOTHUB_CLIENT_CORE_HANDLE, &metrics));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubDeviceClient_GetMetrics(TEST_IOTHUB_DEVICE_CLIENT_HANDLE, &metrics);
+
+    //assert
+    ASSERT_IS_TRUE(result == IOTHUB_CLIENT_OK);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
 END_TEST_SUITE(iothubdeviceclient_ut)
\ No newline at end of file
@@ -5,10 +5,12 @@
 #include <cstdlib>
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
 #else
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 #endif
 
 #include "testrunnerswitcher.h"
@@ -22,6 +24,11 @@ static void* my_gballoc_malloc(size_t size)
     return malloc(size);
 }
 
+static void* my_gballoc_realloc(void* ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
 static void my_gballoc_free(void* ptr)
 {
     free(ptr);
@@ -83,6 +90,7 @@ static const char* TEST_CONNECTION_MODULE_ID2 = "connectionmoduleid2";
 static const char* TEST_COMPONENT_NAME = "testComponentName";
 static const char* TEST_PROPERTY_KEY = "property_key";
 static const char* TEST_PROPERTY_VALUE = "property_value";
+static const BUFFER_HANDLE TEST_BUFFER_HANDLE = (BUFFER_HANDLE)0x4242;
 static const char* TEST_NON_ASCII_PROPERTY_KEY = "\x01property_key";
 static const char* TEST_NON_ASCII_PROPERTY_VALUE = "\x01property_value";
 
@@ -283,6 +291,8 @@ TEST_SUITE_INITIALIZE(suite_init)
 
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_realloc, NULL);
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
 
     REGISTER_GLOBAL_MOCK_HOOK(BUFFER_new, real_BUFFER_new);
@@ -345,7 +355,6 @@ TEST_FUNCTION(IoTHubMessage_CreateFromByteArray_happy_path)
     // arrange
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(BUFFER_create(c, 1));
-    STRICT_EXPECTED_CALL(Map_Create(IGNORED_PTR_ARG));
 
     //act
     IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
@@ -378,7 +387,6 @@ TEST_FUNCTION(IoTHubMessage_CreateFromByteArray_succeeds_when_size_0_and_buffer_
     // arrange
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(BUFFER_create(IGNORED_PTR_ARG, 0)).IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(Map_Create(IGNORED_PTR_ARG));
 
     //act
     IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(NULL, 0);
@@ -396,7 +404,6 @@ TEST_FUNCTION(IoTHubMessage_CreateFromByteArray_succeeds_when_size_0_and_buffer_
     //arrange
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(BUFFER_create(IGNORED_PTR_ARG, 0)).IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(Map_Create(IGNORED_PTR_ARG));
 
     //act
     IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 0);
@@ -417,7 +424,6 @@ TEST_FUNCTION(IoTHubMessage_CreateFromByteArray_fails)
     // arrange
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(BUFFER_create(c, 1));
-    STRICT_EXPECTED_CALL(Map_Create(IGNORED_PTR_ARG));
 
     umock_c_negative_tests_snapshot();
 
@@ -446,7 +452,6 @@ TEST_FUNCTION(IoTHubMessage_CreateFromString_happy_path)
     //arrange
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(STRING_construct("a"));
-    STRICT_EXPECTED_CALL(Map_Create(IGNORED_PTR_ARG));
 
     //act
     IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromString("a");
@@ -483,7 +488,6 @@ TEST_FUNCTION(IoTHubMessage_CreateFromString_fails)
     // arrange
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(STRING_construct("a"));
-    STRICT_EXPECTED_CALL(Map_Create(IGNORED_PTR_ARG));
 
     umock_c_negative_tests_snapshot();
 
@@ -511,6 +515,7 @@ TEST_FUNCTION(IoTHubMessage_Map_Filter_validate_Ascii_char_SUCCEED)
 {
     //arrange
     IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromString(TEST_STRING_VALUE);
+    (void)IoTHubMessage_Properties(h);
     umock_c_reset_all_calls();
 
     //act
@@ -528,6 +533,7 @@ TEST_FUNCTION(IoTHubMessage_Map_Filter_invalidate_Ascii_key_fail)
 {
     //arrange
     IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromString(TEST_STRING_VALUE);
+    (void)IoTHubMessage_Properties(h);
     umock_c_reset_all_calls();
 
     //act
@@ -545,6 +551,7 @@ TEST_FUNCTION(IoTHubMessage_Map_Filter_invalidate_Ascii_value_fail)
 {
     //arrange
     IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromString(TEST_STRING_VALUE);
+    (void)IoTHubMessage_Properties(h);
     umock_c_reset_all_calls();
 
     //act
@@ -578,7 +585,6 @@ TEST_FUNCTION(IoTHubMessage_Destroy_destroys_a_BYTEARRAY_IoTHubMEssage)
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(Map_Destroy(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
@@ -609,7 +615,6 @@ TEST_FUNCTION(IoTHubMessage_Destroy_destroys_a_STRING_IoTHubMessage)
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(Map_Destroy(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
@@ -718,7 +723,6 @@ TEST_FUNCTION(IoTHubMessage_Clone_with_BYTE_ARRAY_happy_path)
 
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(BUFFER_clone(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(Map_Clone(IGNORED_PTR_ARG));
 
     //act
     IOTHUB_MESSAGE_HANDLE r = IoTHubMessage_Clone(h);
@@ -758,7 +762,6 @@ TEST_FUNCTION(IoTHubMessage_Clone_with_BYTE_ARRAY_fails)
 
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(BUFFER_clone(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(Map_Clone(IGNORED_PTR_ARG));
 
     umock_c_negative_tests_snapshot();
 
@@ -791,7 +794,6 @@ TEST_FUNCTION(IoTHubMessage_Clone_with_STRING_happy_path)
 
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(STRING_clone(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(Map_Clone(IGNORED_PTR_ARG));
 
     ///act
     IOTHUB_MESSAGE_HANDLE r = IoTHubMessage_Clone(h);
@@ -816,7 +818,6 @@ TEST_FUNCTION(IoTHubMessage_Clone_with_STRING_fails)
 
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(STRING_clone(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(Map_Clone(IGNORED_PTR_ARG));
 
     umock_c_negative_tests_snapshot();
 
@@ -847,6 +848,8 @@ TEST_FUNCTION(IoTHubMessage_Properties_happy_path)
     IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromString(TEST_STRING_VALUE);
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(Map_Create(IGNORED_PTR_ARG));
+
     //act
     MAP_HANDLE r = IoTHubMessage_Properties(h);
 
@@ -1581,56 +1584,39 @@ TEST_FUNCTION(IoTHubMessage_SetDiagnosticPropertyData_DiagnosticData_Not_NULL_SU
     (void)IoTHubMessage_SetDiagnosticPropertyData(h, &TEST_DIAGNOSTIC_DATA);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-
     //act
     IOTHUB_MESSAGE_RESULT result = IoTHubMessage_SetDiagnosticPropertyData(h, &TEST_DIAGNOSTIC_DATA2);
 
     //assert
     ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(char_ptr, TEST_DIAGNOSTIC_DATA2.diagnosticId, IoTHubMessage_GetDiagnosticPropertyData(h)->diagnosticId);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_DIAGNOSTIC_DATA2.diagnosticCreationTimeUtc, IoTHubMessage_GetDiagnosticPropertyData(h)->diagnosticCreationTimeUtc);
 
     //cleanup
     IoTHubMessage_Destroy(h);
 }
 
-TEST_FUNCTION(IoTHubMessage_SetDiagnosticPropertyData_Fails)
+TEST_FUNCTION(IoTHubMessage_SetDiagnosticPropertyData_too_long_Fails)
 {
-    // arrange
-    ASSERT_ARE_EQUAL(int, 0, umock_c_negative_tests_init());
-
+    //arrange
+    IOTHUB_MESSAGE_DIAGNOSTIC_PROPERTY_DATA longId = { "0123456789abcdef", "1506054179" };
+    IOTHUB_MESSAGE_DIAGNOSTIC_PROPERTY_DATA longCreationTime = { "12345678", "1506054179.1234567890123" };
     IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
-
+    (void)IoTHubMessage_SetDiagnosticPropertyData(h, &TEST_DIAGNOSTIC_DATA);
     umock_c_reset_all_calls();
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    umock_c_negative_tests_snapshot();
 
     //act
-    size_t count = umock_c_negative_tests_call_count();
-    for (size_t index = 0; index < count; index++)
-    {
-        umock_c_negative_tests_reset();
-        umock_c_negative_tests_fail_call(index);
-
-        char tmp_msg[128];
-        sprintf(tmp_msg, "Failed in test %lu/%lu", (unsigned long)index, (unsigned long)count);
-
-        //act
-        IOTHUB_MESSAGE_RESULT result = IoTHubMessage_SetDiagnosticPropertyData(h, &TEST_DIAGNOSTIC_DATA);
+    IOTHUB_MESSAGE_RESULT result1 = IoTHubMessage_SetDiagnosticPropertyData(h, &longId);
+    IOTHUB_MESSAGE_RESULT result2 = IoTHubMessage_SetDiagnosticPropertyData(h, &longCreationTime);
 
-        //assert
-        ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_ERROR, result, tmp_msg);
-    }
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_INVALID_ARG, result1);
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_INVALID_ARG, result2);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(char_ptr, TEST_DIAGNOSTIC_DATA.diagnosticId, IoTHubMessage_GetDiagnosticPropertyData(h)->diagnosticId);
 
     //cleanup
-    umock_c_negative_tests_deinit();
     IoTHubMessage_Destroy(h);
 }
 
@@ -1640,10 +1626,6 @@ TEST_FUNCTION(IoTHubMessage_SetDiagnosticPropertyData_SUCCEED)
     IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-
     //act
     IOTHUB_MESSAGE_RESULT result = IoTHubMessage_SetDiagnosticPropertyData(h, &TEST_DIAGNOSTIC_DATA);
 
@@ -1709,8 +1691,6 @@ TEST_FUNCTION(IoTHubMessage_SetProperty_key_Non_Ascii_Fail)
     IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG)).SetReturn(MAP_FILTER_REJECT);
-
     //act
     IOTHUB_MESSAGE_RESULT result = IoTHubMessage_SetProperty(h, TEST_NON_ASCII_PROPERTY_KEY, TEST_PROPERTY_VALUE);
 
@@ -1728,8 +1708,6 @@ TEST_FUNCTION(IoTHubMessage_SetProperty_value_Non_Ascii_Fail)
     IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG)).SetReturn(MAP_FILTER_REJECT);
-
     //act
     IOTHUB_MESSAGE_RESULT result = IoTHubMessage_SetProperty(h, TEST_PROPERTY_KEY, TEST_NON_ASCII_PROPERTY_VALUE);
 
@@ -1747,17 +1725,34 @@ TEST_FUNCTION(IoTHubMessage_SetProperty_Fail)
     IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG)).SetReturn(MAP_ERROR);
+    int negativeTestsInitResult = umock_c_negative_tests_init();
+    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    umock_c_negative_tests_snapshot();
 
     //act
-    IOTHUB_MESSAGE_RESULT result = IoTHubMessage_SetProperty(h, TEST_PROPERTY_KEY, TEST_PROPERTY_VALUE);
+    size_t count = umock_c_negative_tests_call_count();
+    for (size_t index = 0; index < count; index++)
+    {
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(index);
 
-    //assert
-    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_ERROR, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        char tmp_msg[128];
+        sprintf(tmp_msg, "IoTHubMessage_SetProperty failure in test %lu/%lu", (unsigned long)index, (unsigned long)count);
+
+        IOTHUB_MESSAGE_RESULT result = IoTHubMessage_SetProperty(h, TEST_PROPERTY_KEY, TEST_PROPERTY_VALUE);
+
+        //assert
+        ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_ERROR, result, tmp_msg);
+        ASSERT_IS_NULL(IoTHubMessage_GetProperty(h, TEST_PROPERTY_KEY), tmp_msg);
+    }
 
     //cleanup
     IoTHubMessage_Destroy(h);
+    umock_c_negative_tests_deinit();
 }
 
 TEST_FUNCTION(IoTHubMessage_SetProperty_Succeed)
@@ -1766,7 +1761,8 @@ TEST_FUNCTION(IoTHubMessage_SetProperty_Succeed)
     IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
 
     //act
     IOTHUB_MESSAGE_RESULT result = IoTHubMessage_SetProperty(h, TEST_PROPERTY_KEY, TEST_PROPERTY_VALUE);
@@ -1779,200 +1775,805 @@ TEST_FUNCTION(IoTHubMessage_SetProperty_Succeed)
     IoTHubMessage_Destroy(h);
 }
 
-TEST_FUNCTION(IoTHubMessage_GetProperty_handle_NULL_Fail)
+TEST_FUNCTION(IoTHubMessage_SetProperty_second_property_does_not_allocate_Succeed)
 {
     //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    (void)IoTHubMessage_SetProperty(h, TEST_VALID_MAP_KEY, TEST_VALID_MAP_VALUE);
+    umock_c_reset_all_calls();
 
     //act
-    const char* result = IoTHubMessage_GetProperty(NULL, TEST_PROPERTY_KEY);
+    IOTHUB_MESSAGE_RESULT result = IoTHubMessage_SetProperty(h, TEST_PROPERTY_KEY, TEST_PROPERTY_VALUE);
 
     //assert
-    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(char_ptr, TEST_VALID_MAP_VALUE, IoTHubMessage_GetProperty(h, TEST_VALID_MAP_KEY));
+    ASSERT_ARE_EQUAL(char_ptr, TEST_PROPERTY_VALUE, IoTHubMessage_GetProperty(h, TEST_PROPERTY_KEY));
 
     //cleanup
+    IoTHubMessage_Destroy(h);
 }
 
-TEST_FUNCTION(IoTHubMessage_GetProperty_key_NULL_Fail)
+TEST_FUNCTION(IoTHubMessage_SetProperty_existing_key_updates_value_Succeed)
 {
     //arrange
     IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    (void)IoTHubMessage_SetProperty(h, TEST_PROPERTY_KEY, TEST_STRING_VALUE);
+    (void)IoTHubMessage_SetProperty(h, TEST_VALID_MAP_KEY, TEST_VALID_MAP_VALUE);
     umock_c_reset_all_calls();
 
     //act
-    const char* result = IoTHubMessage_GetProperty(h, NULL);
+    IOTHUB_MESSAGE_RESULT result = IoTHubMessage_SetProperty(h, TEST_PROPERTY_KEY, TEST_PROPERTY_VALUE);
 
     //assert
-    ASSERT_IS_NULL(result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    size_t count;
+    size_t cursor = 0;
+    const char* key;
+    const char* value;
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, result);
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, IoTHubMessage_GetPropertyCount(h, &count));
+    ASSERT_ARE_EQUAL(size_t, 2, count);
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, IoTHubMessage_GetNextProperty(h, &cursor, &key, &value));
+    ASSERT_ARE_EQUAL(char_ptr, TEST_PROPERTY_KEY, key);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_PROPERTY_VALUE, value);
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, IoTHubMessage_GetNextProperty(h, &cursor, &key, &value));
+    ASSERT_ARE_EQUAL(char_ptr, TEST_VALID_MAP_KEY, key);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_VALID_MAP_VALUE, value);
 
     //cleanup
     IoTHubMessage_Destroy(h);
 }
 
-TEST_FUNCTION(IoTHubMessage_GetProperty_Succeed)
+TEST_FUNCTION(IoTHubMessage_SetProperty_value_from_GetProperty_Succeed)
 {
     //arrange
     IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    (void)IoTHubMessage_SetProperty(h, TEST_PROPERTY_KEY, TEST_PROPERTY_VALUE);
     umock_c_reset_all_calls();
 
-    bool key_exist = true;
-    STRICT_EXPECTED_CALL(Map_ContainsKey(IGNORED_PTR_ARG, TEST_PROPERTY_KEY, IGNORED_PTR_ARG)).CopyOutArgumentBuffer_keyExists(&key_exist, sizeof(bool));
-    STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, TEST_PROPERTY_KEY)).SetReturn(TEST_PROPERTY_VALUE);
-
     //act
-    const char* result = IoTHubMessage_GetProperty(h, TEST_PROPERTY_KEY);
+    IOTHUB_MESSAGE_RESULT result = IoTHubMessage_SetProperty(h, TEST_VALID_MAP_KEY, IoTHubMessage_GetProperty(h, TEST_PROPERTY_KEY));
 
     //assert
-    ASSERT_IS_NOT_NULL(result);
-    ASSERT_ARE_EQUAL(char_ptr, TEST_PROPERTY_VALUE, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_PROPERTY_VALUE, IoTHubMessage_GetProperty(h, TEST_VALID_MAP_KEY));
 
     //cleanup
     IoTHubMessage_Destroy(h);
 }
 
-TEST_FUNCTION(IoTHubMessage_GetProperty_Fail)
+TEST_FUNCTION(IoTHubMessage_SetProperty_after_Properties_uses_map_Succeed)
 {
     //arrange
     IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    (void)IoTHubMessage_Properties(h);
     umock_c_reset_all_calls();
 
-    bool key_exist = false;
-    STRICT_EXPECTED_CALL(Map_ContainsKey(IGNORED_PTR_ARG, TEST_PROPERTY_KEY, IGNORED_PTR_ARG)).CopyOutArgumentBuffer_keyExists(&key_exist, sizeof(bool));
+    STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, TEST_PROPERTY_KEY, TEST_PROPERTY_VALUE));
 
     //act
-    const char* result = IoTHubMessage_GetProperty(h, TEST_PROPERTY_KEY);
+    IOTHUB_MESSAGE_RESULT result = IoTHubMessage_SetProperty(h, TEST_PROPERTY_KEY, TEST_PROPERTY_VALUE);
 
     //assert
-    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     //cleanup
     IoTHubMessage_Destroy(h);
 }
 
-TEST_FUNCTION(IoTHubMessage_SetOutputName_NULL_handle_Fails)
+TEST_FUNCTION(IoTHubMessage_SetProperty_after_Properties_Non_Ascii_Fail)
 {
-    set_string_NULL_handle_fails_impl(IoTHubMessage_SetOutputName, TEST_OUTPUT_NAME);
-}
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    (void)IoTHubMessage_Properties(h);
+    umock_c_reset_all_calls();
 
-TEST_FUNCTION(IoTHubMessage_SetOutputName_NULL_MessageId_Fails)
-{
-    set_string_NULL_string_fails_impl(IoTHubMessage_SetOutputName);
-}
+    STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG)).SetReturn(MAP_FILTER_REJECT);
 
-TEST_FUNCTION(IoTHubMessage_SetOutputName_SUCCEED)
-{
-    set_string_succeeds_impl(IoTHubMessage_SetOutputName, TEST_OUTPUT_NAME);
-}
+    //act
+    IOTHUB_MESSAGE_RESULT result = IoTHubMessage_SetProperty(h, TEST_NON_ASCII_PROPERTY_KEY, TEST_PROPERTY_VALUE);
 
-TEST_FUNCTION(IoTHubMessage_SetOutputName_OutputName_Not_NULL_SUCCEED)
-{
-    set_string_string_already_allocated_succeeds_impl(IoTHubMessage_SetOutputName, TEST_OUTPUT_NAME2);
-}
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_INVALID_TYPE, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-TEST_FUNCTION(IoTHubMessage_GetOutputName_NULL_handle_Fails)
-{
-    get_string_NULL_handle_fails_impl(IoTHubMessage_GetOutputName);
+    //cleanup
+    IoTHubMessage_Destroy(h);
 }
 
-TEST_FUNCTION(IoTHubMessage_GetOutputName_OutputName_Not_Set_Fails)
+TEST_FUNCTION(IoTHubMessage_SetProperty_after_Properties_Fail)
 {
-    get_string_not_set_fails_impl(IoTHubMessage_GetOutputName);
-}
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    (void)IoTHubMessage_Properties(h);
+    umock_c_reset_all_calls();
 
-TEST_FUNCTION(IoTHubMessage_GetOutputName_SUCCEED)
-{
-    get_string_succeeds_impl(IoTHubMessage_SetOutputName, IoTHubMessage_GetOutputName, TEST_OUTPUT_NAME);
-}
+    STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG)).SetReturn(MAP_ERROR);
 
-TEST_FUNCTION(IoTHubMessage_SetInputName_NULL_handle_Fails)
-{
-    set_string_NULL_handle_fails_impl(IoTHubMessage_SetInputName, TEST_INPUT_NAME);
-}
+    //act
+    IOTHUB_MESSAGE_RESULT result = IoTHubMessage_SetProperty(h, TEST_PROPERTY_KEY, TEST_PROPERTY_VALUE);
 
-TEST_FUNCTION(IoTHubMessage_SetInputName_NULL_MessageId_Fails)
-{
-    set_string_NULL_string_fails_impl(IoTHubMessage_SetInputName);
-}
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-TEST_FUNCTION(IoTHubMessage_SetInputName_SUCCEED)
-{
-    set_string_succeeds_impl(IoTHubMessage_SetInputName, TEST_INPUT_NAME);
+    //cleanup
+    IoTHubMessage_Destroy(h);
 }
 
-TEST_FUNCTION(IoTHubMessage_SetInputName_InputName_Not_NULL_SUCCEED)
+TEST_FUNCTION(IoTHubMessage_GetProperty_handle_NULL_Fail)
 {
-    set_string_string_already_allocated_succeeds_impl(IoTHubMessage_SetInputName, TEST_INPUT_NAME2);
-}
+    //arrange
 
-TEST_FUNCTION(IoTHubMessage_GetInputName_NULL_handle_Fails)
-{
-    get_string_NULL_handle_fails_impl(IoTHubMessage_GetInputName);
-}
+    //act
+    const char* result = IoTHubMessage_GetProperty(NULL, TEST_PROPERTY_KEY);
 
-TEST_FUNCTION(IoTHubMessage_GetInputName_InputName_Not_Set_Fails)
-{
-    get_string_not_set_fails_impl(IoTHubMessage_GetInputName);
-}
+    //assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-TEST_FUNCTION(IoTHubMessage_GetInputName_SUCCEED)
-{
-    get_string_succeeds_impl(IoTHubMessage_SetInputName, IoTHubMessage_GetInputName, TEST_INPUT_NAME);
+    //cleanup
 }
 
-TEST_FUNCTION(IoTHubMessage_SetConnectionModuleId_NULL_handle_Fails)
+TEST_FUNCTION(IoTHubMessage_GetProperty_key_NULL_Fail)
 {
-    set_string_NULL_handle_fails_impl(IoTHubMessage_SetConnectionModuleId, TEST_CONNECTION_MODULE_ID);
-}
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    umock_c_reset_all_calls();
 
-TEST_FUNCTION(IoTHubMessage_SetConnectionModuleId_NULL_MessageId_Fails)
-{
-    set_string_NULL_string_fails_impl(IoTHubMessage_SetConnectionModuleId);
-}
+    //act
+    const char* result = IoTHubMessage_GetProperty(h, NULL);
 
-TEST_FUNCTION(IoTHubMessage_SetConnectionModuleId_SUCCEED)
-{
-    set_string_succeeds_impl(IoTHubMessage_SetConnectionModuleId, TEST_CONNECTION_MODULE_ID);
-}
+    //assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-TEST_FUNCTION(IoTHubMessage_SetConnectionModuleId_ConnectionModuleId_Not_NULL_SUCCEED)
-{
-    set_string_string_already_allocated_succeeds_impl(IoTHubMessage_SetConnectionModuleId, TEST_CONNECTION_MODULE_ID2);
+    //cleanup
+    IoTHubMessage_Destroy(h);
 }
 
-TEST_FUNCTION(IoTHubMessage_GetConnectionModuleId_NULL_handle_Fails)
+TEST_FUNCTION(IoTHubMessage_GetProperty_Succeed)
 {
-    get_string_NULL_handle_fails_impl(IoTHubMessage_GetConnectionModuleId);
-}
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    (void)IoTHubMessage_SetProperty(h, TEST_PROPERTY_KEY, TEST_PROPERTY_VALUE);
+    umock_c_reset_all_calls();
 
-TEST_FUNCTION(IoTHubMessage_GetConnectionModuleId_ConnectionModuleId_Not_Set_Fails)
-{
-    get_string_not_set_fails_impl(IoTHubMessage_GetConnectionModuleId);
-}
+    //act
+    const char* result = IoTHubMessage_GetProperty(h, TEST_PROPERTY_KEY);
 
-TEST_FUNCTION(IoTHubMessage_GetConnectionModuleId_SUCCEED)
-{
-    get_string_succeeds_impl(IoTHubMessage_SetConnectionModuleId, IoTHubMessage_GetConnectionModuleId, TEST_CONNECTION_MODULE_ID);
-}
+    //assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_PROPERTY_VALUE, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-TEST_FUNCTION(IoTHubMessage_SetConnectionDeviceId_NULL_handle_Fails)
-{
-    set_string_NULL_handle_fails_impl(IoTHubMessage_SetConnectionDeviceId, TEST_CONNECTION_DEVICE_ID);
+    //cleanup
+    IoTHubMessage_Destroy(h);
 }
 
-TEST_FUNCTION(IoTHubMessage_SetConnectionDeviceId_NULL_MessageId_Fails)
+TEST_FUNCTION(IoTHubMessage_GetProperty_Fail)
 {
-    set_string_NULL_string_fails_impl(IoTHubMessage_SetConnectionDeviceId);
-}
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    (void)IoTHubMessage_SetProperty(h, TEST_VALID_MAP_KEY, TEST_VALID_MAP_VALUE);
+    umock_c_reset_all_calls();
 
-TEST_FUNCTION(IoTHubMessage_SetConnectionDeviceId_SUCCEED)
-{
-    set_string_succeeds_impl(IoTHubMessage_SetConnectionDeviceId, TEST_CONNECTION_DEVICE_ID);
-}
+    //act
+    const char* result = IoTHubMessage_GetProperty(h, TEST_PROPERTY_KEY);
 
-TEST_FUNCTION(IoTHubMessage_SetConnectionDeviceId_ConnectionDeviceId_Not_NULL_SUCCEED)
+    //assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubMessage_GetProperty_no_properties_Fail)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    umock_c_reset_all_calls();
+
+    //act
+    const char* result = IoTHubMessage_GetProperty(h, TEST_PROPERTY_KEY);
+
+    //assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubMessage_GetProperty_after_Properties_Succeed)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    (void)IoTHubMessage_Properties(h);
+    umock_c_reset_all_calls();
+
+    bool key_exist = true;
+    STRICT_EXPECTED_CALL(Map_ContainsKey(IGNORED_PTR_ARG, TEST_PROPERTY_KEY, IGNORED_PTR_ARG)).CopyOutArgumentBuffer_keyExists(&key_exist, sizeof(bool));
+    STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, TEST_PROPERTY_KEY)).SetReturn(TEST_PROPERTY_VALUE);
+
+    //act
+    const char* result = IoTHubMessage_GetProperty(h, TEST_PROPERTY_KEY);
+
+    //assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_PROPERTY_VALUE, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubMessage_GetProperty_after_Properties_Fail)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    (void)IoTHubMessage_Properties(h);
+    umock_c_reset_all_calls();
+
+    bool key_exist = false;
+    STRICT_EXPECTED_CALL(Map_ContainsKey(IGNORED_PTR_ARG, TEST_PROPERTY_KEY, IGNORED_PTR_ARG)).CopyOutArgumentBuffer_keyExists(&key_exist, sizeof(bool));
+
+    //act
+    const char* result = IoTHubMessage_GetProperty(h, TEST_PROPERTY_KEY);
+
+    //assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubMessage_GetPropertyCount_NULL_handle_Fails)
+{
+    //arrange
+    size_t count;
+
+    //act
+    IOTHUB_MESSAGE_RESULT result = IoTHubMessage_GetPropertyCount(NULL, &count);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+}
+
+TEST_FUNCTION(IoTHubMessage_GetPropertyCount_NULL_count_Fails)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_MESSAGE_RESULT result = IoTHubMessage_GetPropertyCount(h, NULL);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubMessage_GetPropertyCount_no_properties_SUCCEED)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    size_t count = 42;
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_MESSAGE_RESULT result = IoTHubMessage_GetPropertyCount(h, &count);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, result);
+    ASSERT_ARE_EQUAL(size_t, 0, count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubMessage_GetPropertyCount_SUCCEED)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    size_t count;
+    (void)IoTHubMessage_SetProperty(h, TEST_PROPERTY_KEY, TEST_PROPERTY_VALUE);
+    (void)IoTHubMessage_SetProperty(h, TEST_VALID_MAP_KEY, TEST_VALID_MAP_VALUE);
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_MESSAGE_RESULT result = IoTHubMessage_GetPropertyCount(h, &count);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, result);
+    ASSERT_ARE_EQUAL(size_t, 2, count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubMessage_GetPropertyCount_after_Properties_SUCCEED)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    size_t count;
+    size_t map_count = 3;
+    (void)IoTHubMessage_Properties(h);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_count(&map_count, sizeof(map_count));
+
+    //act
+    IOTHUB_MESSAGE_RESULT result = IoTHubMessage_GetPropertyCount(h, &count);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, result);
+    ASSERT_ARE_EQUAL(size_t, 3, count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubMessage_GetNextProperty_NULL_arguments_Fails)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    size_t cursor = 0;
+    const char* key;
+    const char* value;
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_MESSAGE_RESULT result1 = IoTHubMessage_GetNextProperty(NULL, &cursor, &key, &value);
+    IOTHUB_MESSAGE_RESULT result2 = IoTHubMessage_GetNextProperty(h, NULL, &key, &value);
+    IOTHUB_MESSAGE_RESULT result3 = IoTHubMessage_GetNextProperty(h, &cursor, NULL, &value);
+    IOTHUB_MESSAGE_RESULT result4 = IoTHubMessage_GetNextProperty(h, &cursor, &key, NULL);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_INVALID_ARG, result1);
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_INVALID_ARG, result2);
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_INVALID_ARG, result3);
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_INVALID_ARG, result4);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubMessage_GetNextProperty_in_order_set_SUCCEED)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    size_t cursor = 0;
+    const char* key1;
+    const char* value1;
+    const char* key2;
+    const char* value2;
+    (void)IoTHubMessage_SetProperty(h, TEST_PROPERTY_KEY, TEST_PROPERTY_VALUE);
+    (void)IoTHubMessage_SetProperty(h, TEST_VALID_MAP_KEY, TEST_VALID_MAP_VALUE);
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_MESSAGE_RESULT result1 = IoTHubMessage_GetNextProperty(h, &cursor, &key1, &value1);
+    IOTHUB_MESSAGE_RESULT result2 = IoTHubMessage_GetNextProperty(h, &cursor, &key2, &value2);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, result1);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_PROPERTY_KEY, key1);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_PROPERTY_VALUE, value1);
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, result2);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_VALID_MAP_KEY, key2);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_VALID_MAP_VALUE, value2);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubMessage_GetNextProperty_past_last_property_Fails)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    size_t cursor = 0;
+    const char* key;
+    const char* value;
+    (void)IoTHubMessage_SetProperty(h, TEST_PROPERTY_KEY, TEST_PROPERTY_VALUE);
+    (void)IoTHubMessage_GetNextProperty(h, &cursor, &key, &value);
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_MESSAGE_RESULT result = IoTHubMessage_GetNextProperty(h, &cursor, &key, &value);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubMessage_GetNextProperty_after_Properties_SUCCEED)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    const char* map_keys[] = { TEST_PROPERTY_KEY };
+    const char* map_values[] = { TEST_PROPERTY_VALUE };
+    const char* const* keys = (const char* const*)map_keys;
+    const char* const* values = (const char* const*)map_values;
+    size_t map_count = 1;
+    size_t cursor = 0;
+    const char* key;
+    const char* value;
+    (void)IoTHubMessage_Properties(h);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_keys(&keys, sizeof(keys))
+        .CopyOutArgumentBuffer_values(&values, sizeof(values))
+        .CopyOutArgumentBuffer_count(&map_count, sizeof(map_count));
+
+    //act
+    IOTHUB_MESSAGE_RESULT result = IoTHubMessage_GetNextProperty(h, &cursor, &key, &value);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, result);
+    ASSERT_ARE_EQUAL(size_t, 1, cursor);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_PROPERTY_KEY, key);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_PROPERTY_VALUE, value);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubMessage_Properties_moves_properties_to_map_SUCCEED)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    (void)IoTHubMessage_SetProperty(h, TEST_PROPERTY_KEY, TEST_PROPERTY_VALUE);
+    (void)IoTHubMessage_SetProperty(h, TEST_VALID_MAP_KEY, TEST_VALID_MAP_VALUE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Map_Create(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, TEST_PROPERTY_KEY, TEST_PROPERTY_VALUE));
+    STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, TEST_VALID_MAP_KEY, TEST_VALID_MAP_VALUE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    //act
+    MAP_HANDLE r1 = IoTHubMessage_Properties(h);
+    MAP_HANDLE r2 = IoTHubMessage_Properties(h);
+
+    //assert
+    ASSERT_IS_NOT_NULL(r1);
+    ASSERT_ARE_EQUAL(void_ptr, r1, r2);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubMessage_Properties_Fail)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    (void)IoTHubMessage_SetProperty(h, TEST_PROPERTY_KEY, TEST_PROPERTY_VALUE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Map_Create(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, TEST_PROPERTY_KEY, TEST_PROPERTY_VALUE)).SetReturn(MAP_ERROR);
+    STRICT_EXPECTED_CALL(Map_Destroy(IGNORED_PTR_ARG));
+
+    //act
+    MAP_HANDLE r = IoTHubMessage_Properties(h);
+
+    //assert
+    ASSERT_IS_NULL(r);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(char_ptr, TEST_PROPERTY_VALUE, IoTHubMessage_GetProperty(h, TEST_PROPERTY_KEY));
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubMessage_Clone_shares_properties_SUCCEED)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    (void)IoTHubMessage_SetProperty(h, TEST_PROPERTY_KEY, TEST_PROPERTY_VALUE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_clone(IGNORED_PTR_ARG));
+
+    //act
+    IOTHUB_MESSAGE_HANDLE r = IoTHubMessage_Clone(h);
+
+    //assert
+    ASSERT_IS_NOT_NULL(r);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(void_ptr, IoTHubMessage_GetProperty(h, TEST_PROPERTY_KEY), IoTHubMessage_GetProperty(r, TEST_PROPERTY_KEY));
+
+    //cleanup
+    IoTHubMessage_Destroy(r);
+    IoTHubMessage_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubMessage_SetProperty_on_clone_copies_properties_SUCCEED)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    (void)IoTHubMessage_SetProperty(h, TEST_PROPERTY_KEY, TEST_PROPERTY_VALUE);
+    IOTHUB_MESSAGE_HANDLE r = IoTHubMessage_Clone(h);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    //act
+    IOTHUB_MESSAGE_RESULT result = IoTHubMessage_SetProperty(r, TEST_PROPERTY_KEY, TEST_STRING_VALUE);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(char_ptr, TEST_PROPERTY_VALUE, IoTHubMessage_GetProperty(h, TEST_PROPERTY_KEY));
+    ASSERT_ARE_EQUAL(char_ptr, TEST_STRING_VALUE, IoTHubMessage_GetProperty(r, TEST_PROPERTY_KEY));
+
+    //cleanup
+    IoTHubMessage_Destroy(r);
+    IoTHubMessage_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubMessage_Destroy_releases_shared_properties_last)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    (void)IoTHubMessage_SetProperty(h, TEST_PROPERTY_KEY, TEST_PROPERTY_VALUE);
+    IOTHUB_MESSAGE_HANDLE r = IoTHubMessage_Clone(h);
+    IoTHubMessage_Destroy(h);
+    umock_c_reset_all_calls();
+
+    //act
+    const char* result = IoTHubMessage_GetProperty(r, TEST_PROPERTY_KEY);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, TEST_PROPERTY_VALUE, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubMessage_Destroy(r);
+}
+
+TEST_FUNCTION(IoTHubMessage_SetProperty_on_source_after_clone_destroyed_does_not_copy_SUCCEED)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    (void)IoTHubMessage_SetProperty(h, TEST_PROPERTY_KEY, TEST_PROPERTY_VALUE);
+    IOTHUB_MESSAGE_HANDLE r = IoTHubMessage_Clone(h);
+    IoTHubMessage_Destroy(r);
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_MESSAGE_RESULT result = IoTHubMessage_SetProperty(h, TEST_VALID_MAP_KEY, TEST_VALID_MAP_VALUE);
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubMessage_GetProperty_value_stays_valid_after_SetProperty_SUCCEED)
+{
+    //arrange
+    char key[32];
+    size_t index;
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    (void)IoTHubMessage_SetProperty(h, TEST_PROPERTY_KEY, TEST_PROPERTY_VALUE);
+    (void)IoTHubMessage_SetProperty(h, TEST_VALID_MAP_KEY, TEST_VALID_MAP_VALUE);
+    const char* value = IoTHubMessage_GetProperty(h, TEST_PROPERTY_KEY);
+    const char* otherValue = IoTHubMessage_GetProperty(h, TEST_VALID_MAP_KEY);
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_MESSAGE_RESULT result = IoTHubMessage_SetProperty(h, TEST_PROPERTY_KEY, TEST_STRING_VALUE);
+    // Enough properties to outgrow the block
+    for (index = 0; index < 64 && result == IOTHUB_MESSAGE_OK; index++)
+    {
+        (void)sprintf(key, "key%lu", (unsigned long)index);
+        result = IoTHubMessage_SetProperty(h, key, TEST_PROPERTY_VALUE);
+    }
+
+    //assert
+    ASSERT_ARE_EQUAL(IOTHUB_MESSAGE_RESULT, IOTHUB_MESSAGE_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_PROPERTY_VALUE, value);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_VALID_MAP_VALUE, otherValue);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_STRING_VALUE, IoTHubMessage_GetProperty(h, TEST_PROPERTY_KEY));
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubMessage_GetProperty_value_stays_valid_after_Properties_SUCCEED)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    (void)IoTHubMessage_SetProperty(h, TEST_PROPERTY_KEY, TEST_PROPERTY_VALUE);
+    const char* value = IoTHubMessage_GetProperty(h, TEST_PROPERTY_KEY);
+    umock_c_reset_all_calls();
+
+    //act
+    MAP_HANDLE map = IoTHubMessage_Properties(h);
+
+    //assert
+    ASSERT_IS_NOT_NULL(map);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_PROPERTY_VALUE, value);
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubMessage_Properties_keeping_lent_properties_Fail)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    (void)IoTHubMessage_SetProperty(h, TEST_PROPERTY_KEY, TEST_PROPERTY_VALUE);
+    const char* value = IoTHubMessage_GetProperty(h, TEST_PROPERTY_KEY);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Map_Create(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, TEST_PROPERTY_KEY, TEST_PROPERTY_VALUE));
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG)).SetReturn(NULL);
+    STRICT_EXPECTED_CALL(Map_Destroy(IGNORED_PTR_ARG));
+
+    //act
+    MAP_HANDLE map = IoTHubMessage_Properties(h);
+
+    //assert
+    ASSERT_IS_NULL(map);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(char_ptr, TEST_PROPERTY_VALUE, value);
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubMessage_SetOutputName_NULL_handle_Fails)
+{
+    set_string_NULL_handle_fails_impl(IoTHubMessage_SetOutputName, TEST_OUTPUT_NAME);
+}
+
+TEST_FUNCTION(IoTHubMessage_SetOutputName_NULL_MessageId_Fails)
+{
+    set_string_NULL_string_fails_impl(IoTHubMessage_SetOutputName);
+}
+
+TEST_FUNCTION(IoTHubMessage_SetOutputName_SUCCEED)
+{
+    set_string_succeeds_impl(IoTHubMessage_SetOutputName, TEST_OUTPUT_NAME);
+}
+
+TEST_FUNCTION(IoTHubMessage_SetOutputName_OutputName_Not_NULL_SUCCEED)
+{
+    set_string_string_already_allocated_succeeds_impl(IoTHubMessage_SetOutputName, TEST_OUTPUT_NAME2);
+}
+
+TEST_FUNCTION(IoTHubMessage_GetOutputName_NULL_handle_Fails)
+{
+    get_string_NULL_handle_fails_impl(IoTHubMessage_GetOutputName);
+}
+
+TEST_FUNCTION(IoTHubMessage_GetOutputName_OutputName_Not_Set_Fails)
+{
+    get_string_not_set_fails_impl(IoTHubMessage_GetOutputName);
+}
+
+TEST_FUNCTION(IoTHubMessage_GetOutputName_SUCCEED)
+{
+    get_string_succeeds_impl(IoTHubMessage_SetOutputName, IoTHubMessage_GetOutputName, TEST_OUTPUT_NAME);
+}
+
+TEST_FUNCTION(IoTHubMessage_SetInputName_NULL_handle_Fails)
+{
+    set_string_NULL_handle_fails_impl(IoTHubMessage_SetInputName, TEST_INPUT_NAME);
+}
+
+TEST_FUNCTION(IoTHubMessage_SetInputName_NULL_MessageId_Fails)
+{
+    set_string_NULL_string_fails_impl(IoTHubMessage_SetInputName);
+}
+
+TEST_FUNCTION(IoTHubMessage_SetInputName_SUCCEED)
+{
+    set_string_succeeds_impl(IoTHubMessage_SetInputName, TEST_INPUT_NAME);
+}
+
+TEST_FUNCTION(IoTHubMessage_SetInputName_InputName_Not_NULL_SUCCEED)
+{
+    set_string_string_already_allocated_succeeds_impl(IoTHubMessage_SetInputName, TEST_INPUT_NAME2);
+}
+
+TEST_FUNCTION(IoTHubMessage_GetInputName_NULL_handle_Fails)
+{
+    get_string_NULL_handle_fails_impl(IoTHubMessage_GetInputName);
+}
+
+TEST_FUNCTION(IoTHubMessage_GetInputName_InputName_Not_Set_Fails)
+{
+    get_string_not_set_fails_impl(IoTHubMessage_GetInputName);
+}
+
+TEST_FUNCTION(IoTHubMessage_GetInputName_SUCCEED)
+{
+    get_string_succeeds_impl(IoTHubMessage_SetInputName, IoTHubMessage_GetInputName, TEST_INPUT_NAME);
+}
+
+TEST_FUNCTION(IoTHubMessage_SetConnectionModuleId_NULL_handle_Fails)
+{
+    set_string_NULL_handle_fails_impl(IoTHubMessage_SetConnectionModuleId, TEST_CONNECTION_MODULE_ID);
+}
+
+TEST_FUNCTION(IoTHubMessage_SetConnectionModuleId_NULL_MessageId_Fails)
+{
+    set_string_NULL_string_fails_impl(IoTHubMessage_SetConnectionModuleId);
+}
+
+TEST_FUNCTION(IoTHubMessage_SetConnectionModuleId_SUCCEED)
+{
+    set_string_succeeds_impl(IoTHubMessage_SetConnectionModuleId, TEST_CONNECTION_MODULE_ID);
+}
+
+TEST_FUNCTION(IoTHubMessage_SetConnectionModuleId_ConnectionModuleId_Not_NULL_SUCCEED)
+{
+    set_string_string_already_allocated_succeeds_impl(IoTHubMessage_SetConnectionModuleId, TEST_CONNECTION_MODULE_ID2);
+}
+
+TEST_FUNCTION(IoTHubMessage_GetConnectionModuleId_NULL_handle_Fails)
+{
+    get_string_NULL_handle_fails_impl(IoTHubMessage_GetConnectionModuleId);
+}
+
+TEST_FUNCTION(IoTHubMessage_GetConnectionModuleId_ConnectionModuleId_Not_Set_Fails)
+{
+    get_string_not_set_fails_impl(IoTHubMessage_GetConnectionModuleId);
+}
+
+TEST_FUNCTION(IoTHubMessage_GetConnectionModuleId_SUCCEED)
+{
+    get_string_succeeds_impl(IoTHubMessage_SetConnectionModuleId, IoTHubMessage_GetConnectionModuleId, TEST_CONNECTION_MODULE_ID);
+}
+
+TEST_FUNCTION(IoTHubMessage_SetConnectionDeviceId_NULL_handle_Fails)
+{
+    set_string_NULL_handle_fails_impl(IoTHubMessage_SetConnectionDeviceId, TEST_CONNECTION_DEVICE_ID);
+}
+
+TEST_FUNCTION(IoTHubMessage_SetConnectionDeviceId_NULL_MessageId_Fails)
+{
+    set_string_NULL_string_fails_impl(IoTHubMessage_SetConnectionDeviceId);
+}
+
+TEST_FUNCTION(IoTHubMessage_SetConnectionDeviceId_SUCCEED)
+{
+    set_string_succeeds_impl(IoTHubMessage_SetConnectionDeviceId, TEST_CONNECTION_DEVICE_ID);
+}
+
+TEST_FUNCTION(IoTHubMessage_SetConnectionDeviceId_ConnectionDeviceId_Not_NULL_SUCCEED)
 {
     set_string_string_already_allocated_succeeds_impl(IoTHubMessage_SetConnectionDeviceId, "output_string2");
 }
@@ -2186,7 +2787,6 @@ TEST_FUNCTION(IoTHubMessage_Destroy_with_context_Succeed)
 
     umock_c_reset_all_calls();
     STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(Map_Destroy(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
@@ -2337,6 +2937,72 @@ TEST_FUNCTION(IoTHubMessage_GetDispositionContext_NULL_context_Fails)
     IoTHubMessage_Destroy(h);
 }
 
+TEST_FUNCTION(IoTHubMessage_SetBody_string_message_becomes_byte_array_Succeed)
+{
+    //arrange
+    const unsigned char* buffer;
+    size_t size;
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromString("a");
+    BUFFER_HANDLE body = real_BUFFER_create(c, 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
+
+    //act
+    IOTHUB_MESSAGE_RESULT result = IoTHubMessage_SetBody(h, body);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_TRUE(result == IOTHUB_MESSAGE_OK);
+    ASSERT_ARE_EQUAL(IOTHUBMESSAGE_CONTENT_TYPE, IOTHUBMESSAGE_BYTEARRAY, IoTHubMessage_GetContentType(h));
+    ASSERT_IS_TRUE(IoTHubMessage_GetByteArray(h, &buffer, &size) == IOTHUB_MESSAGE_OK);
+    ASSERT_ARE_EQUAL(size_t, 1, size);
+    ASSERT_ARE_EQUAL(int, c[0], buffer[0]);
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubMessage_SetBody_byte_array_message_Succeed)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    BUFFER_HANDLE body = real_BUFFER_create(c, 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
+
+    //act
+    IOTHUB_MESSAGE_RESULT result = IoTHubMessage_SetBody(h, body);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_TRUE(result == IOTHUB_MESSAGE_OK);
+    ASSERT_ARE_EQUAL(IOTHUBMESSAGE_CONTENT_TYPE, IOTHUBMESSAGE_BYTEARRAY, IoTHubMessage_GetContentType(h));
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
+TEST_FUNCTION(IoTHubMessage_SetBody_NULL_arguments_Fails)
+{
+    //arrange
+    IOTHUB_MESSAGE_HANDLE h = IoTHubMessage_CreateFromByteArray(c, 1);
+    umock_c_reset_all_calls();
+
+    //act
+    IOTHUB_MESSAGE_RESULT no_handle = IoTHubMessage_SetBody(NULL, TEST_BUFFER_HANDLE);
+    IOTHUB_MESSAGE_RESULT no_body = IoTHubMessage_SetBody(h, NULL);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_TRUE(no_handle == IOTHUB_MESSAGE_INVALID_ARG);
+    ASSERT_IS_TRUE(no_body == IOTHUB_MESSAGE_INVALID_ARG);
+
+    //cleanup
+    IoTHubMessage_Destroy(h);
+}
+
 TEST_FUNCTION(IoTHubMessage_SetComponentName_NULL_handle_Fails)
 {
     set_string_NULL_handle_fails_impl(IoTHubMessage_SetComponentName, TEST_COMPONENT_NAME);
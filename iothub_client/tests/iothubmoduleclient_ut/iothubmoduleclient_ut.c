@@ -119,6 +119,8 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_RETURN(IoTHubClientCore_SendEventToOutputAsync, IOTHUB_CLIENT_OK);
     REGISTER_GLOBAL_MOCK_RETURN(IoTHubClientCore_SetInputMessageCallback, IOTHUB_CLIENT_OK);
     REGISTER_GLOBAL_MOCK_RETURN(IoTHubClientCore_GetTwinAsync, IOTHUB_CLIENT_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(IoTHubClientCore_GetCallbackQueueStatistics, IOTHUB_CLIENT_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(IoTHubClientCore_GetMetrics, IOTHUB_CLIENT_OK);
 }
 
 TEST_SUITE_CLEANUP(suite_cleanup)
@@ -423,4 +425,32 @@ TEST_FUNCTION(IoTHubModuleClient_GetPropertiesAndSubscribeToUpdatesAsync_Test)
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
+TEST_FUNCTION(IoTHubModuleClient_GetCallbackQueueStatistics_Test)
+{
+    //arrange
+    IOTHUB_CLIENT_CALLBACK_QUEUE_STATISTICS statistics;
+    STRICT_EXPECTED_CALL(IoTHubClientCore_GetCallbackQueueStatistics(TEST_IOTHUB_CLIENT_CORE_HANDLE, &statistics));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubModuleClient_GetCallbackQueueStatistics(TEST_IOTHUB_MODULE_CLIENT_HANDLE, &statistics);
+
+    //assert
+    ASSERT_IS_TRUE(result == IOTHUB_CLIENT_OK);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(IoTHubModuleClient_GetMetrics_Test)
+{
+    //arrange
+    IOTHUB_CLIENT_METRICS metrics;
+    STRICT_EXPECTED_CALL(IoTHubClientCore_GetMetrics(TEST_IOTHUB_CLIENT_CORE_HANDLE, &metrics));
+
+    //act
+    IOTHUB_CLIENT_RESULT result = IoTHubModuleClient_GetMetrics(TEST_IOTHUB_MODULE_CLIENT_HANDLE, &metrics);
+
+    //assert
+    ASSERT_IS_TRUE(result == IOTHUB_CLIENT_OK);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
 END_TEST_SUITE(iothubmoduleclient_ut)
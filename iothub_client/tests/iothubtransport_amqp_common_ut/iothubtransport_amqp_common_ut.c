@@ -474,6 +474,13 @@ static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
 #define TEST_MESSAGE_SOURCE_CHAR_PTR               "messagereceiver_link_name"
 #define TEST_RETRY_CONTROL_HANDLE                  (RETRY_CONTROL_HANDLE)0x4276
 
+// Not a mock, so that the calls do not show up in the expectations of every test
+static METRICS_HANDLE test_get_metrics_callback(void* ctx)
+{
+    (void)ctx;
+    return NULL;
+}
+
 static TRANSPORT_CALLBACKS_INFO transport_cb_info;
 static void* transport_cb_ctx = (void*)0x499922;
 
@@ -1329,6 +1336,7 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     transport_cb_info.msg_input_cb = Transport_MessageCallbackFromInput;
     transport_cb_info.msg_cb = Transport_MessageCallback;
     transport_cb_info.method_complete_cb = Transport_DeviceMethod_Complete_Callback;
+    transport_cb_info.get_metrics_cb = test_get_metrics_callback;
 }
 
 TEST_SUITE_CLEANUP(TestClassCleanup)
@@ -68,6 +68,13 @@ MOCKABLE_FUNCTION(, const char*, Transport_GetOption_Model_Id_Callback, void*, c
 
 #undef ENABLE_MOCKS
 
+// Not a mock, so that the calls do not show up in the expectations of every test
+static METRICS_HANDLE test_get_metrics_callback(void* ctx)
+{
+    (void)ctx;
+    return NULL;
+}
+
 #include "internal/iothubtransport_mqtt_common.h"
 #include "azure_c_shared_utility/strings.h"
 
@@ -510,6 +517,7 @@ TEST_SUITE_INITIALIZE(suite_init)
     transport_cb_info.msg_cb = Transport_MessageCallback;
     transport_cb_info.method_complete_cb = Transport_DeviceMethod_Complete_Callback;
     transport_cb_info.get_model_id_cb = Transport_GetOption_Model_Id_Callback;
+    transport_cb_info.get_metrics_cb = test_get_metrics_callback;
 
     test_serialize_mutex = TEST_MUTEX_CREATE();
     ASSERT_IS_NOT_NULL(test_serialize_mutex);
@@ -10,6 +10,7 @@
 #include "umock_c/umock_c.h"
 #include "umock_c/umock_c_negative_tests.h"
 #include "umock_c/umocktypes_charptr.h"
+#include "umock_c/umocktypes_bool.h"
 
 #if defined _MSC_VER
 #pragma warning(disable: 4054) /* MSC incorrectly fires this */
@@ -113,6 +114,7 @@ static pfIoTHubTransport_Subscribe_InputQueue       IoTHubTransportMqtt_Subscrib
 static pfIoTHubTransport_Unsubscribe_InputQueue     IoTHubTransportMqtt_Unsubscribe_InputQueue;
 static pfIoTHubTransport_SetCallbackContext         IoTHubTransportMqtt_SetCallbackContext;
 static pfIoTHubTransport_GetSupportedPlatformInfo   IotHubTransportMqtt_GetSupportedPlatformInfo;
+static pfIoTHubTransport_GetPollInfo                IotHubTransportMqtt_GetPollInfo;
 
 static TRANSPORT_LL_HANDLE my_IoTHubTransport_MQTT_Common_Create(const IOTHUBTRANSPORT_CONFIG* config, MQTT_GET_IO_TRANSPORT get_io_transport, TRANSPORT_CALLBACKS_INFO* cb_info, void* ctx)
 {
@@ -301,6 +303,7 @@ TEST_SUITE_INITIALIZE(suite_init)
     ASSERT_IS_NOT_NULL(test_serialize_mutex);
 
     umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, umocktypes_bool_register_types());
 
     REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(PDLIST_ENTRY, void*);
@@ -359,6 +362,7 @@ TEST_SUITE_INITIALIZE(suite_init)
     IoTHubTransportMqtt_Unsubscribe_InputQueue = ((TRANSPORT_PROVIDER*)MQTT_Protocol())->IoTHubTransport_Unsubscribe_InputQueue;
     IoTHubTransportMqtt_SetCallbackContext = ((TRANSPORT_PROVIDER*)MQTT_Protocol())->IoTHubTransport_SetCallbackContext;
     IotHubTransportMqtt_GetSupportedPlatformInfo = ((TRANSPORT_PROVIDER*)MQTT_Protocol())->IoTHubTransport_GetSupportedPlatformInfo;
+    IotHubTransportMqtt_GetPollInfo = ((TRANSPORT_PROVIDER*)MQTT_Protocol())->IoTHubTransport_GetPollInfo;
 }
 
 TEST_SUITE_CLEANUP(suite_cleanup)
@@ -955,4 +959,26 @@ TEST_FUNCTION(IoTHubTransportMqtt_GetSupportedPlatformInfo_NULL_info)
     // cleanup
 }
 
+TEST_FUNCTION(IoTHubTransportMqtt_GetPollInfo)
+{
+    // arrange
+    IOTHUBTRANSPORT_CONFIG config = { 0 };
+    SetupIothubTransportConfig(&config, TEST_DEVICE_ID, TEST_DEVICE_KEY, TEST_IOTHUB_NAME, TEST_IOTHUB_SUFFIX, TEST_PROTOCOL_GATEWAY_HOSTNAME);
+    TRANSPORT_LL_HANDLE handle = IoTHubTransportMqtt_Create(&config, g_transport_cb_info, NULL);
+    IOTHUB_CLIENT_POLL_INFO pollInfo;
+
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(IoTHubTransport_MQTT_Common_GetPollInfo(handle, true, &pollInfo))
+        .SetReturn(IOTHUB_CLIENT_OK);
+
+    // act
+    IOTHUB_CLIENT_RESULT result = IotHubTransportMqtt_GetPollInfo(handle, true, &pollInfo);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, IOTHUB_CLIENT_OK, result);
+
+    // cleanup
+}
+
 END_TEST_SUITE(iothubtransportmqtt_ut)
@@ -0,0 +1,228 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// Compares the peak heap use and run time of IoTHubClient_Properties_Deserializer_Create (copy + parson DOM) with
+// IoTHubClient_Properties_Deserializer_CreateStreaming (pull parser over the caller's buffer) while enumerating
+// every property of a synthetic full twin.
+//
+// Output is CSV on stdout, one line per deserializer and twin size:
+//     deserializer,payload_bytes,properties,peak_heap_bytes,allocations,elapsed_ms
+//
+// Usage: properties_deserializer_perf [iterations]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "iothub_client_properties.h"
+#include "parson.h"
+
+typedef IOTHUB_CLIENT_RESULT(*DESERIALIZER_CREATE)(IOTHUB_CLIENT_PROPERTY_PAYLOAD_TYPE payloadType, const unsigned char* payload, size_t payloadLength, IOTHUB_CLIENT_PROPERTIES_DESERIALIZER_HANDLE* propertiesDeserializerHandle);
+
+typedef struct TWIN_SHAPE_TAG
+{
+    size_t componentCount;
+    size_t propertiesPerComponent;
+    size_t valueLength;
+} TWIN_SHAPE;
+
+// Roughly 16 KB, 128 KB, 512 KB and 1 MB full twins, split evenly between desired and reported.
+static const TWIN_SHAPE TWIN_SHAPES[] = {
+    { 4, 16, 96 },
+    { 8, 64, 96 },
+    { 16, 128, 96 },
+    { 32, 128, 96 }
+};
+
+static const int DEFAULT_ITERATIONS = 10;
+
+typedef struct TWIN_WRITER_TAG
+{
+    char* buffer;
+    size_t length;
+    size_t capacity;
+} TWIN_WRITER;
+
+static void append(TWIN_WRITER* writer, const char* text)
+{
+    size_t textLength = strlen(text);
+
+    if (writer->length + textLength + 1 > writer->capacity)
+    {
+        size_t newCapacity = (writer->capacity == 0) ? 4096 : writer->capacity;
+        while (writer->length + textLength + 1 > newCapacity)
+        {
+            newCapacity *= 2;
+        }
+
+        if ((writer->buffer = (char*)realloc(writer->buffer, newCapacity)) == NULL)
+        {
+            (void)printf("Unable to allocate %lu bytes for the synthetic twin\r\n", (unsigned long)newCapacity);
+            exit(EXIT_FAILURE);
+        }
+        writer->capacity = newCapacity;
+    }
+
+    memcpy(writer->buffer + writer->length, text, textLength + 1);
+    writer->length += textLength;
+}
+
+static void append_section(TWIN_WRITER* writer, const TWIN_SHAPE* shape, const char* prefix)
+{
+    char scratch[128];
+    char* value;
+    size_t component;
+    size_t property;
+
+    if ((value = (char*)malloc(shape->valueLength + 1)) == NULL)
+    {
+        (void)printf("Unable to allocate property value\r\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(value, 'x', shape->valueLength);
+    value[shape->valueLength] = '\0';
+
+    for (component = 0; component < shape->componentCount; component++)
+    {
+        (void)snprintf(scratch, sizeof(scratch), "%s\"%sComponent%lu\":{\"__t\":\"c\"", (component == 0) ? "" : ",", prefix, (unsigned long)component);
+        append(writer, scratch);
+
+        for (property = 0; property < shape->propertiesPerComponent; property++)
+        {
+            // Alternate between string and nested object values, as real twins do.
+            if ((property % 2) == 0)
+            {
+                (void)snprintf(scratch, sizeof(scratch), ",\"%sProperty%lu\":\"", prefix, (unsigned long)property);
+                append(writer, scratch);
+                append(writer, value);
+                append(writer, "\"");
+            }
+            else
+            {
+                (void)snprintf(scratch, sizeof(scratch), ",\"%sProperty%lu\":{\"value\":%lu,\"unit\":\"", prefix, (unsigned long)property, (unsigned long)property);
+                append(writer, scratch);
+                append(writer, value);
+                append(writer, "\",\"ac\":200,\"av\":1}");
+            }
+        }
+
+        append(writer, "}");
+    }
+
+    free(value);
+}
+
+static char* create_twin(const TWIN_SHAPE* shape, size_t* twinLength)
+{
+    TWIN_WRITER writer = { NULL, 0, 0 };
+
+    append(&writer, "{\"desired\":{");
+    append_section(&writer, shape, "desired");
+    append(&writer, ",\"$version\":42},\"reported\":{");
+    append_section(&writer, shape, "reported");
+    append(&writer, ",\"$version\":7}}");
+
+    *twinLength = writer.length;
+    return writer.buffer;
+}
+
+// Enumerates the complete twin once.  Returns the number of properties seen, or 0 on failure.
+static size_t enumerate_twin(DESERIALIZER_CREATE createDeserializer, const char* twin, size_t twinLength)
+{
+    size_t propertyCount = 0;
+    IOTHUB_CLIENT_PROPERTIES_DESERIALIZER_HANDLE deserializer;
+    int propertiesVersion;
+
+    if (createDeserializer(IOTHUB_CLIENT_PROPERTY_PAYLOAD_ALL, (const unsigned char*)twin, twinLength, &deserializer) != IOTHUB_CLIENT_OK)
+    {
+        (void)printf("Unable to create deserializer\r\n");
+    }
+    else
+    {
+        if (IoTHubClient_Properties_Deserializer_GetVersion(deserializer, &propertiesVersion) == IOTHUB_CLIENT_OK)
+        {
+            IOTHUB_CLIENT_PROPERTY_PARSED property;
+            bool propertySpecified;
+
+            property.structVersion = IOTHUB_CLIENT_PROPERTY_PARSED_STRUCT_VERSION_1;
+
+            while ((IoTHubClient_Properties_Deserializer_GetNext(deserializer, &property, &propertySpecified) == IOTHUB_CLIENT_OK) && propertySpecified)
+            {
+                propertyCount++;
+                IoTHubClient_Properties_DeserializerProperty_Destroy(&property);
+            }
+        }
+
+        IoTHubClient_Properties_Deserializer_Destroy(deserializer);
+    }
+
+    return propertyCount;
+}
+
+static void run_benchmark(const char* name, DESERIALIZER_CREATE createDeserializer, const char* twin, size_t twinLength, int iterations)
+{
+    size_t propertyCount = 0;
+    size_t peakHeap;
+    size_t allocations;
+    clock_t start;
+    double elapsedMs;
+    int i;
+
+    gballoc_resetMetrics();
+    start = clock();
+
+    for (i = 0; i < iterations; i++)
+    {
+        propertyCount = enumerate_twin(createDeserializer, twin, twinLength);
+    }
+
+    elapsedMs = ((double)(clock() - start) * 1000.0) / CLOCKS_PER_SEC / iterations;
+    peakHeap = gballoc_getMaximumMemoryUsed();
+    allocations = gballoc_getAllocationCount() / (size_t)iterations;
+
+    (void)printf("%s,%lu,%lu,%lu,%lu,%.3f\r\n", name, (unsigned long)twinLength, (unsigned long)propertyCount, (unsigned long)peakHeap, (unsigned long)allocations, elapsedMs);
+}
+
+int main(int argc, char* argv[])
+{
+    int result;
+    int iterations = (argc > 1) ? atoi(argv[1]) : DEFAULT_ITERATIONS;
+
+    if (iterations <= 0)
+    {
+        (void)printf("usage: properties_deserializer_perf [iterations]\r\n");
+        result = EXIT_FAILURE;
+    }
+    else if (gballoc_init() != 0)
+    {
+        (void)printf("gballoc_init failed\r\n");
+        result = EXIT_FAILURE;
+    }
+    else
+    {
+        size_t i;
+
+        // Count parson's allocations along with the deserializer's.
+        json_set_allocation_functions(gballoc_malloc, gballoc_free);
+
+        (void)printf("deserializer,payload_bytes,properties,peak_heap_bytes,allocations,elapsed_ms\r\n");
+
+        for (i = 0; i < sizeof(TWIN_SHAPES) / sizeof(TWIN_SHAPES[0]); i++)
+        {
+            size_t twinLength;
+            char* twin = create_twin(&TWIN_SHAPES[i], &twinLength);
+
+            run_benchmark("dom", IoTHubClient_Properties_Deserializer_Create, twin, twinLength, iterations);
+            run_benchmark("streaming", IoTHubClient_Properties_Deserializer_CreateStreaming, twin, twinLength, iterations);
+
+            free(twin);
+        }
+
+        gballoc_deinit();
+        result = EXIT_SUCCESS;
+    }
+
+    return result;
+}
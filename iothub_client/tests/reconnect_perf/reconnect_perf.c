@@ -0,0 +1,260 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// Measures how long IoTHubDeviceClient_LL takes to get telemetry through again after a network outage, against the
+// in-process stand-ins of the hub of telemetry_perf (see loopback_io.c).  This is the baseline for work on the reconnect
+// path: the transport destroys and recreates its IO after a drop and goes through the TLS handshake and the MQTT CONNECT
+// or AMQP CBS authentication again.  The loopback IO makes opening take handshake_ms, to stand for the TLS handshake of
+// a real link; with the default of 0 only the time spent in the SDK is measured.
+//
+// Each round drops the connection (every open IO fails with an IO error), queues one message and calls DoWork until it
+// is confirmed; the time from the drop to the confirmation is the reconnect time.  The retry policy is
+// IOTHUB_CLIENT_RETRY_IMMEDIATE so the retry back-off does not hide the connection cost.
+//
+// Output is CSV on stdout, one line per transport:
+//     protocol,reconnects,handshake_ms,mean_ms,p50_ms,max_ms
+//
+// Usage: reconnect_perf [reconnects [handshake_ms]]
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "iothub.h"
+#include "iothub_device_client_ll.h"
+#include "iothub_message.h"
+
+#include "loopback_io.h"
+#include "loopback_transport.h"
+
+static const long DEFAULT_RECONNECTS = 20;
+static const long DEFAULT_HANDSHAKE_MS = 0;
+
+static const uint64_t STALL_TIMEOUT_US = 10 * 1000 * 1000;
+
+static const char* CONNECTION_STRING = "HostName=loopback.azure-devices.net;DeviceId=reconnect-perf;x509=true";
+static const char* MESSAGE_BODY = "reconnect-perf";
+
+typedef struct PROTOCOL_ENTRY_TAG
+{
+    const char* name;
+    IOTHUB_CLIENT_TRANSPORT_PROVIDER protocol;
+} PROTOCOL_ENTRY;
+
+static const PROTOCOL_ENTRY PROTOCOLS[] =
+{
+#ifdef USE_MQTT
+    { "mqtt", Loopback_MQTT_Protocol },
+#endif
+#ifdef USE_AMQP
+    { "amqp", Loopback_AMQP_Protocol },
+#endif
+};
+
+typedef struct SEND_RESULT_TAG
+{
+    bool is_complete;
+    IOTHUB_CLIENT_CONFIRMATION_RESULT result;
+} SEND_RESULT;
+
+static uint64_t get_time_us(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+    (void)QueryPerformanceCounter(&counter);
+    (void)QueryPerformanceFrequency(&frequency);
+    return (uint64_t)((counter.QuadPart * 1000000.0) / frequency.QuadPart);
+#else
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000) + ((uint64_t)now.tv_nsec / 1000);
+#endif
+}
+
+static void on_send_confirmation(IOTHUB_CLIENT_CONFIRMATION_RESULT result, void* userContextCallback)
+{
+    SEND_RESULT* send_result = (SEND_RESULT*)userContextCallback;
+    send_result->result = result;
+    send_result->is_complete = true;
+}
+
+// Sends one message and runs DoWork until it is confirmed
+static int send_message(IOTHUB_DEVICE_CLIENT_LL_HANDLE client)
+{
+    int result;
+    IOTHUB_MESSAGE_HANDLE message;
+    SEND_RESULT send_result = { false, IOTHUB_CLIENT_CONFIRMATION_ERROR };
+
+    if ((message = IoTHubMessage_CreateFromString(MESSAGE_BODY)) == NULL)
+    {
+        (void)printf("Unable to create the message\r\n");
+        result = __LINE__;
+    }
+    else
+    {
+        if (IoTHubDeviceClient_LL_SendEventAsync(client, message, on_send_confirmation, &send_result) != IOTHUB_CLIENT_OK)
+        {
+            (void)printf("Unable to send the message\r\n");
+            result = __LINE__;
+        }
+        else
+        {
+            uint64_t start_us = get_time_us();
+
+            while (!send_result.is_complete && get_time_us() - start_us < STALL_TIMEOUT_US)
+            {
+                IoTHubDeviceClient_LL_DoWork(client);
+            }
+
+            if (!send_result.is_complete)
+            {
+                (void)printf("No confirmation received for %lu seconds\r\n", (unsigned long)(STALL_TIMEOUT_US / 1000000));
+                result = __LINE__;
+            }
+            else if (send_result.result != IOTHUB_CLIENT_CONFIRMATION_OK)
+            {
+                (void)printf("The message was not confirmed OK\r\n");
+                result = __LINE__;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+
+        IoTHubMessage_Destroy(message);
+    }
+
+    return result;
+}
+
+static int compare_times(const void* left, const void* right)
+{
+    uint64_t left_time = *(const uint64_t*)left;
+    uint64_t right_time = *(const uint64_t*)right;
+    return (left_time < right_time) ? -1 : ((left_time > right_time) ? 1 : 0);
+}
+
+static int run_benchmark(const PROTOCOL_ENTRY* protocol, size_t reconnects, unsigned int handshake_ms)
+{
+    int result;
+    uint64_t* reconnect_times_us;
+
+    if ((reconnect_times_us = (uint64_t*)malloc(sizeof(uint64_t) * reconnects)) == NULL)
+    {
+        (void)printf("Unable to allocate the reconnect times\r\n");
+        result = __LINE__;
+    }
+    else
+    {
+        IOTHUB_DEVICE_CLIENT_LL_HANDLE client;
+
+        if ((client = IoTHubDeviceClient_LL_CreateFromConnectionString(CONNECTION_STRING, protocol->protocol)) == NULL)
+        {
+            (void)printf("Unable to create the %s client\r\n", protocol->name);
+            result = __LINE__;
+        }
+        else
+        {
+            if (IoTHubDeviceClient_LL_SetRetryPolicy(client, IOTHUB_CLIENT_RETRY_IMMEDIATE, 0) != IOTHUB_CLIENT_OK)
+            {
+                (void)printf("Unable to set the %s retry policy\r\n", protocol->name);
+                result = __LINE__;
+            }
+            // The first message connects
+            else if (send_message(client) != 0)
+            {
+                (void)printf("%s warm-up failed\r\n", protocol->name);
+                result = __LINE__;
+            }
+            else
+            {
+                uint64_t total_us = 0;
+                size_t i;
+
+                result = 0;
+                for (i = 0; i < reconnects && result == 0; i++)
+                {
+                    uint64_t start_us = get_time_us();
+
+                    loopback_io_drop_connections();
+                    result = send_message(client);
+
+                    reconnect_times_us[i] = get_time_us() - start_us;
+                    total_us += reconnect_times_us[i];
+                }
+
+                if (result != 0)
+                {
+                    (void)printf("%s reconnect %lu failed\r\n", protocol->name, (unsigned long)i);
+                }
+                else
+                {
+                    qsort(reconnect_times_us, reconnects, sizeof(uint64_t), compare_times);
+
+                    (void)printf("%s,%lu,%u,%.1f,%.1f,%.1f\r\n",
+                        protocol->name,
+                        (unsigned long)reconnects,
+                        handshake_ms,
+                        (total_us / 1000.0) / reconnects,
+                        reconnect_times_us[(reconnects - 1) / 2] / 1000.0,
+                        reconnect_times_us[reconnects - 1] / 1000.0);
+                }
+            }
+
+            IoTHubDeviceClient_LL_Destroy(client);
+        }
+
+        free(reconnect_times_us);
+    }
+
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    int result;
+    long reconnects = (argc > 1) ? atol(argv[1]) : DEFAULT_RECONNECTS;
+    long handshake_ms = (argc > 2) ? atol(argv[2]) : DEFAULT_HANDSHAKE_MS;
+
+    if (reconnects <= 0 || handshake_ms < 0)
+    {
+        (void)printf("usage: reconnect_perf [reconnects [handshake_ms]]\r\n");
+        result = EXIT_FAILURE;
+    }
+    else if (IoTHub_Init() != 0)
+    {
+        (void)printf("IoTHub_Init failed\r\n");
+        result = EXIT_FAILURE;
+    }
+    else
+    {
+        size_t i;
+
+        loopback_io_set_handshake_time((unsigned int)handshake_ms);
+        result = EXIT_SUCCESS;
+
+        (void)printf("protocol,reconnects,handshake_ms,mean_ms,p50_ms,max_ms\r\n");
+
+        for (i = 0; i < sizeof(PROTOCOLS) / sizeof(PROTOCOLS[0]); i++)
+        {
+            if (run_benchmark(&PROTOCOLS[i], (size_t)reconnects, (unsigned int)handshake_ms) != 0)
+            {
+                result = EXIT_FAILURE;
+            }
+        }
+
+        IoTHub_Deinit();
+    }
+
+    return result;
+}
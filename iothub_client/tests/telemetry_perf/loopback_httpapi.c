@@ -0,0 +1,95 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// HTTP stand-in: replaces the platform HTTPAPI adapter (these definitions take precedence over the one linked from the
+// shared utility library) and completes every request with 204 No Content, which is how IoT Hub acknowledges
+// telemetry and answers a C2D poll when there is nothing to receive.
+
+#include <stdlib.h>
+
+#include "azure_c_shared_utility/httpapi.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#define HTTP_STATUS_NO_CONTENT      204
+
+typedef struct HTTP_HANDLE_DATA_TAG
+{
+    int unused;
+} HTTP_HANDLE_DATA;
+
+HTTPAPI_RESULT HTTPAPI_Init(void)
+{
+    return HTTPAPI_OK;
+}
+
+void HTTPAPI_Deinit(void)
+{
+}
+
+HTTP_HANDLE HTTPAPI_CreateConnection(const char* hostName)
+{
+    HTTP_HANDLE_DATA* result;
+
+    (void)hostName;
+
+    if ((result = (HTTP_HANDLE_DATA*)calloc(1, sizeof(HTTP_HANDLE_DATA))) == NULL)
+    {
+        LogError("Failed allocating the HTTP stand-in connection");
+    }
+
+    return result;
+}
+
+void HTTPAPI_CloseConnection(HTTP_HANDLE handle)
+{
+    free(handle);
+}
+
+HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+    HTTP_HEADERS_HANDLE httpHeadersHandle, const unsigned char* content,
+    size_t contentLength, unsigned int* statusCode,
+    HTTP_HEADERS_HANDLE responseHeadersHandle, BUFFER_HANDLE responseContent)
+{
+    HTTPAPI_RESULT result;
+
+    (void)requestType;
+    (void)relativePath;
+    (void)httpHeadersHandle;
+    (void)content;
+    (void)contentLength;
+    (void)responseHeadersHandle;
+    (void)responseContent;
+
+    if (handle == NULL)
+    {
+        result = HTTPAPI_INVALID_ARG;
+    }
+    else
+    {
+        if (statusCode != NULL)
+        {
+            *statusCode = HTTP_STATUS_NO_CONTENT;
+        }
+
+        result = HTTPAPI_OK;
+    }
+
+    return result;
+}
+
+HTTPAPI_RESULT HTTPAPI_SetOption(HTTP_HANDLE handle, const char* optionName, const void* value)
+{
+    (void)handle;
+    (void)optionName;
+    (void)value;
+    return HTTPAPI_OK;
+}
+
+HTTPAPI_RESULT HTTPAPI_CloneOption(const char* optionName, const void* value, const void** savedValue)
+{
+    (void)optionName;
+    (void)value;
+    /* Nothing to keep: options set on the stand-in are ignored. */
+    *savedValue = NULL;
+    return HTTPAPI_OK;
+}
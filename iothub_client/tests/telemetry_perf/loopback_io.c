@@ -0,0 +1,436 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// The stand-ins deliberately use the CRT allocator (gballoc.h is not included here), so that only the allocations made
+// by the SDK are reported by the benchmark.
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "azure_macro_utils/macro_utils.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/lock.h"
+
+#include "loopback_io.h"
+
+static unsigned int g_handshake_ms;
+/* Guards g_device_ends once loopback_io_set_multithreaded is on. */
+static LOCK_HANDLE g_lock;
+
+typedef struct LOOPBACK_IO_INSTANCE_TAG
+{
+    struct LOOPBACK_IO_INSTANCE_TAG* peer;
+    /* Device ends are listed so loopback_io_drop_connections can reach them. */
+    struct LOOPBACK_IO_INSTANCE_TAG* next_device_end;
+    const LOOPBACK_BROKER_INTERFACE* broker_interface;
+    void* broker;
+    bool is_open;
+    bool is_open_pending;
+    uint64_t handshake_done_ms;
+    ON_IO_OPEN_COMPLETE on_io_open_complete;
+    void* on_io_open_complete_context;
+    ON_BYTES_RECEIVED on_bytes_received;
+    void* on_bytes_received_context;
+    ON_IO_ERROR on_io_error;
+    void* on_io_error_context;
+    /* Bytes sent by the peer, delivered on the next dowork.  The two buffers are swapped while delivering so the
+       peer can keep sending from within on_bytes_received. */
+    unsigned char* pending;
+    size_t pending_size;
+    size_t pending_capacity;
+    unsigned char* delivering;
+    size_t delivering_capacity;
+} LOOPBACK_IO_INSTANCE;
+
+static LOOPBACK_IO_INSTANCE* g_device_ends;
+
+static void lock_globals(void)
+{
+    if (g_lock != NULL)
+    {
+        (void)Lock(g_lock);
+    }
+}
+
+static void unlock_globals(void)
+{
+    if (g_lock != NULL)
+    {
+        (void)Unlock(g_lock);
+    }
+}
+
+static uint64_t get_time_ms(void)
+{
+#ifdef _WIN32
+    return (uint64_t)GetTickCount64();
+#else
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000) + ((uint64_t)now.tv_nsec / 1000000);
+#endif
+}
+
+static void* loopback_io_clone_option(const char* name, const void* value)
+{
+    (void)name;
+    (void)value;
+    return NULL;
+}
+
+static void loopback_io_destroy_option(const char* name, const void* value)
+{
+    (void)name;
+    (void)value;
+}
+
+static int loopback_io_setoption(CONCRETE_IO_HANDLE handle, const char* optionName, const void* value)
+{
+    (void)handle;
+    (void)optionName;
+    (void)value;
+    /* TLS options (certificates, trusted certs...) have no meaning for the loopback. */
+    return 0;
+}
+
+static OPTIONHANDLER_HANDLE loopback_io_retrieveoptions(CONCRETE_IO_HANDLE handle)
+{
+    (void)handle;
+    return OptionHandler_Create(loopback_io_clone_option, loopback_io_destroy_option, loopback_io_setoption);
+}
+
+static CONCRETE_IO_HANDLE loopback_io_create(void* io_create_parameters)
+{
+    LOOPBACK_IO_CONFIG* config = (LOOPBACK_IO_CONFIG*)io_create_parameters;
+    LOOPBACK_IO_INSTANCE* result;
+
+    if (config == NULL || (config->broker_interface == NULL && config->peer == NULL))
+    {
+        LogError("Invalid loopback IO configuration");
+        result = NULL;
+    }
+    else if ((result = (LOOPBACK_IO_INSTANCE*)calloc(1, sizeof(LOOPBACK_IO_INSTANCE))) == NULL)
+    {
+        LogError("Failed allocating the loopback IO");
+    }
+    else
+    {
+        result->broker_interface = config->broker_interface;
+        result->peer = (LOOPBACK_IO_INSTANCE*)config->peer;
+
+        if (result->peer != NULL)
+        {
+            result->peer->peer = result;
+        }
+        else
+        {
+            lock_globals();
+            result->next_device_end = g_device_ends;
+            g_device_ends = result;
+            unlock_globals();
+        }
+    }
+
+    return result;
+}
+
+static void stop_broker(LOOPBACK_IO_INSTANCE* instance)
+{
+    if (instance->broker != NULL)
+    {
+        void* broker = instance->broker;
+        instance->broker = NULL;
+        /* Destroys the broker end of the IO, which detaches itself from this end. */
+        instance->broker_interface->destroy(broker);
+    }
+}
+
+static void loopback_io_destroy(CONCRETE_IO_HANDLE handle)
+{
+    LOOPBACK_IO_INSTANCE* instance = (LOOPBACK_IO_INSTANCE*)handle;
+
+    if (instance != NULL)
+    {
+        stop_broker(instance);
+
+        if (instance->peer != NULL)
+        {
+            instance->peer->peer = NULL;
+        }
+
+        if (instance->broker_interface != NULL)
+        {
+            LOOPBACK_IO_INSTANCE** device_end;
+
+            lock_globals();
+            device_end = &g_device_ends;
+            while (*device_end != NULL && *device_end != instance)
+            {
+                device_end = &(*device_end)->next_device_end;
+            }
+            if (*device_end != NULL)
+            {
+                *device_end = instance->next_device_end;
+            }
+            unlock_globals();
+        }
+
+        free(instance->pending);
+        free(instance->delivering);
+        free(instance);
+    }
+}
+
+static int loopback_io_open(CONCRETE_IO_HANDLE handle, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    int result;
+    LOOPBACK_IO_INSTANCE* instance = (LOOPBACK_IO_INSTANCE*)handle;
+
+    if (instance == NULL || instance->is_open || instance->is_open_pending)
+    {
+        LogError("Invalid loopback IO open");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        instance->on_io_open_complete = on_io_open_complete;
+        instance->on_io_open_complete_context = on_io_open_complete_context;
+        instance->on_bytes_received = on_bytes_received;
+        instance->on_bytes_received_context = on_bytes_received_context;
+        instance->on_io_error = on_io_error;
+        instance->on_io_error_context = on_io_error_context;
+        instance->pending_size = 0;
+
+        if (instance->broker_interface != NULL)
+        {
+            LOOPBACK_IO_CONFIG broker_config;
+            XIO_HANDLE broker_io;
+
+            broker_config.broker_interface = NULL;
+            broker_config.peer = instance;
+
+            if ((broker_io = xio_create(loopback_io_get_interface_description(), &broker_config)) == NULL)
+            {
+                LogError("Failed creating the broker end of the loopback IO");
+                result = MU_FAILURE;
+            }
+            else if ((instance->broker = instance->broker_interface->create(broker_io)) == NULL)
+            {
+                LogError("Failed starting the broker stand-in");
+                xio_destroy(broker_io);
+                result = MU_FAILURE;
+            }
+            else
+            {
+                instance->handshake_done_ms = get_time_ms() + g_handshake_ms;
+                instance->is_open_pending = true;
+                result = 0;
+            }
+        }
+        else
+        {
+            instance->handshake_done_ms = 0;
+            instance->is_open_pending = true;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int loopback_io_close(CONCRETE_IO_HANDLE handle, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+{
+    int result;
+    LOOPBACK_IO_INSTANCE* instance = (LOOPBACK_IO_INSTANCE*)handle;
+
+    if (instance == NULL)
+    {
+        result = MU_FAILURE;
+    }
+    else
+    {
+        instance->is_open = false;
+        instance->is_open_pending = false;
+        instance->pending_size = 0;
+        stop_broker(instance);
+
+        if (on_io_close_complete != NULL)
+        {
+            on_io_close_complete(callback_context);
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
+static int loopback_io_send(CONCRETE_IO_HANDLE handle, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+    LOOPBACK_IO_INSTANCE* instance = (LOOPBACK_IO_INSTANCE*)handle;
+
+    if (instance == NULL || buffer == NULL || size == 0 || !instance->is_open || instance->peer == NULL)
+    {
+        LogError("Invalid loopback IO send");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        LOOPBACK_IO_INSTANCE* peer = instance->peer;
+
+        if (peer->pending_size + size > peer->pending_capacity)
+        {
+            size_t new_capacity = (peer->pending_capacity == 0) ? 4096 : peer->pending_capacity;
+            unsigned char* new_pending;
+
+            while (new_capacity < peer->pending_size + size)
+            {
+                new_capacity *= 2;
+            }
+
+            if ((new_pending = (unsigned char*)realloc(peer->pending, new_capacity)) != NULL)
+            {
+                peer->pending = new_pending;
+                peer->pending_capacity = new_capacity;
+            }
+        }
+
+        if (peer->pending_size + size > peer->pending_capacity)
+        {
+            LogError("Failed growing the loopback buffer");
+            result = MU_FAILURE;
+        }
+        else
+        {
+            (void)memcpy(peer->pending + peer->pending_size, buffer, size);
+            peer->pending_size += size;
+
+            if (on_send_complete != NULL)
+            {
+                on_send_complete(callback_context, IO_SEND_OK);
+            }
+
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void loopback_io_dowork(CONCRETE_IO_HANDLE handle)
+{
+    LOOPBACK_IO_INSTANCE* instance = (LOOPBACK_IO_INSTANCE*)handle;
+
+    if (instance != NULL)
+    {
+        if (instance->is_open_pending && get_time_ms() >= instance->handshake_done_ms)
+        {
+            instance->is_open_pending = false;
+            instance->is_open = true;
+
+            if (instance->on_io_open_complete != NULL)
+            {
+                instance->on_io_open_complete(instance->on_io_open_complete_context, IO_OPEN_OK);
+            }
+        }
+
+        /* Let the stand-in process what was sent so far, so its replies are delivered in this same dowork. */
+        if (instance->broker != NULL)
+        {
+            instance->broker_interface->dowork(instance->broker);
+        }
+
+        if (instance->is_open && instance->pending_size > 0)
+        {
+            unsigned char* bytes = instance->pending;
+            size_t size = instance->pending_size;
+            size_t capacity = instance->pending_capacity;
+
+            instance->pending = instance->delivering;
+            instance->pending_capacity = instance->delivering_capacity;
+            instance->pending_size = 0;
+            instance->delivering = bytes;
+            instance->delivering_capacity = capacity;
+
+            if (instance->on_bytes_received != NULL)
+            {
+                instance->on_bytes_received(instance->on_bytes_received_context, bytes, size);
+            }
+        }
+    }
+}
+
+static const IO_INTERFACE_DESCRIPTION loopback_io_interface_description =
+{
+    loopback_io_retrieveoptions,
+    loopback_io_create,
+    loopback_io_destroy,
+    loopback_io_open,
+    loopback_io_close,
+    loopback_io_send,
+    loopback_io_dowork,
+    loopback_io_setoption
+};
+
+const IO_INTERFACE_DESCRIPTION* loopback_io_get_interface_description(void)
+{
+    return &loopback_io_interface_description;
+}
+
+void loopback_io_set_handshake_time(unsigned int handshake_ms)
+{
+    g_handshake_ms = handshake_ms;
+}
+
+void loopback_io_set_multithreaded(bool is_multithreaded)
+{
+    if (is_multithreaded && g_lock == NULL)
+    {
+        if ((g_lock = Lock_Init()) == NULL)
+        {
+            LogError("Failed creating the lock of the loopback IO");
+        }
+    }
+    else if (!is_multithreaded && g_lock != NULL)
+    {
+        Lock_Deinit(g_lock);
+        g_lock = NULL;
+    }
+}
+
+void loopback_io_drop_connections(void)
+{
+    LOOPBACK_IO_INSTANCE* instance = g_device_ends;
+
+    while (instance != NULL)
+    {
+        /* The error callback may lead the transport to destroy the IO. */
+        LOOPBACK_IO_INSTANCE* next_device_end = instance->next_device_end;
+
+        if (instance->is_open)
+        {
+            instance->is_open = false;
+            instance->pending_size = 0;
+            stop_broker(instance);
+
+            if (instance->on_io_error != NULL)
+            {
+                instance->on_io_error(instance->on_io_error_context);
+            }
+        }
+
+        instance = next_device_end;
+    }
+}
@@ -0,0 +1,55 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// In-process replacement for the TLS IO used by the transports.  Opening the IO creates a second, "broker" end and
+// starts the broker stand-in on it; bytes sent on one end are delivered to the other end on its next dowork, so the
+// transport and the stand-in never reenter each other from within a send.
+
+#ifndef LOOPBACK_IO_H
+#define LOOPBACK_IO_H
+
+#include "azure_c_shared_utility/xio.h"
+
+#ifdef __cplusplus
+#include <cstdbool>
+#else
+#include <stdbool.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct LOOPBACK_BROKER_INTERFACE_TAG
+{
+    /* Starts the stand-in on the broker end of the IO.  The stand-in owns broker_io and opens it. */
+    void* (*create)(XIO_HANDLE broker_io);
+    void (*destroy)(void* broker);
+    void (*dowork)(void* broker);
+} LOOPBACK_BROKER_INTERFACE;
+
+typedef struct LOOPBACK_IO_CONFIG_TAG
+{
+    /* Stand-in started when the device end is opened. */
+    const LOOPBACK_BROKER_INTERFACE* broker_interface;
+    /* Internal, set when creating the broker end. */
+    void* peer;
+} LOOPBACK_IO_CONFIG;
+
+extern const IO_INTERFACE_DESCRIPTION* loopback_io_get_interface_description(void);
+
+/* Simulated TLS handshake: opening a device end completes after handshake_ms, 0 by default. */
+extern void loopback_io_set_handshake_time(unsigned int handshake_ms);
+
+/* Guards the state shared by all the IOs with a lock, for clients that run on several threads (a client group).  Turn it
+   on before creating the clients and off after destroying them. */
+extern void loopback_io_set_multithreaded(bool is_multithreaded);
+
+/* Fails every open device end with an IO error, as a network outage would.  Only for clients run on the calling thread. */
+extern void loopback_io_drop_connections(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOOPBACK_IO_H */
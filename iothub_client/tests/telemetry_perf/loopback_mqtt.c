@@ -0,0 +1,330 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// MQTT stand-in: accepts any CONNECT, acknowledges QoS 1 PUBLISHes, grants every SUBSCRIBE and answers PINGREQs.
+// Nothing is ever published to the device.
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "internal/iothub_transport_ll_private.h"
+#include "internal/iothubtransport_mqtt_common.h"
+#include "iothubtransportmqtt.h"
+
+#include "loopback_io.h"
+#include "loopback_transport.h"
+
+#define MQTT_PACKET_CONNECT             0x10
+#define MQTT_PACKET_CONNACK             0x20
+#define MQTT_PACKET_PUBLISH             0x30
+#define MQTT_PACKET_PUBACK              0x40
+#define MQTT_PACKET_SUBSCRIBE           0x80
+#define MQTT_PACKET_SUBACK              0x90
+#define MQTT_PACKET_UNSUBSCRIBE         0xA0
+#define MQTT_PACKET_UNSUBACK            0xB0
+#define MQTT_PACKET_PINGREQ             0xC0
+#define MQTT_PACKET_PINGRESP            0xD0
+#define MQTT_PACKET_DISCONNECT          0xE0
+
+#define MQTT_PUBLISH_QOS_MASK           0x06
+
+#define MAX_SUBSCRIBE_TOPICS            32
+
+typedef struct LOOPBACK_MQTT_BROKER_TAG
+{
+    XIO_HANDLE io;
+    unsigned char* received;
+    size_t received_size;
+    size_t received_capacity;
+} LOOPBACK_MQTT_BROKER;
+
+static int send_packet(LOOPBACK_MQTT_BROKER* broker, const unsigned char* packet, size_t size)
+{
+    int result;
+
+    if (xio_send(broker->io, packet, size, NULL, NULL) != 0)
+    {
+        LogError("MQTT stand-in failed sending a reply");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static int process_packet(LOOPBACK_MQTT_BROKER* broker, unsigned char header, const unsigned char* payload, size_t size)
+{
+    int result;
+
+    switch (header & 0xF0)
+    {
+        case MQTT_PACKET_CONNECT:
+        {
+            static const unsigned char connack[] = { MQTT_PACKET_CONNACK, 0x02, 0x00, 0x00 };
+            result = send_packet(broker, connack, sizeof(connack));
+            break;
+        }
+        case MQTT_PACKET_PUBLISH:
+        {
+            size_t topic_length = (size >= 2) ? (((size_t)payload[0] << 8) | payload[1]) : 0;
+
+            if (size < 2 || 2 + topic_length > size)
+            {
+                LogError("MQTT stand-in received a malformed PUBLISH");
+                result = MU_FAILURE;
+            }
+            else if ((header & MQTT_PUBLISH_QOS_MASK) == 0)
+            {
+                result = 0;
+            }
+            else if (2 + topic_length + 2 > size)
+            {
+                LogError("MQTT stand-in received a PUBLISH without packet identifier");
+                result = MU_FAILURE;
+            }
+            else
+            {
+                unsigned char puback[4];
+                puback[0] = MQTT_PACKET_PUBACK;
+                puback[1] = 0x02;
+                puback[2] = payload[2 + topic_length];
+                puback[3] = payload[2 + topic_length + 1];
+                result = send_packet(broker, puback, sizeof(puback));
+            }
+            break;
+        }
+        case MQTT_PACKET_SUBSCRIBE:
+        {
+            unsigned char suback[4 + MAX_SUBSCRIBE_TOPICS];
+            size_t topic_count = 0;
+            size_t position = 2;
+
+            while (position + 2 <= size && topic_count < MAX_SUBSCRIBE_TOPICS)
+            {
+                size_t topic_length = ((size_t)payload[position] << 8) | payload[position + 1];
+                position += 2 + topic_length;
+
+                if (position >= size)
+                {
+                    break;
+                }
+
+                suback[4 + topic_count] = payload[position] & 0x03;
+                topic_count++;
+                position++;
+            }
+
+            if (size < 2 || topic_count == 0)
+            {
+                LogError("MQTT stand-in received a malformed SUBSCRIBE");
+                result = MU_FAILURE;
+            }
+            else
+            {
+                /* Remaining length fits in a single byte given MAX_SUBSCRIBE_TOPICS. */
+                suback[0] = MQTT_PACKET_SUBACK;
+                suback[1] = (unsigned char)(2 + topic_count);
+                suback[2] = payload[0];
+                suback[3] = payload[1];
+                result = send_packet(broker, suback, 2 + 2 + topic_count);
+            }
+            break;
+        }
+        case MQTT_PACKET_UNSUBSCRIBE:
+        {
+            unsigned char unsuback[4];
+
+            if (size < 2)
+            {
+                LogError("MQTT stand-in received a malformed UNSUBSCRIBE");
+                result = MU_FAILURE;
+            }
+            else
+            {
+                unsuback[0] = MQTT_PACKET_UNSUBACK;
+                unsuback[1] = 0x02;
+                unsuback[2] = payload[0];
+                unsuback[3] = payload[1];
+                result = send_packet(broker, unsuback, sizeof(unsuback));
+            }
+            break;
+        }
+        case MQTT_PACKET_PINGREQ:
+        {
+            static const unsigned char pingresp[] = { MQTT_PACKET_PINGRESP, 0x00 };
+            result = send_packet(broker, pingresp, sizeof(pingresp));
+            break;
+        }
+        default:
+            /* PUBACK, DISCONNECT... need no reply. */
+            result = 0;
+            break;
+    }
+
+    return result;
+}
+
+static void process_received_packets(LOOPBACK_MQTT_BROKER* broker)
+{
+    size_t position = 0;
+
+    /* Process every complete packet; a partial one stays in the buffer until the rest arrives. */
+    while (position + 2 <= broker->received_size)
+    {
+        size_t remaining_length = 0;
+        size_t multiplier = 1;
+        size_t header_size = 1;
+        bool is_length_complete = false;
+
+        while (position + header_size < broker->received_size && header_size <= 4)
+        {
+            unsigned char encoded = broker->received[position + header_size];
+            remaining_length += (encoded & 0x7F) * multiplier;
+            multiplier *= 128;
+            header_size++;
+
+            if ((encoded & 0x80) == 0)
+            {
+                is_length_complete = true;
+                break;
+            }
+        }
+
+        if (!is_length_complete || position + header_size + remaining_length > broker->received_size)
+        {
+            break;
+        }
+
+        (void)process_packet(broker, broker->received[position], broker->received + position + header_size, remaining_length);
+        position += header_size + remaining_length;
+    }
+
+    if (position > 0)
+    {
+        (void)memmove(broker->received, broker->received + position, broker->received_size - position);
+        broker->received_size -= position;
+    }
+}
+
+static void on_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    LOOPBACK_MQTT_BROKER* broker = (LOOPBACK_MQTT_BROKER*)context;
+
+    if (broker->received_size + size > broker->received_capacity)
+    {
+        unsigned char* new_received;
+
+        if ((new_received = (unsigned char*)realloc(broker->received, broker->received_size + size)) != NULL)
+        {
+            broker->received = new_received;
+            broker->received_capacity = broker->received_size + size;
+        }
+    }
+
+    if (broker->received_size + size > broker->received_capacity)
+    {
+        LogError("MQTT stand-in failed growing its receive buffer");
+    }
+    else
+    {
+        (void)memcpy(broker->received + broker->received_size, buffer, size);
+        broker->received_size += size;
+        process_received_packets(broker);
+    }
+}
+
+static void on_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    (void)context;
+
+    if (open_result != IO_OPEN_OK)
+    {
+        LogError("MQTT stand-in failed opening its end of the loopback");
+    }
+}
+
+static void on_io_error(void* context)
+{
+    (void)context;
+    LogError("MQTT stand-in IO error");
+}
+
+static void* loopback_mqtt_broker_create(XIO_HANDLE broker_io)
+{
+    LOOPBACK_MQTT_BROKER* result;
+
+    if ((result = (LOOPBACK_MQTT_BROKER*)calloc(1, sizeof(LOOPBACK_MQTT_BROKER))) == NULL)
+    {
+        LogError("Failed allocating the MQTT stand-in");
+    }
+    else
+    {
+        result->io = broker_io;
+
+        if (xio_open(broker_io, on_io_open_complete, result, on_bytes_received, result, on_io_error, result) != 0)
+        {
+            LogError("MQTT stand-in failed opening its end of the loopback");
+            free(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+static void loopback_mqtt_broker_destroy(void* broker)
+{
+    LOOPBACK_MQTT_BROKER* instance = (LOOPBACK_MQTT_BROKER*)broker;
+
+    xio_destroy(instance->io);
+    free(instance->received);
+    free(instance);
+}
+
+static void loopback_mqtt_broker_dowork(void* broker)
+{
+    LOOPBACK_MQTT_BROKER* instance = (LOOPBACK_MQTT_BROKER*)broker;
+
+    xio_dowork(instance->io);
+}
+
+static const LOOPBACK_BROKER_INTERFACE loopback_mqtt_broker_interface =
+{
+    loopback_mqtt_broker_create,
+    loopback_mqtt_broker_destroy,
+    loopback_mqtt_broker_dowork
+};
+
+static XIO_HANDLE get_loopback_io(const char* fully_qualified_name, const MQTT_TRANSPORT_PROXY_OPTIONS* mqtt_transport_proxy_options)
+{
+    LOOPBACK_IO_CONFIG config;
+
+    (void)fully_qualified_name;
+    (void)mqtt_transport_proxy_options;
+
+    config.broker_interface = &loopback_mqtt_broker_interface;
+    config.peer = NULL;
+
+    return xio_create(loopback_io_get_interface_description(), &config);
+}
+
+static TRANSPORT_LL_HANDLE loopback_mqtt_create(const IOTHUBTRANSPORT_CONFIG* config, TRANSPORT_CALLBACKS_INFO* cb_info, void* ctx)
+{
+    return IoTHubTransport_MQTT_Common_Create(config, get_loopback_io, cb_info, ctx);
+}
+
+static TRANSPORT_PROVIDER loopback_mqtt_provider;
+
+const TRANSPORT_PROVIDER* Loopback_MQTT_Protocol(void)
+{
+    /* Same provider as MQTT_Protocol, only the IO handed to the transport differs. */
+    loopback_mqtt_provider = *MQTT_Protocol();
+    loopback_mqtt_provider.IoTHubTransport_Create = loopback_mqtt_create;
+    return &loopback_mqtt_provider;
+}
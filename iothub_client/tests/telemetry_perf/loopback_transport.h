@@ -0,0 +1,22 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef LOOPBACK_TRANSPORT_H
+#define LOOPBACK_TRANSPORT_H
+
+#include "internal/iothub_transport_ll_private.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The MQTT and AMQP transports of the SDK, talking to an in-process stand-in instead of the TLS IO.  The HTTP transport
+   is used as is (HTTP_Protocol), loopback_httpapi.c replaces the HTTPAPI adapter underneath it. */
+extern const TRANSPORT_PROVIDER* Loopback_MQTT_Protocol(void);
+extern const TRANSPORT_PROVIDER* Loopback_AMQP_Protocol(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOOPBACK_TRANSPORT_H */
@@ -0,0 +1,374 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// Measures telemetry throughput and cost through IoTHubDeviceClient_LL with each transport, against in-process
+// stand-ins of the hub (see loopback_mqtt.c, loopback_amqp.c and loopback_httpapi.c), so no network or IoT Hub is
+// needed and runs are reproducible.  The transports, the client and the messages are the real ones; only the TLS IO
+// (MQTT, AMQP) or the HTTPAPI adapter (HTTP) is replaced.  Up to max_in_flight messages are kept queued, DoWork is
+// called in a tight loop and the connection is established by a warm-up round before measuring.
+//
+// Output is CSV on stdout, one line per transport:
+//     protocol,messages,message_bytes,max_in_flight,elapsed_ms,msgs_per_sec,p50_latency_us,p99_latency_us,allocations_per_msg,cpu_us_per_msg
+//
+// Latency is measured from IoTHubDeviceClient_LL_SendEventAsync to the confirmation callback.  allocations_per_msg
+// counts the allocations made through gballoc, that is by the iothub_client libraries when built with
+// -Dmemory_trace=ON (it is 0 otherwise); the stand-ins allocate from the CRT so they are not counted.  cpu_us_per_msg
+// is process CPU time and includes the stand-in, which only parses what is needed to acknowledge.
+//
+// When a trace_file is given (which needs the SDK built with -Duse_tracing=ON), the trace points of the measured
+// messages are written to it, one "point,message_id,timestamp_ns" line each, for trace_breakdown.
+//
+// Usage: telemetry_perf [messages [message_bytes [max_in_flight [trace_file]]]]
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/platform.h"
+#include "iothub.h"
+#include "iothub_device_client_ll.h"
+#include "iothub_message.h"
+#include "iothub_client_tracing.h"
+
+#ifdef USE_HTTP
+#include "iothubtransporthttp.h"
+#endif
+
+#include "loopback_transport.h"
+
+static const size_t DEFAULT_MESSAGES = 10000;
+static const size_t DEFAULT_MESSAGE_BYTES = 256;
+static const size_t DEFAULT_MAX_IN_FLIGHT = 64;
+
+static const size_t WARMUP_MESSAGES = 100;
+static const uint64_t STALL_TIMEOUT_US = 10 * 1000 * 1000;
+
+static const char* CONNECTION_STRING = "HostName=loopback.azure-devices.net;DeviceId=telemetry-perf;x509=true";
+
+typedef struct PROTOCOL_ENTRY_TAG
+{
+    const char* name;
+    IOTHUB_CLIENT_TRANSPORT_PROVIDER protocol;
+} PROTOCOL_ENTRY;
+
+static const PROTOCOL_ENTRY PROTOCOLS[] =
+{
+#ifdef USE_MQTT
+    { "mqtt", Loopback_MQTT_Protocol },
+#endif
+#ifdef USE_AMQP
+    { "amqp", Loopback_AMQP_Protocol },
+#endif
+#ifdef USE_HTTP
+    { "http", HTTP_Protocol },
+#endif
+};
+
+struct BENCHMARK_RUN_TAG;
+
+typedef struct SEND_RECORD_TAG
+{
+    struct BENCHMARK_RUN_TAG* run;
+    uint64_t queued_us;
+    uint64_t latency_us;
+} SEND_RECORD;
+
+typedef struct BENCHMARK_RUN_TAG
+{
+    IOTHUB_DEVICE_CLIENT_LL_HANDLE client;
+    const unsigned char* body;
+    size_t message_bytes;
+    size_t max_in_flight;
+    SEND_RECORD* records;
+    size_t completed;
+    size_t failed;
+} BENCHMARK_RUN;
+
+static uint64_t get_time_us(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+    (void)QueryPerformanceCounter(&counter);
+    (void)QueryPerformanceFrequency(&frequency);
+    return (uint64_t)((counter.QuadPart * 1000000.0) / frequency.QuadPart);
+#else
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000) + ((uint64_t)now.tv_nsec / 1000);
+#endif
+}
+
+static void on_send_confirmation(IOTHUB_CLIENT_CONFIRMATION_RESULT result, void* userContextCallback)
+{
+    SEND_RECORD* record = (SEND_RECORD*)userContextCallback;
+
+    record->latency_us = get_time_us() - record->queued_us;
+    record->run->completed++;
+
+    if (result != IOTHUB_CLIENT_CONFIRMATION_OK)
+    {
+        record->run->failed++;
+    }
+}
+
+static int send_messages(BENCHMARK_RUN* run, size_t count)
+{
+    int result = 0;
+    size_t sent = 0;
+    uint64_t last_progress_us = get_time_us();
+
+    run->completed = 0;
+    run->failed = 0;
+
+    while (result == 0 && run->completed < count)
+    {
+        size_t completed = run->completed;
+
+        while (result == 0 && sent < count && sent - run->completed < run->max_in_flight)
+        {
+            IOTHUB_MESSAGE_HANDLE message;
+            SEND_RECORD* record = &run->records[sent];
+
+            record->run = run;
+            record->queued_us = get_time_us();
+
+            if ((message = IoTHubMessage_CreateFromByteArray(run->body, run->message_bytes)) == NULL)
+            {
+                (void)printf("Unable to create message %lu\r\n", (unsigned long)sent);
+                result = __LINE__;
+            }
+            else
+            {
+                if (IoTHubDeviceClient_LL_SendEventAsync(run->client, message, on_send_confirmation, record) != IOTHUB_CLIENT_OK)
+                {
+                    (void)printf("Unable to send message %lu\r\n", (unsigned long)sent);
+                    result = __LINE__;
+                }
+                else
+                {
+                    sent++;
+                }
+
+                IoTHubMessage_Destroy(message);
+            }
+        }
+
+        if (result == 0)
+        {
+            uint64_t now_us;
+
+            IoTHubDeviceClient_LL_DoWork(run->client);
+            now_us = get_time_us();
+
+            if (run->completed != completed)
+            {
+                last_progress_us = now_us;
+            }
+            else if (now_us - last_progress_us > STALL_TIMEOUT_US)
+            {
+                (void)printf("No confirmation received for %lu seconds (%lu of %lu messages confirmed)\r\n",
+                    (unsigned long)(STALL_TIMEOUT_US / 1000000), (unsigned long)run->completed, (unsigned long)count);
+                result = __LINE__;
+            }
+        }
+    }
+
+    if (result == 0 && run->failed > 0)
+    {
+        (void)printf("%lu of %lu messages were not confirmed OK\r\n", (unsigned long)run->failed, (unsigned long)count);
+        result = __LINE__;
+    }
+
+    return result;
+}
+
+static int compare_latencies(const void* left, const void* right)
+{
+    uint64_t left_latency = ((const SEND_RECORD*)left)->latency_us;
+    uint64_t right_latency = ((const SEND_RECORD*)right)->latency_us;
+    return (left_latency < right_latency) ? -1 : ((left_latency > right_latency) ? 1 : 0);
+}
+
+static uint64_t get_percentile(const SEND_RECORD* sorted_records, size_t count, size_t percentile)
+{
+    // Nearest rank.
+    size_t rank = (count * percentile + 99) / 100;
+    return sorted_records[(rank == 0) ? 0 : rank - 1].latency_us;
+}
+
+static void write_trace_point(IOTHUB_CLIENT_TRACE_POINT point, uint64_t messageId, uint64_t timestampNs, void* userContext)
+{
+    (void)fprintf((FILE*)userContext, "%s,%llu,%llu\n", MU_ENUM_TO_STRING(IOTHUB_CLIENT_TRACE_POINT, point), (unsigned long long)messageId, (unsigned long long)timestampNs);
+}
+
+static int run_benchmark(const PROTOCOL_ENTRY* protocol, const unsigned char* body, size_t messages, size_t message_bytes, size_t max_in_flight, FILE* trace_file)
+{
+    int result;
+    BENCHMARK_RUN run;
+
+    run.body = body;
+    run.message_bytes = message_bytes;
+    run.max_in_flight = max_in_flight;
+
+    if ((run.records = (SEND_RECORD*)malloc(sizeof(SEND_RECORD) * (messages > WARMUP_MESSAGES ? messages : WARMUP_MESSAGES))) == NULL)
+    {
+        (void)printf("Unable to allocate the send records\r\n");
+        result = __LINE__;
+    }
+    else
+    {
+        if ((run.client = IoTHubDeviceClient_LL_CreateFromConnectionString(CONNECTION_STRING, protocol->protocol)) == NULL)
+        {
+            (void)printf("Unable to create the %s client\r\n", protocol->name);
+            result = __LINE__;
+        }
+        else
+        {
+            if (send_messages(&run, WARMUP_MESSAGES) != 0)
+            {
+                (void)printf("%s warm-up failed\r\n", protocol->name);
+                result = __LINE__;
+            }
+            else if (trace_file != NULL && IoTHubClient_SetTraceCallback(write_trace_point, trace_file) != IOTHUB_CLIENT_OK)
+            {
+                (void)printf("Unable to set the trace callback (is the SDK built with use_tracing?)\r\n");
+                result = __LINE__;
+            }
+            else
+            {
+                clock_t cpu_start;
+                uint64_t start_us;
+                uint64_t elapsed_us;
+                double cpu_us;
+                size_t allocations;
+
+                gballoc_resetMetrics();
+                cpu_start = clock();
+                start_us = get_time_us();
+
+                result = send_messages(&run, messages);
+
+                // Every measured message is confirmed by now, so none of them is still being traced
+                if (trace_file != NULL)
+                {
+                    (void)IoTHubClient_SetTraceCallback(NULL, NULL);
+                }
+
+                elapsed_us = get_time_us() - start_us;
+                cpu_us = ((double)(clock() - cpu_start) * 1000000.0) / CLOCKS_PER_SEC;
+                allocations = gballoc_getAllocationCount();
+
+                if (result != 0)
+                {
+                    (void)printf("%s run failed\r\n", protocol->name);
+                }
+                else
+                {
+                    qsort(run.records, messages, sizeof(SEND_RECORD), compare_latencies);
+
+                    (void)printf("%s,%lu,%lu,%lu,%.3f,%.1f,%lu,%lu,%.2f,%.2f\r\n",
+                        protocol->name,
+                        (unsigned long)messages,
+                        (unsigned long)message_bytes,
+                        (unsigned long)max_in_flight,
+                        elapsed_us / 1000.0,
+                        (elapsed_us > 0) ? (messages * 1000000.0) / elapsed_us : 0.0,
+                        (unsigned long)get_percentile(run.records, messages, 50),
+                        (unsigned long)get_percentile(run.records, messages, 99),
+                        (double)allocations / messages,
+                        cpu_us / messages);
+                }
+            }
+
+            IoTHubDeviceClient_LL_Destroy(run.client);
+        }
+
+        free(run.records);
+    }
+
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    int result;
+    long messages = (argc > 1) ? atol(argv[1]) : (long)DEFAULT_MESSAGES;
+    long message_bytes = (argc > 2) ? atol(argv[2]) : (long)DEFAULT_MESSAGE_BYTES;
+    long max_in_flight = (argc > 3) ? atol(argv[3]) : (long)DEFAULT_MAX_IN_FLIGHT;
+    const char* trace_file_name = (argc > 4) ? argv[4] : NULL;
+    FILE* trace_file = NULL;
+
+    if (messages <= 0 || message_bytes <= 0 || max_in_flight <= 0)
+    {
+        (void)printf("usage: telemetry_perf [messages [message_bytes [max_in_flight [trace_file]]]]\r\n");
+        result = EXIT_FAILURE;
+    }
+    else if (trace_file_name != NULL && (trace_file = fopen(trace_file_name, "w")) == NULL)
+    {
+        (void)printf("Unable to open %s\r\n", trace_file_name);
+        result = EXIT_FAILURE;
+    }
+    else if (gballoc_init() != 0)
+    {
+        (void)printf("gballoc_init failed\r\n");
+        result = EXIT_FAILURE;
+    }
+    else
+    {
+        unsigned char* body;
+
+        if (IoTHub_Init() != 0)
+        {
+            (void)printf("IoTHub_Init failed\r\n");
+            result = EXIT_FAILURE;
+        }
+        else
+        {
+            if ((body = (unsigned char*)malloc((size_t)message_bytes)) == NULL)
+            {
+                (void)printf("Unable to allocate %ld bytes for the message body\r\n", message_bytes);
+                result = EXIT_FAILURE;
+            }
+            else
+            {
+                size_t i;
+
+                (void)memset(body, 'A', (size_t)message_bytes);
+                result = EXIT_SUCCESS;
+
+                (void)printf("protocol,messages,message_bytes,max_in_flight,elapsed_ms,msgs_per_sec,p50_latency_us,p99_latency_us,allocations_per_msg,cpu_us_per_msg\r\n");
+
+                for (i = 0; i < sizeof(PROTOCOLS) / sizeof(PROTOCOLS[0]); i++)
+                {
+                    if (run_benchmark(&PROTOCOLS[i], body, (size_t)messages, (size_t)message_bytes, (size_t)max_in_flight, trace_file) != 0)
+                    {
+                        result = EXIT_FAILURE;
+                    }
+                }
+
+                free(body);
+            }
+
+            IoTHub_Deinit();
+        }
+
+        gballoc_deinit();
+    }
+
+    if (trace_file != NULL)
+    {
+        (void)fclose(trace_file);
+    }
+
+    return result;
+}
@@ -0,0 +1,307 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// Breaks the latency of device-to-cloud messages down by stage, from a trace of the points reported to an
+// IoTHubClient_SetTraceCallback callback (see iothub_client_tracing.h) written one per line as
+//     point,message_id,timestamp_ns
+// with point the name of the IOTHUB_CLIENT_TRACE_POINT, as telemetry_perf writes it.  Lines that do not parse are
+// skipped.  The first occurrence of a point is used when a message passes it more than once (MQTT republishes the
+// messages in flight after a reconnect).
+//
+// Output is CSV on stdout, one line per stage, then one line of totals:
+//     stage,count,mean_us,p50_us,p90_us,p99_us,max_us
+//     messages,<traced>,acknowledged,<count>,abandoned,<count>,incomplete,<count>
+//
+// The stages are queued (ENQUEUED to DEQUEUED), encode (DEQUEUED to WRITTEN), ack (WRITTEN to ACKNOWLEDGED) and
+// total (ENQUEUED to ACKNOWLEDGED).  HTTP messages have no DEQUEUED and WRITTEN points, so they only count in total.
+//
+// Usage: trace_breakdown [trace_file]   (reads stdin when no file is given)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "iothub_client_tracing.h"
+
+#define TRACE_POINT_COUNT   (IOTHUB_CLIENT_TRACE_ABANDONED + 1)
+#define MAX_LINE_LENGTH     128
+
+typedef struct TRACE_EVENT_TAG
+{
+    IOTHUB_CLIENT_TRACE_POINT point;
+    uint64_t message_id;
+    uint64_t timestamp_ns;
+} TRACE_EVENT;
+
+typedef struct STAGE_TAG
+{
+    const char* name;
+    IOTHUB_CLIENT_TRACE_POINT from;
+    IOTHUB_CLIENT_TRACE_POINT to;
+} STAGE;
+
+static const STAGE STAGES[] =
+{
+    { "queued", IOTHUB_CLIENT_TRACE_ENQUEUED, IOTHUB_CLIENT_TRACE_DEQUEUED },
+    { "encode", IOTHUB_CLIENT_TRACE_DEQUEUED, IOTHUB_CLIENT_TRACE_WRITTEN },
+    { "ack", IOTHUB_CLIENT_TRACE_WRITTEN, IOTHUB_CLIENT_TRACE_ACKNOWLEDGED },
+    { "total", IOTHUB_CLIENT_TRACE_ENQUEUED, IOTHUB_CLIENT_TRACE_ACKNOWLEDGED },
+};
+
+#define STAGE_COUNT (sizeof(STAGES) / sizeof(STAGES[0]))
+
+static int parse_line(char* line, TRACE_EVENT* event)
+{
+    int result = __LINE__;
+    char* separator = strchr(line, ',');
+
+    if (separator != NULL)
+    {
+        unsigned long long message_id;
+        unsigned long long timestamp_ns;
+        size_t i;
+
+        *separator = '\0';
+
+        for (i = 0; i < TRACE_POINT_COUNT; i++)
+        {
+            if (strcmp(line, MU_ENUM_TO_STRING(IOTHUB_CLIENT_TRACE_POINT, (IOTHUB_CLIENT_TRACE_POINT)i)) == 0)
+            {
+                break;
+            }
+        }
+
+        if (i < TRACE_POINT_COUNT && sscanf(separator + 1, "%llu,%llu", &message_id, &timestamp_ns) == 2)
+        {
+            event->point = (IOTHUB_CLIENT_TRACE_POINT)i;
+            event->message_id = message_id;
+            event->timestamp_ns = timestamp_ns;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int read_trace(FILE* file, TRACE_EVENT** events, size_t* count)
+{
+    int result = 0;
+    size_t capacity = 0;
+    char line[MAX_LINE_LENGTH];
+
+    *events = NULL;
+    *count = 0;
+
+    while (result == 0 && fgets(line, sizeof(line), file) != NULL)
+    {
+        TRACE_EVENT event;
+
+        if (parse_line(line, &event) == 0)
+        {
+            if (*count == capacity)
+            {
+                size_t new_capacity = (capacity == 0) ? 1024 : capacity * 2;
+                TRACE_EVENT* new_events = (TRACE_EVENT*)realloc(*events, new_capacity * sizeof(TRACE_EVENT));
+
+                if (new_events == NULL)
+                {
+                    (void)printf("Unable to allocate %lu trace events\r\n", (unsigned long)new_capacity);
+                    result = __LINE__;
+                }
+                else
+                {
+                    *events = new_events;
+                    capacity = new_capacity;
+                }
+            }
+
+            if (result == 0)
+            {
+                (*events)[(*count)++] = event;
+            }
+        }
+    }
+
+    return result;
+}
+
+static int compare_events(const void* left, const void* right)
+{
+    const TRACE_EVENT* left_event = (const TRACE_EVENT*)left;
+    const TRACE_EVENT* right_event = (const TRACE_EVENT*)right;
+    int result;
+
+    if (left_event->message_id != right_event->message_id)
+    {
+        result = (left_event->message_id < right_event->message_id) ? -1 : 1;
+    }
+    else if (left_event->timestamp_ns != right_event->timestamp_ns)
+    {
+        result = (left_event->timestamp_ns < right_event->timestamp_ns) ? -1 : 1;
+    }
+    else
+    {
+        result = (left_event->point < right_event->point) ? -1 : ((left_event->point > right_event->point) ? 1 : 0);
+    }
+
+    return result;
+}
+
+static int compare_durations(const void* left, const void* right)
+{
+    uint64_t left_duration = *(const uint64_t*)left;
+    uint64_t right_duration = *(const uint64_t*)right;
+    return (left_duration < right_duration) ? -1 : ((left_duration > right_duration) ? 1 : 0);
+}
+
+static uint64_t get_percentile(const uint64_t* sorted_durations, size_t count, size_t percentile)
+{
+    // Nearest rank.
+    size_t rank = (count * percentile + 99) / 100;
+    return sorted_durations[(rank == 0) ? 0 : rank - 1];
+}
+
+static void print_stage(const char* name, uint64_t* durations, size_t count)
+{
+    if (count == 0)
+    {
+        (void)printf("%s,0,,,,,\r\n", name);
+    }
+    else
+    {
+        double total_ns = 0;
+        size_t i;
+
+        qsort(durations, count, sizeof(uint64_t), compare_durations);
+
+        for (i = 0; i < count; i++)
+        {
+            total_ns += (double)durations[i];
+        }
+
+        (void)printf("%s,%lu,%.1f,%.1f,%.1f,%.1f,%.1f\r\n",
+            name,
+            (unsigned long)count,
+            total_ns / count / 1000.0,
+            get_percentile(durations, count, 50) / 1000.0,
+            get_percentile(durations, count, 90) / 1000.0,
+            get_percentile(durations, count, 99) / 1000.0,
+            durations[count - 1] / 1000.0);
+    }
+}
+
+static int print_breakdown(TRACE_EVENT* events, size_t count)
+{
+    int result;
+    uint64_t* durations[STAGE_COUNT] = { NULL };
+    size_t duration_counts[STAGE_COUNT] = { 0 };
+    size_t messages = 0;
+    size_t acknowledged = 0;
+    size_t abandoned = 0;
+    size_t i;
+
+    result = 0;
+
+    for (i = 0; i < STAGE_COUNT && result == 0; i++)
+    {
+        // A message adds at most one duration per stage, and has at least one event
+        if ((durations[i] = (uint64_t*)malloc((count == 0 ? 1 : count) * sizeof(uint64_t))) == NULL)
+        {
+            (void)printf("Unable to allocate the durations\r\n");
+            result = __LINE__;
+        }
+    }
+
+    if (result == 0)
+    {
+        qsort(events, count, sizeof(TRACE_EVENT), compare_events);
+
+        i = 0;
+        while (i < count)
+        {
+            bool seen[TRACE_POINT_COUNT] = { false };
+            uint64_t timestamp_ns[TRACE_POINT_COUNT] = { 0 };
+            uint64_t message_id = events[i].message_id;
+            size_t stage;
+
+            for (; i < count && events[i].message_id == message_id; i++)
+            {
+                if (!seen[events[i].point])
+                {
+                    seen[events[i].point] = true;
+                    timestamp_ns[events[i].point] = events[i].timestamp_ns;
+                }
+            }
+
+            messages++;
+            if (seen[IOTHUB_CLIENT_TRACE_ACKNOWLEDGED])
+            {
+                acknowledged++;
+            }
+            else if (seen[IOTHUB_CLIENT_TRACE_ABANDONED])
+            {
+                abandoned++;
+            }
+
+            for (stage = 0; stage < STAGE_COUNT; stage++)
+            {
+                if (seen[STAGES[stage].from] && seen[STAGES[stage].to] && timestamp_ns[STAGES[stage].to] >= timestamp_ns[STAGES[stage].from])
+                {
+                    durations[stage][duration_counts[stage]++] = timestamp_ns[STAGES[stage].to] - timestamp_ns[STAGES[stage].from];
+                }
+            }
+        }
+
+        (void)printf("stage,count,mean_us,p50_us,p90_us,p99_us,max_us\r\n");
+        for (i = 0; i < STAGE_COUNT; i++)
+        {
+            print_stage(STAGES[i].name, durations[i], duration_counts[i]);
+        }
+        (void)printf("messages,%lu,acknowledged,%lu,abandoned,%lu,incomplete,%lu\r\n",
+            (unsigned long)messages, (unsigned long)acknowledged, (unsigned long)abandoned, (unsigned long)(messages - acknowledged - abandoned));
+    }
+
+    for (i = 0; i < STAGE_COUNT; i++)
+    {
+        free(durations[i]);
+    }
+
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    int result;
+    FILE* file = (argc > 1) ? fopen(argv[1], "r") : stdin;
+
+    if (file == NULL)
+    {
+        (void)printf("Unable to open %s\r\nusage: trace_breakdown [trace_file]\r\n", argv[1]);
+        result = EXIT_FAILURE;
+    }
+    else
+    {
+        TRACE_EVENT* events;
+        size_t count;
+
+        if (read_trace(file, &events, &count) != 0 || print_breakdown(events, count) != 0)
+        {
+            result = EXIT_FAILURE;
+        }
+        else
+        {
+            result = EXIT_SUCCESS;
+        }
+
+        free(events);
+
+        if (file != stdin)
+        {
+            (void)fclose(file);
+        }
+    }
+
+    return result;
+}
@@ -63,6 +63,7 @@ static void TEST_free(void* ptr)
 #include "azure_c_shared_utility/uuid.h"
 
 #include "iothub_message.h"
+#include "internal/iothub_message_private.h"
 #include "azure_uamqp_c/amqp_definitions_application_properties.h"
 #include "azure_uamqp_c/amqp_definitions_data.h"
 #include "azure_uamqp_c/message.h"
@@ -94,7 +95,8 @@ static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
 
 #define TEST_AMQP_ENCODING_SIZE 5
 
-static char g_encoding_buffer[TEST_AMQP_ENCODING_SIZE * 3];
+// Room for the mocked sections plus the data section (header and TEST_STRING body) written directly by the code under test.
+static char g_encoding_buffer[TEST_AMQP_ENCODING_SIZE * 3 + sizeof(TEST_STRING) + 8];
 
 #define UUID_N_OF_OCTECTS 16
 #define UUID_STRING_SIZE 37
@@ -188,12 +190,8 @@ static void set_exp_calls_for_create_encoded_annotations_properties(bool has_dia
 
         set_add_map_item();
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-
         // Add Map Item
         set_add_map_item();
-
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     }
     else
     {
@@ -271,16 +269,12 @@ static void set_exp_calls_for_create_encoded_application_properties(size_t numbe
 {
     size_t encoding_size = TEST_AMQP_ENCODING_SIZE;
 
-    STRICT_EXPECTED_CALL(IoTHubMessage_Properties(TEST_IOTHUB_MESSAGE_HANDLE)); //16
-
     STRICT_EXPECTED_CALL(IoTHubMessage_GetMessageCreationTimeUtcSystemProperty(TEST_IOTHUB_MESSAGE_HANDLE))
         .CallCannotFail();
-    STRICT_EXPECTED_CALL(Map_AddOrUpdate(TEST_MAP_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(IoTHubMessage_SetProperty(TEST_IOTHUB_MESSAGE_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
-    STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .CopyOutArgumentBuffer(2, &TEST_MAP_KEYS, sizeof(TEST_MAP_KEYS))
-        .CopyOutArgumentBuffer(3, &TEST_MAP_VALUES, sizeof(TEST_MAP_VALUES))
-        .CopyOutArgumentBuffer(4, &number_of_app_properties, sizeof(number_of_app_properties));
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetPropertyCount(TEST_IOTHUB_MESSAGE_HANDLE, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_count(&number_of_app_properties, sizeof(number_of_app_properties));
 
     if (number_of_app_properties > 0)
     {
@@ -288,6 +282,9 @@ static void set_exp_calls_for_create_encoded_application_properties(size_t numbe
 
         for (size_t i = 0; i < number_of_app_properties; i++)
         {
+            STRICT_EXPECTED_CALL(IoTHubMessage_GetNextProperty(TEST_IOTHUB_MESSAGE_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+                .CopyOutArgumentBuffer_key(&TEST_MAP_KEYS[i], sizeof(char*))
+                .CopyOutArgumentBuffer_value(&TEST_MAP_VALUES[i], sizeof(char*));
             STRICT_EXPECTED_CALL(amqpvalue_create_string(TEST_MAP_KEYS[i]));
             STRICT_EXPECTED_CALL(amqpvalue_create_string(TEST_MAP_VALUES[i]));
             STRICT_EXPECTED_CALL(amqpvalue_set_map_value(TEST_AMQP_VALUE, TEST_AMQP_VALUE, TEST_AMQP_VALUE));
@@ -302,10 +299,8 @@ static void set_exp_calls_for_create_encoded_application_properties(size_t numbe
     }
 }
 
-static void set_exp_calls_for_create_encoded_data(IOTHUBMESSAGE_CONTENT_TYPE msg_content_type)
+static void set_exp_calls_for_get_message_body(IOTHUBMESSAGE_CONTENT_TYPE msg_content_type)
 {
-    size_t encoding_size = TEST_AMQP_ENCODING_SIZE;
-
     STRICT_EXPECTED_CALL(IoTHubMessage_GetContentType(TEST_IOTHUB_MESSAGE_HANDLE)).SetReturn(msg_content_type);
 
     if (msg_content_type == IOTHUBMESSAGE_BYTEARRAY)
@@ -316,12 +311,6 @@ static void set_exp_calls_for_create_encoded_data(IOTHUBMESSAGE_CONTENT_TYPE msg
     {
         STRICT_EXPECTED_CALL(IoTHubMessage_GetString(TEST_IOTHUB_MESSAGE_HANDLE));
     }
-
-    data d;
-    memset(&d, 0, sizeof(d));
-    STRICT_EXPECTED_CALL(amqpvalue_create_data(d)).IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(amqpvalue_get_encoded_size(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .CopyOutArgumentBuffer(2, &encoding_size, sizeof(encoding_size));
 }
 
 static void set_exp_calls_for_message_create_uamqp_encoding_from_iothub_message(size_t number_of_app_properties, IOTHUBMESSAGE_CONTENT_TYPE msg_content_type, bool has_message_id, bool has_correlation_id, bool has_diag_properties, bool has_security_props, const char* content_type, const char* content_encoding)
@@ -330,7 +319,7 @@ static void set_exp_calls_for_message_create_uamqp_encoding_from_iothub_message(
     set_exp_calls_for_create_encoded_application_properties(number_of_app_properties);
     set_exp_calls_for_create_encoded_annotations_properties(has_diag_properties, has_security_props);
 
-    set_exp_calls_for_create_encoded_data(msg_content_type);
+    set_exp_calls_for_get_message_body(msg_content_type);
 
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .SetReturn(g_encoding_buffer);
@@ -346,9 +335,6 @@ static void set_exp_calls_for_message_create_uamqp_encoding_from_iothub_message(
         STRICT_EXPECTED_CALL(amqpvalue_encode(TEST_AMQP_VALUE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     }
 
-    STRICT_EXPECTED_CALL(amqpvalue_encode(TEST_AMQP_VALUE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-
-    STRICT_EXPECTED_CALL(amqpvalue_destroy(TEST_AMQP_VALUE));
     if (number_of_app_properties > 0)
     {
         STRICT_EXPECTED_CALL(amqpvalue_destroy(TEST_AMQP_VALUE));
@@ -481,7 +467,6 @@ static void set_exp_calls_for_message_create_IoTHubMessage_from_uamqp_message(
     STRICT_EXPECTED_CALL(properties_destroy(TEST_PROPERTIES_HANDLE));
 
     // readApplicationPropertiesFromuAMQPMessage
-    STRICT_EXPECTED_CALL(IoTHubMessage_Properties(TEST_IOTHUB_MESSAGE_HANDLE)).SetReturn(TEST_MAP_HANDLE);
 
     if (has_properties)
     {
@@ -504,7 +489,7 @@ static void set_exp_calls_for_message_create_IoTHubMessage_from_uamqp_message(
                 .IgnoreArgument_string_value().CopyOutArgumentBuffer_string_value(&TEST_MAP_KEYS[i], sizeof(char*));
             STRICT_EXPECTED_CALL(amqpvalue_get_string(TEST_AMQP_VALUE, IGNORED_PTR_ARG))
                 .IgnoreArgument_string_value().CopyOutArgumentBuffer_string_value(&TEST_MAP_VALUES[i], sizeof(char*));
-            STRICT_EXPECTED_CALL(Map_AddOrUpdate(TEST_MAP_HANDLE, TEST_MAP_KEYS[i], TEST_MAP_VALUES[i]));
+            STRICT_EXPECTED_CALL(IoTHubMessage_SetProperty(TEST_IOTHUB_MESSAGE_HANDLE, TEST_MAP_KEYS[i], TEST_MAP_VALUES[i]));
             STRICT_EXPECTED_CALL(amqpvalue_destroy(TEST_AMQP_VALUE));
             STRICT_EXPECTED_CALL(amqpvalue_destroy(TEST_AMQP_VALUE));
         }
@@ -661,8 +646,14 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(properties_set_correlation_id, 1);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(message_set_properties, 1);
 
-    REGISTER_GLOBAL_MOCK_RETURN(IoTHubMessage_Properties, TEST_MAP_HANDLE);
-    REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubMessage_Properties, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(IoTHubMessage_SetProperty, IOTHUB_MESSAGE_OK);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubMessage_SetProperty, IOTHUB_MESSAGE_ERROR);
+
+    REGISTER_GLOBAL_MOCK_RETURN(IoTHubMessage_GetPropertyCount, IOTHUB_MESSAGE_OK);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubMessage_GetPropertyCount, IOTHUB_MESSAGE_ERROR);
+
+    REGISTER_GLOBAL_MOCK_RETURN(IoTHubMessage_GetNextProperty, IOTHUB_MESSAGE_OK);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(IoTHubMessage_GetNextProperty, IOTHUB_MESSAGE_ERROR);
 
     REGISTER_GLOBAL_MOCK_RETURN(amqpvalue_create_map, TEST_AMQP_VALUE);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(amqpvalue_create_map, NULL);
@@ -723,8 +714,6 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_GLOBAL_MOCK_RETURN(amqpvalue_get_encoded_size, 0);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(amqpvalue_get_encoded_size, 1);
 
-    REGISTER_GLOBAL_MOCK_RETURN(amqpvalue_create_data, TEST_AMQP_VALUE);
-    REGISTER_GLOBAL_MOCK_FAIL_RETURN(amqpvalue_create_data, 0);
 
     REGISTER_GLOBAL_MOCK_RETURN(amqpvalue_create_application_properties, TEST_AMQP_VALUE);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(amqpvalue_create_application_properties, 0);
@@ -873,6 +862,31 @@ TEST_FUNCTION(message_create_from_iothub_message_string_success)
     // cleanup
 }
 
+TEST_FUNCTION(message_create_from_iothub_message_string_encodes_data_section)
+{
+    // arrange
+    const unsigned char expected_header[] = { 0x00, 0x53, 0x75, 0xA0, (unsigned char)(sizeof(TEST_STRING) - 1) };
+    umock_c_reset_all_calls();
+    set_exp_calls_for_message_create_uamqp_encoding_from_iothub_message(0, IOTHUBMESSAGE_STRING, true, true, false, false, TEST_CONTENT_TYPE, TEST_CONTENT_ENCODING);
+
+    BINARY_DATA binary_data;
+    memset(&binary_data, 0, sizeof(binary_data));
+    memset(g_encoding_buffer, 0, sizeof(g_encoding_buffer));
+
+    ///act
+    int result = message_create_uamqp_encoding_from_iothub_message(NULL, TEST_IOTHUB_MESSAGE_HANDLE, &binary_data);
+
+    // assert
+    // The mocked sections do not write anything, so the data section starts at the beginning of the buffer.
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, result, 0);
+    ASSERT_ARE_EQUAL(void_ptr, g_encoding_buffer, binary_data.bytes);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(g_encoding_buffer, expected_header, sizeof(expected_header)));
+    ASSERT_ARE_EQUAL(int, 0, memcmp(g_encoding_buffer + sizeof(expected_header), TEST_STRING, sizeof(TEST_STRING) - 1));
+
+    // cleanup
+}
+
 TEST_FUNCTION(message_create_from_iothub_message_no_message_id_success)
 {
     // arrange
@@ -0,0 +1,74 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file   iothub_service_client_feedback.h
+*    @brief  Streaming parser for the body of feedback messages, and a dispatcher that runs it on a pool of worker threads.
+*            The parser walks the JSON array once and hands each record to the callback as soon as it is complete, so the
+*            memory used does not grow with the number of records in a batch.
+*/
+
+#ifndef IOTHUB_SERVICE_CLIENT_FEEDBACK_H
+#define IOTHUB_SERVICE_CLIENT_FEEDBACK_H
+
+#include "umock_c/umock_c_prod.h"
+#include "iothub_messaging_ll.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+extern "C" {
+#else
+#include <stddef.h>
+#endif
+
+typedef struct FEEDBACK_PARSER_TAG* FEEDBACK_PARSER_HANDLE;
+typedef struct FEEDBACK_DISPATCHER_TAG* FEEDBACK_DISPATCHER_HANDLE;
+
+/**
+    * @brief    Creates a parser.  A parser keeps the buffer the strings of a record are unescaped into between calls, and must
+    *           not be used by two threads at once.
+    *
+    * @return   A handle to the parser, or NULL on failure.
+    */
+MOCKABLE_FUNCTION(, FEEDBACK_PARSER_HANDLE, feedback_parser_create);
+
+MOCKABLE_FUNCTION(, void, feedback_parser_destroy, FEEDBACK_PARSER_HANDLE, parser);
+
+/**
+    * @brief    Parses a feedback message body, a JSON array of objects, calling @p onFeedbackRecord for every object in order.
+    *           The record and its strings are only valid during the call.  Members other than the record fields are skipped.
+    *
+    * @param    body                Body of the message; does not need to be NUL-terminated.
+    * @param    length              Number of bytes in @p body.
+    *
+    * @return   0 if the whole body was parsed and held at least one record.  On failure the records that came before the
+    *           error have already been handed to the callback.
+    */
+MOCKABLE_FUNCTION(, int, feedback_parser_parse, FEEDBACK_PARSER_HANDLE, parser, const unsigned char*, body, size_t, length, IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK, onFeedbackRecord, void*, context);
+
+/**
+    * @brief    Creates a dispatcher that parses feedback bodies with @p workerCount threads, holding at most
+    *           @p maxPendingBatches bodies that are not being parsed yet.  With no workers, bodies are parsed by the caller.
+    *
+    * @return   A handle to the dispatcher, or NULL on failure.
+    */
+MOCKABLE_FUNCTION(, FEEDBACK_DISPATCHER_HANDLE, feedback_dispatcher_create, size_t, workerCount, size_t, maxPendingBatches, IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK, onFeedbackRecord, void*, context);
+
+/**
+    * @brief    Parses the bodies still pending, then stops the workers and frees the dispatcher.
+    */
+MOCKABLE_FUNCTION(, void, feedback_dispatcher_destroy, FEEDBACK_DISPATCHER_HANDLE, dispatcher);
+
+/**
+    * @brief    Hands a feedback body to the workers, copying it.  When there are no workers or the pending bodies are at their
+    *           limit, the body is parsed on the calling thread instead, which slows the caller down to the pace of the workers.
+    *
+    * @return   0 if the body was queued or parsed; non-zero if it could not be parsed, in which case the message is to be
+    *           rejected.  Parse errors of queued bodies are only logged, since their messages have already been settled.
+    */
+MOCKABLE_FUNCTION(, int, feedback_dispatcher_dispatch, FEEDBACK_DISPATCHER_HANDLE, dispatcher, const unsigned char*, body, size_t, length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTHUB_SERVICE_CLIENT_FEEDBACK_H */
@@ -0,0 +1,72 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file   iothub_service_client_http_pool.h
+*    @brief  Pool of persistent HTTPS connections to an IoT Hub, shared by the service client modules created from the
+*            same @c IOTHUB_SERVICE_CLIENT_AUTH_HANDLE.  Connections are kept open between requests (up to a maximum),
+*            and the SAS token is generated once and reused until it is about to expire.  All functions are thread-safe.
+*/
+
+#ifndef IOTHUB_SERVICE_CLIENT_HTTP_POOL_H
+#define IOTHUB_SERVICE_CLIENT_HTTP_POOL_H
+
+#include "umock_c/umock_c_prod.h"
+#include "azure_c_shared_utility/httpapiex.h"
+#include "azure_c_shared_utility/httpheaders.h"
+#include "azure_c_shared_utility/buffer_.h"
+#include "iothub_service_client_auth.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+extern "C" {
+#else
+#include <stddef.h>
+#endif
+
+typedef struct SERVICE_CLIENT_HTTP_POOL_TAG* SERVICE_CLIENT_HTTP_POOL_HANDLE;
+
+/**
+    * @brief    Creates a pool holding a single reference.
+    *
+    * @param    hostname            IoT Hub host name the connections are opened to.
+    * @param    sharedAccessKey     Shared access key the SAS token is signed with, or "sas=" followed by a ready-made token.
+    * @param    keyName             Name of the shared access policy; may be NULL when a ready-made token is given.
+    * @param    maxConnections      Maximum number of connections open at once.
+    *
+    * @return   A handle to the pool, or NULL on failure.
+    */
+MOCKABLE_FUNCTION(, SERVICE_CLIENT_HTTP_POOL_HANDLE, service_client_http_pool_create, const char*, hostname, const char*, sharedAccessKey, const char*, keyName, size_t, maxConnections);
+
+/**
+    * @brief    Adds a reference to the pool.
+    *
+    * @return   @p handle, or NULL on failure.
+    */
+MOCKABLE_FUNCTION(, SERVICE_CLIENT_HTTP_POOL_HANDLE, service_client_http_pool_clone, SERVICE_CLIENT_HTTP_POOL_HANDLE, handle);
+
+/**
+    * @brief    Releases a reference to the pool; the last one closes the connections and frees the pool.
+    */
+MOCKABLE_FUNCTION(, void, service_client_http_pool_destroy, SERVICE_CLIENT_HTTP_POOL_HANDLE, handle);
+
+/**
+    * @brief    Signs the request and executes it on an idle connection of the pool, opening a new one if all are busy and the
+    *           maximum is not reached, or waiting for one to be released otherwise.  Same parameters as @c HTTPAPIEX_ExecuteRequest;
+    *           the Authorization header of @p requestHttpHeadersHandle is replaced with the cached SAS token.
+    */
+MOCKABLE_FUNCTION(, HTTPAPIEX_RESULT, service_client_http_pool_execute_request, SERVICE_CLIENT_HTTP_POOL_HANDLE, handle, HTTPAPI_REQUEST_TYPE, requestType, const char*, relativePath, HTTP_HEADERS_HANDLE, requestHttpHeadersHandle, BUFFER_HANDLE, requestContent, unsigned int*, statusCode, HTTP_HEADERS_HANDLE, responseHttpHeadersHandle, BUFFER_HANDLE, responseContent);
+
+/**
+    * @brief    Gets the pool enabled on @p serviceClientHandle by @c IoTHubServiceClientAuth_EnableConnectionPool.  No
+    *           reference is added; modules keeping the pool must clone it.  Implemented by iothub_service_client_auth.c, as
+    *           the pool is kept out of the public @c IOTHUB_SERVICE_CLIENT_AUTH structure.
+    *
+    * @return   The pool, or NULL if @p serviceClientHandle is NULL or has no pool enabled.
+    */
+MOCKABLE_FUNCTION(, SERVICE_CLIENT_HTTP_POOL_HANDLE, service_client_auth_get_http_pool, IOTHUB_SERVICE_CLIENT_AUTH_HANDLE, serviceClientHandle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTHUB_SERVICE_CLIENT_HTTP_POOL_H */
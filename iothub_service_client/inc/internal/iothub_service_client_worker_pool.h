@@ -0,0 +1,45 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file   iothub_service_client_worker_pool.h
+*    @brief  Runs a function on every item of a list from a bounded number of threads, the calling thread being one of
+*            them.  Used by the service client calls that fan a request out to many devices.
+*/
+
+#ifndef IOTHUB_SERVICE_CLIENT_WORKER_POOL_H
+#define IOTHUB_SERVICE_CLIENT_WORKER_POOL_H
+
+#include "umock_c/umock_c_prod.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+extern "C" {
+#else
+#include <stddef.h>
+#endif
+
+/**
+    * @brief    Processes the item at @p index.  Called once per item, from any of the threads of the pool, so calls for
+    *           different items can run at the same time.
+    */
+typedef void(*SERVICE_CLIENT_WORKER_POOL_ITEM_FUNCTION)(void* context, size_t index);
+
+/**
+    * @brief    Calls @p processItem on the items 0 to @p itemCount - 1, each from whichever thread is free first, and returns
+    *           once all calls have returned.  If fewer threads than requested can be started, the items are processed by
+    *           the ones that could.
+    *
+    * @param    itemCount       Number of items.
+    * @param    maxConcurrency  Maximum number of items processed at once, including by the calling thread.
+    * @param    processItem     Function called for each item.
+    * @param    context         Passed to @p processItem.
+    *
+    * @return   0 if @p processItem was called for every item, a non-zero value otherwise.
+    */
+MOCKABLE_FUNCTION(, int, service_client_worker_pool_run, size_t, itemCount, size_t, maxConcurrency, SERVICE_CLIENT_WORKER_POOL_ITEM_FUNCTION, processItem, void*, context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTHUB_SERVICE_CLIENT_WORKER_POOL_H */
@@ -16,6 +16,12 @@ extern "C"
 
 #include "umock_c/umock_c_prod.h"
 
+#ifdef __cplusplus
+#include <cstdint>
+#else
+#include <stdint.h>
+#endif
+
 #define IOTHUB_DEVICE_METHOD_RESULT_VALUES     \
     IOTHUB_DEVICE_METHOD_OK,                   \
     IOTHUB_DEVICE_METHOD_INVALID_ARG,          \
@@ -28,6 +34,32 @@ MU_DEFINE_ENUM_WITHOUT_INVALID(IOTHUB_DEVICE_METHOD_RESULT, IOTHUB_DEVICE_METHOD
 */
 typedef struct IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_TAG* IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_HANDLE;
 
+/** @brief    Called by IoTHubDeviceMethod_InvokeMany as soon as the method call on a device completes.
+*           It is called on the worker thread that made the call, so with maxConcurrency above 1 calls for different
+*           devices can run at the same time; the callback must guard whatever state it shares.
+*
+* @param    deviceId                        The device the method was called on.
+* @param    result                          IOTHUB_DEVICE_METHOD_OK if the device answered, an error otherwise.
+* @param    responseStatus                  Status returned by the device (only valid when result is IOTHUB_DEVICE_METHOD_OK).
+* @param    responsePayload                 Payload returned by the device; owned by the SDK and only valid during the call.
+* @param    responsePayloadSize             String length of responsePayload.
+* @param    context                         The context given to IoTHubDeviceMethod_InvokeMany.
+*/
+typedef void(*IOTHUB_DEVICE_METHOD_INVOKE_MANY_CALLBACK)(const char* deviceId, IOTHUB_DEVICE_METHOD_RESULT result, int responseStatus, const unsigned char* responsePayload, size_t responsePayloadSize, void* context);
+
+/** @brief Aggregate results of IoTHubDeviceMethod_InvokeMany. Latencies are per device, from the request to the parsed response.
+*/
+typedef struct IOTHUB_DEVICE_METHOD_INVOKE_MANY_STATISTICS_TAG
+{
+    size_t succeeded;
+    size_t failed;
+    uint64_t elapsedMs;
+    uint64_t averageLatencyMs;
+    uint64_t p50LatencyMs;
+    uint64_t p99LatencyMs;
+    uint64_t maxLatencyMs;
+} IOTHUB_DEVICE_METHOD_INVOKE_MANY_STATISTICS;
+
 /** @brief    Creates a IoT Hub Service Client DeviceMethod handle for use it in consequent APIs.
 *
 * @param    serviceClientHandle    Service client handle.
@@ -83,6 +115,32 @@ MOCKABLE_FUNCTION(, IOTHUB_DEVICE_METHOD_RESULT, IoTHubDeviceMethod_Invoke, IOTH
 */
 MOCKABLE_FUNCTION(, IOTHUB_DEVICE_METHOD_RESULT, IoTHubDeviceMethod_InvokeModule, IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_HANDLE, serviceClientDeviceMethodHandle, const char*, deviceId, const char*, moduleId, const char*, methodName, const char*, methodPayload, unsigned int, timeout, int*, responseStatus, unsigned char**, responsePayload, size_t*, responsePayloadSize);
 
+/** @brief    Call the same method with the same payload on many devices, with up to maxConcurrency calls in flight.
+*
+* @param    serviceClientDeviceMethodHandle    The handle created by a call to the create function.
+* @param    deviceIds                       The device names (ids) to call the method on.
+* @param    deviceCount                     Number of entries in deviceIds.
+* @param    methodName                      The method name to call.
+* @param    methodPayload                   The message payload to send.
+* @param    timeout                         Time before each call times out.
+*
+* @warning  The timeout parameter is ignored.  See https://github.com/Azure/azure-iot-sdk-c/issues/1378.
+*           The timeout used will be the default for IoT Hub.
+*
+* @param    maxConcurrency                  Maximum number of calls in flight at once.
+* @param    deviceResultCallback            Called, one device at a time, as each call completes; may be NULL.
+* @param    context                         User context passed to deviceResultCallback.
+* @param    statistics                      Optional output for the aggregate results.
+*
+* @remarks  The calls are made from worker threads and from the calling thread, which returns once every device has
+*           been called.  They share the connection pool of the service client handle when one was enabled with
+*           IoTHubServiceClientAuth_EnableConnectionPool; otherwise a pool of maxConcurrency connections is opened
+*           for the duration of the call.
+*
+* @return    IOTHUB_DEVICE_METHOD_OK if every device was called, whatever its answer; an error otherwise.
+*/
+MOCKABLE_FUNCTION(, IOTHUB_DEVICE_METHOD_RESULT, IoTHubDeviceMethod_InvokeMany, IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_HANDLE, serviceClientDeviceMethodHandle, const char* const*, deviceIds, size_t, deviceCount, const char*, methodName, const char*, methodPayload, unsigned int, timeout, size_t, maxConcurrency, IOTHUB_DEVICE_METHOD_INVOKE_MANY_CALLBACK, deviceResultCallback, void*, context, IOTHUB_DEVICE_METHOD_INVOKE_MANY_STATISTICS*, statistics);
+
 
 #ifdef __cplusplus
 }
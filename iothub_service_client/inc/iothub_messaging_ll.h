@@ -72,6 +72,25 @@ typedef struct IOTHUB_MESSAGING_TAG* IOTHUB_MESSAGING_HANDLE;
 typedef void(*IOTHUB_OPEN_COMPLETE_CALLBACK)(void* context);
 typedef void(*IOTHUB_SEND_COMPLETE_CALLBACK)(void* context, IOTHUB_MESSAGING_RESULT messagingResult);
 typedef void(*IOTHUB_FEEDBACK_MESSAGE_RECEIVED_CALLBACK)(void* context, IOTHUB_SERVICE_FEEDBACK_BATCH* feedbackBatch);
+typedef void(*IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK)(void* context, const IOTHUB_SERVICE_FEEDBACK_RECORD* feedbackRecord);
+
+typedef struct IOTHUB_MESSAGING_BATCH_ITEM_TAG
+{
+    const char* deviceId;
+    IOTHUB_MESSAGE_HANDLE message;
+    IOTHUB_SEND_COMPLETE_CALLBACK sendCompleteCallback;
+    void* userContextCallback;
+} IOTHUB_MESSAGING_BATCH_ITEM;
+
+typedef struct IOTHUB_MESSAGING_SEND_STATISTICS_TAG
+{
+    size_t messagesQueued;      // Handed to the AMQP sender since the handle was created.
+    size_t messagesSent;        // Accepted by IoT Hub.
+    size_t messagesFailed;      // Rejected, timed out or cancelled, including those dropped by IoTHubMessaging_LL_Destroy.
+    size_t inFlight;            // Queued and not yet settled by IoT Hub.
+    size_t peakInFlight;        // Highest inFlight seen.
+    size_t sendWindow;          // Messages that can still be queued before IOTHUB_MESSAGING_QUEUE_FULL.
+} IOTHUB_MESSAGING_SEND_STATISTICS;
 
 /** @brief    Creates a IoT Hub Service Client Messaging handle for use it in consequent APIs.
 *
@@ -145,6 +164,28 @@ MOCKABLE_FUNCTION(, IOTHUB_MESSAGING_RESULT, IoTHubMessaging_LL_Send, IOTHUB_MES
 */
 MOCKABLE_FUNCTION(, IOTHUB_MESSAGING_RESULT, IoTHubMessaging_LL_SetFeedbackMessageCallback, IOTHUB_MESSAGING_HANDLE, messagingHandle, IOTHUB_FEEDBACK_MESSAGE_RECEIVED_CALLBACK, feedbackMessageReceivedCallback, void*, userContextCallback);
 
+/**
+* @brief    Sets a callback that gets the feedback records one at a time, as they are parsed
+*           out of the message, instead of as a whole IOTHUB_SERVICE_FEEDBACK_BATCH. While it
+*           is set, the callback given to IoTHubMessaging_LL_SetFeedbackMessageCallback is not called.
+*
+* @param    messagingHandle                 The handle created by a call to the create function.
+* @param    feedbackRecordReceivedCallback  The callback, or NULL to go back to whole batches.
+*                                           The record is only valid during the call.
+* @param    userContextCallback             User specified context passed to the callback.
+* @param    workerCount                     Number of threads parsing feedback messages. With 0,
+*                                           records are parsed and passed to the callback from
+*                                           IoTHubMessaging_LL_DoWork, and a message is settled
+*                                           once all its records were. With workers, messages
+*                                           are accepted as soon as they are handed over, and the
+*                                           callback is called from the workers, concurrently
+*                                           when there is more than one; when all the workers
+*                                           are busy, DoWork parses the message itself.
+*
+* @return   IOTHUB_MESSAGING_OK upon success or an error code upon failure.
+*/
+MOCKABLE_FUNCTION(, IOTHUB_MESSAGING_RESULT, IoTHubMessaging_LL_SetFeedbackRecordCallback, IOTHUB_MESSAGING_HANDLE, messagingHandle, IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK, feedbackRecordReceivedCallback, void*, userContextCallback, size_t, workerCount);
+
 /**
 * @brief    This function is meant to be called by the user when work
 *             (sending/receiving) can be done by the IoTHubServiceClient.
@@ -178,6 +219,36 @@ MOCKABLE_FUNCTION(, IOTHUB_MESSAGING_RESULT, IoTHubMessaging_LL_SetTrustedCert,
 */
 MOCKABLE_FUNCTION(, IOTHUB_MESSAGING_RESULT, IoTHubMessaging_LL_SetMaxSendQueueSize, IOTHUB_MESSAGING_HANDLE, messagingHandle, size_t, maxQueueSize);
 
+/**
+* @brief    Queues cloud-to-device messages for many devices in one call.
+*
+* @param    messagingHandle The handle created by a call to the create function.
+* @param    items           The messages to send, each with its device and completion callback.
+*                           Consecutive items carrying the same message handle share a single
+*                           AMQP encoding, so a broadcast should list its devices one after another.
+* @param    itemCount       The number of items.
+* @param    itemsQueued     Receives the number of items, from the start of @p items, that were queued.
+*
+*            Items are queued in order until the send window set with
+*            IoTHubMessaging_LL_SetMaxSendQueueSize is full; IoTHubMessaging_LL_DoWork then sends them
+*            as link credit allows. Items that were not queued have had no callback and can be passed
+*            again, starting at items[*itemsQueued], once DoWork has settled some of the messages in flight.
+*
+* @return   IOTHUB_MESSAGING_OK if every item was queued, IOTHUB_MESSAGING_QUEUE_FULL if the send window
+*           filled up first, or an error code if an item could not be queued.
+*/
+MOCKABLE_FUNCTION(, IOTHUB_MESSAGING_RESULT, IoTHubMessaging_LL_SendBatch, IOTHUB_MESSAGING_HANDLE, messagingHandle, const IOTHUB_MESSAGING_BATCH_ITEM*, items, size_t, itemCount, size_t*, itemsQueued);
+
+/**
+* @brief    Gets the throughput counters and the current send window of the messaging handle.
+*
+* @param    messagingHandle The handle created by a call to the create function.
+* @param    statistics      Receives the counters.
+*
+* @return   IOTHUB_MESSAGING_OK upon success or an error code upon failure.
+*/
+MOCKABLE_FUNCTION(, IOTHUB_MESSAGING_RESULT, IoTHubMessaging_LL_GetSendStatistics, IOTHUB_MESSAGING_HANDLE, messagingHandle, IOTHUB_MESSAGING_SEND_STATISTICS*, statistics);
+
 #ifdef __cplusplus
 }
 #endif
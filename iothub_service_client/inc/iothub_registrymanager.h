@@ -28,7 +28,8 @@ extern "C"
     IOTHUB_REGISTRYMANAGER_DEVICE_EXIST,            \
     IOTHUB_REGISTRYMANAGER_DEVICE_NOT_EXIST,        \
     IOTHUB_REGISTRYMANAGER_CALLBACK_NOT_SET,        \
-    IOTHUB_REGISTRYMANAGER_INVALID_VERSION          \
+    IOTHUB_REGISTRYMANAGER_INVALID_VERSION,         \
+    IOTHUB_REGISTRYMANAGER_END_OF_LIST              \
 
 MU_DEFINE_ENUM_WITHOUT_INVALID(IOTHUB_REGISTRYMANAGER_RESULT, IOTHUB_REGISTRYMANAGER_RESULT_VALUES);
 
@@ -165,6 +166,27 @@ typedef struct IOTHUB_REGISTRY_MODULE_UPDATE_TAG
     const char* managedBy;                          //version 1+
 } IOTHUB_REGISTRY_MODULE_UPDATE;
 
+#define IOTHUB_REGISTRY_BULK_OPERATION_MODE_VALUES      \
+    IOTHUB_REGISTRY_BULK_OPERATION_CREATE,              \
+    IOTHUB_REGISTRY_BULK_OPERATION_UPDATE,              \
+    IOTHUB_REGISTRY_BULK_OPERATION_DELETE               \
+
+MU_DEFINE_ENUM_WITHOUT_INVALID(IOTHUB_REGISTRY_BULK_OPERATION_MODE, IOTHUB_REGISTRY_BULK_OPERATION_MODE_VALUES);
+
+#define IOTHUB_REGISTRY_BULK_OPERATION_VERSION_1 1
+typedef struct IOTHUB_REGISTRY_BULK_OPERATION_TAG
+{
+    int version;
+    IOTHUB_REGISTRY_BULK_OPERATION_MODE mode;       //version 1+
+    const char* deviceId;                           //version 1+
+    const char* primaryKey;                         //version 1+, create and update only
+    const char* secondaryKey;                       //version 1+, create and update only
+    IOTHUB_REGISTRYMANAGER_AUTH_METHOD authMethod;  //version 1+, create and update only
+    IOTHUB_DEVICE_STATUS status;                    //version 1+, create and update only
+    bool iotEdge_capable;                           //version 1+, create and update only
+    const char* eTag;                               //version 1+, optional: update and delete only apply if it matches
+} IOTHUB_REGISTRY_BULK_OPERATION;
+
 /** @brief Structure to store IoTHub authentication information
 */
 typedef struct IOTHUB_REGISTRYMANAGER_TAG
@@ -313,6 +335,95 @@ extern IOTHUB_REGISTRYMANAGER_RESULT IoTHubRegistryManager_DeleteModule(IOTHUB_R
 */
 extern IOTHUB_REGISTRYMANAGER_RESULT IoTHubRegistryManager_GetModuleList(IOTHUB_REGISTRYMANAGER_HANDLE registryManagerHandle, const char* deviceId, SINGLYLINKEDLIST_HANDLE moduleList, int module_version);
 
+typedef struct IOTHUB_REGISTRYMANAGER_ITERATOR_TAG* IOTHUB_REGISTRYMANAGER_ITERATOR_HANDLE;
+
+/**
+* @brief    Creates an iterator over every device registered on the IoT Hub.
+*
+* @param    registryManagerHandle   The handle created by a call to the create function. It must
+*                                   outlive the iterator.
+* @param    pageSize                Number of devices requested per page, up to 1000. 0 lets the
+*                                   service choose.
+* @param    prefetch                If true, the next page is fetched on a worker thread while the
+*                                   caller goes through the current one.
+*
+* @remarks  Devices are read with the query API a page at a time and parsed one at a time, so
+*           memory use is bounded by the page size rather than by the number of devices. Query
+*           results are device twins, so primaryKey and secondaryKey are never filled in.
+*
+* @return   A valid IOTHUB_REGISTRYMANAGER_ITERATOR_HANDLE or NULL in case an error occurs.
+*/
+extern IOTHUB_REGISTRYMANAGER_ITERATOR_HANDLE IoTHubRegistryManager_CreateDeviceIterator(IOTHUB_REGISTRYMANAGER_HANDLE registryManagerHandle, size_t pageSize, bool prefetch);
+
+/**
+* @brief    Creates an iterator over every module of every device registered on the IoT Hub.
+*
+* @param    registryManagerHandle   The handle created by a call to the create function. It must
+*                                   outlive the iterator.
+* @param    pageSize                Number of modules requested per page, up to 1000. 0 lets the
+*                                   service choose.
+* @param    prefetch                If true, the next page is fetched on a worker thread while the
+*                                   caller goes through the current one.
+*
+* @return   A valid IOTHUB_REGISTRYMANAGER_ITERATOR_HANDLE or NULL in case an error occurs.
+*/
+extern IOTHUB_REGISTRYMANAGER_ITERATOR_HANDLE IoTHubRegistryManager_CreateModuleIterator(IOTHUB_REGISTRYMANAGER_HANDLE registryManagerHandle, size_t pageSize, bool prefetch);
+
+/**
+* @brief    Gets the next device from an iterator created by IoTHubRegistryManager_CreateDeviceIterator.
+*
+* @param    iterator                The iterator.
+* @param    deviceInfo              Receives the device. Its members must be freed with
+*                                   IoTHubRegistryManager_FreeDeviceExMembers.
+*
+* @return   IOTHUB_REGISTRYMANAGER_OK upon success, IOTHUB_REGISTRYMANAGER_END_OF_LIST once every
+*           device has been returned, or an error code upon failure. After a failure to fetch a
+*           page, calling again retries that page.
+*/
+extern IOTHUB_REGISTRYMANAGER_RESULT IoTHubRegistryManager_GetNextDevice(IOTHUB_REGISTRYMANAGER_ITERATOR_HANDLE iterator, IOTHUB_DEVICE_EX* deviceInfo);
+
+/**
+* @brief    Gets the next module from an iterator created by IoTHubRegistryManager_CreateModuleIterator.
+*
+* @param    iterator                The iterator.
+* @param    module                  Receives the module. Its members must be freed with
+*                                   IoTHubRegistryManager_FreeModuleMembers.
+*
+* @return   IOTHUB_REGISTRYMANAGER_OK upon success, IOTHUB_REGISTRYMANAGER_END_OF_LIST once every
+*           module has been returned, or an error code upon failure. After a failure to fetch a
+*           page, calling again retries that page.
+*/
+extern IOTHUB_REGISTRYMANAGER_RESULT IoTHubRegistryManager_GetNextModule(IOTHUB_REGISTRYMANAGER_ITERATOR_HANDLE iterator, IOTHUB_MODULE* module);
+
+/**
+* @brief    Destroys an iterator, waiting for any page being prefetched.
+*
+* @param    iterator                The iterator.
+*/
+extern void IoTHubRegistryManager_DestroyIterator(IOTHUB_REGISTRYMANAGER_ITERATOR_HANDLE iterator);
+
+/**
+* @brief    Creates, updates or deletes many devices, up to 100 per request.
+*
+* @param    registryManagerHandle   The handle created by a call to the create function.
+* @param    operations              The operations. Any number can be given; they are sent in
+*                                   batches of 100.
+* @param    operationCount          Number of operations.
+* @param    maxConcurrency          Maximum number of batches in flight at once. Batches are sent
+*                                   over the handle's connection pool when it has one, otherwise
+*                                   over a pool of maxConcurrency connections created for the call.
+* @param    operationResults        Caller-allocated array of operationCount entries that receives
+*                                   the outcome of each operation, e.g. IOTHUB_REGISTRYMANAGER_DEVICE_EXIST
+*                                   for a create of a device that is already registered.
+*
+* @remarks  Operations in a batch are not atomic: the service applies the ones it can and reports
+*           the others. The call blocks until every batch has been answered.
+*
+* @return   IOTHUB_REGISTRYMANAGER_OK if every operation succeeded, the result of the first failed
+*           operation otherwise, or an error code if the arguments are invalid.
+*/
+extern IOTHUB_REGISTRYMANAGER_RESULT IoTHubRegistryManager_BulkOperation(IOTHUB_REGISTRYMANAGER_HANDLE registryManagerHandle, const IOTHUB_REGISTRY_BULK_OPERATION* operations, size_t operationCount, size_t maxConcurrency, IOTHUB_REGISTRYMANAGER_RESULT* operationResults);
+
 
 /* DEPRECATED: THE FOLLOWING APIS ARE DEPRECATED, AND ARE ONLY BEING KEPT FOR BACK COMPAT. PLEASE USE _EX EQUIVALENT ABOVE */
 /* DEPRECATED: THE FOLLOWING APIS ARE DEPRECATED, AND ARE ONLY BEING KEPT FOR BACK COMPAT. PLEASE USE _EX EQUIVALENT ABOVE */
@@ -22,6 +22,12 @@
 #include "azure_macro_utils/macro_utils.h"
 #include "umock_c/umock_c_prod.h"
 
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#endif
+
 #define IOTHUB_DEVICE_STATUS_VALUES       \
     IOTHUB_DEVICE_STATUS_ENABLED,         \
     IOTHUB_DEVICE_STATUS_DISABLED         \
@@ -90,6 +96,20 @@ extern IOTHUB_SERVICE_CLIENT_AUTH_HANDLE IoTHubServiceClientAuth_CreateFromConne
 */
 extern IOTHUB_SERVICE_CLIENT_AUTH_HANDLE IoTHubServiceClientAuth_CreateFromSharedAccessSignature(const char* connectionString);
 
+/**
+* @brief    Makes the service client handles created from now on with this handle (device method, device twin,
+*             registry manager and device configuration) share a pool of persistent HTTPS connections to the
+*             IoT Hub, instead of opening a new connection and signing a new SAS token for every request.
+*             The pool is thread-safe; connections are kept open between requests and reused, and at most
+*             @p maxConnections are open at once (further requests wait for one to be released).
+*
+* @param    serviceClientHandle    The handle created by a call to the create function.
+* @param    maxConnections         Maximum number of connections to the IoT Hub open at once. Must be greater than 0.
+*
+* @return    0 on success, a non-zero value if the pool could not be created or was already enabled.
+*/
+extern int IoTHubServiceClientAuth_EnableConnectionPool(IOTHUB_SERVICE_CLIENT_AUTH_HANDLE serviceClientHandle, size_t maxConnections);
+
 /**
 * @brief    Disposes of resources allocated by the IoT Hub Service Client.
 *
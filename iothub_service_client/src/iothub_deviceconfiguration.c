@@ -2,6 +2,7 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #include <stdlib.h>
+#include <stdbool.h>
 #include <ctype.h>
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/gballoc.h"
@@ -19,6 +20,7 @@
 #include "parson.h"
 #include "iothub_deviceconfiguration.h"
 #include "iothub_sc_version.h"
+#include "internal/iothub_service_client_http_pool.h"
 
 MU_DEFINE_ENUM_STRINGS_WITHOUT_INVALID(IOTHUB_DEVICE_CONFIGURATION_RESULT, IOTHUB_DEVICE_CONFIGURATION_RESULT_VALUES);
 
@@ -75,6 +77,7 @@ typedef struct IOTHUB_SERVICE_CLIENT_DEVICE_CONFIGURATION_TAG
     char* hostname;
     char* sharedAccessKey;
     char* keyName;
+    SERVICE_CLIENT_HTTP_POOL_HANDLE httpPool;
 } IOTHUB_SERVICE_CLIENT_DEVICE_CONFIGURATION;
 
 static const char* generateGuid(void)
@@ -183,6 +186,92 @@ static HTTP_HEADERS_HANDLE createHttpHeader(IOTHUB_DEVICECONFIGURATION_REQUEST_M
     return httpHeader;
 }
 
+static int getHttpRequestType(IOTHUB_DEVICECONFIGURATION_REQUEST_MODE iotHubDeviceConfigurationRequestMode, HTTPAPI_REQUEST_TYPE* httpApiRequestType)
+{
+    int result = 0;
+
+    if ((iotHubDeviceConfigurationRequestMode == IOTHUB_DEVICECONFIGURATION_REQUEST_ADD) || (iotHubDeviceConfigurationRequestMode == IOTHUB_DEVICECONFIGURATION_REQUEST_UPDATE))
+    {
+        *httpApiRequestType = HTTPAPI_REQUEST_PUT;
+    }
+    else if ((iotHubDeviceConfigurationRequestMode == IOTHUB_DEVICECONFIGURATION_REQUEST_GET) || (iotHubDeviceConfigurationRequestMode == IOTHUB_DEVICECONFIGURATION_REQUEST_GET_LIST))
+    {
+        *httpApiRequestType = HTTPAPI_REQUEST_GET;
+    }
+    else if (iotHubDeviceConfigurationRequestMode == IOTHUB_DEVICECONFIGURATION_REQUEST_DELETE)
+    {
+        *httpApiRequestType = HTTPAPI_REQUEST_DELETE;
+    }
+    else if (iotHubDeviceConfigurationRequestMode == IOTHUB_DEVICECONFIGURATION_REQUEST_APPLY_CONFIGURATION_CONTENT)
+    {
+        *httpApiRequestType = HTTPAPI_REQUEST_POST;
+    }
+    else
+    {
+        result = MU_FAILURE;
+    }
+
+    return result;
+}
+
+static bool isSuccessStatusCode(IOTHUB_DEVICECONFIGURATION_REQUEST_MODE iotHubDeviceConfigurationRequestMode, unsigned int statusCode)
+{
+    return (((iotHubDeviceConfigurationRequestMode == IOTHUB_DEVICECONFIGURATION_REQUEST_ADD) ||
+        (iotHubDeviceConfigurationRequestMode == IOTHUB_DEVICECONFIGURATION_REQUEST_GET) ||
+        (iotHubDeviceConfigurationRequestMode == IOTHUB_DEVICECONFIGURATION_REQUEST_GET_LIST) ||
+        (iotHubDeviceConfigurationRequestMode == IOTHUB_DEVICECONFIGURATION_REQUEST_UPDATE)) && (statusCode == 200)) ||
+        ((iotHubDeviceConfigurationRequestMode == IOTHUB_DEVICECONFIGURATION_REQUEST_DELETE) && (statusCode == 204)) ||
+        ((iotHubDeviceConfigurationRequestMode == IOTHUB_DEVICECONFIGURATION_REQUEST_APPLY_CONFIGURATION_CONTENT) && ((statusCode == 200) || (statusCode == 204)));
+}
+
+static IOTHUB_DEVICE_CONFIGURATION_RESULT sendPooledHttpRequestDeviceConfiguration(IOTHUB_SERVICE_CLIENT_DEVICE_CONFIGURATION_HANDLE serviceClientDeviceConfigurationHandle, IOTHUB_DEVICECONFIGURATION_REQUEST_MODE iotHubDeviceConfigurationRequestMode, const char* id, BUFFER_HANDLE json, size_t maxConfigurationsCount, BUFFER_HANDLE responseBuffer)
+{
+    IOTHUB_DEVICE_CONFIGURATION_RESULT result;
+    HTTPAPI_REQUEST_TYPE httpApiRequestType;
+    HTTP_HEADERS_HANDLE httpHeader;
+    STRING_HANDLE relativePath;
+    unsigned int statusCode = 0;
+
+    if (getHttpRequestType(iotHubDeviceConfigurationRequestMode, &httpApiRequestType) != 0)
+    {
+        LogError("Invalid request type");
+        result = IOTHUB_DEVICE_CONFIGURATION_HTTPAPI_ERROR;
+    }
+    else if ((httpHeader = createHttpHeader(iotHubDeviceConfigurationRequestMode)) == NULL)
+    {
+        LogError("HttpHeader creation failed");
+        result = IOTHUB_DEVICE_CONFIGURATION_ERROR;
+    }
+    else
+    {
+        if ((relativePath = createRelativePath(iotHubDeviceConfigurationRequestMode, id, maxConfigurationsCount)) == NULL)
+        {
+            LogError("Failure creating relative path");
+            result = IOTHUB_DEVICE_CONFIGURATION_ERROR;
+        }
+        else
+        {
+            if (service_client_http_pool_execute_request(serviceClientDeviceConfigurationHandle->httpPool, httpApiRequestType, STRING_c_str(relativePath), httpHeader, json, &statusCode, NULL, responseBuffer) != HTTPAPIEX_OK)
+            {
+                LogError("service_client_http_pool_execute_request failed");
+                result = IOTHUB_DEVICE_CONFIGURATION_HTTPAPI_ERROR;
+            }
+            else if (isSuccessStatusCode(iotHubDeviceConfigurationRequestMode, statusCode))
+            {
+                result = IOTHUB_DEVICE_CONFIGURATION_OK;
+            }
+            else
+            {
+                LogError("Http Failure status code %d.", statusCode);
+                result = IOTHUB_DEVICE_CONFIGURATION_ERROR;
+            }
+            STRING_delete(relativePath);
+        }
+        HTTPHeaders_Free(httpHeader);
+    }
+    return result;
+}
+
 static IOTHUB_DEVICE_CONFIGURATION_RESULT sendHttpRequestDeviceConfiguration(IOTHUB_SERVICE_CLIENT_DEVICE_CONFIGURATION_HANDLE serviceClientDeviceConfigurationHandle, IOTHUB_DEVICECONFIGURATION_REQUEST_MODE iotHubDeviceConfigurationRequestMode, const char* id, BUFFER_HANDLE json, size_t maxConfigurationsCount, BUFFER_HANDLE responseBuffer)
 {
     IOTHUB_DEVICE_CONFIGURATION_RESULT result;
@@ -194,7 +283,11 @@ static IOTHUB_DEVICE_CONFIGURATION_RESULT sendHttpRequestDeviceConfiguration(IOT
     HTTPAPIEX_HANDLE httpExApiHandle;
     HTTP_HEADERS_HANDLE httpHeader;
 
-    if ((uriResource = STRING_construct(serviceClientDeviceConfigurationHandle->hostname)) == NULL)
+    if (serviceClientDeviceConfigurationHandle->httpPool != NULL)
+    {
+        result = sendPooledHttpRequestDeviceConfiguration(serviceClientDeviceConfigurationHandle, iotHubDeviceConfigurationRequestMode, id, json, maxConfigurationsCount, responseBuffer);
+    }
+    else if ((uriResource = STRING_construct(serviceClientDeviceConfigurationHandle->hostname)) == NULL)
     {
         LogError("STRING_construct failed for uriResource");
         result = IOTHUB_DEVICE_CONFIGURATION_ERROR;
@@ -241,33 +334,11 @@ static IOTHUB_DEVICE_CONFIGURATION_RESULT sendHttpRequestDeviceConfiguration(IOT
     }
     else
     {
-        HTTPAPI_REQUEST_TYPE httpApiRequestType = HTTPAPI_REQUEST_GET;
+        HTTPAPI_REQUEST_TYPE httpApiRequestType;
         STRING_HANDLE relativePath;
         unsigned int statusCode = 0;
-        unsigned char is_error = 0;
 
-        if ((iotHubDeviceConfigurationRequestMode == IOTHUB_DEVICECONFIGURATION_REQUEST_ADD) || (iotHubDeviceConfigurationRequestMode == IOTHUB_DEVICECONFIGURATION_REQUEST_UPDATE))
-        {
-            httpApiRequestType = HTTPAPI_REQUEST_PUT;
-        }
-        else if ((iotHubDeviceConfigurationRequestMode == IOTHUB_DEVICECONFIGURATION_REQUEST_GET) || (iotHubDeviceConfigurationRequestMode == IOTHUB_DEVICECONFIGURATION_REQUEST_GET_LIST))
-        {
-            httpApiRequestType = HTTPAPI_REQUEST_GET;
-        }
-        else if (iotHubDeviceConfigurationRequestMode == IOTHUB_DEVICECONFIGURATION_REQUEST_DELETE)
-        {
-            httpApiRequestType = HTTPAPI_REQUEST_DELETE;
-        }
-        else if (iotHubDeviceConfigurationRequestMode == IOTHUB_DEVICECONFIGURATION_REQUEST_APPLY_CONFIGURATION_CONTENT)
-        {
-            httpApiRequestType = HTTPAPI_REQUEST_POST;
-        }
-        else
-        {
-            is_error = 1;
-        }
-
-        if (is_error)
+        if (getHttpRequestType(iotHubDeviceConfigurationRequestMode, &httpApiRequestType) != 0)
         {
             LogError("Invalid request type");
             result = IOTHUB_DEVICE_CONFIGURATION_HTTPAPI_ERROR;
@@ -288,13 +359,7 @@ static IOTHUB_DEVICE_CONFIGURATION_RESULT sendHttpRequestDeviceConfiguration(IOT
             else
             {
                 STRING_delete(relativePath);
-                if ((((iotHubDeviceConfigurationRequestMode == IOTHUB_DEVICECONFIGURATION_REQUEST_ADD) ||
-                    (iotHubDeviceConfigurationRequestMode == IOTHUB_DEVICECONFIGURATION_REQUEST_GET) ||
-                    (iotHubDeviceConfigurationRequestMode == IOTHUB_DEVICECONFIGURATION_REQUEST_GET_LIST) ||
-                    (iotHubDeviceConfigurationRequestMode == IOTHUB_DEVICECONFIGURATION_REQUEST_UPDATE)) && (statusCode == 200)) ||
-                    ((iotHubDeviceConfigurationRequestMode == IOTHUB_DEVICECONFIGURATION_REQUEST_DELETE) && (statusCode == 204)) ||
-                    ((iotHubDeviceConfigurationRequestMode == IOTHUB_DEVICECONFIGURATION_REQUEST_APPLY_CONFIGURATION_CONTENT) && ((statusCode == 200) || (statusCode == 204)))
-                    )
+                if (isSuccessStatusCode(iotHubDeviceConfigurationRequestMode, statusCode))
                 {
                     result = IOTHUB_DEVICE_CONFIGURATION_OK;
                 }
@@ -943,6 +1008,10 @@ static void free_deviceConfiguration_handle(IOTHUB_SERVICE_CLIENT_DEVICE_CONFIGU
     free(deviceConfiguration->hostname);
     free(deviceConfiguration->sharedAccessKey);
     free(deviceConfiguration->keyName);
+    if (deviceConfiguration->httpPool != NULL)
+    {
+        service_client_http_pool_destroy(deviceConfiguration->httpPool);
+    }
     free(deviceConfiguration);
 }
 
@@ -958,6 +1027,7 @@ IOTHUB_SERVICE_CLIENT_DEVICE_CONFIGURATION_HANDLE IoTHubDeviceConfiguration_Crea
     else
     {
         IOTHUB_SERVICE_CLIENT_AUTH* serviceClientAuth = (IOTHUB_SERVICE_CLIENT_AUTH*)serviceClientHandle;
+        SERVICE_CLIENT_HTTP_POOL_HANDLE authHttpPool;
 
         if (serviceClientAuth->hostname == NULL)
         {
@@ -1013,6 +1083,12 @@ IOTHUB_SERVICE_CLIENT_DEVICE_CONFIGURATION_HANDLE IoTHubDeviceConfiguration_Crea
                     free_deviceConfiguration_handle(result);
                     result = NULL;
                 }
+                else if (((authHttpPool = service_client_auth_get_http_pool(serviceClientHandle)) != NULL) && ((result->httpPool = service_client_http_pool_clone(authHttpPool)) == NULL))
+                {
+                    LogError("service_client_http_pool_clone failed");
+                    free_deviceConfiguration_handle(result);
+                    result = NULL;
+                }
             }
         }
     }
@@ -14,10 +14,14 @@
 #include "azure_c_shared_utility/azure_base64.h"
 #include "azure_c_shared_utility/uniqueid.h"
 #include "azure_c_shared_utility/connection_string_parser.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/tickcounter.h"
 
 #include "parson.h"
 #include "iothub_devicemethod.h"
 #include "iothub_sc_version.h"
+#include "internal/iothub_service_client_http_pool.h"
+#include "internal/iothub_service_client_worker_pool.h"
 
 MU_DEFINE_ENUM_STRINGS_WITHOUT_INVALID(IOTHUB_DEVICE_METHOD_RESULT, IOTHUB_DEVICE_METHOD_RESULT_VALUES);
 
@@ -54,8 +58,27 @@ typedef struct IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_TAG
     char* hostname;
     char* sharedAccessKey;
     char* keyName;
+    SERVICE_CLIENT_HTTP_POOL_HANDLE httpPool;
 } IOTHUB_SERVICE_CLIENT_DEVICE_METHOD;
 
+/** @brief State shared by the threads of an IoTHubDeviceMethod_InvokeMany call
+*/
+typedef struct INVOKE_MANY_CONTEXT_TAG
+{
+    SERVICE_CLIENT_HTTP_POOL_HANDLE httpPool;
+    const char* const* deviceIds;
+    size_t deviceCount;
+    BUFFER_HANDLE httpPayloadBuffer;
+    IOTHUB_DEVICE_METHOD_INVOKE_MANY_CALLBACK deviceResultCallback;
+    void* context;
+    TICK_COUNTER_HANDLE tickCounter;
+    // Guards the fields below.
+    LOCK_HANDLE lock;
+    size_t completed;
+    size_t succeeded;
+    tickcounter_ms_t* latencies;
+} INVOKE_MANY_CONTEXT;
+
 static IOTHUB_DEVICE_METHOD_RESULT parseResponseJson(BUFFER_HANDLE responseJson, int* responseStatus, unsigned char** responsePayload, size_t* responsePayloadSize)
 {
     IOTHUB_DEVICE_METHOD_RESULT result;
@@ -261,6 +284,53 @@ static HTTP_HEADERS_HANDLE createHttpHeader(void)
     return httpHeader;
 }
 
+static IOTHUB_DEVICE_METHOD_RESULT sendPooledHttpRequestDeviceMethod(SERVICE_CLIENT_HTTP_POOL_HANDLE httpPool, IOTHUB_DEVICEMETHOD_REQUEST_MODE iotHubDeviceMethodRequestMode, const char* deviceId, const char* moduleId, BUFFER_HANDLE deviceJsonBuffer, BUFFER_HANDLE responseBuffer)
+{
+    IOTHUB_DEVICE_METHOD_RESULT result;
+    HTTP_HEADERS_HANDLE httpHeader;
+    STRING_HANDLE relativePath;
+    unsigned int statusCode = 0;
+
+    if (iotHubDeviceMethodRequestMode != IOTHUB_DEVICEMETHOD_REQUEST_INVOKE)
+    {
+        LogError("Invalid request type");
+        result = IOTHUB_DEVICE_METHOD_HTTPAPI_ERROR;
+    }
+    else if ((httpHeader = createHttpHeader()) == NULL)
+    {
+        LogError("HttpHeader creation failed");
+        result = IOTHUB_DEVICE_METHOD_ERROR;
+    }
+    else
+    {
+        if ((relativePath = createRelativePath(iotHubDeviceMethodRequestMode, deviceId, moduleId)) == NULL)
+        {
+            LogError("Failure creating relative path");
+            result = IOTHUB_DEVICE_METHOD_ERROR;
+        }
+        else
+        {
+            if (service_client_http_pool_execute_request(httpPool, HTTPAPI_REQUEST_POST, STRING_c_str(relativePath), httpHeader, deviceJsonBuffer, &statusCode, NULL, responseBuffer) != HTTPAPIEX_OK)
+            {
+                LogError("service_client_http_pool_execute_request failed (%s)", STRING_c_str(relativePath));
+                result = IOTHUB_DEVICE_METHOD_HTTPAPI_ERROR;
+            }
+            else if (statusCode == 200)
+            {
+                result = IOTHUB_DEVICE_METHOD_OK;
+            }
+            else
+            {
+                LogError("Http Failure status code %d.", statusCode);
+                result = IOTHUB_DEVICE_METHOD_ERROR;
+            }
+            STRING_delete(relativePath);
+        }
+        HTTPHeaders_Free(httpHeader);
+    }
+    return result;
+}
+
 static IOTHUB_DEVICE_METHOD_RESULT sendHttpRequestDeviceMethod(IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_HANDLE serviceClientDeviceMethodHandle, IOTHUB_DEVICEMETHOD_REQUEST_MODE iotHubDeviceMethodRequestMode, const char* deviceId, const char* moduleId, BUFFER_HANDLE deviceJsonBuffer, BUFFER_HANDLE responseBuffer)
 {
     IOTHUB_DEVICE_METHOD_RESULT result;
@@ -272,7 +342,11 @@ static IOTHUB_DEVICE_METHOD_RESULT sendHttpRequestDeviceMethod(IOTHUB_SERVICE_CL
     HTTPAPIEX_HANDLE httpExApiHandle;
     HTTP_HEADERS_HANDLE httpHeader;
 
-    if ((uriResource = STRING_construct(serviceClientDeviceMethodHandle->hostname)) == NULL)
+    if (serviceClientDeviceMethodHandle->httpPool != NULL)
+    {
+        result = sendPooledHttpRequestDeviceMethod(serviceClientDeviceMethodHandle->httpPool, iotHubDeviceMethodRequestMode, deviceId, moduleId, deviceJsonBuffer, responseBuffer);
+    }
+    else if ((uriResource = STRING_construct(serviceClientDeviceMethodHandle->hostname)) == NULL)
     {
         LogError("STRING_construct failed for uriResource");
         result = IOTHUB_DEVICE_METHOD_ERROR;
@@ -387,6 +461,7 @@ IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_HANDLE IoTHubDeviceMethod_Create(IOTHUB_SERV
     else
     {
         IOTHUB_SERVICE_CLIENT_AUTH* serviceClientAuth = (IOTHUB_SERVICE_CLIENT_AUTH*)serviceClientHandle;
+        SERVICE_CLIENT_HTTP_POOL_HANDLE authHttpPool;
 
         if (serviceClientAuth->hostname == NULL)
         {
@@ -443,6 +518,19 @@ IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_HANDLE IoTHubDeviceMethod_Create(IOTHUB_SERV
                     free(result);
                     result = NULL;
                 }
+                else if ((authHttpPool = service_client_auth_get_http_pool(serviceClientHandle)) == NULL)
+                {
+                    result->httpPool = NULL;
+                }
+                else if ((result->httpPool = service_client_http_pool_clone(authHttpPool)) == NULL)
+                {
+                    LogError("service_client_http_pool_clone failed");
+                    free(result->hostname);
+                    free(result->sharedAccessKey);
+                    free(result->keyName);
+                    free(result);
+                    result = NULL;
+                }
             }
         }
     }
@@ -458,6 +546,10 @@ void IoTHubDeviceMethod_Destroy(IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_HANDLE servi
         free(serviceClientDeviceMethod->hostname);
         free(serviceClientDeviceMethod->sharedAccessKey);
         free(serviceClientDeviceMethod->keyName);
+        if (serviceClientDeviceMethod->httpPool != NULL)
+        {
+            service_client_http_pool_destroy(serviceClientDeviceMethod->httpPool);
+        }
         free(serviceClientDeviceMethod);
     }
 }
@@ -536,3 +628,207 @@ IOTHUB_DEVICE_METHOD_RESULT IoTHubDeviceMethod_InvokeModule(IOTHUB_SERVICE_CLIEN
     return result;
 }
 
+
+static bool areDeviceIdsValid(const char* const* deviceIds, size_t deviceCount)
+{
+    bool result = true;
+    size_t i;
+
+    for (i = 0; result && i < deviceCount; i++)
+    {
+        if (deviceIds[i] == NULL)
+        {
+            LogError("deviceIds[%lu] cannot be NULL", (unsigned long)i);
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+static void invokeManyDevice(void* context, size_t index)
+{
+    INVOKE_MANY_CONTEXT* invokeManyContext = (INVOKE_MANY_CONTEXT*)context;
+    const char* deviceId = invokeManyContext->deviceIds[index];
+    IOTHUB_DEVICE_METHOD_RESULT result;
+    BUFFER_HANDLE responseBuffer;
+    int responseStatus = 0;
+    unsigned char* responsePayload = NULL;
+    size_t responsePayloadSize = 0;
+    tickcounter_ms_t startTime = 0;
+    tickcounter_ms_t endTime = 0;
+
+    (void)tickcounter_get_current_ms(invokeManyContext->tickCounter, &startTime);
+
+    if ((responseBuffer = BUFFER_new()) == NULL)
+    {
+        LogError("BUFFER_new failed for responseBuffer");
+        result = IOTHUB_DEVICE_METHOD_ERROR;
+    }
+    else
+    {
+        if ((result = sendPooledHttpRequestDeviceMethod(invokeManyContext->httpPool, IOTHUB_DEVICEMETHOD_REQUEST_INVOKE, deviceId, NULL, invokeManyContext->httpPayloadBuffer, responseBuffer)) != IOTHUB_DEVICE_METHOD_OK)
+        {
+            LogError("Failure sending HTTP request for device method invoke on %s", deviceId);
+        }
+        else if ((result = parseResponseJson(responseBuffer, &responseStatus, &responsePayload, &responsePayloadSize)) != IOTHUB_DEVICE_METHOD_OK)
+        {
+            LogError("Failure parsing response of %s", deviceId);
+        }
+        BUFFER_delete(responseBuffer);
+    }
+
+    (void)tickcounter_get_current_ms(invokeManyContext->tickCounter, &endTime);
+
+    if (Lock(invokeManyContext->lock) != LOCK_OK)
+    {
+        LogError("Lock failed, result of %s is not counted", deviceId);
+    }
+    else
+    {
+        invokeManyContext->latencies[invokeManyContext->completed++] = endTime - startTime;
+        if (result == IOTHUB_DEVICE_METHOD_OK)
+        {
+            invokeManyContext->succeeded++;
+        }
+        (void)Unlock(invokeManyContext->lock);
+    }
+
+    // Outside the lock, so a slow callback does not hold back the other workers.
+    if (invokeManyContext->deviceResultCallback != NULL)
+    {
+        invokeManyContext->deviceResultCallback(deviceId, result, responseStatus, responsePayload, responsePayloadSize, invokeManyContext->context);
+    }
+
+    free(responsePayload);
+}
+
+static int compareLatencies(const void* left, const void* right)
+{
+    tickcounter_ms_t leftLatency = *(const tickcounter_ms_t*)left;
+    tickcounter_ms_t rightLatency = *(const tickcounter_ms_t*)right;
+    return (leftLatency < rightLatency) ? -1 : ((leftLatency > rightLatency) ? 1 : 0);
+}
+
+static void computeInvokeManyStatistics(INVOKE_MANY_CONTEXT* invokeManyContext, tickcounter_ms_t elapsedTime, IOTHUB_DEVICE_METHOD_INVOKE_MANY_STATISTICS* statistics)
+{
+    size_t completed = invokeManyContext->completed;
+
+    (void)memset(statistics, 0, sizeof(IOTHUB_DEVICE_METHOD_INVOKE_MANY_STATISTICS));
+    statistics->succeeded = invokeManyContext->succeeded;
+    statistics->failed = completed - invokeManyContext->succeeded;
+    statistics->elapsedMs = (uint64_t)elapsedTime;
+
+    if (completed > 0)
+    {
+        uint64_t total = 0;
+        size_t i;
+
+        qsort(invokeManyContext->latencies, completed, sizeof(tickcounter_ms_t), compareLatencies);
+
+        for (i = 0; i < completed; i++)
+        {
+            total += (uint64_t)invokeManyContext->latencies[i];
+        }
+
+        statistics->averageLatencyMs = total / completed;
+        // Nearest rank.
+        statistics->p50LatencyMs = (uint64_t)invokeManyContext->latencies[(completed * 50 + 99) / 100 - 1];
+        statistics->p99LatencyMs = (uint64_t)invokeManyContext->latencies[(completed * 99 + 99) / 100 - 1];
+        statistics->maxLatencyMs = (uint64_t)invokeManyContext->latencies[completed - 1];
+    }
+}
+
+IOTHUB_DEVICE_METHOD_RESULT IoTHubDeviceMethod_InvokeMany(IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_HANDLE serviceClientDeviceMethodHandle, const char* const* deviceIds, size_t deviceCount, const char* methodName, const char* methodPayload, unsigned int timeout, size_t maxConcurrency, IOTHUB_DEVICE_METHOD_INVOKE_MANY_CALLBACK deviceResultCallback, void* context, IOTHUB_DEVICE_METHOD_INVOKE_MANY_STATISTICS* statistics)
+{
+    IOTHUB_DEVICE_METHOD_RESULT result;
+
+    if ((serviceClientDeviceMethodHandle == NULL) || (deviceIds == NULL) || (deviceCount == 0) || (methodName == NULL) || (maxConcurrency == 0))
+    {
+        LogError("Invalid argument (serviceClientDeviceMethodHandle=%p, deviceIds=%p, deviceCount=%lu, methodName=%p, maxConcurrency=%lu)",
+            serviceClientDeviceMethodHandle, deviceIds, (unsigned long)deviceCount, methodName, (unsigned long)maxConcurrency);
+        result = IOTHUB_DEVICE_METHOD_INVALID_ARG;
+    }
+    else if (!areDeviceIdsValid(deviceIds, deviceCount))
+    {
+        result = IOTHUB_DEVICE_METHOD_INVALID_ARG;
+    }
+    else
+    {
+        INVOKE_MANY_CONTEXT invokeManyContext;
+
+        (void)memset(&invokeManyContext, 0, sizeof(INVOKE_MANY_CONTEXT));
+        invokeManyContext.deviceIds = deviceIds;
+        invokeManyContext.deviceCount = deviceCount;
+        invokeManyContext.deviceResultCallback = deviceResultCallback;
+        invokeManyContext.context = context;
+
+        // The payload is the same for every device, so it is built once.
+        if ((invokeManyContext.httpPayloadBuffer = createMethodPayloadJson(methodName, timeout, methodPayload)) == NULL)
+        {
+            LogError("BUFFER creation failed for httpPayloadBuffer");
+            result = IOTHUB_DEVICE_METHOD_ERROR;
+        }
+        else if ((invokeManyContext.latencies = (tickcounter_ms_t*)malloc(sizeof(tickcounter_ms_t) * deviceCount)) == NULL)
+        {
+            LogError("Malloc failed for the latencies");
+            result = IOTHUB_DEVICE_METHOD_ERROR;
+        }
+        else if ((invokeManyContext.tickCounter = tickcounter_create()) == NULL)
+        {
+            LogError("tickcounter_create failed");
+            result = IOTHUB_DEVICE_METHOD_ERROR;
+        }
+        else if ((invokeManyContext.lock = Lock_Init()) == NULL)
+        {
+            LogError("Lock_Init failed");
+            result = IOTHUB_DEVICE_METHOD_ERROR;
+        }
+        else if ((invokeManyContext.httpPool = (serviceClientDeviceMethodHandle->httpPool != NULL) ?
+            service_client_http_pool_clone(serviceClientDeviceMethodHandle->httpPool) :
+            service_client_http_pool_create(serviceClientDeviceMethodHandle->hostname, serviceClientDeviceMethodHandle->sharedAccessKey, serviceClientDeviceMethodHandle->keyName, maxConcurrency)) == NULL)
+        {
+            LogError("Failed getting a connection pool");
+            result = IOTHUB_DEVICE_METHOD_HTTPAPI_ERROR;
+        }
+        else
+        {
+            tickcounter_ms_t startTime = 0;
+            tickcounter_ms_t endTime = 0;
+
+            (void)tickcounter_get_current_ms(invokeManyContext.tickCounter, &startTime);
+            (void)service_client_worker_pool_run(deviceCount, maxConcurrency, invokeManyDevice, &invokeManyContext);
+            (void)tickcounter_get_current_ms(invokeManyContext.tickCounter, &endTime);
+
+            if (statistics != NULL)
+            {
+                computeInvokeManyStatistics(&invokeManyContext, endTime - startTime, statistics);
+            }
+
+            if (invokeManyContext.completed != deviceCount)
+            {
+                LogError("Only %lu of %lu devices were called", (unsigned long)invokeManyContext.completed, (unsigned long)deviceCount);
+                result = IOTHUB_DEVICE_METHOD_ERROR;
+            }
+            else
+            {
+                result = IOTHUB_DEVICE_METHOD_OK;
+            }
+
+            service_client_http_pool_destroy(invokeManyContext.httpPool);
+        }
+
+        if (invokeManyContext.lock != NULL)
+        {
+            (void)Lock_Deinit(invokeManyContext.lock);
+        }
+        if (invokeManyContext.tickCounter != NULL)
+        {
+            tickcounter_destroy(invokeManyContext.tickCounter);
+        }
+        free(invokeManyContext.latencies);
+        BUFFER_delete(invokeManyContext.httpPayloadBuffer);
+    }
+
+    return result;
+}
@@ -19,6 +19,7 @@
 #include "parson.h"
 #include "iothub_devicetwin.h"
 #include "iothub_sc_version.h"
+#include "internal/iothub_service_client_http_pool.h"
 
 #define IOTHUB_TWIN_REQUEST_MODE_VALUES    \
     IOTHUB_TWIN_REQUEST_GET,               \
@@ -56,6 +57,7 @@ typedef struct IOTHUB_SERVICE_CLIENT_DEVICE_TWIN_TAG
     char* hostname;
     char* sharedAccessKey;
     char* keyName;
+    SERVICE_CLIENT_HTTP_POOL_HANDLE httpPool;
 } IOTHUB_SERVICE_CLIENT_DEVICE_TWIN;
 
 static const char* generateGuid(void)
@@ -155,6 +157,84 @@ static HTTP_HEADERS_HANDLE createHttpHeader(IOTHUB_TWIN_REQUEST_MODE iotHubTwinR
     return httpHeader;
 }
 
+static int getHttpRequestType(IOTHUB_TWIN_REQUEST_MODE iotHubTwinRequestMode, HTTPAPI_REQUEST_TYPE* httpApiRequestType)
+{
+    int result = 0;
+
+    //IOTHUB_TWIN_REQUEST_GET               GET      {iot hub}/twins/{device id}                     // Get device twin
+    //IOTHUB_TWIN_REQUEST_UPDATE            PATCH    {iot hub}/twins/{device id}                     // Partally update device twin
+    //IOTHUB_TWIN_REQUEST_REPLACE_TAGS      PUT      {iot hub}/twins/{device id}/tags                // Replace update tags
+    //IOTHUB_TWIN_REQUEST_REPLACE_DESIRED   PUT      {iot hub}/twins/{device id}/properties/desired  // Replace update desired properties
+    //IOTHUB_TWIN_REQUEST_UPDATE_DESIRED    PATCH    {iot hub}/twins/{device id}/properties/desired  // Partially update desired properties
+
+    if ((iotHubTwinRequestMode == IOTHUB_TWIN_REQUEST_REPLACE_TAGS) || (iotHubTwinRequestMode == IOTHUB_TWIN_REQUEST_REPLACE_DESIRED))
+    {
+        *httpApiRequestType = HTTPAPI_REQUEST_PUT;
+    }
+    else if ((iotHubTwinRequestMode == IOTHUB_TWIN_REQUEST_UPDATE) || (iotHubTwinRequestMode == IOTHUB_TWIN_REQUEST_UPDATE_DESIRED))
+    {
+        *httpApiRequestType = HTTPAPI_REQUEST_PATCH;
+    }
+    else if (iotHubTwinRequestMode == IOTHUB_TWIN_REQUEST_GET)
+    {
+        *httpApiRequestType = HTTPAPI_REQUEST_GET;
+    }
+    else
+    {
+        result = MU_FAILURE;
+    }
+
+    return result;
+}
+
+static IOTHUB_DEVICE_TWIN_RESULT sendPooledHttpRequestTwin(IOTHUB_SERVICE_CLIENT_DEVICE_TWIN_HANDLE serviceClientDeviceTwinHandle, IOTHUB_TWIN_REQUEST_MODE iotHubTwinRequestMode, const char* deviceName, const char* moduleId, BUFFER_HANDLE deviceJsonBuffer, BUFFER_HANDLE responseBuffer)
+{
+    IOTHUB_DEVICE_TWIN_RESULT result;
+    HTTPAPI_REQUEST_TYPE httpApiRequestType;
+    HTTP_HEADERS_HANDLE httpHeader;
+    STRING_HANDLE relativePath;
+    unsigned int statusCode = 0;
+
+    if (getHttpRequestType(iotHubTwinRequestMode, &httpApiRequestType) != 0)
+    {
+        LogError("Invalid request type");
+        result = IOTHUB_DEVICE_TWIN_HTTPAPI_ERROR;
+    }
+    else if ((httpHeader = createHttpHeader(iotHubTwinRequestMode)) == NULL)
+    {
+        LogError("HttpHeader creation failed");
+        result = IOTHUB_DEVICE_TWIN_ERROR;
+    }
+    else
+    {
+        if ((relativePath = createRelativePath(iotHubTwinRequestMode, deviceName, moduleId)) == NULL)
+        {
+            LogError("Failure creating relative path");
+            result = IOTHUB_DEVICE_TWIN_ERROR;
+        }
+        else
+        {
+            if (service_client_http_pool_execute_request(serviceClientDeviceTwinHandle->httpPool, httpApiRequestType, STRING_c_str(relativePath), httpHeader, deviceJsonBuffer, &statusCode, NULL, responseBuffer) != HTTPAPIEX_OK)
+            {
+                LogError("service_client_http_pool_execute_request failed");
+                result = IOTHUB_DEVICE_TWIN_HTTPAPI_ERROR;
+            }
+            else if (statusCode == 200)
+            {
+                result = IOTHUB_DEVICE_TWIN_OK;
+            }
+            else
+            {
+                LogError("Http Failure status code %d.", statusCode);
+                result = IOTHUB_DEVICE_TWIN_ERROR;
+            }
+            STRING_delete(relativePath);
+        }
+        HTTPHeaders_Free(httpHeader);
+    }
+    return result;
+}
+
 static IOTHUB_DEVICE_TWIN_RESULT sendHttpRequestTwin(IOTHUB_SERVICE_CLIENT_DEVICE_TWIN_HANDLE serviceClientDeviceTwinHandle, IOTHUB_TWIN_REQUEST_MODE iotHubTwinRequestMode, const char* deviceName, const char* moduleId, BUFFER_HANDLE deviceJsonBuffer, BUFFER_HANDLE responseBuffer)
 {
     IOTHUB_DEVICE_TWIN_RESULT result;
@@ -166,7 +246,11 @@ static IOTHUB_DEVICE_TWIN_RESULT sendHttpRequestTwin(IOTHUB_SERVICE_CLIENT_DEVIC
     HTTPAPIEX_HANDLE httpExApiHandle;
     HTTP_HEADERS_HANDLE httpHeader;
 
-    if ((uriResource = STRING_construct(serviceClientDeviceTwinHandle->hostname)) == NULL)
+    if (serviceClientDeviceTwinHandle->httpPool != NULL)
+    {
+        result = sendPooledHttpRequestTwin(serviceClientDeviceTwinHandle, iotHubTwinRequestMode, deviceName, moduleId, deviceJsonBuffer, responseBuffer);
+    }
+    else if ((uriResource = STRING_construct(serviceClientDeviceTwinHandle->hostname)) == NULL)
     {
         LogError("STRING_construct failed for uriResource");
         result = IOTHUB_DEVICE_TWIN_ERROR;
@@ -213,35 +297,11 @@ static IOTHUB_DEVICE_TWIN_RESULT sendHttpRequestTwin(IOTHUB_SERVICE_CLIENT_DEVIC
     }
     else
     {
-        HTTPAPI_REQUEST_TYPE httpApiRequestType = HTTPAPI_REQUEST_GET;
+        HTTPAPI_REQUEST_TYPE httpApiRequestType;
         STRING_HANDLE relativePath;
         unsigned int statusCode = 0;
-        unsigned char is_error = 0;
-
-        //IOTHUB_TWIN_REQUEST_GET               GET      {iot hub}/twins/{device id}                     // Get device twin
-        //IOTHUB_TWIN_REQUEST_UPDATE            PATCH    {iot hub}/twins/{device id}                     // Partally update device twin
-        //IOTHUB_TWIN_REQUEST_REPLACE_TAGS      PUT      {iot hub}/twins/{device id}/tags                // Replace update tags
-        //IOTHUB_TWIN_REQUEST_REPLACE_DESIRED   PUT      {iot hub}/twins/{device id}/properties/desired  // Replace update desired properties
-        //IOTHUB_TWIN_REQUEST_UPDATE_DESIRED    PATCH    {iot hub}/twins/{device id}/properties/desired  // Partially update desired properties
-
-        if ((iotHubTwinRequestMode == IOTHUB_TWIN_REQUEST_REPLACE_TAGS) || (iotHubTwinRequestMode == IOTHUB_TWIN_REQUEST_REPLACE_DESIRED))
-        {
-            httpApiRequestType = HTTPAPI_REQUEST_PUT;
-        }
-        else if ((iotHubTwinRequestMode == IOTHUB_TWIN_REQUEST_UPDATE) || (iotHubTwinRequestMode == IOTHUB_TWIN_REQUEST_UPDATE_DESIRED))
-        {
-            httpApiRequestType = HTTPAPI_REQUEST_PATCH;
-        }
-        else if (iotHubTwinRequestMode == IOTHUB_TWIN_REQUEST_GET)
-        {
-            httpApiRequestType = HTTPAPI_REQUEST_GET;
-        }
-        else
-        {
-            is_error = 1;
-        }
 
-        if (is_error)
+        if (getHttpRequestType(iotHubTwinRequestMode, &httpApiRequestType) != 0)
         {
             LogError("Invalid request type");
             result = IOTHUB_DEVICE_TWIN_HTTPAPI_ERROR;
@@ -288,6 +348,10 @@ static void free_devicetwin_handle(IOTHUB_SERVICE_CLIENT_DEVICE_TWIN* deviceTwin
     free(deviceTwin->hostname);
     free(deviceTwin->sharedAccessKey);
     free(deviceTwin->keyName);
+    if (deviceTwin->httpPool != NULL)
+    {
+        service_client_http_pool_destroy(deviceTwin->httpPool);
+    }
     free(deviceTwin);
 }
 
@@ -303,6 +367,7 @@ IOTHUB_SERVICE_CLIENT_DEVICE_TWIN_HANDLE IoTHubDeviceTwin_Create(IOTHUB_SERVICE_
     else
     {
         IOTHUB_SERVICE_CLIENT_AUTH* serviceClientAuth = (IOTHUB_SERVICE_CLIENT_AUTH*)serviceClientHandle;
+        SERVICE_CLIENT_HTTP_POOL_HANDLE authHttpPool;
 
         if (serviceClientAuth->hostname == NULL)
         {
@@ -358,6 +423,12 @@ IOTHUB_SERVICE_CLIENT_DEVICE_TWIN_HANDLE IoTHubDeviceTwin_Create(IOTHUB_SERVICE_
                     free_devicetwin_handle(result);
                     result = NULL;
                 }
+                else if (((authHttpPool = service_client_auth_get_http_pool(serviceClientHandle)) != NULL) && ((result->httpPool = service_client_http_pool_clone(authHttpPool)) == NULL))
+                {
+                    LogError("service_client_http_pool_clone failed");
+                    free_devicetwin_handle(result);
+                    result = NULL;
+                }
             }
         }
     }
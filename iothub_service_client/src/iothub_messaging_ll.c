@@ -26,6 +26,7 @@
 
 #include "iothub_messaging_ll.h"
 #include "iothub_sc_version.h"
+#include "internal/iothub_service_client_feedback.h"
 
 #define SIZE_OF_PERCENT_S_IN_FMT_STRING 2
 #define DEFAULT_MAX_SEND_QUEUE_SIZE     SIZE_MAX
@@ -80,9 +81,24 @@ typedef struct IOTHUB_MESSAGING_TAG
     size_t max_send_queue_size;
     size_t send_queue_size;
     size_t next_send_data_id;
+
+    // Reused by IoTHubMessaging_LL_SendBatch for the destination of every message it sends.
+    char* destination_buffer;
+    size_t destination_buffer_size;
+
+    size_t messages_queued;
+    size_t messages_sent;
+    size_t messages_failed;
+    size_t peak_send_queue_size;
+
+    // Set by IoTHubMessaging_LL_SetFeedbackRecordCallback; feedback is then parsed a record at a time.
+    FEEDBACK_DISPATCHER_HANDLE feedback_dispatcher;
 } IOTHUB_MESSAGING;
 
 
+// Feedback messages accepted and waiting for a worker, per worker; further ones are parsed by DoWork itself.
+#define FEEDBACK_MAX_PENDING_MESSAGES_PER_WORKER    2
+
 static const char* const FEEDBACK_RECORD_KEY_DEVICE_ID = "deviceId";
 static const char* const FEEDBACK_RECORD_KEY_DEVICE_GENERATION_ID = "deviceGenerationId";
 static const char* const FEEDBACK_RECORD_KEY_DESCRIPTION = "description";
@@ -139,6 +155,16 @@ static SEND_CALLBACK_DATA* enqueue_send_callback_data(IOTHUB_MESSAGING_HANDLE me
     return result;
 }
 
+static void record_message_queued(IOTHUB_MESSAGING_HANDLE messagingHandle)
+{
+    messagingHandle->messages_queued++;
+
+    if (messagingHandle->send_queue_size > messagingHandle->peak_send_queue_size)
+    {
+        messagingHandle->peak_send_queue_size = messagingHandle->send_queue_size;
+    }
+}
+
 static bool remove_single_send_data_condition_function(const void* item, const void* match_context, bool* continue_processing)
 {
     SEND_CALLBACK_DATA* current_send_data = (SEND_CALLBACK_DATA*)item;
@@ -194,6 +220,7 @@ static void dequeue_all_send_callback_data(IOTHUB_MESSAGING_HANDLE messagingHand
         LogError("Failed dequeueing all send_data.");
     }
 
+    messagingHandle->messages_failed += messagingHandle->send_queue_size;
     messagingHandle->send_queue_size = 0;
 }
 
@@ -658,13 +685,13 @@ static char* createDeviceDestinationString(const char* deviceId, const char* mod
         {
             if ((moduleId == NULL) && (snprintf(buffer, deviceDestLen, AMQP_ADDRESS_PATH_FMT, deviceId)) < 0)
             {
-                LogError("sprintf_s failed for deviceDestinationString.");
+                LogError("snprintf failed for deviceDestinationString.");
                 free((char*)buffer);
                 result = NULL;
             }
             else if ((moduleId != NULL) && (snprintf(buffer, deviceDestLen, AMQP_ADDRESS_PATH_MODULE_FMT, deviceId, moduleId)) < 0)
             {
-                LogError("sprintf_s failed for deviceDestinationString for module.");
+                LogError("snprintf failed for deviceDestinationString for module.");
                 free((char*)buffer);
                 result = NULL;
             }
@@ -730,23 +757,25 @@ static void IoTHubMessaging_LL_SendMessageComplete(void* context, MESSAGE_SEND_R
     {
         SEND_CALLBACK_DATA* send_data = (SEND_CALLBACK_DATA*)context;
 
-        if (send_data->callback != NULL)
+        // Convert a MESSAGE_SEND_RESULT to an IOTHUB_MESSAGING_RESULT.
+        IOTHUB_MESSAGING_RESULT msg_result;
+        switch (send_result)
         {
-            // Convert a MESSAGE_SEND_RESULT to an IOTHUB_MESSAGING_RESULT.
-            IOTHUB_MESSAGING_RESULT msg_result;
-            switch (send_result)
-            {
-                case MESSAGE_SEND_OK:
-                    msg_result = IOTHUB_MESSAGING_OK;
-                    break;
-                case MESSAGE_SEND_ERROR:
-                case MESSAGE_SEND_TIMEOUT:
-                case MESSAGE_SEND_CANCELLED:
-                default:
-                    msg_result = IOTHUB_MESSAGING_ERROR;
-                    break;
-            }
+            case MESSAGE_SEND_OK:
+                msg_result = IOTHUB_MESSAGING_OK;
+                send_data->messagingHandle->messages_sent++;
+                break;
+            case MESSAGE_SEND_ERROR:
+            case MESSAGE_SEND_TIMEOUT:
+            case MESSAGE_SEND_CANCELLED:
+            default:
+                msg_result = IOTHUB_MESSAGING_ERROR;
+                send_data->messagingHandle->messages_failed++;
+                break;
+        }
 
+        if (send_data->callback != NULL)
+        {
             send_data->callback(send_data->userContext, msg_result);
         }
 
@@ -754,6 +783,32 @@ static void IoTHubMessaging_LL_SendMessageComplete(void* context, MESSAGE_SEND_R
     }
 }
 
+static AMQP_VALUE dispatchFeedbackMessage(IOTHUB_MESSAGING* messagingData, MESSAGE_HANDLE message)
+{
+    AMQP_VALUE result;
+    BINARY_DATA binary_data;
+
+    binary_data.bytes = NULL;
+    binary_data.length = 0;
+
+    if (message_get_body_amqp_data_in_place(message, 0, &binary_data) != 0)
+    {
+        LogError("Cannot get message data");
+        result = messaging_delivery_rejected("Rejected due to failure reading AMQP message", "Failed reading message body");
+    }
+    else if (feedback_dispatcher_dispatch(messagingData->feedback_dispatcher, binary_data.bytes, binary_data.length) != 0)
+    {
+        LogError("Failed to read feedback records");
+        result = messaging_delivery_rejected("Rejected due to failure reading AMQP message", "Failed to read feedback records");
+    }
+    else
+    {
+        result = messaging_delivery_accepted();
+    }
+
+    return result;
+}
+
 static AMQP_VALUE IoTHubMessaging_LL_FeedbackMessageReceived(const void* context, MESSAGE_HANDLE message)
 {
     AMQP_VALUE result;
@@ -762,6 +817,10 @@ static AMQP_VALUE IoTHubMessaging_LL_FeedbackMessageReceived(const void* context
     {
         result = messaging_delivery_accepted();
     }
+    else if (((IOTHUB_MESSAGING*)context)->feedback_dispatcher != NULL)
+    {
+        result = dispatchFeedbackMessage((IOTHUB_MESSAGING*)context, message);
+    }
     else
     {
         IOTHUB_MESSAGING* messagingData = (IOTHUB_MESSAGING*)context;
@@ -1042,6 +1101,14 @@ void IoTHubMessaging_LL_Destroy(IOTHUB_MESSAGING_HANDLE messagingHandle)
         free(messHandle->sharedAccessKey);
         free(messHandle->keyName);
         free(messHandle->trusted_cert);
+        if (messHandle->destination_buffer != NULL)
+        {
+            free(messHandle->destination_buffer);
+        }
+        if (messHandle->feedback_dispatcher != NULL)
+        {
+            feedback_dispatcher_destroy(messHandle->feedback_dispatcher);
+        }
         free(messHandle);
     }
 }
@@ -1432,6 +1499,36 @@ IOTHUB_MESSAGING_RESULT IoTHubMessaging_LL_SetFeedbackMessageCallback(IOTHUB_MES
     return result;
 }
 
+IOTHUB_MESSAGING_RESULT IoTHubMessaging_LL_SetFeedbackRecordCallback(IOTHUB_MESSAGING_HANDLE messagingHandle, IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK feedbackRecordReceivedCallback, void* userContextCallback, size_t workerCount)
+{
+    IOTHUB_MESSAGING_RESULT result;
+    FEEDBACK_DISPATCHER_HANDLE feedbackDispatcher = NULL;
+
+    if (messagingHandle == NULL)
+    {
+        LogError("Input parameter cannot be NULL");
+        result = IOTHUB_MESSAGING_INVALID_ARG;
+    }
+    else if ((feedbackRecordReceivedCallback != NULL) &&
+        ((feedbackDispatcher = feedback_dispatcher_create(workerCount, workerCount * FEEDBACK_MAX_PENDING_MESSAGES_PER_WORKER, feedbackRecordReceivedCallback, userContextCallback)) == NULL))
+    {
+        LogError("Failed creating the feedback dispatcher");
+        result = IOTHUB_MESSAGING_ERROR;
+    }
+    else
+    {
+        if (messagingHandle->feedback_dispatcher != NULL)
+        {
+            // Lets the workers finish the feedback already accepted, with the callback it was accepted for.
+            feedback_dispatcher_destroy(messagingHandle->feedback_dispatcher);
+        }
+
+        messagingHandle->feedback_dispatcher = feedbackDispatcher;
+        result = IOTHUB_MESSAGING_OK;
+    }
+    return result;
+}
+
 IOTHUB_MESSAGING_RESULT IoTHubMessaging_LL_Send(IOTHUB_MESSAGING_HANDLE messagingHandle, const char* deviceId, IOTHUB_MESSAGE_HANDLE message, IOTHUB_SEND_COMPLETE_CALLBACK sendCompleteCallback, void* userContextCallback)
 {
     IOTHUB_MESSAGING_RESULT result;
@@ -1538,6 +1635,7 @@ IOTHUB_MESSAGING_RESULT IoTHubMessaging_LL_Send(IOTHUB_MESSAGING_HANDLE messagin
                         }
                         else
                         {
+                            record_message_queued(messagingHandle);
                             result = IOTHUB_MESSAGING_OK;
                         }
                     }
@@ -1551,6 +1649,261 @@ IOTHUB_MESSAGING_RESULT IoTHubMessaging_LL_Send(IOTHUB_MESSAGING_HANDLE messagin
     return result;
 }
 
+static const char* formatDeviceDestination(IOTHUB_MESSAGING_HANDLE messagingHandle, const char* deviceId)
+{
+    const char* result;
+    size_t deviceDestLen = strlen(AMQP_ADDRESS_PATH_FMT) + strlen(deviceId) + 1;
+    char* buffer;
+
+    if (deviceDestLen <= messagingHandle->destination_buffer_size)
+    {
+        buffer = messagingHandle->destination_buffer;
+    }
+    else if ((buffer = (char*)realloc(messagingHandle->destination_buffer, deviceDestLen)) != NULL)
+    {
+        messagingHandle->destination_buffer = buffer;
+        messagingHandle->destination_buffer_size = deviceDestLen;
+    }
+
+    if (buffer == NULL)
+    {
+        LogError("Could not grow the device destination buffer.");
+        result = NULL;
+    }
+    else if (snprintf(buffer, messagingHandle->destination_buffer_size, AMQP_ADDRESS_PATH_FMT, deviceId) < 0)
+    {
+        LogError("sprintf_s failed for deviceDestinationString.");
+        result = NULL;
+    }
+    else
+    {
+        result = buffer;
+    }
+
+    return result;
+}
+
+// Encodes everything but the destination of the message: body, application properties, message and correlation ids.
+static MESSAGE_HANDLE createBatchMessage(IOTHUB_MESSAGE_HANDLE message, PROPERTIES_HANDLE* properties)
+{
+    MESSAGE_HANDLE result;
+    unsigned const char* messageContent;
+    size_t messageContentSize;
+
+    *properties = NULL;
+
+    if (getMessageContentAndSize(message, &messageContent, &messageContentSize) != 0)
+    {
+        LogError("Failed getting the message content and message size from IOTHUB_MESSAGE_HANDLE instance.");
+        result = NULL;
+    }
+    else if ((result = message_create()) == NULL)
+    {
+        LogError("Could not create a message.");
+    }
+    else
+    {
+        BINARY_DATA binary_data;
+
+        binary_data.bytes = messageContent;
+        binary_data.length = messageContentSize;
+
+        if (message_add_body_amqp_data(result, binary_data) != 0)
+        {
+            LogError("Failed setting the body of the uAMQP message.");
+            message_destroy(result);
+            result = NULL;
+        }
+        else if (addApplicationPropertiesToAMQPMessage(message, result) != 0)
+        {
+            LogError("Failed setting application properties of the uAMQP message.");
+            message_destroy(result);
+            result = NULL;
+        }
+        else if ((*properties = properties_create()) == NULL)
+        {
+            LogError("Failed to create properties map for uAMQP message.");
+            message_destroy(result);
+            result = NULL;
+        }
+        else if ((setMessageId(message, *properties) != 0) || (setCorrelationId(message, *properties) != 0))
+        {
+            LogError("Failed to set uampq messageId or correlationId.");
+            properties_destroy(*properties);
+            *properties = NULL;
+            message_destroy(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+static IOTHUB_MESSAGING_RESULT sendBatchItem(IOTHUB_MESSAGING_HANDLE messagingHandle, MESSAGE_HANDLE amqpMessage, PROPERTIES_HANDLE properties, const IOTHUB_MESSAGING_BATCH_ITEM* item)
+{
+    IOTHUB_MESSAGING_RESULT result;
+    const char* deviceDestination;
+    AMQP_VALUE to_amqp_value;
+
+    if ((deviceDestination = formatDeviceDestination(messagingHandle, item->deviceId)) == NULL)
+    {
+        LogError("Could not create the destination of the message.");
+        result = IOTHUB_MESSAGING_ERROR;
+    }
+    else if ((to_amqp_value = amqpvalue_create_string(deviceDestination)) == NULL)
+    {
+        LogError("Could not create properties for message - amqpvalue_create_string");
+        result = IOTHUB_MESSAGING_ERROR;
+    }
+    else
+    {
+        SEND_CALLBACK_DATA* send_data;
+
+        // The sender takes its own copy of the message, so the same one is readdressed for every device.
+        if (properties_set_to(properties, to_amqp_value) != 0)
+        {
+            LogError("Could not create properties for message - properties_set_to failed");
+            result = IOTHUB_MESSAGING_ERROR;
+        }
+        else if (message_set_properties(amqpMessage, properties) != 0)
+        {
+            LogError("Failed to set properties map on uAMQP message.");
+            result = IOTHUB_MESSAGING_ERROR;
+        }
+        else if ((send_data = enqueue_send_callback_data(messagingHandle, item->sendCompleteCallback, item->userContextCallback)) == NULL)
+        {
+            LogError("Failed enqueueing message.");
+            result = IOTHUB_MESSAGING_ERROR;
+        }
+        else if (messagesender_send_async(messagingHandle->message_sender, amqpMessage, IoTHubMessaging_LL_SendMessageComplete, send_data, 0) == NULL)
+        {
+            LogError("messagesender_send_async failed.");
+            dequeue_send_callback_data(send_data);
+            result = IOTHUB_MESSAGING_ERROR;
+        }
+        else
+        {
+            record_message_queued(messagingHandle);
+            result = IOTHUB_MESSAGING_OK;
+        }
+
+        amqpvalue_destroy(to_amqp_value);
+    }
+
+    return result;
+}
+
+IOTHUB_MESSAGING_RESULT IoTHubMessaging_LL_SendBatch(IOTHUB_MESSAGING_HANDLE messagingHandle, const IOTHUB_MESSAGING_BATCH_ITEM* items, size_t itemCount, size_t* itemsQueued)
+{
+    IOTHUB_MESSAGING_RESULT result;
+    size_t i;
+
+    if ((messagingHandle == NULL) || (items == NULL) || (itemCount == 0) || (itemsQueued == NULL))
+    {
+        LogError("Invalid argument (messagingHandle=%p, items=%p, itemCount=%lu, itemsQueued=%p)", messagingHandle, items, (unsigned long)itemCount, itemsQueued);
+        result = IOTHUB_MESSAGING_INVALID_ARG;
+    }
+    else
+    {
+        for (i = 0; i < itemCount; i++)
+        {
+            if ((items[i].deviceId == NULL) || (items[i].message == NULL))
+            {
+                break;
+            }
+        }
+
+        if (i < itemCount)
+        {
+            LogError("Item %lu has no deviceId or message", (unsigned long)i);
+            result = IOTHUB_MESSAGING_INVALID_ARG;
+        }
+        else if (messagingHandle->isOpened == 0)
+        {
+            LogError("Messaging is not opened - call IoTHubMessaging_LL_Open to open");
+            result = IOTHUB_MESSAGING_ERROR;
+        }
+        else
+        {
+            IOTHUB_MESSAGE_HANDLE encodedMessage = NULL;
+            MESSAGE_HANDLE amqpMessage = NULL;
+            PROPERTIES_HANDLE properties = NULL;
+
+            *itemsQueued = 0;
+            result = IOTHUB_MESSAGING_OK;
+
+            while ((result == IOTHUB_MESSAGING_OK) && (*itemsQueued < itemCount))
+            {
+                const IOTHUB_MESSAGING_BATCH_ITEM* item = &items[*itemsQueued];
+
+                if (is_send_queue_full(messagingHandle))
+                {
+                    // Not an error: the caller resumes from itemsQueued once DoWork has settled some messages.
+                    result = IOTHUB_MESSAGING_QUEUE_FULL;
+                }
+                else
+                {
+                    // Consecutive items carrying the same message, as in a broadcast, are encoded once.
+                    if (item->message != encodedMessage)
+                    {
+                        if (amqpMessage != NULL)
+                        {
+                            properties_destroy(properties);
+                            message_destroy(amqpMessage);
+                        }
+
+                        if ((amqpMessage = createBatchMessage(item->message, &properties)) == NULL)
+                        {
+                            LogError("Failed encoding the message of item %lu", (unsigned long)*itemsQueued);
+                            encodedMessage = NULL;
+                            result = IOTHUB_MESSAGING_ERROR;
+                        }
+                        else
+                        {
+                            encodedMessage = item->message;
+                        }
+                    }
+
+                    if ((result == IOTHUB_MESSAGING_OK) && ((result = sendBatchItem(messagingHandle, amqpMessage, properties, item)) == IOTHUB_MESSAGING_OK))
+                    {
+                        (*itemsQueued)++;
+                    }
+                }
+            }
+
+            if (amqpMessage != NULL)
+            {
+                properties_destroy(properties);
+                message_destroy(amqpMessage);
+            }
+        }
+    }
+
+    return result;
+}
+
+IOTHUB_MESSAGING_RESULT IoTHubMessaging_LL_GetSendStatistics(IOTHUB_MESSAGING_HANDLE messagingHandle, IOTHUB_MESSAGING_SEND_STATISTICS* statistics)
+{
+    IOTHUB_MESSAGING_RESULT result;
+
+    if ((messagingHandle == NULL) || (statistics == NULL))
+    {
+        LogError("Invalid argument messagingHandle: %p statistics: %p", messagingHandle, statistics);
+        result = IOTHUB_MESSAGING_INVALID_ARG;
+    }
+    else
+    {
+        statistics->messagesQueued = messagingHandle->messages_queued;
+        statistics->messagesSent = messagingHandle->messages_sent;
+        statistics->messagesFailed = messagingHandle->messages_failed;
+        statistics->inFlight = messagingHandle->send_queue_size;
+        statistics->peakInFlight = messagingHandle->peak_send_queue_size;
+        statistics->sendWindow = is_send_queue_full(messagingHandle) ? 0 : messagingHandle->max_send_queue_size - messagingHandle->send_queue_size;
+        result = IOTHUB_MESSAGING_OK;
+    }
+
+    return result;
+}
 
 void IoTHubMessaging_LL_DoWork(IOTHUB_MESSAGING_HANDLE messagingHandle)
 {
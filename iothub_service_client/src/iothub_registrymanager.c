@@ -12,10 +12,13 @@
 #include "azure_c_shared_utility/httpapiex.h"
 #include "azure_c_shared_utility/httpapiexsas.h"
 #include "azure_c_shared_utility/connection_string_parser.h"
+#include "azure_c_shared_utility/threadapi.h"
 
 #include "parson.h"
 #include "iothub_registrymanager.h"
 #include "iothub_sc_version.h"
+#include "internal/iothub_service_client_http_pool.h"
+#include "internal/iothub_service_client_worker_pool.h"
 
 #define IOTHUB_DEVICE_EX_VERSION_LATEST IOTHUB_DEVICE_EX_VERSION_1
 #define IOTHUB_REGISTRY_DEVICE_CREATE_EX_VERSION_LATEST IOTHUB_REGISTRY_DEVICE_CREATE_EX_VERSION_1
@@ -23,6 +26,7 @@
 #define IOTHUB_MODULE_VERSION_LATEST IOTHUB_MODULE_VERSION_1
 #define IOTHUB_REGISTRY_MODULE_CREATE_VERSION_LATEST IOTHUB_REGISTRY_MODULE_CREATE_VERSION_1
 #define IOTHUB_REGISTRY_MODULE_UPDATE_VERSION_LATEST IOTHUB_REGISTRY_MODULE_UPDATE_VERSION_1
+#define IOTHUB_REGISTRY_BULK_OPERATION_VERSION_LATEST IOTHUB_REGISTRY_BULK_OPERATION_VERSION_1
 
 
 #define IOTHUB_REQUEST_MODE_VALUES    \
@@ -31,7 +35,9 @@
     IOTHUB_REQUEST_UPDATE,            \
     IOTHUB_REQUEST_DELETE,            \
     IOTHUB_REQUEST_GET_DEVICE_LIST,   \
-    IOTHUB_REQUEST_GET_STATISTICS     \
+    IOTHUB_REQUEST_GET_STATISTICS,    \
+    IOTHUB_REQUEST_QUERY,             \
+    IOTHUB_REQUEST_BULK               \
 
 MU_DEFINE_ENUM(IOTHUB_REQUEST_MODE, IOTHUB_REQUEST_MODE_VALUES);
 
@@ -50,8 +56,11 @@ MU_DEFINE_ENUM_STRINGS_WITHOUT_INVALID(IOTHUB_REGISTRYMANAGER_AUTH_METHOD, IOTHU
 #define  HTTP_HEADER_VAL_CONTENT_TYPE  "application/json; charset=utf-8"
 #define  HTTP_HEADER_KEY_IFMATCH  "If-Match"
 #define  HTTP_HEADER_VAL_IFMATCH  "*"
+#define  HTTP_HEADER_KEY_MAX_ITEM_COUNT  "x-ms-max-item-count"
+#define  HTTP_HEADER_KEY_CONTINUATION  "x-ms-continuation"
 
 static size_t IOTHUB_DEVICES_MAX_REQUEST = 1000;
+static size_t IOTHUB_DEVICES_MAX_BULK_REQUEST = 100;
 
 static const char* DEVICE_JSON_KEY_DEVICE_NAME = "deviceId";
 static const char* DEVICE_JSON_KEY_MODULE_NAME = "moduleId";
@@ -101,6 +110,29 @@ static const char* RELATIVE_PATH_MODULE_FMT_CRUD = "/devices/%s/modules/%s?%s";
 static const char* RELATIVE_PATH_FMT_LIST = "/devices/?top=%s&%s";
 static const char* RELATIVE_PATH_FMT_STAT = "/statistics/devices?%s";
 static const char* RELATIVE_PATH_FMT_MODULE_LIST = "/devices/%s/modules?%s";
+static const char* RELATIVE_PATH_FMT_QUERY = "/devices/query?%s";
+static const char* RELATIVE_PATH_FMT_BULK = "/devices?%s";
+
+static const char* QUERY_JSON_ALL_DEVICES = "{\"query\":\"SELECT * FROM devices\"}";
+static const char* QUERY_JSON_ALL_MODULES = "{\"query\":\"SELECT * FROM devices.modules\"}";
+
+// Query results are twins, which name these differently from the registry identity.
+static const char* TWIN_JSON_KEY_AUTH_TYPE = "authenticationType";
+static const char* TWIN_JSON_KEY_STATUSUPDATETIME = "statusUpdateTime";
+
+static const char* BULK_JSON_KEY_DEVICE_ID = "id";
+static const char* BULK_JSON_KEY_IMPORT_MODE = "importMode";
+static const char* BULK_JSON_KEY_ETAG = "eTag";
+static const char* BULK_JSON_KEY_ERRORS = "errors";
+static const char* BULK_JSON_KEY_ERROR_DEVICE_ID = "deviceId";
+static const char* BULK_JSON_KEY_ERROR_CODE = "errorCode";
+static const char* BULK_JSON_VALUE_CREATE = "create";
+static const char* BULK_JSON_VALUE_UPDATE = "update";
+static const char* BULK_JSON_VALUE_UPDATE_IF_MATCH_ETAG = "updateIfMatchETag";
+static const char* BULK_JSON_VALUE_DELETE = "delete";
+static const char* BULK_JSON_VALUE_DELETE_IF_MATCH_ETAG = "deleteIfMatchETag";
+static const char* BULK_JSON_VALUE_DEVICE_ALREADY_EXISTS = "DeviceAlreadyExists";
+static const char* BULK_JSON_VALUE_DEVICE_NOT_FOUND = "DeviceNotFound";
 
 typedef enum {IOTHUB_REGISTRYMANAGER_MODEL_TYPE_DEVICE, IOTHUB_REGISTRYMANAGER_MODEL_TYPE_MODULE} IOTHUB_REGISTRYMANAGER_MODEL_TYPE;
 
@@ -164,6 +196,50 @@ typedef struct IOTHUB_REGISTRY_DEVICE_OR_MODULE_UPDATE_TAG
     const char* managedBy;
 } IOTHUB_REGISTRY_DEVICE_OR_MODULE_UPDATE;
 
+typedef struct REGISTRY_QUERY_PAGE_TAG
+{
+    BUFFER_HANDLE body;         // the JSON array returned by the service, followed by a NUL
+    size_t length;              // length of the JSON, not counting the NUL
+    size_t offset;              // where the next unread element starts
+    char* continuationToken;    // NULL on the last page
+    IOTHUB_REGISTRYMANAGER_RESULT result;
+} REGISTRY_QUERY_PAGE;
+
+typedef struct IOTHUB_REGISTRYMANAGER_ITERATOR_TAG
+{
+    IOTHUB_REGISTRYMANAGER_HANDLE registryManagerHandle;
+    IOTHUB_REGISTRYMANAGER_MODEL_TYPE type;
+    BUFFER_HANDLE query;
+    size_t pageSize;
+    bool prefetch;
+    bool started;
+    REGISTRY_QUERY_PAGE current;
+    REGISTRY_QUERY_PAGE next;
+    THREAD_HANDLE prefetchThread;
+} IOTHUB_REGISTRYMANAGER_ITERATOR;
+
+typedef struct IOTHUB_REGISTRYMANAGER_INSTANCE_TAG
+{
+    // Must stay first: IOTHUB_REGISTRYMANAGER_HANDLE points to it.
+    IOTHUB_REGISTRYMANAGER registryManager;
+    // Shared with the IOTHUB_SERVICE_CLIENT_AUTH_HANDLE when its connection pool is enabled; NULL otherwise.
+    SERVICE_CLIENT_HTTP_POOL_HANDLE httpPool;
+} IOTHUB_REGISTRYMANAGER_INSTANCE;
+
+typedef struct BULK_OPERATION_CONTEXT_TAG
+{
+    SERVICE_CLIENT_HTTP_POOL_HANDLE httpPool;
+    const IOTHUB_REGISTRY_BULK_OPERATION* operations;
+    size_t operationCount;
+    // Each batch owns its slice.
+    IOTHUB_REGISTRYMANAGER_RESULT* operationResults;
+} BULK_OPERATION_CONTEXT;
+
+static SERVICE_CLIENT_HTTP_POOL_HANDLE getHttpPool(IOTHUB_REGISTRYMANAGER_HANDLE registryManagerHandle)
+{
+    return ((IOTHUB_REGISTRYMANAGER_INSTANCE*)registryManagerHandle)->httpPool;
+}
+
 static void initializeDeviceOrModuleInfoMembers(IOTHUB_DEVICE_OR_MODULE* deviceOrModuleInfo)
 {
     if (NULL != deviceOrModuleInfo)
@@ -1067,6 +1143,14 @@ static IOTHUB_REGISTRYMANAGER_RESULT createRelativePath(IOTHUB_REQUEST_MODE iotH
             result = IOTHUB_REGISTRYMANAGER_ERROR;
         }
     }
+    else if (iotHubRequestMode == IOTHUB_REQUEST_QUERY)
+    {
+        result = (snprintf(relativePath, 256, RELATIVE_PATH_FMT_QUERY, URL_API_VERSION) > 0) ? IOTHUB_REGISTRYMANAGER_OK : IOTHUB_REGISTRYMANAGER_ERROR;
+    }
+    else if (iotHubRequestMode == IOTHUB_REQUEST_BULK)
+    {
+        result = (snprintf(relativePath, 256, RELATIVE_PATH_FMT_BULK, URL_API_VERSION) > 0) ? IOTHUB_REGISTRYMANAGER_OK : IOTHUB_REGISTRYMANAGER_ERROR;
+    }
     else
     {
         if (moduleId != NULL)
@@ -1146,6 +1230,101 @@ static STRING_HANDLE createUriPath(IOTHUB_REGISTRYMANAGER_HANDLE registryManager
     }
 }
 
+static int getHttpRequestType(IOTHUB_REQUEST_MODE iotHubRequestMode, HTTPAPI_REQUEST_TYPE* httpApiRequestType)
+{
+    int result = 0;
+
+    if ((iotHubRequestMode == IOTHUB_REQUEST_CREATE) || (iotHubRequestMode == IOTHUB_REQUEST_UPDATE))
+    {
+        *httpApiRequestType = HTTPAPI_REQUEST_PUT;
+    }
+    else if (iotHubRequestMode == IOTHUB_REQUEST_DELETE)
+    {
+        *httpApiRequestType = HTTPAPI_REQUEST_DELETE;
+    }
+    else if ((iotHubRequestMode == IOTHUB_REQUEST_GET) || (iotHubRequestMode == IOTHUB_REQUEST_GET_DEVICE_LIST) || (iotHubRequestMode == IOTHUB_REQUEST_GET_STATISTICS))
+    {
+        *httpApiRequestType = HTTPAPI_REQUEST_GET;
+    }
+    else if ((iotHubRequestMode == IOTHUB_REQUEST_QUERY) || (iotHubRequestMode == IOTHUB_REQUEST_BULK))
+    {
+        *httpApiRequestType = HTTPAPI_REQUEST_POST;
+    }
+    else
+    {
+        result = MU_FAILURE;
+    }
+
+    return result;
+}
+
+static IOTHUB_REGISTRYMANAGER_RESULT getResultFromStatusCode(IOTHUB_REQUEST_MODE iotHubRequestMode, unsigned int statusCode)
+{
+    IOTHUB_REGISTRYMANAGER_RESULT result;
+
+    if (statusCode > 300)
+    {
+        if ((iotHubRequestMode == IOTHUB_REQUEST_CREATE) && (statusCode == 409))
+        {
+            result = IOTHUB_REGISTRYMANAGER_DEVICE_EXIST;
+        }
+        else if ((iotHubRequestMode == IOTHUB_REQUEST_GET) && (statusCode == 404))
+        {
+            result = IOTHUB_REGISTRYMANAGER_DEVICE_NOT_EXIST;
+        }
+        else
+        {
+            LogError("Http Failure status code %d.", statusCode);
+            result = IOTHUB_REGISTRYMANAGER_HTTP_STATUS_ERROR;
+        }
+    }
+    else
+    {
+        result = IOTHUB_REGISTRYMANAGER_OK;
+    }
+
+    return result;
+}
+
+static IOTHUB_REGISTRYMANAGER_RESULT sendPooledHttpRequestCRUD(IOTHUB_REGISTRYMANAGER_HANDLE registryManagerHandle, IOTHUB_REQUEST_MODE iotHubRequestMode, const char* deviceName, const char* moduleId, BUFFER_HANDLE deviceJsonBuffer, size_t numberOfDevices, BUFFER_HANDLE responseBuffer)
+{
+    IOTHUB_REGISTRYMANAGER_RESULT result;
+    HTTPAPI_REQUEST_TYPE httpApiRequestType;
+    HTTP_HEADERS_HANDLE httpHeader;
+    char relativePath[256];
+    unsigned int statusCode;
+
+    if (getHttpRequestType(iotHubRequestMode, &httpApiRequestType) != 0)
+    {
+        LogError("Invalid request type");
+        result = IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR;
+    }
+    else if (createRelativePath(iotHubRequestMode, deviceName, moduleId, numberOfDevices, relativePath) != IOTHUB_REGISTRYMANAGER_OK)
+    {
+        LogError("Failure creating relative path");
+        result = IOTHUB_REGISTRYMANAGER_ERROR;
+    }
+    else if ((httpHeader = createHttpHeader(iotHubRequestMode)) == NULL)
+    {
+        LogError("HttpHeader creation failed");
+        result = IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR;
+    }
+    else
+    {
+        if (service_client_http_pool_execute_request(getHttpPool(registryManagerHandle), httpApiRequestType, relativePath, httpHeader, deviceJsonBuffer, &statusCode, NULL, responseBuffer) != HTTPAPIEX_OK)
+        {
+            LogError("service_client_http_pool_execute_request failed. Host:%s", registryManagerHandle->hostname);
+            result = IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR;
+        }
+        else
+        {
+            result = getResultFromStatusCode(iotHubRequestMode, statusCode);
+        }
+        HTTPHeaders_Free(httpHeader);
+    }
+    return result;
+}
+
 static IOTHUB_REGISTRYMANAGER_RESULT sendHttpRequestCRUD(IOTHUB_REGISTRYMANAGER_HANDLE registryManagerHandle, IOTHUB_REQUEST_MODE iotHubRequestMode, const char* deviceName, const char* moduleId, BUFFER_HANDLE deviceJsonBuffer, size_t numberOfDevices, BUFFER_HANDLE responseBuffer)
 {
     IOTHUB_REGISTRYMANAGER_RESULT result;
@@ -1157,7 +1336,11 @@ static IOTHUB_REGISTRYMANAGER_RESULT sendHttpRequestCRUD(IOTHUB_REGISTRYMANAGER_
     HTTPAPIEX_HANDLE httpExApiHandle = NULL;
     HTTP_HEADERS_HANDLE httpHeader = NULL;
 
-    if ((uriResource = createUriPath(registryManagerHandle)) == NULL)
+    if (getHttpPool(registryManagerHandle) != NULL)
+    {
+        result = sendPooledHttpRequestCRUD(registryManagerHandle, iotHubRequestMode, deviceName, moduleId, deviceJsonBuffer, numberOfDevices, responseBuffer);
+    }
+    else if ((uriResource = createUriPath(registryManagerHandle)) == NULL)
     {
         LogError("STRING_construct failed for uriResource");
         result = IOTHUB_REGISTRYMANAGER_ERROR;
@@ -1189,29 +1372,11 @@ static IOTHUB_REGISTRYMANAGER_RESULT sendHttpRequestCRUD(IOTHUB_REGISTRYMANAGER_
     }
     else
     {
-        HTTPAPI_REQUEST_TYPE httpApiRequestType = HTTPAPI_REQUEST_GET;
+        HTTPAPI_REQUEST_TYPE httpApiRequestType;
         char relativePath[256];
         unsigned int statusCode;
-        unsigned char is_error = 0;
-
-        if ((iotHubRequestMode == IOTHUB_REQUEST_CREATE) || (iotHubRequestMode == IOTHUB_REQUEST_UPDATE))
-        {
-            httpApiRequestType = HTTPAPI_REQUEST_PUT;
-        }
-        else if (iotHubRequestMode == IOTHUB_REQUEST_DELETE)
-        {
-            httpApiRequestType = HTTPAPI_REQUEST_DELETE;
-        }
-        else if ((iotHubRequestMode == IOTHUB_REQUEST_GET) || (iotHubRequestMode == IOTHUB_REQUEST_GET_DEVICE_LIST) || (iotHubRequestMode == IOTHUB_REQUEST_GET_STATISTICS))
-        {
-            httpApiRequestType = HTTPAPI_REQUEST_GET;
-        }
-        else
-        {
-            is_error = 1;
-        }
 
-        if (is_error)
+        if (getHttpRequestType(iotHubRequestMode, &httpApiRequestType) != 0)
         {
             LogError("Invalid request type");
             result = IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR;
@@ -1230,26 +1395,7 @@ static IOTHUB_REGISTRYMANAGER_RESULT sendHttpRequestCRUD(IOTHUB_REGISTRYMANAGER_
             }
             else
             {
-                if (statusCode > 300)
-                {
-                    if ((iotHubRequestMode == IOTHUB_REQUEST_CREATE) && (statusCode == 409))
-                    {
-                        result = IOTHUB_REGISTRYMANAGER_DEVICE_EXIST;
-                    }
-                    else if ((iotHubRequestMode == IOTHUB_REQUEST_GET) && (statusCode == 404))
-                    {
-                        result = IOTHUB_REGISTRYMANAGER_DEVICE_NOT_EXIST;
-                    }
-                    else
-                    {
-                        LogError("Http Failure status code %d.", statusCode);
-                        result = IOTHUB_REGISTRYMANAGER_HTTP_STATUS_ERROR;
-                    }
-                }
-                else
-                {
-                    result = IOTHUB_REGISTRYMANAGER_OK;
-                }
+                result = getResultFromStatusCode(iotHubRequestMode, statusCode);
             }
         }
     }
@@ -1263,80 +1409,978 @@ static IOTHUB_REGISTRYMANAGER_RESULT sendHttpRequestCRUD(IOTHUB_REGISTRYMANAGER_
     return result;
 }
 
-static void free_registrymanager_handle(IOTHUB_REGISTRYMANAGER *registryManager)
+static IOTHUB_REGISTRYMANAGER_RESULT sendHttpRequestQuery(IOTHUB_REGISTRYMANAGER_HANDLE registryManagerHandle, BUFFER_HANDLE queryBuffer, size_t pageSize, const char* continuationToken, BUFFER_HANDLE responseBuffer, char** nextContinuationToken)
 {
-    free(registryManager->hostname);
-    free(registryManager->iothubName);
-    free(registryManager->iothubSuffix);
-    free(registryManager->sharedAccessKey);
-    free(registryManager->deviceId);
-    free(registryManager);
-}
+    IOTHUB_REGISTRYMANAGER_RESULT result;
 
-IOTHUB_REGISTRYMANAGER_HANDLE IoTHubRegistryManager_Create(IOTHUB_SERVICE_CLIENT_AUTH_HANDLE serviceClientHandle)
-{
-    IOTHUB_REGISTRYMANAGER_HANDLE result;
+    STRING_HANDLE uriResource = NULL;
+    STRING_HANDLE accessKey = NULL;
+    STRING_HANDLE keyName = NULL;
+    HTTPAPIEX_SAS_HANDLE httpExApiSasHandle = NULL;
+    HTTPAPIEX_HANDLE httpExApiHandle = NULL;
+    HTTP_HEADERS_HANDLE httpHeader = NULL;
+    HTTP_HEADERS_HANDLE responseHeader = NULL;
+    char relativePath[256];
+    char pageSizeStr[32];
+    unsigned int statusCode;
 
-    if (serviceClientHandle == NULL)
+    *nextContinuationToken = NULL;
+
+    if (createRelativePath(IOTHUB_REQUEST_QUERY, NULL, NULL, 0, relativePath) != IOTHUB_REGISTRYMANAGER_OK)
     {
-        LogError("serviceClientHandle input parameter cannot be NULL");
-        result = NULL;
+        LogError("Failure creating relative path");
+        result = IOTHUB_REGISTRYMANAGER_ERROR;
     }
-    else
+    else if ((httpHeader = createHttpHeader(IOTHUB_REQUEST_QUERY)) == NULL)
     {
-        IOTHUB_SERVICE_CLIENT_AUTH* serviceClientAuth = (IOTHUB_SERVICE_CLIENT_AUTH*)serviceClientHandle;
-
-        if (serviceClientAuth->hostname == NULL)
+        LogError("HttpHeader creation failed");
+        result = IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR;
+    }
+    else if ((pageSize > 0) &&
+        ((snprintf(pageSizeStr, sizeof(pageSizeStr), "%lu", (unsigned long)pageSize) <= 0) ||
+         (HTTPHeaders_AddHeaderNameValuePair(httpHeader, HTTP_HEADER_KEY_MAX_ITEM_COUNT, pageSizeStr) != HTTP_HEADERS_OK)))
+    {
+        LogError("HTTPHeaders_AddHeaderNameValuePair failed for x-ms-max-item-count header");
+        result = IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR;
+    }
+    else if ((continuationToken != NULL) && (HTTPHeaders_AddHeaderNameValuePair(httpHeader, HTTP_HEADER_KEY_CONTINUATION, continuationToken) != HTTP_HEADERS_OK))
+    {
+        LogError("HTTPHeaders_AddHeaderNameValuePair failed for x-ms-continuation header");
+        result = IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR;
+    }
+    else if ((responseHeader = HTTPHeaders_Alloc()) == NULL)
+    {
+        LogError("HTTPHeaders_Alloc failed for response headers");
+        result = IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR;
+    }
+    else if (getHttpPool(registryManagerHandle) != NULL)
+    {
+        if (service_client_http_pool_execute_request(getHttpPool(registryManagerHandle), HTTPAPI_REQUEST_POST, relativePath, httpHeader, queryBuffer, &statusCode, responseHeader, responseBuffer) != HTTPAPIEX_OK)
         {
-            LogError("authInfo->hostName input parameter cannot be NULL");
-            result = NULL;
+            LogError("service_client_http_pool_execute_request failed. Host:%s", registryManagerHandle->hostname);
+            result = IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR;
         }
-        else if (serviceClientAuth->iothubName == NULL)
+        else
         {
-            LogError("authInfo->iothubName input parameter cannot be NULL");
-            result = NULL;
+            result = getResultFromStatusCode(IOTHUB_REQUEST_QUERY, statusCode);
         }
-        else if (serviceClientAuth->iothubSuffix == NULL)
+    }
+    else if ((uriResource = createUriPath(registryManagerHandle)) == NULL)
+    {
+        LogError("STRING_construct failed for uriResource");
+        result = IOTHUB_REGISTRYMANAGER_ERROR;
+    }
+    else if ((accessKey = STRING_construct(registryManagerHandle->sharedAccessKey)) == NULL)
+    {
+        LogError("STRING_construct failed for accessKey");
+        result = IOTHUB_REGISTRYMANAGER_ERROR;
+    }
+    else if ((registryManagerHandle->keyName != NULL) && ((keyName = STRING_construct(registryManagerHandle->keyName)) == NULL))
+    {
+        LogError("STRING_construct failed for keyName");
+        result = IOTHUB_REGISTRYMANAGER_ERROR;
+    }
+    else if ((httpExApiSasHandle = HTTPAPIEX_SAS_Create(accessKey, uriResource, keyName)) == NULL)
+    {
+        LogError("HTTPAPIEX_SAS_Create failed");
+        result = IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR;
+    }
+    else if ((httpExApiHandle = HTTPAPIEX_Create(registryManagerHandle->hostname)) == NULL)
+    {
+        LogError("HTTPAPIEX_Create failed");
+        result = IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR;
+    }
+    else if (HTTPAPIEX_SAS_ExecuteRequest(httpExApiSasHandle, httpExApiHandle, HTTPAPI_REQUEST_POST, relativePath, httpHeader, queryBuffer, &statusCode, responseHeader, responseBuffer) != HTTPAPIEX_OK)
+    {
+        LogError("HTTPAPIEX_SAS_ExecuteRequest failed. Host:%s", registryManagerHandle->hostname);
+        result = IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR;
+    }
+    else
+    {
+        result = getResultFromStatusCode(IOTHUB_REQUEST_QUERY, statusCode);
+    }
+
+    if (result == IOTHUB_REGISTRYMANAGER_OK)
+    {
+        // No continuation token means this was the last page.
+        const char* nextToken = HTTPHeaders_FindHeaderValue(responseHeader, HTTP_HEADER_KEY_CONTINUATION);
+        if ((nextToken != NULL) && (nextToken[0] != '\0') && (mallocAndStrcpy_s(nextContinuationToken, nextToken) != 0))
         {
-            LogError("authInfo->iothubSuffix input parameter cannot be NULL");
-            result = NULL;
+            LogError("mallocAndStrcpy_s failed for continuation token");
+            result = IOTHUB_REGISTRYMANAGER_ERROR;
         }
-        else if ((serviceClientAuth->keyName == NULL) && (serviceClientAuth->deviceId == NULL))
+    }
+
+    HTTPHeaders_Free(responseHeader);
+    HTTPHeaders_Free(httpHeader);
+    HTTPAPIEX_Destroy(httpExApiHandle);
+    HTTPAPIEX_SAS_Destroy(httpExApiSasHandle);
+    STRING_delete(keyName);
+    STRING_delete(accessKey);
+    STRING_delete(uriResource);
+    return result;
+}
+
+static IOTHUB_REGISTRYMANAGER_RESULT parseTwinQueryJsonObject(JSON_Object* root_object, IOTHUB_DEVICE_OR_MODULE* deviceOrModuleInfo)
+{
+    IOTHUB_REGISTRYMANAGER_RESULT result;
+
+    if ((result = parseDeviceOrModuleJsonObject(root_object, deviceOrModuleInfo)) == IOTHUB_REGISTRYMANAGER_OK)
+    {
+        const char* authType = json_object_get_string(root_object, TWIN_JSON_KEY_AUTH_TYPE);
+        const char* statusUpdateTime = json_object_get_string(root_object, TWIN_JSON_KEY_STATUSUPDATETIME);
+
+        if ((authType != NULL) && (deviceOrModuleInfo->authMethod == IOTHUB_REGISTRYMANAGER_AUTH_UNKNOWN))
         {
-            LogError("authInfo->keyName and authInfo->deviceId input parameter cannot both be NULL");
-            result = NULL;
+            if (0 == strcmp(authType, DEVICE_JSON_KEY_DEVICE_AUTH_SAS))
+            {
+                deviceOrModuleInfo->authMethod = IOTHUB_REGISTRYMANAGER_AUTH_SPK;
+            }
+            else if (0 == strcmp(authType, DEVICE_JSON_KEY_DEVICE_AUTH_SELF_SIGNED))
+            {
+                deviceOrModuleInfo->authMethod = IOTHUB_REGISTRYMANAGER_AUTH_X509_THUMBPRINT;
+            }
+            else if (0 == strcmp(authType, DEVICE_JSON_KEY_DEVICE_AUTH_CERTIFICATE_AUTHORITY))
+            {
+                deviceOrModuleInfo->authMethod = IOTHUB_REGISTRYMANAGER_AUTH_X509_CERTIFICATE_AUTHORITY;
+            }
+            else if (0 == strcmp(authType, DEVICE_JSON_KEY_DEVICE_AUTH_NONE))
+            {
+                deviceOrModuleInfo->authMethod = IOTHUB_REGISTRYMANAGER_AUTH_NONE;
+            }
         }
-        else if (serviceClientAuth->sharedAccessKey == NULL)
+
+        if ((statusUpdateTime != NULL) && (deviceOrModuleInfo->statusUpdatedTime == NULL) && (mallocAndStrcpy_s((char**)&deviceOrModuleInfo->statusUpdatedTime, statusUpdateTime) != 0))
         {
-            LogError("authInfo->sharedAccessKey input parameter cannot be NULL");
-            result = NULL;
+            LogError("mallocAndStrcpy_s failed for statusUpdatedTime");
+            result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
         }
-        else
+    }
+
+    return result;
+}
+
+// Finds the extent of the next element of a page of query results, starting at *offset.  Each element is handed to
+// parson on its own, so only one device is ever parsed at a time however large the page is.  objectLength is set to 0
+// once the page is exhausted.
+static IOTHUB_REGISTRYMANAGER_RESULT findNextQueryPageObject(const char* page, size_t pageLength, size_t* offset, size_t* objectLength)
+{
+    IOTHUB_REGISTRYMANAGER_RESULT result;
+    size_t position = *offset;
+
+    while ((position < pageLength) && (isspace((unsigned char)page[position]) || (page[position] == '[') || (page[position] == ',')))
+    {
+        position++;
+    }
+
+    if ((position >= pageLength) || (page[position] == ']'))
+    {
+        *offset = pageLength;
+        *objectLength = 0;
+        result = IOTHUB_REGISTRYMANAGER_OK;
+    }
+    else if (page[position] != '{')
+    {
+        LogError("Unexpected character in query page at offset %lu", (unsigned long)position);
+        result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+    }
+    else
+    {
+        size_t depth = 0;
+        bool inString = false;
+        bool escaped = false;
+        size_t end;
+
+        for (end = position; end < pageLength; end++)
         {
-            result = malloc(sizeof(IOTHUB_REGISTRYMANAGER));
-            if (result == NULL)
-            {
-                LogError("Malloc failed for IOTHUB_REGISTRYMANAGER");
-            }
-            else
+            char c = page[end];
+            if (inString)
             {
-                memset(result, 0, sizeof(IOTHUB_REGISTRYMANAGER));
-
-                if (mallocAndStrcpy_s(&result->hostname, serviceClientAuth->hostname) != 0)
+                if (escaped)
                 {
-                    LogError("mallocAndStrcpy_s failed for hostName");
-                    free_registrymanager_handle(result);
-                    result = NULL;
+                    escaped = false;
                 }
-                else if (mallocAndStrcpy_s(&result->iothubName, serviceClientAuth->iothubName) != 0)
+                else if (c == '\\')
                 {
-                    LogError("mallocAndStrcpy_s failed for iothubName");
-                    free_registrymanager_handle(result);
-                    result = NULL;
+                    escaped = true;
                 }
-                else if (mallocAndStrcpy_s(&result->iothubSuffix, serviceClientAuth->iothubSuffix) != 0)
+                else if (c == '"')
                 {
-                    LogError("mallocAndStrcpy_s failed for iothubSuffix");
+                    inString = false;
+                }
+            }
+            else if (c == '"')
+            {
+                inString = true;
+            }
+            else if ((c == '{') || (c == '['))
+            {
+                depth++;
+            }
+            else if (((c == '}') || (c == ']')) && (--depth == 0))
+            {
+                break;
+            }
+        }
+
+        if (end == pageLength)
+        {
+            LogError("Truncated object in query page at offset %lu", (unsigned long)position);
+            result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+        }
+        else
+        {
+            *offset = position;
+            *objectLength = end - position + 1;
+            result = IOTHUB_REGISTRYMANAGER_OK;
+        }
+    }
+
+    return result;
+}
+
+static IOTHUB_REGISTRYMANAGER_RESULT parseQueryPageObject(char* json, size_t length, IOTHUB_DEVICE_OR_MODULE* deviceOrModuleInfo)
+{
+    IOTHUB_REGISTRYMANAGER_RESULT result;
+    JSON_Value* root_value;
+    JSON_Object* root_object;
+    // The page always has at least its trailing NUL after the object, so the object can be terminated in place.
+    char terminator = json[length];
+
+    initializeDeviceOrModuleInfoMembers(deviceOrModuleInfo);
+
+    json[length] = '\0';
+    if ((root_value = json_parse_string(json)) == NULL)
+    {
+        LogError("json_parse_string failed");
+        result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+    }
+    else
+    {
+        if ((root_object = json_value_get_object(root_value)) == NULL)
+        {
+            LogError("json_value_get_object failed");
+            result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+        }
+        else if ((result = parseTwinQueryJsonObject(root_object, deviceOrModuleInfo)) != IOTHUB_REGISTRYMANAGER_OK)
+        {
+            free_deviceOrModule_members(deviceOrModuleInfo);
+        }
+
+        json_value_free(root_value);
+    }
+    json[length] = terminator;
+
+    return result;
+}
+
+// Appends a NUL to a response, which the HTTP layer does not guarantee, so it can be read as a string.  length
+// receives the length of the response without it.
+static char* terminateResponseBuffer(BUFFER_HANDLE buffer, size_t* length)
+{
+    char* result;
+
+    *length = BUFFER_length(buffer);
+    if (BUFFER_enlarge(buffer, 1) != 0)
+    {
+        LogError("BUFFER_enlarge failed");
+        result = NULL;
+    }
+    else if ((result = (char*)BUFFER_u_char(buffer)) == NULL)
+    {
+        LogError("BUFFER_u_char failed");
+    }
+    else
+    {
+        result[*length] = '\0';
+    }
+
+    return result;
+}
+
+static void clearQueryPage(REGISTRY_QUERY_PAGE* page)
+{
+    if (page->body != NULL)
+    {
+        BUFFER_delete(page->body);
+    }
+    free(page->continuationToken);
+    memset(page, 0, sizeof(*page));
+}
+
+static void fetchQueryPage(IOTHUB_REGISTRYMANAGER_ITERATOR* iterator, const char* continuationToken, REGISTRY_QUERY_PAGE* page)
+{
+    memset(page, 0, sizeof(*page));
+
+    if ((page->body = BUFFER_new()) == NULL)
+    {
+        LogError("BUFFER_new failed for query page");
+        page->result = IOTHUB_REGISTRYMANAGER_ERROR;
+    }
+    else if ((page->result = sendHttpRequestQuery(iterator->registryManagerHandle, iterator->query, iterator->pageSize, continuationToken, page->body, &page->continuationToken)) != IOTHUB_REGISTRYMANAGER_OK)
+    {
+        LogError("Failure sending HTTP request for registry query");
+    }
+    else if (terminateResponseBuffer(page->body, &page->length) == NULL)
+    {
+        LogError("Failure terminating query page");
+        page->result = IOTHUB_REGISTRYMANAGER_ERROR;
+    }
+
+    if (page->result != IOTHUB_REGISTRYMANAGER_OK)
+    {
+        IOTHUB_REGISTRYMANAGER_RESULT result = page->result;
+        clearQueryPage(page);
+        page->result = result;
+    }
+}
+
+static int prefetchQueryPage(void* context)
+{
+    IOTHUB_REGISTRYMANAGER_ITERATOR* iterator = (IOTHUB_REGISTRYMANAGER_ITERATOR*)context;
+
+    // The caller only reads the current page while this runs, and does not look at the next one until it has joined.
+    fetchQueryPage(iterator, iterator->current.continuationToken, &iterator->next);
+    return 0;
+}
+
+static void startQueryPagePrefetch(IOTHUB_REGISTRYMANAGER_ITERATOR* iterator)
+{
+    if (ThreadAPI_Create(&iterator->prefetchThread, prefetchQueryPage, iterator) != THREADAPI_OK)
+    {
+        LogError("ThreadAPI_Create failed, the next page will be fetched when it is needed");
+        iterator->prefetchThread = NULL;
+    }
+}
+
+static void joinQueryPagePrefetch(IOTHUB_REGISTRYMANAGER_ITERATOR* iterator)
+{
+    if (iterator->prefetchThread != NULL)
+    {
+        int threadResult;
+        if (ThreadAPI_Join(iterator->prefetchThread, &threadResult) != THREADAPI_OK)
+        {
+            LogError("ThreadAPI_Join failed");
+        }
+        iterator->prefetchThread = NULL;
+    }
+}
+
+static IOTHUB_REGISTRYMANAGER_RESULT advanceQueryPage(IOTHUB_REGISTRYMANAGER_ITERATOR* iterator)
+{
+    IOTHUB_REGISTRYMANAGER_RESULT result;
+
+    if (iterator->started && (iterator->current.continuationToken == NULL))
+    {
+        result = IOTHUB_REGISTRYMANAGER_END_OF_LIST;
+    }
+    else
+    {
+        if (iterator->prefetchThread != NULL)
+        {
+            joinQueryPagePrefetch(iterator);
+        }
+        else
+        {
+            fetchQueryPage(iterator, iterator->current.continuationToken, &iterator->next);
+        }
+
+        if ((result = iterator->next.result) != IOTHUB_REGISTRYMANAGER_OK)
+        {
+            // The current page and its continuation token are kept, so calling again retries the same page.
+            clearQueryPage(&iterator->next);
+        }
+        else
+        {
+            clearQueryPage(&iterator->current);
+            iterator->current = iterator->next;
+            memset(&iterator->next, 0, sizeof(iterator->next));
+            iterator->started = true;
+
+            if (iterator->prefetch && (iterator->current.continuationToken != NULL))
+            {
+                startQueryPagePrefetch(iterator);
+            }
+        }
+    }
+
+    return result;
+}
+
+static IOTHUB_REGISTRYMANAGER_RESULT getNextQueryResult(IOTHUB_REGISTRYMANAGER_ITERATOR* iterator, IOTHUB_DEVICE_OR_MODULE* deviceOrModuleInfo)
+{
+    IOTHUB_REGISTRYMANAGER_RESULT result;
+    bool found = false;
+
+    do
+    {
+        char* page = (iterator->current.body == NULL) ? NULL : (char*)BUFFER_u_char(iterator->current.body);
+        size_t objectLength = 0;
+
+        if ((page != NULL) && ((result = findNextQueryPageObject(page, iterator->current.length, &iterator->current.offset, &objectLength)) != IOTHUB_REGISTRYMANAGER_OK))
+        {
+            LogError("Failure reading query page, skipping the rest of it");
+            iterator->current.offset = iterator->current.length;
+        }
+        else if (objectLength == 0)
+        {
+            result = advanceQueryPage(iterator);
+        }
+        else
+        {
+            result = parseQueryPageObject(page + iterator->current.offset, objectLength, deviceOrModuleInfo);
+            // A malformed element is skipped rather than retried forever.
+            iterator->current.offset += objectLength;
+            found = true;
+        }
+    } while ((result == IOTHUB_REGISTRYMANAGER_OK) && !found);
+
+    return result;
+}
+
+static IOTHUB_REGISTRYMANAGER_ITERATOR_HANDLE createIterator(IOTHUB_REGISTRYMANAGER_HANDLE registryManagerHandle, size_t pageSize, bool prefetch, IOTHUB_REGISTRYMANAGER_MODEL_TYPE type, const char* query)
+{
+    IOTHUB_REGISTRYMANAGER_ITERATOR* result;
+
+    if (registryManagerHandle == NULL)
+    {
+        LogError("registryManagerHandle cannot be NULL");
+        result = NULL;
+    }
+    else if (pageSize > IOTHUB_DEVICES_MAX_REQUEST)
+    {
+        LogError("pageSize has to be between 0 and %lu", (unsigned long)IOTHUB_DEVICES_MAX_REQUEST);
+        result = NULL;
+    }
+    else if ((result = (IOTHUB_REGISTRYMANAGER_ITERATOR*)malloc(sizeof(IOTHUB_REGISTRYMANAGER_ITERATOR))) == NULL)
+    {
+        LogError("Malloc failed for IOTHUB_REGISTRYMANAGER_ITERATOR");
+    }
+    else
+    {
+        memset(result, 0, sizeof(*result));
+        result->registryManagerHandle = registryManagerHandle;
+        result->type = type;
+        result->pageSize = pageSize;
+        result->prefetch = prefetch;
+
+        if ((result->query = BUFFER_create((const unsigned char*)query, strlen(query))) == NULL)
+        {
+            LogError("BUFFER_create failed for query");
+            free(result);
+            result = NULL;
+        }
+        else if (prefetch)
+        {
+            startQueryPagePrefetch(result);
+        }
+    }
+
+    return result;
+}
+
+static const char* getImportModeStringForJson(const IOTHUB_REGISTRY_BULK_OPERATION* operation)
+{
+    const char* importModeForJson;
+
+    if (operation->mode == IOTHUB_REGISTRY_BULK_OPERATION_CREATE)
+    {
+        importModeForJson = BULK_JSON_VALUE_CREATE;
+    }
+    else if (operation->mode == IOTHUB_REGISTRY_BULK_OPERATION_UPDATE)
+    {
+        importModeForJson = (operation->eTag != NULL) ? BULK_JSON_VALUE_UPDATE_IF_MATCH_ETAG : BULK_JSON_VALUE_UPDATE;
+    }
+    else
+    {
+        importModeForJson = (operation->eTag != NULL) ? BULK_JSON_VALUE_DELETE_IF_MATCH_ETAG : BULK_JSON_VALUE_DELETE;
+    }
+
+    return importModeForJson;
+}
+
+static IOTHUB_REGISTRYMANAGER_RESULT checkBulkOperation(const IOTHUB_REGISTRY_BULK_OPERATION* operation, size_t index)
+{
+    IOTHUB_REGISTRYMANAGER_RESULT result;
+
+    if ((operation->version < IOTHUB_REGISTRY_BULK_OPERATION_VERSION_1) || (operation->version > IOTHUB_REGISTRY_BULK_OPERATION_VERSION_LATEST))
+    {
+        LogError("operation %lu must have a valid version", (unsigned long)index);
+        result = IOTHUB_REGISTRYMANAGER_INVALID_VERSION;
+    }
+    else if (operation->deviceId == NULL)
+    {
+        LogError("operation %lu has no deviceId", (unsigned long)index);
+        result = IOTHUB_REGISTRYMANAGER_INVALID_ARG;
+    }
+    else if ((operation->mode != IOTHUB_REGISTRY_BULK_OPERATION_CREATE) && (operation->mode != IOTHUB_REGISTRY_BULK_OPERATION_UPDATE) && (operation->mode != IOTHUB_REGISTRY_BULK_OPERATION_DELETE))
+    {
+        LogError("operation %lu has an invalid mode", (unsigned long)index);
+        result = IOTHUB_REGISTRYMANAGER_INVALID_ARG;
+    }
+    else if ((operation->mode != IOTHUB_REGISTRY_BULK_OPERATION_DELETE) && (isAuthTypeAllowed(operation->authMethod) == false))
+    {
+        LogError("operation %lu has an invalid authorization type", (unsigned long)index);
+        result = IOTHUB_REGISTRYMANAGER_INVALID_ARG;
+    }
+    else
+    {
+        result = IOTHUB_REGISTRYMANAGER_OK;
+    }
+
+    return result;
+}
+
+static IOTHUB_REGISTRYMANAGER_RESULT addBulkOperationJson(JSON_Array* operation_array, const IOTHUB_REGISTRY_BULK_OPERATION* operation)
+{
+    IOTHUB_REGISTRYMANAGER_RESULT result;
+    JSON_Value* operation_value;
+    JSON_Object* operation_object = NULL;
+    bool hasIdentity = (operation->mode != IOTHUB_REGISTRY_BULK_OPERATION_DELETE);
+    const char* authTypeForJson = hasIdentity ? getAuthTypeStringForJson(operation->authMethod) : NULL;
+
+    if ((operation_value = json_value_init_object()) == NULL)
+    {
+        LogError("json_value_init_object failed");
+        result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+    }
+    else if ((operation_object = json_value_get_object(operation_value)) == NULL)
+    {
+        LogError("json_value_get_object failed");
+        result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+    }
+    else if (json_object_set_string(operation_object, BULK_JSON_KEY_DEVICE_ID, operation->deviceId) != JSONSuccess)
+    {
+        LogError("json_object_set_string failed for id");
+        result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+    }
+    else if (json_object_set_string(operation_object, BULK_JSON_KEY_IMPORT_MODE, getImportModeStringForJson(operation)) != JSONSuccess)
+    {
+        LogError("json_object_set_string failed for importMode");
+        result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+    }
+    else if ((operation->eTag != NULL) && (json_object_set_string(operation_object, BULK_JSON_KEY_ETAG, operation->eTag) != JSONSuccess))
+    {
+        LogError("json_object_set_string failed for eTag");
+        result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+    }
+    else if (hasIdentity && (json_object_dotset_string(operation_object, DEVICE_JSON_KEY_DEVICE_STATUS, getStatusStringForJson(operation->status)) != JSONSuccess))
+    {
+        LogError("json_object_dotset_string failed for status");
+        result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+    }
+    else if (hasIdentity && ((authTypeForJson == NULL) || (json_object_dotset_string(operation_object, DEVICE_JSON_KEY_DEVICE_AUTH_TYPE, authTypeForJson) != JSONSuccess)))
+    {
+        LogError("json_object_dotset_string failed for authType");
+        result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+    }
+    // Keys left NULL on a create are generated by the service.
+    else if (hasIdentity && (operation->authMethod == IOTHUB_REGISTRYMANAGER_AUTH_SPK) && (operation->primaryKey != NULL) && (json_object_dotset_string(operation_object, DEVICE_JSON_KEY_DEVICE_PRIMARY_KEY, operation->primaryKey) != JSONSuccess))
+    {
+        LogError("json_object_dotset_string failed for primaryKey");
+        result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+    }
+    else if (hasIdentity && (operation->authMethod == IOTHUB_REGISTRYMANAGER_AUTH_SPK) && (operation->secondaryKey != NULL) && (json_object_dotset_string(operation_object, DEVICE_JSON_KEY_DEVICE_SECONDARY_KEY, operation->secondaryKey) != JSONSuccess))
+    {
+        LogError("json_object_dotset_string failed for secondaryKey");
+        result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+    }
+    else if (hasIdentity && (operation->authMethod == IOTHUB_REGISTRYMANAGER_AUTH_X509_THUMBPRINT) && (operation->primaryKey != NULL) && (json_object_dotset_string(operation_object, DEVICE_JSON_KEY_DEVICE_PRIMARY_THUMBPRINT, operation->primaryKey) != JSONSuccess))
+    {
+        LogError("json_object_dotset_string failed for primaryThumbprint");
+        result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+    }
+    else if (hasIdentity && (operation->authMethod == IOTHUB_REGISTRYMANAGER_AUTH_X509_THUMBPRINT) && (operation->secondaryKey != NULL) && (json_object_dotset_string(operation_object, DEVICE_JSON_KEY_DEVICE_SECONDARY_THUMBPRINT, operation->secondaryKey) != JSONSuccess))
+    {
+        LogError("json_object_dotset_string failed for secondaryThumbprint");
+        result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+    }
+    else if (hasIdentity && (json_object_dotset_boolean(operation_object, DEVICE_JSON_KEY_CAPABILITIES_IOTEDGE, operation->iotEdge_capable ? 1 : 0) != JSONSuccess))
+    {
+        LogError("json_object_dotset_boolean failed for iotEdge capability");
+        result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+    }
+    else if (json_array_append_value(operation_array, operation_value) != JSONSuccess)
+    {
+        LogError("json_array_append_value failed");
+        result = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+    }
+    else
+    {
+        // Owned by the array now.
+        operation_value = NULL;
+        result = IOTHUB_REGISTRYMANAGER_OK;
+    }
+
+    if (operation_value != NULL)
+    {
+        json_value_free(operation_value);
+    }
+
+    return result;
+}
+
+static BUFFER_HANDLE constructBulkOperationJson(const IOTHUB_REGISTRY_BULK_OPERATION* operations, size_t operationCount)
+{
+    BUFFER_HANDLE result = NULL;
+    JSON_Value* root_value;
+    JSON_Array* root_array;
+
+    if ((root_value = json_value_init_array()) == NULL)
+    {
+        LogError("json_value_init_array failed");
+    }
+    else
+    {
+        if ((root_array = json_value_get_array(root_value)) == NULL)
+        {
+            LogError("json_value_get_array failed");
+        }
+        else
+        {
+            size_t i;
+            char* serialized_string;
+
+            for (i = 0; i < operationCount; i++)
+            {
+                if (addBulkOperationJson(root_array, &operations[i]) != IOTHUB_REGISTRYMANAGER_OK)
+                {
+                    break;
+                }
+            }
+
+            if (i < operationCount)
+            {
+                LogError("Failure adding operation %lu to the batch", (unsigned long)i);
+            }
+            else if ((serialized_string = json_serialize_to_string(root_value)) == NULL)
+            {
+                LogError("json_serialize_to_string failed");
+            }
+            else
+            {
+                if ((result = BUFFER_create((const unsigned char*)serialized_string, strlen(serialized_string))) == NULL)
+                {
+                    LogError("BUFFER_create failed");
+                }
+                json_free_serialized_string(serialized_string);
+            }
+        }
+
+        json_value_free(root_value);
+    }
+
+    return result;
+}
+
+static IOTHUB_REGISTRYMANAGER_RESULT getResultFromBulkErrorCode(const char* errorCode)
+{
+    IOTHUB_REGISTRYMANAGER_RESULT result;
+
+    if ((errorCode != NULL) && (strcmp(errorCode, BULK_JSON_VALUE_DEVICE_ALREADY_EXISTS) == 0))
+    {
+        result = IOTHUB_REGISTRYMANAGER_DEVICE_EXIST;
+    }
+    else if ((errorCode != NULL) && (strcmp(errorCode, BULK_JSON_VALUE_DEVICE_NOT_FOUND) == 0))
+    {
+        result = IOTHUB_REGISTRYMANAGER_DEVICE_NOT_EXIST;
+    }
+    else
+    {
+        result = IOTHUB_REGISTRYMANAGER_HTTP_STATUS_ERROR;
+    }
+
+    return result;
+}
+
+static IOTHUB_REGISTRYMANAGER_RESULT getResultFromBulkStatusCode(unsigned int statusCode)
+{
+    IOTHUB_REGISTRYMANAGER_RESULT result;
+
+    if (statusCode < 300)
+    {
+        result = IOTHUB_REGISTRYMANAGER_OK;
+    }
+    else if (statusCode == 409)
+    {
+        result = IOTHUB_REGISTRYMANAGER_DEVICE_EXIST;
+    }
+    else if (statusCode == 404)
+    {
+        result = IOTHUB_REGISTRYMANAGER_DEVICE_NOT_EXIST;
+    }
+    else
+    {
+        LogError("Http Failure status code %u.", statusCode);
+        result = IOTHUB_REGISTRYMANAGER_HTTP_STATUS_ERROR;
+    }
+
+    return result;
+}
+
+static int compareBulkOperationDeviceIds(const void* left, const void* right)
+{
+    const IOTHUB_REGISTRY_BULK_OPERATION* leftOperation = *(const IOTHUB_REGISTRY_BULK_OPERATION* const*)left;
+    const IOTHUB_REGISTRY_BULK_OPERATION* rightOperation = *(const IOTHUB_REGISTRY_BULK_OPERATION* const*)right;
+    return strcmp(leftOperation->deviceId, rightOperation->deviceId);
+}
+
+static int compareDeviceIdToBulkOperation(const void* key, const void* element)
+{
+    const IOTHUB_REGISTRY_BULK_OPERATION* operation = *(const IOTHUB_REGISTRY_BULK_OPERATION* const*)element;
+    return strcmp((const char*)key, operation->deviceId);
+}
+
+// Sets the result of every operation on deviceId; byDeviceId holds the operations of the batch sorted by device id.
+static bool setBulkOperationError(const IOTHUB_REGISTRY_BULK_OPERATION* const* byDeviceId, size_t operationCount, const IOTHUB_REGISTRY_BULK_OPERATION* operations, const char* deviceId, IOTHUB_REGISTRYMANAGER_RESULT error, IOTHUB_REGISTRYMANAGER_RESULT* operationResults)
+{
+    const IOTHUB_REGISTRY_BULK_OPERATION* const* found = (const IOTHUB_REGISTRY_BULK_OPERATION* const*)bsearch(deviceId, byDeviceId, operationCount, sizeof(const IOTHUB_REGISTRY_BULK_OPERATION*), compareDeviceIdToBulkOperation);
+
+    if (found != NULL)
+    {
+        const IOTHUB_REGISTRY_BULK_OPERATION* const* end = &byDeviceId[operationCount];
+
+        // The same device may appear more than once in a batch.
+        while ((found > byDeviceId) && (strcmp(found[-1]->deviceId, deviceId) == 0))
+        {
+            found--;
+        }
+        for (; (found < end) && (strcmp((*found)->deviceId, deviceId) == 0); found++)
+        {
+            operationResults[*found - operations] = error;
+        }
+    }
+
+    return (found != NULL);
+}
+
+// The response to a failed batch lists the devices the service rejected.  Those get the result of their error code; with
+// a 400 the service applied the rest of the batch, so the others succeeded, while with any other status they keep the
+// result of the status.  A response without device errors leaves the whole batch with the result of the status.
+static void applyBulkOperationErrors(BUFFER_HANDLE responseBuffer, unsigned int statusCode, const IOTHUB_REGISTRY_BULK_OPERATION* operations, size_t operationCount, IOTHUB_REGISTRYMANAGER_RESULT* operationResults)
+{
+    size_t responseLength;
+    const char* bufferStr;
+    JSON_Value* root_value = NULL;
+    JSON_Object* root_object;
+    JSON_Array* errors_array;
+    size_t errorCount;
+    const IOTHUB_REGISTRY_BULK_OPERATION** byDeviceId = NULL;
+
+    if ((bufferStr = terminateResponseBuffer(responseBuffer, &responseLength)) == NULL)
+    {
+        LogError("Failure terminating bulk response");
+    }
+    else if ((root_value = json_parse_string(bufferStr)) == NULL)
+    {
+        LogError("json_parse_string failed");
+    }
+    else if ((root_object = json_value_get_object(root_value)) == NULL)
+    {
+        LogError("json_value_get_object failed");
+    }
+    else if (((errors_array = json_object_get_array(root_object, BULK_JSON_KEY_ERRORS)) == NULL) || ((errorCount = json_array_get_count(errors_array)) == 0))
+    {
+        LogError("Bulk request failed with status %u without device errors", statusCode);
+    }
+    else if ((byDeviceId = (const IOTHUB_REGISTRY_BULK_OPERATION**)malloc(sizeof(const IOTHUB_REGISTRY_BULK_OPERATION*) * operationCount)) == NULL)
+    {
+        LogError("Malloc failed for the device index, the whole batch is marked as failed");
+    }
+    else
+    {
+        size_t i;
+
+        for (i = 0; i < operationCount; i++)
+        {
+            byDeviceId[i] = &operations[i];
+            if (statusCode == 400)
+            {
+                operationResults[i] = IOTHUB_REGISTRYMANAGER_OK;
+            }
+        }
+
+        qsort((void*)byDeviceId, operationCount, sizeof(const IOTHUB_REGISTRY_BULK_OPERATION*), compareBulkOperationDeviceIds);
+
+        for (i = 0; i < errorCount; i++)
+        {
+            JSON_Object* error_object = json_array_get_object(errors_array, i);
+            const char* deviceId = (error_object == NULL) ? NULL : json_object_get_string(error_object, BULK_JSON_KEY_ERROR_DEVICE_ID);
+            const char* errorCode = (error_object == NULL) ? NULL : json_object_get_string(error_object, BULK_JSON_KEY_ERROR_CODE);
+
+            if (deviceId == NULL)
+            {
+                LogError("Bulk error %lu has no device id", (unsigned long)i);
+            }
+            else if (!setBulkOperationError(byDeviceId, operationCount, operations, deviceId, getResultFromBulkErrorCode(errorCode), operationResults))
+            {
+                LogError("Bulk error for device %s, which is not in the batch", deviceId);
+            }
+            else
+            {
+                LogError("Bulk operation failed for device %s: %s", deviceId, (errorCode == NULL) ? "" : errorCode);
+            }
+        }
+    }
+
+    free((void*)byDeviceId);
+    if (root_value != NULL)
+    {
+        json_value_free(root_value);
+    }
+}
+
+static void sendBulkOperationBatch(void* context, size_t batchIndex)
+{
+    BULK_OPERATION_CONTEXT* bulkOperationContext = (BULK_OPERATION_CONTEXT*)context;
+    size_t first = batchIndex * IOTHUB_DEVICES_MAX_BULK_REQUEST;
+    size_t count = bulkOperationContext->operationCount - first;
+    const IOTHUB_REGISTRY_BULK_OPERATION* operations = &bulkOperationContext->operations[first];
+    IOTHUB_REGISTRYMANAGER_RESULT* operationResults = &bulkOperationContext->operationResults[first];
+    IOTHUB_REGISTRYMANAGER_RESULT batchResult;
+    BUFFER_HANDLE requestBuffer = NULL;
+    BUFFER_HANDLE responseBuffer = NULL;
+    HTTP_HEADERS_HANDLE httpHeader = NULL;
+    char relativePath[256];
+    unsigned int statusCode = 0;
+    size_t i;
+
+    if (count > IOTHUB_DEVICES_MAX_BULK_REQUEST)
+    {
+        count = IOTHUB_DEVICES_MAX_BULK_REQUEST;
+    }
+
+    if ((requestBuffer = constructBulkOperationJson(operations, count)) == NULL)
+    {
+        LogError("Failure constructing bulk request");
+        batchResult = IOTHUB_REGISTRYMANAGER_JSON_ERROR;
+    }
+    else if ((responseBuffer = BUFFER_new()) == NULL)
+    {
+        LogError("BUFFER_new failed for responseBuffer");
+        batchResult = IOTHUB_REGISTRYMANAGER_ERROR;
+    }
+    else if (createRelativePath(IOTHUB_REQUEST_BULK, NULL, NULL, 0, relativePath) != IOTHUB_REGISTRYMANAGER_OK)
+    {
+        LogError("Failure creating relative path");
+        batchResult = IOTHUB_REGISTRYMANAGER_ERROR;
+    }
+    else if ((httpHeader = createHttpHeader(IOTHUB_REQUEST_BULK)) == NULL)
+    {
+        LogError("HttpHeader creation failed");
+        batchResult = IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR;
+    }
+    else if (service_client_http_pool_execute_request(bulkOperationContext->httpPool, HTTPAPI_REQUEST_POST, relativePath, httpHeader, requestBuffer, &statusCode, NULL, responseBuffer) != HTTPAPIEX_OK)
+    {
+        LogError("service_client_http_pool_execute_request failed");
+        batchResult = IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR;
+    }
+    else
+    {
+        batchResult = getResultFromBulkStatusCode(statusCode);
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        operationResults[i] = batchResult;
+    }
+
+    // statusCode is only set once the service answered.
+    if (statusCode >= 300)
+    {
+        applyBulkOperationErrors(responseBuffer, statusCode, operations, count, operationResults);
+    }
+
+    HTTPHeaders_Free(httpHeader);
+    BUFFER_delete(responseBuffer);
+    BUFFER_delete(requestBuffer);
+}
+
+static void free_registrymanager_handle(IOTHUB_REGISTRYMANAGER *registryManager)
+{
+    IOTHUB_REGISTRYMANAGER_INSTANCE* registryManagerInstance = (IOTHUB_REGISTRYMANAGER_INSTANCE*)registryManager;
+
+    free(registryManager->hostname);
+    free(registryManager->iothubName);
+    free(registryManager->iothubSuffix);
+    free(registryManager->sharedAccessKey);
+    free(registryManager->keyName);
+    free(registryManager->deviceId);
+    if (registryManagerInstance->httpPool != NULL)
+    {
+        service_client_http_pool_destroy(registryManagerInstance->httpPool);
+    }
+    free(registryManagerInstance);
+}
+
+IOTHUB_REGISTRYMANAGER_HANDLE IoTHubRegistryManager_Create(IOTHUB_SERVICE_CLIENT_AUTH_HANDLE serviceClientHandle)
+{
+    IOTHUB_REGISTRYMANAGER_HANDLE result;
+
+    if (serviceClientHandle == NULL)
+    {
+        LogError("serviceClientHandle input parameter cannot be NULL");
+        result = NULL;
+    }
+    else
+    {
+        IOTHUB_SERVICE_CLIENT_AUTH* serviceClientAuth = (IOTHUB_SERVICE_CLIENT_AUTH*)serviceClientHandle;
+        IOTHUB_REGISTRYMANAGER_INSTANCE* registryManagerInstance;
+        SERVICE_CLIENT_HTTP_POOL_HANDLE authHttpPool;
+
+        if (serviceClientAuth->hostname == NULL)
+        {
+            LogError("authInfo->hostName input parameter cannot be NULL");
+            result = NULL;
+        }
+        else if (serviceClientAuth->iothubName == NULL)
+        {
+            LogError("authInfo->iothubName input parameter cannot be NULL");
+            result = NULL;
+        }
+        else if (serviceClientAuth->iothubSuffix == NULL)
+        {
+            LogError("authInfo->iothubSuffix input parameter cannot be NULL");
+            result = NULL;
+        }
+        else if ((serviceClientAuth->keyName == NULL) && (serviceClientAuth->deviceId == NULL))
+        {
+            LogError("authInfo->keyName and authInfo->deviceId input parameter cannot both be NULL");
+            result = NULL;
+        }
+        else if (serviceClientAuth->sharedAccessKey == NULL)
+        {
+            LogError("authInfo->sharedAccessKey input parameter cannot be NULL");
+            result = NULL;
+        }
+        else
+        {
+            registryManagerInstance = malloc(sizeof(IOTHUB_REGISTRYMANAGER_INSTANCE));
+            if (registryManagerInstance == NULL)
+            {
+                LogError("Malloc failed for IOTHUB_REGISTRYMANAGER");
+                result = NULL;
+            }
+            else
+            {
+                memset(registryManagerInstance, 0, sizeof(IOTHUB_REGISTRYMANAGER_INSTANCE));
+                result = &registryManagerInstance->registryManager;
+
+                if (mallocAndStrcpy_s(&result->hostname, serviceClientAuth->hostname) != 0)
+                {
+                    LogError("mallocAndStrcpy_s failed for hostName");
+                    free_registrymanager_handle(result);
+                    result = NULL;
+                }
+                else if (mallocAndStrcpy_s(&result->iothubName, serviceClientAuth->iothubName) != 0)
+                {
+                    LogError("mallocAndStrcpy_s failed for iothubName");
+                    free_registrymanager_handle(result);
+                    result = NULL;
+                }
+                else if (mallocAndStrcpy_s(&result->iothubSuffix, serviceClientAuth->iothubSuffix) != 0)
+                {
+                    LogError("mallocAndStrcpy_s failed for iothubSuffix");
                     free_registrymanager_handle(result);
                     result = NULL;
                 }
@@ -1358,6 +2402,12 @@ IOTHUB_REGISTRYMANAGER_HANDLE IoTHubRegistryManager_Create(IOTHUB_SERVICE_CLIENT
                     free_registrymanager_handle(result);
                     result = NULL;
                 }
+                else if (((authHttpPool = service_client_auth_get_http_pool(serviceClientHandle)) != NULL) && ((registryManagerInstance->httpPool = service_client_http_pool_clone(authHttpPool)) == NULL))
+                {
+                    LogError("service_client_http_pool_clone failed");
+                    free_registrymanager_handle(result);
+                    result = NULL;
+                }
             }
         }
     }
@@ -1368,15 +2418,7 @@ void IoTHubRegistryManager_Destroy(IOTHUB_REGISTRYMANAGER_HANDLE registryManager
 {
     if (registryManagerHandle != NULL)
     {
-        IOTHUB_REGISTRYMANAGER* regManHandle = (IOTHUB_REGISTRYMANAGER*)registryManagerHandle;
-
-        free(regManHandle->hostname);
-        free(regManHandle->iothubName);
-        free(regManHandle->iothubSuffix);
-        free(regManHandle->sharedAccessKey);
-        free(regManHandle->keyName);
-        free(regManHandle->deviceId);
-        free(regManHandle);
+        free_registrymanager_handle((IOTHUB_REGISTRYMANAGER*)registryManagerHandle);
     }
 }
 
@@ -2042,3 +3084,154 @@ IOTHUB_REGISTRYMANAGER_RESULT IoTHubRegistryManager_GetModuleList(IOTHUB_REGISTR
     return IoTHubRegistryManager_GetModuleOrDeviceList(registryManagerHandle, deviceId, IOTHUB_DEVICES_MAX_REQUEST, moduleList, IOTHUB_REGISTRYMANAGER_MODEL_TYPE_MODULE, module_version);
 }
 
+IOTHUB_REGISTRYMANAGER_ITERATOR_HANDLE IoTHubRegistryManager_CreateDeviceIterator(IOTHUB_REGISTRYMANAGER_HANDLE registryManagerHandle, size_t pageSize, bool prefetch)
+{
+    return createIterator(registryManagerHandle, pageSize, prefetch, IOTHUB_REGISTRYMANAGER_MODEL_TYPE_DEVICE, QUERY_JSON_ALL_DEVICES);
+}
+
+IOTHUB_REGISTRYMANAGER_ITERATOR_HANDLE IoTHubRegistryManager_CreateModuleIterator(IOTHUB_REGISTRYMANAGER_HANDLE registryManagerHandle, size_t pageSize, bool prefetch)
+{
+    return createIterator(registryManagerHandle, pageSize, prefetch, IOTHUB_REGISTRYMANAGER_MODEL_TYPE_MODULE, QUERY_JSON_ALL_MODULES);
+}
+
+IOTHUB_REGISTRYMANAGER_RESULT IoTHubRegistryManager_GetNextDevice(IOTHUB_REGISTRYMANAGER_ITERATOR_HANDLE iterator, IOTHUB_DEVICE_EX* deviceInfo)
+{
+    IOTHUB_REGISTRYMANAGER_RESULT result;
+
+    if ((iterator == NULL) || (deviceInfo == NULL))
+    {
+        LogError("Input parameter cannot be NULL");
+        result = IOTHUB_REGISTRYMANAGER_INVALID_ARG;
+    }
+    else if (iterator->type != IOTHUB_REGISTRYMANAGER_MODEL_TYPE_DEVICE)
+    {
+        LogError("iterator does not enumerate devices");
+        result = IOTHUB_REGISTRYMANAGER_INVALID_ARG;
+    }
+    else if ((deviceInfo->version < IOTHUB_DEVICE_EX_VERSION_1) || (deviceInfo->version > IOTHUB_DEVICE_EX_VERSION_LATEST))
+    {
+        LogError("deviceInfo must have a valid version");
+        result = IOTHUB_REGISTRYMANAGER_INVALID_VERSION;
+    }
+    else
+    {
+        IOTHUB_DEVICE_OR_MODULE deviceOrModuleInfo;
+
+        if ((result = getNextQueryResult(iterator, &deviceOrModuleInfo)) == IOTHUB_REGISTRYMANAGER_OK)
+        {
+            move_deviceOrModule_members_to_deviceEx(&deviceOrModuleInfo, deviceInfo);
+            free_nonDeviceEx_members_from_deviceOrModule(&deviceOrModuleInfo);
+        }
+    }
+
+    return result;
+}
+
+IOTHUB_REGISTRYMANAGER_RESULT IoTHubRegistryManager_GetNextModule(IOTHUB_REGISTRYMANAGER_ITERATOR_HANDLE iterator, IOTHUB_MODULE* module)
+{
+    IOTHUB_REGISTRYMANAGER_RESULT result;
+
+    if ((iterator == NULL) || (module == NULL))
+    {
+        LogError("Input parameter cannot be NULL");
+        result = IOTHUB_REGISTRYMANAGER_INVALID_ARG;
+    }
+    else if (iterator->type != IOTHUB_REGISTRYMANAGER_MODEL_TYPE_MODULE)
+    {
+        LogError("iterator does not enumerate modules");
+        result = IOTHUB_REGISTRYMANAGER_INVALID_ARG;
+    }
+    else if ((module->version < IOTHUB_MODULE_VERSION_1) || (module->version > IOTHUB_MODULE_VERSION_LATEST))
+    {
+        LogError("module must have a valid version");
+        result = IOTHUB_REGISTRYMANAGER_INVALID_VERSION;
+    }
+    else
+    {
+        IOTHUB_DEVICE_OR_MODULE deviceOrModuleInfo;
+
+        if ((result = getNextQueryResult(iterator, &deviceOrModuleInfo)) == IOTHUB_REGISTRYMANAGER_OK)
+        {
+            move_deviceOrModule_members_to_module(&deviceOrModuleInfo, module);
+        }
+    }
+
+    return result;
+}
+
+void IoTHubRegistryManager_DestroyIterator(IOTHUB_REGISTRYMANAGER_ITERATOR_HANDLE iterator)
+{
+    if (iterator != NULL)
+    {
+        joinQueryPagePrefetch(iterator);
+        clearQueryPage(&iterator->current);
+        clearQueryPage(&iterator->next);
+        BUFFER_delete(iterator->query);
+        free(iterator);
+    }
+}
+
+IOTHUB_REGISTRYMANAGER_RESULT IoTHubRegistryManager_BulkOperation(IOTHUB_REGISTRYMANAGER_HANDLE registryManagerHandle, const IOTHUB_REGISTRY_BULK_OPERATION* operations, size_t operationCount, size_t maxConcurrency, IOTHUB_REGISTRYMANAGER_RESULT* operationResults)
+{
+    IOTHUB_REGISTRYMANAGER_RESULT result;
+    size_t i;
+
+    if ((registryManagerHandle == NULL) || (operations == NULL) || (operationCount == 0) || (maxConcurrency == 0) || (operationResults == NULL))
+    {
+        LogError("Invalid argument (registryManagerHandle=%p, operations=%p, operationCount=%lu, maxConcurrency=%lu, operationResults=%p)",
+            registryManagerHandle, operations, (unsigned long)operationCount, (unsigned long)maxConcurrency, operationResults);
+        result = IOTHUB_REGISTRYMANAGER_INVALID_ARG;
+    }
+    else
+    {
+        result = IOTHUB_REGISTRYMANAGER_OK;
+        for (i = 0; (i < operationCount) && (result == IOTHUB_REGISTRYMANAGER_OK); i++)
+        {
+            result = checkBulkOperation(&operations[i], i);
+        }
+
+        if (result != IOTHUB_REGISTRYMANAGER_OK)
+        {
+            LogError("Invalid bulk operation");
+        }
+        else
+        {
+            BULK_OPERATION_CONTEXT bulkOperationContext;
+
+            (void)memset(&bulkOperationContext, 0, sizeof(BULK_OPERATION_CONTEXT));
+            bulkOperationContext.operations = operations;
+            bulkOperationContext.operationCount = operationCount;
+            bulkOperationContext.operationResults = operationResults;
+
+            // Operations of batches that are not sent keep this result.
+            for (i = 0; i < operationCount; i++)
+            {
+                operationResults[i] = IOTHUB_REGISTRYMANAGER_ERROR;
+            }
+
+            if ((bulkOperationContext.httpPool = (getHttpPool(registryManagerHandle) != NULL) ?
+                service_client_http_pool_clone(getHttpPool(registryManagerHandle)) :
+                service_client_http_pool_create(registryManagerHandle->hostname, registryManagerHandle->sharedAccessKey, registryManagerHandle->keyName, maxConcurrency)) == NULL)
+            {
+                LogError("Failed getting a connection pool");
+                result = IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR;
+            }
+            else
+            {
+                size_t batchCount = (operationCount + IOTHUB_DEVICES_MAX_BULK_REQUEST - 1) / IOTHUB_DEVICES_MAX_BULK_REQUEST;
+
+                (void)service_client_worker_pool_run(batchCount, maxConcurrency, sendBulkOperationBatch, &bulkOperationContext);
+
+                result = IOTHUB_REGISTRYMANAGER_OK;
+                for (i = 0; (i < operationCount) && (result == IOTHUB_REGISTRYMANAGER_OK); i++)
+                {
+                    result = operationResults[i];
+                }
+
+                service_client_http_pool_destroy(bulkOperationContext.httpPool);
+            }
+        }
+    }
+
+    return result;
+}
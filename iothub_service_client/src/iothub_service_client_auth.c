@@ -10,6 +10,7 @@
 #include "azure_c_shared_utility/connection_string_parser.h"
 
 #include "iothub_service_client_auth.h"
+#include "internal/iothub_service_client_http_pool.h"
 
 static const char* IOTHUBHOSTNAME = "HostName";
 static const char* IOTHUBSHAREDACESSKEYNAME = "SharedAccessKeyName";
@@ -18,15 +19,29 @@ static const char* IOTHUBSHAREDACESSSIGNATURE = "SharedAccessSignature";
 static const char* IOTHUBDEVICEID = "DeviceId";
 static const char* IOTHUBSASPREFIX = "sas=";
 
+typedef struct IOTHUB_SERVICE_CLIENT_AUTH_INSTANCE_TAG
+{
+    // Must stay first: IOTHUB_SERVICE_CLIENT_AUTH_HANDLE points to it.
+    IOTHUB_SERVICE_CLIENT_AUTH auth;
+    // Set by IoTHubServiceClientAuth_EnableConnectionPool; NULL otherwise.
+    SERVICE_CLIENT_HTTP_POOL_HANDLE httpPool;
+} IOTHUB_SERVICE_CLIENT_AUTH_INSTANCE;
+
 static void free_service_client_auth(IOTHUB_SERVICE_CLIENT_AUTH* authInfo)
 {
+    IOTHUB_SERVICE_CLIENT_AUTH_INSTANCE* authInstance = (IOTHUB_SERVICE_CLIENT_AUTH_INSTANCE*)authInfo;
+
     free(authInfo->hostname);
     free(authInfo->iothubName);
     free(authInfo->iothubSuffix);
     free(authInfo->sharedAccessKey);
     free(authInfo->keyName);
     free(authInfo->deviceId);
-    free(authInfo);
+    if (authInstance->httpPool != NULL)
+    {
+        service_client_http_pool_destroy(authInstance->httpPool);
+    }
+    free(authInstance);
 }
 
 MU_DEFINE_ENUM_STRINGS_WITHOUT_INVALID(IOTHUB_DEVICE_STATUS, IOTHUB_DEVICE_STATUS_VALUES);
@@ -43,14 +58,16 @@ static IOTHUB_SERVICE_CLIENT_AUTH_HANDLE create_from_connection_string(const cha
     }
     else
     {
-        result = malloc(sizeof(IOTHUB_SERVICE_CLIENT_AUTH));
-        if (result == NULL)
+        IOTHUB_SERVICE_CLIENT_AUTH_INSTANCE* authInstance = malloc(sizeof(IOTHUB_SERVICE_CLIENT_AUTH_INSTANCE));
+        if (authInstance == NULL)
         {
             LogError("Malloc failed for IOTHUB_SERVICE_CLIENT_AUTH");
+            result = NULL;
         }
         else
         {
-            memset(result, 0, sizeof(*result));
+            memset(authInstance, 0, sizeof(*authInstance));
+            result = &authInstance->auth;
 
             STRING_HANDLE connection_string;
             if ((connection_string = STRING_construct(connectionString)) == NULL)
@@ -237,6 +254,60 @@ IOTHUB_SERVICE_CLIENT_AUTH_HANDLE IoTHubServiceClientAuth_CreateFromSharedAccess
     return create_from_connection_string(connectionString, true);
 }
 
+int IoTHubServiceClientAuth_EnableConnectionPool(IOTHUB_SERVICE_CLIENT_AUTH_HANDLE serviceClientHandle, size_t maxConnections)
+{
+    int result;
+    IOTHUB_SERVICE_CLIENT_AUTH_INSTANCE* authInstance = (IOTHUB_SERVICE_CLIENT_AUTH_INSTANCE*)serviceClientHandle;
+
+    if (serviceClientHandle == NULL || maxConnections == 0)
+    {
+        LogError("Invalid argument (serviceClientHandle=%p, maxConnections=%lu)", serviceClientHandle, (unsigned long)maxConnections);
+        result = MU_FAILURE;
+    }
+    else if (authInstance->httpPool != NULL)
+    {
+        LogError("Connection pool already enabled");
+        result = MU_FAILURE;
+    }
+    else if (serviceClientHandle->sharedAccessKey == NULL)
+    {
+        LogError("Connection pool requires a shared access key or signature");
+        result = MU_FAILURE;
+    }
+    else if (serviceClientHandle->deviceId != NULL)
+    {
+        LogError("Connection pool is not supported with device scoped credentials");
+        result = MU_FAILURE;
+    }
+    else if ((authInstance->httpPool = service_client_http_pool_create(serviceClientHandle->hostname, serviceClientHandle->sharedAccessKey, serviceClientHandle->keyName, maxConnections)) == NULL)
+    {
+        LogError("service_client_http_pool_create failed");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+SERVICE_CLIENT_HTTP_POOL_HANDLE service_client_auth_get_http_pool(IOTHUB_SERVICE_CLIENT_AUTH_HANDLE serviceClientHandle)
+{
+    SERVICE_CLIENT_HTTP_POOL_HANDLE result;
+
+    if (serviceClientHandle == NULL)
+    {
+        result = NULL;
+    }
+    else
+    {
+        result = ((IOTHUB_SERVICE_CLIENT_AUTH_INSTANCE*)serviceClientHandle)->httpPool;
+    }
+
+    return result;
+}
+
 void IoTHubServiceClientAuth_Destroy(IOTHUB_SERVICE_CLIENT_AUTH_HANDLE serviceClientHandle)
 {
     if (serviceClientHandle != NULL)
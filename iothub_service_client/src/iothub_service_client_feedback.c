@@ -0,0 +1,949 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/condition.h"
+#include "azure_c_shared_utility/threadapi.h"
+
+#include "internal/iothub_service_client_feedback.h"
+
+static const char* const FEEDBACK_RECORD_KEY_DEVICE_ID = "deviceId";
+static const char* const FEEDBACK_RECORD_KEY_DEVICE_GENERATION_ID = "deviceGenerationId";
+static const char* const FEEDBACK_RECORD_KEY_DESCRIPTION = "description";
+static const char* const FEEDBACK_RECORD_KEY_ENQUED_TIME_UTC = "enqueuedTimeUtc";
+static const char* const FEEDBACK_RECORD_KEY_ORIGINAL_MESSAGE_ID = "originalMessageId";
+
+// Longest member name the parser looks at; longer names are skipped without being copied.
+#define MAX_KEY_LENGTH              32
+// Deepest nesting skipped inside a record; feedback records are flat.
+#define MAX_SKIPPED_DEPTH           16
+#define INITIAL_STRINGS_SIZE        256
+#define NO_STRING                   SIZE_MAX
+
+typedef enum FEEDBACK_FIELD_TAG
+{
+    FEEDBACK_FIELD_DEVICE_ID,
+    FEEDBACK_FIELD_DEVICE_GENERATION_ID,
+    FEEDBACK_FIELD_DESCRIPTION,
+    FEEDBACK_FIELD_ENQUEUED_TIME_UTC,
+    FEEDBACK_FIELD_ORIGINAL_MESSAGE_ID,
+    FEEDBACK_FIELD_COUNT,
+    FEEDBACK_FIELD_NONE = FEEDBACK_FIELD_COUNT
+} FEEDBACK_FIELD;
+
+typedef struct FEEDBACK_PARSER_TAG
+{
+    // Unescaped strings of the record being parsed, NUL-terminated one after the other.
+    char* strings;
+    size_t stringsSize;
+    size_t stringsUsed;
+    // Offset in strings of each field of the record, or NO_STRING.
+    size_t fields[FEEDBACK_FIELD_COUNT];
+} FEEDBACK_PARSER;
+
+typedef struct FEEDBACK_CURSOR_TAG
+{
+    const unsigned char* position;
+    const unsigned char* end;
+} FEEDBACK_CURSOR;
+
+typedef struct PENDING_FEEDBACK_TAG
+{
+    unsigned char* body;
+    size_t length;
+} PENDING_FEEDBACK;
+
+typedef struct FEEDBACK_DISPATCHER_TAG
+{
+    IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK onFeedbackRecord;
+    void* context;
+    // Used for the bodies parsed on the calling thread.
+    FEEDBACK_PARSER_HANDLE parser;
+    LOCK_HANDLE lock;
+    COND_HANDLE pendingChanged;
+    // Ring of the bodies waiting for a worker.
+    PENDING_FEEDBACK* pending;
+    size_t maxPending;
+    size_t pendingHead;
+    size_t pendingCount;
+    THREAD_HANDLE* workers;
+    size_t workerCount;
+    bool isStopping;
+} FEEDBACK_DISPATCHER;
+
+static void skip_whitespace(FEEDBACK_CURSOR* cursor)
+{
+    while (cursor->position < cursor->end &&
+        (*cursor->position == ' ' || *cursor->position == '\t' || *cursor->position == '\r' || *cursor->position == '\n'))
+    {
+        cursor->position++;
+    }
+}
+
+static bool consume(FEEDBACK_CURSOR* cursor, unsigned char expected)
+{
+    bool result;
+
+    skip_whitespace(cursor);
+
+    if (cursor->position < cursor->end && *cursor->position == expected)
+    {
+        cursor->position++;
+        result = true;
+    }
+    else
+    {
+        result = false;
+    }
+
+    return result;
+}
+
+static bool peek(FEEDBACK_CURSOR* cursor, unsigned char expected)
+{
+    skip_whitespace(cursor);
+    return (cursor->position < cursor->end && *cursor->position == expected);
+}
+
+static int get_hex_digit(unsigned char c)
+{
+    int result;
+
+    if (c >= '0' && c <= '9')
+    {
+        result = c - '0';
+    }
+    else if (c >= 'a' && c <= 'f')
+    {
+        result = c - 'a' + 10;
+    }
+    else if (c >= 'A' && c <= 'F')
+    {
+        result = c - 'A' + 10;
+    }
+    else
+    {
+        result = -1;
+    }
+
+    return result;
+}
+
+static int read_code_unit(FEEDBACK_CURSOR* cursor, uint32_t* codeUnit)
+{
+    int result = 0;
+    size_t i;
+
+    *codeUnit = 0;
+
+    if (cursor->end - cursor->position < 4)
+    {
+        result = MU_FAILURE;
+    }
+    else
+    {
+        for (i = 0; i < 4; i++)
+        {
+            int digit = get_hex_digit(cursor->position[i]);
+
+            if (digit < 0)
+            {
+                result = MU_FAILURE;
+                break;
+            }
+
+            *codeUnit = (*codeUnit << 4) | (uint32_t)digit;
+        }
+
+        cursor->position += 4;
+    }
+
+    return result;
+}
+
+static size_t encode_utf8(uint32_t codePoint, char* destination)
+{
+    size_t result;
+
+    if (codePoint < 0x80)
+    {
+        destination[0] = (char)codePoint;
+        result = 1;
+    }
+    else if (codePoint < 0x800)
+    {
+        destination[0] = (char)(0xC0 | (codePoint >> 6));
+        destination[1] = (char)(0x80 | (codePoint & 0x3F));
+        result = 2;
+    }
+    else if (codePoint < 0x10000)
+    {
+        destination[0] = (char)(0xE0 | (codePoint >> 12));
+        destination[1] = (char)(0x80 | ((codePoint >> 6) & 0x3F));
+        destination[2] = (char)(0x80 | (codePoint & 0x3F));
+        result = 3;
+    }
+    else
+    {
+        destination[0] = (char)(0xF0 | (codePoint >> 18));
+        destination[1] = (char)(0x80 | ((codePoint >> 12) & 0x3F));
+        destination[2] = (char)(0x80 | ((codePoint >> 6) & 0x3F));
+        destination[3] = (char)(0x80 | (codePoint & 0x3F));
+        result = 4;
+    }
+
+    return result;
+}
+
+// Reads the string at the cursor, unescaped and NUL-terminated, into destination.  With no destination the string is
+// only measured: length is set to the number of bytes it takes once unescaped, without the terminator.
+static int read_string(FEEDBACK_CURSOR* cursor, char* destination, size_t* length)
+{
+    int result = MU_FAILURE;
+    size_t written = 0;
+
+    if (consume(cursor, '"'))
+    {
+        while (cursor->position < cursor->end)
+        {
+            unsigned char c = *cursor->position++;
+
+            if (c == '"')
+            {
+                result = 0;
+                break;
+            }
+            else if (c < 0x20)
+            {
+                break;
+            }
+            else if (c != '\\')
+            {
+                if (destination != NULL)
+                {
+                    destination[written] = (char)c;
+                }
+                written++;
+            }
+            else if (cursor->position == cursor->end)
+            {
+                break;
+            }
+            else
+            {
+                char decoded[4];
+                size_t decodedLength = 1;
+
+                c = *cursor->position++;
+
+                switch (c)
+                {
+                case '"': case '\\': case '/':
+                    decoded[0] = (char)c;
+                    break;
+                case 'b':
+                    decoded[0] = '\b';
+                    break;
+                case 'f':
+                    decoded[0] = '\f';
+                    break;
+                case 'n':
+                    decoded[0] = '\n';
+                    break;
+                case 'r':
+                    decoded[0] = '\r';
+                    break;
+                case 't':
+                    decoded[0] = '\t';
+                    break;
+                case 'u':
+                {
+                    uint32_t codePoint;
+                    uint32_t lowSurrogate;
+
+                    if (read_code_unit(cursor, &codePoint) != 0)
+                    {
+                        decodedLength = 0;
+                    }
+                    else if (codePoint >= 0xD800 && codePoint <= 0xDBFF &&
+                        cursor->end - cursor->position >= 6 && cursor->position[0] == '\\' && cursor->position[1] == 'u')
+                    {
+                        FEEDBACK_CURSOR lowCursor = { cursor->position + 2, cursor->end };
+
+                        if (read_code_unit(&lowCursor, &lowSurrogate) == 0 && lowSurrogate >= 0xDC00 && lowSurrogate <= 0xDFFF)
+                        {
+                            cursor->position = lowCursor.position;
+                            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (lowSurrogate - 0xDC00);
+                        }
+                        decodedLength = encode_utf8(codePoint, decoded);
+                    }
+                    else
+                    {
+                        decodedLength = encode_utf8(codePoint, decoded);
+                    }
+                    break;
+                }
+                default:
+                    decodedLength = 0;
+                    break;
+                }
+
+                if (decodedLength == 0)
+                {
+                    break;
+                }
+
+                if (destination != NULL)
+                {
+                    (void)memcpy(destination + written, decoded, decodedLength);
+                }
+                written += decodedLength;
+            }
+        }
+    }
+
+    if (result == 0)
+    {
+        if (destination != NULL)
+        {
+            destination[written] = '\0';
+        }
+        *length = written;
+    }
+
+    return result;
+}
+
+static int skip_value(FEEDBACK_CURSOR* cursor)
+{
+    int result = 0;
+    size_t depth = 0;
+
+    do
+    {
+        skip_whitespace(cursor);
+
+        if (cursor->position == cursor->end)
+        {
+            result = MU_FAILURE;
+        }
+        else if (*cursor->position == '"')
+        {
+            size_t ignored;
+            result = read_string(cursor, NULL, &ignored);
+        }
+        else if (*cursor->position == '{' || *cursor->position == '[')
+        {
+            if (++depth > MAX_SKIPPED_DEPTH)
+            {
+                result = MU_FAILURE;
+            }
+            cursor->position++;
+        }
+        else if (*cursor->position == '}' || *cursor->position == ']')
+        {
+            if (depth == 0)
+            {
+                result = MU_FAILURE;
+            }
+            else
+            {
+                depth--;
+                cursor->position++;
+            }
+        }
+        else if (*cursor->position == ',' || *cursor->position == ':')
+        {
+            if (depth == 0)
+            {
+                result = MU_FAILURE;
+            }
+            cursor->position++;
+        }
+        else
+        {
+            // Number, true, false or null; the characters are not checked, only where the literal ends.
+            const unsigned char* start = cursor->position;
+
+            while (cursor->position < cursor->end && strchr(" \t\r\n,:{}[]\"", *cursor->position) == NULL)
+            {
+                cursor->position++;
+            }
+
+            if (cursor->position == start)
+            {
+                result = MU_FAILURE;
+            }
+        }
+    } while (result == 0 && depth > 0);
+
+    return result;
+}
+
+static FEEDBACK_FIELD get_field(const char* key)
+{
+    FEEDBACK_FIELD result;
+
+    if (strcmp(key, FEEDBACK_RECORD_KEY_DEVICE_ID) == 0)
+    {
+        result = FEEDBACK_FIELD_DEVICE_ID;
+    }
+    else if (strcmp(key, FEEDBACK_RECORD_KEY_DEVICE_GENERATION_ID) == 0)
+    {
+        result = FEEDBACK_FIELD_DEVICE_GENERATION_ID;
+    }
+    else if (strcmp(key, FEEDBACK_RECORD_KEY_DESCRIPTION) == 0)
+    {
+        result = FEEDBACK_FIELD_DESCRIPTION;
+    }
+    else if (strcmp(key, FEEDBACK_RECORD_KEY_ENQUED_TIME_UTC) == 0)
+    {
+        result = FEEDBACK_FIELD_ENQUEUED_TIME_UTC;
+    }
+    else if (strcmp(key, FEEDBACK_RECORD_KEY_ORIGINAL_MESSAGE_ID) == 0)
+    {
+        result = FEEDBACK_FIELD_ORIGINAL_MESSAGE_ID;
+    }
+    else
+    {
+        result = FEEDBACK_FIELD_NONE;
+    }
+
+    return result;
+}
+
+static IOTHUB_FEEDBACK_STATUS_CODE get_status_code(char* description)
+{
+    IOTHUB_FEEDBACK_STATUS_CODE result;
+
+    if (description == NULL)
+    {
+        result = IOTHUB_FEEDBACK_STATUS_CODE_UNKNOWN;
+    }
+    else
+    {
+        size_t i;
+
+        // Same lowercasing IoTHubMessaging_LL applies to the records of IOTHUB_SERVICE_FEEDBACK_BATCH.
+        for (i = 0; description[i] != '\0'; i++)
+        {
+            description[i] = (char)tolower((unsigned char)description[i]);
+        }
+
+        if (strcmp(description, "success") == 0)
+        {
+            result = IOTHUB_FEEDBACK_STATUS_CODE_SUCCESS;
+        }
+        else if (strcmp(description, "expired") == 0)
+        {
+            result = IOTHUB_FEEDBACK_STATUS_CODE_EXPIRED;
+        }
+        else if (strcmp(description, "deliverycountexceeded") == 0)
+        {
+            result = IOTHUB_FEEDBACK_STATUS_CODE_DELIVER_COUNT_EXCEEDED;
+        }
+        else if (strcmp(description, "rejected") == 0)
+        {
+            result = IOTHUB_FEEDBACK_STATUS_CODE_REJECTED;
+        }
+        else
+        {
+            result = IOTHUB_FEEDBACK_STATUS_CODE_UNKNOWN;
+        }
+    }
+
+    return result;
+}
+
+// Copies the string value at the cursor into the strings of the record.
+static int read_field(FEEDBACK_PARSER* parser, FEEDBACK_CURSOR* cursor, FEEDBACK_FIELD field)
+{
+    int result;
+    FEEDBACK_CURSOR measureCursor = *cursor;
+    size_t length;
+
+    // Measured first, so the strings never grow past what the largest record needs.
+    if (read_string(&measureCursor, NULL, &length) != 0)
+    {
+        LogError("Malformed string in feedback record");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        size_t needed = parser->stringsUsed + length + 1;
+
+        if (needed > parser->stringsSize)
+        {
+            size_t newSize = parser->stringsSize * 2;
+            char* strings;
+
+            if (newSize < needed)
+            {
+                newSize = needed;
+            }
+
+            if ((strings = (char*)realloc(parser->strings, newSize)) != NULL)
+            {
+                parser->strings = strings;
+                parser->stringsSize = newSize;
+            }
+        }
+
+        if (needed > parser->stringsSize)
+        {
+            LogError("Failed growing the feedback record strings to %lu bytes", (unsigned long)needed);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            (void)read_string(cursor, parser->strings + parser->stringsUsed, &length);
+            parser->fields[field] = parser->stringsUsed;
+            parser->stringsUsed += length + 1;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static const char* get_field_string(FEEDBACK_PARSER* parser, FEEDBACK_FIELD field)
+{
+    return (parser->fields[field] == NO_STRING) ? NULL : parser->strings + parser->fields[field];
+}
+
+static int parse_record(FEEDBACK_PARSER* parser, FEEDBACK_CURSOR* cursor, IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK onFeedbackRecord, void* context)
+{
+    int result = 0;
+    size_t i;
+
+    parser->stringsUsed = 0;
+    for (i = 0; i < FEEDBACK_FIELD_COUNT; i++)
+    {
+        parser->fields[i] = NO_STRING;
+    }
+
+    if (!consume(cursor, '{'))
+    {
+        LogError("Feedback record is not an object");
+        result = MU_FAILURE;
+    }
+    else if (!consume(cursor, '}'))
+    {
+        do
+        {
+            char key[MAX_KEY_LENGTH + 1];
+            FEEDBACK_CURSOR keyCursor = *cursor;
+            size_t keyLength;
+            FEEDBACK_FIELD field = FEEDBACK_FIELD_NONE;
+
+            // Measure the key first, so names longer than any field are never copied.
+            if (read_string(&keyCursor, NULL, &keyLength) != 0)
+            {
+                LogError("Malformed member name in feedback record");
+                result = MU_FAILURE;
+            }
+            else if (keyLength <= MAX_KEY_LENGTH)
+            {
+                (void)read_string(cursor, key, &keyLength);
+                field = get_field(key);
+            }
+            else
+            {
+                *cursor = keyCursor;
+            }
+
+            if (result != 0)
+            {
+                break;
+            }
+            else if (!consume(cursor, ':'))
+            {
+                LogError("Missing ':' in feedback record");
+                result = MU_FAILURE;
+            }
+            else if (field != FEEDBACK_FIELD_NONE && peek(cursor, '"'))
+            {
+                result = read_field(parser, cursor, field);
+            }
+            else
+            {
+                // Unknown members, and fields that are not strings, as json_object_get_string would return NULL for them.
+                result = skip_value(cursor);
+            }
+        } while (result == 0 && consume(cursor, ','));
+
+        if (result == 0 && !consume(cursor, '}'))
+        {
+            LogError("Missing '}' in feedback record");
+            result = MU_FAILURE;
+        }
+    }
+
+    if (result == 0)
+    {
+        IOTHUB_SERVICE_FEEDBACK_RECORD feedbackRecord;
+
+        feedbackRecord.deviceId = (char*)get_field_string(parser, FEEDBACK_FIELD_DEVICE_ID);
+        feedbackRecord.generationId = (char*)get_field_string(parser, FEEDBACK_FIELD_DEVICE_GENERATION_ID);
+        feedbackRecord.description = (char*)get_field_string(parser, FEEDBACK_FIELD_DESCRIPTION);
+        feedbackRecord.enqueuedTimeUtc = (char*)get_field_string(parser, FEEDBACK_FIELD_ENQUEUED_TIME_UTC);
+        feedbackRecord.originalMessageId = (char*)get_field_string(parser, FEEDBACK_FIELD_ORIGINAL_MESSAGE_ID);
+        feedbackRecord.correlationId = "";
+        feedbackRecord.statusCode = get_status_code((char*)feedbackRecord.description);
+
+        onFeedbackRecord(context, &feedbackRecord);
+    }
+
+    return result;
+}
+
+FEEDBACK_PARSER_HANDLE feedback_parser_create(void)
+{
+    FEEDBACK_PARSER* result;
+
+    if ((result = (FEEDBACK_PARSER*)malloc(sizeof(FEEDBACK_PARSER))) == NULL)
+    {
+        LogError("Malloc failed for FEEDBACK_PARSER");
+    }
+    else
+    {
+        (void)memset(result, 0, sizeof(FEEDBACK_PARSER));
+
+        if ((result->strings = (char*)malloc(INITIAL_STRINGS_SIZE)) == NULL)
+        {
+            LogError("Malloc failed for the feedback record strings");
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            result->stringsSize = INITIAL_STRINGS_SIZE;
+        }
+    }
+
+    return result;
+}
+
+void feedback_parser_destroy(FEEDBACK_PARSER_HANDLE parser)
+{
+    if (parser != NULL)
+    {
+        free(parser->strings);
+        free(parser);
+    }
+}
+
+int feedback_parser_parse(FEEDBACK_PARSER_HANDLE parser, const unsigned char* body, size_t length, IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK onFeedbackRecord, void* context)
+{
+    int result;
+
+    if (parser == NULL || body == NULL || onFeedbackRecord == NULL)
+    {
+        LogError("Invalid argument (parser=%p, body=%p, onFeedbackRecord=%p)", parser, body, onFeedbackRecord);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        FEEDBACK_CURSOR cursor;
+        size_t recordCount = 0;
+
+        cursor.position = body;
+        cursor.end = body + length;
+
+        if (!consume(&cursor, '['))
+        {
+            LogError("Feedback body is not an array");
+            result = MU_FAILURE;
+        }
+        else if (consume(&cursor, ']'))
+        {
+            LogError("Feedback body holds no records");
+            result = MU_FAILURE;
+        }
+        else
+        {
+            do
+            {
+                result = parse_record(parser, &cursor, onFeedbackRecord, context);
+                recordCount++;
+            } while (result == 0 && consume(&cursor, ','));
+
+            if (result == 0 && !consume(&cursor, ']'))
+            {
+                LogError("Missing ']' after %lu feedback records", (unsigned long)recordCount);
+                result = MU_FAILURE;
+            }
+        }
+    }
+
+    return result;
+}
+
+static int feedbackWorker(void* param)
+{
+    FEEDBACK_DISPATCHER* dispatcher = (FEEDBACK_DISPATCHER*)param;
+    FEEDBACK_PARSER_HANDLE parser;
+
+    if ((parser = feedback_parser_create()) == NULL)
+    {
+        LogError("Failed creating the parser of a feedback worker");
+    }
+    else
+    {
+        bool isDone = false;
+
+        while (!isDone)
+        {
+            PENDING_FEEDBACK feedback = { NULL, 0 };
+
+            if (Lock(dispatcher->lock) != LOCK_OK)
+            {
+                LogError("Lock failed, stopping a feedback worker");
+                isDone = true;
+            }
+            else
+            {
+                bool isWaitFailed = false;
+
+                while (dispatcher->pendingCount == 0 && !dispatcher->isStopping && !isWaitFailed)
+                {
+                    if (Condition_Wait(dispatcher->pendingChanged, dispatcher->lock, 0) != COND_OK)
+                    {
+                        LogError("Condition_Wait failed, stopping a feedback worker");
+                        isWaitFailed = true;
+                    }
+                }
+
+                if (dispatcher->pendingCount > 0)
+                {
+                    feedback = dispatcher->pending[dispatcher->pendingHead];
+                    dispatcher->pendingHead = (dispatcher->pendingHead + 1) % dispatcher->maxPending;
+                    dispatcher->pendingCount--;
+                }
+                else
+                {
+                    // Stopping, with nothing left to parse.
+                    isDone = true;
+                }
+
+                (void)Unlock(dispatcher->lock);
+            }
+
+            if (feedback.body != NULL)
+            {
+                if (feedback_parser_parse(parser, feedback.body, feedback.length, dispatcher->onFeedbackRecord, dispatcher->context) != 0)
+                {
+                    LogError("Failed parsing a feedback message that was already accepted");
+                }
+
+                free(feedback.body);
+            }
+        }
+
+        feedback_parser_destroy(parser);
+    }
+
+    // Condition_Post wakes a single worker; each one passes the stop on to the next.
+    (void)Condition_Post(dispatcher->pendingChanged);
+
+    return 0;
+}
+
+static void stop_workers(FEEDBACK_DISPATCHER* dispatcher)
+{
+    if (dispatcher->workerCount > 0)
+    {
+        if (Lock(dispatcher->lock) != LOCK_OK)
+        {
+            LogError("Lock failed, stopping the feedback workers anyway");
+            dispatcher->isStopping = true;
+        }
+        else
+        {
+            dispatcher->isStopping = true;
+            (void)Unlock(dispatcher->lock);
+        }
+
+        (void)Condition_Post(dispatcher->pendingChanged);
+
+        while (dispatcher->workerCount > 0)
+        {
+            int threadResult;
+
+            if (ThreadAPI_Join(dispatcher->workers[--dispatcher->workerCount], &threadResult) != THREADAPI_OK)
+            {
+                LogError("ThreadAPI_Join failed");
+            }
+        }
+    }
+}
+
+static void free_dispatcher(FEEDBACK_DISPATCHER* dispatcher)
+{
+    stop_workers(dispatcher);
+
+    // Only left over if every worker failed to start or stopped early.
+    while (dispatcher->pendingCount > 0)
+    {
+        PENDING_FEEDBACK* feedback = &dispatcher->pending[dispatcher->pendingHead];
+
+        if (feedback_parser_parse(dispatcher->parser, feedback->body, feedback->length, dispatcher->onFeedbackRecord, dispatcher->context) != 0)
+        {
+            LogError("Failed parsing a feedback message that was already accepted");
+        }
+
+        free(feedback->body);
+        dispatcher->pendingHead = (dispatcher->pendingHead + 1) % dispatcher->maxPending;
+        dispatcher->pendingCount--;
+    }
+
+    if (dispatcher->pendingChanged != NULL)
+    {
+        Condition_Deinit(dispatcher->pendingChanged);
+    }
+    if (dispatcher->lock != NULL)
+    {
+        (void)Lock_Deinit(dispatcher->lock);
+    }
+
+    feedback_parser_destroy(dispatcher->parser);
+    free(dispatcher->workers);
+    free(dispatcher->pending);
+    free(dispatcher);
+}
+
+FEEDBACK_DISPATCHER_HANDLE feedback_dispatcher_create(size_t workerCount, size_t maxPendingBatches, IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK onFeedbackRecord, void* context)
+{
+    FEEDBACK_DISPATCHER* result;
+
+    if (onFeedbackRecord == NULL || (workerCount > 0 && maxPendingBatches == 0))
+    {
+        LogError("Invalid argument (workerCount=%lu, maxPendingBatches=%lu, onFeedbackRecord=%p)", (unsigned long)workerCount, (unsigned long)maxPendingBatches, onFeedbackRecord);
+        result = NULL;
+    }
+    else if ((result = (FEEDBACK_DISPATCHER*)malloc(sizeof(FEEDBACK_DISPATCHER))) == NULL)
+    {
+        LogError("Malloc failed for FEEDBACK_DISPATCHER");
+    }
+    else
+    {
+        (void)memset(result, 0, sizeof(FEEDBACK_DISPATCHER));
+        result->onFeedbackRecord = onFeedbackRecord;
+        result->context = context;
+        result->maxPending = maxPendingBatches;
+
+        if ((result->parser = feedback_parser_create()) == NULL)
+        {
+            LogError("Failed creating the feedback parser");
+            free_dispatcher(result);
+            result = NULL;
+        }
+        else if (workerCount > 0)
+        {
+            if ((result->pending = (PENDING_FEEDBACK*)malloc(sizeof(PENDING_FEEDBACK) * maxPendingBatches)) == NULL ||
+                (result->workers = (THREAD_HANDLE*)malloc(sizeof(THREAD_HANDLE) * workerCount)) == NULL)
+            {
+                LogError("Malloc failed for the feedback workers");
+                free_dispatcher(result);
+                result = NULL;
+            }
+            else if ((result->lock = Lock_Init()) == NULL)
+            {
+                LogError("Lock_Init failed");
+                free_dispatcher(result);
+                result = NULL;
+            }
+            else if ((result->pendingChanged = Condition_Init()) == NULL)
+            {
+                LogError("Condition_Init failed");
+                free_dispatcher(result);
+                result = NULL;
+            }
+            else
+            {
+                while (result->workerCount < workerCount && ThreadAPI_Create(&result->workers[result->workerCount], feedbackWorker, result) == THREADAPI_OK)
+                {
+                    result->workerCount++;
+                }
+
+                if (result->workerCount < workerCount)
+                {
+                    // Whatever the workers cannot take is parsed by the caller, so fewer workers only cost throughput.
+                    LogError("ThreadAPI_Create failed, parsing feedback with %lu workers instead of %lu", (unsigned long)result->workerCount, (unsigned long)workerCount);
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+void feedback_dispatcher_destroy(FEEDBACK_DISPATCHER_HANDLE dispatcher)
+{
+    if (dispatcher != NULL)
+    {
+        free_dispatcher(dispatcher);
+    }
+}
+
+int feedback_dispatcher_dispatch(FEEDBACK_DISPATCHER_HANDLE dispatcher, const unsigned char* body, size_t length)
+{
+    int result;
+
+    if (dispatcher == NULL || body == NULL)
+    {
+        LogError("Invalid argument (dispatcher=%p, body=%p)", dispatcher, body);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        unsigned char* copy = NULL;
+
+        if (dispatcher->workerCount > 0 && length > 0 && (copy = (unsigned char*)malloc(length)) != NULL)
+        {
+            (void)memcpy(copy, body, length);
+
+            if (Lock(dispatcher->lock) != LOCK_OK)
+            {
+                LogError("Lock failed, parsing the feedback on the calling thread");
+            }
+            else
+            {
+                if (dispatcher->pendingCount < dispatcher->maxPending)
+                {
+                    PENDING_FEEDBACK* feedback = &dispatcher->pending[(dispatcher->pendingHead + dispatcher->pendingCount) % dispatcher->maxPending];
+                    feedback->body = copy;
+                    feedback->length = length;
+                    dispatcher->pendingCount++;
+                    copy = NULL;
+                }
+
+                (void)Unlock(dispatcher->lock);
+            }
+
+            if (copy == NULL)
+            {
+                (void)Condition_Post(dispatcher->pendingChanged);
+                result = 0;
+            }
+            else
+            {
+                free(copy);
+                result = feedback_parser_parse(dispatcher->parser, body, length, dispatcher->onFeedbackRecord, dispatcher->context);
+            }
+        }
+        else
+        {
+            result = feedback_parser_parse(dispatcher->parser, body, length, dispatcher->onFeedbackRecord, dispatcher->context);
+        }
+    }
+
+    return result;
+}
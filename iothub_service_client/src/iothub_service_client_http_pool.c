@@ -0,0 +1,368 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/strings.h"
+#include "azure_c_shared_utility/agenttime.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/condition.h"
+#include "azure_c_shared_utility/sastoken.h"
+#include "azure_c_shared_utility/httpapiex.h"
+#include "azure_c_shared_utility/httpheaders.h"
+
+#include "internal/iothub_service_client_http_pool.h"
+
+#define HTTP_HEADER_KEY_AUTHORIZATION   "Authorization"
+#define SAS_PREFIX                      "sas="
+#define SAS_PREFIX_LENGTH               (sizeof(SAS_PREFIX) - 1)
+
+// Same lifetime HTTPAPIEX_SAS gives its tokens; a new one is generated when less than the margin is left.
+#define SAS_TOKEN_LIFETIME_SECS         3600
+#define SAS_TOKEN_RENEWAL_MARGIN_SECS   300
+
+// Connections idle for longer than this are assumed to have been closed by the hub and are replaced.
+#define CONNECTION_IDLE_TIMEOUT_SECS    60
+
+typedef struct POOLED_CONNECTION_TAG
+{
+    HTTPAPIEX_HANDLE httpApiExHandle;
+    time_t lastUsed;
+} POOLED_CONNECTION;
+
+typedef struct SERVICE_CLIENT_HTTP_POOL_TAG
+{
+    char* hostname;
+    STRING_HANDLE sharedAccessKey;
+    STRING_HANDLE keyName;
+    STRING_HANDLE uriResource;
+    // Set when the pool was given a ready-made token instead of a key.
+    const char* sharedAccessSignature;
+    STRING_HANDLE sasToken;
+    time_t sasTokenExpiry;
+    LOCK_HANDLE lock;
+    COND_HANDLE connectionReleased;
+    // Stack of idle connections, the most recently used on top.
+    POOLED_CONNECTION* idleConnections;
+    size_t idleCount;
+    size_t openCount;
+    size_t maxConnections;
+    size_t refCount;
+} SERVICE_CLIENT_HTTP_POOL;
+
+static void free_pool(SERVICE_CLIENT_HTTP_POOL* pool)
+{
+    size_t i;
+
+    for (i = 0; i < pool->idleCount; i++)
+    {
+        HTTPAPIEX_Destroy(pool->idleConnections[i].httpApiExHandle);
+    }
+
+    if (pool->connectionReleased != NULL)
+    {
+        Condition_Deinit(pool->connectionReleased);
+    }
+    if (pool->lock != NULL)
+    {
+        (void)Lock_Deinit(pool->lock);
+    }
+
+    STRING_delete(pool->sasToken);
+    STRING_delete(pool->uriResource);
+    STRING_delete(pool->keyName);
+    STRING_delete(pool->sharedAccessKey);
+    free(pool->idleConnections);
+    free(pool->hostname);
+    free(pool);
+}
+
+SERVICE_CLIENT_HTTP_POOL_HANDLE service_client_http_pool_create(const char* hostname, const char* sharedAccessKey, const char* keyName, size_t maxConnections)
+{
+    SERVICE_CLIENT_HTTP_POOL* result;
+
+    if (hostname == NULL || sharedAccessKey == NULL || maxConnections == 0 ||
+        (keyName == NULL && strncmp(sharedAccessKey, SAS_PREFIX, SAS_PREFIX_LENGTH) != 0))
+    {
+        LogError("Invalid argument (hostname=%p, sharedAccessKey=%p, keyName=%p, maxConnections=%lu)", hostname, sharedAccessKey, keyName, (unsigned long)maxConnections);
+        result = NULL;
+    }
+    else if ((result = (SERVICE_CLIENT_HTTP_POOL*)malloc(sizeof(SERVICE_CLIENT_HTTP_POOL))) == NULL)
+    {
+        LogError("Malloc failed for SERVICE_CLIENT_HTTP_POOL");
+    }
+    else
+    {
+        (void)memset(result, 0, sizeof(SERVICE_CLIENT_HTTP_POOL));
+        result->maxConnections = maxConnections;
+        result->refCount = 1;
+
+        if (mallocAndStrcpy_s(&result->hostname, hostname) != 0)
+        {
+            LogError("mallocAndStrcpy_s failed for hostname");
+            free_pool(result);
+            result = NULL;
+        }
+        else if ((result->sharedAccessKey = STRING_construct(sharedAccessKey)) == NULL ||
+            (result->keyName = STRING_construct(keyName == NULL ? "" : keyName)) == NULL ||
+            (result->uriResource = STRING_construct(hostname)) == NULL)
+        {
+            LogError("STRING_construct failed");
+            free_pool(result);
+            result = NULL;
+        }
+        else if ((result->idleConnections = (POOLED_CONNECTION*)malloc(sizeof(POOLED_CONNECTION) * maxConnections)) == NULL)
+        {
+            LogError("Malloc failed for the idle connections");
+            free_pool(result);
+            result = NULL;
+        }
+        else if ((result->lock = Lock_Init()) == NULL)
+        {
+            LogError("Lock_Init failed");
+            free_pool(result);
+            result = NULL;
+        }
+        else if ((result->connectionReleased = Condition_Init()) == NULL)
+        {
+            LogError("Condition_Init failed");
+            free_pool(result);
+            result = NULL;
+        }
+        else if (strncmp(sharedAccessKey, SAS_PREFIX, SAS_PREFIX_LENGTH) == 0)
+        {
+            result->sharedAccessSignature = STRING_c_str(result->sharedAccessKey) + SAS_PREFIX_LENGTH;
+        }
+    }
+
+    return result;
+}
+
+SERVICE_CLIENT_HTTP_POOL_HANDLE service_client_http_pool_clone(SERVICE_CLIENT_HTTP_POOL_HANDLE handle)
+{
+    SERVICE_CLIENT_HTTP_POOL_HANDLE result;
+
+    if (handle == NULL)
+    {
+        LogError("Invalid argument (handle=NULL)");
+        result = NULL;
+    }
+    else if (Lock(handle->lock) != LOCK_OK)
+    {
+        LogError("Lock failed");
+        result = NULL;
+    }
+    else
+    {
+        handle->refCount++;
+        (void)Unlock(handle->lock);
+        result = handle;
+    }
+
+    return result;
+}
+
+void service_client_http_pool_destroy(SERVICE_CLIENT_HTTP_POOL_HANDLE handle)
+{
+    if (handle == NULL)
+    {
+        LogError("Invalid argument (handle=NULL)");
+    }
+    else if (Lock(handle->lock) != LOCK_OK)
+    {
+        LogError("Lock failed, the pool is leaked");
+    }
+    else
+    {
+        bool isLastReference = (--handle->refCount == 0);
+        (void)Unlock(handle->lock);
+
+        if (isLastReference)
+        {
+            free_pool(handle);
+        }
+    }
+}
+
+// Must be called with the lock held.
+static int set_authorization_header(SERVICE_CLIENT_HTTP_POOL* pool, HTTP_HEADERS_HANDLE requestHttpHeadersHandle)
+{
+    int result;
+    const char* authorization;
+
+    if (pool->sharedAccessSignature != NULL)
+    {
+        authorization = pool->sharedAccessSignature;
+    }
+    else
+    {
+        time_t now = get_time(NULL);
+
+        if (now == (time_t)-1)
+        {
+            LogError("get_time failed");
+            authorization = NULL;
+        }
+        else if (pool->sasToken == NULL || get_difftime(pool->sasTokenExpiry, now) < SAS_TOKEN_RENEWAL_MARGIN_SECS)
+        {
+            uint64_t expiry = (uint64_t)(get_difftime(now, (time_t)0) + SAS_TOKEN_LIFETIME_SECS);
+            STRING_HANDLE newToken;
+
+            if ((newToken = SASToken_Create(pool->sharedAccessKey, pool->uriResource, pool->keyName, expiry)) == NULL)
+            {
+                LogError("SASToken_Create failed");
+                authorization = NULL;
+            }
+            else
+            {
+                STRING_delete(pool->sasToken);
+                pool->sasToken = newToken;
+                pool->sasTokenExpiry = now + SAS_TOKEN_LIFETIME_SECS;
+                authorization = STRING_c_str(pool->sasToken);
+            }
+        }
+        else
+        {
+            authorization = STRING_c_str(pool->sasToken);
+        }
+    }
+
+    if (authorization == NULL)
+    {
+        result = MU_FAILURE;
+    }
+    else if (HTTPHeaders_ReplaceHeaderNameValuePair(requestHttpHeadersHandle, HTTP_HEADER_KEY_AUTHORIZATION, authorization) != HTTP_HEADERS_OK)
+    {
+        LogError("HTTPHeaders_ReplaceHeaderNameValuePair failed for %s", HTTP_HEADER_KEY_AUTHORIZATION);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+// Must be called with the lock held; waits (releasing the lock) while every connection is busy.
+static HTTPAPIEX_HANDLE acquire_connection(SERVICE_CLIENT_HTTP_POOL* pool)
+{
+    HTTPAPIEX_HANDLE result = NULL;
+    bool failed = false;
+
+    while (result == NULL && !failed)
+    {
+        if (pool->idleCount > 0)
+        {
+            POOLED_CONNECTION* connection = &pool->idleConnections[--pool->idleCount];
+            time_t now = get_time(NULL);
+
+            if (now != (time_t)-1 && get_difftime(now, connection->lastUsed) > CONNECTION_IDLE_TIMEOUT_SECS)
+            {
+                HTTPAPIEX_Destroy(connection->httpApiExHandle);
+                pool->openCount--;
+            }
+            else
+            {
+                result = connection->httpApiExHandle;
+            }
+        }
+        else if (pool->openCount < pool->maxConnections)
+        {
+            if ((result = HTTPAPIEX_Create(pool->hostname)) == NULL)
+            {
+                LogError("HTTPAPIEX_Create failed");
+                failed = true;
+            }
+            else
+            {
+                pool->openCount++;
+            }
+        }
+        else if (Condition_Wait(pool->connectionReleased, pool->lock, 0) != COND_OK)
+        {
+            LogError("Condition_Wait failed");
+            failed = true;
+        }
+    }
+
+    return result;
+}
+
+static void release_connection(SERVICE_CLIENT_HTTP_POOL* pool, HTTPAPIEX_HANDLE connection, bool isReusable)
+{
+    if (Lock(pool->lock) != LOCK_OK)
+    {
+        LogError("Lock failed, closing the connection");
+        HTTPAPIEX_Destroy(connection);
+    }
+    else
+    {
+        if (isReusable)
+        {
+            pool->idleConnections[pool->idleCount].httpApiExHandle = connection;
+            pool->idleConnections[pool->idleCount].lastUsed = get_time(NULL);
+            pool->idleCount++;
+        }
+        else
+        {
+            HTTPAPIEX_Destroy(connection);
+            pool->openCount--;
+        }
+
+        (void)Condition_Post(pool->connectionReleased);
+        (void)Unlock(pool->lock);
+    }
+}
+
+HTTPAPIEX_RESULT service_client_http_pool_execute_request(SERVICE_CLIENT_HTTP_POOL_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath, HTTP_HEADERS_HANDLE requestHttpHeadersHandle, BUFFER_HANDLE requestContent, unsigned int* statusCode, HTTP_HEADERS_HANDLE responseHttpHeadersHandle, BUFFER_HANDLE responseContent)
+{
+    HTTPAPIEX_RESULT result;
+
+    if (handle == NULL || relativePath == NULL || requestHttpHeadersHandle == NULL)
+    {
+        LogError("Invalid argument (handle=%p, relativePath=%p, requestHttpHeadersHandle=%p)", handle, relativePath, requestHttpHeadersHandle);
+        result = HTTPAPIEX_INVALID_ARG;
+    }
+    else if (Lock(handle->lock) != LOCK_OK)
+    {
+        LogError("Lock failed");
+        result = HTTPAPIEX_ERROR;
+    }
+    else
+    {
+        HTTPAPIEX_HANDLE connection;
+
+        if (set_authorization_header(handle, requestHttpHeadersHandle) != 0)
+        {
+            (void)Unlock(handle->lock);
+            result = HTTPAPIEX_ERROR;
+        }
+        else if ((connection = acquire_connection(handle)) == NULL)
+        {
+            (void)Unlock(handle->lock);
+            result = HTTPAPIEX_ERROR;
+        }
+        else
+        {
+            (void)Unlock(handle->lock);
+
+            result = HTTPAPIEX_ExecuteRequest(connection, requestType, relativePath, requestHttpHeadersHandle, requestContent, statusCode, responseHttpHeadersHandle, responseContent);
+
+            if (result != HTTPAPIEX_OK)
+            {
+                LogError("HTTPAPIEX_ExecuteRequest failed (%s)", MU_ENUM_TO_STRING(HTTPAPIEX_RESULT, result));
+            }
+
+            // HTTPAPIEX already reconnects once on failure; a connection that still failed is not kept.
+            release_connection(handle, connection, result == HTTPAPIEX_OK);
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,138 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/threadapi.h"
+
+#include "internal/iothub_service_client_worker_pool.h"
+
+typedef struct WORKER_POOL_RUN_TAG
+{
+    size_t itemCount;
+    SERVICE_CLIENT_WORKER_POOL_ITEM_FUNCTION processItem;
+    void* context;
+    // Guards the fields below.
+    LOCK_HANDLE lock;
+    size_t nextItem;
+} WORKER_POOL_RUN;
+
+static int workerPoolWorker(void* arg)
+{
+    WORKER_POOL_RUN* run = (WORKER_POOL_RUN*)arg;
+    bool done = false;
+
+    while (!done)
+    {
+        size_t index = 0;
+        bool hasItem = false;
+
+        if (Lock(run->lock) != LOCK_OK)
+        {
+            LogError("Lock failed");
+            done = true;
+        }
+        else
+        {
+            if (run->nextItem < run->itemCount)
+            {
+                index = run->nextItem++;
+                hasItem = true;
+            }
+            else
+            {
+                done = true;
+            }
+            (void)Unlock(run->lock);
+        }
+
+        if (hasItem)
+        {
+            run->processItem(run->context, index);
+        }
+    }
+
+    return 0;
+}
+
+int service_client_worker_pool_run(size_t itemCount, size_t maxConcurrency, SERVICE_CLIENT_WORKER_POOL_ITEM_FUNCTION processItem, void* context)
+{
+    int result;
+
+    if ((itemCount == 0) || (maxConcurrency == 0) || (processItem == NULL))
+    {
+        LogError("Invalid argument (itemCount=%lu, maxConcurrency=%lu, processItem=%p)", (unsigned long)itemCount, (unsigned long)maxConcurrency, processItem);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        WORKER_POOL_RUN run;
+
+        (void)memset(&run, 0, sizeof(WORKER_POOL_RUN));
+        run.itemCount = itemCount;
+        run.processItem = processItem;
+        run.context = context;
+
+        if ((run.lock = Lock_Init()) == NULL)
+        {
+            LogError("Lock_Init failed");
+            result = MU_FAILURE;
+        }
+        else
+        {
+            // The calling thread is one of the workers.
+            size_t threadCount = ((maxConcurrency < itemCount) ? maxConcurrency : itemCount) - 1;
+            THREAD_HANDLE* threads = NULL;
+            size_t started = 0;
+
+            if ((threadCount > 0) && ((threads = (THREAD_HANDLE*)malloc(sizeof(THREAD_HANDLE) * threadCount)) == NULL))
+            {
+                LogError("Malloc failed for the worker threads, processing the items sequentially");
+            }
+            else
+            {
+                while ((started < threadCount) && (ThreadAPI_Create(&threads[started], workerPoolWorker, &run) == THREADAPI_OK))
+                {
+                    started++;
+                }
+
+                if (started < threadCount)
+                {
+                    LogError("ThreadAPI_Create failed, processing the items with %lu threads instead of %lu", (unsigned long)(started + 1), (unsigned long)(threadCount + 1));
+                }
+            }
+
+            (void)workerPoolWorker(&run);
+
+            while (started > 0)
+            {
+                int threadResult;
+                if (ThreadAPI_Join(threads[--started], &threadResult) != THREADAPI_OK)
+                {
+                    LogError("ThreadAPI_Join failed");
+                }
+            }
+
+            free(threads);
+
+            // Items are only left when a worker could not take the lock; those are not processed.
+            if (run.nextItem != itemCount)
+            {
+                LogError("Only %lu of %lu items were processed", (unsigned long)run.nextItem, (unsigned long)itemCount);
+                result = MU_FAILURE;
+            }
+            else
+            {
+                result = 0;
+            }
+
+            (void)Lock_Deinit(run.lock);
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,269 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// Measures direct method fan-out through the service client against an in-process stand-in of the hub (see
+// loopback_httpapi.c), so no network or IoT Hub is needed and runs are reproducible.  The service client is the real
+// one; only the HTTPAPI adapter is replaced, and it waits device_latency_ms before answering to stand for the round
+// trip to the device.  Three ways of calling the same method on every device are compared:
+//     invoke          IoTHubDeviceMethod_Invoke in a loop, one connection per call
+//     invoke_many_1   IoTHubDeviceMethod_InvokeMany with a single call in flight, reusing the connection
+//     invoke_many     IoTHubDeviceMethod_InvokeMany with up to max_concurrency calls in flight
+//
+// Output is CSV on stdout, one line per mode:
+//     mode,devices,max_concurrency,device_latency_ms,elapsed_ms,calls_per_sec,avg_latency_ms,p50_latency_ms,p99_latency_ms,failed
+//
+// Usage: devicemethod_perf [devices [max_concurrency [device_latency_ms]]]
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "azure_c_shared_utility/platform.h"
+#include "iothub_service_client_auth.h"
+#include "iothub_devicemethod.h"
+
+// Defined by loopback_httpapi.c.
+extern unsigned int loopback_httpapi_device_latency_ms;
+
+static const size_t DEFAULT_DEVICES = 1000;
+static const size_t DEFAULT_MAX_CONCURRENCY = 32;
+static const unsigned int DEFAULT_DEVICE_LATENCY_MS = 5;
+
+static const char* CONNECTION_STRING = "HostName=loopback.azure-devices.net;SharedAccessKeyName=iothubowner;SharedAccessKey=AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA=";
+static const char* METHOD_NAME = "reboot";
+static const char* METHOD_PAYLOAD = "{\"delay\":0}";
+static const unsigned int METHOD_TIMEOUT = 30;
+
+typedef struct BENCHMARK_RESULT_TAG
+{
+    uint64_t elapsedMs;
+    uint64_t averageLatencyMs;
+    uint64_t p50LatencyMs;
+    uint64_t p99LatencyMs;
+    size_t failed;
+} BENCHMARK_RESULT;
+
+static uint64_t get_time_us(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+    (void)QueryPerformanceCounter(&counter);
+    (void)QueryPerformanceFrequency(&frequency);
+    return (uint64_t)((counter.QuadPart * 1000000.0) / frequency.QuadPart);
+#else
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000) + ((uint64_t)now.tv_nsec / 1000);
+#endif
+}
+
+static int compare_latencies(const void* left, const void* right)
+{
+    uint64_t left_latency = *(const uint64_t*)left;
+    uint64_t right_latency = *(const uint64_t*)right;
+    return (left_latency < right_latency) ? -1 : ((left_latency > right_latency) ? 1 : 0);
+}
+
+static uint64_t get_percentile(const uint64_t* sorted_latencies, size_t count, size_t percentile)
+{
+    // Nearest rank.
+    size_t rank = (count * percentile + 99) / 100;
+    return sorted_latencies[(rank == 0) ? 0 : rank - 1];
+}
+
+static int run_invoke(IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_HANDLE device_method, const char* const* device_ids, size_t devices, BENCHMARK_RESULT* benchmark_result)
+{
+    int result;
+    uint64_t* latencies;
+
+    if ((latencies = (uint64_t*)malloc(sizeof(uint64_t) * devices)) == NULL)
+    {
+        (void)printf("Unable to allocate the latencies\r\n");
+        result = __LINE__;
+    }
+    else
+    {
+        uint64_t start_us = get_time_us();
+        uint64_t total_ms = 0;
+        size_t i;
+
+        benchmark_result->failed = 0;
+
+        for (i = 0; i < devices; i++)
+        {
+            int response_status;
+            unsigned char* response_payload = NULL;
+            size_t response_payload_size;
+            uint64_t call_start_us = get_time_us();
+
+            if (IoTHubDeviceMethod_Invoke(device_method, device_ids[i], METHOD_NAME, METHOD_PAYLOAD, METHOD_TIMEOUT, &response_status, &response_payload, &response_payload_size) != IOTHUB_DEVICE_METHOD_OK)
+            {
+                benchmark_result->failed++;
+            }
+
+            latencies[i] = (get_time_us() - call_start_us) / 1000;
+            total_ms += latencies[i];
+            free(response_payload);
+        }
+
+        benchmark_result->elapsedMs = (get_time_us() - start_us) / 1000;
+        benchmark_result->averageLatencyMs = total_ms / devices;
+
+        qsort(latencies, devices, sizeof(uint64_t), compare_latencies);
+        benchmark_result->p50LatencyMs = get_percentile(latencies, devices, 50);
+        benchmark_result->p99LatencyMs = get_percentile(latencies, devices, 99);
+
+        free(latencies);
+        result = 0;
+    }
+
+    return result;
+}
+
+static int run_invoke_many(IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_HANDLE device_method, const char* const* device_ids, size_t devices, size_t max_concurrency, BENCHMARK_RESULT* benchmark_result)
+{
+    int result;
+    IOTHUB_DEVICE_METHOD_INVOKE_MANY_STATISTICS statistics;
+
+    if (IoTHubDeviceMethod_InvokeMany(device_method, device_ids, devices, METHOD_NAME, METHOD_PAYLOAD, METHOD_TIMEOUT, max_concurrency, NULL, NULL, &statistics) != IOTHUB_DEVICE_METHOD_OK)
+    {
+        (void)printf("IoTHubDeviceMethod_InvokeMany failed\r\n");
+        result = __LINE__;
+    }
+    else
+    {
+        benchmark_result->elapsedMs = statistics.elapsedMs;
+        benchmark_result->averageLatencyMs = statistics.averageLatencyMs;
+        benchmark_result->p50LatencyMs = statistics.p50LatencyMs;
+        benchmark_result->p99LatencyMs = statistics.p99LatencyMs;
+        benchmark_result->failed = statistics.failed;
+        result = 0;
+    }
+
+    return result;
+}
+
+static void print_result(const char* mode, size_t devices, size_t max_concurrency, const BENCHMARK_RESULT* benchmark_result)
+{
+    (void)printf("%s,%lu,%lu,%u,%lu,%.1f,%lu,%lu,%lu,%lu\r\n",
+        mode,
+        (unsigned long)devices,
+        (unsigned long)max_concurrency,
+        loopback_httpapi_device_latency_ms,
+        (unsigned long)benchmark_result->elapsedMs,
+        (benchmark_result->elapsedMs > 0) ? (devices * 1000.0) / benchmark_result->elapsedMs : 0.0,
+        (unsigned long)benchmark_result->averageLatencyMs,
+        (unsigned long)benchmark_result->p50LatencyMs,
+        (unsigned long)benchmark_result->p99LatencyMs,
+        (unsigned long)benchmark_result->failed);
+}
+
+static int run_benchmarks(const char* const* device_ids, size_t devices, size_t max_concurrency)
+{
+    int result;
+    IOTHUB_SERVICE_CLIENT_AUTH_HANDLE service_client;
+
+    if ((service_client = IoTHubServiceClientAuth_CreateFromConnectionString(CONNECTION_STRING)) == NULL)
+    {
+        (void)printf("Unable to create the service client\r\n");
+        result = __LINE__;
+    }
+    else
+    {
+        IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_HANDLE device_method;
+
+        if ((device_method = IoTHubDeviceMethod_Create(service_client)) == NULL)
+        {
+            (void)printf("Unable to create the device method client\r\n");
+            result = __LINE__;
+        }
+        else
+        {
+            BENCHMARK_RESULT benchmark_result;
+
+            (void)printf("mode,devices,max_concurrency,device_latency_ms,elapsed_ms,calls_per_sec,avg_latency_ms,p50_latency_ms,p99_latency_ms,failed\r\n");
+
+            if ((result = run_invoke(device_method, device_ids, devices, &benchmark_result)) == 0)
+            {
+                print_result("invoke", devices, 1, &benchmark_result);
+            }
+
+            if (result == 0 && (result = run_invoke_many(device_method, device_ids, devices, 1, &benchmark_result)) == 0)
+            {
+                print_result("invoke_many_1", devices, 1, &benchmark_result);
+            }
+
+            if (result == 0 && (result = run_invoke_many(device_method, device_ids, devices, max_concurrency, &benchmark_result)) == 0)
+            {
+                print_result("invoke_many", devices, max_concurrency, &benchmark_result);
+            }
+
+            IoTHubDeviceMethod_Destroy(device_method);
+        }
+
+        IoTHubServiceClientAuth_Destroy(service_client);
+    }
+
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    int result;
+    long devices = (argc > 1) ? atol(argv[1]) : (long)DEFAULT_DEVICES;
+    long max_concurrency = (argc > 2) ? atol(argv[2]) : (long)DEFAULT_MAX_CONCURRENCY;
+    long device_latency_ms = (argc > 3) ? atol(argv[3]) : (long)DEFAULT_DEVICE_LATENCY_MS;
+
+    if (devices <= 0 || max_concurrency <= 0 || device_latency_ms < 0)
+    {
+        (void)printf("usage: devicemethod_perf [devices [max_concurrency [device_latency_ms]]]\r\n");
+        result = EXIT_FAILURE;
+    }
+    else if (platform_init() != 0)
+    {
+        (void)printf("platform_init failed\r\n");
+        result = EXIT_FAILURE;
+    }
+    else
+    {
+        char* names;
+        const char** device_ids;
+
+        loopback_httpapi_device_latency_ms = (unsigned int)device_latency_ms;
+
+        if ((names = (char*)malloc((size_t)devices * 16)) == NULL || (device_ids = (const char**)malloc(sizeof(const char*) * (size_t)devices)) == NULL)
+        {
+            (void)printf("Unable to allocate %ld device ids\r\n", devices);
+            free(names);
+            result = EXIT_FAILURE;
+        }
+        else
+        {
+            long i;
+
+            for (i = 0; i < devices; i++)
+            {
+                (void)sprintf(&names[i * 16], "device%ld", i);
+                device_ids[i] = &names[i * 16];
+            }
+
+            result = (run_benchmarks(device_ids, (size_t)devices, (size_t)max_concurrency) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+            free((void*)device_ids);
+            free(names);
+        }
+
+        platform_deinit();
+    }
+
+    return result;
+}
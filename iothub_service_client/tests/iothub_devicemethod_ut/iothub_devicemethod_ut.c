@@ -60,7 +60,10 @@ static int my_mallocAndStrcpy_s(char** destination, const char* source)
 #include "azure_c_shared_utility/httpheaders.h"
 #include "azure_c_shared_utility/httpapiex.h"
 #include "azure_c_shared_utility/httpapiexsas.h"
+#include "internal/iothub_service_client_http_pool.h"
+#include "internal/iothub_service_client_worker_pool.h"
 #include "azure_c_shared_utility/uniqueid.h"
+#include "azure_c_shared_utility/lock.h"
 #include "parson.h"
 
 MOCKABLE_FUNCTION(, JSON_Value*, json_parse_string, const char *, string);
@@ -193,6 +196,68 @@ void my_json_value_free(JSON_Value *value)
     my_gballoc_free(value);
 }
 
+HTTPAPIEX_RESULT my_service_client_http_pool_execute_request(SERVICE_CLIENT_HTTP_POOL_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath, HTTP_HEADERS_HANDLE requestHttpHeadersHandle, BUFFER_HANDLE requestContent, unsigned int* statusCode, HTTP_HEADERS_HANDLE responseHttpHeadersHandle, BUFFER_HANDLE responseContent)
+{
+    (void)handle;
+    (void)requestType;
+    (void)relativePath;
+    (void)requestHttpHeadersHandle;
+    (void)requestContent;
+    (void)responseHttpHeadersHandle;
+    (void)responseContent;
+    *statusCode = 200;
+    return HTTPAPIEX_OK;
+}
+
+static size_t g_invoke_many_callback_count;
+static size_t g_invoke_many_callback_succeeded;
+static size_t g_invoke_many_callback_under_lock;
+static int g_lock_depth;
+
+static LOCK_RESULT my_Lock(LOCK_HANDLE handle)
+{
+    (void)handle;
+    g_lock_depth++;
+    return LOCK_OK;
+}
+
+static LOCK_RESULT my_Unlock(LOCK_HANDLE handle)
+{
+    (void)handle;
+    g_lock_depth--;
+    return LOCK_OK;
+}
+
+// Processes the devices in order on the calling thread.
+static int my_service_client_worker_pool_run(size_t itemCount, size_t maxConcurrency, SERVICE_CLIENT_WORKER_POOL_ITEM_FUNCTION processItem, void* context)
+{
+    size_t i;
+    (void)maxConcurrency;
+    for (i = 0; i < itemCount; i++)
+    {
+        processItem(context, i);
+    }
+    return 0;
+}
+
+static void test_invoke_many_callback(const char* deviceId, IOTHUB_DEVICE_METHOD_RESULT result, int responseStatus, const unsigned char* responsePayload, size_t responsePayloadSize, void* context)
+{
+    (void)deviceId;
+    (void)responseStatus;
+    (void)responsePayload;
+    (void)responsePayloadSize;
+    (void)context;
+    g_invoke_many_callback_count++;
+    if (g_lock_depth != 0)
+    {
+        g_invoke_many_callback_under_lock++;
+    }
+    if (result == IOTHUB_DEVICE_METHOD_OK)
+    {
+        g_invoke_many_callback_succeeded++;
+    }
+}
+
 
 #include "iothub_devicemethod.h"
 #include "iothub_service_client_auth.h"
@@ -202,6 +267,7 @@ typedef struct IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_TAG
     char* hostname;
     char* sharedAccessKey;
     char* keyName;
+    SERVICE_CLIENT_HTTP_POOL_HANDLE httpPool;
 } IOTHUB_SERVICE_CLIENT_DEVICE_METHOD;
 
 static IOTHUB_SERVICE_CLIENT_AUTH TEST_IOTHUB_SERVICE_CLIENT_AUTH;
@@ -220,6 +286,12 @@ static char* TEST_SHAREDACCESSKEY = "theSharedAccessKey";
 static char* TEST_SHAREDACCESSKEYNAME = "theSharedAccessKeyName";
 
 static const HTTP_HEADERS_HANDLE TEST_HTTP_HEADERS_HANDLE = (HTTP_HEADERS_HANDLE)0x4545;
+static SERVICE_CLIENT_HTTP_POOL_HANDLE TEST_HTTP_POOL_HANDLE = (SERVICE_CLIENT_HTTP_POOL_HANDLE)0x4646;
+static LOCK_HANDLE TEST_LOCK_HANDLE = (LOCK_HANDLE)0x4747;
+static TICK_COUNTER_HANDLE TEST_TICK_COUNTER_HANDLE = (TICK_COUNTER_HANDLE)0x4848;
+
+static const char* TEST_DEVICE_IDS[] = { "TEST_DEVICE_ID_1", "TEST_DEVICE_ID_2", "TEST_DEVICE_ID_3" };
+static const size_t TEST_DEVICE_COUNT = sizeof(TEST_DEVICE_IDS) / sizeof(TEST_DEVICE_IDS[0]);
 
 static const unsigned int httpStatusCodeOk = 200;
 static const unsigned int httpStatusCodeBadRequest = 400;
@@ -292,7 +364,13 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_UMOCK_ALIAS_TYPE(HTTP_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(HTTPAPIEX_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(HTTPAPIEX_SAS_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(SERVICE_CLIENT_HTTP_POOL_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_SERVICE_CLIENT_AUTH_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(JSON_Value_Type, int);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(SERVICE_CLIENT_WORKER_POOL_ITEM_FUNCTION, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
 
     REGISTER_GLOBAL_MOCK_RETURN(UniqueId_Generate, UNIQUEID_OK);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(UniqueId_Generate, UNIQUEID_ERROR);
@@ -369,6 +447,26 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
 
     REGISTER_GLOBAL_MOCK_HOOK(json_serialize_to_string, my_json_serialize_to_string);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(json_serialize_to_string, NULL);
+
+    REGISTER_GLOBAL_MOCK_RETURN(service_client_auth_get_http_pool, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(service_client_http_pool_create, TEST_HTTP_POOL_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(service_client_http_pool_create, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(service_client_http_pool_execute_request, my_service_client_http_pool_execute_request);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(service_client_http_pool_execute_request, HTTPAPIEX_ERROR);
+
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock_Init, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(Lock, my_Lock);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock, LOCK_ERROR);
+    REGISTER_GLOBAL_MOCK_HOOK(Unlock, my_Unlock);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Deinit, LOCK_OK);
+
+    REGISTER_GLOBAL_MOCK_HOOK(service_client_worker_pool_run, my_service_client_worker_pool_run);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(service_client_worker_pool_run, MU_FAILURE);
+
+    REGISTER_GLOBAL_MOCK_RETURN(tickcounter_create, TEST_TICK_COUNTER_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(tickcounter_create, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(tickcounter_get_current_ms, 0);
 }
 
 TEST_SUITE_CLEANUP(TestClassCleanup)
@@ -391,7 +489,15 @@ TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
     TEST_IOTHUB_SERVICE_CLIENT_AUTH.iothubSuffix = TEST_IOTHUBSUFFIX;
     TEST_IOTHUB_SERVICE_CLIENT_AUTH.keyName = TEST_SHAREDACCESSKEYNAME;
     TEST_IOTHUB_SERVICE_CLIENT_AUTH.sharedAccessKey = TEST_SHAREDACCESSKEY;
+    TEST_IOTHUB_SERVICE_CLIENT_DEVICE_METHOD.hostname = TEST_HOSTNAME;
+    TEST_IOTHUB_SERVICE_CLIENT_DEVICE_METHOD.sharedAccessKey = TEST_SHAREDACCESSKEY;
+    TEST_IOTHUB_SERVICE_CLIENT_DEVICE_METHOD.keyName = TEST_SHAREDACCESSKEYNAME;
+    TEST_IOTHUB_SERVICE_CLIENT_DEVICE_METHOD.httpPool = NULL;
 
+    g_invoke_many_callback_count = 0;
+    g_invoke_many_callback_succeeded = 0;
+    g_invoke_many_callback_under_lock = 0;
+    g_lock_depth = 0;
 }
 
 TEST_FUNCTION_CLEANUP(TestMethodCleanup)
@@ -492,6 +598,8 @@ TEST_FUNCTION(IoTHubDeviceMethod_Create_happy_path)
     EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreAllArguments();
 
+    STRICT_EXPECTED_CALL(service_client_auth_get_http_pool(TEST_IOTHUB_SERVICE_CLIENT_AUTH_HANDLE));
+
     // act
     IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_HANDLE result = IoTHubDeviceMethod_Create(TEST_IOTHUB_SERVICE_CLIENT_AUTH_HANDLE);
 
@@ -550,6 +658,65 @@ TEST_FUNCTION(IoTHubDeviceMethod_Create_non_happy_path)
 
 }
 
+TEST_FUNCTION(IoTHubDeviceMethod_Create_shares_the_connection_pool_of_serviceClientHandle)
+{
+    // arrange
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+    EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+    EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+    STRICT_EXPECTED_CALL(service_client_auth_get_http_pool(TEST_IOTHUB_SERVICE_CLIENT_AUTH_HANDLE))
+        .SetReturn(TEST_HTTP_POOL_HANDLE);
+    STRICT_EXPECTED_CALL(service_client_http_pool_clone(TEST_HTTP_POOL_HANDLE))
+        .SetReturn(TEST_HTTP_POOL_HANDLE);
+
+    // act
+    IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_HANDLE result = IoTHubDeviceMethod_Create(TEST_IOTHUB_SERVICE_CLIENT_AUTH_HANDLE);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_HTTP_POOL_HANDLE, result->httpPool);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(service_client_http_pool_destroy(TEST_HTTP_POOL_HANDLE));
+    IoTHubDeviceMethod_Destroy(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(IoTHubDeviceMethod_Create_return_null_if_connection_pool_clone_fails)
+{
+    // arrange
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+    EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+    EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+    STRICT_EXPECTED_CALL(service_client_auth_get_http_pool(TEST_IOTHUB_SERVICE_CLIENT_AUTH_HANDLE))
+        .SetReturn(TEST_HTTP_POOL_HANDLE);
+    STRICT_EXPECTED_CALL(service_client_http_pool_clone(TEST_HTTP_POOL_HANDLE))
+        .SetReturn(NULL);
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_HANDLE result = IoTHubDeviceMethod_Create(TEST_IOTHUB_SERVICE_CLIENT_AUTH_HANDLE);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
 TEST_FUNCTION(IoTHubDeviceMethod_Destroy_return_if_input_parameter_serviceClientdevicemethodHandle_is_NULL)
 {
     // arrange
@@ -940,6 +1107,95 @@ TEST_FUNCTION(IoTHubDeviceMethod_Invoke_happy_path)
     IoTHubDeviceMethod_InvokeDeviceOrModule_happy_path_impl(false);
 }
 
+TEST_FUNCTION(IoTHubDeviceMethod_Invoke_uses_the_connection_pool_when_enabled)
+{
+    // arrange
+    TEST_IOTHUB_SERVICE_CLIENT_DEVICE_METHOD.httpPool = TEST_HTTP_POOL_HANDLE;
+
+    EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+    EXPECTED_CALL(BUFFER_create(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+        .IgnoreAllArguments();
+    EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    EXPECTED_CALL(BUFFER_new());
+
+    EXPECTED_CALL(HTTPHeaders_Alloc());
+    EXPECTED_CALL(HTTPHeaders_AddHeaderNameValuePair(IGNORED_PTR_ARG, TEST_HTTP_HEADER_KEY_AUTHORIZATION, TEST_HTTP_HEADER_VAL_AUTHORIZATION))
+        .IgnoreArgument(1);
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    EXPECTED_CALL(UniqueId_Generate(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    EXPECTED_CALL(HTTPHeaders_AddHeaderNameValuePair(IGNORED_PTR_ARG, TEST_HTTP_HEADER_KEY_REQUEST_ID, TEST_HTTP_HEADER_VAL_REQUEST_ID))
+        .IgnoreArgument(1);
+    EXPECTED_CALL(HTTPHeaders_AddHeaderNameValuePair(IGNORED_PTR_ARG, TEST_HTTP_HEADER_KEY_USER_AGENT, IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    EXPECTED_CALL(HTTPHeaders_AddHeaderNameValuePair(IGNORED_PTR_ARG, TEST_HTTP_HEADER_KEY_ACCEPT, TEST_HTTP_HEADER_VAL_ACCEPT))
+        .IgnoreArgument(1);
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(service_client_http_pool_execute_request(TEST_HTTP_POOL_HANDLE, HTTPAPI_REQUEST_POST, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_relativePath()
+        .IgnoreArgument_requestHttpHeadersHandle()
+        .IgnoreArgument_requestContent()
+        .IgnoreArgument_statusCode()
+        .IgnoreArgument_responseHttpHeadersHandle()
+        .IgnoreArgument_responseContent()
+        .CopyOutArgumentBuffer_statusCode(&httpStatusCodeOk, sizeof(httpStatusCodeOk))
+        .SetReturn(HTTPAPIEX_OK);
+    EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    EXPECTED_CALL(HTTPHeaders_Free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .SetReturn(TEST_UNSIGNED_CHAR_PTR);
+    EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    EXPECTED_CALL(STRING_from_byte_array(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+        .IgnoreAllArguments();
+    EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    EXPECTED_CALL(json_parse_string(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    EXPECTED_CALL(json_value_get_object(TEST_JSON_VALUE));
+    EXPECTED_CALL(json_object_get_value(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+    EXPECTED_CALL(json_object_get_value(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+
+    EXPECTED_CALL(json_serialize_to_string(IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+    EXPECTED_CALL(json_value_get_number(IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+
+    EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    EXPECTED_CALL(json_value_free(IGNORED_PTR_ARG))
+        .IgnoreAllArguments();
+
+    EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    // act
+    int responseStatus;
+    unsigned char* responsePayload;
+    size_t responsePayloadSize;
+
+    IOTHUB_DEVICE_METHOD_RESULT result = IoTHubDeviceMethod_Invoke(TEST_IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_HANDLE, TEST_DEVICE_ID, TEST_METHOD_NAME, TEST_METHOD_PAYLOAD, TEST_TIMEOUT, &responseStatus, &responsePayload, &responsePayloadSize);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, result, IOTHUB_DEVICE_METHOD_OK);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    free((void*)responsePayload);
+}
+
 TEST_FUNCTION(IoTHubDeviceMethod_InvokeModule_happy_path)
 {
     IoTHubDeviceMethod_InvokeDeviceOrModule_happy_path_impl(true);
@@ -1207,4 +1463,260 @@ TEST_FUNCTION(IoTHubDeviceMethod_InvokeModule_non_happy_path)
     IoTHubDeviceMethod_Invoke_non_happy_path_impl(true);
 }
 
+TEST_FUNCTION(IoTHubDeviceMethod_InvokeMany_return_INVALID_ARG_if_input_parameter_serviceClientDeviceMethodHandle_is_NULL)
+{
+    // act
+    IOTHUB_DEVICE_METHOD_RESULT result = IoTHubDeviceMethod_InvokeMany(NULL, TEST_DEVICE_IDS, TEST_DEVICE_COUNT, TEST_METHOD_NAME, TEST_METHOD_PAYLOAD, TEST_TIMEOUT, 2, test_invoke_many_callback, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, IOTHUB_DEVICE_METHOD_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(IoTHubDeviceMethod_InvokeMany_return_INVALID_ARG_if_input_parameter_deviceIds_is_NULL)
+{
+    // act
+    IOTHUB_DEVICE_METHOD_RESULT result = IoTHubDeviceMethod_InvokeMany(TEST_IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_HANDLE, NULL, TEST_DEVICE_COUNT, TEST_METHOD_NAME, TEST_METHOD_PAYLOAD, TEST_TIMEOUT, 2, test_invoke_many_callback, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, IOTHUB_DEVICE_METHOD_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(IoTHubDeviceMethod_InvokeMany_return_INVALID_ARG_if_input_parameter_deviceCount_is_0)
+{
+    // act
+    IOTHUB_DEVICE_METHOD_RESULT result = IoTHubDeviceMethod_InvokeMany(TEST_IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_HANDLE, TEST_DEVICE_IDS, 0, TEST_METHOD_NAME, TEST_METHOD_PAYLOAD, TEST_TIMEOUT, 2, test_invoke_many_callback, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, IOTHUB_DEVICE_METHOD_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(IoTHubDeviceMethod_InvokeMany_return_INVALID_ARG_if_input_parameter_methodName_is_NULL)
+{
+    // act
+    IOTHUB_DEVICE_METHOD_RESULT result = IoTHubDeviceMethod_InvokeMany(TEST_IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_HANDLE, TEST_DEVICE_IDS, TEST_DEVICE_COUNT, NULL, TEST_METHOD_PAYLOAD, TEST_TIMEOUT, 2, test_invoke_many_callback, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, IOTHUB_DEVICE_METHOD_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(IoTHubDeviceMethod_InvokeMany_return_INVALID_ARG_if_input_parameter_maxConcurrency_is_0)
+{
+    // act
+    IOTHUB_DEVICE_METHOD_RESULT result = IoTHubDeviceMethod_InvokeMany(TEST_IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_HANDLE, TEST_DEVICE_IDS, TEST_DEVICE_COUNT, TEST_METHOD_NAME, TEST_METHOD_PAYLOAD, TEST_TIMEOUT, 0, test_invoke_many_callback, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, IOTHUB_DEVICE_METHOD_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(IoTHubDeviceMethod_InvokeMany_return_INVALID_ARG_if_a_deviceId_is_NULL)
+{
+    // arrange
+    const char* deviceIds[] = { TEST_DEVICE_ID, NULL };
+
+    // act
+    IOTHUB_DEVICE_METHOD_RESULT result = IoTHubDeviceMethod_InvokeMany(TEST_IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_HANDLE, deviceIds, 2, TEST_METHOD_NAME, TEST_METHOD_PAYLOAD, TEST_TIMEOUT, 2, test_invoke_many_callback, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, IOTHUB_DEVICE_METHOD_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+static void set_expected_calls_for_invoke_many_device(void)
+{
+    EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    EXPECTED_CALL(BUFFER_new());
+
+    EXPECTED_CALL(HTTPHeaders_Alloc());
+    EXPECTED_CALL(HTTPHeaders_AddHeaderNameValuePair(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    EXPECTED_CALL(UniqueId_Generate(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    EXPECTED_CALL(HTTPHeaders_AddHeaderNameValuePair(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(HTTPHeaders_AddHeaderNameValuePair(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(HTTPHeaders_AddHeaderNameValuePair(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(service_client_http_pool_execute_request(TEST_HTTP_POOL_HANDLE, HTTPAPI_REQUEST_POST, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
+    EXPECTED_CALL(HTTPHeaders_Free(IGNORED_PTR_ARG));
+
+    EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .SetReturn(TEST_UNSIGNED_CHAR_PTR);
+    EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG));
+    EXPECTED_CALL(STRING_from_byte_array(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+    EXPECTED_CALL(json_parse_string(IGNORED_PTR_ARG));
+    EXPECTED_CALL(json_value_get_object(TEST_JSON_VALUE));
+    EXPECTED_CALL(json_object_get_value(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(json_object_get_value(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(json_serialize_to_string(IGNORED_PTR_ARG));
+    EXPECTED_CALL(json_value_get_number(IGNORED_PTR_ARG));
+    EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
+    EXPECTED_CALL(json_value_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
+
+    EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+}
+
+TEST_FUNCTION(IoTHubDeviceMethod_InvokeMany_happy_path)
+{
+    // arrange
+    IOTHUB_DEVICE_METHOD_INVOKE_MANY_STATISTICS statistics;
+    size_t i;
+
+    TEST_IOTHUB_SERVICE_CLIENT_DEVICE_METHOD.httpPool = TEST_HTTP_POOL_HANDLE;
+
+    EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+    EXPECTED_CALL(BUFFER_create(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_create());
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(service_client_http_pool_clone(TEST_HTTP_POOL_HANDLE))
+        .SetReturn(TEST_HTTP_POOL_HANDLE);
+    EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(service_client_worker_pool_run(TEST_DEVICE_COUNT, 1, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    for (i = 0; i < TEST_DEVICE_COUNT; i++)
+    {
+        set_expected_calls_for_invoke_many_device();
+    }
+    EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(service_client_http_pool_destroy(TEST_HTTP_POOL_HANDLE));
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
+
+    // act
+    IOTHUB_DEVICE_METHOD_RESULT result = IoTHubDeviceMethod_InvokeMany(TEST_IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_HANDLE, TEST_DEVICE_IDS, TEST_DEVICE_COUNT, TEST_METHOD_NAME, TEST_METHOD_PAYLOAD, TEST_TIMEOUT, 1, test_invoke_many_callback, NULL, &statistics);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, IOTHUB_DEVICE_METHOD_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, TEST_DEVICE_COUNT, g_invoke_many_callback_count);
+    ASSERT_ARE_EQUAL(size_t, TEST_DEVICE_COUNT, g_invoke_many_callback_succeeded);
+    ASSERT_ARE_EQUAL(size_t, TEST_DEVICE_COUNT, statistics.succeeded);
+    ASSERT_ARE_EQUAL(size_t, 0, statistics.failed);
+}
+
+TEST_FUNCTION(IoTHubDeviceMethod_InvokeMany_runs_the_devices_on_a_worker_pool_of_maxConcurrency)
+{
+    // arrange
+    IOTHUB_DEVICE_METHOD_INVOKE_MANY_STATISTICS statistics;
+    size_t i;
+
+    EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+    EXPECTED_CALL(BUFFER_create(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_create());
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(service_client_http_pool_create(TEST_HOSTNAME, TEST_SHAREDACCESSKEY, TEST_SHAREDACCESSKEYNAME, 8));
+    EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(service_client_worker_pool_run(TEST_DEVICE_COUNT, 8, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    for (i = 0; i < TEST_DEVICE_COUNT; i++)
+    {
+        set_expected_calls_for_invoke_many_device();
+    }
+    EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(service_client_http_pool_destroy(TEST_HTTP_POOL_HANDLE));
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
+
+    // act
+    IOTHUB_DEVICE_METHOD_RESULT result = IoTHubDeviceMethod_InvokeMany(TEST_IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_HANDLE, TEST_DEVICE_IDS, TEST_DEVICE_COUNT, TEST_METHOD_NAME, TEST_METHOD_PAYLOAD, TEST_TIMEOUT, 8, test_invoke_many_callback, NULL, &statistics);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, IOTHUB_DEVICE_METHOD_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, TEST_DEVICE_COUNT, g_invoke_many_callback_count);
+    ASSERT_ARE_EQUAL(size_t, TEST_DEVICE_COUNT, statistics.succeeded);
+}
+
+TEST_FUNCTION(IoTHubDeviceMethod_InvokeMany_reports_failed_devices_to_the_callback)
+{
+    // arrange
+    IOTHUB_DEVICE_METHOD_INVOKE_MANY_STATISTICS statistics;
+
+    TEST_IOTHUB_SERVICE_CLIENT_DEVICE_METHOD.httpPool = TEST_HTTP_POOL_HANDLE;
+    STRICT_EXPECTED_CALL(service_client_http_pool_clone(TEST_HTTP_POOL_HANDLE))
+        .SetReturn(TEST_HTTP_POOL_HANDLE);
+    STRICT_EXPECTED_CALL(service_client_http_pool_execute_request(TEST_HTTP_POOL_HANDLE, HTTPAPI_REQUEST_POST, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_statusCode(&httpStatusCodeBadRequest, sizeof(httpStatusCodeBadRequest))
+        .SetReturn(HTTPAPIEX_OK);
+    EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .SetReturn(TEST_UNSIGNED_CHAR_PTR);
+    EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .SetReturn(TEST_UNSIGNED_CHAR_PTR);
+
+    // act
+    IOTHUB_DEVICE_METHOD_RESULT result = IoTHubDeviceMethod_InvokeMany(TEST_IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_HANDLE, TEST_DEVICE_IDS, TEST_DEVICE_COUNT, TEST_METHOD_NAME, TEST_METHOD_PAYLOAD, TEST_TIMEOUT, 1, test_invoke_many_callback, NULL, &statistics);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, IOTHUB_DEVICE_METHOD_OK, result);
+    ASSERT_ARE_EQUAL(size_t, TEST_DEVICE_COUNT, g_invoke_many_callback_count);
+    ASSERT_ARE_EQUAL(size_t, TEST_DEVICE_COUNT - 1, g_invoke_many_callback_succeeded);
+    ASSERT_ARE_EQUAL(size_t, TEST_DEVICE_COUNT - 1, statistics.succeeded);
+    ASSERT_ARE_EQUAL(size_t, 1, statistics.failed);
+}
+
+TEST_FUNCTION(IoTHubDeviceMethod_InvokeMany_return_ERROR_if_not_every_device_is_called)
+{
+    // arrange
+    TEST_IOTHUB_SERVICE_CLIENT_DEVICE_METHOD.httpPool = TEST_HTTP_POOL_HANDLE;
+    STRICT_EXPECTED_CALL(service_client_http_pool_clone(TEST_HTTP_POOL_HANDLE))
+        .SetReturn(TEST_HTTP_POOL_HANDLE);
+    STRICT_EXPECTED_CALL(service_client_worker_pool_run(TEST_DEVICE_COUNT, 1, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(MU_FAILURE);
+
+    // act
+    IOTHUB_DEVICE_METHOD_RESULT result = IoTHubDeviceMethod_InvokeMany(TEST_IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_HANDLE, TEST_DEVICE_IDS, TEST_DEVICE_COUNT, TEST_METHOD_NAME, TEST_METHOD_PAYLOAD, TEST_TIMEOUT, 1, test_invoke_many_callback, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, IOTHUB_DEVICE_METHOD_ERROR, result);
+    ASSERT_ARE_EQUAL(size_t, 0, g_invoke_many_callback_count);
+}
+
+TEST_FUNCTION(IoTHubDeviceMethod_InvokeMany_calls_the_callback_without_holding_the_lock)
+{
+    // arrange
+    TEST_IOTHUB_SERVICE_CLIENT_DEVICE_METHOD.httpPool = TEST_HTTP_POOL_HANDLE;
+    STRICT_EXPECTED_CALL(service_client_http_pool_clone(TEST_HTTP_POOL_HANDLE))
+        .SetReturn(TEST_HTTP_POOL_HANDLE);
+    EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .SetReturn(TEST_UNSIGNED_CHAR_PTR);
+
+    // act
+    IOTHUB_DEVICE_METHOD_RESULT result = IoTHubDeviceMethod_InvokeMany(TEST_IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_HANDLE, TEST_DEVICE_IDS, TEST_DEVICE_COUNT, TEST_METHOD_NAME, TEST_METHOD_PAYLOAD, TEST_TIMEOUT, 1, test_invoke_many_callback, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, IOTHUB_DEVICE_METHOD_OK, result);
+    ASSERT_ARE_EQUAL(size_t, TEST_DEVICE_COUNT, g_invoke_many_callback_count);
+    ASSERT_ARE_EQUAL(size_t, 0, g_invoke_many_callback_under_lock);
+    ASSERT_ARE_EQUAL(int, 0, g_lock_depth);
+}
+
+TEST_FUNCTION(IoTHubDeviceMethod_InvokeMany_return_HTTPAPI_ERROR_if_connection_pool_creation_fails)
+{
+    // arrange
+    STRICT_EXPECTED_CALL(service_client_http_pool_create(TEST_HOSTNAME, TEST_SHAREDACCESSKEY, TEST_SHAREDACCESSKEYNAME, 2))
+        .SetReturn(NULL);
+
+    // act
+    IOTHUB_DEVICE_METHOD_RESULT result = IoTHubDeviceMethod_InvokeMany(TEST_IOTHUB_SERVICE_CLIENT_DEVICE_METHOD_HANDLE, TEST_DEVICE_IDS, TEST_DEVICE_COUNT, TEST_METHOD_NAME, TEST_METHOD_PAYLOAD, TEST_TIMEOUT, 2, test_invoke_many_callback, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, IOTHUB_DEVICE_METHOD_HTTPAPI_ERROR, result);
+    ASSERT_ARE_EQUAL(size_t, 0, g_invoke_many_callback_count);
+}
+
 END_TEST_SUITE(iothub_devicemethod_ut)
@@ -80,6 +80,10 @@ MOCKABLE_FUNCTION(, void, json_value_free, JSON_Value *, value);
 
 #include "iothub_messaging_ll.h"
 
+#define ENABLE_MOCKS
+#include "internal/iothub_service_client_feedback.h"
+#undef ENABLE_MOCKS
+
 TEST_DEFINE_ENUM_TYPE(IOTHUB_MESSAGING_RESULT, IOTHUB_MESSAGING_RESULT_VALUES);
 IMPLEMENT_UMOCK_C_ENUM_TYPE(IOTHUB_MESSAGING_RESULT, IOTHUB_MESSAGING_RESULT_VALUES);
 
@@ -91,10 +95,11 @@ static TEST_MUTEX_HANDLE g_testByTest;
 
 static STRING_HANDLE TEST_STRING_HANDLE = (STRING_HANDLE)0x4242;
 #define TEST_ASYNC_HANDLE           (ASYNC_OPERATION_HANDLE)0x4246
+#define TEST_FEEDBACK_DISPATCHER_HANDLE (FEEDBACK_DISPATCHER_HANDLE)0x4247
 
 // Whenever it's changed, update this according with
 // the current value of sizeof(IOTHUB_MESSAGING)
-#define SIZE_OF_IOTHUB_MESSAGING_STRUCT 224
+#define SIZE_OF_IOTHUB_MESSAGING_STRUCT 280
 static uint8_t TEST_IOTHUB_MESSAGING_INSTANCE[SIZE_OF_IOTHUB_MESSAGING_STRUCT];
 
 #define SOME_RANDOM_NUMBER 50304050
@@ -412,6 +417,71 @@ static void set_IoTHubMessaging_LL_Send_expected_calls()
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 }
 
+static void set_IoTHubMessaging_LL_SendBatch_encode_expected_calls()
+{
+    size_t number_of_arguments = 1;
+
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetContentType(IGNORED_PTR_ARG))
+        .CallCannotFail();
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetByteArray(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(message_create());
+    STRICT_EXPECTED_CALL(message_add_body_amqp_data(IGNORED_PTR_ARG, TEST_BINARY_DATA_INST));
+    STRICT_EXPECTED_CALL(IoTHubMessage_Properties(TEST_IOTHUB_MESSAGE_HANDLE))
+        .CallCannotFail()
+        .SetReturn(TEST_MAP_HANDLE);
+    STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_keys(&pTEST_MAP_KEYS, sizeof(pTEST_MAP_KEYS))
+        .CopyOutArgumentBuffer_values(&pTEST_MAP_VALUES, sizeof(pTEST_MAP_VALUES))
+        .CopyOutArgumentBuffer_count(&number_of_arguments, sizeof(size_t))
+        .SetReturn(MAP_OK);
+    STRICT_EXPECTED_CALL(amqpvalue_create_map());
+    STRICT_EXPECTED_CALL(amqpvalue_create_string(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_create_string(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_set_map_value(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(message_set_application_properties(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(properties_create());
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetMessageId(IGNORED_PTR_ARG))
+        .CallCannotFail()
+        .SetReturn(TEST_CONST_CHAR_PTR);
+    STRICT_EXPECTED_CALL(amqpvalue_create_string(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(properties_set_message_id(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(IoTHubMessage_GetCorrelationId(IGNORED_PTR_ARG))
+        .CallCannotFail()
+        .SetReturn(TEST_CONST_CHAR_PTR);
+    STRICT_EXPECTED_CALL(amqpvalue_create_string(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(properties_set_correlation_id(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(IGNORED_PTR_ARG));
+}
+
+static void set_IoTHubMessaging_LL_SendBatch_item_expected_calls(bool grow_destination_buffer)
+{
+    if (grow_destination_buffer)
+    {
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+            .SetReturn(TEST_DEVICE_DESTINATION_BUFFER);
+    }
+    STRICT_EXPECTED_CALL(amqpvalue_create_string(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(properties_set_to(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(message_set_properties(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) // SEND_CALLBACK_DATA
+        .SetReturn(TEST_SEND_CALLBACK_DATA_BUFFER);
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(messagesender_send_async(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+        .CaptureArgumentValue_on_message_send_complete(&saved_on_message_send_complete_callback)
+        .CaptureArgumentValue_callback_context(&saved_on_message_send_complete_context);
+    STRICT_EXPECTED_CALL(amqpvalue_destroy(IGNORED_PTR_ARG));
+}
+
+static void set_IoTHubMessaging_LL_SendBatch_cleanup_expected_calls()
+{
+    STRICT_EXPECTED_CALL(properties_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(message_destroy(IGNORED_PTR_ARG));
+}
+
 typedef struct SEND_COMPLETE_INFO_STRUCT
 {
     void* context;
@@ -486,6 +556,12 @@ static void test_func_iothub_feedback_message_received_callback(void* context, I
     }
 }
 
+static void test_func_iothub_feedback_record_received_callback(void* context, const IOTHUB_SERVICE_FEEDBACK_RECORD* feedbackRecord)
+{
+    (void)context;
+    (void)feedbackRecord;
+}
+
 static void reset_saved_feedback_message_received()
 {
     saved_feedback_message_received_count = 0;
@@ -604,6 +680,8 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         REGISTER_UMOCK_ALIAS_TYPE(MAP_RESULT, int);
         REGISTER_UMOCK_ALIAS_TYPE(MAP_HANDLE, void*);
         REGISTER_UMOCK_ALIAS_TYPE(receiver_settle_mode, uint8_t);
+        REGISTER_UMOCK_ALIAS_TYPE(FEEDBACK_DISPATCHER_HANDLE, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_FEEDBACK_RECORD_RECEIVED_CALLBACK, void*);
         REGISTER_UMOCK_ALIAS_TYPE(tickcounter_ms_t, unsigned long long);
         REGISTER_UMOCK_ALIAS_TYPE(fields, void*);
 
@@ -662,6 +740,8 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         REGISTER_GLOBAL_MOCK_RETURNS(Map_GetInternals, MAP_OK, MAP_ERROR);
         REGISTER_GLOBAL_MOCK_RETURNS(messaging_delivery_accepted, TEST_AMQP_VALUE, NULL);
         REGISTER_GLOBAL_MOCK_RETURNS(messaging_delivery_rejected, TEST_DELIVERY_REJECTED_AMQP_VALUE, NULL);
+        REGISTER_GLOBAL_MOCK_RETURNS(feedback_dispatcher_create, TEST_FEEDBACK_DISPATCHER_HANDLE, NULL);
+        REGISTER_GLOBAL_MOCK_RETURNS(feedback_dispatcher_dispatch, 0, 1);
     }
 
     TEST_SUITE_CLEANUP(TestClassCleanup)
@@ -1862,4 +1942,388 @@ BEGIN_TEST_SUITE(iothub_messaging_ll_ut)
         //cleanup
     }
 
+    TEST_FUNCTION(IoTHubMessaging_LL_SendBatch_NULL_handle_fails)
+    {
+        //arrange
+        IOTHUB_MESSAGING_BATCH_ITEM items[1] = { { TEST_DEVICE_ID, TEST_IOTHUB_MESSAGE_HANDLE, NULL, NULL } };
+        size_t itemsQueued;
+
+        umock_c_reset_all_calls();
+
+        //act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_SendBatch(NULL, items, 1, &itemsQueued);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_INVALID_ARG, result);
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(IoTHubMessaging_LL_SendBatch_zero_items_fails)
+    {
+        //arrange
+        IOTHUB_MESSAGING_HANDLE iothub_messaging_handle = create_messaging_handle();
+        IOTHUB_MESSAGING_BATCH_ITEM items[1] = { { TEST_DEVICE_ID, TEST_IOTHUB_MESSAGE_HANDLE, NULL, NULL } };
+        size_t itemsQueued;
+
+        umock_c_reset_all_calls();
+
+        //act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_SendBatch(iothub_messaging_handle, items, 0, &itemsQueued);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_INVALID_ARG, result);
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(IoTHubMessaging_LL_SendBatch_NULL_itemsQueued_fails)
+    {
+        //arrange
+        IOTHUB_MESSAGING_HANDLE iothub_messaging_handle = create_messaging_handle();
+        IOTHUB_MESSAGING_BATCH_ITEM items[1] = { { TEST_DEVICE_ID, TEST_IOTHUB_MESSAGE_HANDLE, NULL, NULL } };
+
+        umock_c_reset_all_calls();
+
+        //act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_SendBatch(iothub_messaging_handle, items, 1, NULL);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_INVALID_ARG, result);
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(IoTHubMessaging_LL_SendBatch_item_without_deviceId_fails)
+    {
+        //arrange
+        IOTHUB_MESSAGING_HANDLE iothub_messaging_handle = create_messaging_handle();
+        ASSERT_ARE_EQUAL(int, 0, open_messaging_handle(iothub_messaging_handle, false));
+        IOTHUB_MESSAGING_BATCH_ITEM items[2] = { { TEST_DEVICE_ID, TEST_IOTHUB_MESSAGE_HANDLE, NULL, NULL }, { NULL, TEST_IOTHUB_MESSAGE_HANDLE, NULL, NULL } };
+        size_t itemsQueued;
+
+        umock_c_reset_all_calls();
+
+        //act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_SendBatch(iothub_messaging_handle, items, 2, &itemsQueued);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_INVALID_ARG, result);
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(IoTHubMessaging_LL_SendBatch_not_opened_fails)
+    {
+        //arrange
+        IOTHUB_MESSAGING_HANDLE iothub_messaging_handle = create_messaging_handle();
+        IOTHUB_MESSAGING_BATCH_ITEM items[1] = { { TEST_DEVICE_ID, TEST_IOTHUB_MESSAGE_HANDLE, NULL, NULL } };
+        size_t itemsQueued;
+
+        umock_c_reset_all_calls();
+
+        //act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_SendBatch(iothub_messaging_handle, items, 1, &itemsQueued);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_ERROR, result);
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(IoTHubMessaging_LL_SendBatch_encodes_a_shared_message_once)
+    {
+        //arrange
+        IOTHUB_MESSAGING_HANDLE iothub_messaging_handle = create_messaging_handle();
+        ASSERT_ARE_EQUAL(int, 0, open_messaging_handle(iothub_messaging_handle, false));
+        IOTHUB_MESSAGING_BATCH_ITEM items[2] = { { TEST_DEVICE_ID, TEST_IOTHUB_MESSAGE_HANDLE, NULL, NULL }, { TEST_DEVICE_ID, TEST_IOTHUB_MESSAGE_HANDLE, NULL, NULL } };
+        size_t itemsQueued;
+
+        umock_c_reset_all_calls();
+        set_IoTHubMessaging_LL_SendBatch_encode_expected_calls();
+        set_IoTHubMessaging_LL_SendBatch_item_expected_calls(true);
+        set_IoTHubMessaging_LL_SendBatch_item_expected_calls(false);
+        set_IoTHubMessaging_LL_SendBatch_cleanup_expected_calls();
+
+        //act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_SendBatch(iothub_messaging_handle, items, 2, &itemsQueued);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_OK, result);
+        ASSERT_ARE_EQUAL(size_t, 2, itemsQueued);
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(IoTHubMessaging_LL_SendBatch_stops_when_the_send_window_is_full)
+    {
+        //arrange
+        IOTHUB_MESSAGING_HANDLE iothub_messaging_handle = create_messaging_handle();
+        ASSERT_ARE_EQUAL(int, 0, open_messaging_handle(iothub_messaging_handle, false));
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_OK, IoTHubMessaging_LL_SetMaxSendQueueSize(iothub_messaging_handle, 1));
+        IOTHUB_MESSAGING_BATCH_ITEM items[2] = { { TEST_DEVICE_ID, TEST_IOTHUB_MESSAGE_HANDLE, NULL, NULL }, { TEST_DEVICE_ID, TEST_IOTHUB_MESSAGE_HANDLE, NULL, NULL } };
+        size_t itemsQueued;
+
+        umock_c_reset_all_calls();
+        set_IoTHubMessaging_LL_SendBatch_encode_expected_calls();
+        set_IoTHubMessaging_LL_SendBatch_item_expected_calls(true);
+        set_IoTHubMessaging_LL_SendBatch_cleanup_expected_calls();
+
+        //act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_SendBatch(iothub_messaging_handle, items, 2, &itemsQueued);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_QUEUE_FULL, result);
+        ASSERT_ARE_EQUAL(size_t, 1, itemsQueued);
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(IoTHubMessaging_LL_SendBatch_send_async_fails)
+    {
+        //arrange
+        IOTHUB_MESSAGING_HANDLE iothub_messaging_handle = create_messaging_handle();
+        ASSERT_ARE_EQUAL(int, 0, open_messaging_handle(iothub_messaging_handle, false));
+        IOTHUB_MESSAGING_BATCH_ITEM items[1] = { { TEST_DEVICE_ID, TEST_IOTHUB_MESSAGE_HANDLE, NULL, NULL } };
+        size_t itemsQueued;
+
+        umock_c_reset_all_calls();
+        set_IoTHubMessaging_LL_SendBatch_encode_expected_calls();
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+            .SetReturn(TEST_DEVICE_DESTINATION_BUFFER);
+        STRICT_EXPECTED_CALL(amqpvalue_create_string(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(properties_set_to(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(message_set_properties(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .SetReturn(TEST_SEND_CALLBACK_DATA_BUFFER);
+        STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(messagesender_send_async(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+            .SetReturn(NULL);
+        STRICT_EXPECTED_CALL(singlylinkedlist_remove_if(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(amqpvalue_destroy(IGNORED_PTR_ARG));
+        set_IoTHubMessaging_LL_SendBatch_cleanup_expected_calls();
+
+        //act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_SendBatch(iothub_messaging_handle, items, 1, &itemsQueued);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_ERROR, result);
+        ASSERT_ARE_EQUAL(size_t, 0, itemsQueued);
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(IoTHubMessaging_LL_GetSendStatistics_NULL_handle_fails)
+    {
+        //arrange
+        IOTHUB_MESSAGING_SEND_STATISTICS statistics;
+
+        umock_c_reset_all_calls();
+
+        //act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_GetSendStatistics(NULL, &statistics);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_INVALID_ARG, result);
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(IoTHubMessaging_LL_GetSendStatistics_NULL_statistics_fails)
+    {
+        //arrange
+        IOTHUB_MESSAGING_HANDLE iothub_messaging_handle = create_messaging_handle();
+
+        umock_c_reset_all_calls();
+
+        //act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_GetSendStatistics(iothub_messaging_handle, NULL);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_INVALID_ARG, result);
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(IoTHubMessaging_LL_GetSendStatistics_counts_queued_and_settled_messages)
+    {
+        //arrange
+        IOTHUB_MESSAGING_HANDLE iothub_messaging_handle = create_messaging_handle();
+        ASSERT_ARE_EQUAL(int, 0, open_messaging_handle(iothub_messaging_handle, false));
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_OK, IoTHubMessaging_LL_SetMaxSendQueueSize(iothub_messaging_handle, 10));
+        IOTHUB_MESSAGING_SEND_STATISTICS statistics;
+
+        umock_c_reset_all_calls();
+        set_IoTHubMessaging_LL_Send_expected_calls();
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_OK, IoTHubMessaging_LL_Send(iothub_messaging_handle, TEST_DEVICE_ID, TEST_IOTHUB_MESSAGE_HANDLE, NULL, NULL));
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_OK, IoTHubMessaging_LL_GetSendStatistics(iothub_messaging_handle, &statistics));
+        ASSERT_ARE_EQUAL(size_t, 1, statistics.inFlight);
+        ASSERT_ARE_EQUAL(size_t, 9, statistics.sendWindow);
+
+        umock_c_reset_all_calls();
+
+        //act
+        saved_on_message_send_complete_callback(saved_on_message_send_complete_context, MESSAGE_SEND_OK, TEST_AMQP_VALUE);
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_GetSendStatistics(iothub_messaging_handle, &statistics);
+
+        //assert
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_OK, result);
+        ASSERT_ARE_EQUAL(size_t, 1, statistics.messagesQueued);
+        ASSERT_ARE_EQUAL(size_t, 1, statistics.messagesSent);
+        ASSERT_ARE_EQUAL(size_t, 0, statistics.messagesFailed);
+        ASSERT_ARE_EQUAL(size_t, 0, statistics.inFlight);
+        ASSERT_ARE_EQUAL(size_t, 1, statistics.peakInFlight);
+        ASSERT_ARE_EQUAL(size_t, 10, statistics.sendWindow);
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(IoTHubMessaging_LL_SetFeedbackRecordCallback_NULL_handle_fails)
+    {
+        //arrange
+        umock_c_reset_all_calls();
+
+        //act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_SetFeedbackRecordCallback(NULL, test_func_iothub_feedback_record_received_callback, NULL, 2);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_INVALID_ARG, result);
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(IoTHubMessaging_LL_SetFeedbackRecordCallback_success)
+    {
+        //arrange
+        IOTHUB_MESSAGING_HANDLE iothub_messaging_handle = create_messaging_handle();
+        int feedbackContext = SOME_RANDOM_NUMBER;
+
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(feedback_dispatcher_create(2, 4, test_func_iothub_feedback_record_received_callback, &feedbackContext));
+
+        //act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_SetFeedbackRecordCallback(iothub_messaging_handle, test_func_iothub_feedback_record_received_callback, &feedbackContext, 2);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_OK, result);
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(IoTHubMessaging_LL_SetFeedbackRecordCallback_replaces_the_dispatcher)
+    {
+        //arrange
+        IOTHUB_MESSAGING_HANDLE iothub_messaging_handle = create_messaging_handle();
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_OK, IoTHubMessaging_LL_SetFeedbackRecordCallback(iothub_messaging_handle, test_func_iothub_feedback_record_received_callback, NULL, 2));
+
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(feedback_dispatcher_create(0, 0, test_func_iothub_feedback_record_received_callback, NULL));
+        STRICT_EXPECTED_CALL(feedback_dispatcher_destroy(TEST_FEEDBACK_DISPATCHER_HANDLE));
+
+        //act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_SetFeedbackRecordCallback(iothub_messaging_handle, test_func_iothub_feedback_record_received_callback, NULL, 0);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_OK, result);
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(IoTHubMessaging_LL_SetFeedbackRecordCallback_NULL_callback_removes_the_dispatcher)
+    {
+        //arrange
+        IOTHUB_MESSAGING_HANDLE iothub_messaging_handle = create_messaging_handle();
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_OK, IoTHubMessaging_LL_SetFeedbackRecordCallback(iothub_messaging_handle, test_func_iothub_feedback_record_received_callback, NULL, 2));
+
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(feedback_dispatcher_destroy(TEST_FEEDBACK_DISPATCHER_HANDLE));
+
+        //act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_SetFeedbackRecordCallback(iothub_messaging_handle, NULL, NULL, 0);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_OK, result);
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(IoTHubMessaging_LL_SetFeedbackRecordCallback_dispatcher_create_fails)
+    {
+        //arrange
+        IOTHUB_MESSAGING_HANDLE iothub_messaging_handle = create_messaging_handle();
+
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(feedback_dispatcher_create(2, 4, test_func_iothub_feedback_record_received_callback, NULL))
+            .SetReturn(NULL);
+
+        //act
+        IOTHUB_MESSAGING_RESULT result = IoTHubMessaging_LL_SetFeedbackRecordCallback(iothub_messaging_handle, test_func_iothub_feedback_record_received_callback, NULL, 2);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_ERROR, result);
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(IoTHubMessaging_LL_FeedbackMessageReceived_with_record_callback_dispatches_the_body)
+    {
+        //arrange
+        IOTHUB_MESSAGING_HANDLE iothub_messaging_handle = create_messaging_handle();
+        ASSERT_ARE_EQUAL(int, 0, open_messaging_handle(iothub_messaging_handle, false));
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_OK, IoTHubMessaging_LL_SetFeedbackRecordCallback(iothub_messaging_handle, test_func_iothub_feedback_record_received_callback, NULL, 2));
+
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(message_get_body_amqp_data_in_place(IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(feedback_dispatcher_dispatch(TEST_FEEDBACK_DISPATCHER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+        STRICT_EXPECTED_CALL(messaging_delivery_accepted());
+
+        //act
+        void* amqp_result = (void*)saved_on_message_receiver_callback(iothub_messaging_handle, TEST_MESSAGE_HANDLE);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(void_ptr, TEST_AMQP_VALUE, amqp_result);
+
+        ///cleanup
+    }
+
+    TEST_FUNCTION(IoTHubMessaging_LL_FeedbackMessageReceived_with_record_callback_rejects_when_dispatch_fails)
+    {
+        //arrange
+        IOTHUB_MESSAGING_HANDLE iothub_messaging_handle = create_messaging_handle();
+        ASSERT_ARE_EQUAL(int, 0, open_messaging_handle(iothub_messaging_handle, false));
+        ASSERT_ARE_EQUAL(int, IOTHUB_MESSAGING_OK, IoTHubMessaging_LL_SetFeedbackRecordCallback(iothub_messaging_handle, test_func_iothub_feedback_record_received_callback, NULL, 0));
+
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(message_get_body_amqp_data_in_place(IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(feedback_dispatcher_dispatch(TEST_FEEDBACK_DISPATCHER_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+            .SetReturn(1);
+        STRICT_EXPECTED_CALL(messaging_delivery_rejected(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+        //act
+        void* amqp_result = (void*)saved_on_message_receiver_callback(iothub_messaging_handle, TEST_MESSAGE_HANDLE);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(void_ptr, TEST_DELIVERY_REJECTED_AMQP_VALUE, amqp_result);
+
+        ///cleanup
+    }
+
 END_TEST_SUITE(iothub_messaging_ll_ut)
@@ -19,10 +19,13 @@
 #include "azure_c_shared_utility/httpheaders.h"
 #include "azure_c_shared_utility/httpapiex.h"
 #include "azure_c_shared_utility/httpapiexsas.h"
+#include "internal/iothub_service_client_http_pool.h"
+#include "internal/iothub_service_client_worker_pool.h"
 #include "azure_c_shared_utility/strings.h"
 #include "azure_c_shared_utility/singlylinkedlist.h"
 #include "parson.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/threadapi.h"
 
 MOCKABLE_FUNCTION(, JSON_Value*, json_parse_string, const char *, string);
 MOCKABLE_FUNCTION(, const char*, json_object_get_string, const JSON_Object *, object, const char *, name);
@@ -43,6 +46,9 @@ MOCKABLE_FUNCTION(, JSON_Status, json_object_clear, JSON_Object*, object);
 MOCKABLE_FUNCTION(, void, json_value_free, JSON_Value *, value);
 MOCKABLE_FUNCTION(, JSON_Status, json_object_dotset_boolean, JSON_Object*, object, const char *, name, int, boolean);
 MOCKABLE_FUNCTION(, int, json_object_dotget_boolean, const JSON_Object *, object, const char *, name);
+MOCKABLE_FUNCTION(, JSON_Value*, json_value_init_array);
+MOCKABLE_FUNCTION(, JSON_Status, json_array_append_value, JSON_Array*, array, JSON_Value*, value);
+MOCKABLE_FUNCTION(, JSON_Array*, json_object_get_array, const JSON_Object*, object, const char*, name);
 
 
 #undef ENABLE_MOCKS
@@ -356,6 +362,26 @@ static LIST_ITEM_HANDLE my_list_find(SINGLYLINKEDLIST_HANDLE list, LIST_MATCH_FU
     return result;
 }
 
+static THREADAPI_RESULT my_ThreadAPI_Create(THREAD_HANDLE* threadHandle, THREAD_START_FUNC func, void* arg)
+{
+    // Runs the prefetch inline, so the page is ready by the time the iterator joins.
+    *threadHandle = (THREAD_HANDLE)0x4646;
+    (void)func(arg);
+    return THREADAPI_OK;
+}
+
+// Processes the items in order on the calling thread.
+static int my_service_client_worker_pool_run(size_t itemCount, size_t maxConcurrency, SERVICE_CLIENT_WORKER_POOL_ITEM_FUNCTION processItem, void* context)
+{
+    size_t i;
+    (void)maxConcurrency;
+    for (i = 0; i < itemCount; i++)
+    {
+        processItem(context, i);
+    }
+    return 0;
+}
+
 #define ENABLE_MOCKS
 #include "azure_c_shared_utility/gballoc.h"
 #undef ENABLE_MOCKS
@@ -402,8 +428,14 @@ static char* TEST_SHAREDACCESSKEYNAME = "theSharedAccessKeyName";
 static IOTHUB_SERVICE_CLIENT_AUTH TEST_IOTHUB_SERVICE_CLIENT_AUTH;
 static IOTHUB_SERVICE_CLIENT_AUTH_HANDLE TEST_IOTHUB_SERVICE_CLIENT_AUTH_HANDLE = &TEST_IOTHUB_SERVICE_CLIENT_AUTH;
 
-static IOTHUB_REGISTRYMANAGER TEST_IOTHUB_REGISTRYMANAGER;
-static IOTHUB_REGISTRYMANAGER_HANDLE TEST_IOTHUB_REGISTRYMANAGER_HANDLE = &TEST_IOTHUB_REGISTRYMANAGER;
+typedef struct IOTHUB_REGISTRYMANAGER_INSTANCE_TAG
+{
+    IOTHUB_REGISTRYMANAGER registryManager;
+    SERVICE_CLIENT_HTTP_POOL_HANDLE httpPool;
+} IOTHUB_REGISTRYMANAGER_INSTANCE;
+
+static IOTHUB_REGISTRYMANAGER_INSTANCE TEST_IOTHUB_REGISTRYMANAGER;
+static IOTHUB_REGISTRYMANAGER_HANDLE TEST_IOTHUB_REGISTRYMANAGER_HANDLE = &TEST_IOTHUB_REGISTRYMANAGER.registryManager;
 
 static IOTHUB_REGISTRY_DEVICE_CREATE TEST_IOTHUB_REGISTRY_DEVICE_CREATE;
 static IOTHUB_REGISTRY_DEVICE_UPDATE TEST_IOTHUB_REGISTRY_DEVICE_UPDATE;
@@ -430,6 +462,7 @@ static STRING_HANDLE TEST_STRING_HANDLE = (STRING_HANDLE)0x4242;
 static BUFFER_HANDLE TEST_BUFFER_HANDLE = (BUFFER_HANDLE)0x4242;
 static const SINGLYLINKEDLIST_HANDLE TEST_LIST_HANDLE = (SINGLYLINKEDLIST_HANDLE)0x4242;
 static const LIST_ITEM_HANDLE TEST_LIST_ITEM_HANDLE = (LIST_ITEM_HANDLE)0x3434;
+static SERVICE_CLIENT_HTTP_POOL_HANDLE TEST_HTTP_POOL_HANDLE = (SERVICE_CLIENT_HTTP_POOL_HANDLE)0x4747;
 
 static const unsigned int httpStatusCodeOk = 200;
 static const unsigned int httpStatusCodeBadRequest = 400;
@@ -503,6 +536,16 @@ static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
     ASSERT_FAIL(temp_str);
 }
 
+static void set_bulk_operation(IOTHUB_REGISTRY_BULK_OPERATION* operation, const char* deviceId)
+{
+    memset(operation, 0, sizeof(IOTHUB_REGISTRY_BULK_OPERATION));
+    operation->version = IOTHUB_REGISTRY_BULK_OPERATION_VERSION_1;
+    operation->mode = IOTHUB_REGISTRY_BULK_OPERATION_CREATE;
+    operation->deviceId = deviceId;
+    operation->authMethod = IOTHUB_REGISTRYMANAGER_AUTH_SPK;
+    operation->status = IOTHUB_DEVICE_STATUS_ENABLED;
+}
+
 static void freeDeviceList(SINGLYLINKEDLIST_HANDLE deviceList, IOTHUB_REGISTRYMANAGER_AUTH_METHOD expectedAuth)
 {
     if (deviceList != NULL)
@@ -843,10 +886,16 @@ BEGIN_TEST_SUITE(iothub_registrymanager_ut)
         REGISTER_UMOCK_ALIAS_TYPE(HTTP_HANDLE, void*);
         REGISTER_UMOCK_ALIAS_TYPE(HTTPAPIEX_HANDLE, void*);
         REGISTER_UMOCK_ALIAS_TYPE(HTTPAPIEX_SAS_HANDLE, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(SERVICE_CLIENT_HTTP_POOL_HANDLE, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(IOTHUB_SERVICE_CLIENT_AUTH_HANDLE, void*);
 
         REGISTER_UMOCK_ALIAS_TYPE(JSON_Status, int);
         REGISTER_UMOCK_ALIAS_TYPE(SINGLYLINKEDLIST_HANDLE, void*);
         REGISTER_UMOCK_ALIAS_TYPE(LIST_ITEM_HANDLE, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(THREAD_HANDLE, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(THREAD_START_FUNC, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(THREADAPI_RESULT, int);
+        REGISTER_UMOCK_ALIAS_TYPE(SERVICE_CLIENT_WORKER_POOL_ITEM_FUNCTION, void*);
 
         REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
         REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
@@ -958,6 +1007,23 @@ BEGIN_TEST_SUITE(iothub_registrymanager_ut)
 
         REGISTER_GLOBAL_MOCK_RETURN(json_object_dotget_boolean, JSONSuccess);
         REGISTER_GLOBAL_MOCK_FAIL_RETURN(json_object_dotget_boolean, -1);
+
+        REGISTER_GLOBAL_MOCK_HOOK(ThreadAPI_Create, my_ThreadAPI_Create);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(ThreadAPI_Create, THREADAPI_ERROR);
+        REGISTER_GLOBAL_MOCK_RETURN(ThreadAPI_Join, THREADAPI_OK);
+
+        REGISTER_GLOBAL_MOCK_RETURN(json_value_init_array, TEST_JSON_VALUE);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(json_value_init_array, NULL);
+        REGISTER_GLOBAL_MOCK_RETURN(json_array_append_value, JSONSuccess);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(json_array_append_value, JSONFailure);
+
+        REGISTER_GLOBAL_MOCK_RETURN(service_client_http_pool_create, TEST_HTTP_POOL_HANDLE);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(service_client_http_pool_create, NULL);
+        REGISTER_GLOBAL_MOCK_RETURN(service_client_http_pool_execute_request, HTTPAPIEX_OK);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(service_client_http_pool_execute_request, HTTPAPIEX_ERROR);
+
+        REGISTER_GLOBAL_MOCK_HOOK(service_client_worker_pool_run, my_service_client_worker_pool_run);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(service_client_worker_pool_run, MU_FAILURE);
     }
 
     TEST_SUITE_CLEANUP(TestClassCleanup)
@@ -981,11 +1047,12 @@ BEGIN_TEST_SUITE(iothub_registrymanager_ut)
         TEST_IOTHUB_SERVICE_CLIENT_AUTH.keyName = TEST_SHAREDACCESSKEYNAME;
         TEST_IOTHUB_SERVICE_CLIENT_AUTH.sharedAccessKey = TEST_SHAREDACCESSKEY;
 
-        TEST_IOTHUB_REGISTRYMANAGER.hostname = TEST_HOSTNAME;
-        TEST_IOTHUB_REGISTRYMANAGER.iothubName = TEST_IOTHUBNAME;
-        TEST_IOTHUB_REGISTRYMANAGER.iothubSuffix = TEST_IOTHUBSUFFIX;
-        TEST_IOTHUB_REGISTRYMANAGER.keyName = TEST_SHAREDACCESSKEYNAME;
-        TEST_IOTHUB_REGISTRYMANAGER.sharedAccessKey = TEST_SHAREDACCESSKEY;
+        TEST_IOTHUB_REGISTRYMANAGER.registryManager.hostname = TEST_HOSTNAME;
+        TEST_IOTHUB_REGISTRYMANAGER.registryManager.iothubName = TEST_IOTHUBNAME;
+        TEST_IOTHUB_REGISTRYMANAGER.registryManager.iothubSuffix = TEST_IOTHUBSUFFIX;
+        TEST_IOTHUB_REGISTRYMANAGER.registryManager.keyName = TEST_SHAREDACCESSKEYNAME;
+        TEST_IOTHUB_REGISTRYMANAGER.registryManager.sharedAccessKey = TEST_SHAREDACCESSKEY;
+        TEST_IOTHUB_REGISTRYMANAGER.httpPool = NULL;
 
         TEST_IOTHUB_REGISTRY_DEVICE_CREATE.deviceId = TEST_DEVICE_ID;
         TEST_IOTHUB_REGISTRY_DEVICE_CREATE.primaryKey = TEST_PRIMARYKEY;
@@ -1150,6 +1217,8 @@ BEGIN_TEST_SUITE(iothub_registrymanager_ut)
         STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
             .IgnoreAllArguments();
 
+        STRICT_EXPECTED_CALL(service_client_auth_get_http_pool(TEST_IOTHUB_SERVICE_CLIENT_AUTH_HANDLE));
+
         // act
         IOTHUB_REGISTRYMANAGER_HANDLE result = IoTHubRegistryManager_Create(TEST_IOTHUB_SERVICE_CLIENT_AUTH_HANDLE);
 
@@ -1255,6 +1324,41 @@ BEGIN_TEST_SUITE(iothub_registrymanager_ut)
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
     }
 
+    TEST_FUNCTION(IoTHubRegistryManager_Destroy_releases_the_connection_pool_of_serviceClientHandle)
+    {
+        // arrange
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(service_client_auth_get_http_pool(TEST_IOTHUB_SERVICE_CLIENT_AUTH_HANDLE))
+            .SetReturn(TEST_HTTP_POOL_HANDLE);
+        STRICT_EXPECTED_CALL(service_client_http_pool_clone(TEST_HTTP_POOL_HANDLE))
+            .SetReturn(TEST_HTTP_POOL_HANDLE);
+
+        IOTHUB_REGISTRYMANAGER_HANDLE handle = IoTHubRegistryManager_Create(TEST_IOTHUB_SERVICE_CLIENT_AUTH_HANDLE);
+        ASSERT_IS_NOT_NULL(handle);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(service_client_http_pool_destroy(TEST_HTTP_POOL_HANDLE));
+        STRICT_EXPECTED_CALL(gballoc_free(handle));
+
+        // act
+        IoTHubRegistryManager_Destroy(handle);
+
+        // assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
     TEST_FUNCTION(IoTHubRegistryManager_CreateModule_return_IOTHUB_REGISTRYMANAGER_INVALID_ARG_if_input_parameter_registryManagerHandle_is_NULL)
     {
         // arrange
@@ -4064,4 +4168,671 @@ BEGIN_TEST_SUITE(iothub_registrymanager_ut)
         umock_c_negative_tests_deinit();
     }
 
+    TEST_FUNCTION(IoTHubRegistryManager_CreateDeviceIterator_return_NULL_if_input_parameter_registryManagerHandle_is_NULL)
+    {
+        ///arrange
+
+        ///act
+        IOTHUB_REGISTRYMANAGER_ITERATOR_HANDLE result = IoTHubRegistryManager_CreateDeviceIterator(NULL, 100, false);
+
+        ///assert
+        ASSERT_IS_NULL(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    TEST_FUNCTION(IoTHubRegistryManager_CreateDeviceIterator_return_NULL_if_pageSize_is_greater_than_1000)
+    {
+        ///arrange
+
+        ///act
+        IOTHUB_REGISTRYMANAGER_ITERATOR_HANDLE result = IoTHubRegistryManager_CreateDeviceIterator(TEST_IOTHUB_REGISTRYMANAGER_HANDLE, 1001, false);
+
+        ///assert
+        ASSERT_IS_NULL(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    TEST_FUNCTION(IoTHubRegistryManager_CreateDeviceIterator_does_not_send_a_request_without_prefetch)
+    {
+        ///arrange
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+        STRICT_EXPECTED_CALL(BUFFER_create(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+
+        ///act
+        IOTHUB_REGISTRYMANAGER_ITERATOR_HANDLE result = IoTHubRegistryManager_CreateDeviceIterator(TEST_IOTHUB_REGISTRYMANAGER_HANDLE, 100, false);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        IoTHubRegistryManager_DestroyIterator(result);
+    }
+
+    TEST_FUNCTION(IoTHubRegistryManager_CreateDeviceIterator_return_NULL_if_BUFFER_create_fails)
+    {
+        ///arrange
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+        STRICT_EXPECTED_CALL(BUFFER_create(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+            .SetReturn(NULL);
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+        ///act
+        IOTHUB_REGISTRYMANAGER_ITERATOR_HANDLE result = IoTHubRegistryManager_CreateDeviceIterator(TEST_IOTHUB_REGISTRYMANAGER_HANDLE, 100, false);
+
+        ///assert
+        ASSERT_IS_NULL(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    TEST_FUNCTION(IoTHubRegistryManager_GetNextDevice_return_IOTHUB_REGISTRYMANAGER_INVALID_ARG_if_input_parameter_is_NULL)
+    {
+        ///arrange
+        IOTHUB_REGISTRYMANAGER_ITERATOR_HANDLE iterator = IoTHubRegistryManager_CreateDeviceIterator(TEST_IOTHUB_REGISTRYMANAGER_HANDLE, 100, false);
+        umock_c_reset_all_calls();
+
+        ///act
+        IOTHUB_REGISTRYMANAGER_RESULT result1 = IoTHubRegistryManager_GetNextDevice(NULL, &TEST_IOTHUB_DEVICE_EX);
+        IOTHUB_REGISTRYMANAGER_RESULT result2 = IoTHubRegistryManager_GetNextDevice(iterator, NULL);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_INVALID_ARG, result1);
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_INVALID_ARG, result2);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        IoTHubRegistryManager_DestroyIterator(iterator);
+    }
+
+    TEST_FUNCTION(IoTHubRegistryManager_GetNextDevice_return_IOTHUB_REGISTRYMANAGER_INVALID_ARG_for_a_module_iterator)
+    {
+        ///arrange
+        IOTHUB_REGISTRYMANAGER_ITERATOR_HANDLE iterator = IoTHubRegistryManager_CreateModuleIterator(TEST_IOTHUB_REGISTRYMANAGER_HANDLE, 100, false);
+        umock_c_reset_all_calls();
+
+        ///act
+        IOTHUB_REGISTRYMANAGER_RESULT result = IoTHubRegistryManager_GetNextDevice(iterator, &TEST_IOTHUB_DEVICE_EX);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_INVALID_ARG, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        IoTHubRegistryManager_DestroyIterator(iterator);
+    }
+
+    TEST_FUNCTION(IoTHubRegistryManager_GetNextDevice_return_IOTHUB_REGISTRYMANAGER_INVALID_VERSION_if_version_is_invalid)
+    {
+        ///arrange
+        IOTHUB_DEVICE_EX deviceInfo;
+        memset(&deviceInfo, 0, sizeof(deviceInfo));
+        IOTHUB_REGISTRYMANAGER_ITERATOR_HANDLE iterator = IoTHubRegistryManager_CreateDeviceIterator(TEST_IOTHUB_REGISTRYMANAGER_HANDLE, 100, false);
+        umock_c_reset_all_calls();
+
+        ///act
+        IOTHUB_REGISTRYMANAGER_RESULT result = IoTHubRegistryManager_GetNextDevice(iterator, &deviceInfo);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_INVALID_VERSION, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        IoTHubRegistryManager_DestroyIterator(iterator);
+    }
+
+    TEST_FUNCTION(IoTHubRegistryManager_GetNextDevice_parses_one_device_at_a_time)
+    {
+        ///arrange
+        char page[] = "[{\"deviceId\":\"d1\"},{\"deviceId\":\"d2\",\"tags\":{\"a\":\"}\"}}]";
+        IOTHUB_DEVICE_EX deviceInfo;
+        memset(&deviceInfo, 0, sizeof(deviceInfo));
+        deviceInfo.version = IOTHUB_DEVICE_EX_VERSION_1;
+        IOTHUB_REGISTRYMANAGER_ITERATOR_HANDLE iterator = IoTHubRegistryManager_CreateDeviceIterator(TEST_IOTHUB_REGISTRYMANAGER_HANDLE, 100, false);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(HTTPHeaders_AddHeaderNameValuePair(IGNORED_PTR_ARG, "x-ms-max-item-count", "100"));
+        STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_ExecuteRequest(IGNORED_PTR_ARG, IGNORED_PTR_ARG, HTTPAPI_REQUEST_POST, "/devices/query?api-version=2020-09-30", IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer_statusCode(&httpStatusCodeOk, sizeof(httpStatusCodeOk))
+            .SetReturn(HTTPAPIEX_OK);
+        STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+            .SetReturn(strlen(page));
+        STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+            .SetReturn((unsigned char*)page);
+        STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+            .SetReturn((unsigned char*)page);
+        STRICT_EXPECTED_CALL(json_parse_string("{\"deviceId\":\"d1\"}"));
+        STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+            .SetReturn((unsigned char*)page);
+        STRICT_EXPECTED_CALL(json_parse_string("{\"deviceId\":\"d2\",\"tags\":{\"a\":\"}\"}}"));
+        STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+            .SetReturn((unsigned char*)page);
+
+        ///act
+        IOTHUB_REGISTRYMANAGER_RESULT result1 = IoTHubRegistryManager_GetNextDevice(iterator, &deviceInfo);
+        ASSERT_ARE_EQUAL(char_ptr, TEST_CONST_CHAR_PTR, deviceInfo.deviceId);
+        IoTHubRegistryManager_FreeDeviceExMembers(&deviceInfo);
+        deviceInfo.version = IOTHUB_DEVICE_EX_VERSION_1;
+        IOTHUB_REGISTRYMANAGER_RESULT result2 = IoTHubRegistryManager_GetNextDevice(iterator, &deviceInfo);
+        IoTHubRegistryManager_FreeDeviceExMembers(&deviceInfo);
+        deviceInfo.version = IOTHUB_DEVICE_EX_VERSION_1;
+        IOTHUB_REGISTRYMANAGER_RESULT result3 = IoTHubRegistryManager_GetNextDevice(iterator, &deviceInfo);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_OK, result1);
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_OK, result2);
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_END_OF_LIST, result3);
+        ASSERT_ARE_EQUAL(char_ptr, "", umock_c_get_expected_calls());
+        ASSERT_ARE_EQUAL(char_ptr, "[{\"deviceId\":\"d1\"},{\"deviceId\":\"d2\",\"tags\":{\"a\":\"}\"}}]", page);
+
+        ///cleanup
+        IoTHubRegistryManager_DestroyIterator(iterator);
+    }
+
+    TEST_FUNCTION(IoTHubRegistryManager_GetNextDevice_follows_the_continuation_token)
+    {
+        ///arrange
+        char page1[] = "[{\"deviceId\":\"d1\"}]";
+        char page2[] = "[{\"deviceId\":\"d2\"}]";
+        IOTHUB_DEVICE_EX deviceInfo;
+        memset(&deviceInfo, 0, sizeof(deviceInfo));
+        deviceInfo.version = IOTHUB_DEVICE_EX_VERSION_1;
+        IOTHUB_REGISTRYMANAGER_ITERATOR_HANDLE iterator = IoTHubRegistryManager_CreateDeviceIterator(TEST_IOTHUB_REGISTRYMANAGER_HANDLE, 0, false);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_ExecuteRequest(IGNORED_PTR_ARG, IGNORED_PTR_ARG, HTTPAPI_REQUEST_POST, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer_statusCode(&httpStatusCodeOk, sizeof(httpStatusCodeOk))
+            .SetReturn(HTTPAPIEX_OK);
+        STRICT_EXPECTED_CALL(HTTPHeaders_FindHeaderValue(IGNORED_PTR_ARG, "x-ms-continuation"))
+            .SetReturn("theToken");
+        STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+            .SetReturn(strlen(page1));
+        STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+            .SetReturn((unsigned char*)page1);
+        STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+            .SetReturn((unsigned char*)page1);
+        STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+            .SetReturn((unsigned char*)page1);
+        STRICT_EXPECTED_CALL(HTTPHeaders_AddHeaderNameValuePair(IGNORED_PTR_ARG, "x-ms-continuation", "theToken"));
+        STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_ExecuteRequest(IGNORED_PTR_ARG, IGNORED_PTR_ARG, HTTPAPI_REQUEST_POST, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer_statusCode(&httpStatusCodeOk, sizeof(httpStatusCodeOk))
+            .SetReturn(HTTPAPIEX_OK);
+        STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+            .SetReturn(strlen(page2));
+        STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+            .SetReturn((unsigned char*)page2);
+        STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+            .SetReturn((unsigned char*)page2);
+        STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+            .SetReturn((unsigned char*)page2);
+
+        ///act
+        IOTHUB_REGISTRYMANAGER_RESULT result1 = IoTHubRegistryManager_GetNextDevice(iterator, &deviceInfo);
+        IoTHubRegistryManager_FreeDeviceExMembers(&deviceInfo);
+        deviceInfo.version = IOTHUB_DEVICE_EX_VERSION_1;
+        IOTHUB_REGISTRYMANAGER_RESULT result2 = IoTHubRegistryManager_GetNextDevice(iterator, &deviceInfo);
+        IoTHubRegistryManager_FreeDeviceExMembers(&deviceInfo);
+        deviceInfo.version = IOTHUB_DEVICE_EX_VERSION_1;
+        IOTHUB_REGISTRYMANAGER_RESULT result3 = IoTHubRegistryManager_GetNextDevice(iterator, &deviceInfo);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_OK, result1);
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_OK, result2);
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_END_OF_LIST, result3);
+        ASSERT_ARE_EQUAL(char_ptr, "", umock_c_get_expected_calls());
+
+        ///cleanup
+        IoTHubRegistryManager_DestroyIterator(iterator);
+    }
+
+    TEST_FUNCTION(IoTHubRegistryManager_GetNextDevice_retries_a_page_that_failed)
+    {
+        ///arrange
+        char page[] = "[{\"deviceId\":\"d1\"}]";
+        IOTHUB_DEVICE_EX deviceInfo;
+        memset(&deviceInfo, 0, sizeof(deviceInfo));
+        deviceInfo.version = IOTHUB_DEVICE_EX_VERSION_1;
+        IOTHUB_REGISTRYMANAGER_ITERATOR_HANDLE iterator = IoTHubRegistryManager_CreateDeviceIterator(TEST_IOTHUB_REGISTRYMANAGER_HANDLE, 100, false);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_ExecuteRequest(IGNORED_PTR_ARG, IGNORED_PTR_ARG, HTTPAPI_REQUEST_POST, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer_statusCode(&httpStatusCodeBadRequest, sizeof(httpStatusCodeBadRequest))
+            .SetReturn(HTTPAPIEX_OK);
+        STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_ExecuteRequest(IGNORED_PTR_ARG, IGNORED_PTR_ARG, HTTPAPI_REQUEST_POST, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer_statusCode(&httpStatusCodeOk, sizeof(httpStatusCodeOk))
+            .SetReturn(HTTPAPIEX_OK);
+        STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+            .SetReturn(strlen(page));
+        STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+            .SetReturn((unsigned char*)page);
+        STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+            .SetReturn((unsigned char*)page);
+
+        ///act
+        IOTHUB_REGISTRYMANAGER_RESULT result1 = IoTHubRegistryManager_GetNextDevice(iterator, &deviceInfo);
+        IOTHUB_REGISTRYMANAGER_RESULT result2 = IoTHubRegistryManager_GetNextDevice(iterator, &deviceInfo);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_HTTP_STATUS_ERROR, result1);
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_OK, result2);
+        ASSERT_ARE_EQUAL(char_ptr, "", umock_c_get_expected_calls());
+
+        ///cleanup
+        IoTHubRegistryManager_FreeDeviceExMembers(&deviceInfo);
+        IoTHubRegistryManager_DestroyIterator(iterator);
+    }
+
+    TEST_FUNCTION(IoTHubRegistryManager_GetNextModule_prefetches_the_next_page)
+    {
+        ///arrange
+        char page1[] = "[{\"deviceId\":\"d1\",\"moduleId\":\"m1\"}]";
+        char page2[] = "[{\"deviceId\":\"d1\",\"moduleId\":\"m2\"}]";
+        IOTHUB_MODULE module;
+        memset(&module, 0, sizeof(module));
+        module.version = IOTHUB_MODULE_VERSION_1;
+
+        STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_ExecuteRequest(IGNORED_PTR_ARG, IGNORED_PTR_ARG, HTTPAPI_REQUEST_POST, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer_statusCode(&httpStatusCodeOk, sizeof(httpStatusCodeOk))
+            .SetReturn(HTTPAPIEX_OK);
+        STRICT_EXPECTED_CALL(HTTPHeaders_FindHeaderValue(IGNORED_PTR_ARG, "x-ms-continuation"))
+            .SetReturn("theToken");
+        STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+            .SetReturn(strlen(page1));
+        STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+            .SetReturn((unsigned char*)page1);
+        STRICT_EXPECTED_CALL(ThreadAPI_Join(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(HTTPHeaders_AddHeaderNameValuePair(IGNORED_PTR_ARG, "x-ms-continuation", "theToken"));
+        STRICT_EXPECTED_CALL(HTTPAPIEX_SAS_ExecuteRequest(IGNORED_PTR_ARG, IGNORED_PTR_ARG, HTTPAPI_REQUEST_POST, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer_statusCode(&httpStatusCodeOk, sizeof(httpStatusCodeOk))
+            .SetReturn(HTTPAPIEX_OK);
+        STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+            .SetReturn(strlen(page2));
+        STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+            .SetReturn((unsigned char*)page2);
+        STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+            .SetReturn((unsigned char*)page1);
+        STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+            .SetReturn((unsigned char*)page1);
+        STRICT_EXPECTED_CALL(ThreadAPI_Join(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+            .SetReturn((unsigned char*)page2);
+
+        ///act
+        IOTHUB_REGISTRYMANAGER_ITERATOR_HANDLE iterator = IoTHubRegistryManager_CreateModuleIterator(TEST_IOTHUB_REGISTRYMANAGER_HANDLE, 100, true);
+        IOTHUB_REGISTRYMANAGER_RESULT result1 = IoTHubRegistryManager_GetNextModule(iterator, &module);
+        IoTHubRegistryManager_FreeModuleMembers(&module);
+        module.version = IOTHUB_MODULE_VERSION_1;
+        IOTHUB_REGISTRYMANAGER_RESULT result2 = IoTHubRegistryManager_GetNextModule(iterator, &module);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(iterator);
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_OK, result1);
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_OK, result2);
+        ASSERT_ARE_EQUAL(char_ptr, "", umock_c_get_expected_calls());
+
+        ///cleanup
+        IoTHubRegistryManager_FreeModuleMembers(&module);
+        IoTHubRegistryManager_DestroyIterator(iterator);
+    }
+
+    TEST_FUNCTION(IoTHubRegistryManager_BulkOperation_return_IOTHUB_REGISTRYMANAGER_INVALID_ARG_if_input_parameter_registryManagerHandle_is_NULL)
+    {
+        ///arrange
+        IOTHUB_REGISTRY_BULK_OPERATION operation;
+        IOTHUB_REGISTRYMANAGER_RESULT operationResult;
+        set_bulk_operation(&operation, TEST_DEVICE_ID);
+
+        ///act
+        IOTHUB_REGISTRYMANAGER_RESULT result = IoTHubRegistryManager_BulkOperation(NULL, &operation, 1, 1, &operationResult);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_INVALID_ARG, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    TEST_FUNCTION(IoTHubRegistryManager_BulkOperation_return_IOTHUB_REGISTRYMANAGER_INVALID_ARG_if_operationCount_is_0)
+    {
+        ///arrange
+        IOTHUB_REGISTRY_BULK_OPERATION operation;
+        IOTHUB_REGISTRYMANAGER_RESULT operationResult;
+        set_bulk_operation(&operation, TEST_DEVICE_ID);
+
+        ///act
+        IOTHUB_REGISTRYMANAGER_RESULT result = IoTHubRegistryManager_BulkOperation(TEST_IOTHUB_REGISTRYMANAGER_HANDLE, &operation, 0, 1, &operationResult);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_INVALID_ARG, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    TEST_FUNCTION(IoTHubRegistryManager_BulkOperation_return_IOTHUB_REGISTRYMANAGER_INVALID_ARG_if_maxConcurrency_is_0)
+    {
+        ///arrange
+        IOTHUB_REGISTRY_BULK_OPERATION operation;
+        IOTHUB_REGISTRYMANAGER_RESULT operationResult;
+        set_bulk_operation(&operation, TEST_DEVICE_ID);
+
+        ///act
+        IOTHUB_REGISTRYMANAGER_RESULT result = IoTHubRegistryManager_BulkOperation(TEST_IOTHUB_REGISTRYMANAGER_HANDLE, &operation, 1, 0, &operationResult);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_INVALID_ARG, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    TEST_FUNCTION(IoTHubRegistryManager_BulkOperation_return_IOTHUB_REGISTRYMANAGER_INVALID_ARG_if_operationResults_is_NULL)
+    {
+        ///arrange
+        IOTHUB_REGISTRY_BULK_OPERATION operation;
+        set_bulk_operation(&operation, TEST_DEVICE_ID);
+
+        ///act
+        IOTHUB_REGISTRYMANAGER_RESULT result = IoTHubRegistryManager_BulkOperation(TEST_IOTHUB_REGISTRYMANAGER_HANDLE, &operation, 1, 1, NULL);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_INVALID_ARG, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    TEST_FUNCTION(IoTHubRegistryManager_BulkOperation_return_IOTHUB_REGISTRYMANAGER_INVALID_VERSION_if_an_operation_version_is_invalid)
+    {
+        ///arrange
+        IOTHUB_REGISTRY_BULK_OPERATION operations[2];
+        IOTHUB_REGISTRYMANAGER_RESULT operationResults[2];
+        set_bulk_operation(&operations[0], "d1");
+        set_bulk_operation(&operations[1], "d2");
+        operations[1].version = 0;
+
+        ///act
+        IOTHUB_REGISTRYMANAGER_RESULT result = IoTHubRegistryManager_BulkOperation(TEST_IOTHUB_REGISTRYMANAGER_HANDLE, operations, 2, 1, operationResults);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_INVALID_VERSION, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    TEST_FUNCTION(IoTHubRegistryManager_BulkOperation_return_IOTHUB_REGISTRYMANAGER_INVALID_ARG_if_an_operation_has_no_deviceId)
+    {
+        ///arrange
+        IOTHUB_REGISTRY_BULK_OPERATION operation;
+        IOTHUB_REGISTRYMANAGER_RESULT operationResult;
+        set_bulk_operation(&operation, NULL);
+
+        ///act
+        IOTHUB_REGISTRYMANAGER_RESULT result = IoTHubRegistryManager_BulkOperation(TEST_IOTHUB_REGISTRYMANAGER_HANDLE, &operation, 1, 1, &operationResult);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_INVALID_ARG, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    TEST_FUNCTION(IoTHubRegistryManager_BulkOperation_sends_one_request_per_batch_happy_path)
+    {
+        ///arrange
+        IOTHUB_REGISTRY_BULK_OPERATION operations[2];
+        IOTHUB_REGISTRYMANAGER_RESULT operationResults[2];
+        set_bulk_operation(&operations[0], "d1");
+        set_bulk_operation(&operations[1], "d2");
+        operations[1].mode = IOTHUB_REGISTRY_BULK_OPERATION_DELETE;
+        operations[1].eTag = "theETag";
+
+        STRICT_EXPECTED_CALL(service_client_http_pool_create(TEST_HOSTNAME, TEST_SHAREDACCESSKEY, TEST_SHAREDACCESSKEYNAME, 4));
+        STRICT_EXPECTED_CALL(service_client_worker_pool_run(1, 4, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(json_value_init_array());
+        STRICT_EXPECTED_CALL(json_object_set_string(IGNORED_PTR_ARG, "id", "d1"));
+        STRICT_EXPECTED_CALL(json_object_set_string(IGNORED_PTR_ARG, "importMode", "create"));
+        STRICT_EXPECTED_CALL(json_object_set_string(IGNORED_PTR_ARG, "id", "d2"));
+        STRICT_EXPECTED_CALL(json_object_set_string(IGNORED_PTR_ARG, "importMode", "deleteIfMatchETag"));
+        STRICT_EXPECTED_CALL(json_object_set_string(IGNORED_PTR_ARG, "eTag", "theETag"));
+        STRICT_EXPECTED_CALL(json_serialize_to_string(TEST_JSON_VALUE));
+        STRICT_EXPECTED_CALL(service_client_http_pool_execute_request(TEST_HTTP_POOL_HANDLE, HTTPAPI_REQUEST_POST, "/devices?api-version=2020-09-30", IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, NULL, IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer_statusCode(&httpStatusCodeOk, sizeof(httpStatusCodeOk));
+        STRICT_EXPECTED_CALL(service_client_http_pool_destroy(TEST_HTTP_POOL_HANDLE));
+
+        ///act
+        IOTHUB_REGISTRYMANAGER_RESULT result = IoTHubRegistryManager_BulkOperation(TEST_IOTHUB_REGISTRYMANAGER_HANDLE, operations, 2, 4, operationResults);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_OK, result);
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_OK, operationResults[0]);
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_OK, operationResults[1]);
+        ASSERT_ARE_EQUAL(char_ptr, "", umock_c_get_expected_calls());
+    }
+
+    TEST_FUNCTION(IoTHubRegistryManager_BulkOperation_splits_operations_into_batches_of_100)
+    {
+        ///arrange
+        IOTHUB_REGISTRY_BULK_OPERATION operations[150];
+        IOTHUB_REGISTRYMANAGER_RESULT operationResults[150];
+        size_t i;
+        for (i = 0; i < 150; i++)
+        {
+            set_bulk_operation(&operations[i], TEST_DEVICE_ID);
+        }
+
+        STRICT_EXPECTED_CALL(service_client_worker_pool_run(2, 8, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(service_client_http_pool_execute_request(TEST_HTTP_POOL_HANDLE, HTTPAPI_REQUEST_POST, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, NULL, IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer_statusCode(&httpStatusCodeOk, sizeof(httpStatusCodeOk));
+        STRICT_EXPECTED_CALL(service_client_http_pool_execute_request(TEST_HTTP_POOL_HANDLE, HTTPAPI_REQUEST_POST, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, NULL, IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer_statusCode(&httpStatusCodeOk, sizeof(httpStatusCodeOk));
+
+        ///act
+        IOTHUB_REGISTRYMANAGER_RESULT result = IoTHubRegistryManager_BulkOperation(TEST_IOTHUB_REGISTRYMANAGER_HANDLE, operations, 150, 8, operationResults);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_OK, result);
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_OK, operationResults[0]);
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_OK, operationResults[149]);
+        ASSERT_ARE_EQUAL(char_ptr, "", umock_c_get_expected_calls());
+    }
+
+    TEST_FUNCTION(IoTHubRegistryManager_BulkOperation_reports_per_device_errors)
+    {
+        ///arrange
+        char response[64] = "{\"errors\":[]}";
+        IOTHUB_REGISTRY_BULK_OPERATION operations[2];
+        IOTHUB_REGISTRYMANAGER_RESULT operationResults[2];
+        set_bulk_operation(&operations[0], "d1");
+        set_bulk_operation(&operations[1], "d2");
+
+        STRICT_EXPECTED_CALL(service_client_http_pool_execute_request(TEST_HTTP_POOL_HANDLE, HTTPAPI_REQUEST_POST, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, NULL, IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer_statusCode(&httpStatusCodeBadRequest, sizeof(httpStatusCodeBadRequest));
+        STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+            .SetReturn(strlen(response));
+        STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+            .SetReturn((unsigned char*)response);
+        STRICT_EXPECTED_CALL(json_parse_string(response));
+        STRICT_EXPECTED_CALL(json_object_get_array(TEST_JSON_OBJECT, "errors"))
+            .SetReturn(TEST_JSON_ARRAY);
+        STRICT_EXPECTED_CALL(json_array_get_count(TEST_JSON_ARRAY))
+            .SetReturn(1);
+        STRICT_EXPECTED_CALL(json_array_get_object(TEST_JSON_ARRAY, 0));
+        STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, "deviceId"))
+            .SetReturn("d2");
+        STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, "errorCode"))
+            .SetReturn("DeviceAlreadyExists");
+        STRICT_EXPECTED_CALL(json_value_free(TEST_JSON_VALUE));
+
+        ///act
+        IOTHUB_REGISTRYMANAGER_RESULT result = IoTHubRegistryManager_BulkOperation(TEST_IOTHUB_REGISTRYMANAGER_HANDLE, operations, 2, 1, operationResults);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_DEVICE_EXIST, result);
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_OK, operationResults[0]);
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_DEVICE_EXIST, operationResults[1]);
+        ASSERT_ARE_EQUAL(char_ptr, "", umock_c_get_expected_calls());
+    }
+
+    TEST_FUNCTION(IoTHubRegistryManager_BulkOperation_maps_per_device_errors_by_device_id)
+    {
+        ///arrange
+        char response[64] = "{\"errors\":[]}";
+        IOTHUB_REGISTRY_BULK_OPERATION operations[3];
+        IOTHUB_REGISTRYMANAGER_RESULT operationResults[3];
+        set_bulk_operation(&operations[0], "d3");
+        set_bulk_operation(&operations[1], "d1");
+        set_bulk_operation(&operations[2], "d2");
+
+        STRICT_EXPECTED_CALL(service_client_http_pool_execute_request(TEST_HTTP_POOL_HANDLE, HTTPAPI_REQUEST_POST, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, NULL, IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer_statusCode(&httpStatusCodeBadRequest, sizeof(httpStatusCodeBadRequest));
+        STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+            .SetReturn(strlen(response));
+        STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+            .SetReturn((unsigned char*)response);
+        STRICT_EXPECTED_CALL(json_parse_string(response));
+        STRICT_EXPECTED_CALL(json_object_get_array(TEST_JSON_OBJECT, "errors"))
+            .SetReturn(TEST_JSON_ARRAY);
+        STRICT_EXPECTED_CALL(json_array_get_count(TEST_JSON_ARRAY))
+            .SetReturn(2);
+        STRICT_EXPECTED_CALL(json_array_get_object(TEST_JSON_ARRAY, 0));
+        STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, "deviceId"))
+            .SetReturn("d3");
+        STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, "errorCode"))
+            .SetReturn("DeviceAlreadyExists");
+        STRICT_EXPECTED_CALL(json_array_get_object(TEST_JSON_ARRAY, 1));
+        STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, "deviceId"))
+            .SetReturn("d1");
+        STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, "errorCode"))
+            .SetReturn("DeviceNotFound");
+        STRICT_EXPECTED_CALL(json_value_free(TEST_JSON_VALUE));
+
+        ///act
+        IOTHUB_REGISTRYMANAGER_RESULT result = IoTHubRegistryManager_BulkOperation(TEST_IOTHUB_REGISTRYMANAGER_HANDLE, operations, 3, 1, operationResults);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_DEVICE_EXIST, result);
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_DEVICE_EXIST, operationResults[0]);
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_DEVICE_NOT_EXIST, operationResults[1]);
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_OK, operationResults[2]);
+        ASSERT_ARE_EQUAL(char_ptr, "", umock_c_get_expected_calls());
+    }
+
+    TEST_FUNCTION(IoTHubRegistryManager_BulkOperation_reports_per_device_errors_for_statuses_other_than_400)
+    {
+        ///arrange
+        char response[64] = "{\"errors\":[]}";
+        IOTHUB_REGISTRY_BULK_OPERATION operations[2];
+        IOTHUB_REGISTRYMANAGER_RESULT operationResults[2];
+        set_bulk_operation(&operations[0], "d1");
+        set_bulk_operation(&operations[1], "d2");
+
+        STRICT_EXPECTED_CALL(service_client_http_pool_execute_request(TEST_HTTP_POOL_HANDLE, HTTPAPI_REQUEST_POST, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, NULL, IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer_statusCode(&httpStatusCodeDeviceNotExists, sizeof(httpStatusCodeDeviceNotExists));
+        STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+            .SetReturn(strlen(response));
+        STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+            .SetReturn((unsigned char*)response);
+        STRICT_EXPECTED_CALL(json_parse_string(response));
+        STRICT_EXPECTED_CALL(json_object_get_array(TEST_JSON_OBJECT, "errors"))
+            .SetReturn(TEST_JSON_ARRAY);
+        STRICT_EXPECTED_CALL(json_array_get_count(TEST_JSON_ARRAY))
+            .SetReturn(1);
+        STRICT_EXPECTED_CALL(json_array_get_object(TEST_JSON_ARRAY, 0));
+        STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, "deviceId"))
+            .SetReturn("d2");
+        STRICT_EXPECTED_CALL(json_object_get_string(TEST_JSON_OBJECT, "errorCode"))
+            .SetReturn("SomethingElse");
+        STRICT_EXPECTED_CALL(json_value_free(TEST_JSON_VALUE));
+
+        ///act
+        IOTHUB_REGISTRYMANAGER_RESULT result = IoTHubRegistryManager_BulkOperation(TEST_IOTHUB_REGISTRYMANAGER_HANDLE, operations, 2, 1, operationResults);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_DEVICE_NOT_EXIST, result);
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_DEVICE_NOT_EXIST, operationResults[0]);
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_HTTP_STATUS_ERROR, operationResults[1]);
+        ASSERT_ARE_EQUAL(char_ptr, "", umock_c_get_expected_calls());
+    }
+
+    TEST_FUNCTION(IoTHubRegistryManager_BulkOperation_maps_the_status_of_a_batch_without_device_errors)
+    {
+        ///arrange
+        char response[64] = "{}";
+        IOTHUB_REGISTRY_BULK_OPERATION operations[2];
+        IOTHUB_REGISTRYMANAGER_RESULT operationResults[2];
+        set_bulk_operation(&operations[0], "d1");
+        set_bulk_operation(&operations[1], "d2");
+
+        STRICT_EXPECTED_CALL(service_client_http_pool_execute_request(TEST_HTTP_POOL_HANDLE, HTTPAPI_REQUEST_POST, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, NULL, IGNORED_PTR_ARG))
+            .CopyOutArgumentBuffer_statusCode(&httpStatusCodeDeviceExists, sizeof(httpStatusCodeDeviceExists));
+        STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+            .SetReturn(strlen(response));
+        STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+            .SetReturn((unsigned char*)response);
+        STRICT_EXPECTED_CALL(json_parse_string(response));
+        STRICT_EXPECTED_CALL(json_object_get_array(TEST_JSON_OBJECT, "errors"))
+            .SetReturn(NULL);
+        STRICT_EXPECTED_CALL(json_value_free(TEST_JSON_VALUE));
+
+        ///act
+        IOTHUB_REGISTRYMANAGER_RESULT result = IoTHubRegistryManager_BulkOperation(TEST_IOTHUB_REGISTRYMANAGER_HANDLE, operations, 2, 1, operationResults);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_DEVICE_EXIST, result);
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_DEVICE_EXIST, operationResults[0]);
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_DEVICE_EXIST, operationResults[1]);
+        ASSERT_ARE_EQUAL(char_ptr, "", umock_c_get_expected_calls());
+    }
+
+    TEST_FUNCTION(IoTHubRegistryManager_BulkOperation_fails_the_operations_that_were_not_sent)
+    {
+        ///arrange
+        IOTHUB_REGISTRY_BULK_OPERATION operations[2];
+        IOTHUB_REGISTRYMANAGER_RESULT operationResults[2];
+        set_bulk_operation(&operations[0], "d1");
+        set_bulk_operation(&operations[1], "d2");
+
+        STRICT_EXPECTED_CALL(service_client_worker_pool_run(1, 1, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .SetReturn(MU_FAILURE);
+
+        ///act
+        IOTHUB_REGISTRYMANAGER_RESULT result = IoTHubRegistryManager_BulkOperation(TEST_IOTHUB_REGISTRYMANAGER_HANDLE, operations, 2, 1, operationResults);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_ERROR, result);
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_ERROR, operationResults[0]);
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_ERROR, operationResults[1]);
+        ASSERT_ARE_EQUAL(char_ptr, "", umock_c_get_expected_calls());
+    }
+
+    TEST_FUNCTION(IoTHubRegistryManager_BulkOperation_fails_the_whole_batch_if_the_request_fails)
+    {
+        ///arrange
+        IOTHUB_REGISTRY_BULK_OPERATION operations[2];
+        IOTHUB_REGISTRYMANAGER_RESULT operationResults[2];
+        set_bulk_operation(&operations[0], "d1");
+        set_bulk_operation(&operations[1], "d2");
+
+        STRICT_EXPECTED_CALL(service_client_http_pool_execute_request(TEST_HTTP_POOL_HANDLE, HTTPAPI_REQUEST_POST, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, NULL, IGNORED_PTR_ARG))
+            .SetReturn(HTTPAPIEX_ERROR);
+
+        ///act
+        IOTHUB_REGISTRYMANAGER_RESULT result = IoTHubRegistryManager_BulkOperation(TEST_IOTHUB_REGISTRYMANAGER_HANDLE, operations, 2, 1, operationResults);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR, result);
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR, operationResults[0]);
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR, operationResults[1]);
+        ASSERT_ARE_EQUAL(char_ptr, "", umock_c_get_expected_calls());
+    }
+
+    TEST_FUNCTION(IoTHubRegistryManager_BulkOperation_return_IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR_if_the_pool_cannot_be_created)
+    {
+        ///arrange
+        IOTHUB_REGISTRY_BULK_OPERATION operation;
+        IOTHUB_REGISTRYMANAGER_RESULT operationResult;
+        set_bulk_operation(&operation, TEST_DEVICE_ID);
+
+        STRICT_EXPECTED_CALL(service_client_http_pool_create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, 1))
+            .SetReturn(NULL);
+
+        ///act
+        IOTHUB_REGISTRYMANAGER_RESULT result = IoTHubRegistryManager_BulkOperation(TEST_IOTHUB_REGISTRYMANAGER_HANDLE, &operation, 1, 1, &operationResult);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, IOTHUB_REGISTRYMANAGER_HTTPAPI_ERROR, result);
+        ASSERT_ARE_EQUAL(char_ptr, "", umock_c_get_expected_calls());
+    }
+
     END_TEST_SUITE(iothub_registrymanager_ut)
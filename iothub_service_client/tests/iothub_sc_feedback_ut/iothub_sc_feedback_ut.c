@@ -0,0 +1,534 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+#endif
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void* my_gballoc_realloc(void* ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#include "testrunnerswitcher.h"
+#include "umock_c/umock_c.h"
+#include "umock_c/umocktypes_charptr.h"
+#include "umock_c/umocktypes_stdint.h"
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/condition.h"
+#include "azure_c_shared_utility/threadapi.h"
+
+#undef ENABLE_MOCKS
+
+#include "internal/iothub_service_client_feedback.h"
+
+static LOCK_HANDLE TEST_LOCK_HANDLE = (LOCK_HANDLE)0x4747;
+static COND_HANDLE TEST_COND_HANDLE = (COND_HANDLE)0x4848;
+
+static const char* TEST_FEEDBACK_BODY =
+    "[{\"originalMessageId\":\"msg1\",\"deviceGenerationId\":\"gen1\",\"deviceId\":\"device1\",\"enqueuedTimeUtc\":\"2023-01-01T00:00:00Z\",\"description\":\"Success\"},"
+    " {\"originalMessageId\":\"msg2\",\"deviceGenerationId\":\"gen2\",\"deviceId\":\"device2\",\"enqueuedTimeUtc\":\"2023-01-01T00:00:01Z\",\"description\":\"Expired\"}]";
+
+#define MAX_SAVED_RECORDS   4
+#define MAX_SAVED_STRING    64
+
+typedef struct SAVED_RECORD_TAG
+{
+    char deviceId[MAX_SAVED_STRING];
+    char generationId[MAX_SAVED_STRING];
+    char description[MAX_SAVED_STRING];
+    char enqueuedTimeUtc[MAX_SAVED_STRING];
+    char originalMessageId[MAX_SAVED_STRING];
+    bool hasGenerationId;
+    IOTHUB_FEEDBACK_STATUS_CODE statusCode;
+} SAVED_RECORD;
+
+static SAVED_RECORD saved_records[MAX_SAVED_RECORDS];
+static size_t saved_record_count;
+
+static void save_string(char* destination, const char* source)
+{
+    (void)strncpy(destination, (source == NULL) ? "" : source, MAX_SAVED_STRING - 1);
+    destination[MAX_SAVED_STRING - 1] = '\0';
+}
+
+static void test_on_feedback_record(void* context, const IOTHUB_SERVICE_FEEDBACK_RECORD* feedbackRecord)
+{
+    (void)context;
+
+    if (saved_record_count < MAX_SAVED_RECORDS)
+    {
+        SAVED_RECORD* saved = &saved_records[saved_record_count];
+        save_string(saved->deviceId, feedbackRecord->deviceId);
+        save_string(saved->generationId, feedbackRecord->generationId);
+        save_string(saved->description, feedbackRecord->description);
+        save_string(saved->enqueuedTimeUtc, feedbackRecord->enqueuedTimeUtc);
+        save_string(saved->originalMessageId, feedbackRecord->originalMessageId);
+        saved->hasGenerationId = (feedbackRecord->generationId != NULL);
+        saved->statusCode = feedbackRecord->statusCode;
+    }
+
+    saved_record_count++;
+}
+
+static int parse_body(const char* body)
+{
+    int result;
+    FEEDBACK_PARSER_HANDLE parser = feedback_parser_create();
+    ASSERT_IS_NOT_NULL(parser);
+
+    result = feedback_parser_parse(parser, (const unsigned char*)body, strlen(body), test_on_feedback_record, NULL);
+
+    feedback_parser_destroy(parser);
+    return result;
+}
+
+static void set_expected_calls_for_dispatcher_create_with_workers(size_t workerCount)
+{
+    size_t i;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(Condition_Init());
+    for (i = 0; i < workerCount; i++)
+    {
+        STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    }
+}
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%" PRI_MU_ENUM "", MU_ENUM_VALUE(UMOCK_C_ERROR_CODE, error_code));
+}
+
+BEGIN_TEST_SUITE(iothub_sc_feedback_ut)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+    int result;
+
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(COND_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(COND_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(THREAD_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREAD_START_FUNC, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREADAPI_RESULT, int);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_realloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock_Init, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock, LOCK_ERROR);
+    REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Deinit, LOCK_OK);
+
+    REGISTER_GLOBAL_MOCK_RETURN(Condition_Init, TEST_COND_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Condition_Init, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(Condition_Post, COND_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Condition_Wait, COND_OK);
+
+    // The workers are never started, so what is queued stays queued until the dispatcher is destroyed.
+    REGISTER_GLOBAL_MOCK_RETURN(ThreadAPI_Create, THREADAPI_OK);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(ThreadAPI_Create, THREADAPI_ERROR);
+    REGISTER_GLOBAL_MOCK_RETURN(ThreadAPI_Join, THREADAPI_OK);
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+    (void)memset(saved_records, 0, sizeof(saved_records));
+    saved_record_count = 0;
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+TEST_FUNCTION(feedback_parser_create_succeeds)
+{
+    // arrange
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    FEEDBACK_PARSER_HANDLE result = feedback_parser_create();
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    feedback_parser_destroy(result);
+}
+
+TEST_FUNCTION(feedback_parser_create_fails_when_malloc_fails)
+{
+    // arrange
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    FEEDBACK_PARSER_HANDLE result = feedback_parser_create();
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(feedback_parser_parse_NULL_parser_fails)
+{
+    // act
+    int result = feedback_parser_parse(NULL, (const unsigned char*)TEST_FEEDBACK_BODY, strlen(TEST_FEEDBACK_BODY), test_on_feedback_record, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(feedback_parser_parse_yields_every_record)
+{
+    // act
+    int result = parse_body(TEST_FEEDBACK_BODY);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 2, saved_record_count);
+    ASSERT_ARE_EQUAL(char_ptr, "device1", saved_records[0].deviceId);
+    ASSERT_ARE_EQUAL(char_ptr, "gen1", saved_records[0].generationId);
+    ASSERT_ARE_EQUAL(char_ptr, "success", saved_records[0].description);
+    ASSERT_ARE_EQUAL(char_ptr, "2023-01-01T00:00:00Z", saved_records[0].enqueuedTimeUtc);
+    ASSERT_ARE_EQUAL(char_ptr, "msg1", saved_records[0].originalMessageId);
+    ASSERT_ARE_EQUAL(int, IOTHUB_FEEDBACK_STATUS_CODE_SUCCESS, saved_records[0].statusCode);
+    ASSERT_ARE_EQUAL(char_ptr, "device2", saved_records[1].deviceId);
+    ASSERT_ARE_EQUAL(char_ptr, "msg2", saved_records[1].originalMessageId);
+    ASSERT_ARE_EQUAL(int, IOTHUB_FEEDBACK_STATUS_CODE_EXPIRED, saved_records[1].statusCode);
+}
+
+TEST_FUNCTION(feedback_parser_parse_maps_every_status_code)
+{
+    // act
+    int result = parse_body("[{\"description\":\"DeliveryCountExceeded\"},{\"description\":\"rejected\"},{\"description\":\"other\"},{}]");
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 4, saved_record_count);
+    ASSERT_ARE_EQUAL(int, IOTHUB_FEEDBACK_STATUS_CODE_DELIVER_COUNT_EXCEEDED, saved_records[0].statusCode);
+    ASSERT_ARE_EQUAL(int, IOTHUB_FEEDBACK_STATUS_CODE_REJECTED, saved_records[1].statusCode);
+    ASSERT_ARE_EQUAL(int, IOTHUB_FEEDBACK_STATUS_CODE_UNKNOWN, saved_records[2].statusCode);
+    ASSERT_ARE_EQUAL(int, IOTHUB_FEEDBACK_STATUS_CODE_UNKNOWN, saved_records[3].statusCode);
+}
+
+TEST_FUNCTION(feedback_parser_parse_unescapes_strings)
+{
+    // act
+    int result = parse_body("[{\"deviceId\":\"a\\\"b\\\\c\\/d\\u00e9\\ud83d\\ude00\"}]");
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, saved_record_count);
+    ASSERT_ARE_EQUAL(char_ptr, "a\"b\\c/d\xc3\xa9\xf0\x9f\x98\x80", saved_records[0].deviceId);
+}
+
+TEST_FUNCTION(feedback_parser_parse_skips_unknown_members_and_non_string_fields)
+{
+    // act
+    int result = parse_body("[ { \"extra\" : { \"nested\" : [1, 2.5, \"]\", {\"x\": null}] }, \"deviceGenerationId\": 42,"
+        " \"aMemberNameLongerThanAnyOfTheRecordFields\": true, \"deviceId\" : \"device1\" } ]");
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, saved_record_count);
+    ASSERT_ARE_EQUAL(char_ptr, "device1", saved_records[0].deviceId);
+    ASSERT_IS_FALSE(saved_records[0].hasGenerationId);
+}
+
+TEST_FUNCTION(feedback_parser_parse_stops_at_length)
+{
+    // arrange
+    const char* body = "[{\"deviceId\":\"device1\"}]this is not part of the body";
+    FEEDBACK_PARSER_HANDLE parser = feedback_parser_create();
+
+    // act
+    int result = feedback_parser_parse(parser, (const unsigned char*)body, strlen("[{\"deviceId\":\"device1\"}]"), test_on_feedback_record, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, saved_record_count);
+
+    // cleanup
+    feedback_parser_destroy(parser);
+}
+
+TEST_FUNCTION(feedback_parser_parse_not_an_array_fails)
+{
+    // act
+    int result = parse_body("{\"deviceId\":\"device1\"}");
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, saved_record_count);
+}
+
+TEST_FUNCTION(feedback_parser_parse_empty_array_fails)
+{
+    // act
+    int result = parse_body(" [ ] ");
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, saved_record_count);
+}
+
+TEST_FUNCTION(feedback_parser_parse_truncated_body_fails_after_the_complete_records)
+{
+    // act
+    int result = parse_body("[{\"deviceId\":\"device1\"},{\"deviceId\":\"dev");
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, saved_record_count);
+}
+
+TEST_FUNCTION(feedback_parser_parse_fails_when_growing_the_strings_fails)
+{
+    // arrange
+    char body[1024];
+    char longDeviceId[512];
+    FEEDBACK_PARSER_HANDLE parser = feedback_parser_create();
+    (void)memset(longDeviceId, 'd', sizeof(longDeviceId) - 1);
+    longDeviceId[sizeof(longDeviceId) - 1] = '\0';
+    (void)sprintf(body, "[{\"deviceId\":\"%s\"}]", longDeviceId);
+
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    int result = feedback_parser_parse(parser, (const unsigned char*)body, strlen(body), test_on_feedback_record, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, saved_record_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    feedback_parser_destroy(parser);
+}
+
+TEST_FUNCTION(feedback_dispatcher_create_NULL_callback_fails)
+{
+    // act
+    FEEDBACK_DISPATCHER_HANDLE result = feedback_dispatcher_create(2, 4, NULL, NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(feedback_dispatcher_create_workers_without_pending_batches_fails)
+{
+    // act
+    FEEDBACK_DISPATCHER_HANDLE result = feedback_dispatcher_create(2, 0, test_on_feedback_record, NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(feedback_dispatcher_create_with_workers_succeeds)
+{
+    // arrange
+    set_expected_calls_for_dispatcher_create_with_workers(2);
+
+    // act
+    FEEDBACK_DISPATCHER_HANDLE result = feedback_dispatcher_create(2, 4, test_on_feedback_record, NULL);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    feedback_dispatcher_destroy(result);
+}
+
+TEST_FUNCTION(feedback_dispatcher_dispatch_without_workers_parses_on_the_calling_thread)
+{
+    // arrange
+    FEEDBACK_DISPATCHER_HANDLE dispatcher = feedback_dispatcher_create(0, 0, test_on_feedback_record, NULL);
+    ASSERT_IS_NOT_NULL(dispatcher);
+    umock_c_reset_all_calls();
+
+    // act
+    int result = feedback_dispatcher_dispatch(dispatcher, (const unsigned char*)TEST_FEEDBACK_BODY, strlen(TEST_FEEDBACK_BODY));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 2, saved_record_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    feedback_dispatcher_destroy(dispatcher);
+}
+
+TEST_FUNCTION(feedback_dispatcher_dispatch_without_workers_returns_parse_errors)
+{
+    // arrange
+    FEEDBACK_DISPATCHER_HANDLE dispatcher = feedback_dispatcher_create(0, 0, test_on_feedback_record, NULL);
+    ASSERT_IS_NOT_NULL(dispatcher);
+
+    // act
+    int result = feedback_dispatcher_dispatch(dispatcher, (const unsigned char*)"[]", 2);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    feedback_dispatcher_destroy(dispatcher);
+}
+
+TEST_FUNCTION(feedback_dispatcher_dispatch_queues_a_copy_for_the_workers)
+{
+    // arrange
+    FEEDBACK_DISPATCHER_HANDLE dispatcher = feedback_dispatcher_create(2, 4, test_on_feedback_record, NULL);
+    ASSERT_IS_NOT_NULL(dispatcher);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_FEEDBACK_BODY)));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
+
+    // act
+    int result = feedback_dispatcher_dispatch(dispatcher, (const unsigned char*)TEST_FEEDBACK_BODY, strlen(TEST_FEEDBACK_BODY));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, saved_record_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    feedback_dispatcher_destroy(dispatcher);
+}
+
+TEST_FUNCTION(feedback_dispatcher_dispatch_parses_on_the_calling_thread_when_the_queue_is_full)
+{
+    // arrange
+    FEEDBACK_DISPATCHER_HANDLE dispatcher = feedback_dispatcher_create(1, 1, test_on_feedback_record, NULL);
+    ASSERT_IS_NOT_NULL(dispatcher);
+    ASSERT_ARE_EQUAL(int, 0, feedback_dispatcher_dispatch(dispatcher, (const unsigned char*)TEST_FEEDBACK_BODY, strlen(TEST_FEEDBACK_BODY)));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_FEEDBACK_BODY)));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    int result = feedback_dispatcher_dispatch(dispatcher, (const unsigned char*)TEST_FEEDBACK_BODY, strlen(TEST_FEEDBACK_BODY));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 2, saved_record_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    feedback_dispatcher_destroy(dispatcher);
+}
+
+TEST_FUNCTION(feedback_dispatcher_dispatch_parses_on_the_calling_thread_when_the_copy_fails)
+{
+    // arrange
+    FEEDBACK_DISPATCHER_HANDLE dispatcher = feedback_dispatcher_create(1, 1, test_on_feedback_record, NULL);
+    ASSERT_IS_NOT_NULL(dispatcher);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_FEEDBACK_BODY)))
+        .SetReturn(NULL);
+
+    // act
+    int result = feedback_dispatcher_dispatch(dispatcher, (const unsigned char*)TEST_FEEDBACK_BODY, strlen(TEST_FEEDBACK_BODY));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 2, saved_record_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    feedback_dispatcher_destroy(dispatcher);
+}
+
+TEST_FUNCTION(feedback_dispatcher_destroy_parses_what_the_workers_left)
+{
+    // arrange
+    FEEDBACK_DISPATCHER_HANDLE dispatcher = feedback_dispatcher_create(2, 4, test_on_feedback_record, NULL);
+    ASSERT_IS_NOT_NULL(dispatcher);
+    ASSERT_ARE_EQUAL(int, 0, feedback_dispatcher_dispatch(dispatcher, (const unsigned char*)TEST_FEEDBACK_BODY, strlen(TEST_FEEDBACK_BODY)));
+    umock_c_reset_all_calls();
+
+    // act
+    feedback_dispatcher_destroy(dispatcher);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, saved_record_count);
+}
+
+END_TEST_SUITE(iothub_sc_feedback_ut)
@@ -0,0 +1,554 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#endif
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+static int my_mallocAndStrcpy_s(char** destination, const char* source)
+{
+    size_t l = strlen(source);
+    *destination = (char*)my_gballoc_malloc(l + 1);
+    strcpy(*destination, source);
+    return 0;
+}
+
+#include "testrunnerswitcher.h"
+#include "umock_c/umock_c.h"
+#include "umock_c/umocktypes_charptr.h"
+#include "umock_c/umocktypes_stdint.h"
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/strings.h"
+#include "azure_c_shared_utility/agenttime.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/condition.h"
+#include "azure_c_shared_utility/sastoken.h"
+#include "azure_c_shared_utility/httpapiex.h"
+#include "azure_c_shared_utility/httpheaders.h"
+
+#undef ENABLE_MOCKS
+
+#include "internal/iothub_service_client_http_pool.h"
+
+TEST_DEFINE_ENUM_TYPE(HTTPAPIEX_RESULT, HTTPAPIEX_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(HTTPAPIEX_RESULT, HTTPAPIEX_RESULT_VALUES);
+TEST_DEFINE_ENUM_TYPE(HTTP_HEADERS_RESULT, HTTP_HEADERS_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(HTTP_HEADERS_RESULT, HTTP_HEADERS_RESULT_VALUES);
+TEST_DEFINE_ENUM_TYPE(HTTPAPI_REQUEST_TYPE, HTTPAPI_REQUEST_TYPE_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(HTTPAPI_REQUEST_TYPE, HTTPAPI_REQUEST_TYPE_VALUES);
+
+static const char* TEST_HOSTNAME = "theHostName";
+static const char* TEST_SHAREDACCESSKEY = "theSharedAccessKey";
+static const char* TEST_SHAREDACCESSKEYNAME = "theSharedAccessKeyName";
+static const char* TEST_SHAREDACCESSSIGNATURE = "sas=SharedAccessSignature sr=theHostName&sig=theSignature";
+static const char* TEST_SAS_TOKEN = "SharedAccessSignature sr=theHostName&sig=theSignature&se=3600&skn=theSharedAccessKeyName";
+static const char* TEST_RELATIVE_PATH = "/twins/theDeviceId?api-version=2020-09-30";
+static const time_t TEST_TIME_VALUE = (time_t)1000;
+static const size_t TEST_MAX_CONNECTIONS = 2;
+
+static HTTP_HEADERS_HANDLE TEST_HTTP_HEADERS_HANDLE = (HTTP_HEADERS_HANDLE)0x4545;
+static BUFFER_HANDLE TEST_BUFFER_HANDLE = (BUFFER_HANDLE)0x4646;
+static LOCK_HANDLE TEST_LOCK_HANDLE = (LOCK_HANDLE)0x4747;
+static COND_HANDLE TEST_COND_HANDLE = (COND_HANDLE)0x4848;
+
+static const unsigned int httpStatusCodeOk = 200;
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%" PRI_MU_ENUM "", MU_ENUM_VALUE(UMOCK_C_ERROR_CODE, error_code));
+}
+
+static STRING_HANDLE my_STRING_construct(const char* psz)
+{
+    char* result;
+    (void)my_mallocAndStrcpy_s(&result, psz);
+    return (STRING_HANDLE)result;
+}
+
+static void my_STRING_delete(STRING_HANDLE handle)
+{
+    my_gballoc_free(handle);
+}
+
+static const char* my_STRING_c_str(STRING_HANDLE handle)
+{
+    return (const char*)handle;
+}
+
+static STRING_HANDLE my_SASToken_Create(STRING_HANDLE key, STRING_HANDLE scope, STRING_HANDLE keyName, uint64_t expiry)
+{
+    (void)key;
+    (void)scope;
+    (void)keyName;
+    (void)expiry;
+    return my_STRING_construct(TEST_SAS_TOKEN);
+}
+
+static HTTPAPIEX_HANDLE my_HTTPAPIEX_Create(const char* hostName)
+{
+    (void)hostName;
+    return (HTTPAPIEX_HANDLE)my_gballoc_malloc(1);
+}
+
+static void my_HTTPAPIEX_Destroy(HTTPAPIEX_HANDLE handle)
+{
+    my_gballoc_free(handle);
+}
+
+static void set_expected_calls_for_create(const char* sharedAccessKey)
+{
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, TEST_HOSTNAME));
+    STRICT_EXPECTED_CALL(STRING_construct(sharedAccessKey));
+    STRICT_EXPECTED_CALL(STRING_construct(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(STRING_construct(TEST_HOSTNAME));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(Condition_Init());
+}
+
+static void set_expected_calls_for_release(void)
+{
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(get_time(NULL));
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+}
+
+static void set_expected_calls_for_first_request(void)
+{
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(get_time(NULL));
+    STRICT_EXPECTED_CALL(get_difftime(TEST_TIME_VALUE, 0));
+    STRICT_EXPECTED_CALL(SASToken_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(STRING_delete(NULL));
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(TEST_HTTP_HEADERS_HANDLE, "Authorization", TEST_SAS_TOKEN));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Create(TEST_HOSTNAME));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(IGNORED_PTR_ARG, HTTPAPI_REQUEST_GET, TEST_RELATIVE_PATH, TEST_HTTP_HEADERS_HANDLE, NULL, IGNORED_PTR_ARG, NULL, TEST_BUFFER_HANDLE))
+        .CopyOutArgumentBuffer_statusCode(&httpStatusCodeOk, sizeof(httpStatusCodeOk));
+    set_expected_calls_for_release();
+}
+
+static HTTPAPIEX_RESULT execute_test_request(SERVICE_CLIENT_HTTP_POOL_HANDLE handle, unsigned int* statusCode)
+{
+    return service_client_http_pool_execute_request(handle, HTTPAPI_REQUEST_GET, TEST_RELATIVE_PATH, TEST_HTTP_HEADERS_HANDLE, NULL, statusCode, NULL, TEST_BUFFER_HANDLE);
+}
+
+BEGIN_TEST_SUITE(iothub_sc_http_pool_ut)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+    int result;
+
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_TYPE(HTTPAPIEX_RESULT, HTTPAPIEX_RESULT);
+    REGISTER_TYPE(HTTP_HEADERS_RESULT, HTTP_HEADERS_RESULT);
+    REGISTER_TYPE(HTTPAPI_REQUEST_TYPE, HTTPAPI_REQUEST_TYPE);
+    REGISTER_UMOCK_ALIAS_TYPE(BUFFER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(STRING_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(HTTP_HEADERS_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(HTTPAPIEX_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(COND_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(COND_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(time_t, long long);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+    REGISTER_GLOBAL_MOCK_HOOK(mallocAndStrcpy_s, my_mallocAndStrcpy_s);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(mallocAndStrcpy_s, 42);
+
+    REGISTER_GLOBAL_MOCK_HOOK(STRING_construct, my_STRING_construct);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(STRING_construct, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(STRING_delete, my_STRING_delete);
+    REGISTER_GLOBAL_MOCK_HOOK(STRING_c_str, my_STRING_c_str);
+
+    REGISTER_GLOBAL_MOCK_RETURN(get_time, TEST_TIME_VALUE);
+    REGISTER_GLOBAL_MOCK_RETURN(get_difftime, 1.0);
+
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock_Init, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock, LOCK_ERROR);
+    REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Deinit, LOCK_OK);
+
+    REGISTER_GLOBAL_MOCK_RETURN(Condition_Init, TEST_COND_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Condition_Init, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(Condition_Post, COND_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Condition_Wait, COND_OK);
+
+    REGISTER_GLOBAL_MOCK_HOOK(SASToken_Create, my_SASToken_Create);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(SASToken_Create, NULL);
+
+    REGISTER_GLOBAL_MOCK_HOOK(HTTPAPIEX_Create, my_HTTPAPIEX_Create);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(HTTPAPIEX_Create, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(HTTPAPIEX_Destroy, my_HTTPAPIEX_Destroy);
+    REGISTER_GLOBAL_MOCK_RETURN(HTTPAPIEX_ExecuteRequest, HTTPAPIEX_OK);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(HTTPAPIEX_ExecuteRequest, HTTPAPIEX_ERROR);
+
+    REGISTER_GLOBAL_MOCK_RETURN(HTTPHeaders_ReplaceHeaderNameValuePair, HTTP_HEADERS_OK);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(HTTPHeaders_ReplaceHeaderNameValuePair, HTTP_HEADERS_ERROR);
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+TEST_FUNCTION(service_client_http_pool_create_NULL_hostname_fails)
+{
+    // act
+    SERVICE_CLIENT_HTTP_POOL_HANDLE result = service_client_http_pool_create(NULL, TEST_SHAREDACCESSKEY, TEST_SHAREDACCESSKEYNAME, TEST_MAX_CONNECTIONS);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(service_client_http_pool_create_zero_maxConnections_fails)
+{
+    // act
+    SERVICE_CLIENT_HTTP_POOL_HANDLE result = service_client_http_pool_create(TEST_HOSTNAME, TEST_SHAREDACCESSKEY, TEST_SHAREDACCESSKEYNAME, 0);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(service_client_http_pool_create_NULL_keyName_with_shared_access_key_fails)
+{
+    // act
+    SERVICE_CLIENT_HTTP_POOL_HANDLE result = service_client_http_pool_create(TEST_HOSTNAME, TEST_SHAREDACCESSKEY, NULL, TEST_MAX_CONNECTIONS);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(service_client_http_pool_create_succeeds)
+{
+    // arrange
+    set_expected_calls_for_create(TEST_SHAREDACCESSKEY);
+
+    // act
+    SERVICE_CLIENT_HTTP_POOL_HANDLE result = service_client_http_pool_create(TEST_HOSTNAME, TEST_SHAREDACCESSKEY, TEST_SHAREDACCESSKEYNAME, TEST_MAX_CONNECTIONS);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    service_client_http_pool_destroy(result);
+}
+
+TEST_FUNCTION(service_client_http_pool_create_fails_when_Condition_Init_fails)
+{
+    // arrange
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, TEST_HOSTNAME));
+    STRICT_EXPECTED_CALL(STRING_construct(TEST_SHAREDACCESSKEY));
+    STRICT_EXPECTED_CALL(STRING_construct(TEST_SHAREDACCESSKEYNAME));
+    STRICT_EXPECTED_CALL(STRING_construct(TEST_HOSTNAME));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(Condition_Init())
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(STRING_delete(NULL));
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    SERVICE_CLIENT_HTTP_POOL_HANDLE result = service_client_http_pool_create(TEST_HOSTNAME, TEST_SHAREDACCESSKEY, TEST_SHAREDACCESSKEYNAME, TEST_MAX_CONNECTIONS);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(service_client_http_pool_execute_request_NULL_handle_fails)
+{
+    // arrange
+    unsigned int statusCode;
+
+    // act
+    HTTPAPIEX_RESULT result = execute_test_request(NULL, &statusCode);
+
+    // assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(service_client_http_pool_execute_request_signs_and_opens_a_connection_on_first_request)
+{
+    // arrange
+    unsigned int statusCode = 0;
+    SERVICE_CLIENT_HTTP_POOL_HANDLE handle = service_client_http_pool_create(TEST_HOSTNAME, TEST_SHAREDACCESSKEY, TEST_SHAREDACCESSKEYNAME, TEST_MAX_CONNECTIONS);
+    umock_c_reset_all_calls();
+
+    set_expected_calls_for_first_request();
+
+    // act
+    HTTPAPIEX_RESULT result = execute_test_request(handle, &statusCode);
+
+    // assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result);
+    ASSERT_ARE_EQUAL(int, httpStatusCodeOk, statusCode);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    service_client_http_pool_destroy(handle);
+}
+
+TEST_FUNCTION(service_client_http_pool_execute_request_reuses_token_and_connection)
+{
+    // arrange
+    unsigned int statusCode = 0;
+    SERVICE_CLIENT_HTTP_POOL_HANDLE handle = service_client_http_pool_create(TEST_HOSTNAME, TEST_SHAREDACCESSKEY, TEST_SHAREDACCESSKEYNAME, TEST_MAX_CONNECTIONS);
+    (void)execute_test_request(handle, &statusCode);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(get_time(NULL));
+    STRICT_EXPECTED_CALL(get_difftime(TEST_TIME_VALUE + 3600, TEST_TIME_VALUE))
+        .SetReturn(3600.0);
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(TEST_HTTP_HEADERS_HANDLE, "Authorization", TEST_SAS_TOKEN));
+    STRICT_EXPECTED_CALL(get_time(NULL));
+    STRICT_EXPECTED_CALL(get_difftime(TEST_TIME_VALUE, TEST_TIME_VALUE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(IGNORED_PTR_ARG, HTTPAPI_REQUEST_GET, TEST_RELATIVE_PATH, TEST_HTTP_HEADERS_HANDLE, NULL, IGNORED_PTR_ARG, NULL, TEST_BUFFER_HANDLE))
+        .CopyOutArgumentBuffer_statusCode(&httpStatusCodeOk, sizeof(httpStatusCodeOk));
+    set_expected_calls_for_release();
+
+    // act
+    HTTPAPIEX_RESULT result = execute_test_request(handle, &statusCode);
+
+    // assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    service_client_http_pool_destroy(handle);
+}
+
+TEST_FUNCTION(service_client_http_pool_execute_request_renews_token_about_to_expire)
+{
+    // arrange
+    unsigned int statusCode = 0;
+    SERVICE_CLIENT_HTTP_POOL_HANDLE handle = service_client_http_pool_create(TEST_HOSTNAME, TEST_SHAREDACCESSKEY, TEST_SHAREDACCESSKEYNAME, TEST_MAX_CONNECTIONS);
+    (void)execute_test_request(handle, &statusCode);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(get_time(NULL));
+    STRICT_EXPECTED_CALL(get_difftime(TEST_TIME_VALUE + 3600, TEST_TIME_VALUE))
+        .SetReturn(10.0);
+    STRICT_EXPECTED_CALL(get_difftime(TEST_TIME_VALUE, 0))
+        .SetReturn(1000.0);
+    STRICT_EXPECTED_CALL(SASToken_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, 4600));
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(TEST_HTTP_HEADERS_HANDLE, "Authorization", TEST_SAS_TOKEN));
+    STRICT_EXPECTED_CALL(get_time(NULL));
+    STRICT_EXPECTED_CALL(get_difftime(TEST_TIME_VALUE, TEST_TIME_VALUE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(IGNORED_PTR_ARG, HTTPAPI_REQUEST_GET, TEST_RELATIVE_PATH, TEST_HTTP_HEADERS_HANDLE, NULL, IGNORED_PTR_ARG, NULL, TEST_BUFFER_HANDLE));
+    set_expected_calls_for_release();
+
+    // act
+    HTTPAPIEX_RESULT result = execute_test_request(handle, &statusCode);
+
+    // assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    service_client_http_pool_destroy(handle);
+}
+
+TEST_FUNCTION(service_client_http_pool_execute_request_replaces_connection_idle_for_too_long)
+{
+    // arrange
+    unsigned int statusCode = 0;
+    SERVICE_CLIENT_HTTP_POOL_HANDLE handle = service_client_http_pool_create(TEST_HOSTNAME, TEST_SHAREDACCESSKEY, TEST_SHAREDACCESSKEYNAME, TEST_MAX_CONNECTIONS);
+    (void)execute_test_request(handle, &statusCode);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(get_time(NULL));
+    STRICT_EXPECTED_CALL(get_difftime(TEST_TIME_VALUE + 3600, TEST_TIME_VALUE))
+        .SetReturn(3600.0);
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(TEST_HTTP_HEADERS_HANDLE, "Authorization", TEST_SAS_TOKEN));
+    STRICT_EXPECTED_CALL(get_time(NULL));
+    STRICT_EXPECTED_CALL(get_difftime(TEST_TIME_VALUE, TEST_TIME_VALUE))
+        .SetReturn(120.0);
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Create(TEST_HOSTNAME));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(IGNORED_PTR_ARG, HTTPAPI_REQUEST_GET, TEST_RELATIVE_PATH, TEST_HTTP_HEADERS_HANDLE, NULL, IGNORED_PTR_ARG, NULL, TEST_BUFFER_HANDLE));
+    set_expected_calls_for_release();
+
+    // act
+    HTTPAPIEX_RESULT result = execute_test_request(handle, &statusCode);
+
+    // assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    service_client_http_pool_destroy(handle);
+}
+
+TEST_FUNCTION(service_client_http_pool_execute_request_closes_connection_that_failed)
+{
+    // arrange
+    unsigned int statusCode = 0;
+    SERVICE_CLIENT_HTTP_POOL_HANDLE handle = service_client_http_pool_create(TEST_HOSTNAME, TEST_SHAREDACCESSKEY, TEST_SHAREDACCESSKEYNAME, TEST_MAX_CONNECTIONS);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(get_time(NULL));
+    STRICT_EXPECTED_CALL(get_difftime(TEST_TIME_VALUE, 0));
+    STRICT_EXPECTED_CALL(SASToken_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(STRING_delete(NULL));
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(TEST_HTTP_HEADERS_HANDLE, "Authorization", TEST_SAS_TOKEN));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Create(TEST_HOSTNAME));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(IGNORED_PTR_ARG, HTTPAPI_REQUEST_GET, TEST_RELATIVE_PATH, TEST_HTTP_HEADERS_HANDLE, NULL, IGNORED_PTR_ARG, NULL, TEST_BUFFER_HANDLE))
+        .SetReturn(HTTPAPIEX_RECOVERYFAILED);
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    HTTPAPIEX_RESULT result = execute_test_request(handle, &statusCode);
+
+    // assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_RECOVERYFAILED, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    service_client_http_pool_destroy(handle);
+}
+
+TEST_FUNCTION(service_client_http_pool_execute_request_with_shared_access_signature_does_not_sign)
+{
+    // arrange
+    unsigned int statusCode = 0;
+    SERVICE_CLIENT_HTTP_POOL_HANDLE handle = service_client_http_pool_create(TEST_HOSTNAME, TEST_SHAREDACCESSSIGNATURE, NULL, TEST_MAX_CONNECTIONS);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(TEST_HTTP_HEADERS_HANDLE, "Authorization", TEST_SHAREDACCESSSIGNATURE + 4));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Create(TEST_HOSTNAME));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(IGNORED_PTR_ARG, HTTPAPI_REQUEST_GET, TEST_RELATIVE_PATH, TEST_HTTP_HEADERS_HANDLE, NULL, IGNORED_PTR_ARG, NULL, TEST_BUFFER_HANDLE));
+    set_expected_calls_for_release();
+
+    // act
+    HTTPAPIEX_RESULT result = execute_test_request(handle, &statusCode);
+
+    // assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    service_client_http_pool_destroy(handle);
+}
+
+TEST_FUNCTION(service_client_http_pool_destroy_keeps_the_pool_until_last_reference)
+{
+    // arrange
+    unsigned int statusCode = 0;
+    SERVICE_CLIENT_HTTP_POOL_HANDLE handle = service_client_http_pool_create(TEST_HOSTNAME, TEST_SHAREDACCESSKEY, TEST_SHAREDACCESSKEYNAME, TEST_MAX_CONNECTIONS);
+    SERVICE_CLIENT_HTTP_POOL_HANDLE clone = service_client_http_pool_clone(handle);
+    (void)execute_test_request(handle, &statusCode);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_Destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Condition_Deinit(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    service_client_http_pool_destroy(clone);
+    service_client_http_pool_destroy(handle);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, handle, clone);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+END_TEST_SUITE(iothub_sc_http_pool_ut)
@@ -16,6 +16,7 @@
 #include "azure_c_shared_utility/connection_string_parser.h"
 
 #include "iothub_service_client_auth.h"
+#include "internal/iothub_service_client_http_pool.h"
 
 extern "C" int gballoc_init(void);
 extern "C" void gballoc_deinit(void);
@@ -52,6 +53,8 @@ static MAP_HANDLE TEST_MAP_HANDLE_NULL = (MAP_HANDLE)NULL;
 static STRING_TOKENIZER_HANDLE TEST_STRING_TOKENIZER_HANDLE = (STRING_TOKENIZER_HANDLE)0x4444;
 static STRING_TOKENIZER_HANDLE TEST_STRING_TOKENIZER_HANDLE_NULL = (STRING_TOKENIZER_HANDLE)NULL;
 
+static SERVICE_CLIENT_HTTP_POOL_HANDLE TEST_HTTP_POOL_HANDLE = (SERVICE_CLIENT_HTTP_POOL_HANDLE)0x4747;
+
 static STRING_HANDLE TEST_KEY_STRING_HANDLE = (STRING_HANDLE)0x4545;
 static STRING_HANDLE TEST_VALUE_STRING_HANDLE = (STRING_HANDLE)0x4646;
 
@@ -132,6 +135,12 @@ public:
     /* Connection string parser mock */
     MOCK_STATIC_METHOD_1(, MAP_HANDLE, connectionstringparser_parse, STRING_HANDLE, connectionString)
     MOCK_METHOD_END(MAP_HANDLE, TEST_MAP_HANDLE);
+
+    /* HTTP connection pool mocks */
+    MOCK_STATIC_METHOD_4(, SERVICE_CLIENT_HTTP_POOL_HANDLE, service_client_http_pool_create, const char*, hostname, const char*, sharedAccessKey, const char*, keyName, size_t, maxConnections)
+    MOCK_METHOD_END(SERVICE_CLIENT_HTTP_POOL_HANDLE, TEST_HTTP_POOL_HANDLE);
+    MOCK_STATIC_METHOD_1(, void, service_client_http_pool_destroy, SERVICE_CLIENT_HTTP_POOL_HANDLE, handle)
+    MOCK_VOID_METHOD_END();
 };
 
 
@@ -158,6 +167,9 @@ DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubServiceClientAuthMocks, , void, STRING_TOKEN
 
 DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubServiceClientAuthMocks, , MAP_HANDLE, connectionstringparser_parse, STRING_HANDLE, connectionString);
 
+DECLARE_GLOBAL_MOCK_METHOD_4(CIoTHubServiceClientAuthMocks, , SERVICE_CLIENT_HTTP_POOL_HANDLE, service_client_http_pool_create, const char*, hostname, const char*, sharedAccessKey, const char*, keyName, size_t, maxConnections);
+DECLARE_GLOBAL_MOCK_METHOD_1(CIoTHubServiceClientAuthMocks, , void, service_client_http_pool_destroy, SERVICE_CLIENT_HTTP_POOL_HANDLE, handle);
+
 static void set_expected_calls_for_free_service_client_auth(CIoTHubServiceClientAuthMocks &mocks)
 {
     (void)mocks;
@@ -1547,5 +1559,173 @@ TEST_FUNCTION(IoTHubServiceClient_Destroy_do_clean_up_and_return_if_input_parame
     mocks.AssertActualAndExpectedCalls();
 }
 
+typedef struct IOTHUB_SERVICE_CLIENT_AUTH_INSTANCE_TAG
+{
+    IOTHUB_SERVICE_CLIENT_AUTH auth;
+    SERVICE_CLIENT_HTTP_POOL_HANDLE httpPool;
+} IOTHUB_SERVICE_CLIENT_AUTH_INSTANCE;
+
+static void set_test_service_client_auth(IOTHUB_SERVICE_CLIENT_AUTH_INSTANCE* authInstance)
+{
+    memset(authInstance, 0, sizeof(*authInstance));
+    authInstance->auth.hostname = (char*)"aaa.bbb.net";
+    authInstance->auth.sharedAccessKey = (char*)"yyy";
+    authInstance->auth.keyName = (char*)"xxx";
+}
+
+TEST_FUNCTION(IoTHubServiceClientAuth_EnableConnectionPool_fails_if_serviceClientHandle_is_NULL)
+{
+    // arrange
+    CIoTHubServiceClientAuthMocks mocks;
+
+    // act
+    int result = IoTHubServiceClientAuth_EnableConnectionPool(NULL, 4);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    mocks.AssertActualAndExpectedCalls();
+}
+
+TEST_FUNCTION(IoTHubServiceClientAuth_EnableConnectionPool_fails_if_maxConnections_is_0)
+{
+    // arrange
+    CIoTHubServiceClientAuthMocks mocks;
+    IOTHUB_SERVICE_CLIENT_AUTH_INSTANCE authInstance;
+    set_test_service_client_auth(&authInstance);
+
+    // act
+    int result = IoTHubServiceClientAuth_EnableConnectionPool(&authInstance.auth, 0);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(authInstance.httpPool);
+    mocks.AssertActualAndExpectedCalls();
+}
+
+TEST_FUNCTION(IoTHubServiceClientAuth_EnableConnectionPool_creates_the_pool)
+{
+    // arrange
+    CIoTHubServiceClientAuthMocks mocks;
+    IOTHUB_SERVICE_CLIENT_AUTH_INSTANCE authInstance;
+    set_test_service_client_auth(&authInstance);
+
+    STRICT_EXPECTED_CALL(mocks, service_client_http_pool_create(authInstance.auth.hostname, authInstance.auth.sharedAccessKey, authInstance.auth.keyName, 4));
+
+    // act
+    int result = IoTHubServiceClientAuth_EnableConnectionPool(&authInstance.auth, 4);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_HTTP_POOL_HANDLE, authInstance.httpPool);
+    mocks.AssertActualAndExpectedCalls();
+}
+
+TEST_FUNCTION(IoTHubServiceClientAuth_EnableConnectionPool_fails_if_already_enabled)
+{
+    // arrange
+    CIoTHubServiceClientAuthMocks mocks;
+    IOTHUB_SERVICE_CLIENT_AUTH_INSTANCE authInstance;
+    set_test_service_client_auth(&authInstance);
+    authInstance.httpPool = TEST_HTTP_POOL_HANDLE;
+
+    // act
+    int result = IoTHubServiceClientAuth_EnableConnectionPool(&authInstance.auth, 4);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_HTTP_POOL_HANDLE, authInstance.httpPool);
+    mocks.AssertActualAndExpectedCalls();
+}
+
+TEST_FUNCTION(IoTHubServiceClientAuth_EnableConnectionPool_fails_for_device_scoped_credentials)
+{
+    // arrange
+    CIoTHubServiceClientAuthMocks mocks;
+    IOTHUB_SERVICE_CLIENT_AUTH_INSTANCE authInstance;
+    set_test_service_client_auth(&authInstance);
+    authInstance.auth.keyName = NULL;
+    authInstance.auth.deviceId = (char*)"theDeviceId";
+
+    // act
+    int result = IoTHubServiceClientAuth_EnableConnectionPool(&authInstance.auth, 4);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(authInstance.httpPool);
+    mocks.AssertActualAndExpectedCalls();
+}
+
+TEST_FUNCTION(IoTHubServiceClientAuth_EnableConnectionPool_fails_if_pool_create_fails)
+{
+    // arrange
+    CIoTHubServiceClientAuthMocks mocks;
+    IOTHUB_SERVICE_CLIENT_AUTH_INSTANCE authInstance;
+    set_test_service_client_auth(&authInstance);
+
+    STRICT_EXPECTED_CALL(mocks, service_client_http_pool_create(authInstance.auth.hostname, authInstance.auth.sharedAccessKey, authInstance.auth.keyName, 4))
+        .SetReturn((SERVICE_CLIENT_HTTP_POOL_HANDLE)NULL);
+
+    // act
+    int result = IoTHubServiceClientAuth_EnableConnectionPool(&authInstance.auth, 4);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(authInstance.httpPool);
+    mocks.AssertActualAndExpectedCalls();
+}
+
+TEST_FUNCTION(IoTHubServiceClient_Destroy_releases_the_connection_pool)
+{
+    // arrange
+    CIoTHubServiceClientAuthMocks mocks;
+    IOTHUB_SERVICE_CLIENT_AUTH_INSTANCE* authInstance = (IOTHUB_SERVICE_CLIENT_AUTH_INSTANCE*)BASEIMPLEMENTATION::gballoc_malloc(sizeof(IOTHUB_SERVICE_CLIENT_AUTH_INSTANCE));
+    memset(authInstance, 0, sizeof(*authInstance));
+    authInstance->httpPool = TEST_HTTP_POOL_HANDLE;
+
+    STRICT_EXPECTED_CALL(mocks, gballoc_free(NULL));
+    STRICT_EXPECTED_CALL(mocks, gballoc_free(NULL));
+    STRICT_EXPECTED_CALL(mocks, gballoc_free(NULL));
+    STRICT_EXPECTED_CALL(mocks, gballoc_free(NULL));
+    STRICT_EXPECTED_CALL(mocks, gballoc_free(NULL));
+    STRICT_EXPECTED_CALL(mocks, gballoc_free(NULL));
+    STRICT_EXPECTED_CALL(mocks, service_client_http_pool_destroy(TEST_HTTP_POOL_HANDLE));
+    STRICT_EXPECTED_CALL(mocks, gballoc_free(authInstance));
+
+    // act
+    IoTHubServiceClientAuth_Destroy(&authInstance->auth);
+
+    // assert
+    mocks.AssertActualAndExpectedCalls();
+}
+
+TEST_FUNCTION(service_client_auth_get_http_pool_returns_NULL_if_serviceClientHandle_is_NULL)
+{
+    // arrange
+    CIoTHubServiceClientAuthMocks mocks;
+
+    // act
+    SERVICE_CLIENT_HTTP_POOL_HANDLE result = service_client_auth_get_http_pool(NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    mocks.AssertActualAndExpectedCalls();
+}
+
+TEST_FUNCTION(service_client_auth_get_http_pool_returns_the_enabled_pool)
+{
+    // arrange
+    CIoTHubServiceClientAuthMocks mocks;
+    IOTHUB_SERVICE_CLIENT_AUTH_INSTANCE authInstance;
+    set_test_service_client_auth(&authInstance);
+    authInstance.httpPool = TEST_HTTP_POOL_HANDLE;
+
+    // act
+    SERVICE_CLIENT_HTTP_POOL_HANDLE result = service_client_auth_get_http_pool(&authInstance.auth);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_HTTP_POOL_HANDLE, result);
+    mocks.AssertActualAndExpectedCalls();
+}
+
 END_TEST_SUITE(iothub_service_client_auth_ut)
 
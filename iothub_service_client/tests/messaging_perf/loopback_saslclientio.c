@@ -0,0 +1,254 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// AMQP stand-in for IoT Hub.  IoTHubMessaging_LL_Open layers the AMQP connection on a SASL IO; this file defines
+// saslclientio_get_interface_description so that IO is a loopback (see loopback_io.h) to a uAMQP listener instead.
+// The TLS IO handed to it is created but never opened, and no SASL exchange takes place.  The listener settles every
+// cloud-to-device message as accepted and attaches the feedback link without ever sending on it.
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_uamqp_c/connection.h"
+#include "azure_uamqp_c/session.h"
+#include "azure_uamqp_c/link.h"
+#include "azure_uamqp_c/message_receiver.h"
+#include "azure_uamqp_c/message_sender.h"
+#include "azure_uamqp_c/messaging.h"
+#include "azure_uamqp_c/saslclientio.h"
+
+#include "loopback_io.h"
+
+#define MAX_SESSIONS                2
+#define MAX_LINKS                   4
+#define SESSION_INCOMING_WINDOW     2147483647
+
+typedef struct LOOPBACK_AMQP_BROKER_TAG
+{
+    XIO_HANDLE io;
+    CONNECTION_HANDLE connection;
+    SESSION_HANDLE sessions[MAX_SESSIONS];
+    size_t session_count;
+    LINK_HANDLE links[MAX_LINKS];
+    MESSAGE_RECEIVER_HANDLE receivers[MAX_LINKS];
+    MESSAGE_SENDER_HANDLE senders[MAX_LINKS];
+    size_t link_count;
+} LOOPBACK_AMQP_BROKER;
+
+static AMQP_VALUE on_message_received(const void* context, MESSAGE_HANDLE message)
+{
+    (void)context;
+    (void)message;
+    return messaging_delivery_accepted();
+}
+
+static bool on_link_attached(void* context, LINK_ENDPOINT_HANDLE new_link_endpoint, const char* name, role role, AMQP_VALUE source, AMQP_VALUE target, fields properties)
+{
+    bool result;
+    LOOPBACK_AMQP_BROKER* broker = (LOOPBACK_AMQP_BROKER*)context;
+    LINK_HANDLE link;
+
+    (void)properties;
+
+    if (broker->link_count == MAX_LINKS || broker->session_count == 0)
+    {
+        LogError("AMQP stand-in refused link %s", name);
+        result = false;
+    }
+    // role is the one of the client; the stand-in takes the other end of the link.
+    else if ((link = link_create_from_endpoint(broker->sessions[broker->session_count - 1], new_link_endpoint, name, (role == role_sender) ? role_receiver : role_sender, source, target)) == NULL)
+    {
+        LogError("AMQP stand-in failed creating link %s", name);
+        result = false;
+    }
+    else if (role == role_sender)
+    {
+        MESSAGE_RECEIVER_HANDLE receiver;
+
+        if ((receiver = messagereceiver_create(link, NULL, NULL)) == NULL)
+        {
+            LogError("AMQP stand-in failed creating the receiver for link %s", name);
+            link_destroy(link);
+            result = false;
+        }
+        else if (messagereceiver_open(receiver, on_message_received, broker) != 0)
+        {
+            LogError("AMQP stand-in failed opening the receiver for link %s", name);
+            messagereceiver_destroy(receiver);
+            link_destroy(link);
+            result = false;
+        }
+        else
+        {
+            broker->links[broker->link_count] = link;
+            broker->receivers[broker->link_count] = receiver;
+            broker->senders[broker->link_count] = NULL;
+            broker->link_count++;
+            result = true;
+        }
+    }
+    else
+    {
+        MESSAGE_SENDER_HANDLE sender;
+
+        if ((sender = messagesender_create(link, NULL, NULL)) == NULL)
+        {
+            LogError("AMQP stand-in failed creating the sender for link %s", name);
+            link_destroy(link);
+            result = false;
+        }
+        else if (messagesender_open(sender) != 0)
+        {
+            LogError("AMQP stand-in failed opening the sender for link %s", name);
+            messagesender_destroy(sender);
+            link_destroy(link);
+            result = false;
+        }
+        else
+        {
+            broker->links[broker->link_count] = link;
+            broker->receivers[broker->link_count] = NULL;
+            broker->senders[broker->link_count] = sender;
+            broker->link_count++;
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+static bool on_new_endpoint(void* context, ENDPOINT_HANDLE new_endpoint)
+{
+    bool result;
+    LOOPBACK_AMQP_BROKER* broker = (LOOPBACK_AMQP_BROKER*)context;
+    SESSION_HANDLE session;
+
+    if (broker->session_count == MAX_SESSIONS)
+    {
+        LogError("AMQP stand-in refused a session");
+        result = false;
+    }
+    else if ((session = session_create_from_endpoint(broker->connection, new_endpoint, on_link_attached, broker)) == NULL)
+    {
+        LogError("AMQP stand-in failed creating a session");
+        result = false;
+    }
+    else if (session_set_incoming_window(session, SESSION_INCOMING_WINDOW) != 0 ||
+        session_begin(session) != 0)
+    {
+        LogError("AMQP stand-in failed beginning a session");
+        session_destroy(session);
+        result = false;
+    }
+    else
+    {
+        broker->sessions[broker->session_count] = session;
+        broker->session_count++;
+        result = true;
+    }
+
+    return result;
+}
+
+static void loopback_amqp_broker_destroy(void* broker)
+{
+    LOOPBACK_AMQP_BROKER* instance = (LOOPBACK_AMQP_BROKER*)broker;
+    size_t i;
+
+    for (i = 0; i < instance->link_count; i++)
+    {
+        if (instance->receivers[i] != NULL)
+        {
+            messagereceiver_destroy(instance->receivers[i]);
+        }
+
+        if (instance->senders[i] != NULL)
+        {
+            messagesender_destroy(instance->senders[i]);
+        }
+
+        link_destroy(instance->links[i]);
+    }
+
+    for (i = 0; i < instance->session_count; i++)
+    {
+        session_destroy(instance->sessions[i]);
+    }
+
+    if (instance->connection != NULL)
+    {
+        connection_destroy(instance->connection);
+    }
+
+    xio_destroy(instance->io);
+    free(instance);
+}
+
+static void* loopback_amqp_broker_create(XIO_HANDLE broker_io)
+{
+    LOOPBACK_AMQP_BROKER* result;
+
+    if ((result = (LOOPBACK_AMQP_BROKER*)calloc(1, sizeof(LOOPBACK_AMQP_BROKER))) == NULL)
+    {
+        LogError("Failed allocating the AMQP stand-in");
+    }
+    else
+    {
+        result->io = broker_io;
+
+        if ((result->connection = connection_create(broker_io, NULL, "loopback", on_new_endpoint, result)) == NULL)
+        {
+            LogError("AMQP stand-in failed creating its connection");
+            loopback_amqp_broker_destroy(result);
+            result = NULL;
+        }
+        else if (connection_listen(result->connection) != 0)
+        {
+            LogError("AMQP stand-in failed listening on its end of the loopback");
+            loopback_amqp_broker_destroy(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+static void loopback_amqp_broker_dowork(void* broker)
+{
+    LOOPBACK_AMQP_BROKER* instance = (LOOPBACK_AMQP_BROKER*)broker;
+
+    /* Also does the work of the broker end of the IO. */
+    connection_dowork(instance->connection);
+}
+
+static const LOOPBACK_BROKER_INTERFACE loopback_amqp_broker_interface =
+{
+    loopback_amqp_broker_create,
+    loopback_amqp_broker_destroy,
+    loopback_amqp_broker_dowork
+};
+
+static IO_INTERFACE_DESCRIPTION loopback_saslclientio_interface_description;
+
+static CONCRETE_IO_HANDLE loopback_saslclientio_create(void* io_create_parameters)
+{
+    LOOPBACK_IO_CONFIG config;
+
+    /* The SASLCLIENTIO_CONFIG, and the TLS IO in it, are left alone; IoTHubMessaging_LL destroys them itself. */
+    (void)io_create_parameters;
+
+    config.broker_interface = &loopback_amqp_broker_interface;
+    config.peer = NULL;
+
+    return loopback_io_get_interface_description()->concrete_io_create(&config);
+}
+
+const IO_INTERFACE_DESCRIPTION* saslclientio_get_interface_description(void)
+{
+    /* Same IO as the loopback, only creating it also names the AMQP stand-in as the broker. */
+    loopback_saslclientio_interface_description = *loopback_io_get_interface_description();
+    loopback_saslclientio_interface_description.concrete_io_create = loopback_saslclientio_create;
+    return &loopback_saslclientio_interface_description;
+}
@@ -0,0 +1,340 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// Measures a cloud-to-device broadcast through IoTHubMessaging_LL against an in-process AMQP stand-in of the hub (see
+// loopback_saslclientio.c), so no network or IoT Hub is needed and runs are reproducible.  The messaging client and
+// uAMQP are the real ones; only the IO under the AMQP connection is replaced.  The same message is sent to every
+// device in two ways:
+//     send         IoTHubMessaging_LL_Send in a loop, encoding the message once per device
+//     send_batch   IoTHubMessaging_LL_SendBatch, encoding the message once for the whole broadcast
+// Both keep up to send_window messages in flight and call IoTHubMessaging_LL_DoWork whenever the window is full.
+//
+// Output is CSV on stdout, one line per mode:
+//     mode,devices,send_window,elapsed_ms,messages_per_sec,sent,failed,peak_in_flight
+//
+// Usage: messaging_perf [devices [send_window [payload_size]]]
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "azure_c_shared_utility/platform.h"
+#include "iothub_service_client_auth.h"
+#include "iothub_messaging_ll.h"
+
+static const size_t DEFAULT_DEVICES = 100000;
+static const size_t DEFAULT_SEND_WINDOW = 1000;
+static const size_t DEFAULT_PAYLOAD_SIZE = 256;
+
+static const char* CONNECTION_STRING = "HostName=loopback.azure-devices.net;SharedAccessKeyName=iothubowner;SharedAccessKey=AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA=";
+
+// Gives up on a run that stops making progress, e.g. if the stand-in stops granting credit.
+#define MAX_IDLE_DOWORK_CALLS 100000
+
+typedef struct BENCHMARK_RESULT_TAG
+{
+    uint64_t elapsedMs;
+    IOTHUB_MESSAGING_SEND_STATISTICS statistics;
+} BENCHMARK_RESULT;
+
+static uint64_t get_time_us(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+    (void)QueryPerformanceCounter(&counter);
+    (void)QueryPerformanceFrequency(&frequency);
+    return (uint64_t)((counter.QuadPart * 1000000.0) / frequency.QuadPart);
+#else
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000) + ((uint64_t)now.tv_nsec / 1000);
+#endif
+}
+
+// Runs DoWork until at least one message settles, so the window has room again.
+static int wait_for_window(IOTHUB_MESSAGING_HANDLE messaging)
+{
+    int result = __LINE__;
+    size_t idle;
+    IOTHUB_MESSAGING_SEND_STATISTICS statistics;
+
+    for (idle = 0; idle < MAX_IDLE_DOWORK_CALLS; idle++)
+    {
+        IoTHubMessaging_LL_DoWork(messaging);
+
+        if (IoTHubMessaging_LL_GetSendStatistics(messaging, &statistics) == IOTHUB_MESSAGING_OK && statistics.sendWindow > 0)
+        {
+            result = 0;
+            break;
+        }
+    }
+
+    return result;
+}
+
+static int wait_for_all_settled(IOTHUB_MESSAGING_HANDLE messaging)
+{
+    int result = __LINE__;
+    size_t idle;
+    IOTHUB_MESSAGING_SEND_STATISTICS statistics;
+
+    for (idle = 0; idle < MAX_IDLE_DOWORK_CALLS; idle++)
+    {
+        IoTHubMessaging_LL_DoWork(messaging);
+
+        if (IoTHubMessaging_LL_GetSendStatistics(messaging, &statistics) == IOTHUB_MESSAGING_OK && statistics.inFlight == 0)
+        {
+            result = 0;
+            break;
+        }
+    }
+
+    return result;
+}
+
+static int run_send(IOTHUB_MESSAGING_HANDLE messaging, const char* const* device_ids, size_t devices, IOTHUB_MESSAGE_HANDLE message)
+{
+    int result = 0;
+    size_t i = 0;
+
+    while (result == 0 && i < devices)
+    {
+        IOTHUB_MESSAGING_RESULT send_result = IoTHubMessaging_LL_Send(messaging, device_ids[i], message, NULL, NULL);
+
+        if (send_result == IOTHUB_MESSAGING_OK)
+        {
+            i++;
+        }
+        else if (send_result == IOTHUB_MESSAGING_QUEUE_FULL)
+        {
+            result = wait_for_window(messaging);
+        }
+        else
+        {
+            (void)printf("IoTHubMessaging_LL_Send failed for device %lu\r\n", (unsigned long)i);
+            result = __LINE__;
+        }
+    }
+
+    return result;
+}
+
+static int run_send_batch(IOTHUB_MESSAGING_HANDLE messaging, const IOTHUB_MESSAGING_BATCH_ITEM* items, size_t devices)
+{
+    int result = 0;
+    size_t i = 0;
+
+    while (result == 0 && i < devices)
+    {
+        size_t items_queued = 0;
+        IOTHUB_MESSAGING_RESULT send_result = IoTHubMessaging_LL_SendBatch(messaging, &items[i], devices - i, &items_queued);
+
+        if (send_result == IOTHUB_MESSAGING_OK)
+        {
+            i = devices;
+        }
+        else if (send_result == IOTHUB_MESSAGING_QUEUE_FULL)
+        {
+            i += items_queued;
+            result = wait_for_window(messaging);
+        }
+        else
+        {
+            (void)printf("IoTHubMessaging_LL_SendBatch failed for device %lu\r\n", (unsigned long)(i + items_queued));
+            result = __LINE__;
+        }
+    }
+
+    return result;
+}
+
+static int run_mode(IOTHUB_SERVICE_CLIENT_AUTH_HANDLE service_client, bool batched, const char* const* device_ids, const IOTHUB_MESSAGING_BATCH_ITEM* items, size_t devices, size_t send_window, IOTHUB_MESSAGE_HANDLE message, BENCHMARK_RESULT* benchmark_result)
+{
+    int result;
+    IOTHUB_MESSAGING_HANDLE messaging;
+
+    if ((messaging = IoTHubMessaging_LL_Create(service_client)) == NULL)
+    {
+        (void)printf("Unable to create the messaging client\r\n");
+        result = __LINE__;
+    }
+    else
+    {
+        if (IoTHubMessaging_LL_SetMaxSendQueueSize(messaging, send_window) != IOTHUB_MESSAGING_OK)
+        {
+            (void)printf("Unable to set the send window\r\n");
+            result = __LINE__;
+        }
+        else if (IoTHubMessaging_LL_Open(messaging, NULL, NULL) != IOTHUB_MESSAGING_OK)
+        {
+            (void)printf("Unable to open the messaging client\r\n");
+            result = __LINE__;
+        }
+        else
+        {
+            uint64_t start_us = get_time_us();
+
+            if ((result = batched ? run_send_batch(messaging, items, devices) : run_send(messaging, device_ids, devices, message)) == 0 &&
+                (result = wait_for_all_settled(messaging)) != 0)
+            {
+                (void)printf("Messages did not settle\r\n");
+            }
+
+            benchmark_result->elapsedMs = (get_time_us() - start_us) / 1000;
+            (void)IoTHubMessaging_LL_GetSendStatistics(messaging, &benchmark_result->statistics);
+
+            IoTHubMessaging_LL_Close(messaging);
+        }
+
+        IoTHubMessaging_LL_Destroy(messaging);
+    }
+
+    return result;
+}
+
+static void print_result(const char* mode, size_t devices, size_t send_window, const BENCHMARK_RESULT* benchmark_result)
+{
+    (void)printf("%s,%lu,%lu,%lu,%.1f,%lu,%lu,%lu\r\n",
+        mode,
+        (unsigned long)devices,
+        (unsigned long)send_window,
+        (unsigned long)benchmark_result->elapsedMs,
+        (benchmark_result->elapsedMs > 0) ? (benchmark_result->statistics.messagesSent * 1000.0) / benchmark_result->elapsedMs : 0.0,
+        (unsigned long)benchmark_result->statistics.messagesSent,
+        (unsigned long)benchmark_result->statistics.messagesFailed,
+        (unsigned long)benchmark_result->statistics.peakInFlight);
+}
+
+static int run_benchmarks(const char* const* device_ids, size_t devices, size_t send_window, size_t payload_size)
+{
+    int result;
+    IOTHUB_SERVICE_CLIENT_AUTH_HANDLE service_client;
+    unsigned char* payload;
+
+    if ((payload = (unsigned char*)malloc(payload_size)) == NULL)
+    {
+        (void)printf("Unable to allocate the payload\r\n");
+        result = __LINE__;
+    }
+    else if ((service_client = IoTHubServiceClientAuth_CreateFromConnectionString(CONNECTION_STRING)) == NULL)
+    {
+        (void)printf("Unable to create the service client\r\n");
+        free(payload);
+        result = __LINE__;
+    }
+    else
+    {
+        IOTHUB_MESSAGE_HANDLE message;
+        IOTHUB_MESSAGING_BATCH_ITEM* items;
+
+        (void)memset(payload, 'x', payload_size);
+
+        if ((message = IoTHubMessage_CreateFromByteArray(payload, payload_size)) == NULL)
+        {
+            (void)printf("Unable to create the message\r\n");
+            result = __LINE__;
+        }
+        else
+        {
+            if ((items = (IOTHUB_MESSAGING_BATCH_ITEM*)malloc(sizeof(IOTHUB_MESSAGING_BATCH_ITEM) * devices)) == NULL)
+            {
+                (void)printf("Unable to allocate the batch\r\n");
+                result = __LINE__;
+            }
+            else
+            {
+                BENCHMARK_RESULT benchmark_result;
+                size_t i;
+
+                for (i = 0; i < devices; i++)
+                {
+                    items[i].deviceId = device_ids[i];
+                    items[i].message = message;
+                    items[i].sendCompleteCallback = NULL;
+                    items[i].userContextCallback = NULL;
+                }
+
+                (void)printf("mode,devices,send_window,elapsed_ms,messages_per_sec,sent,failed,peak_in_flight\r\n");
+
+                if ((result = run_mode(service_client, false, device_ids, items, devices, send_window, message, &benchmark_result)) == 0)
+                {
+                    print_result("send", devices, send_window, &benchmark_result);
+                }
+
+                if (result == 0 && (result = run_mode(service_client, true, device_ids, items, devices, send_window, message, &benchmark_result)) == 0)
+                {
+                    print_result("send_batch", devices, send_window, &benchmark_result);
+                }
+
+                free(items);
+            }
+
+            IoTHubMessage_Destroy(message);
+        }
+
+        IoTHubServiceClientAuth_Destroy(service_client);
+        free(payload);
+    }
+
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    int result;
+    long devices = (argc > 1) ? atol(argv[1]) : (long)DEFAULT_DEVICES;
+    long send_window = (argc > 2) ? atol(argv[2]) : (long)DEFAULT_SEND_WINDOW;
+    long payload_size = (argc > 3) ? atol(argv[3]) : (long)DEFAULT_PAYLOAD_SIZE;
+
+    if (devices <= 0 || send_window <= 0 || payload_size <= 0)
+    {
+        (void)printf("usage: messaging_perf [devices [send_window [payload_size]]]\r\n");
+        result = EXIT_FAILURE;
+    }
+    else if (platform_init() != 0)
+    {
+        (void)printf("platform_init failed\r\n");
+        result = EXIT_FAILURE;
+    }
+    else
+    {
+        char* names;
+        const char** device_ids;
+
+        if ((names = (char*)malloc((size_t)devices * 16)) == NULL || (device_ids = (const char**)malloc(sizeof(const char*) * (size_t)devices)) == NULL)
+        {
+            (void)printf("Unable to allocate %ld device ids\r\n", devices);
+            free(names);
+            result = EXIT_FAILURE;
+        }
+        else
+        {
+            long i;
+
+            for (i = 0; i < devices; i++)
+            {
+                (void)sprintf(&names[i * 16], "device%ld", i);
+                device_ids[i] = &names[i * 16];
+            }
+
+            result = (run_benchmarks(device_ids, (size_t)devices, (size_t)send_window, (size_t)payload_size) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+            free((void*)device_ids);
+            free(names);
+        }
+
+        platform_deinit();
+    }
+
+    return result;
+}
@@ -0,0 +1,257 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// Measures device onboarding through the registry manager against an in-process stand-in of the hub (see
+// loopback_httpapi.c), so no network or IoT Hub is needed and runs are reproducible.  The service client is the real
+// one; only the HTTPAPI adapter is replaced, and it waits request_latency_ms before answering to stand for the round
+// trip to the hub.  Three ways of creating the same devices are compared:
+//     create_device   IoTHubRegistryManager_CreateDevice_Ex in a loop, one request and one connection per device
+//     bulk_1          IoTHubRegistryManager_BulkOperation with a single batch in flight
+//     bulk            IoTHubRegistryManager_BulkOperation with up to max_concurrency batches in flight
+//
+// Output is CSV on stdout, one line per mode:
+//     mode,devices,max_concurrency,request_latency_ms,elapsed_ms,devices_per_sec,failed
+//
+// Usage: registrymanager_perf [devices [max_concurrency [request_latency_ms]]]
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "azure_c_shared_utility/platform.h"
+#include "iothub_service_client_auth.h"
+#include "iothub_registrymanager.h"
+
+// Defined by loopback_httpapi.c.
+extern unsigned int loopback_httpapi_request_latency_ms;
+
+static const size_t DEFAULT_DEVICES = 1000;
+static const size_t DEFAULT_MAX_CONCURRENCY = 8;
+static const unsigned int DEFAULT_REQUEST_LATENCY_MS = 5;
+
+static const char* CONNECTION_STRING = "HostName=loopback.azure-devices.net;SharedAccessKeyName=iothubowner;SharedAccessKey=AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA=";
+static const char* PRIMARY_KEY = "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA=";
+static const char* SECONDARY_KEY = "BBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBB=";
+
+typedef struct BENCHMARK_RESULT_TAG
+{
+    uint64_t elapsedMs;
+    size_t failed;
+} BENCHMARK_RESULT;
+
+static uint64_t get_time_us(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+    (void)QueryPerformanceCounter(&counter);
+    (void)QueryPerformanceFrequency(&frequency);
+    return (uint64_t)((counter.QuadPart * 1000000.0) / frequency.QuadPart);
+#else
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000) + ((uint64_t)now.tv_nsec / 1000);
+#endif
+}
+
+static void run_create_device(IOTHUB_REGISTRYMANAGER_HANDLE registry_manager, const char* const* device_ids, size_t devices, BENCHMARK_RESULT* benchmark_result)
+{
+    uint64_t start_us = get_time_us();
+    size_t i;
+
+    benchmark_result->failed = 0;
+
+    for (i = 0; i < devices; i++)
+    {
+        IOTHUB_REGISTRY_DEVICE_CREATE_EX device_create;
+        IOTHUB_DEVICE_EX device;
+
+        (void)memset(&device_create, 0, sizeof(device_create));
+        device_create.version = IOTHUB_REGISTRY_DEVICE_CREATE_EX_VERSION_1;
+        device_create.deviceId = device_ids[i];
+        device_create.primaryKey = PRIMARY_KEY;
+        device_create.secondaryKey = SECONDARY_KEY;
+        device_create.authMethod = IOTHUB_REGISTRYMANAGER_AUTH_SPK;
+
+        (void)memset(&device, 0, sizeof(device));
+        device.version = IOTHUB_DEVICE_EX_VERSION_1;
+
+        if (IoTHubRegistryManager_CreateDevice_Ex(registry_manager, &device_create, &device) != IOTHUB_REGISTRYMANAGER_OK)
+        {
+            benchmark_result->failed++;
+        }
+
+        IoTHubRegistryManager_FreeDeviceExMembers(&device);
+    }
+
+    benchmark_result->elapsedMs = (get_time_us() - start_us) / 1000;
+}
+
+static int run_bulk(IOTHUB_REGISTRYMANAGER_HANDLE registry_manager, const char* const* device_ids, size_t devices, size_t max_concurrency, BENCHMARK_RESULT* benchmark_result)
+{
+    int result;
+    IOTHUB_REGISTRY_BULK_OPERATION* operations;
+    IOTHUB_REGISTRYMANAGER_RESULT* operation_results = NULL;
+
+    if ((operations = (IOTHUB_REGISTRY_BULK_OPERATION*)calloc(devices, sizeof(IOTHUB_REGISTRY_BULK_OPERATION))) == NULL ||
+        (operation_results = (IOTHUB_REGISTRYMANAGER_RESULT*)calloc(devices, sizeof(IOTHUB_REGISTRYMANAGER_RESULT))) == NULL)
+    {
+        (void)printf("Unable to allocate the bulk operations\r\n");
+        result = __LINE__;
+    }
+    else
+    {
+        uint64_t start_us;
+        size_t i;
+
+        for (i = 0; i < devices; i++)
+        {
+            operations[i].version = IOTHUB_REGISTRY_BULK_OPERATION_VERSION_1;
+            operations[i].mode = IOTHUB_REGISTRY_BULK_OPERATION_CREATE;
+            operations[i].deviceId = device_ids[i];
+            operations[i].primaryKey = PRIMARY_KEY;
+            operations[i].secondaryKey = SECONDARY_KEY;
+            operations[i].authMethod = IOTHUB_REGISTRYMANAGER_AUTH_SPK;
+            operations[i].status = IOTHUB_DEVICE_STATUS_ENABLED;
+        }
+
+        start_us = get_time_us();
+        (void)IoTHubRegistryManager_BulkOperation(registry_manager, operations, devices, max_concurrency, operation_results);
+        benchmark_result->elapsedMs = (get_time_us() - start_us) / 1000;
+
+        benchmark_result->failed = 0;
+        for (i = 0; i < devices; i++)
+        {
+            if (operation_results[i] != IOTHUB_REGISTRYMANAGER_OK)
+            {
+                benchmark_result->failed++;
+            }
+        }
+
+        result = 0;
+    }
+
+    free(operation_results);
+    free(operations);
+
+    return result;
+}
+
+static void print_result(const char* mode, size_t devices, size_t max_concurrency, const BENCHMARK_RESULT* benchmark_result)
+{
+    (void)printf("%s,%lu,%lu,%u,%lu,%.1f,%lu\r\n",
+        mode,
+        (unsigned long)devices,
+        (unsigned long)max_concurrency,
+        loopback_httpapi_request_latency_ms,
+        (unsigned long)benchmark_result->elapsedMs,
+        (benchmark_result->elapsedMs > 0) ? (devices * 1000.0) / benchmark_result->elapsedMs : 0.0,
+        (unsigned long)benchmark_result->failed);
+}
+
+static int run_benchmarks(const char* const* device_ids, size_t devices, size_t max_concurrency)
+{
+    int result;
+    IOTHUB_SERVICE_CLIENT_AUTH_HANDLE service_client;
+
+    if ((service_client = IoTHubServiceClientAuth_CreateFromConnectionString(CONNECTION_STRING)) == NULL)
+    {
+        (void)printf("Unable to create the service client\r\n");
+        result = __LINE__;
+    }
+    else
+    {
+        IOTHUB_REGISTRYMANAGER_HANDLE registry_manager;
+
+        if ((registry_manager = IoTHubRegistryManager_Create(service_client)) == NULL)
+        {
+            (void)printf("Unable to create the registry manager\r\n");
+            result = __LINE__;
+        }
+        else
+        {
+            BENCHMARK_RESULT benchmark_result;
+
+            (void)printf("mode,devices,max_concurrency,request_latency_ms,elapsed_ms,devices_per_sec,failed\r\n");
+
+            run_create_device(registry_manager, device_ids, devices, &benchmark_result);
+            print_result("create_device", devices, 1, &benchmark_result);
+
+            if ((result = run_bulk(registry_manager, device_ids, devices, 1, &benchmark_result)) == 0)
+            {
+                print_result("bulk_1", devices, 1, &benchmark_result);
+            }
+
+            if (result == 0 && (result = run_bulk(registry_manager, device_ids, devices, max_concurrency, &benchmark_result)) == 0)
+            {
+                print_result("bulk", devices, max_concurrency, &benchmark_result);
+            }
+
+            IoTHubRegistryManager_Destroy(registry_manager);
+        }
+
+        IoTHubServiceClientAuth_Destroy(service_client);
+    }
+
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    int result;
+    long devices = (argc > 1) ? atol(argv[1]) : (long)DEFAULT_DEVICES;
+    long max_concurrency = (argc > 2) ? atol(argv[2]) : (long)DEFAULT_MAX_CONCURRENCY;
+    long request_latency_ms = (argc > 3) ? atol(argv[3]) : (long)DEFAULT_REQUEST_LATENCY_MS;
+
+    if (devices <= 0 || max_concurrency <= 0 || request_latency_ms < 0)
+    {
+        (void)printf("usage: registrymanager_perf [devices [max_concurrency [request_latency_ms]]]\r\n");
+        result = EXIT_FAILURE;
+    }
+    else if (platform_init() != 0)
+    {
+        (void)printf("platform_init failed\r\n");
+        result = EXIT_FAILURE;
+    }
+    else
+    {
+        char* names;
+        const char** device_ids;
+
+        loopback_httpapi_request_latency_ms = (unsigned int)request_latency_ms;
+
+        if ((names = (char*)malloc((size_t)devices * 16)) == NULL || (device_ids = (const char**)malloc(sizeof(const char*) * (size_t)devices)) == NULL)
+        {
+            (void)printf("Unable to allocate %ld device ids\r\n", devices);
+            free(names);
+            result = EXIT_FAILURE;
+        }
+        else
+        {
+            long i;
+
+            for (i = 0; i < devices; i++)
+            {
+                (void)sprintf(&names[i * 16], "device%ld", i);
+                device_ids[i] = &names[i * 16];
+            }
+
+            result = (run_benchmarks(device_ids, (size_t)devices, (size_t)max_concurrency) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+            free((void*)device_ids);
+            free(names);
+        }
+
+        platform_deinit();
+    }
+
+    return result;
+}
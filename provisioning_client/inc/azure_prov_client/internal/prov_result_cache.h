@@ -0,0 +1,28 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef PROV_RESULT_CACHE_H
+#define PROV_RESULT_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#include <cstddef>
+#else
+#include <stddef.h>
+#endif /* __cplusplus */
+
+#include "umock_c/umock_c_prod.h"
+
+// Keeps the hub and device id a registration was assigned in a file, with a digest over the entry so a truncated or
+// corrupted file is ignored instead of sending the device to the wrong hub.  The digest is a corruption check, not a
+// signature: the file must be protected like the other device settings.  An entry is only returned for the scope and
+// registration id it was saved for.  iothub_uri and device_id are allocated by load and freed by the caller.
+MOCKABLE_FUNCTION(, int, prov_result_cache_load, const char*, cache_path, const char*, scope_id, const char*, registration_id, char**, iothub_uri, char**, device_id);
+MOCKABLE_FUNCTION(, int, prov_result_cache_save, const char*, cache_path, const char*, scope_id, const char*, registration_id, const char*, iothub_uri, const char*, device_id);
+MOCKABLE_FUNCTION(, int, prov_result_cache_clear, const char*, cache_path);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif // PROV_RESULT_CACHE_H
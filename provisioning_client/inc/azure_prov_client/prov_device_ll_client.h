@@ -50,6 +50,10 @@ MU_DEFINE_ENUM_WITHOUT_INVALID(PROV_DEVICE_REG_STATUS, PROV_DEVICE_REG_STATUS_VA
 static STATIC_VAR_UNUSED const char* const PROV_REGISTRATION_ID = "registration_id";
 static STATIC_VAR_UNUSED const char* const PROV_OPTION_LOG_TRACE = "logtrace";
 static STATIC_VAR_UNUSED const char* const PROV_OPTION_TIMEOUT = "provisioning_timeout";
+// uint8_t percentage, 0 to 100: a random delay of up to this share of the retry interval the service asks for is added to each wait
+static STATIC_VAR_UNUSED const char* const PROV_OPTION_RETRY_JITTER = "retry_jitter";
+// const char* file path, or NULL to turn the cache off: the assigned hub and device id are kept in this file and later registrations use them without contacting the service
+static STATIC_VAR_UNUSED const char* const PROV_OPTION_RESULT_CACHE = "result_cache";
 
 #ifndef OPTION_X509_CERT_DEF
 #define OPTION_X509_CERT_DEF
@@ -145,6 +149,17 @@ MOCKABLE_FUNCTION(, PROV_DEVICE_RESULT, Prov_Device_LL_Set_Provisioning_Payload,
 */
 MOCKABLE_FUNCTION(, const char*, Prov_Device_LL_Get_Provisioning_Payload, PROV_DEVICE_LL_HANDLE, handle);
 
+/**
+* @brief    Removes the result kept by PROV_OPTION_RESULT_CACHE, so the next call to Prov_Device_LL_Register_Device
+*           registers with the Device Provisioning Service.  Call this when IoT Hub rejects the cached identity.
+*           TPM devices are never served from the cache.
+*
+* @param    handle          The handle created by a call to the create function.
+*
+* @return PROV_DEVICE_RESULT_OK upon success or an error code upon failure
+*/
+MOCKABLE_FUNCTION(, PROV_DEVICE_RESULT, Prov_Device_LL_Invalidate_Cached_Result, PROV_DEVICE_LL_HANDLE, handle);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
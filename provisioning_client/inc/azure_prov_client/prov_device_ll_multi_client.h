@@ -0,0 +1,118 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file prov_device_ll_multi_client.h
+*   @brief Low level driver that runs the registration of many devices from one process.
+*
+*   @details Registrations are queued and started as earlier ones finish, with at most a given number in progress.
+*            A single call to Prov_Device_LL_Multi_DoWork drives all of them, so one thread serves thousands of
+*            devices.  Each registration has its own low level provisioning client, since the service
+*            authenticates every device on its own connection.
+*/
+
+#ifndef PROV_DEVICE_LL_MULTI_CLIENT_H
+#define PROV_DEVICE_LL_MULTI_CLIENT_H
+
+#include "umock_c/umock_c_prod.h"
+#include "azure_prov_client/prov_device_ll_client.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+extern "C" {
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif /* __cplusplus */
+
+typedef struct PROV_DEVICE_LL_MULTI_INFO_TAG* PROV_DEVICE_LL_MULTI_HANDLE;
+
+/** @brief  Progress of the registrations added to a driver.  Latencies are measured from the start of a registration
+*           to its result, for the registrations that succeeded.  latency_sample_count is lower than
+*           registrations_succeeded when memory for some of the samples could not be allocated.
+*/
+typedef struct PROV_DEVICE_MULTI_STATISTICS_TAG
+{
+    size_t registrations_queued;
+    size_t registrations_in_progress;
+    size_t registrations_succeeded;
+    size_t registrations_failed;
+    double registrations_per_second;
+    size_t latency_sample_count;
+    uint32_t latency_p50_ms;
+    uint32_t latency_p90_ms;
+    uint32_t latency_p99_ms;
+    uint32_t latency_max_ms;
+} PROV_DEVICE_MULTI_STATISTICS;
+
+/**
+* @brief    Creates a driver for registering many devices with the Device Provisioning Service
+*
+* @param    uri                 The URI of the Device Provisioning Service
+* @param    scope_id            The customer specific Id Scope
+* @param    protocol            Function pointer for protocol implementation
+* @param    max_in_progress     The largest number of registrations that run at the same time
+*
+* @return   A non-NULL PROV_DEVICE_LL_MULTI_HANDLE value that is used when invoking other functions
+*           and NULL on Failure
+*/
+MOCKABLE_FUNCTION(, PROV_DEVICE_LL_MULTI_HANDLE, Prov_Device_LL_Multi_Create, const char*, uri, const char*, scope_id, PROV_DEVICE_TRANSPORT_PROVIDER_FUNCTION, protocol, size_t, max_in_progress);
+
+/**
+* @brief    Disposes of the driver.  Registrations that are queued or in progress are dropped without their callbacks
+*           being called.
+*
+* @param    handle  The handle created by a call to the create function
+*/
+MOCKABLE_FUNCTION(, void, Prov_Device_LL_Multi_Destroy, PROV_DEVICE_LL_MULTI_HANDLE, handle);
+
+/**
+* @brief    Queues the registration of a device.  The registration starts in a later call to Prov_Device_LL_Multi_DoWork.
+*
+* @param    handle              The handle created by a call to the create function.
+* @param    registration_id     The registration id of the device.
+* @param    symmetric_key       The symmetric key of the device, or NULL to use the credentials of the security module.
+*                               Either every registration of a driver has a key or none has, since the security
+*                               module holds a single key; PROV_DEVICE_RESULT_INVALID_ARG is returned otherwise.
+* @param    register_callback   The callback that gets called with the result of the registration
+* @param    user_context        User specified context that will be provided to the callback
+*
+* @return PROV_DEVICE_RESULT_OK upon success or an error code upon failure
+*/
+MOCKABLE_FUNCTION(, PROV_DEVICE_RESULT, Prov_Device_LL_Multi_Add_Registration, PROV_DEVICE_LL_MULTI_HANDLE, handle, const char*, registration_id, const char*, symmetric_key, PROV_DEVICE_CLIENT_REGISTER_DEVICE_CALLBACK, register_callback, void*, user_context);
+
+/**
+* @brief    Starts queued registrations while fewer than max_in_progress are running, and does the work of all the
+*           registrations in progress.
+*
+* @param    handle  The handle created by a call to the create function.
+*/
+MOCKABLE_FUNCTION(, void, Prov_Device_LL_Multi_DoWork, PROV_DEVICE_LL_MULTI_HANDLE, handle);
+
+/**
+* @brief    Sets an option on every registration started from now on.  The supported options are OPTION_TRUSTED_CERT,
+*           PROV_OPTION_LOG_TRACE, PROV_OPTION_TIMEOUT and PROV_OPTION_RETRY_JITTER.
+*
+* @param    handle          The handle created by a call to the create function.
+* @param    optionName      The name of the option to be set
+* @param    value           A pointer to the value of the option to be set
+*
+* @return PROV_DEVICE_RESULT_OK upon success or an error code upon failure
+*/
+MOCKABLE_FUNCTION(, PROV_DEVICE_RESULT, Prov_Device_LL_Multi_SetOption, PROV_DEVICE_LL_MULTI_HANDLE, handle, const char*, optionName, const void*, value);
+
+/**
+* @brief    Retrieves the progress of the registrations and the rate and latency of those that completed.
+*
+* @param    handle          The handle created by a call to the create function.
+* @param    statistics      Receives the statistics.
+*
+* @return PROV_DEVICE_RESULT_OK upon success or an error code upon failure
+*/
+MOCKABLE_FUNCTION(, PROV_DEVICE_RESULT, Prov_Device_LL_Multi_Get_Statistics, PROV_DEVICE_LL_MULTI_HANDLE, handle, PROV_DEVICE_MULTI_STATISTICS*, statistics);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif // PROV_DEVICE_LL_MULTI_CLIENT_H
@@ -21,6 +21,7 @@
 
 #include "azure_prov_client/internal/prov_auth_client.h"
 #include "azure_prov_client/internal/prov_transport_private.h"
+#include "azure_prov_client/internal/prov_result_cache.h"
 #include "azure_prov_client/prov_device_ll_client.h"
 #include "azure_prov_client/prov_client_const.h"
 
@@ -62,6 +63,9 @@ static const char* const JSON_STORAGE_ROOT_KEY_NODE = "storageRootKey";
 #define EPOCH_TIME_T_VALUE          (time_t)0
 #define MAX_AUTH_ATTEMPTS           3
 #define PROV_DEFAULT_TIMEOUT        60
+#define MAX_RETRY_JITTER_PERCENT    100
+
+static bool g_is_rand_seeded = false;
 
 typedef enum CLIENT_STATE_TAG
 {
@@ -75,6 +79,8 @@ typedef enum CLIENT_STATE_TAG
     CLIENT_STATE_STATUS_SENT,
     CLIENT_STATE_STATUS_RECV,
 
+    CLIENT_STATE_CACHED_RESULT,
+
     CLIENT_STATE_ERROR
 } CLIENT_STATE;
 
@@ -97,6 +103,7 @@ typedef struct PROV_INSTANCE_INFO_TAG
     size_t retry_after_ms;
 
     uint8_t prov_timeout;
+    uint8_t retry_jitter_percent;
 
     char* registration_id;
     bool user_supplied_reg_id;
@@ -115,6 +122,10 @@ typedef struct PROV_INSTANCE_INFO_TAG
 
     char* custom_request_data;
     char* custom_response_data;
+
+    char* result_cache_path;
+    char* cached_iothub_uri;
+    char* cached_device_id;
 } PROV_INSTANCE_INFO;
 
 static char* prov_transport_challenge_callback(const unsigned char* nonce, size_t nonce_len, const char* key_name, void* user_ctx)
@@ -741,6 +752,12 @@ static void on_transport_registration_data(PROV_DEVICE_TRANSPORT_RESULT transpor
 
             if (prov_info->prov_state != CLIENT_STATE_ERROR)
             {
+                if (prov_info->result_cache_path != NULL && prov_info->hsm_type != PROV_AUTH_TYPE_TPM &&
+                    prov_result_cache_save(prov_info->result_cache_path, prov_info->scope_id, prov_info->registration_id, assigned_hub, device_id) != 0)
+                {
+                    // The next start registers with the service again
+                    LogError("Failure caching the provisioning result");
+                }
                 prov_info->register_callback(PROV_DEVICE_RESULT_OK, assigned_hub, device_id, prov_info->user_context);
                 prov_info->prov_state = CLIENT_STATE_READY;
                 cleanup_prov_info(prov_info);
@@ -775,6 +792,12 @@ static void on_transport_status(PROV_DEVICE_TRANSPORT_STATUS transport_status, u
         PROV_INSTANCE_INFO* prov_info = (PROV_INSTANCE_INFO*)user_ctx;
 
         prov_info->retry_after_ms = (size_t)retry_interval * 1000; // retry_interval is in seconds.
+        if (prov_info->retry_jitter_percent > 0)
+        {
+            // Devices told the same interval would otherwise all poll again in the same instant
+            size_t max_jitter_ms = prov_info->retry_after_ms * prov_info->retry_jitter_percent / 100;
+            prov_info->retry_after_ms += (size_t)(((double)rand() / RAND_MAX) * max_jitter_ms);
+        }
 
         switch (transport_status)
         {
@@ -826,9 +849,36 @@ static void on_transport_status(PROV_DEVICE_TRANSPORT_STATUS transport_status, u
     }
 }
 
+static void free_cached_result(PROV_INSTANCE_INFO* prov_info)
+{
+    if (prov_info->cached_iothub_uri != NULL)
+    {
+        free(prov_info->cached_iothub_uri);
+        prov_info->cached_iothub_uri = NULL;
+    }
+    if (prov_info->cached_device_id != NULL)
+    {
+        free(prov_info->cached_device_id);
+        prov_info->cached_device_id = NULL;
+    }
+}
+
+static void report_cached_result(PROV_INSTANCE_INFO* prov_info)
+{
+    prov_info->register_callback(PROV_DEVICE_RESULT_OK, prov_info->cached_iothub_uri, prov_info->cached_device_id, prov_info->user_context);
+    prov_info->prov_state = CLIENT_STATE_READY;
+    free_cached_result(prov_info);
+    cleanup_prov_info(prov_info);
+}
+
 static void destroy_instance(PROV_INSTANCE_INFO* prov_info)
 {
     cleanup_prov_info(prov_info);
+    free_cached_result(prov_info);
+    if (prov_info->result_cache_path != NULL)
+    {
+        free(prov_info->result_cache_path);
+    }
     // Clean custom request data
     free(prov_info->custom_request_data);
     prov_info->custom_request_data = NULL;
@@ -855,7 +905,14 @@ PROV_DEVICE_LL_HANDLE Prov_Device_LL_Create(const char* uri, const char* id_scop
     }
     else
     {
-        srand((unsigned int)get_time(NULL));
+        // Seeded only once, so devices created within the same second do not draw the same retry jitter; two Creates
+        // racing here at worst seed twice
+        time_t seed = get_time(NULL);
+        if (!g_is_rand_seeded)
+        {
+            srand((unsigned int)seed);
+            g_is_rand_seeded = true;
+        }
 
         result = (PROV_INSTANCE_INFO*)malloc(sizeof(PROV_INSTANCE_INFO));
         if (result == NULL)
@@ -948,6 +1005,7 @@ PROV_DEVICE_RESULT Prov_Device_LL_Register_Device(PROV_DEVICE_LL_HANDLE handle,
     {
         BUFFER_HANDLE ek_value = NULL;
         BUFFER_HANDLE srk_value = NULL;
+        bool use_cached_result = false;
 
         if (handle->prov_state != CLIENT_STATE_READY)
         {
@@ -959,6 +1017,20 @@ PROV_DEVICE_RESULT Prov_Device_LL_Register_Device(PROV_DEVICE_LL_HANDLE handle,
             }
             result = PROV_DEVICE_RESULT_ERROR;
         }
+        // TPM devices are left out, the key the service returns has to be imported on every registration
+        else if (handle->result_cache_path != NULL && handle->hsm_type != PROV_AUTH_TYPE_TPM &&
+            prov_result_cache_load(handle->result_cache_path, handle->scope_id, handle->registration_id, &handle->cached_iothub_uri, &handle->cached_device_id) == 0)
+        {
+            // The result is reported from the next DoWork, the same as a result from the service
+            LogInfo("Using the cached assignment of %s to %s", handle->registration_id, handle->cached_iothub_uri);
+            handle->register_callback = register_callback;
+            handle->user_context = user_context;
+            handle->register_status_cb = reg_status_cb;
+            handle->status_user_ctx = status_ctx;
+            handle->prov_state = CLIENT_STATE_CACHED_RESULT;
+            use_cached_result = true;
+            result = PROV_DEVICE_RESULT_OK;
+        }
         else
         {
             if (handle->hsm_type == PROV_AUTH_TYPE_TPM)
@@ -1039,7 +1111,7 @@ PROV_DEVICE_RESULT Prov_Device_LL_Register_Device(PROV_DEVICE_LL_HANDLE handle,
                 result = PROV_DEVICE_RESULT_OK;
             }
         }
-        if (result == PROV_DEVICE_RESULT_OK)
+        if (result == PROV_DEVICE_RESULT_OK && !use_cached_result)
         {
             handle->register_callback = register_callback;
             handle->user_context = user_context;
@@ -1084,7 +1156,11 @@ PROV_DEVICE_RESULT Prov_Device_LL_Register_Device(PROV_DEVICE_LL_HANDLE handle,
 
 void Prov_Device_LL_DoWork(PROV_DEVICE_LL_HANDLE handle)
 {
-    if (handle != NULL)
+    if (handle != NULL && handle->prov_state == CLIENT_STATE_CACHED_RESULT)
+    {
+        report_cached_result(handle);
+    }
+    else if (handle != NULL)
     {
         PROV_INSTANCE_INFO* prov_info = (PROV_INSTANCE_INFO*)handle;
         if (prov_info->prov_state != CLIENT_STATE_ERROR)
@@ -1272,6 +1348,40 @@ PROV_DEVICE_RESULT Prov_Device_LL_SetOption(PROV_DEVICE_LL_HANDLE handle, const
                 result = PROV_DEVICE_RESULT_OK;
             }
         }
+        else if (strcmp(PROV_OPTION_RETRY_JITTER, option_name) == 0)
+        {
+            if (value == NULL || *((uint8_t*)value) > MAX_RETRY_JITTER_PERCENT)
+            {
+                LogError("setting PROV_OPTION_RETRY_JITTER option, the value must be between 0 and %d", MAX_RETRY_JITTER_PERCENT);
+                result = PROV_DEVICE_RESULT_ERROR;
+            }
+            else
+            {
+                handle->retry_jitter_percent = *((uint8_t*)value);
+                result = PROV_DEVICE_RESULT_OK;
+            }
+        }
+        else if (strcmp(PROV_OPTION_RESULT_CACHE, option_name) == 0)
+        {
+            char* cache_path = NULL;
+            if (handle->prov_state != CLIENT_STATE_READY)
+            {
+                LogError("the result cache cannot be set after registration has begun");
+                result = PROV_DEVICE_RESULT_ERROR;
+            }
+            else if (value != NULL && mallocAndStrcpy_s(&cache_path, (const char*)value) != 0)
+            {
+                LogError("Failure allocating the result cache path");
+                result = PROV_DEVICE_RESULT_ERROR;
+            }
+            else
+            {
+                // A NULL value turns the cache off
+                free(handle->result_cache_path);
+                handle->result_cache_path = cache_path;
+                result = PROV_DEVICE_RESULT_OK;
+            }
+        }
         else if (strcmp(PROV_REGISTRATION_ID, option_name) == 0)
         {
             if (handle->prov_state != CLIENT_STATE_READY)
@@ -1408,3 +1518,28 @@ const char* Prov_Device_LL_Get_Provisioning_Payload(PROV_DEVICE_LL_HANDLE handle
     }
     return result;
 }
+
+PROV_DEVICE_RESULT Prov_Device_LL_Invalidate_Cached_Result(PROV_DEVICE_LL_HANDLE handle)
+{
+    PROV_DEVICE_RESULT result;
+    if (handle == NULL)
+    {
+        LogError("Invalid parameter specified handle: %p", handle);
+        result = PROV_DEVICE_RESULT_INVALID_ARG;
+    }
+    else if (handle->result_cache_path == NULL)
+    {
+        // Nothing is cached without a cache path
+        result = PROV_DEVICE_RESULT_OK;
+    }
+    else if (prov_result_cache_clear(handle->result_cache_path) != 0)
+    {
+        LogError("Failure clearing the provisioning result cache");
+        result = PROV_DEVICE_RESULT_ERROR;
+    }
+    else
+    {
+        result = PROV_DEVICE_RESULT_OK;
+    }
+    return result;
+}
@@ -0,0 +1,529 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+
+#include "azure_prov_client/prov_device_ll_client.h"
+#include "azure_prov_client/prov_device_ll_multi_client.h"
+#include "azure_prov_client/prov_security_factory.h"
+
+#define INITIAL_LATENCY_CAPACITY    64
+
+struct PROV_DEVICE_LL_MULTI_INFO_TAG;
+
+typedef struct MULTI_REGISTRATION_TAG
+{
+    struct PROV_DEVICE_LL_MULTI_INFO_TAG* multi_info;
+
+    char* registration_id;
+    char* symmetric_key;
+    PROV_DEVICE_CLIENT_REGISTER_DEVICE_CALLBACK register_callback;
+    void* user_context;
+
+    PROV_DEVICE_LL_HANDLE device_handle;
+    tickcounter_ms_t start_time_ms;
+    bool is_complete;
+} MULTI_REGISTRATION;
+
+typedef struct PROV_DEVICE_LL_MULTI_INFO_TAG
+{
+    char* uri;
+    char* scope_id;
+    PROV_DEVICE_TRANSPORT_PROVIDER_FUNCTION protocol;
+
+    SINGLYLINKEDLIST_HANDLE queued_list;
+    size_t queued_count;
+    // The security module holds a single symmetric key, so keyed and unkeyed registrations are not mixed
+    bool has_keyed_registration;
+    bool has_unkeyed_registration;
+
+    // Registrations in progress are kept packed at the front of the array
+    MULTI_REGISTRATION** in_progress;
+    size_t in_progress_count;
+    size_t max_in_progress;
+
+    TICK_COUNTER_HANDLE tick_counter;
+    bool is_started;
+    tickcounter_ms_t first_start_time_ms;
+    tickcounter_ms_t last_complete_time_ms;
+
+    size_t succeeded_count;
+    size_t failed_count;
+    uint32_t* latencies_ms;
+    size_t latency_count;
+    size_t latency_capacity;
+
+    // Options applied to every registration as it starts
+    char* trusted_cert;
+    bool log_trace;
+    bool is_log_trace_set;
+    uint8_t prov_timeout;
+    bool is_prov_timeout_set;
+    uint8_t retry_jitter_percent;
+    bool is_retry_jitter_set;
+} PROV_DEVICE_LL_MULTI_INFO;
+
+static void destroy_registration(MULTI_REGISTRATION* registration)
+{
+    if (registration->device_handle != NULL)
+    {
+        Prov_Device_LL_Destroy(registration->device_handle);
+    }
+    free(registration->registration_id);
+    free(registration->symmetric_key);
+    free(registration);
+}
+
+static void record_latency(PROV_DEVICE_LL_MULTI_INFO* multi_info, tickcounter_ms_t latency_ms)
+{
+    if (multi_info->latency_count == multi_info->latency_capacity)
+    {
+        size_t new_capacity = (multi_info->latency_capacity == 0) ? INITIAL_LATENCY_CAPACITY : multi_info->latency_capacity * 2;
+        uint32_t* latencies_ms = (uint32_t*)realloc(multi_info->latencies_ms, new_capacity * sizeof(uint32_t));
+        if (latencies_ms == NULL)
+        {
+            // The registration still counts, its latency is left out of the percentiles; growing is tried again on the next sample
+            LogError("Failure growing the latency samples, dropping the latency of registration %lu", (unsigned long)(multi_info->succeeded_count + 1));
+        }
+        else
+        {
+            multi_info->latencies_ms = latencies_ms;
+            multi_info->latency_capacity = new_capacity;
+        }
+    }
+
+    if (multi_info->latency_count < multi_info->latency_capacity)
+    {
+        multi_info->latencies_ms[multi_info->latency_count++] = (uint32_t)latency_ms;
+    }
+}
+
+static void complete_registration(MULTI_REGISTRATION* registration, PROV_DEVICE_RESULT register_result, const char* iothub_uri, const char* device_id)
+{
+    PROV_DEVICE_LL_MULTI_INFO* multi_info = registration->multi_info;
+    tickcounter_ms_t current_time = 0;
+
+    (void)tickcounter_get_current_ms(multi_info->tick_counter, &current_time);
+    multi_info->last_complete_time_ms = current_time;
+
+    if (register_result == PROV_DEVICE_RESULT_OK)
+    {
+        record_latency(multi_info, current_time - registration->start_time_ms);
+        multi_info->succeeded_count++;
+    }
+    else
+    {
+        multi_info->failed_count++;
+    }
+    registration->is_complete = true;
+
+    registration->register_callback(register_result, iothub_uri, device_id, registration->user_context);
+}
+
+static void on_device_registered(PROV_DEVICE_RESULT register_result, const char* iothub_uri, const char* device_id, void* user_context)
+{
+    if (user_context == NULL)
+    {
+        LogError("user_context was unexpectedly NULL");
+    }
+    else
+    {
+        // The device client is still in use by its DoWork, it is destroyed once that returns
+        complete_registration((MULTI_REGISTRATION*)user_context, register_result, iothub_uri, device_id);
+    }
+}
+
+static PROV_DEVICE_RESULT apply_options(PROV_DEVICE_LL_MULTI_INFO* multi_info, PROV_DEVICE_LL_HANDLE device_handle)
+{
+    PROV_DEVICE_RESULT result;
+
+    if (multi_info->trusted_cert != NULL && (result = Prov_Device_LL_SetOption(device_handle, OPTION_TRUSTED_CERT, multi_info->trusted_cert)) != PROV_DEVICE_RESULT_OK)
+    {
+        LogError("Failure setting the trusted certificate");
+    }
+    else if (multi_info->is_log_trace_set && (result = Prov_Device_LL_SetOption(device_handle, PROV_OPTION_LOG_TRACE, &multi_info->log_trace)) != PROV_DEVICE_RESULT_OK)
+    {
+        LogError("Failure setting the log trace option");
+    }
+    else if (multi_info->is_prov_timeout_set && (result = Prov_Device_LL_SetOption(device_handle, PROV_OPTION_TIMEOUT, &multi_info->prov_timeout)) != PROV_DEVICE_RESULT_OK)
+    {
+        LogError("Failure setting the timeout option");
+    }
+    else if (multi_info->is_retry_jitter_set && (result = Prov_Device_LL_SetOption(device_handle, PROV_OPTION_RETRY_JITTER, &multi_info->retry_jitter_percent)) != PROV_DEVICE_RESULT_OK)
+    {
+        LogError("Failure setting the retry jitter option");
+    }
+    else
+    {
+        result = PROV_DEVICE_RESULT_OK;
+    }
+    return result;
+}
+
+static PROV_DEVICE_RESULT start_registration(PROV_DEVICE_LL_MULTI_INFO* multi_info, MULTI_REGISTRATION* registration)
+{
+    PROV_DEVICE_RESULT result;
+
+    // The security module reads the key when the device client is created
+    if (registration->symmetric_key != NULL && prov_dev_set_symmetric_key_info(registration->registration_id, registration->symmetric_key) != 0)
+    {
+        LogError("Failure setting the symmetric key of %s", registration->registration_id);
+        result = PROV_DEVICE_RESULT_KEY_ERROR;
+    }
+    else if ((registration->device_handle = Prov_Device_LL_Create(multi_info->uri, multi_info->scope_id, multi_info->protocol)) == NULL)
+    {
+        LogError("Failure creating the device client of %s", registration->registration_id);
+        result = PROV_DEVICE_RESULT_ERROR;
+    }
+    else if ((result = Prov_Device_LL_SetOption(registration->device_handle, PROV_REGISTRATION_ID, registration->registration_id)) != PROV_DEVICE_RESULT_OK)
+    {
+        LogError("Failure setting the registration id %s", registration->registration_id);
+    }
+    else if ((result = apply_options(multi_info, registration->device_handle)) != PROV_DEVICE_RESULT_OK)
+    {
+        LogError("Failure setting the options of %s", registration->registration_id);
+    }
+    else
+    {
+        (void)tickcounter_get_current_ms(multi_info->tick_counter, &registration->start_time_ms);
+        if (!multi_info->is_started)
+        {
+            multi_info->first_start_time_ms = registration->start_time_ms;
+            multi_info->is_started = true;
+        }
+
+        if ((result = Prov_Device_LL_Register_Device(registration->device_handle, on_device_registered, registration, NULL, NULL)) != PROV_DEVICE_RESULT_OK)
+        {
+            LogError("Failure starting the registration of %s", registration->registration_id);
+        }
+    }
+
+    // The key is only needed to create the device client
+    free(registration->symmetric_key);
+    registration->symmetric_key = NULL;
+
+    return result;
+}
+
+static void start_queued_registrations(PROV_DEVICE_LL_MULTI_INFO* multi_info)
+{
+    LIST_ITEM_HANDLE list_item;
+
+    while (multi_info->in_progress_count < multi_info->max_in_progress && (list_item = singlylinkedlist_get_head_item(multi_info->queued_list)) != NULL)
+    {
+        MULTI_REGISTRATION* registration = (MULTI_REGISTRATION*)singlylinkedlist_item_get_value(list_item);
+        PROV_DEVICE_RESULT start_result;
+
+        (void)singlylinkedlist_remove(multi_info->queued_list, list_item);
+        multi_info->queued_count--;
+
+        if ((start_result = start_registration(multi_info, registration)) != PROV_DEVICE_RESULT_OK)
+        {
+            complete_registration(registration, start_result, NULL, NULL);
+            destroy_registration(registration);
+        }
+        else
+        {
+            multi_info->in_progress[multi_info->in_progress_count++] = registration;
+        }
+    }
+}
+
+static int compare_latency(const void* left, const void* right)
+{
+    uint32_t left_value = *(const uint32_t*)left;
+    uint32_t right_value = *(const uint32_t*)right;
+    return (left_value > right_value) - (left_value < right_value);
+}
+
+static uint32_t get_percentile(const uint32_t* sorted_latencies, size_t count, size_t percentile)
+{
+    // Nearest rank
+    size_t rank = (percentile * count + 99) / 100;
+    return sorted_latencies[(rank == 0) ? 0 : rank - 1];
+}
+
+PROV_DEVICE_LL_MULTI_HANDLE Prov_Device_LL_Multi_Create(const char* uri, const char* scope_id, PROV_DEVICE_TRANSPORT_PROVIDER_FUNCTION protocol, size_t max_in_progress)
+{
+    PROV_DEVICE_LL_MULTI_INFO* result;
+    if (uri == NULL || scope_id == NULL || protocol == NULL || max_in_progress == 0)
+    {
+        LogError("Invalid parameter specified uri: %p, scope_id: %p, protocol: %p, max_in_progress: %lu", uri, scope_id, protocol, (unsigned long)max_in_progress);
+        result = NULL;
+    }
+    else if ((result = (PROV_DEVICE_LL_MULTI_INFO*)malloc(sizeof(PROV_DEVICE_LL_MULTI_INFO))) == NULL)
+    {
+        LogError("unable to allocate multi registration info");
+    }
+    else
+    {
+        memset(result, 0, sizeof(PROV_DEVICE_LL_MULTI_INFO));
+        result->protocol = protocol;
+        result->max_in_progress = max_in_progress;
+
+        if (mallocAndStrcpy_s(&result->uri, uri) != 0)
+        {
+            LogError("failed to copy uri");
+            Prov_Device_LL_Multi_Destroy(result);
+            result = NULL;
+        }
+        else if (mallocAndStrcpy_s(&result->scope_id, scope_id) != 0)
+        {
+            LogError("failed to copy scope_id");
+            Prov_Device_LL_Multi_Destroy(result);
+            result = NULL;
+        }
+        else if ((result->queued_list = singlylinkedlist_create()) == NULL)
+        {
+            LogError("failed to create the registration queue");
+            Prov_Device_LL_Multi_Destroy(result);
+            result = NULL;
+        }
+        else if ((result->in_progress = (MULTI_REGISTRATION**)malloc(max_in_progress * sizeof(MULTI_REGISTRATION*))) == NULL)
+        {
+            LogError("failed to allocate the registrations in progress");
+            Prov_Device_LL_Multi_Destroy(result);
+            result = NULL;
+        }
+        else if ((result->tick_counter = tickcounter_create()) == NULL)
+        {
+            LogError("failure: allocating tickcounter");
+            Prov_Device_LL_Multi_Destroy(result);
+            result = NULL;
+        }
+    }
+    return result;
+}
+
+void Prov_Device_LL_Multi_Destroy(PROV_DEVICE_LL_MULTI_HANDLE handle)
+{
+    if (handle != NULL)
+    {
+        size_t index;
+
+        for (index = 0; index < handle->in_progress_count; index++)
+        {
+            destroy_registration(handle->in_progress[index]);
+        }
+        free(handle->in_progress);
+
+        if (handle->queued_list != NULL)
+        {
+            LIST_ITEM_HANDLE list_item;
+            while ((list_item = singlylinkedlist_get_head_item(handle->queued_list)) != NULL)
+            {
+                destroy_registration((MULTI_REGISTRATION*)singlylinkedlist_item_get_value(list_item));
+                (void)singlylinkedlist_remove(handle->queued_list, list_item);
+            }
+            singlylinkedlist_destroy(handle->queued_list);
+        }
+
+        if (handle->tick_counter != NULL)
+        {
+            tickcounter_destroy(handle->tick_counter);
+        }
+        free(handle->latencies_ms);
+        free(handle->trusted_cert);
+        free(handle->uri);
+        free(handle->scope_id);
+        free(handle);
+    }
+}
+
+PROV_DEVICE_RESULT Prov_Device_LL_Multi_Add_Registration(PROV_DEVICE_LL_MULTI_HANDLE handle, const char* registration_id, const char* symmetric_key, PROV_DEVICE_CLIENT_REGISTER_DEVICE_CALLBACK register_callback, void* user_context)
+{
+    PROV_DEVICE_RESULT result;
+    MULTI_REGISTRATION* registration;
+
+    if (handle == NULL || registration_id == NULL || register_callback == NULL)
+    {
+        LogError("Invalid parameter specified handle: %p, registration_id: %p, register_callback: %p", handle, registration_id, register_callback);
+        result = PROV_DEVICE_RESULT_INVALID_ARG;
+    }
+    else if ((symmetric_key != NULL) ? handle->has_unkeyed_registration : handle->has_keyed_registration)
+    {
+        // A registration without a key would pick up the key set for the one started before it
+        LogError("Registration %s %s a symmetric key, unlike the earlier registrations", registration_id, (symmetric_key != NULL) ? "has" : "does not have");
+        result = PROV_DEVICE_RESULT_INVALID_ARG;
+    }
+    else if ((registration = (MULTI_REGISTRATION*)malloc(sizeof(MULTI_REGISTRATION))) == NULL)
+    {
+        LogError("Failure allocating registration");
+        result = PROV_DEVICE_RESULT_MEMORY;
+    }
+    else
+    {
+        memset(registration, 0, sizeof(MULTI_REGISTRATION));
+        registration->multi_info = handle;
+        registration->register_callback = register_callback;
+        registration->user_context = user_context;
+
+        if (mallocAndStrcpy_s(&registration->registration_id, registration_id) != 0)
+        {
+            LogError("Failure copying registration id");
+            destroy_registration(registration);
+            result = PROV_DEVICE_RESULT_MEMORY;
+        }
+        else if (symmetric_key != NULL && mallocAndStrcpy_s(&registration->symmetric_key, symmetric_key) != 0)
+        {
+            LogError("Failure copying symmetric key");
+            destroy_registration(registration);
+            result = PROV_DEVICE_RESULT_MEMORY;
+        }
+        else if (singlylinkedlist_add(handle->queued_list, registration) == NULL)
+        {
+            LogError("Failure queuing registration");
+            destroy_registration(registration);
+            result = PROV_DEVICE_RESULT_ERROR;
+        }
+        else
+        {
+            handle->queued_count++;
+            if (symmetric_key != NULL)
+            {
+                handle->has_keyed_registration = true;
+            }
+            else
+            {
+                handle->has_unkeyed_registration = true;
+            }
+            result = PROV_DEVICE_RESULT_OK;
+        }
+    }
+    return result;
+}
+
+void Prov_Device_LL_Multi_DoWork(PROV_DEVICE_LL_MULTI_HANDLE handle)
+{
+    if (handle != NULL)
+    {
+        size_t index = 0;
+
+        start_queued_registrations(handle);
+
+        while (index < handle->in_progress_count)
+        {
+            MULTI_REGISTRATION* registration = handle->in_progress[index];
+
+            Prov_Device_LL_DoWork(registration->device_handle);
+            if (registration->is_complete)
+            {
+                destroy_registration(registration);
+                handle->in_progress[index] = handle->in_progress[--handle->in_progress_count];
+            }
+            else
+            {
+                index++;
+            }
+        }
+    }
+}
+
+PROV_DEVICE_RESULT Prov_Device_LL_Multi_SetOption(PROV_DEVICE_LL_MULTI_HANDLE handle, const char* option_name, const void* value)
+{
+    PROV_DEVICE_RESULT result;
+    if (handle == NULL || option_name == NULL || value == NULL)
+    {
+        LogError("Invalid parameter specified handle: %p, option_name: %p, value: %p", handle, option_name, value);
+        result = PROV_DEVICE_RESULT_INVALID_ARG;
+    }
+    else if (strcmp(OPTION_TRUSTED_CERT, option_name) == 0)
+    {
+        char* trusted_cert;
+        if (mallocAndStrcpy_s(&trusted_cert, (const char*)value) != 0)
+        {
+            LogError("Failure copying the trusted certificate");
+            result = PROV_DEVICE_RESULT_MEMORY;
+        }
+        else
+        {
+            free(handle->trusted_cert);
+            handle->trusted_cert = trusted_cert;
+            result = PROV_DEVICE_RESULT_OK;
+        }
+    }
+    else if (strcmp(PROV_OPTION_LOG_TRACE, option_name) == 0)
+    {
+        handle->log_trace = *((const bool*)value);
+        handle->is_log_trace_set = true;
+        result = PROV_DEVICE_RESULT_OK;
+    }
+    else if (strcmp(PROV_OPTION_TIMEOUT, option_name) == 0)
+    {
+        handle->prov_timeout = *((const uint8_t*)value);
+        handle->is_prov_timeout_set = true;
+        result = PROV_DEVICE_RESULT_OK;
+    }
+    else if (strcmp(PROV_OPTION_RETRY_JITTER, option_name) == 0)
+    {
+        // The range is checked by the device client when the option is applied
+        handle->retry_jitter_percent = *((const uint8_t*)value);
+        handle->is_retry_jitter_set = true;
+        result = PROV_DEVICE_RESULT_OK;
+    }
+    else
+    {
+        LogError("Option %s is not supported", option_name);
+        result = PROV_DEVICE_RESULT_INVALID_ARG;
+    }
+    return result;
+}
+
+PROV_DEVICE_RESULT Prov_Device_LL_Multi_Get_Statistics(PROV_DEVICE_LL_MULTI_HANDLE handle, PROV_DEVICE_MULTI_STATISTICS* statistics)
+{
+    PROV_DEVICE_RESULT result;
+    if (handle == NULL || statistics == NULL)
+    {
+        LogError("Invalid parameter specified handle: %p, statistics: %p", handle, statistics);
+        result = PROV_DEVICE_RESULT_INVALID_ARG;
+    }
+    else
+    {
+        size_t sample_count = handle->latency_count;
+        uint32_t* sorted_latencies = NULL;
+
+        if (sample_count > 0 && (sorted_latencies = (uint32_t*)malloc(sample_count * sizeof(uint32_t))) == NULL)
+        {
+            LogError("Failure allocating the latency samples");
+            result = PROV_DEVICE_RESULT_MEMORY;
+        }
+        else
+        {
+            tickcounter_ms_t elapsed_ms = handle->last_complete_time_ms - handle->first_start_time_ms;
+
+            memset(statistics, 0, sizeof(PROV_DEVICE_MULTI_STATISTICS));
+            statistics->registrations_queued = handle->queued_count;
+            statistics->registrations_in_progress = handle->in_progress_count;
+            statistics->registrations_succeeded = handle->succeeded_count;
+            statistics->registrations_failed = handle->failed_count;
+            statistics->latency_sample_count = sample_count;
+            if (handle->is_started && elapsed_ms > 0)
+            {
+                statistics->registrations_per_second = (double)(handle->succeeded_count + handle->failed_count) * 1000 / elapsed_ms;
+            }
+
+            if (sample_count > 0)
+            {
+                memcpy(sorted_latencies, handle->latencies_ms, sample_count * sizeof(uint32_t));
+                qsort(sorted_latencies, sample_count, sizeof(uint32_t), compare_latency);
+                statistics->latency_p50_ms = get_percentile(sorted_latencies, sample_count, 50);
+                statistics->latency_p90_ms = get_percentile(sorted_latencies, sample_count, 90);
+                statistics->latency_p99_ms = get_percentile(sorted_latencies, sample_count, 99);
+                statistics->latency_max_ms = sorted_latencies[sample_count - 1];
+                free(sorted_latencies);
+            }
+            result = PROV_DEVICE_RESULT_OK;
+        }
+    }
+    return result;
+}
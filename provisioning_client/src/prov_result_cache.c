@@ -0,0 +1,329 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#define _POSIX_C_SOURCE 200112L
+#include <unistd.h>
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/sha.h"
+
+#include "azure_prov_client/internal/prov_result_cache.h"
+#include "parson.h"
+
+#define CACHE_FORMAT_VERSION    1
+#define DIGEST_STRING_LENGTH    (SHA256HashSize * 2)
+
+static const char* const JSON_NODE_VERSION = "version";
+static const char* const JSON_NODE_SCOPE_ID = "scopeId";
+static const char* const JSON_NODE_REGISTRATION_ID = "registrationId";
+static const char* const JSON_NODE_ASSIGNED_HUB = "assignedHub";
+static const char* const JSON_NODE_DEVICE_ID = "deviceId";
+static const char* const JSON_NODE_DIGEST = "digest";
+static const char* const TEMP_FILE_SUFFIX = ".tmp";
+
+// The digest only detects a truncated or corrupted entry: it is not keyed, so whoever can edit the file can also
+// recompute it.  Each field goes in with its terminator, so moving characters from one field to the next changes it.
+static int compute_digest(const char* scope_id, const char* registration_id, const char* iothub_uri, const char* device_id, char digest_string[DIGEST_STRING_LENGTH + 1])
+{
+    int result;
+    SHA256Context sha_ctx;
+    uint8_t msg_digest[SHA256HashSize];
+
+    if (SHA256Reset(&sha_ctx) != 0)
+    {
+        LogError("Failed sha256 reset");
+        result = MU_FAILURE;
+    }
+    else if (SHA256Input(&sha_ctx, (const uint8_t*)scope_id, (unsigned int)strlen(scope_id) + 1) != 0 ||
+        SHA256Input(&sha_ctx, (const uint8_t*)registration_id, (unsigned int)strlen(registration_id) + 1) != 0 ||
+        SHA256Input(&sha_ctx, (const uint8_t*)iothub_uri, (unsigned int)strlen(iothub_uri) + 1) != 0 ||
+        SHA256Input(&sha_ctx, (const uint8_t*)device_id, (unsigned int)strlen(device_id) + 1) != 0)
+    {
+        LogError("Failed SHA256Input");
+        result = MU_FAILURE;
+    }
+    else if (SHA256Result(&sha_ctx, msg_digest) != 0)
+    {
+        LogError("Failed SHA256Result");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        static const char HEX_DIGITS[] = "0123456789abcdef";
+        size_t index;
+
+        for (index = 0; index < SHA256HashSize; index++)
+        {
+            digest_string[index * 2] = HEX_DIGITS[msg_digest[index] >> 4];
+            digest_string[index * 2 + 1] = HEX_DIGITS[msg_digest[index] & 0x0F];
+        }
+        digest_string[DIGEST_STRING_LENGTH] = '\0';
+        result = 0;
+    }
+    return result;
+}
+
+int prov_result_cache_load(const char* cache_path, const char* scope_id, const char* registration_id, char** iothub_uri, char** device_id)
+{
+    int result;
+    JSON_Value* root_value;
+    JSON_Object* root_object;
+
+    if (cache_path == NULL || scope_id == NULL || registration_id == NULL || iothub_uri == NULL || device_id == NULL)
+    {
+        LogError("Invalid parameter specified cache_path: %p, scope_id: %p, registration_id: %p, iothub_uri: %p, device_id: %p", cache_path, scope_id, registration_id, iothub_uri, device_id);
+        result = MU_FAILURE;
+    }
+    else if ((root_value = json_parse_file(cache_path)) == NULL)
+    {
+        // No file yet is the usual case on the first start
+        LogInfo("No provisioning result cached in %s", cache_path);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        const char* cached_scope_id;
+        const char* cached_registration_id;
+        const char* cached_iothub_uri;
+        const char* cached_device_id;
+        const char* cached_digest;
+        char digest_string[DIGEST_STRING_LENGTH + 1];
+
+        if ((root_object = json_value_get_object(root_value)) == NULL)
+        {
+            LogError("Provisioning result cache %s is not a JSON object", cache_path);
+            result = MU_FAILURE;
+        }
+        else if ((int)json_object_get_number(root_object, JSON_NODE_VERSION) != CACHE_FORMAT_VERSION ||
+            (cached_scope_id = json_object_get_string(root_object, JSON_NODE_SCOPE_ID)) == NULL ||
+            (cached_registration_id = json_object_get_string(root_object, JSON_NODE_REGISTRATION_ID)) == NULL ||
+            (cached_iothub_uri = json_object_get_string(root_object, JSON_NODE_ASSIGNED_HUB)) == NULL ||
+            (cached_device_id = json_object_get_string(root_object, JSON_NODE_DEVICE_ID)) == NULL ||
+            (cached_digest = json_object_get_string(root_object, JSON_NODE_DIGEST)) == NULL)
+        {
+            LogError("Provisioning result cache %s is missing fields", cache_path);
+            result = MU_FAILURE;
+        }
+        else if (strcmp(cached_scope_id, scope_id) != 0 || strcmp(cached_registration_id, registration_id) != 0)
+        {
+            LogInfo("Provisioning result cache %s is for another registration", cache_path);
+            result = MU_FAILURE;
+        }
+        else if (compute_digest(cached_scope_id, cached_registration_id, cached_iothub_uri, cached_device_id, digest_string) != 0)
+        {
+            LogError("Failure computing the digest of the provisioning result cache");
+            result = MU_FAILURE;
+        }
+        else if (strcmp(cached_digest, digest_string) != 0)
+        {
+            LogError("Provisioning result cache %s is corrupted", cache_path);
+            result = MU_FAILURE;
+        }
+        else if (mallocAndStrcpy_s(iothub_uri, cached_iothub_uri) != 0)
+        {
+            LogError("Failure copying the cached iothub uri");
+            result = MU_FAILURE;
+        }
+        else if (mallocAndStrcpy_s(device_id, cached_device_id) != 0)
+        {
+            LogError("Failure copying the cached device id");
+            free(*iothub_uri);
+            *iothub_uri = NULL;
+            result = MU_FAILURE;
+        }
+        else
+        {
+            result = 0;
+        }
+        json_value_free(root_value);
+    }
+    return result;
+}
+
+// Writes the entry and makes sure it reached the disk before the rename that publishes it
+static int write_file_synced(const char* path, const char* content)
+{
+    int result;
+    FILE* file;
+
+    if ((file = fopen(path, "w")) == NULL)
+    {
+        LogError("Failure opening %s", path);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        if (fputs(content, file) < 0 || fflush(file) != 0)
+        {
+            LogError("Failure writing %s", path);
+            result = MU_FAILURE;
+        }
+#ifdef _WIN32
+        else if (_commit(_fileno(file)) != 0)
+#else
+        else if (fsync(fileno(file)) != 0)
+#endif
+        {
+            LogError("Failure syncing %s", path);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            result = 0;
+        }
+
+        if (fclose(file) != 0 && result == 0)
+        {
+            LogError("Failure closing %s", path);
+            result = MU_FAILURE;
+        }
+    }
+    return result;
+}
+
+// Replaces the cache with the temporary file in one step, so there is no moment without a cache file
+static int replace_file(const char* temp_path, const char* cache_path)
+{
+    int result;
+#ifdef _WIN32
+    if (!MoveFileExA(temp_path, cache_path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+    {
+        LogError("Failure moving %s to %s: %lu", temp_path, cache_path, (unsigned long)GetLastError());
+        result = MU_FAILURE;
+    }
+#else
+    if (rename(temp_path, cache_path) != 0)
+    {
+        LogError("Failure moving %s to %s", temp_path, cache_path);
+        result = MU_FAILURE;
+    }
+#endif
+    else
+    {
+        result = 0;
+    }
+    return result;
+}
+
+int prov_result_cache_save(const char* cache_path, const char* scope_id, const char* registration_id, const char* iothub_uri, const char* device_id)
+{
+    int result;
+    char digest_string[DIGEST_STRING_LENGTH + 1];
+    JSON_Value* root_value;
+    JSON_Object* root_object;
+    char* temp_path;
+    char* serialized;
+
+    if (cache_path == NULL || scope_id == NULL || registration_id == NULL || iothub_uri == NULL || device_id == NULL)
+    {
+        LogError("Invalid parameter specified cache_path: %p, scope_id: %p, registration_id: %p, iothub_uri: %p, device_id: %p", cache_path, scope_id, registration_id, iothub_uri, device_id);
+        result = MU_FAILURE;
+    }
+    else if (compute_digest(scope_id, registration_id, iothub_uri, device_id, digest_string) != 0)
+    {
+        LogError("Failure computing the digest of the provisioning result");
+        result = MU_FAILURE;
+    }
+    else if ((temp_path = (char*)malloc(strlen(cache_path) + strlen(TEMP_FILE_SUFFIX) + 1)) == NULL)
+    {
+        LogError("Failure allocating the temporary cache path");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        (void)strcpy(temp_path, cache_path);
+        (void)strcat(temp_path, TEMP_FILE_SUFFIX);
+
+        if ((root_value = json_value_init_object()) == NULL)
+        {
+            LogError("Failure creating the provisioning result JSON");
+            result = MU_FAILURE;
+        }
+        else
+        {
+            if ((root_object = json_value_get_object(root_value)) == NULL ||
+                json_object_set_number(root_object, JSON_NODE_VERSION, CACHE_FORMAT_VERSION) != JSONSuccess ||
+                json_object_set_string(root_object, JSON_NODE_SCOPE_ID, scope_id) != JSONSuccess ||
+                json_object_set_string(root_object, JSON_NODE_REGISTRATION_ID, registration_id) != JSONSuccess ||
+                json_object_set_string(root_object, JSON_NODE_ASSIGNED_HUB, iothub_uri) != JSONSuccess ||
+                json_object_set_string(root_object, JSON_NODE_DEVICE_ID, device_id) != JSONSuccess ||
+                json_object_set_string(root_object, JSON_NODE_DIGEST, digest_string) != JSONSuccess)
+            {
+                LogError("Failure building the provisioning result JSON");
+                result = MU_FAILURE;
+            }
+            else if ((serialized = json_serialize_to_string(root_value)) == NULL)
+            {
+                LogError("Failure serializing the provisioning result");
+                result = MU_FAILURE;
+            }
+            else
+            {
+                // Written aside, synced and then moved over the cache, so a power loss leaves either the old or the new entry
+                if (write_file_synced(temp_path, serialized) != 0)
+                {
+                    LogError("Failure writing the provisioning result to %s", temp_path);
+                    (void)remove(temp_path);
+                    result = MU_FAILURE;
+                }
+                else if (replace_file(temp_path, cache_path) != 0)
+                {
+                    LogError("Failure moving the provisioning result to %s", cache_path);
+                    (void)remove(temp_path);
+                    result = MU_FAILURE;
+                }
+                else
+                {
+                    result = 0;
+                }
+                json_free_serialized_string(serialized);
+            }
+            json_value_free(root_value);
+        }
+        free(temp_path);
+    }
+    return result;
+}
+
+int prov_result_cache_clear(const char* cache_path)
+{
+    int result;
+    FILE* cache_file;
+
+    if (cache_path == NULL)
+    {
+        LogError("Invalid parameter specified cache_path: NULL");
+        result = MU_FAILURE;
+    }
+    else if ((cache_file = fopen(cache_path, "r")) == NULL)
+    {
+        // Nothing cached
+        result = 0;
+    }
+    else
+    {
+        (void)fclose(cache_file);
+        if (remove(cache_path) != 0)
+        {
+            LogError("Failure removing the provisioning result cache %s", cache_path);
+            result = MU_FAILURE;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+    return result;
+}
@@ -41,6 +41,7 @@ static void my_gballoc_free(void* ptr)
 #include "azure_prov_client/internal/iothub_auth_client.h"
 #include "azure_prov_client/internal/prov_auth_client.h"
 #include "azure_prov_client/internal/prov_transport_private.h"
+#include "azure_prov_client/internal/prov_result_cache.h"
 #include "parson.h"
 
 #undef ENABLE_MOCKS
@@ -95,6 +96,7 @@ static void* g_http_error_ctx;
 PROV_TRANSPORT_JSON_PARSE g_json_parse_cb;
 PROV_TRANSPORT_CREATE_JSON_PAYLOAD g_json_create_cb;
 void* g_json_ctx;
+static int g_cache_load_result;
 
 #ifdef __cplusplus
 extern "C"
@@ -147,6 +149,7 @@ static const char* TEST_HTTP_PASSWORD = "password";
 static const char* TEST_TRUSTED_CERT = "trusted_cert";
 static char* TEST_STRING_VALUE = "Test_String_Value";
 static const char* TEST_CUSTOM_DATA = "{ \"json_cust_data\": 123456 }";
+static const char* TEST_RESULT_CACHE_PATH = "prov_result.json";
 
 static const char* PROV_DISABLED_STATUS = "disabled";
 static const char* PROV_FAILURE_STATUS = "failure";
@@ -408,6 +411,19 @@ static BUFFER_HANDLE my_Azure_Base64_Decode(const char* source)
     return (BUFFER_HANDLE)my_gballoc_malloc(1);
 }
 
+static int my_prov_result_cache_load(const char* cache_path, const char* scope_id, const char* registration_id, char** iothub_uri, char** device_id)
+{
+    (void)cache_path;
+    (void)scope_id;
+    (void)registration_id;
+    if (g_cache_load_result == 0)
+    {
+        (void)my_mallocAndStrcpy_s(iothub_uri, TEST_IOTHUB);
+        (void)my_mallocAndStrcpy_s(device_id, TEST_DEVICE_ID);
+    }
+    return g_cache_load_result;
+}
+
 static JSON_Value* my_json_parse_string(const char* string)
 {
     (void)string;
@@ -530,6 +546,12 @@ BEGIN_TEST_SUITE(prov_device_client_ll_ut)
         REGISTER_GLOBAL_MOCK_HOOK(Azure_Base64_Decode, my_Azure_Base64_Decode);
         REGISTER_GLOBAL_MOCK_FAIL_RETURN(Azure_Base64_Decode, NULL);
 
+        REGISTER_GLOBAL_MOCK_HOOK(prov_result_cache_load, my_prov_result_cache_load);
+        REGISTER_GLOBAL_MOCK_RETURN(prov_result_cache_save, 0);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(prov_result_cache_save, __LINE__);
+        REGISTER_GLOBAL_MOCK_RETURN(prov_result_cache_clear, 0);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(prov_result_cache_clear, __LINE__);
+
         REGISTER_GLOBAL_MOCK_HOOK(json_serialize_to_string, my_json_serialize_to_string);
         REGISTER_GLOBAL_MOCK_HOOK(json_free_serialized_string, my_json_free_serialized_string);
 
@@ -557,6 +579,7 @@ BEGIN_TEST_SUITE(prov_device_client_ll_ut)
         g_challenge_ctx = NULL;
         g_json_parse_cb = NULL;
         g_json_ctx = NULL;
+        g_cache_load_result = __LINE__;
     }
 
     TEST_FUNCTION_CLEANUP(method_cleanup)
@@ -1911,6 +1934,321 @@ BEGIN_TEST_SUITE(prov_device_client_ll_ut)
         Prov_Device_LL_Destroy(handle);
     }
 
+    TEST_FUNCTION(Prov_Device_LL_SetOption_Retry_jitter_NULL_fail)
+    {
+        //arrange
+        PROV_DEVICE_LL_HANDLE handle = Prov_Device_LL_Create(TEST_PROV_URI, TEST_SCOPE_ID, trans_provider);
+        umock_c_reset_all_calls();
+
+        //act
+        PROV_DEVICE_RESULT prov_result = Prov_Device_LL_SetOption(handle, PROV_OPTION_RETRY_JITTER, NULL);
+
+        //assert
+        ASSERT_ARE_EQUAL(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_ERROR, prov_result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        Prov_Device_LL_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_SetOption_Retry_jitter_out_of_range_fail)
+    {
+        //arrange
+        PROV_DEVICE_LL_HANDLE handle = Prov_Device_LL_Create(TEST_PROV_URI, TEST_SCOPE_ID, trans_provider);
+        umock_c_reset_all_calls();
+
+        uint8_t retry_jitter = 101;
+
+        //act
+        PROV_DEVICE_RESULT prov_result = Prov_Device_LL_SetOption(handle, PROV_OPTION_RETRY_JITTER, &retry_jitter);
+
+        //assert
+        ASSERT_ARE_EQUAL(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_ERROR, prov_result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        Prov_Device_LL_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_SetOption_Retry_jitter_success)
+    {
+        //arrange
+        PROV_DEVICE_LL_HANDLE handle = Prov_Device_LL_Create(TEST_PROV_URI, TEST_SCOPE_ID, trans_provider);
+        umock_c_reset_all_calls();
+
+        uint8_t retry_jitter = 25;
+
+        //act
+        PROV_DEVICE_RESULT prov_result = Prov_Device_LL_SetOption(handle, PROV_OPTION_RETRY_JITTER, &retry_jitter);
+
+        //assert
+        ASSERT_ARE_EQUAL(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_OK, prov_result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        Prov_Device_LL_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_SetOption_Result_cache_success)
+    {
+        //arrange
+        PROV_DEVICE_LL_HANDLE handle = Prov_Device_LL_Create(TEST_PROV_URI, TEST_SCOPE_ID, trans_provider);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, TEST_RESULT_CACHE_PATH));
+        STRICT_EXPECTED_CALL(gballoc_free(NULL));
+
+        //act
+        PROV_DEVICE_RESULT prov_result = Prov_Device_LL_SetOption(handle, PROV_OPTION_RESULT_CACHE, TEST_RESULT_CACHE_PATH);
+
+        //assert
+        ASSERT_ARE_EQUAL(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_OK, prov_result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        Prov_Device_LL_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_SetOption_Result_cache_after_register_fail)
+    {
+        //arrange
+        PROV_DEVICE_LL_HANDLE handle = Prov_Device_LL_Create(TEST_PROV_URI, TEST_SCOPE_ID, trans_provider);
+        (void)Prov_Device_LL_Register_Device(handle, on_prov_register_device_callback, NULL, on_prov_register_status_callback, NULL);
+        umock_c_reset_all_calls();
+
+        //act
+        PROV_DEVICE_RESULT prov_result = Prov_Device_LL_SetOption(handle, PROV_OPTION_RESULT_CACHE, TEST_RESULT_CACHE_PATH);
+
+        //assert
+        ASSERT_ARE_EQUAL(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_ERROR, prov_result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        Prov_Device_LL_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Register_Device_result_cache_hit_succeed)
+    {
+        //arrange
+        setup_Prov_Device_LL_Create_mocks(PROV_AUTH_TYPE_X509);
+        PROV_DEVICE_LL_HANDLE handle = Prov_Device_LL_Create(TEST_PROV_URI, TEST_SCOPE_ID, trans_provider);
+        (void)Prov_Device_LL_SetOption(handle, PROV_OPTION_RESULT_CACHE, TEST_RESULT_CACHE_PATH);
+        umock_c_reset_all_calls();
+        g_cache_load_result = 0;
+
+        STRICT_EXPECTED_CALL(prov_auth_get_registration_id(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(prov_result_cache_load(TEST_RESULT_CACHE_PATH, TEST_SCOPE_ID, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+        //act
+        PROV_DEVICE_RESULT prov_result = Prov_Device_LL_Register_Device(handle, on_prov_register_device_callback, NULL, on_prov_register_status_callback, NULL);
+
+        //assert
+        ASSERT_ARE_EQUAL(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_OK, prov_result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        Prov_Device_LL_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_DoWork_result_cache_hit_reports_result)
+    {
+        //arrange
+        setup_Prov_Device_LL_Create_mocks(PROV_AUTH_TYPE_X509);
+        PROV_DEVICE_LL_HANDLE handle = Prov_Device_LL_Create(TEST_PROV_URI, TEST_SCOPE_ID, trans_provider);
+        (void)Prov_Device_LL_SetOption(handle, PROV_OPTION_RESULT_CACHE, TEST_RESULT_CACHE_PATH);
+        g_cache_load_result = 0;
+        (void)Prov_Device_LL_Register_Device(handle, on_prov_register_device_callback, NULL, on_prov_register_status_callback, NULL);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(on_prov_register_device_callback(PROV_DEVICE_RESULT_OK, TEST_IOTHUB, TEST_DEVICE_ID, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        setup_cleanup_prov_info_mocks();
+
+        //act
+        Prov_Device_LL_DoWork(handle);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        Prov_Device_LL_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Register_Device_result_cache_miss_registers)
+    {
+        //arrange
+        setup_Prov_Device_LL_Create_mocks(PROV_AUTH_TYPE_X509);
+        PROV_DEVICE_LL_HANDLE handle = Prov_Device_LL_Create(TEST_PROV_URI, TEST_SCOPE_ID, trans_provider);
+        (void)Prov_Device_LL_SetOption(handle, PROV_OPTION_RESULT_CACHE, TEST_RESULT_CACHE_PATH);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(prov_auth_get_registration_id(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(prov_result_cache_load(TEST_RESULT_CACHE_PATH, TEST_SCOPE_ID, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(prov_auth_get_certificate(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(prov_auth_get_alias_key(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(prov_transport_x509_cert(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(prov_transport_open(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
+
+        //act
+        PROV_DEVICE_RESULT prov_result = Prov_Device_LL_Register_Device(handle, on_prov_register_device_callback, NULL, on_prov_register_status_callback, NULL);
+
+        //assert
+        ASSERT_ARE_EQUAL(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_OK, prov_result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        Prov_Device_LL_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Register_Device_result_cache_tpm_not_used)
+    {
+        //arrange
+        PROV_DEVICE_LL_HANDLE handle = Prov_Device_LL_Create(TEST_PROV_URI, TEST_SCOPE_ID, trans_provider);
+        (void)Prov_Device_LL_SetOption(handle, PROV_OPTION_RESULT_CACHE, TEST_RESULT_CACHE_PATH);
+        umock_c_reset_all_calls();
+        g_cache_load_result = 0;
+
+        setup_Prov_Device_LL_Register_Device_mocks(true);
+
+        //act
+        PROV_DEVICE_RESULT prov_result = Prov_Device_LL_Register_Device(handle, on_prov_register_device_callback, NULL, on_prov_register_status_callback, NULL);
+
+        //assert
+        ASSERT_ARE_EQUAL(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_OK, prov_result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        Prov_Device_LL_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_on_registration_data_result_cache_saved)
+    {
+        //arrange
+        setup_Prov_Device_LL_Create_mocks(PROV_AUTH_TYPE_X509);
+        PROV_DEVICE_LL_HANDLE handle = Prov_Device_LL_Create(TEST_PROV_URI, TEST_SCOPE_ID, trans_provider);
+        (void)Prov_Device_LL_SetOption(handle, PROV_OPTION_RESULT_CACHE, TEST_RESULT_CACHE_PATH);
+        (void)Prov_Device_LL_Register_Device(handle, on_prov_register_device_callback, NULL, on_prov_register_status_callback, NULL);
+        g_status_callback(PROV_DEVICE_TRANSPORT_STATUS_CONNECTED, DEFAULT_RETRY_AFTER, g_status_ctx);
+        Prov_Device_LL_DoWork(handle);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(prov_result_cache_save(TEST_RESULT_CACHE_PATH, TEST_SCOPE_ID, IGNORED_PTR_ARG, TEST_IOTHUB, TEST_DEVICE_ID));
+        STRICT_EXPECTED_CALL(on_prov_register_device_callback(PROV_DEVICE_RESULT_OK, TEST_IOTHUB, TEST_DEVICE_ID, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(prov_transport_close(IGNORED_PTR_ARG));
+        setup_cleanup_prov_info_mocks();
+
+        //act
+        g_registration_callback(PROV_DEVICE_TRANSPORT_RESULT_OK, NULL, TEST_IOTHUB, TEST_DEVICE_ID, g_registration_ctx);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        Prov_Device_LL_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_on_registration_data_result_cache_save_fail_still_reports)
+    {
+        //arrange
+        setup_Prov_Device_LL_Create_mocks(PROV_AUTH_TYPE_X509);
+        PROV_DEVICE_LL_HANDLE handle = Prov_Device_LL_Create(TEST_PROV_URI, TEST_SCOPE_ID, trans_provider);
+        (void)Prov_Device_LL_SetOption(handle, PROV_OPTION_RESULT_CACHE, TEST_RESULT_CACHE_PATH);
+        (void)Prov_Device_LL_Register_Device(handle, on_prov_register_device_callback, NULL, on_prov_register_status_callback, NULL);
+        g_status_callback(PROV_DEVICE_TRANSPORT_STATUS_CONNECTED, DEFAULT_RETRY_AFTER, g_status_ctx);
+        Prov_Device_LL_DoWork(handle);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(prov_result_cache_save(TEST_RESULT_CACHE_PATH, TEST_SCOPE_ID, IGNORED_PTR_ARG, TEST_IOTHUB, TEST_DEVICE_ID)).SetReturn(__LINE__);
+        STRICT_EXPECTED_CALL(on_prov_register_device_callback(PROV_DEVICE_RESULT_OK, TEST_IOTHUB, TEST_DEVICE_ID, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(prov_transport_close(IGNORED_PTR_ARG));
+        setup_cleanup_prov_info_mocks();
+
+        //act
+        g_registration_callback(PROV_DEVICE_TRANSPORT_RESULT_OK, NULL, TEST_IOTHUB, TEST_DEVICE_ID, g_registration_ctx);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        Prov_Device_LL_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Invalidate_Cached_Result_handle_NULL_fail)
+    {
+        //arrange
+
+        //act
+        PROV_DEVICE_RESULT prov_result = Prov_Device_LL_Invalidate_Cached_Result(NULL);
+
+        //assert
+        ASSERT_ARE_EQUAL(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_INVALID_ARG, prov_result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Invalidate_Cached_Result_no_cache_succeed)
+    {
+        //arrange
+        PROV_DEVICE_LL_HANDLE handle = Prov_Device_LL_Create(TEST_PROV_URI, TEST_SCOPE_ID, trans_provider);
+        umock_c_reset_all_calls();
+
+        //act
+        PROV_DEVICE_RESULT prov_result = Prov_Device_LL_Invalidate_Cached_Result(handle);
+
+        //assert
+        ASSERT_ARE_EQUAL(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_OK, prov_result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        Prov_Device_LL_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Invalidate_Cached_Result_succeed)
+    {
+        //arrange
+        PROV_DEVICE_LL_HANDLE handle = Prov_Device_LL_Create(TEST_PROV_URI, TEST_SCOPE_ID, trans_provider);
+        (void)Prov_Device_LL_SetOption(handle, PROV_OPTION_RESULT_CACHE, TEST_RESULT_CACHE_PATH);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(prov_result_cache_clear(TEST_RESULT_CACHE_PATH));
+
+        //act
+        PROV_DEVICE_RESULT prov_result = Prov_Device_LL_Invalidate_Cached_Result(handle);
+
+        //assert
+        ASSERT_ARE_EQUAL(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_OK, prov_result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        Prov_Device_LL_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Invalidate_Cached_Result_clear_fail)
+    {
+        //arrange
+        PROV_DEVICE_LL_HANDLE handle = Prov_Device_LL_Create(TEST_PROV_URI, TEST_SCOPE_ID, trans_provider);
+        (void)Prov_Device_LL_SetOption(handle, PROV_OPTION_RESULT_CACHE, TEST_RESULT_CACHE_PATH);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(prov_result_cache_clear(TEST_RESULT_CACHE_PATH)).SetReturn(__LINE__);
+
+        //act
+        PROV_DEVICE_RESULT prov_result = Prov_Device_LL_Invalidate_Cached_Result(handle);
+
+        //assert
+        ASSERT_ARE_EQUAL(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_ERROR, prov_result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        Prov_Device_LL_Destroy(handle);
+    }
+
     TEST_FUNCTION(Prov_Device_LL_Set_Provisioning_Payload_handle_NULL_fail)
     {
         //arrange
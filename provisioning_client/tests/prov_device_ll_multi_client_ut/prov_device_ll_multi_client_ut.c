@@ -0,0 +1,857 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <string.h>
+#endif
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void* my_gballoc_realloc(void* ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#include "testrunnerswitcher.h"
+#include "umock_c/umock_c.h"
+#include "umock_c/umocktypes_charptr.h"
+#include "umock_c/umocktypes_bool.h"
+#include "umock_c/umocktypes_stdint.h"
+#include "umock_c/umock_c_negative_tests.h"
+#include "azure_macro_utils/macro_utils.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+
+#include "azure_prov_client/prov_device_ll_client.h"
+#include "azure_prov_client/prov_security_factory.h"
+#undef ENABLE_MOCKS
+
+#include "azure_prov_client/prov_device_ll_multi_client.h"
+
+#define ENABLE_MOCKS
+#include "umock_c/umock_c_prod.h"
+MOCKABLE_FUNCTION(, void, on_multi_register_device_callback, PROV_DEVICE_RESULT, register_result, const char*, iothub_uri, const char*, device_id, void*, user_context);
+#undef ENABLE_MOCKS
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    SINGLYLINKEDLIST_HANDLE real_singlylinkedlist_create(void);
+    void real_singlylinkedlist_destroy(SINGLYLINKEDLIST_HANDLE list);
+    LIST_ITEM_HANDLE real_singlylinkedlist_add(SINGLYLINKEDLIST_HANDLE list, const void* item);
+    int real_singlylinkedlist_remove(SINGLYLINKEDLIST_HANDLE list, LIST_ITEM_HANDLE item_handle);
+    LIST_ITEM_HANDLE real_singlylinkedlist_get_head_item(SINGLYLINKEDLIST_HANDLE list);
+    const void* real_singlylinkedlist_item_get_value(LIST_ITEM_HANDLE item_handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+#define TEST_MAX_REGISTRATIONS      10
+
+static const char* TEST_PROV_URI = "www.prov_uri.com";
+static const char* TEST_SCOPE_ID = "scope_id";
+static const char* TEST_REGISTRATION_ID = "registration_id";
+static const char* TEST_KEY = "AD87D58E-4E52-411B-9C63-49BD02C84F0D";
+static const char* TEST_IOTHUB = "iothub.value.test";
+static const char* TEST_DEVICE_ID = "device_id";
+
+static tickcounter_ms_t g_current_ms;
+static PROV_DEVICE_CLIENT_REGISTER_DEVICE_CALLBACK g_register_callback;
+static void* g_register_contexts[TEST_MAX_REGISTRATIONS];
+static size_t g_register_count;
+
+TEST_DEFINE_ENUM_TYPE(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_VALUE);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_VALUE);
+
+MU_DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", MU_ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+static const PROV_DEVICE_TRANSPORT_PROVIDER* test_protocol(void)
+{
+    return NULL;
+}
+
+static int my_mallocAndStrcpy_s(char** destination, const char* source)
+{
+    size_t src_len = strlen(source);
+    *destination = (char*)my_gballoc_malloc(src_len + 1);
+    strcpy(*destination, source);
+    return 0;
+}
+
+static TICK_COUNTER_HANDLE my_tickcounter_create(void)
+{
+    return (TICK_COUNTER_HANDLE)my_gballoc_malloc(1);
+}
+
+static void my_tickcounter_destroy(TICK_COUNTER_HANDLE tick_counter)
+{
+    my_gballoc_free(tick_counter);
+}
+
+static int my_tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t* current_ms)
+{
+    (void)tick_counter;
+    *current_ms = g_current_ms;
+    return 0;
+}
+
+static PROV_DEVICE_LL_HANDLE my_Prov_Device_LL_Create(const char* uri, const char* scope_id, PROV_DEVICE_TRANSPORT_PROVIDER_FUNCTION protocol)
+{
+    (void)uri;
+    (void)scope_id;
+    (void)protocol;
+    return (PROV_DEVICE_LL_HANDLE)my_gballoc_malloc(1);
+}
+
+static void my_Prov_Device_LL_Destroy(PROV_DEVICE_LL_HANDLE handle)
+{
+    my_gballoc_free(handle);
+}
+
+static PROV_DEVICE_RESULT my_Prov_Device_LL_Register_Device(PROV_DEVICE_LL_HANDLE handle, PROV_DEVICE_CLIENT_REGISTER_DEVICE_CALLBACK register_callback, void* user_context, PROV_DEVICE_CLIENT_REGISTER_STATUS_CALLBACK reg_status_cb, void* status_user_ctext)
+{
+    (void)handle;
+    (void)reg_status_cb;
+    (void)status_user_ctext;
+    g_register_callback = register_callback;
+    if (g_register_count < TEST_MAX_REGISTRATIONS)
+    {
+        g_register_contexts[g_register_count++] = user_context;
+    }
+    return PROV_DEVICE_RESULT_OK;
+}
+
+BEGIN_TEST_SUITE(prov_device_ll_multi_client_ut)
+
+    TEST_SUITE_INITIALIZE(suite_init)
+    {
+        int result;
+
+        g_testByTest = TEST_MUTEX_CREATE();
+        ASSERT_IS_NOT_NULL(g_testByTest);
+
+        (void)umock_c_init(on_umock_c_error);
+        (void)umocktypes_bool_register_types();
+
+        result = umocktypes_charptr_register_types();
+        ASSERT_ARE_EQUAL(int, 0, result);
+        result = umocktypes_stdint_register_types();
+        ASSERT_ARE_EQUAL(int, 0, result);
+
+        REGISTER_TYPE(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT);
+
+        REGISTER_UMOCK_ALIAS_TYPE(PROV_DEVICE_LL_HANDLE, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(PROV_DEVICE_TRANSPORT_PROVIDER_FUNCTION, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(PROV_DEVICE_CLIENT_REGISTER_DEVICE_CALLBACK, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(PROV_DEVICE_CLIENT_REGISTER_STATUS_CALLBACK, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(SINGLYLINKEDLIST_HANDLE, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(LIST_ITEM_HANDLE, void*);
+
+        REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+        REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_realloc, NULL);
+        REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+        REGISTER_GLOBAL_MOCK_HOOK(mallocAndStrcpy_s, my_mallocAndStrcpy_s);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(mallocAndStrcpy_s, __LINE__);
+
+        REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_create, real_singlylinkedlist_create);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(singlylinkedlist_create, NULL);
+        REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_destroy, real_singlylinkedlist_destroy);
+        REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_add, real_singlylinkedlist_add);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(singlylinkedlist_add, NULL);
+        REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_remove, real_singlylinkedlist_remove);
+        REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_head_item, real_singlylinkedlist_get_head_item);
+        REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_item_get_value, real_singlylinkedlist_item_get_value);
+
+        REGISTER_GLOBAL_MOCK_HOOK(tickcounter_create, my_tickcounter_create);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(tickcounter_create, NULL);
+        REGISTER_GLOBAL_MOCK_HOOK(tickcounter_destroy, my_tickcounter_destroy);
+        REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, my_tickcounter_get_current_ms);
+
+        REGISTER_GLOBAL_MOCK_RETURN(prov_dev_set_symmetric_key_info, 0);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(prov_dev_set_symmetric_key_info, __LINE__);
+
+        REGISTER_GLOBAL_MOCK_HOOK(Prov_Device_LL_Create, my_Prov_Device_LL_Create);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(Prov_Device_LL_Create, NULL);
+        REGISTER_GLOBAL_MOCK_HOOK(Prov_Device_LL_Destroy, my_Prov_Device_LL_Destroy);
+        REGISTER_GLOBAL_MOCK_HOOK(Prov_Device_LL_Register_Device, my_Prov_Device_LL_Register_Device);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(Prov_Device_LL_Register_Device, PROV_DEVICE_RESULT_ERROR);
+        REGISTER_GLOBAL_MOCK_RETURN(Prov_Device_LL_SetOption, PROV_DEVICE_RESULT_OK);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(Prov_Device_LL_SetOption, PROV_DEVICE_RESULT_ERROR);
+    }
+
+    TEST_SUITE_CLEANUP(suite_cleanup)
+    {
+        umock_c_deinit();
+
+        TEST_MUTEX_DESTROY(g_testByTest);
+    }
+
+    TEST_FUNCTION_INITIALIZE(method_init)
+    {
+        if (TEST_MUTEX_ACQUIRE(g_testByTest))
+        {
+            ASSERT_FAIL("Could not acquire test serialization mutex.");
+        }
+        umock_c_reset_all_calls();
+        g_current_ms = 0;
+        g_register_callback = NULL;
+        memset(g_register_contexts, 0, sizeof(g_register_contexts));
+        g_register_count = 0;
+    }
+
+    TEST_FUNCTION_CLEANUP(method_cleanup)
+    {
+        TEST_MUTEX_RELEASE(g_testByTest);
+    }
+
+    static void setup_Prov_Device_LL_Multi_Create_mocks(void)
+    {
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, TEST_PROV_URI));
+        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, TEST_SCOPE_ID));
+        STRICT_EXPECTED_CALL(singlylinkedlist_create());
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+        STRICT_EXPECTED_CALL(tickcounter_create());
+    }
+
+    static void setup_Prov_Device_LL_Multi_Add_Registration_mocks(void)
+    {
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, TEST_REGISTRATION_ID));
+        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, TEST_KEY));
+        STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    }
+
+    static void setup_start_registration_mocks(void)
+    {
+        STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(singlylinkedlist_remove(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(prov_dev_set_symmetric_key_info(TEST_REGISTRATION_ID, TEST_KEY));
+        STRICT_EXPECTED_CALL(Prov_Device_LL_Create(TEST_PROV_URI, TEST_SCOPE_ID, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Prov_Device_LL_SetOption(IGNORED_PTR_ARG, PROV_REGISTRATION_ID, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Prov_Device_LL_Register_Device(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    }
+
+    static void setup_destroy_registration_mocks(void)
+    {
+        STRICT_EXPECTED_CALL(Prov_Device_LL_Destroy(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    }
+
+    static PROV_DEVICE_LL_MULTI_HANDLE create_with_registrations(size_t max_in_progress, size_t registration_count)
+    {
+        size_t index;
+        PROV_DEVICE_LL_MULTI_HANDLE handle = Prov_Device_LL_Multi_Create(TEST_PROV_URI, TEST_SCOPE_ID, test_protocol, max_in_progress);
+        ASSERT_IS_NOT_NULL(handle);
+        for (index = 0; index < registration_count; index++)
+        {
+            PROV_DEVICE_RESULT result = Prov_Device_LL_Multi_Add_Registration(handle, TEST_REGISTRATION_ID, TEST_KEY, on_multi_register_device_callback, NULL);
+            ASSERT_ARE_EQUAL(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_OK, result);
+        }
+        umock_c_reset_all_calls();
+        return handle;
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Multi_Create_uri_NULL_fail)
+    {
+        //arrange
+
+        //act
+        PROV_DEVICE_LL_MULTI_HANDLE result = Prov_Device_LL_Multi_Create(NULL, TEST_SCOPE_ID, test_protocol, 1);
+
+        //assert
+        ASSERT_IS_NULL(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Multi_Create_scope_id_NULL_fail)
+    {
+        //arrange
+
+        //act
+        PROV_DEVICE_LL_MULTI_HANDLE result = Prov_Device_LL_Multi_Create(TEST_PROV_URI, NULL, test_protocol, 1);
+
+        //assert
+        ASSERT_IS_NULL(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Multi_Create_protocol_NULL_fail)
+    {
+        //arrange
+
+        //act
+        PROV_DEVICE_LL_MULTI_HANDLE result = Prov_Device_LL_Multi_Create(TEST_PROV_URI, TEST_SCOPE_ID, NULL, 1);
+
+        //assert
+        ASSERT_IS_NULL(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Multi_Create_max_in_progress_zero_fail)
+    {
+        //arrange
+
+        //act
+        PROV_DEVICE_LL_MULTI_HANDLE result = Prov_Device_LL_Multi_Create(TEST_PROV_URI, TEST_SCOPE_ID, test_protocol, 0);
+
+        //assert
+        ASSERT_IS_NULL(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Multi_Create_succeed)
+    {
+        //arrange
+        setup_Prov_Device_LL_Multi_Create_mocks();
+
+        //act
+        PROV_DEVICE_LL_MULTI_HANDLE result = Prov_Device_LL_Multi_Create(TEST_PROV_URI, TEST_SCOPE_ID, test_protocol, 1);
+
+        //assert
+        ASSERT_IS_NOT_NULL(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        Prov_Device_LL_Multi_Destroy(result);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Multi_Create_fail)
+    {
+        //arrange
+        int negativeTestsInitResult = umock_c_negative_tests_init();
+        ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+
+        setup_Prov_Device_LL_Multi_Create_mocks();
+
+        umock_c_negative_tests_snapshot();
+
+        size_t count = umock_c_negative_tests_call_count();
+        for (size_t index = 0; index < count; index++)
+        {
+            umock_c_negative_tests_reset();
+            umock_c_negative_tests_fail_call(index);
+
+            char tmp_msg[64];
+            sprintf(tmp_msg, "Prov_Device_LL_Multi_Create failure in test %lu/%lu", (unsigned long)index, (unsigned long)count);
+
+            //act
+            PROV_DEVICE_LL_MULTI_HANDLE result = Prov_Device_LL_Multi_Create(TEST_PROV_URI, TEST_SCOPE_ID, test_protocol, 1);
+
+            //assert
+            ASSERT_IS_NULL(result, tmp_msg);
+        }
+
+        //cleanup
+        umock_c_negative_tests_deinit();
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Multi_Destroy_handle_NULL_succeed)
+    {
+        //arrange
+
+        //act
+        Prov_Device_LL_Multi_Destroy(NULL);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Multi_Destroy_drops_registrations_succeed)
+    {
+        //arrange
+        PROV_DEVICE_LL_MULTI_HANDLE handle = create_with_registrations(1, 2);
+        Prov_Device_LL_Multi_DoWork(handle);
+        umock_c_reset_all_calls();
+
+        // The registration in progress and the queued one are dropped without calling back
+        setup_destroy_registration_mocks();
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(singlylinkedlist_remove(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(singlylinkedlist_destroy(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(tickcounter_destroy(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+        //act
+        Prov_Device_LL_Multi_Destroy(handle);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Multi_Add_Registration_handle_NULL_fail)
+    {
+        //arrange
+
+        //act
+        PROV_DEVICE_RESULT result = Prov_Device_LL_Multi_Add_Registration(NULL, TEST_REGISTRATION_ID, TEST_KEY, on_multi_register_device_callback, NULL);
+
+        //assert
+        ASSERT_ARE_EQUAL(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_INVALID_ARG, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Multi_Add_Registration_registration_id_NULL_fail)
+    {
+        //arrange
+        PROV_DEVICE_LL_MULTI_HANDLE handle = create_with_registrations(1, 0);
+
+        //act
+        PROV_DEVICE_RESULT result = Prov_Device_LL_Multi_Add_Registration(handle, NULL, TEST_KEY, on_multi_register_device_callback, NULL);
+
+        //assert
+        ASSERT_ARE_EQUAL(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_INVALID_ARG, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        Prov_Device_LL_Multi_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Multi_Add_Registration_callback_NULL_fail)
+    {
+        //arrange
+        PROV_DEVICE_LL_MULTI_HANDLE handle = create_with_registrations(1, 0);
+
+        //act
+        PROV_DEVICE_RESULT result = Prov_Device_LL_Multi_Add_Registration(handle, TEST_REGISTRATION_ID, TEST_KEY, NULL, NULL);
+
+        //assert
+        ASSERT_ARE_EQUAL(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_INVALID_ARG, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        Prov_Device_LL_Multi_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Multi_Add_Registration_succeed)
+    {
+        //arrange
+        PROV_DEVICE_MULTI_STATISTICS statistics;
+        PROV_DEVICE_LL_MULTI_HANDLE handle = create_with_registrations(1, 0);
+        setup_Prov_Device_LL_Multi_Add_Registration_mocks();
+
+        //act
+        PROV_DEVICE_RESULT result = Prov_Device_LL_Multi_Add_Registration(handle, TEST_REGISTRATION_ID, TEST_KEY, on_multi_register_device_callback, NULL);
+
+        //assert
+        ASSERT_ARE_EQUAL(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_OK, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        (void)Prov_Device_LL_Multi_Get_Statistics(handle, &statistics);
+        ASSERT_ARE_EQUAL(size_t, 1, statistics.registrations_queued);
+
+        //cleanup
+        Prov_Device_LL_Multi_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Multi_Add_Registration_without_key_after_keyed_fail)
+    {
+        //arrange
+        PROV_DEVICE_MULTI_STATISTICS statistics;
+        PROV_DEVICE_LL_MULTI_HANDLE handle = create_with_registrations(1, 1);
+
+        //act
+        PROV_DEVICE_RESULT result = Prov_Device_LL_Multi_Add_Registration(handle, TEST_REGISTRATION_ID, NULL, on_multi_register_device_callback, NULL);
+
+        //assert
+        ASSERT_ARE_EQUAL(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_INVALID_ARG, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        (void)Prov_Device_LL_Multi_Get_Statistics(handle, &statistics);
+        ASSERT_ARE_EQUAL(size_t, 1, statistics.registrations_queued);
+
+        //cleanup
+        Prov_Device_LL_Multi_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Multi_Add_Registration_with_key_after_unkeyed_fail)
+    {
+        //arrange
+        PROV_DEVICE_LL_MULTI_HANDLE handle = create_with_registrations(1, 0);
+        PROV_DEVICE_RESULT result = Prov_Device_LL_Multi_Add_Registration(handle, TEST_REGISTRATION_ID, NULL, on_multi_register_device_callback, NULL);
+        ASSERT_ARE_EQUAL(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_OK, result);
+        umock_c_reset_all_calls();
+
+        //act
+        result = Prov_Device_LL_Multi_Add_Registration(handle, TEST_REGISTRATION_ID, TEST_KEY, on_multi_register_device_callback, NULL);
+
+        //assert
+        ASSERT_ARE_EQUAL(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_INVALID_ARG, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        Prov_Device_LL_Multi_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Multi_Add_Registration_fail)
+    {
+        //arrange
+        PROV_DEVICE_LL_MULTI_HANDLE handle = create_with_registrations(1, 0);
+
+        int negativeTestsInitResult = umock_c_negative_tests_init();
+        ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+
+        setup_Prov_Device_LL_Multi_Add_Registration_mocks();
+
+        umock_c_negative_tests_snapshot();
+
+        size_t count = umock_c_negative_tests_call_count();
+        for (size_t index = 0; index < count; index++)
+        {
+            umock_c_negative_tests_reset();
+            umock_c_negative_tests_fail_call(index);
+
+            char tmp_msg[64];
+            sprintf(tmp_msg, "Prov_Device_LL_Multi_Add_Registration failure in test %lu/%lu", (unsigned long)index, (unsigned long)count);
+
+            //act
+            PROV_DEVICE_RESULT result = Prov_Device_LL_Multi_Add_Registration(handle, TEST_REGISTRATION_ID, TEST_KEY, on_multi_register_device_callback, NULL);
+
+            //assert
+            ASSERT_ARE_NOT_EQUAL(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_OK, result, tmp_msg);
+        }
+
+        //cleanup
+        umock_c_negative_tests_deinit();
+        Prov_Device_LL_Multi_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Multi_DoWork_handle_NULL_succeed)
+    {
+        //arrange
+
+        //act
+        Prov_Device_LL_Multi_DoWork(NULL);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Multi_DoWork_starts_up_to_max_in_progress_succeed)
+    {
+        //arrange
+        PROV_DEVICE_MULTI_STATISTICS statistics;
+        PROV_DEVICE_LL_MULTI_HANDLE handle = create_with_registrations(2, 3);
+
+        setup_start_registration_mocks();
+        setup_start_registration_mocks();
+        STRICT_EXPECTED_CALL(Prov_Device_LL_DoWork(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Prov_Device_LL_DoWork(IGNORED_PTR_ARG));
+
+        //act
+        Prov_Device_LL_Multi_DoWork(handle);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        (void)Prov_Device_LL_Multi_Get_Statistics(handle, &statistics);
+        ASSERT_ARE_EQUAL(size_t, 1, statistics.registrations_queued);
+        ASSERT_ARE_EQUAL(size_t, 2, statistics.registrations_in_progress);
+
+        //cleanup
+        Prov_Device_LL_Multi_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Multi_DoWork_applies_options_succeed)
+    {
+        //arrange
+        uint8_t retry_jitter = 25;
+        PROV_DEVICE_LL_MULTI_HANDLE handle = create_with_registrations(1, 1);
+        (void)Prov_Device_LL_Multi_SetOption(handle, PROV_OPTION_RETRY_JITTER, &retry_jitter);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(singlylinkedlist_remove(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(prov_dev_set_symmetric_key_info(TEST_REGISTRATION_ID, TEST_KEY));
+        STRICT_EXPECTED_CALL(Prov_Device_LL_Create(TEST_PROV_URI, TEST_SCOPE_ID, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Prov_Device_LL_SetOption(IGNORED_PTR_ARG, PROV_REGISTRATION_ID, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Prov_Device_LL_SetOption(IGNORED_PTR_ARG, PROV_OPTION_RETRY_JITTER, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Prov_Device_LL_Register_Device(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Prov_Device_LL_DoWork(IGNORED_PTR_ARG));
+
+        //act
+        Prov_Device_LL_Multi_DoWork(handle);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        Prov_Device_LL_Multi_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Multi_DoWork_start_fail_reports_error)
+    {
+        //arrange
+        PROV_DEVICE_MULTI_STATISTICS statistics;
+        PROV_DEVICE_LL_MULTI_HANDLE handle = create_with_registrations(1, 1);
+
+        STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(singlylinkedlist_remove(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(prov_dev_set_symmetric_key_info(TEST_REGISTRATION_ID, TEST_KEY));
+        STRICT_EXPECTED_CALL(Prov_Device_LL_Create(TEST_PROV_URI, TEST_SCOPE_ID, IGNORED_PTR_ARG)).SetReturn(NULL);
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(on_multi_register_device_callback(PROV_DEVICE_RESULT_ERROR, NULL, NULL, NULL));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+
+        //act
+        Prov_Device_LL_Multi_DoWork(handle);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        (void)Prov_Device_LL_Multi_Get_Statistics(handle, &statistics);
+        ASSERT_ARE_EQUAL(size_t, 0, statistics.registrations_in_progress);
+        ASSERT_ARE_EQUAL(size_t, 1, statistics.registrations_failed);
+
+        //cleanup
+        Prov_Device_LL_Multi_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Multi_DoWork_completed_registration_destroyed_succeed)
+    {
+        //arrange
+        PROV_DEVICE_MULTI_STATISTICS statistics;
+        PROV_DEVICE_LL_MULTI_HANDLE handle = create_with_registrations(1, 1);
+        Prov_Device_LL_Multi_DoWork(handle);
+        g_register_callback(PROV_DEVICE_RESULT_OK, TEST_IOTHUB, TEST_DEVICE_ID, g_register_contexts[0]);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(Prov_Device_LL_DoWork(IGNORED_PTR_ARG));
+        setup_destroy_registration_mocks();
+
+        //act
+        Prov_Device_LL_Multi_DoWork(handle);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        (void)Prov_Device_LL_Multi_Get_Statistics(handle, &statistics);
+        ASSERT_ARE_EQUAL(size_t, 0, statistics.registrations_in_progress);
+        ASSERT_ARE_EQUAL(size_t, 1, statistics.registrations_succeeded);
+
+        //cleanup
+        Prov_Device_LL_Multi_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Multi_registration_callback_succeed)
+    {
+        //arrange
+        PROV_DEVICE_LL_MULTI_HANDLE handle = create_with_registrations(1, 1);
+        Prov_Device_LL_Multi_DoWork(handle);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+        STRICT_EXPECTED_CALL(on_multi_register_device_callback(PROV_DEVICE_RESULT_OK, TEST_IOTHUB, TEST_DEVICE_ID, NULL));
+
+        //act
+        g_register_callback(PROV_DEVICE_RESULT_OK, TEST_IOTHUB, TEST_DEVICE_ID, g_register_contexts[0]);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        Prov_Device_LL_Multi_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Multi_registration_callback_latency_alloc_fail_retried_on_next_sample)
+    {
+        //arrange
+        PROV_DEVICE_MULTI_STATISTICS statistics;
+        PROV_DEVICE_LL_MULTI_HANDLE handle = create_with_registrations(2, 2);
+        Prov_Device_LL_Multi_DoWork(handle);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+            .SetReturn(NULL);
+        STRICT_EXPECTED_CALL(on_multi_register_device_callback(PROV_DEVICE_RESULT_OK, TEST_IOTHUB, TEST_DEVICE_ID, NULL));
+        STRICT_EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+        STRICT_EXPECTED_CALL(on_multi_register_device_callback(PROV_DEVICE_RESULT_OK, TEST_IOTHUB, TEST_DEVICE_ID, NULL));
+
+        //act
+        g_current_ms = 10;
+        g_register_callback(PROV_DEVICE_RESULT_OK, TEST_IOTHUB, TEST_DEVICE_ID, g_register_contexts[0]);
+        g_current_ms = 20;
+        g_register_callback(PROV_DEVICE_RESULT_OK, TEST_IOTHUB, TEST_DEVICE_ID, g_register_contexts[1]);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        (void)Prov_Device_LL_Multi_Get_Statistics(handle, &statistics);
+        ASSERT_ARE_EQUAL(size_t, 2, statistics.registrations_succeeded);
+        ASSERT_ARE_EQUAL(size_t, 1, statistics.latency_sample_count);
+        ASSERT_ARE_EQUAL(uint32_t, 20, statistics.latency_max_ms);
+
+        //cleanup
+        Prov_Device_LL_Multi_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Multi_SetOption_handle_NULL_fail)
+    {
+        //arrange
+        uint8_t retry_jitter = 25;
+
+        //act
+        PROV_DEVICE_RESULT result = Prov_Device_LL_Multi_SetOption(NULL, PROV_OPTION_RETRY_JITTER, &retry_jitter);
+
+        //assert
+        ASSERT_ARE_EQUAL(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_INVALID_ARG, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Multi_SetOption_unsupported_fail)
+    {
+        //arrange
+        uint8_t value = 1;
+        PROV_DEVICE_LL_MULTI_HANDLE handle = create_with_registrations(1, 0);
+
+        //act
+        PROV_DEVICE_RESULT result = Prov_Device_LL_Multi_SetOption(handle, "unsupported_option", &value);
+
+        //assert
+        ASSERT_ARE_EQUAL(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_INVALID_ARG, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        Prov_Device_LL_Multi_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Multi_SetOption_trusted_cert_succeed)
+    {
+        //arrange
+        PROV_DEVICE_LL_MULTI_HANDLE handle = create_with_registrations(1, 0);
+
+        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "trusted_cert"));
+
+        //act
+        PROV_DEVICE_RESULT result = Prov_Device_LL_Multi_SetOption(handle, OPTION_TRUSTED_CERT, "trusted_cert");
+
+        //assert
+        ASSERT_ARE_EQUAL(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_OK, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        Prov_Device_LL_Multi_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Multi_Get_Statistics_statistics_NULL_fail)
+    {
+        //arrange
+        PROV_DEVICE_LL_MULTI_HANDLE handle = create_with_registrations(1, 0);
+
+        //act
+        PROV_DEVICE_RESULT result = Prov_Device_LL_Multi_Get_Statistics(handle, NULL);
+
+        //assert
+        ASSERT_ARE_EQUAL(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_INVALID_ARG, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        Prov_Device_LL_Multi_Destroy(handle);
+    }
+
+    TEST_FUNCTION(Prov_Device_LL_Multi_Get_Statistics_percentiles_succeed)
+    {
+        //arrange
+        size_t index;
+        PROV_DEVICE_MULTI_STATISTICS statistics;
+        PROV_DEVICE_LL_MULTI_HANDLE handle = create_with_registrations(TEST_MAX_REGISTRATIONS, TEST_MAX_REGISTRATIONS);
+        Prov_Device_LL_Multi_DoWork(handle);
+
+        for (index = 0; index < TEST_MAX_REGISTRATIONS; index++)
+        {
+            g_current_ms = (index + 1) * 10;
+            g_register_callback(PROV_DEVICE_RESULT_OK, TEST_IOTHUB, TEST_DEVICE_ID, g_register_contexts[index]);
+        }
+        Prov_Device_LL_Multi_DoWork(handle);
+        umock_c_reset_all_calls();
+
+        //act
+        PROV_DEVICE_RESULT result = Prov_Device_LL_Multi_Get_Statistics(handle, &statistics);
+
+        //assert
+        ASSERT_ARE_EQUAL(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_OK, result);
+        ASSERT_ARE_EQUAL(size_t, 0, statistics.registrations_queued);
+        ASSERT_ARE_EQUAL(size_t, 0, statistics.registrations_in_progress);
+        ASSERT_ARE_EQUAL(size_t, TEST_MAX_REGISTRATIONS, statistics.registrations_succeeded);
+        ASSERT_ARE_EQUAL(size_t, 0, statistics.registrations_failed);
+        ASSERT_ARE_EQUAL(size_t, TEST_MAX_REGISTRATIONS, statistics.latency_sample_count);
+        ASSERT_ARE_EQUAL(uint32_t, 50, statistics.latency_p50_ms);
+        ASSERT_ARE_EQUAL(uint32_t, 90, statistics.latency_p90_ms);
+        ASSERT_ARE_EQUAL(uint32_t, 100, statistics.latency_p99_ms);
+        ASSERT_ARE_EQUAL(uint32_t, 100, statistics.latency_max_ms);
+        ASSERT_IS_TRUE(statistics.registrations_per_second > 99.9 && statistics.registrations_per_second < 100.1);
+
+        //cleanup
+        Prov_Device_LL_Multi_Destroy(handle);
+    }
+
+    END_TEST_SUITE(prov_device_ll_multi_client_ut)
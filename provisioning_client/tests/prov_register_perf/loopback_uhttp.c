@@ -0,0 +1,271 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// Device Provisioning Service stand-in: replaces the uhttp client (these definitions take precedence over the uhttp
+// library) and answers the requests of the HTTP provisioning transport in process.  A connection opens on its first
+// DoWork.  The register PUT is answered with "assigning" and a Retry-After of loopback_uhttp_retry_after_secs, and
+// the operation status GET keeps answering "assigning" until it has been polled loopback_uhttp_status_polls times,
+// then answers "assigned" with the registration id as the device id.  With no polls the PUT is assigned right away.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "azure_c_shared_utility/httpheaders.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_uhttp_c/uhttp.h"
+
+#define HTTP_STATUS_OK          200
+#define HTTP_STATUS_ACCEPTED    202
+#define MAX_REGISTRATION_ID     128
+#define MAX_RESPONSE_SIZE       512
+
+static const char* REGISTRATIONS_SEGMENT = "/registrations/";
+static const char* ASSIGNED_HUB = "loopback.azure-devices.net";
+
+unsigned int loopback_uhttp_status_polls = 1;
+unsigned int loopback_uhttp_retry_after_secs = 1;
+
+typedef struct HTTP_CLIENT_HANDLE_DATA_TAG
+{
+    ON_HTTP_OPEN_COMPLETE_CALLBACK on_connect;
+    void* connect_ctx;
+    bool is_open_pending;
+
+    ON_HTTP_REQUEST_CALLBACK on_request;
+    void* request_ctx;
+    HTTP_CLIENT_REQUEST_TYPE request_type;
+    bool is_request_pending;
+
+    char registration_id[MAX_REGISTRATION_ID];
+    unsigned int status_polls;
+} HTTP_CLIENT_HANDLE_DATA;
+
+// Takes the registration id from /{scope}/registrations/{registration id}/...
+static void copy_registration_id(HTTP_CLIENT_HANDLE_DATA* http_data, const char* relative_path)
+{
+    const char* start = strstr(relative_path, REGISTRATIONS_SEGMENT);
+    if (start != NULL)
+    {
+        size_t length;
+
+        start += strlen(REGISTRATIONS_SEGMENT);
+        length = strcspn(start, "/?");
+        if (length >= MAX_REGISTRATION_ID)
+        {
+            length = MAX_REGISTRATION_ID - 1;
+        }
+        memcpy(http_data->registration_id, start, length);
+        http_data->registration_id[length] = '\0';
+    }
+}
+
+static void send_reply(HTTP_CLIENT_HANDLE_DATA* http_data)
+{
+    char response[MAX_RESPONSE_SIZE];
+    unsigned int status_code;
+    HTTP_HEADERS_HANDLE response_headers;
+    int length;
+    bool is_assigned;
+
+    if (http_data->request_type == HTTP_CLIENT_REQUEST_PUT)
+    {
+        http_data->status_polls = 0;
+        is_assigned = (loopback_uhttp_status_polls == 0);
+    }
+    else
+    {
+        is_assigned = (++http_data->status_polls >= loopback_uhttp_status_polls);
+    }
+
+    if (is_assigned)
+    {
+        status_code = HTTP_STATUS_OK;
+        length = snprintf(response, sizeof(response),
+            "{\"operationId\":\"op-%s\",\"status\":\"assigned\",\"registrationState\":{\"registrationId\":\"%s\",\"assignedHub\":\"%s\",\"deviceId\":\"%s\",\"status\":\"assigned\"}}",
+            http_data->registration_id, http_data->registration_id, ASSIGNED_HUB, http_data->registration_id);
+    }
+    else
+    {
+        status_code = HTTP_STATUS_ACCEPTED;
+        length = snprintf(response, sizeof(response), "{\"operationId\":\"op-%s\",\"status\":\"assigning\"}", http_data->registration_id);
+    }
+
+    if (length < 0 || (size_t)length >= sizeof(response))
+    {
+        LogError("Failed formatting the provisioning stand-in response");
+        http_data->on_request(http_data->request_ctx, HTTP_CALLBACK_REASON_ERROR, NULL, 0, 0, NULL);
+    }
+    else if ((response_headers = HTTPHeaders_Alloc()) == NULL)
+    {
+        LogError("Failed allocating the provisioning stand-in response headers");
+        http_data->on_request(http_data->request_ctx, HTTP_CALLBACK_REASON_ERROR, NULL, 0, 0, NULL);
+    }
+    else
+    {
+        char retry_after[16];
+
+        (void)snprintf(retry_after, sizeof(retry_after), "%u", loopback_uhttp_retry_after_secs);
+        if (!is_assigned && HTTPHeaders_AddHeaderNameValuePair(response_headers, "Retry-After", retry_after) != HTTP_HEADERS_OK)
+        {
+            LogError("Failed adding the Retry-After header");
+        }
+
+        http_data->on_request(http_data->request_ctx, HTTP_CALLBACK_REASON_OK, (const unsigned char*)response, (size_t)length, status_code, response_headers);
+        HTTPHeaders_Free(response_headers);
+    }
+}
+
+HTTP_CLIENT_HANDLE uhttp_client_create(const IO_INTERFACE_DESCRIPTION* io_interface_desc, const void* xio_param, ON_HTTP_ERROR_CALLBACK on_http_error, void* callback_ctx)
+{
+    HTTP_CLIENT_HANDLE_DATA* result;
+
+    (void)io_interface_desc;
+    (void)xio_param;
+    (void)on_http_error;
+    (void)callback_ctx;
+
+    if ((result = (HTTP_CLIENT_HANDLE_DATA*)calloc(1, sizeof(HTTP_CLIENT_HANDLE_DATA))) == NULL)
+    {
+        LogError("Failed allocating the provisioning stand-in connection");
+    }
+
+    return result;
+}
+
+void uhttp_client_destroy(HTTP_CLIENT_HANDLE handle)
+{
+    free(handle);
+}
+
+HTTP_CLIENT_RESULT uhttp_client_open(HTTP_CLIENT_HANDLE handle, const char* host, int port_num, ON_HTTP_OPEN_COMPLETE_CALLBACK on_connect, void* callback_ctx)
+{
+    HTTP_CLIENT_RESULT result;
+
+    (void)host;
+    (void)port_num;
+
+    if (handle == NULL)
+    {
+        result = HTTP_CLIENT_INVALID_ARG;
+    }
+    else
+    {
+        handle->on_connect = on_connect;
+        handle->connect_ctx = callback_ctx;
+        handle->is_open_pending = true;
+        result = HTTP_CLIENT_OK;
+    }
+
+    return result;
+}
+
+void uhttp_client_close(HTTP_CLIENT_HANDLE handle, ON_HTTP_CLOSED_CALLBACK on_close_callback, void* callback_ctx)
+{
+    if (handle != NULL)
+    {
+        handle->is_open_pending = false;
+        handle->is_request_pending = false;
+    }
+
+    if (on_close_callback != NULL)
+    {
+        on_close_callback(callback_ctx);
+    }
+}
+
+HTTP_CLIENT_RESULT uhttp_client_execute_request(HTTP_CLIENT_HANDLE handle, HTTP_CLIENT_REQUEST_TYPE request_type, const char* relative_path,
+    HTTP_HEADERS_HANDLE http_header_handle, const unsigned char* content, size_t content_len, ON_HTTP_REQUEST_CALLBACK on_request_callback, void* callback_ctx)
+{
+    HTTP_CLIENT_RESULT result;
+
+    (void)http_header_handle;
+    (void)content;
+    (void)content_len;
+
+    if (handle == NULL || relative_path == NULL || on_request_callback == NULL)
+    {
+        result = HTTP_CLIENT_INVALID_ARG;
+    }
+    else if (handle->is_request_pending)
+    {
+        LogError("The provisioning stand-in answers one request at a time");
+        result = HTTP_CLIENT_INVALID_STATE;
+    }
+    else
+    {
+        copy_registration_id(handle, relative_path);
+        handle->on_request = on_request_callback;
+        handle->request_ctx = callback_ctx;
+        handle->request_type = request_type;
+        handle->is_request_pending = true;
+        result = HTTP_CLIENT_OK;
+    }
+
+    return result;
+}
+
+void uhttp_client_dowork(HTTP_CLIENT_HANDLE handle)
+{
+    if (handle != NULL)
+    {
+        if (handle->is_open_pending)
+        {
+            handle->is_open_pending = false;
+            if (handle->on_connect != NULL)
+            {
+                handle->on_connect(handle->connect_ctx, HTTP_CALLBACK_REASON_OK);
+            }
+        }
+        else if (handle->is_request_pending)
+        {
+            handle->is_request_pending = false;
+            send_reply(handle);
+        }
+    }
+}
+
+HTTP_CLIENT_RESULT uhttp_client_set_trace(HTTP_CLIENT_HANDLE handle, bool trace_on, bool trace_data)
+{
+    (void)handle;
+    (void)trace_on;
+    (void)trace_data;
+    return HTTP_CLIENT_OK;
+}
+
+HTTP_CLIENT_RESULT uhttp_client_set_X509_cert(HTTP_CLIENT_HANDLE handle, bool ecc_type, const char* certificate, const char* private_key)
+{
+    (void)handle;
+    (void)ecc_type;
+    (void)certificate;
+    (void)private_key;
+    return HTTP_CLIENT_OK;
+}
+
+HTTP_CLIENT_RESULT uhttp_client_set_trusted_cert(HTTP_CLIENT_HANDLE handle, const char* certificate)
+{
+    (void)handle;
+    (void)certificate;
+    return HTTP_CLIENT_OK;
+}
+
+const char* uhttp_client_get_trusted_cert(HTTP_CLIENT_HANDLE handle)
+{
+    (void)handle;
+    return NULL;
+}
+
+HTTP_CLIENT_RESULT uhttp_client_set_option(HTTP_CLIENT_HANDLE handle, const char* optionName, const void* value)
+{
+    (void)handle;
+    (void)optionName;
+    (void)value;
+    /* Options set on the stand-in are ignored. */
+    return HTTP_CLIENT_OK;
+}
+
+XIO_HANDLE uhttp_client_get_underlying_xio(HTTP_CLIENT_HANDLE handle)
+{
+    (void)handle;
+    return NULL;
+}
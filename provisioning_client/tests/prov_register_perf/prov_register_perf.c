@@ -0,0 +1,170 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// Registers a fleet of symmetric key devices through Prov_Device_LL_Multi against an in-process stand-in of the
+// Device Provisioning Service (see loopback_uhttp.c), so no network or service is needed and runs are reproducible.
+// The provisioning client, the HTTP transport and the SAS token signing are the real ones; only the uhttp client
+// under the transport is replaced.  Every device waits out the Retry-After of the stand-in between status polls, so
+// throughput is bounded by max_in_progress and the retry interval, the way it is against the service.
+//
+// Output is CSV on stdout:
+//     devices,max_in_progress,status_polls,elapsed_ms,registrations_per_sec,succeeded,failed,p50_ms,p90_ms,p99_ms,max_ms
+//
+// Usage: prov_register_perf [devices [max_in_progress [status_polls [retry_after_secs]]]]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "azure_c_shared_utility/platform.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_prov_client/prov_device_ll_multi_client.h"
+#include "azure_prov_client/prov_security_factory.h"
+#include "azure_prov_client/prov_transport_http_client.h"
+
+static const long DEFAULT_DEVICES = 1000;
+static const long DEFAULT_MAX_IN_PROGRESS = 100;
+static const long DEFAULT_STATUS_POLLS = 1;
+static const long DEFAULT_RETRY_AFTER_SECS = 1;
+
+static const char* GLOBAL_PROV_URI = "loopback.azure-devices-provisioning.net";
+static const char* ID_SCOPE = "0ne00000000";
+static const char* SYMMETRIC_KEY = "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA=";
+
+// Gives up on a run that stops making progress
+#define MAX_RUN_TIME_MS     (30 * 60 * 1000)
+
+extern unsigned int loopback_uhttp_status_polls;
+extern unsigned int loopback_uhttp_retry_after_secs;
+
+MU_DEFINE_ENUM_STRINGS(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_VALUE);
+
+static void on_device_registered(PROV_DEVICE_RESULT register_result, const char* iothub_uri, const char* device_id, void* user_context)
+{
+    (void)iothub_uri;
+    (void)user_context;
+    if (register_result != PROV_DEVICE_RESULT_OK)
+    {
+        (void)printf("Registration of %s failed: %s\r\n", device_id == NULL ? "device" : device_id, MU_ENUM_TO_STRING(PROV_DEVICE_RESULT, register_result));
+    }
+}
+
+static int run_benchmark(size_t devices, size_t max_in_progress)
+{
+    int result;
+    PROV_DEVICE_LL_MULTI_HANDLE multi_handle;
+    TICK_COUNTER_HANDLE tick_counter;
+
+    if ((tick_counter = tickcounter_create()) == NULL)
+    {
+        (void)printf("Unable to create the tick counter\r\n");
+        result = __LINE__;
+    }
+    else
+    {
+        if ((multi_handle = Prov_Device_LL_Multi_Create(GLOBAL_PROV_URI, ID_SCOPE, Prov_Device_HTTP_Protocol, max_in_progress)) == NULL)
+        {
+            (void)printf("Unable to create the registration driver\r\n");
+            result = __LINE__;
+        }
+        else
+        {
+            size_t i;
+            char registration_id[32];
+
+            result = 0;
+            for (i = 0; i < devices && result == 0; i++)
+            {
+                (void)sprintf(registration_id, "device%lu", (unsigned long)i);
+                if (Prov_Device_LL_Multi_Add_Registration(multi_handle, registration_id, SYMMETRIC_KEY, on_device_registered, NULL) != PROV_DEVICE_RESULT_OK)
+                {
+                    (void)printf("Unable to queue the registration of %s\r\n", registration_id);
+                    result = __LINE__;
+                }
+            }
+
+            if (result == 0)
+            {
+                PROV_DEVICE_MULTI_STATISTICS statistics;
+                tickcounter_ms_t start_ms = 0;
+                tickcounter_ms_t now_ms = 0;
+
+                (void)tickcounter_get_current_ms(tick_counter, &start_ms);
+                do
+                {
+                    Prov_Device_LL_Multi_DoWork(multi_handle);
+                    ThreadAPI_Sleep(1);
+
+                    (void)Prov_Device_LL_Multi_Get_Statistics(multi_handle, &statistics);
+                    (void)tickcounter_get_current_ms(tick_counter, &now_ms);
+                } while (statistics.registrations_succeeded + statistics.registrations_failed < devices && now_ms - start_ms < MAX_RUN_TIME_MS);
+
+                if (statistics.registrations_succeeded + statistics.registrations_failed < devices)
+                {
+                    (void)printf("Registrations did not complete\r\n");
+                    result = __LINE__;
+                }
+
+                (void)printf("devices,max_in_progress,status_polls,elapsed_ms,registrations_per_sec,succeeded,failed,p50_ms,p90_ms,p99_ms,max_ms\r\n");
+                (void)printf("%lu,%lu,%u,%lu,%.1f,%lu,%lu,%lu,%lu,%lu,%lu\r\n",
+                    (unsigned long)devices,
+                    (unsigned long)max_in_progress,
+                    loopback_uhttp_status_polls,
+                    (unsigned long)(now_ms - start_ms),
+                    statistics.registrations_per_second,
+                    (unsigned long)statistics.registrations_succeeded,
+                    (unsigned long)statistics.registrations_failed,
+                    (unsigned long)statistics.latency_p50_ms,
+                    (unsigned long)statistics.latency_p90_ms,
+                    (unsigned long)statistics.latency_p99_ms,
+                    (unsigned long)statistics.latency_max_ms);
+            }
+
+            Prov_Device_LL_Multi_Destroy(multi_handle);
+        }
+        tickcounter_destroy(tick_counter);
+    }
+
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    int result;
+    long devices = (argc > 1) ? atol(argv[1]) : DEFAULT_DEVICES;
+    long max_in_progress = (argc > 2) ? atol(argv[2]) : DEFAULT_MAX_IN_PROGRESS;
+    long status_polls = (argc > 3) ? atol(argv[3]) : DEFAULT_STATUS_POLLS;
+    long retry_after_secs = (argc > 4) ? atol(argv[4]) : DEFAULT_RETRY_AFTER_SECS;
+
+    if (devices <= 0 || max_in_progress <= 0 || status_polls < 0 || retry_after_secs <= 0)
+    {
+        (void)printf("usage: prov_register_perf [devices [max_in_progress [status_polls [retry_after_secs]]]]\r\n");
+        result = EXIT_FAILURE;
+    }
+    else if (platform_init() != 0)
+    {
+        (void)printf("platform_init failed\r\n");
+        result = EXIT_FAILURE;
+    }
+    else
+    {
+        loopback_uhttp_status_polls = (unsigned int)status_polls;
+        loopback_uhttp_retry_after_secs = (unsigned int)retry_after_secs;
+
+        if (prov_dev_security_init(SECURE_DEVICE_TYPE_SYMMETRIC_KEY) != 0)
+        {
+            (void)printf("Unable to initialize the symmetric key security module\r\n");
+            result = EXIT_FAILURE;
+        }
+        else
+        {
+            result = (run_benchmark((size_t)devices, (size_t)max_in_progress) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+            prov_dev_security_deinit();
+        }
+
+        platform_deinit();
+    }
+
+    return result;
+}
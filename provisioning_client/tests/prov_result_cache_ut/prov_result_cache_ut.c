@@ -0,0 +1,621 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#else
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#endif
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#include "testrunnerswitcher.h"
+#include "umock_c/umock_c.h"
+#include "umock_c/umocktypes_charptr.h"
+#include "umock_c/umocktypes_bool.h"
+#include "umock_c/umocktypes_stdint.h"
+#include "umock_c/umock_c_negative_tests.h"
+#include "azure_macro_utils/macro_utils.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/sha.h"
+#include "parson.h"
+
+MOCKABLE_FUNCTION(, int, SHA256Reset, SHA256Context*, ctx);
+MOCKABLE_FUNCTION(, int, SHA256Input, SHA256Context*, ctx, const uint8_t*, bytes, unsigned int, bytecount);
+MOCKABLE_FUNCTION(, int, SHA256Result, SHA256Context*, ctx, uint8_t*, Message_Digest);
+
+MOCKABLE_FUNCTION(, JSON_Value*, json_parse_file, const char*, filename);
+MOCKABLE_FUNCTION(, char*, json_serialize_to_string, const JSON_Value*, value);
+MOCKABLE_FUNCTION(, void, json_free_serialized_string, char*, string);
+MOCKABLE_FUNCTION(, JSON_Value*, json_value_init_object);
+MOCKABLE_FUNCTION(, JSON_Object*, json_value_get_object, const JSON_Value*, value);
+MOCKABLE_FUNCTION(, double, json_object_get_number, const JSON_Object*, object, const char*, name);
+MOCKABLE_FUNCTION(, const char*, json_object_get_string, const JSON_Object*, object, const char*, name);
+MOCKABLE_FUNCTION(, JSON_Status, json_object_set_number, JSON_Object*, object, const char*, name, double, number);
+MOCKABLE_FUNCTION(, JSON_Status, json_object_set_string, JSON_Object*, object, const char*, name, const char*, string);
+MOCKABLE_FUNCTION(, void, json_value_free, JSON_Value*, value);
+#undef ENABLE_MOCKS
+
+#include "azure_prov_client/internal/prov_result_cache.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+#define TEST_JSON_OBJECT_VALUE      (JSON_Object*)0x11111113
+
+static const char* TEST_CACHE_PATH = "prov_result_cache_ut.json";
+static const char* TEST_CACHE_TEMP_PATH = "prov_result_cache_ut.json.tmp";
+static const char* TEST_SCOPE_ID = "scope_id";
+static const char* TEST_REGISTRATION_ID = "registration_id";
+static const char* TEST_IOTHUB = "iothub.value.test";
+static const char* TEST_DEVICE_ID = "device_id";
+// The SHA256Result hook returns an all zero digest
+static const char* TEST_DIGEST = "0000000000000000000000000000000000000000000000000000000000000000";
+static const char* TEST_BAD_DIGEST = "1111111111111111111111111111111111111111111111111111111111111111";
+
+static const char* g_cached_scope_id;
+static const char* g_cached_digest;
+
+MU_DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", MU_ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+static int my_mallocAndStrcpy_s(char** destination, const char* source)
+{
+    size_t src_len = strlen(source);
+    *destination = (char*)my_gballoc_malloc(src_len + 1);
+    strcpy(*destination, source);
+    return 0;
+}
+
+static int my_SHA256Result(SHA256Context* ctx, uint8_t* Message_Digest)
+{
+    (void)ctx;
+    memset(Message_Digest, 0, SHA256HashSize);
+    return 0;
+}
+
+static JSON_Value* my_json_parse_file(const char* filename)
+{
+    (void)filename;
+    return (JSON_Value*)my_gballoc_malloc(1);
+}
+
+static JSON_Value* my_json_value_init_object(void)
+{
+    return (JSON_Value*)my_gballoc_malloc(1);
+}
+
+static void my_json_value_free(JSON_Value* value)
+{
+    my_gballoc_free(value);
+}
+
+static const char* my_json_object_get_string(const JSON_Object* object, const char* name)
+{
+    const char* result;
+    (void)object;
+    if (strcmp(name, "scopeId") == 0)
+    {
+        result = g_cached_scope_id;
+    }
+    else if (strcmp(name, "registrationId") == 0)
+    {
+        result = TEST_REGISTRATION_ID;
+    }
+    else if (strcmp(name, "assignedHub") == 0)
+    {
+        result = TEST_IOTHUB;
+    }
+    else if (strcmp(name, "deviceId") == 0)
+    {
+        result = TEST_DEVICE_ID;
+    }
+    else if (strcmp(name, "digest") == 0)
+    {
+        result = g_cached_digest;
+    }
+    else
+    {
+        result = NULL;
+    }
+    return result;
+}
+
+static char* my_json_serialize_to_string(const JSON_Value* value)
+{
+    char* result;
+    (void)value;
+    (void)my_mallocAndStrcpy_s(&result, "{}");
+    return result;
+}
+
+static void my_json_free_serialized_string(char* string)
+{
+    my_gballoc_free(string);
+}
+
+static char* read_file(const char* path)
+{
+    char* result = NULL;
+    FILE* file = fopen(path, "r");
+    if (file != NULL)
+    {
+        char buffer[64];
+        size_t length = fread(buffer, 1, sizeof(buffer) - 1, file);
+        buffer[length] = '\0';
+        (void)my_mallocAndStrcpy_s(&result, buffer);
+        (void)fclose(file);
+    }
+    return result;
+}
+
+static bool file_exists(const char* path)
+{
+    bool result;
+    FILE* file;
+    if ((file = fopen(path, "r")) == NULL)
+    {
+        result = false;
+    }
+    else
+    {
+        (void)fclose(file);
+        result = true;
+    }
+    return result;
+}
+
+static void create_file(const char* path)
+{
+    FILE* file = fopen(path, "w");
+    ASSERT_IS_NOT_NULL(file);
+    (void)fputs("{}", file);
+    (void)fclose(file);
+}
+
+BEGIN_TEST_SUITE(prov_result_cache_ut)
+
+    TEST_SUITE_INITIALIZE(suite_init)
+    {
+        int result;
+
+        g_testByTest = TEST_MUTEX_CREATE();
+        ASSERT_IS_NOT_NULL(g_testByTest);
+
+        (void)umock_c_init(on_umock_c_error);
+        (void)umocktypes_bool_register_types();
+
+        result = umocktypes_charptr_register_types();
+        ASSERT_ARE_EQUAL(int, 0, result);
+        result = umocktypes_stdint_register_types();
+        ASSERT_ARE_EQUAL(int, 0, result);
+
+        REGISTER_UMOCK_ALIAS_TYPE(JSON_Status, int);
+
+        REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+        REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+        REGISTER_GLOBAL_MOCK_HOOK(mallocAndStrcpy_s, my_mallocAndStrcpy_s);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(mallocAndStrcpy_s, __LINE__);
+
+        REGISTER_GLOBAL_MOCK_RETURN(SHA256Reset, 0);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(SHA256Reset, __LINE__);
+        REGISTER_GLOBAL_MOCK_RETURN(SHA256Input, 0);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(SHA256Input, __LINE__);
+        REGISTER_GLOBAL_MOCK_HOOK(SHA256Result, my_SHA256Result);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(SHA256Result, __LINE__);
+
+        REGISTER_GLOBAL_MOCK_HOOK(json_parse_file, my_json_parse_file);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(json_parse_file, NULL);
+        REGISTER_GLOBAL_MOCK_HOOK(json_serialize_to_string, my_json_serialize_to_string);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(json_serialize_to_string, NULL);
+        REGISTER_GLOBAL_MOCK_HOOK(json_free_serialized_string, my_json_free_serialized_string);
+        REGISTER_GLOBAL_MOCK_HOOK(json_value_init_object, my_json_value_init_object);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(json_value_init_object, NULL);
+        REGISTER_GLOBAL_MOCK_HOOK(json_value_free, my_json_value_free);
+        REGISTER_GLOBAL_MOCK_RETURN(json_value_get_object, TEST_JSON_OBJECT_VALUE);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(json_value_get_object, NULL);
+        REGISTER_GLOBAL_MOCK_RETURN(json_object_get_number, 1);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(json_object_get_number, 0);
+        REGISTER_GLOBAL_MOCK_HOOK(json_object_get_string, my_json_object_get_string);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(json_object_get_string, NULL);
+        REGISTER_GLOBAL_MOCK_RETURN(json_object_set_number, JSONSuccess);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(json_object_set_number, JSONFailure);
+        REGISTER_GLOBAL_MOCK_RETURN(json_object_set_string, JSONSuccess);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(json_object_set_string, JSONFailure);
+    }
+
+    TEST_SUITE_CLEANUP(suite_cleanup)
+    {
+        umock_c_deinit();
+
+        TEST_MUTEX_DESTROY(g_testByTest);
+    }
+
+    TEST_FUNCTION_INITIALIZE(method_init)
+    {
+        if (TEST_MUTEX_ACQUIRE(g_testByTest))
+        {
+            ASSERT_FAIL("Could not acquire test serialization mutex.");
+        }
+        umock_c_reset_all_calls();
+        g_cached_scope_id = TEST_SCOPE_ID;
+        g_cached_digest = TEST_DIGEST;
+    }
+
+    TEST_FUNCTION_CLEANUP(method_cleanup)
+    {
+        (void)remove(TEST_CACHE_PATH);
+        (void)remove(TEST_CACHE_TEMP_PATH);
+        TEST_MUTEX_RELEASE(g_testByTest);
+    }
+
+    static void setup_compute_digest_mocks(void)
+    {
+        STRICT_EXPECTED_CALL(SHA256Reset(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(SHA256Input(IGNORED_PTR_ARG, IGNORED_PTR_ARG, (unsigned int)strlen(TEST_SCOPE_ID) + 1));
+        STRICT_EXPECTED_CALL(SHA256Input(IGNORED_PTR_ARG, IGNORED_PTR_ARG, (unsigned int)strlen(TEST_REGISTRATION_ID) + 1));
+        STRICT_EXPECTED_CALL(SHA256Input(IGNORED_PTR_ARG, IGNORED_PTR_ARG, (unsigned int)strlen(TEST_IOTHUB) + 1));
+        STRICT_EXPECTED_CALL(SHA256Input(IGNORED_PTR_ARG, IGNORED_PTR_ARG, (unsigned int)strlen(TEST_DEVICE_ID) + 1));
+        STRICT_EXPECTED_CALL(SHA256Result(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    }
+
+    static void setup_read_fields_mocks(void)
+    {
+        STRICT_EXPECTED_CALL(json_parse_file(TEST_CACHE_PATH));
+        STRICT_EXPECTED_CALL(json_value_get_object(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(json_object_get_number(IGNORED_PTR_ARG, "version"));
+        STRICT_EXPECTED_CALL(json_object_get_string(IGNORED_PTR_ARG, "scopeId"));
+        STRICT_EXPECTED_CALL(json_object_get_string(IGNORED_PTR_ARG, "registrationId"));
+        STRICT_EXPECTED_CALL(json_object_get_string(IGNORED_PTR_ARG, "assignedHub"));
+        STRICT_EXPECTED_CALL(json_object_get_string(IGNORED_PTR_ARG, "deviceId"));
+        STRICT_EXPECTED_CALL(json_object_get_string(IGNORED_PTR_ARG, "digest"));
+    }
+
+    static void setup_prov_result_cache_load_mocks(void)
+    {
+        setup_read_fields_mocks();
+        setup_compute_digest_mocks();
+        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, TEST_IOTHUB));
+        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, TEST_DEVICE_ID));
+        STRICT_EXPECTED_CALL(json_value_free(IGNORED_PTR_ARG));
+    }
+
+    static void setup_prov_result_cache_save_mocks(void)
+    {
+        setup_compute_digest_mocks();
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+        STRICT_EXPECTED_CALL(json_value_init_object());
+        STRICT_EXPECTED_CALL(json_value_get_object(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(json_object_set_number(IGNORED_PTR_ARG, "version", 1));
+        STRICT_EXPECTED_CALL(json_object_set_string(IGNORED_PTR_ARG, "scopeId", TEST_SCOPE_ID));
+        STRICT_EXPECTED_CALL(json_object_set_string(IGNORED_PTR_ARG, "registrationId", TEST_REGISTRATION_ID));
+        STRICT_EXPECTED_CALL(json_object_set_string(IGNORED_PTR_ARG, "assignedHub", TEST_IOTHUB));
+        STRICT_EXPECTED_CALL(json_object_set_string(IGNORED_PTR_ARG, "deviceId", TEST_DEVICE_ID));
+        STRICT_EXPECTED_CALL(json_object_set_string(IGNORED_PTR_ARG, "digest", TEST_DIGEST));
+        STRICT_EXPECTED_CALL(json_serialize_to_string(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(json_free_serialized_string(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(json_value_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    }
+
+    TEST_FUNCTION(prov_result_cache_load_cache_path_NULL_fail)
+    {
+        //arrange
+        char* iothub_uri = NULL;
+        char* device_id = NULL;
+
+        //act
+        int result = prov_result_cache_load(NULL, TEST_SCOPE_ID, TEST_REGISTRATION_ID, &iothub_uri, &device_id);
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(prov_result_cache_load_iothub_uri_NULL_fail)
+    {
+        //arrange
+        char* device_id = NULL;
+
+        //act
+        int result = prov_result_cache_load(TEST_CACHE_PATH, TEST_SCOPE_ID, TEST_REGISTRATION_ID, NULL, &device_id);
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(prov_result_cache_load_succeed)
+    {
+        //arrange
+        char* iothub_uri = NULL;
+        char* device_id = NULL;
+
+        setup_prov_result_cache_load_mocks();
+
+        //act
+        int result = prov_result_cache_load(TEST_CACHE_PATH, TEST_SCOPE_ID, TEST_REGISTRATION_ID, &iothub_uri, &device_id);
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, TEST_IOTHUB, iothub_uri);
+        ASSERT_ARE_EQUAL(char_ptr, TEST_DEVICE_ID, device_id);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        my_gballoc_free(iothub_uri);
+        my_gballoc_free(device_id);
+    }
+
+    TEST_FUNCTION(prov_result_cache_load_no_file_fail)
+    {
+        //arrange
+        char* iothub_uri = NULL;
+        char* device_id = NULL;
+
+        STRICT_EXPECTED_CALL(json_parse_file(TEST_CACHE_PATH)).SetReturn(NULL);
+
+        //act
+        int result = prov_result_cache_load(TEST_CACHE_PATH, TEST_SCOPE_ID, TEST_REGISTRATION_ID, &iothub_uri, &device_id);
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_IS_NULL(iothub_uri);
+        ASSERT_IS_NULL(device_id);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(prov_result_cache_load_other_scope_fail)
+    {
+        //arrange
+        char* iothub_uri = NULL;
+        char* device_id = NULL;
+        g_cached_scope_id = "other_scope_id";
+
+        setup_read_fields_mocks();
+        STRICT_EXPECTED_CALL(json_value_free(IGNORED_PTR_ARG));
+
+        //act
+        int result = prov_result_cache_load(TEST_CACHE_PATH, TEST_SCOPE_ID, TEST_REGISTRATION_ID, &iothub_uri, &device_id);
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_IS_NULL(iothub_uri);
+        ASSERT_IS_NULL(device_id);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(prov_result_cache_load_digest_mismatch_fail)
+    {
+        //arrange
+        char* iothub_uri = NULL;
+        char* device_id = NULL;
+        g_cached_digest = TEST_BAD_DIGEST;
+
+        setup_read_fields_mocks();
+        setup_compute_digest_mocks();
+        STRICT_EXPECTED_CALL(json_value_free(IGNORED_PTR_ARG));
+
+        //act
+        int result = prov_result_cache_load(TEST_CACHE_PATH, TEST_SCOPE_ID, TEST_REGISTRATION_ID, &iothub_uri, &device_id);
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_IS_NULL(iothub_uri);
+        ASSERT_IS_NULL(device_id);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(prov_result_cache_load_fail)
+    {
+        //arrange
+        char* iothub_uri = NULL;
+        char* device_id = NULL;
+
+        int negativeTestsInitResult = umock_c_negative_tests_init();
+        ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+
+        setup_prov_result_cache_load_mocks();
+
+        umock_c_negative_tests_snapshot();
+
+        size_t count = umock_c_negative_tests_call_count();
+        for (size_t index = 0; index < count; index++)
+        {
+            if (umock_c_negative_tests_can_call_fail(index))
+            {
+                umock_c_negative_tests_reset();
+                umock_c_negative_tests_fail_call(index);
+
+                char tmp_msg[64];
+                sprintf(tmp_msg, "prov_result_cache_load failure in test %lu/%lu", (unsigned long)index, (unsigned long)count);
+
+                //act
+                int result = prov_result_cache_load(TEST_CACHE_PATH, TEST_SCOPE_ID, TEST_REGISTRATION_ID, &iothub_uri, &device_id);
+
+                //assert
+                ASSERT_ARE_NOT_EQUAL(int, 0, result, tmp_msg);
+                ASSERT_IS_NULL(iothub_uri, tmp_msg);
+            }
+        }
+
+        //cleanup
+        umock_c_negative_tests_deinit();
+    }
+
+    TEST_FUNCTION(prov_result_cache_save_cache_path_NULL_fail)
+    {
+        //arrange
+
+        //act
+        int result = prov_result_cache_save(NULL, TEST_SCOPE_ID, TEST_REGISTRATION_ID, TEST_IOTHUB, TEST_DEVICE_ID);
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(prov_result_cache_save_device_id_NULL_fail)
+    {
+        //arrange
+
+        //act
+        int result = prov_result_cache_save(TEST_CACHE_PATH, TEST_SCOPE_ID, TEST_REGISTRATION_ID, TEST_IOTHUB, NULL);
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(prov_result_cache_save_succeed)
+    {
+        //arrange
+        setup_prov_result_cache_save_mocks();
+
+        //act
+        int result = prov_result_cache_save(TEST_CACHE_PATH, TEST_SCOPE_ID, TEST_REGISTRATION_ID, TEST_IOTHUB, TEST_DEVICE_ID);
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_IS_TRUE(file_exists(TEST_CACHE_PATH));
+        ASSERT_IS_FALSE(file_exists(TEST_CACHE_TEMP_PATH));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(prov_result_cache_save_replaces_existing_succeed)
+    {
+        //arrange
+        FILE* old_file = fopen(TEST_CACHE_PATH, "w");
+        ASSERT_IS_NOT_NULL(old_file);
+        (void)fputs("old", old_file);
+        (void)fclose(old_file);
+        setup_prov_result_cache_save_mocks();
+
+        //act
+        int result = prov_result_cache_save(TEST_CACHE_PATH, TEST_SCOPE_ID, TEST_REGISTRATION_ID, TEST_IOTHUB, TEST_DEVICE_ID);
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        char* content = read_file(TEST_CACHE_PATH);
+        ASSERT_ARE_EQUAL(char_ptr, "{}", content);
+        ASSERT_IS_FALSE(file_exists(TEST_CACHE_TEMP_PATH));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        my_gballoc_free(content);
+    }
+
+    TEST_FUNCTION(prov_result_cache_save_fail)
+    {
+        //arrange
+        int negativeTestsInitResult = umock_c_negative_tests_init();
+        ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+
+        setup_prov_result_cache_save_mocks();
+
+        umock_c_negative_tests_snapshot();
+
+        size_t count = umock_c_negative_tests_call_count();
+        for (size_t index = 0; index < count; index++)
+        {
+            if (umock_c_negative_tests_can_call_fail(index))
+            {
+                umock_c_negative_tests_reset();
+                umock_c_negative_tests_fail_call(index);
+
+                char tmp_msg[64];
+                sprintf(tmp_msg, "prov_result_cache_save failure in test %lu/%lu", (unsigned long)index, (unsigned long)count);
+
+                //act
+                int result = prov_result_cache_save(TEST_CACHE_PATH, TEST_SCOPE_ID, TEST_REGISTRATION_ID, TEST_IOTHUB, TEST_DEVICE_ID);
+
+                //assert
+                ASSERT_ARE_NOT_EQUAL(int, 0, result, tmp_msg);
+                ASSERT_IS_FALSE(file_exists(TEST_CACHE_PATH), tmp_msg);
+            }
+        }
+
+        //cleanup
+        umock_c_negative_tests_deinit();
+    }
+
+    TEST_FUNCTION(prov_result_cache_clear_cache_path_NULL_fail)
+    {
+        //arrange
+
+        //act
+        int result = prov_result_cache_clear(NULL);
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(prov_result_cache_clear_no_file_succeed)
+    {
+        //arrange
+
+        //act
+        int result = prov_result_cache_clear(TEST_CACHE_PATH);
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+
+        //cleanup
+    }
+
+    TEST_FUNCTION(prov_result_cache_clear_succeed)
+    {
+        //arrange
+        create_file(TEST_CACHE_PATH);
+
+        //act
+        int result = prov_result_cache_clear(TEST_CACHE_PATH);
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_IS_FALSE(file_exists(TEST_CACHE_PATH));
+
+        //cleanup
+    }
+
+END_TEST_SUITE(prov_result_cache_ut)
@@ -0,0 +1,229 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// Times how long a symmetric key device takes from Prov_Device_LL_Create to its registration callback, on a cold
+// start that registers with the Device Provisioning Service and on a warm start that finds its assignment in the
+// result cache (PROV_OPTION_RESULT_CACHE).  The service is the in-process stand-in of prov_register_perf (see
+// loopback_uhttp.c), which makes the device wait out its Retry-After between status polls the way the service does.
+// Cold starts invalidate the cache first; the last cold start leaves the cache filled for the warm starts.
+//
+// Output is CSV on stdout:
+//     start,starts,status_polls,retry_after_secs,mean_ms,min_ms,max_ms,failed
+//
+// Usage: prov_warm_start_perf [starts [status_polls [retry_after_secs [cache_path]]]]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "azure_c_shared_utility/platform.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_prov_client/prov_device_ll_client.h"
+#include "azure_prov_client/prov_security_factory.h"
+#include "azure_prov_client/prov_transport_http_client.h"
+
+static const long DEFAULT_STARTS = 5;
+static const long DEFAULT_STATUS_POLLS = 1;
+static const long DEFAULT_RETRY_AFTER_SECS = 1;
+static const char* DEFAULT_CACHE_PATH = "prov_warm_start_perf.json";
+
+static const char* GLOBAL_PROV_URI = "loopback.azure-devices-provisioning.net";
+static const char* ID_SCOPE = "0ne00000000";
+static const char* REGISTRATION_ID = "warm-start-device";
+static const char* SYMMETRIC_KEY = "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA=";
+
+// Gives up on a start that stops making progress
+#define MAX_START_TIME_MS   (5 * 60 * 1000)
+
+extern unsigned int loopback_uhttp_status_polls;
+extern unsigned int loopback_uhttp_retry_after_secs;
+
+MU_DEFINE_ENUM_STRINGS(PROV_DEVICE_RESULT, PROV_DEVICE_RESULT_VALUE);
+
+typedef struct START_RESULT_TAG
+{
+    bool is_complete;
+    PROV_DEVICE_RESULT register_result;
+} START_RESULT;
+
+typedef struct START_STATISTICS_TAG
+{
+    size_t starts;
+    size_t failed;
+    tickcounter_ms_t total_ms;
+    tickcounter_ms_t min_ms;
+    tickcounter_ms_t max_ms;
+} START_STATISTICS;
+
+static void on_device_registered(PROV_DEVICE_RESULT register_result, const char* iothub_uri, const char* device_id, void* user_context)
+{
+    START_RESULT* start_result = (START_RESULT*)user_context;
+    (void)iothub_uri;
+    (void)device_id;
+    start_result->register_result = register_result;
+    start_result->is_complete = true;
+}
+
+// Times one start, from create to the registration callback
+static void run_start(TICK_COUNTER_HANDLE tick_counter, const char* cache_path, bool is_cold, START_STATISTICS* statistics)
+{
+    PROV_DEVICE_LL_HANDLE handle;
+    START_RESULT start_result = { false, PROV_DEVICE_RESULT_ERROR };
+    tickcounter_ms_t start_ms = 0;
+    tickcounter_ms_t now_ms = 0;
+
+    (void)tickcounter_get_current_ms(tick_counter, &start_ms);
+    if ((handle = Prov_Device_LL_Create(GLOBAL_PROV_URI, ID_SCOPE, Prov_Device_HTTP_Protocol)) == NULL)
+    {
+        (void)printf("Unable to create the provisioning client\r\n");
+    }
+    else
+    {
+        if (Prov_Device_LL_SetOption(handle, PROV_REGISTRATION_ID, REGISTRATION_ID) != PROV_DEVICE_RESULT_OK ||
+            Prov_Device_LL_SetOption(handle, PROV_OPTION_RESULT_CACHE, cache_path) != PROV_DEVICE_RESULT_OK)
+        {
+            (void)printf("Unable to set the provisioning client options\r\n");
+        }
+        else if (is_cold && Prov_Device_LL_Invalidate_Cached_Result(handle) != PROV_DEVICE_RESULT_OK)
+        {
+            (void)printf("Unable to invalidate the cached result\r\n");
+        }
+        else if (Prov_Device_LL_Register_Device(handle, on_device_registered, &start_result, NULL, NULL) != PROV_DEVICE_RESULT_OK)
+        {
+            (void)printf("Unable to start the registration\r\n");
+        }
+        else
+        {
+            do
+            {
+                Prov_Device_LL_DoWork(handle);
+                if (!start_result.is_complete)
+                {
+                    ThreadAPI_Sleep(1);
+                }
+                (void)tickcounter_get_current_ms(tick_counter, &now_ms);
+            } while (!start_result.is_complete && now_ms - start_ms < MAX_START_TIME_MS);
+        }
+        Prov_Device_LL_Destroy(handle);
+    }
+
+    statistics->starts++;
+    if (!start_result.is_complete || start_result.register_result != PROV_DEVICE_RESULT_OK)
+    {
+        (void)printf("%s start failed: %s\r\n", is_cold ? "Cold" : "Warm", MU_ENUM_TO_STRING(PROV_DEVICE_RESULT, start_result.register_result));
+        statistics->failed++;
+    }
+    else
+    {
+        tickcounter_ms_t elapsed_ms = now_ms - start_ms;
+        statistics->total_ms += elapsed_ms;
+        if (statistics->starts - statistics->failed == 1 || elapsed_ms < statistics->min_ms)
+        {
+            statistics->min_ms = elapsed_ms;
+        }
+        if (elapsed_ms > statistics->max_ms)
+        {
+            statistics->max_ms = elapsed_ms;
+        }
+    }
+}
+
+static void print_statistics(const char* start_name, const START_STATISTICS* statistics)
+{
+    size_t succeeded = statistics->starts - statistics->failed;
+    (void)printf("%s,%lu,%u,%u,%.1f,%lu,%lu,%lu\r\n",
+        start_name,
+        (unsigned long)statistics->starts,
+        loopback_uhttp_status_polls,
+        loopback_uhttp_retry_after_secs,
+        succeeded == 0 ? 0.0 : (double)statistics->total_ms / succeeded,
+        (unsigned long)statistics->min_ms,
+        (unsigned long)statistics->max_ms,
+        (unsigned long)statistics->failed);
+}
+
+static int run_benchmark(size_t starts, const char* cache_path)
+{
+    int result;
+    TICK_COUNTER_HANDLE tick_counter;
+
+    if ((tick_counter = tickcounter_create()) == NULL)
+    {
+        (void)printf("Unable to create the tick counter\r\n");
+        result = __LINE__;
+    }
+    else
+    {
+        START_STATISTICS cold_statistics = { 0, 0, 0, 0, 0 };
+        START_STATISTICS warm_statistics = { 0, 0, 0, 0, 0 };
+        size_t i;
+
+        for (i = 0; i < starts; i++)
+        {
+            run_start(tick_counter, cache_path, true, &cold_statistics);
+        }
+        for (i = 0; i < starts; i++)
+        {
+            run_start(tick_counter, cache_path, false, &warm_statistics);
+        }
+
+        (void)printf("start,starts,status_polls,retry_after_secs,mean_ms,min_ms,max_ms,failed\r\n");
+        print_statistics("cold", &cold_statistics);
+        print_statistics("warm", &warm_statistics);
+
+        result = (cold_statistics.failed == 0 && warm_statistics.failed == 0) ? 0 : __LINE__;
+        (void)remove(cache_path);
+        tickcounter_destroy(tick_counter);
+    }
+
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    int result;
+    long starts = (argc > 1) ? atol(argv[1]) : DEFAULT_STARTS;
+    long status_polls = (argc > 2) ? atol(argv[2]) : DEFAULT_STATUS_POLLS;
+    long retry_after_secs = (argc > 3) ? atol(argv[3]) : DEFAULT_RETRY_AFTER_SECS;
+    const char* cache_path = (argc > 4) ? argv[4] : DEFAULT_CACHE_PATH;
+
+    if (starts <= 0 || status_polls < 0 || retry_after_secs <= 0)
+    {
+        (void)printf("usage: prov_warm_start_perf [starts [status_polls [retry_after_secs [cache_path]]]]\r\n");
+        result = EXIT_FAILURE;
+    }
+    else if (platform_init() != 0)
+    {
+        (void)printf("platform_init failed\r\n");
+        result = EXIT_FAILURE;
+    }
+    else
+    {
+        loopback_uhttp_status_polls = (unsigned int)status_polls;
+        loopback_uhttp_retry_after_secs = (unsigned int)retry_after_secs;
+
+        if (prov_dev_security_init(SECURE_DEVICE_TYPE_SYMMETRIC_KEY) != 0)
+        {
+            (void)printf("Unable to initialize the symmetric key security module\r\n");
+            result = EXIT_FAILURE;
+        }
+        // The security module reads the key when the device client is created
+        else if (prov_dev_set_symmetric_key_info(REGISTRATION_ID, SYMMETRIC_KEY) != 0)
+        {
+            (void)printf("Unable to set the symmetric key\r\n");
+            prov_dev_security_deinit();
+            result = EXIT_FAILURE;
+        }
+        else
+        {
+            result = (run_benchmark((size_t)starts, cache_path) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+            prov_dev_security_deinit();
+        }
+
+        platform_deinit();
+    }
+
+    return result;
+}
@@ -22,6 +22,9 @@ extern "C" {
 
 #define PROVISIONING_BULK_OPERATION_VERSION_1 1
 
+/* Most enrollments the Provisioning Service accepts in one bulk request; larger operations are sent in chunks of this size */
+#define PROVISIONING_BULK_OPERATION_MAX_ENROLLMENTS 10
+
 #define PROVISIONING_BULK_OPERATION_MODE_VALUES \
 BULK_OP_CREATE, \
 BULK_OP_UPDATE, \
@@ -21,10 +21,18 @@ extern "C" {
         TRACING_STATUS_OFF
 MU_DEFINE_ENUM_WITHOUT_INVALID(TRACING_STATUS, TRACING_STATUS_VALUES);
 
+/** @brief  Upper limit of prov_sc_set_max_concurrent_requests
+*/
+#define PROVISIONING_SC_MAX_CONCURRENT_REQUESTS 8
+
 /** @brief  Handle to hide struct and use it in consequent APIs
 */
 typedef struct PROVISIONING_SERVICE_CLIENT_TAG* PROVISIONING_SERVICE_CLIENT_HANDLE;
 
+/** @brief  Handle to a query iterator, which fetches the pages of a query one after the other.
+*/
+typedef struct PROVISIONING_QUERY_ITERATOR_TAG* PROVISIONING_QUERY_ITERATOR_HANDLE;
+
 /** @brief  Creates a Provisioning Service Client handle for use in consequent APIs.
 *
 * @param    conn_string     A connection string used to establish connection with the Provisioning Service.
@@ -65,6 +73,24 @@ MOCKABLE_FUNCTION(, int, prov_sc_set_certificate, PROVISIONING_SERVICE_CLIENT_HA
 */
 MOCKABLE_FUNCTION(, int, prov_sc_set_proxy, PROVISIONING_SERVICE_CLIENT_HANDLE, prov_client, HTTP_PROXY_OPTIONS*, proxy_options);
 
+/** @brief  Sets whether connections to the Provisioning Service are kept open between requests, so the TLS handshake is only paid
+*           for by the first request on each connection. Off by default, in which case every request opens its own connection.
+*
+* @param    prov_client     The handle used for connecting to the Provisioning Service.
+* @param    keep_alive      true to keep connections open; false closes the open connections.
+*/
+MOCKABLE_FUNCTION(, void, prov_sc_set_keep_alive, PROVISIONING_SERVICE_CLIENT_HANDLE, prov_client, bool, keep_alive);
+
+/** @brief  Sets how many requests a bulk operation may have in flight at once, each on its own connection to the Provisioning Service.
+*           The default is 1.
+*
+* @param    prov_client                 The handle used for connecting to the Provisioning Service.
+* @param    max_concurrent_requests     Number of concurrent requests, from 1 to PROVISIONING_SC_MAX_CONCURRENT_REQUESTS.
+*
+* @return   0 upon success, a non-zero number upon failure.
+*/
+MOCKABLE_FUNCTION(, int, prov_sc_set_max_concurrent_requests, PROVISIONING_SERVICE_CLIENT_HANDLE, prov_client, size_t, max_concurrent_requests);
+
 /** @brief Creates or updates an individual device enrollment record on the Provisioning Service, reflecting the changes in the given struct.
 *
 * @param    prov_client         The handle used for connecting to the Provisioning Service.
@@ -116,12 +142,14 @@ MOCKABLE_FUNCTION(, int, prov_sc_get_individual_enrollment, PROVISIONING_SERVICE
 MOCKABLE_FUNCTION(, int, prov_sc_query_individual_enrollment, PROVISIONING_SERVICE_CLIENT_HANDLE, prov_client, PROVISIONING_QUERY_SPECIFICATION*, query_spec, char**, cont_token_ptr, PROVISIONING_QUERY_RESPONSE**, query_resp_ptr);
 
 /** @brief  Performs a bulk operation on individual device enrollment records from the provisioning service.
+*           Operations larger than PROVISIONING_BULK_OPERATION_MAX_ENROLLMENTS are split into several requests, sent with the
+*           concurrency set by prov_sc_set_max_concurrent_requests, and their results are merged.
 *
 * @param    prov_client     The handle used for connecting to the Provisioning Service.
 * @param    bulk_op         A pointer to a bulk operation structure with details about the bulk operation.
 * @param    bulk_res_ptr    A pointer to a bulk operation result pointer that will be filled with the results upon completion
 *
-* @return   0 upon success, a non-zero number upon failure.
+* @return   0 upon success, a non-zero number upon failure. On failure, requests completed before the failure may have been applied.
 */
 MOCKABLE_FUNCTION(, int, prov_sc_run_individual_enrollment_bulk_operation, PROVISIONING_SERVICE_CLIENT_HANDLE, prov_client, PROVISIONING_BULK_OPERATION*, bulk_op, PROVISIONING_BULK_OPERATION_RESULT**, bulk_res_ptr);
 
@@ -212,6 +240,41 @@ MOCKABLE_FUNCTION(, int, prov_sc_get_device_registration_state, PROVISIONING_SER
 */
 MOCKABLE_FUNCTION(, int, prov_sc_query_device_registration_state, PROVISIONING_SERVICE_CLIENT_HANDLE, prov_client, PROVISIONING_QUERY_SPECIFICATION*, query_spec, char**, cont_token_ptr, PROVISIONING_QUERY_RESPONSE**, query_resp_ptr);
 
+/** @brief  Creates an iterator over the individual enrollment records matching a query. The first page is requested right away,
+*           and each following page as soon as the one before it is returned, so it is fetched while the caller handles the last.
+*           The iterator keeps its own connection open until it is destroyed.
+*
+* @param    prov_client     The handle used for connecting to the Provisioning Service. Must outlive the iterator.
+* @param    query_spec      The query specification with query details and settings. Only used during the call.
+*
+* @return   A handle to the iterator, or NULL on failure.
+*/
+MOCKABLE_FUNCTION(, PROVISIONING_QUERY_ITERATOR_HANDLE, prov_sc_create_individual_enrollment_query_iterator, PROVISIONING_SERVICE_CLIENT_HANDLE, prov_client, PROVISIONING_QUERY_SPECIFICATION*, query_spec);
+
+/** @brief  Creates an iterator over the enrollment group records matching a query. See prov_sc_create_individual_enrollment_query_iterator.
+*/
+MOCKABLE_FUNCTION(, PROVISIONING_QUERY_ITERATOR_HANDLE, prov_sc_create_enrollment_group_query_iterator, PROVISIONING_SERVICE_CLIENT_HANDLE, prov_client, PROVISIONING_QUERY_SPECIFICATION*, query_spec);
+
+/** @brief  Creates an iterator over the device registration states matching a query. See prov_sc_create_individual_enrollment_query_iterator.
+*/
+MOCKABLE_FUNCTION(, PROVISIONING_QUERY_ITERATOR_HANDLE, prov_sc_create_device_registration_state_query_iterator, PROVISIONING_SERVICE_CLIENT_HANDLE, prov_client, PROVISIONING_QUERY_SPECIFICATION*, query_spec);
+
+/** @brief  Gets the next page of a query.
+*
+* @param    iterator        The handle of the query iterator.
+* @param    query_resp_ptr  A pointer to a query response pointer, which will be filled with the next page, or NULL once every
+*                           page has been returned. The page is freed with queryResponse_free.
+*
+* @return   0 upon success, a non-zero number upon failure. After a failure the iterator only fails.
+*/
+MOCKABLE_FUNCTION(, int, prov_sc_query_iterator_get_next, PROVISIONING_QUERY_ITERATOR_HANDLE, iterator, PROVISIONING_QUERY_RESPONSE**, query_resp_ptr);
+
+/** @brief  Disposes of a query iterator and its connection, abandoning any page being fetched.
+*
+* @param    iterator        The handle of the query iterator.
+*/
+MOCKABLE_FUNCTION(, void, prov_sc_query_iterator_destroy, PROVISIONING_QUERY_ITERATOR_HANDLE, iterator);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
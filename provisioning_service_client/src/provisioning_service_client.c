@@ -32,6 +32,21 @@ typedef enum HTTP_CONNECTION_STATE_TAG
     HTTP_STATE_ERROR
 } HTTP_CONNECTION_STATE;
 
+//With keep alive on, a connection stays open between requests, so only the first request made on it pays for the TLS handshake
+typedef struct HTTP_CONNECTION_TAG
+{
+    HTTP_CLIENT_HANDLE http_client;
+    HTTP_CONNECTION_STATE http_state;
+    char* response;
+    HTTP_HEADERS_HANDLE response_headers;
+
+    //Request waiting for the connection to open; owned by the caller until the request completes
+    HTTP_CLIENT_REQUEST_TYPE operation;
+    const char* registration_path;
+    HTTP_HEADERS_HANDLE request_headers;
+    const char* content;
+} HTTP_CONNECTION;
+
 //consider substructure representing SharedAccessSignature?
 typedef struct PROVISIONING_SERVICE_CLIENT_TAG
 {
@@ -40,10 +55,10 @@ typedef struct PROVISIONING_SERVICE_CLIENT_TAG
     char* key_name;
     char* access_key;
 
-    //Connection data
-    HTTP_CONNECTION_STATE http_state;
-    char* response;
-    HTTP_HEADERS_HANDLE response_headers;
+    //Connection data; single requests use the first connection, bulk operations spread their chunks over up to max_concurrent_requests
+    HTTP_CONNECTION connections[PROVISIONING_SC_MAX_CONCURRENT_REQUESTS];
+    size_t max_concurrent_requests;
+    bool keep_alive;
 
     //Connection options
     TRACING_STATUS tracing;
@@ -52,6 +67,19 @@ typedef struct PROVISIONING_SERVICE_CLIENT_TAG
 
 } PROV_SERVICE_CLIENT;
 
+typedef struct PROVISIONING_QUERY_ITERATOR_TAG
+{
+    PROV_SERVICE_CLIENT* prov_client;
+    HTTP_CONNECTION connection;
+    char* content;
+    STRING_HANDLE registration_path;
+    size_t page_size;
+
+    //Headers of the page request in flight, NULL once the last page has been fetched
+    HTTP_HEADERS_HANDLE request_headers;
+    bool is_failed;
+} PROVISIONING_QUERY_ITERATOR;
+
 typedef char*(*VECTOR_SERIALIZE_TO_JSON)(void*);
 typedef void*(*VECTOR_DESERIALIZE_FROM_JSON)(char*);
 typedef char*(*VECTOR_GET_ID)(void*);
@@ -136,14 +164,14 @@ static void on_http_connected(void* callback_ctx, HTTP_CALLBACK_REASON connect_r
 {
     if (callback_ctx != NULL)
     {
-        PROV_SERVICE_CLIENT* prov_client = (PROV_SERVICE_CLIENT*)callback_ctx;
+        HTTP_CONNECTION* connection = (HTTP_CONNECTION*)callback_ctx;
         if (connect_result == HTTP_CALLBACK_REASON_OK)
         {
-            prov_client->http_state = HTTP_STATE_CONNECTED;
+            connection->http_state = HTTP_STATE_CONNECTED;
         }
         else
         {
-            prov_client->http_state = HTTP_STATE_ERROR;
+            connection->http_state = HTTP_STATE_ERROR;
         }
     }
 }
@@ -153,8 +181,8 @@ static void on_http_error(void* callback_ctx, HTTP_CALLBACK_REASON error_result)
     (void)error_result;
     if (callback_ctx != NULL)
     {
-        PROV_SERVICE_CLIENT* prov_client = (PROV_SERVICE_CLIENT*)callback_ctx;
-        prov_client->http_state = HTTP_STATE_ERROR;
+        HTTP_CONNECTION* connection = (HTTP_CONNECTION*)callback_ctx;
+        connection->http_state = HTTP_STATE_ERROR;
         LogError("Failure encountered in http %d", error_result);
     }
     else
@@ -165,34 +193,33 @@ static void on_http_error(void* callback_ctx, HTTP_CALLBACK_REASON error_result)
 
 static void on_http_reply_recv(void* callback_ctx, HTTP_CALLBACK_REASON request_result, const unsigned char* content, size_t content_len, unsigned int status_code, HTTP_HEADERS_HANDLE responseHeadersHandle)
 {
-    (void)content_len;
     if (callback_ctx != NULL)
     {
-        PROV_SERVICE_CLIENT* prov_client = (PROV_SERVICE_CLIENT*)callback_ctx;
+        HTTP_CONNECTION* connection = (HTTP_CONNECTION*)callback_ctx;
         const char* content_str = (const char*)content;
 
-        //attach headers to prov_client
+        //attach headers to the connection
         if (responseHeadersHandle != NULL)
         {
-            if ((prov_client->response_headers = HTTPHeaders_Clone(responseHeadersHandle)) == NULL)
+            if ((connection->response_headers = HTTPHeaders_Clone(responseHeadersHandle)) == NULL)
             {
                 LogError("Copying response headers failed");
-                prov_client->response_headers = NULL;
+                connection->response_headers = NULL;
             }
         }
 
         //if there is a json response
         if (content != NULL)
         {
-            if ((prov_client->response = malloc(content_len + 1)) == NULL)
+            if ((connection->response = malloc(content_len + 1)) == NULL)
             {
                 LogError("Allocating response failed");
-                prov_client->response = NULL;
+                connection->response = NULL;
             }
             else
             {
-                memset(prov_client->response, 0, content_len);
-                memcpy(prov_client->response, content_str, content_len);
+                memcpy(connection->response, content_str, content_len);
+                connection->response[content_len] = '\0';
             }
         }
 
@@ -201,16 +228,16 @@ static void on_http_reply_recv(void* callback_ctx, HTTP_CALLBACK_REASON request_
         {
             if (status_code >= 200 && status_code <= 299)
             {
-                prov_client->http_state = HTTP_STATE_REQUEST_RECV;
+                connection->http_state = HTTP_STATE_REQUEST_RECV;
             }
             else
             {
-                prov_client->http_state = HTTP_STATE_ERROR;
+                connection->http_state = HTTP_STATE_ERROR;
             }
         }
         else
         {
-            prov_client->http_state = HTTP_STATE_ERROR;
+            connection->http_state = HTTP_STATE_ERROR;
         }
     }
     else
@@ -322,10 +349,10 @@ static STRING_HANDLE create_registration_path(const char* path_format, const cha
     return registration_path;
 }
 
-static int get_response_headers(PROV_SERVICE_CLIENT* prov_client, char** cont_token_ptr, const char** resp_type_ptr)
+static int get_response_headers(HTTP_CONNECTION* connection, char** cont_token_ptr, const char** resp_type_ptr)
 {
     int result = 0;
-    HTTP_HEADERS_HANDLE resp_headers = prov_client->response_headers;
+    HTTP_HEADERS_HANDLE resp_headers = connection->response_headers;
     if (resp_headers == NULL)
     {
         LogError("Unable to retrieve headers");
@@ -359,9 +386,38 @@ static int get_response_headers(PROV_SERVICE_CLIENT* prov_client, char** cont_to
     return result;
 }
 
-static HTTP_CLIENT_HANDLE connect_to_service(PROV_SERVICE_CLIENT* prov_client)
+static int read_query_response(HTTP_CONNECTION* connection, char** cont_token_ptr, PROVISIONING_QUERY_RESPONSE** query_res_ptr)
+{
+    int result;
+    const char* resp_type = NULL;
+    PROVISIONING_QUERY_TYPE type;
+
+    if (get_response_headers(connection, cont_token_ptr, &resp_type) != 0)
+    {
+        LogError("Failure reading response headers");
+        result = MU_FAILURE;
+    }
+    else if ((type = queryType_stringToEnum(resp_type)) == QUERY_TYPE_INVALID)
+    {
+        LogError("Failure to parse response type");
+        result = MU_FAILURE;
+    }
+    else if ((*query_res_ptr = queryResponse_deserializeFromJson(connection->response, type)) == NULL)
+    {
+        LogError("Failure deserializing query response");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static int connect_to_service(PROV_SERVICE_CLIENT* prov_client, HTTP_CONNECTION* connection)
 {
-    HTTP_CLIENT_HANDLE result;
+    int result;
 
     // Create uhttp
     TLSIO_CONFIG tls_io_config;
@@ -389,98 +445,193 @@ static HTTP_CLIENT_HANDLE connect_to_service(PROV_SERVICE_CLIENT* prov_client)
     if (interface_desc == NULL)
     {
         LogError("platform default tlsio is NULL");
-        result = NULL;
+        result = MU_FAILURE;
     }
-    else if ((result = uhttp_client_create(interface_desc, &tls_io_config, on_http_error, prov_client)) == NULL)
+    else if ((connection->http_client = uhttp_client_create(interface_desc, &tls_io_config, on_http_error, connection)) == NULL)
     {
         LogError("Failed creating http object");
+        result = MU_FAILURE;
     }
-    else if (prov_client->certificate != NULL && uhttp_client_set_trusted_cert(result, prov_client->certificate) != HTTP_CLIENT_OK)
+    else if (prov_client->certificate != NULL && uhttp_client_set_trusted_cert(connection->http_client, prov_client->certificate) != HTTP_CLIENT_OK)
     {
          LogError("Failed setting trusted cert");
-         uhttp_client_destroy(result);
-         result = NULL;
+         uhttp_client_destroy(connection->http_client);
+         connection->http_client = NULL;
+         result = MU_FAILURE;
      }
-    else if (prov_client->tracing == TRACING_STATUS_ON && uhttp_client_set_trace(result, true, true) != HTTP_CLIENT_OK)
+    else if (prov_client->tracing == TRACING_STATUS_ON && uhttp_client_set_trace(connection->http_client, true, true) != HTTP_CLIENT_OK)
     {
         LogError("Failed setting trace");
-        uhttp_client_destroy(result);
-        result = NULL;
+        uhttp_client_destroy(connection->http_client);
+        connection->http_client = NULL;
+        result = MU_FAILURE;
     }
-    else if (uhttp_client_open(result, prov_client->provisioning_service_uri, DEFAULT_HTTPS_PORT, on_http_connected, prov_client) != HTTP_CLIENT_OK)
+    else
     {
-        LogError("Failed opening http url %s", prov_client->provisioning_service_uri);
-        uhttp_client_destroy(result);
-        result = NULL;
+        connection->http_state = HTTP_STATE_CONNECTING;
+        if (uhttp_client_open(connection->http_client, prov_client->provisioning_service_uri, DEFAULT_HTTPS_PORT, on_http_connected, connection) != HTTP_CLIENT_OK)
+        {
+            LogError("Failed opening http url %s", prov_client->provisioning_service_uri);
+            uhttp_client_destroy(connection->http_client);
+            connection->http_client = NULL;
+            connection->http_state = HTTP_STATE_DISCONNECTED;
+            result = MU_FAILURE;
+        }
+        else
+        {
+            result = 0;
+        }
     }
     return result;
 }
 
-static int rest_call(PROVISIONING_SERVICE_CLIENT_HANDLE prov_client, HTTP_CLIENT_REQUEST_TYPE operation, const char* registration_path, HTTP_HEADERS_HANDLE request_headers, const char* content)
+static void close_connection(HTTP_CONNECTION* connection)
 {
-    int result;
-    size_t content_len;
-    HTTP_CLIENT_HANDLE http_client;
+    if (connection->http_client != NULL)
+    {
+        uhttp_client_close(connection->http_client, NULL, NULL);
+        uhttp_client_destroy(connection->http_client);
+        connection->http_client = NULL;
+    }
+    connection->http_state = HTTP_STATE_DISCONNECTED;
+}
 
-    if (content == NULL)
+static void close_connections(PROV_SERVICE_CLIENT* prov_client)
+{
+    size_t i;
+    for (i = 0; i < PROVISIONING_SC_MAX_CONCURRENT_REQUESTS; i++)
     {
-        content_len = 0;
+        close_connection(&prov_client->connections[i]);
     }
-    else
+}
+
+//Starts a request without waiting for it; poll_request drives it and the response stays on the connection until end_request
+static int send_request(PROV_SERVICE_CLIENT* prov_client, HTTP_CONNECTION* connection, HTTP_CLIENT_REQUEST_TYPE operation, const char* registration_path, HTTP_HEADERS_HANDLE request_headers, const char* content)
+{
+    int result;
+
+    if (connection->http_client != NULL)
     {
-        content_len = strlen(content);
+        //The service closes idle connections; find out before the request is sent rather than after
+        uhttp_client_dowork(connection->http_client);
+        if (connection->http_state == HTTP_STATE_ERROR)
+        {
+            LogInfo("Idle connection was closed, reconnecting");
+            close_connection(connection);
+        }
     }
 
-    http_client = connect_to_service(prov_client);
-    if (http_client == NULL)
+    if (connection->http_client == NULL && connect_to_service(prov_client, connection) != 0)
     {
         LogError("Failed connecting to service");
         result = MU_FAILURE;
     }
     else
     {
+        connection->operation = operation;
+        connection->registration_path = registration_path;
+        connection->request_headers = request_headers;
+        connection->content = content;
         result = 0;
-        do
+    }
+
+    return result;
+}
+
+//Returns true once the request has completed or failed
+static bool poll_request(HTTP_CONNECTION* connection)
+{
+    uhttp_client_dowork(connection->http_client);
+    if (connection->http_state == HTTP_STATE_CONNECTED)
+    {
+        size_t content_len = (connection->content == NULL) ? 0 : strlen(connection->content);
+
+        if (uhttp_client_execute_request(connection->http_client, connection->operation, connection->registration_path, connection->request_headers, (unsigned char*)connection->content, content_len, on_http_reply_recv, connection) != HTTP_CLIENT_OK)
         {
-            uhttp_client_dowork(http_client);
-            if (prov_client->http_state == HTTP_STATE_CONNECTED)
-            {
-                if (uhttp_client_execute_request(http_client, operation, registration_path, request_headers, (unsigned char*)content, content_len, on_http_reply_recv, prov_client) != HTTP_CLIENT_OK)
-                {
-                    LogError("Failure executing http request");
-                    prov_client->http_state = HTTP_STATE_ERROR;
-                    result = MU_FAILURE;
-                }
-                else
-                {
-                    prov_client->http_state = HTTP_STATE_REQUEST_SENT;
-                }
-            }
-            else if (prov_client->http_state == HTTP_STATE_REQUEST_RECV)
-            {
-                prov_client->http_state = HTTP_STATE_COMPLETE;
-            }
-            else if (prov_client->http_state == HTTP_STATE_ERROR)
-            {
-                result = MU_FAILURE;
-                LogError("HTTP error");
-            }
-        } while (prov_client->http_state != HTTP_STATE_COMPLETE && prov_client->http_state != HTTP_STATE_ERROR);
+            LogError("Failure executing http request");
+            connection->http_state = HTTP_STATE_ERROR;
+        }
+        else
+        {
+            connection->http_state = HTTP_STATE_REQUEST_SENT;
+        }
+    }
+    else if (connection->http_state == HTTP_STATE_REQUEST_RECV)
+    {
+        connection->http_state = HTTP_STATE_COMPLETE;
+    }
 
-        uhttp_client_close(http_client, NULL, NULL);
-        uhttp_client_destroy(http_client);
+    return (connection->http_state == HTTP_STATE_COMPLETE || connection->http_state == HTTP_STATE_ERROR);
+}
+
+static int wait_for_response(HTTP_CONNECTION* connection)
+{
+    int result;
+
+    while (!poll_request(connection))
+    {
+    }
+
+    if (connection->http_state == HTTP_STATE_ERROR)
+    {
+        LogError("HTTP error");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+//Frees the response and leaves the connection open for the next request, unless the request failed
+static void end_request(HTTP_CONNECTION* connection)
+{
+    free(connection->response);
+    connection->response = NULL;
+    HTTPHeaders_Free(connection->response_headers);
+    connection->response_headers = NULL;
+    connection->registration_path = NULL;
+    connection->request_headers = NULL;
+    connection->content = NULL;
+
+    if (connection->http_state == HTTP_STATE_COMPLETE)
+    {
+        connection->http_state = HTTP_STATE_CONNECTED;
+    }
+    else
+    {
+        close_connection(connection);
+    }
+}
+
+static int rest_call(PROVISIONING_SERVICE_CLIENT_HANDLE prov_client, HTTP_CLIENT_REQUEST_TYPE operation, const char* registration_path, HTTP_HEADERS_HANDLE request_headers, const char* content)
+{
+    int result;
+    HTTP_CONNECTION* connection = &prov_client->connections[0];
+
+    if (send_request(prov_client, connection, operation, registration_path, request_headers, content) != 0)
+    {
+        LogError("Failed sending request");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        result = wait_for_response(connection);
+        if (!prov_client->keep_alive)
+        {
+            //the response stays on the connection until clear_response
+            close_connection(connection);
+        }
     }
 
-    prov_client->http_state = HTTP_STATE_DISCONNECTED;
     return result;
 }
 
 static void clear_response(PROVISIONING_SERVICE_CLIENT_HANDLE prov_client)
 {
-    free(prov_client->response);
-    prov_client->response = NULL;
-    HTTPHeaders_Free(prov_client->response_headers);
-    prov_client->response_headers = NULL;
+    end_request(&prov_client->connections[0]);
 }
 
 static int prov_sc_create_or_update_record(PROVISIONING_SERVICE_CLIENT_HANDLE prov_client, void** handle_ptr, HANDLE_FUNCTION_VECTOR vector, const char* path_format)
@@ -535,7 +686,7 @@ static int prov_sc_create_or_update_record(PROVISIONING_SERVICE_CLIENT_HANDLE pr
                     if (result == 0)
                     {
                         INDIVIDUAL_ENROLLMENT_HANDLE new_handle;
-                        if ((new_handle = vector.deserializeFromJson(prov_client->response)) == NULL)
+                        if ((new_handle = vector.deserializeFromJson(prov_client->connections[0].response)) == NULL)
                         {
                             LogError("Failure constructing new enrollment structure from json response");
                             result = MU_FAILURE;
@@ -646,7 +797,7 @@ static int prov_sc_get_record(PROVISIONING_SERVICE_CLIENT_HANDLE prov_client, co
                 if (result == 0)
                 {
                     void* handle;
-                    if ((handle = vector.deserializeFromJson(prov_client->response)) == NULL)
+                    if ((handle = vector.deserializeFromJson(prov_client->connections[0].response)) == NULL)
                     {
                         LogError("Failure constructing new enrollment structure from json response");
                         result = MU_FAILURE;
@@ -663,6 +814,190 @@ static int prov_sc_get_record(PROVISIONING_SERVICE_CLIENT_HANDLE prov_client, co
     return result;
 }
 
+static int append_bulk_operation_result(PROVISIONING_BULK_OPERATION_RESULT* bulk_res, PROVISIONING_BULK_OPERATION_RESULT* chunk_res)
+{
+    int result;
+
+    if (chunk_res->num_errors == 0)
+    {
+        result = 0;
+    }
+    else
+    {
+        PROVISIONING_BULK_OPERATION_ERROR** errors;
+        if ((errors = realloc(bulk_res->errors, (bulk_res->num_errors + chunk_res->num_errors) * sizeof(PROVISIONING_BULK_OPERATION_ERROR*))) == NULL)
+        {
+            LogError("Failure growing the bulk operation errors");
+            result = MU_FAILURE;
+        }
+        else
+        {
+            memcpy(errors + bulk_res->num_errors, chunk_res->errors, chunk_res->num_errors * sizeof(PROVISIONING_BULK_OPERATION_ERROR*));
+            bulk_res->errors = errors;
+            bulk_res->num_errors += chunk_res->num_errors;
+
+            //the errors now belong to bulk_res
+            chunk_res->num_errors = 0;
+            result = 0;
+        }
+    }
+
+    if (result == 0)
+    {
+        bulk_res->is_successful = bulk_res->is_successful && chunk_res->is_successful;
+    }
+    bulkOperationResult_free(chunk_res);
+
+    return result;
+}
+
+static int send_bulk_operation_chunk(PROVISIONING_SERVICE_CLIENT_HANDLE prov_client, HTTP_CONNECTION* connection, const PROVISIONING_BULK_OPERATION* bulk_op, size_t first_enrollment, size_t num_enrollments, const char* registration_path, char** content_ptr, HTTP_HEADERS_HANDLE* request_headers_ptr)
+{
+    int result;
+    PROVISIONING_BULK_OPERATION chunk = *bulk_op;
+
+    chunk.enrollments.ie = bulk_op->enrollments.ie + first_enrollment;
+    chunk.num_enrollments = num_enrollments;
+
+    if ((*content_ptr = bulkOperation_serializeToJson(&chunk)) == NULL)
+    {
+        LogError("Failure serializing bulk operation");
+        result = MU_FAILURE;
+    }
+    else if ((*request_headers_ptr = construct_http_headers(prov_client, NULL, HTTP_CLIENT_REQUEST_POST)) == NULL)
+    {
+        LogError("Failure constructing http headers");
+        result = MU_FAILURE;
+    }
+    else if (send_request(prov_client, connection, HTTP_CLIENT_REQUEST_POST, registration_path, *request_headers_ptr, *content_ptr) != 0)
+    {
+        LogError("Failed sending bulk operation request");
+        result = MU_FAILURE;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static int run_chunked_bulk_operation(PROVISIONING_SERVICE_CLIENT_HANDLE prov_client, PROVISIONING_BULK_OPERATION* bulk_op, PROVISIONING_BULK_OPERATION_RESULT** bulk_res_ptr, const char* path_format)
+{
+    int result = 0;
+    PROVISIONING_BULK_OPERATION_RESULT* bulk_res;
+    STRING_HANDLE registration_path;
+
+    if ((bulk_res = malloc(sizeof(PROVISIONING_BULK_OPERATION_RESULT))) == NULL)
+    {
+        LogError("Allocation of bulk operation result failed");
+        result = MU_FAILURE;
+    }
+    else if ((registration_path = create_registration_path(path_format, NULL)) == NULL)
+    {
+        LogError("Failed to construct a registration path");
+        free(bulk_res);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        //The enrollments are split into chunks of the largest size the service accepts, with up to
+        //max_concurrent_requests chunks in flight, each on its own connection
+        char* content[PROVISIONING_SC_MAX_CONCURRENT_REQUESTS];
+        HTTP_HEADERS_HANDLE request_headers[PROVISIONING_SC_MAX_CONCURRENT_REQUESTS];
+        bool is_in_flight[PROVISIONING_SC_MAX_CONCURRENT_REQUESTS];
+        size_t next_enrollment = 0;
+        size_t in_flight_count = 0;
+        size_t i;
+
+        memset(bulk_res, 0, sizeof(PROVISIONING_BULK_OPERATION_RESULT));
+        bulk_res->is_successful = true;
+        for (i = 0; i < prov_client->max_concurrent_requests; i++)
+        {
+            content[i] = NULL;
+            request_headers[i] = NULL;
+            is_in_flight[i] = false;
+        }
+
+        do
+        {
+            for (i = 0; i < prov_client->max_concurrent_requests; i++)
+            {
+                HTTP_CONNECTION* connection = &prov_client->connections[i];
+
+                if (!is_in_flight[i] && result == 0 && next_enrollment < bulk_op->num_enrollments)
+                {
+                    size_t num_enrollments = bulk_op->num_enrollments - next_enrollment;
+                    if (num_enrollments > PROVISIONING_BULK_OPERATION_MAX_ENROLLMENTS)
+                    {
+                        num_enrollments = PROVISIONING_BULK_OPERATION_MAX_ENROLLMENTS;
+                    }
+
+                    if (send_bulk_operation_chunk(prov_client, connection, bulk_op, next_enrollment, num_enrollments, STRING_c_str(registration_path), &content[i], &request_headers[i]) != 0)
+                    {
+                        result = MU_FAILURE;
+                        free(content[i]);
+                        content[i] = NULL;
+                        HTTPHeaders_Free(request_headers[i]);
+                        request_headers[i] = NULL;
+                    }
+                    else
+                    {
+                        next_enrollment += num_enrollments;
+                        is_in_flight[i] = true;
+                        in_flight_count++;
+                    }
+                }
+
+                if (is_in_flight[i] && poll_request(connection))
+                {
+                    PROVISIONING_BULK_OPERATION_RESULT* chunk_res;
+
+                    if (connection->http_state != HTTP_STATE_COMPLETE)
+                    {
+                        LogError("Rest call failed");
+                        result = MU_FAILURE;
+                    }
+                    else if ((chunk_res = bulkOperationResult_deserializeFromJson(connection->response)) == NULL)
+                    {
+                        LogError("Failure deserializing bulk operation result");
+                        result = MU_FAILURE;
+                    }
+                    else if (append_bulk_operation_result(bulk_res, chunk_res) != 0)
+                    {
+                        result = MU_FAILURE;
+                    }
+
+                    end_request(connection);
+                    if (!prov_client->keep_alive)
+                    {
+                        close_connection(connection);
+                    }
+                    free(content[i]);
+                    content[i] = NULL;
+                    HTTPHeaders_Free(request_headers[i]);
+                    request_headers[i] = NULL;
+                    is_in_flight[i] = false;
+                    in_flight_count--;
+                }
+            }
+        } while (in_flight_count > 0 || (result == 0 && next_enrollment < bulk_op->num_enrollments));
+
+        if (result == 0)
+        {
+            *bulk_res_ptr = bulk_res;
+        }
+        else
+        {
+            LogError("Bulk operation failed; chunks completed before the failure may have been applied");
+            bulkOperationResult_free(bulk_res);
+        }
+        STRING_delete(registration_path);
+    }
+
+    return result;
+}
+
 static int prov_sc_run_bulk_operation(PROVISIONING_SERVICE_CLIENT_HANDLE prov_client, PROVISIONING_BULK_OPERATION* bulk_op, PROVISIONING_BULK_OPERATION_RESULT** bulk_res_ptr , const char* path_format)
 {
     int result = 0;
@@ -687,6 +1022,10 @@ static int prov_sc_run_bulk_operation(PROVISIONING_SERVICE_CLIENT_HANDLE prov_cl
         LogError("Invalid Bulk Op Result pointer");
         result = MU_FAILURE;
     }
+    else if (bulk_op->num_enrollments > PROVISIONING_BULK_OPERATION_MAX_ENROLLMENTS)
+    {
+        result = run_chunked_bulk_operation(prov_client, bulk_op, bulk_res_ptr, path_format);
+    }
     else
     {
         char* content;
@@ -717,7 +1056,7 @@ static int prov_sc_run_bulk_operation(PROVISIONING_SERVICE_CLIENT_HANDLE prov_cl
 
                     if (result == 0)
                     {
-                        if ((*bulk_res_ptr = bulkOperationResult_deserializeFromJson(prov_client->response)) == NULL)
+                        if ((*bulk_res_ptr = bulkOperationResult_deserializeFromJson(prov_client->connections[0].response)) == NULL)
                         {
                             LogError("Failure deserializing bulk operation result");
                             result = MU_FAILURE;
@@ -800,25 +1139,9 @@ static int prov_sc_query_records(PROVISIONING_SERVICE_CLIENT_HANDLE prov_client,
 
                     if (result == 0)
                     {
-                        const char* resp_type = NULL;
                         char* new_cont_token = NULL;
-                        PROVISIONING_QUERY_TYPE type;
 
-                        if (get_response_headers(prov_client, &new_cont_token, &resp_type) != 0)
-                        {
-                            LogError("Failure reading response headers");
-                            result = MU_FAILURE;
-                        }
-                        else if ((type = queryType_stringToEnum(resp_type)) == QUERY_TYPE_INVALID)
-                        {
-                            LogError("Failure to parse response type");
-                            result = MU_FAILURE;
-                        }
-                        else if ((*query_res_ptr = queryResponse_deserializeFromJson(prov_client->response, type)) == NULL)
-                        {
-                            LogError("Failure deserializing query response");
-                            result = MU_FAILURE;
-                        }
+                        result = read_query_response(&prov_client->connections[0], &new_cont_token, query_res_ptr);
                         free(*cont_token_ptr);
                         *cont_token_ptr = new_cont_token;
                     }
@@ -838,6 +1161,83 @@ static int prov_sc_query_records(PROVISIONING_SERVICE_CLIENT_HANDLE prov_client,
     return result;
 }
 
+static int send_query_page_request(PROVISIONING_QUERY_ITERATOR* iterator, const char* cont_token)
+{
+    int result;
+
+    if ((iterator->request_headers = construct_http_headers(iterator->prov_client, NULL, HTTP_CLIENT_REQUEST_POST)) == NULL)
+    {
+        LogError("Failure constructing http headers");
+        result = MU_FAILURE;
+    }
+    else if ((add_query_headers(iterator->request_headers, iterator->page_size, cont_token)) != 0 ||
+        send_request(iterator->prov_client, &iterator->connection, HTTP_CLIENT_REQUEST_POST, STRING_c_str(iterator->registration_path), iterator->request_headers, iterator->content) != 0)
+    {
+        LogError("Failure sending query page request");
+        HTTPHeaders_Free(iterator->request_headers);
+        iterator->request_headers = NULL;
+        result = MU_FAILURE;
+    }
+    else
+    {
+        //Get the request on the wire, so the service works on the page while the caller handles the previous one
+        while (!poll_request(&iterator->connection) && iterator->connection.http_state != HTTP_STATE_REQUEST_SENT)
+        {
+        }
+        result = 0;
+    }
+
+    return result;
+}
+
+static PROVISIONING_QUERY_ITERATOR_HANDLE prov_sc_create_query_iterator(PROVISIONING_SERVICE_CLIENT_HANDLE prov_client, PROVISIONING_QUERY_SPECIFICATION* query_spec, const char* path_format)
+{
+    PROVISIONING_QUERY_ITERATOR* result;
+
+    if (prov_client == NULL)
+    {
+        LogError("Invalid Provisioning Client Handle");
+        result = NULL;
+    }
+    else if (query_spec == NULL || query_spec->version != PROVISIONING_QUERY_SPECIFICATION_VERSION_1)
+    {
+        LogError("Invalid Query details");
+        result = NULL;
+    }
+    else if ((result = malloc(sizeof(PROVISIONING_QUERY_ITERATOR))) == NULL)
+    {
+        LogError("Allocation of query iterator failed");
+    }
+    else
+    {
+        memset(result, 0, sizeof(PROVISIONING_QUERY_ITERATOR));
+        result->prov_client = prov_client;
+        result->page_size = query_spec->page_size;
+
+        //do not serialize the query specification if there is no query_string (i.e. DRS query)
+        if ((query_spec->query_string != NULL) && ((result->content = querySpecification_serializeToJson(query_spec)) == NULL))
+        {
+            LogError("Failure serializing query specification");
+            prov_sc_query_iterator_destroy(result);
+            result = NULL;
+        }
+        else if ((result->registration_path = create_registration_path(path_format, query_spec->registration_id)) == NULL)
+        {
+            LogError("Failed to construct a registration path");
+            prov_sc_query_iterator_destroy(result);
+            result = NULL;
+        }
+        else if (send_query_page_request(result, NULL) != 0)
+        {
+            LogError("Failure requesting the first query page");
+            prov_sc_query_iterator_destroy(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
 //Exposed functions below
 
 void prov_sc_destroy(PROVISIONING_SERVICE_CLIENT_HANDLE prov_client)
@@ -847,8 +1247,7 @@ void prov_sc_destroy(PROVISIONING_SERVICE_CLIENT_HANDLE prov_client)
         free(prov_client->provisioning_service_uri);
         free(prov_client->key_name);
         free(prov_client->access_key);
-        free(prov_client->response);
-        HTTPHeaders_Free(prov_client->response_headers);
+        close_connections(prov_client);
         free(prov_client->certificate);
         free(prov_client);
     }
@@ -934,6 +1333,7 @@ PROVISIONING_SERVICE_CLIENT_HANDLE prov_sc_create_from_connection_string(const c
                     else
                     {
                         result->tracing = TRACING_STATUS_OFF;
+                        result->max_concurrent_requests = 1;
                     }
                 }
                 Map_Destroy(connection_string_values_map);
@@ -948,6 +1348,8 @@ void prov_sc_set_trace(PROVISIONING_SERVICE_CLIENT_HANDLE prov_client, TRACING_S
 {
     if (prov_client != NULL)
     {
+        //settings are applied when a connection opens
+        close_connections(prov_client);
         prov_client->tracing = status;
     }
 }
@@ -963,6 +1365,7 @@ int prov_sc_set_certificate(PROVISIONING_SERVICE_CLIENT_HANDLE prov_client, cons
     }
     else if (certificate == NULL)
     {
+        close_connections(prov_client);
         free(prov_client->certificate);
         prov_client->certificate = NULL;
     }
@@ -971,6 +1374,10 @@ int prov_sc_set_certificate(PROVISIONING_SERVICE_CLIENT_HANDLE prov_client, cons
         LogError("Failed allocating memory for certificate");
         result = MU_FAILURE;
     }
+    else
+    {
+        close_connections(prov_client);
+    }
 
     return result;
 }
@@ -1004,6 +1411,7 @@ int prov_sc_set_proxy(PROVISIONING_SERVICE_CLIENT_HANDLE prov_client, HTTP_PROXY
         }
         else
         {
+            close_connections(prov_client);
             prov_client->proxy_options = proxy_options;
         }
     }
@@ -1011,6 +1419,45 @@ int prov_sc_set_proxy(PROVISIONING_SERVICE_CLIENT_HANDLE prov_client, HTTP_PROXY
     return result;
 }
 
+void prov_sc_set_keep_alive(PROVISIONING_SERVICE_CLIENT_HANDLE prov_client, bool keep_alive)
+{
+    if (prov_client != NULL)
+    {
+        if (!keep_alive)
+        {
+            close_connections(prov_client);
+        }
+        prov_client->keep_alive = keep_alive;
+    }
+}
+
+int prov_sc_set_max_concurrent_requests(PROVISIONING_SERVICE_CLIENT_HANDLE prov_client, size_t max_concurrent_requests)
+{
+    int result = 0;
+
+    if (prov_client == NULL)
+    {
+        LogError("Invalid prov_client");
+        result = MU_FAILURE;
+    }
+    else if (max_concurrent_requests < 1 || max_concurrent_requests > PROVISIONING_SC_MAX_CONCURRENT_REQUESTS)
+    {
+        LogError("Invalid max_concurrent_requests %lu, must be between 1 and %d", (unsigned long)max_concurrent_requests, PROVISIONING_SC_MAX_CONCURRENT_REQUESTS);
+        result = MU_FAILURE;
+    }
+    else
+    {
+        size_t i;
+        for (i = max_concurrent_requests; i < prov_client->max_concurrent_requests; i++)
+        {
+            close_connection(&prov_client->connections[i]);
+        }
+        prov_client->max_concurrent_requests = max_concurrent_requests;
+    }
+
+    return result;
+}
+
 int prov_sc_create_or_update_individual_enrollment(PROVISIONING_SERVICE_CLIENT_HANDLE prov_client, INDIVIDUAL_ENROLLMENT_HANDLE* enrollment_ptr)
 {
     return prov_sc_create_or_update_record(prov_client,(void**)enrollment_ptr, getVector_individualEnrollment(), INDV_ENROLL_PROVISION_PATH_FMT);
@@ -1090,4 +1537,88 @@ int prov_sc_get_enrollment_group(PROVISIONING_SERVICE_CLIENT_HANDLE prov_client,
 int prov_sc_query_enrollment_group(PROVISIONING_SERVICE_CLIENT_HANDLE prov_client, PROVISIONING_QUERY_SPECIFICATION* query_spec, char** cont_token_ptr, PROVISIONING_QUERY_RESPONSE** query_resp_ptr)
 {
     return prov_sc_query_records(prov_client, query_spec, cont_token_ptr, query_resp_ptr, ENROLL_GROUP_QUERY_PATH_FMT);
-}
\ No newline at end of file
+}
+
+PROVISIONING_QUERY_ITERATOR_HANDLE prov_sc_create_individual_enrollment_query_iterator(PROVISIONING_SERVICE_CLIENT_HANDLE prov_client, PROVISIONING_QUERY_SPECIFICATION* query_spec)
+{
+    return prov_sc_create_query_iterator(prov_client, query_spec, INDV_ENROLL_QUERY_PATH_FMT);
+}
+
+PROVISIONING_QUERY_ITERATOR_HANDLE prov_sc_create_enrollment_group_query_iterator(PROVISIONING_SERVICE_CLIENT_HANDLE prov_client, PROVISIONING_QUERY_SPECIFICATION* query_spec)
+{
+    return prov_sc_create_query_iterator(prov_client, query_spec, ENROLL_GROUP_QUERY_PATH_FMT);
+}
+
+PROVISIONING_QUERY_ITERATOR_HANDLE prov_sc_create_device_registration_state_query_iterator(PROVISIONING_SERVICE_CLIENT_HANDLE prov_client, PROVISIONING_QUERY_SPECIFICATION* query_spec)
+{
+    return prov_sc_create_query_iterator(prov_client, query_spec, REG_STATE_QUERY_PATH_FMT);
+}
+
+int prov_sc_query_iterator_get_next(PROVISIONING_QUERY_ITERATOR_HANDLE iterator, PROVISIONING_QUERY_RESPONSE** query_resp_ptr)
+{
+    int result;
+
+    if (iterator == NULL || query_resp_ptr == NULL)
+    {
+        LogError("Invalid argument iterator: %p, query_resp_ptr: %p", iterator, query_resp_ptr);
+        result = MU_FAILURE;
+    }
+    else if (iterator->is_failed)
+    {
+        LogError("Query iterator has failed");
+        result = MU_FAILURE;
+    }
+    else if (iterator->request_headers == NULL)
+    {
+        //no more pages
+        *query_resp_ptr = NULL;
+        result = 0;
+    }
+    else
+    {
+        char* cont_token = NULL;
+
+        *query_resp_ptr = NULL;
+        if (wait_for_response(&iterator->connection) != 0)
+        {
+            LogError("Rest call failed");
+            result = MU_FAILURE;
+        }
+        else
+        {
+            result = read_query_response(&iterator->connection, &cont_token, query_resp_ptr);
+        }
+        end_request(&iterator->connection);
+        HTTPHeaders_Free(iterator->request_headers);
+        iterator->request_headers = NULL;
+
+        if (result == 0 && cont_token != NULL && send_query_page_request(iterator, cont_token) != 0)
+        {
+            LogError("Failure requesting the next query page");
+            result = MU_FAILURE;
+        }
+
+        if (result != 0)
+        {
+            queryResponse_free(*query_resp_ptr);
+            *query_resp_ptr = NULL;
+            iterator->is_failed = true;
+        }
+        free(cont_token);
+    }
+
+    return result;
+}
+
+void prov_sc_query_iterator_destroy(PROVISIONING_QUERY_ITERATOR_HANDLE iterator)
+{
+    if (iterator != NULL)
+    {
+        end_request(&iterator->connection);
+        close_connection(&iterator->connection);
+        HTTPHeaders_Free(iterator->request_headers);
+        STRING_delete(iterator->registration_path);
+        free(iterator->content);
+        free(iterator);
+    }
+}
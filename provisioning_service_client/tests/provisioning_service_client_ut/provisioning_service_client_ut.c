@@ -60,6 +60,7 @@ static TEST_MUTEX_HANDLE g_testByTest;
 static int g_uhttp_client_dowork_call_count;
 static ON_HTTP_OPEN_COMPLETE_CALLBACK g_on_http_open;
 static void* g_http_open_ctx;
+static bool g_is_http_open_pending;
 static ON_HTTP_REQUEST_CALLBACK g_on_http_reply_recv;
 static void* g_http_reply_recv_ctx;
 
@@ -176,7 +177,8 @@ static HTTP_CLIENT_RESULT my_uhttp_client_open(HTTP_CLIENT_HANDLE handle, const
     (void)host;
     (void)port_num;
     g_on_http_open = on_connect;
-    g_http_open_ctx = callback_ctx; //prov_client
+    g_http_open_ctx = callback_ctx; //connection
+    g_is_http_open_pending = true;
 
     //note that a real malloc does occur in this fn, but it can't be mocked since it's in a field of handle
 
@@ -217,11 +219,17 @@ static void my_uhttp_client_dowork(HTTP_CLIENT_HANDLE handle)
     else
         content = NULL;
 
-    if (g_uhttp_client_dowork_call_count == 0)
+    if (g_is_http_open_pending)
+    {
+        g_is_http_open_pending = false;
         g_on_http_open(g_http_open_ctx, HTTP_CALLBACK_REASON_OK);
-    else if (g_uhttp_client_dowork_call_count == 1)
+    }
+    else if (g_on_http_reply_recv != NULL)
     {
-        g_on_http_reply_recv(g_http_reply_recv_ctx, HTTP_CALLBACK_REASON_OK, content, 1, STATUS_CODE_SUCCESS, TEST_HTTP_HEADERS_HANDLE);
+        //each request is answered once, so a connection that is kept alive idles until the next request
+        ON_HTTP_REQUEST_CALLBACK on_http_reply_recv = g_on_http_reply_recv;
+        g_on_http_reply_recv = NULL;
+        on_http_reply_recv(g_http_reply_recv_ctx, HTTP_CALLBACK_REASON_OK, content, 1, STATUS_CODE_SUCCESS, TEST_HTTP_HEADERS_HANDLE);
     }
     g_uhttp_client_dowork_call_count++;
 }
@@ -349,7 +357,12 @@ static PROVISIONING_BULK_OPERATION_RESULT* my_bulkOperationResult_deserializeFro
 {
     PROVISIONING_BULK_OPERATION_RESULT* result;
     if (json_string != NULL)
-        result = (PROVISIONING_BULK_OPERATION_RESULT*)real_malloc(1);
+    {
+        result = (PROVISIONING_BULK_OPERATION_RESULT*)real_malloc(sizeof(PROVISIONING_BULK_OPERATION_RESULT));
+        result->is_successful = true;
+        result->errors = NULL;
+        result->num_errors = 0;
+    }
     else
         result = NULL;
     return result;
@@ -718,6 +731,7 @@ TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
 
     g_on_http_open = NULL;
     g_http_open_ctx = NULL;
+    g_is_http_open_pending = false;
     g_on_http_reply_recv = NULL;
     g_http_reply_recv_ctx = NULL;
     g_uhttp_client_dowork_call_count = 0;
@@ -958,8 +972,6 @@ TEST_FUNCTION(prov_sc_destroy_GOLDEN)
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(HTTPHeaders_Free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     //act
@@ -3179,6 +3191,7 @@ TEST_FUNCTION(prov_sc_run_individual_enrollment_bulk_operation_NULL_prov)
     PROVISIONING_BULK_OPERATION bulkop;
     bulkop.version = PROVISIONING_BULK_OPERATION_VERSION_1;
     bulkop.enrollments.ie = ie_arr;
+    bulkop.num_enrollments = 2;
     bulkop.mode = BULK_OP_CREATE;
     bulkop.type = BULK_OP_INDIVIDUAL_ENROLLMENT;
     PROVISIONING_BULK_OPERATION_RESULT* bulk_res;
@@ -3219,6 +3232,7 @@ TEST_FUNCTION(prov_sc_run_individual_enrollment_bulk_operation_NULL_bulk_res)
     PROVISIONING_BULK_OPERATION bulkop;
     bulkop.version = PROVISIONING_BULK_OPERATION_VERSION_1;
     bulkop.enrollments.ie = ie_arr;
+    bulkop.num_enrollments = 2;
     bulkop.mode = BULK_OP_CREATE;
     bulkop.type = BULK_OP_INDIVIDUAL_ENROLLMENT;
     umock_c_reset_all_calls();
@@ -3242,6 +3256,7 @@ TEST_FUNCTION(prov_sc_run_individual_enrollment_bulk_operation_invalid_bulkop_ve
     PROVISIONING_BULK_OPERATION bulkop;
     bulkop.version = 47474747;
     bulkop.enrollments.ie = ie_arr;
+    bulkop.num_enrollments = 2;
     bulkop.mode = BULK_OP_CREATE;
     bulkop.type = BULK_OP_INDIVIDUAL_ENROLLMENT;
     PROVISIONING_BULK_OPERATION_RESULT* bulk_res;
@@ -3266,6 +3281,7 @@ TEST_FUNCTION(prov_sc_run_individual_enrollment_bulk_operation_SUCCESS)
     PROVISIONING_BULK_OPERATION bulkop;
     bulkop.version = PROVISIONING_BULK_OPERATION_VERSION_1;
     bulkop.enrollments.ie = ie_arr;
+    bulkop.num_enrollments = 2;
     bulkop.mode = BULK_OP_CREATE;
     bulkop.type = BULK_OP_INDIVIDUAL_ENROLLMENT;
     PROVISIONING_BULK_OPERATION_RESULT* bulk_res = NULL;
@@ -3307,6 +3323,7 @@ TEST_FUNCTION(prov_sc_run_individual_enrollment_bulk_operation_ERROR)
     PROVISIONING_BULK_OPERATION bulkop;
     bulkop.version = PROVISIONING_BULK_OPERATION_VERSION_1;
     bulkop.enrollments.ie = ie_arr;
+    bulkop.num_enrollments = 2;
     bulkop.mode = BULK_OP_CREATE;
     bulkop.type = BULK_OP_INDIVIDUAL_ENROLLMENT;
     PROVISIONING_BULK_OPERATION_RESULT* bulk_res = NULL;
@@ -4509,4 +4526,408 @@ TEST_FUNCTION(prov_sc_query_device_registration_state_success_paging_given_token
     prov_sc_destroy(sc);
 }
 
+TEST_FUNCTION(prov_sc_set_keep_alive_reuses_connection)
+{
+    //arrange
+    PROVISIONING_SERVICE_CLIENT_HANDLE sc = prov_sc_create_from_connection_string(TEST_CONNECTION_STRING);
+    INDIVIDUAL_ENROLLMENT_HANDLE ie = NULL;
+    prov_sc_set_keep_alive(sc, true);
+    int res = prov_sc_get_individual_enrollment(sc, TEST_REGID, &ie);
+    ASSERT_ARE_EQUAL(int, res, 0);
+    individualEnrollment_destroy(ie);
+    ie = NULL;
+    umock_c_reset_all_calls();
+
+    expected_calls_construct_registration_path(true);
+    expected_calls_construct_http_headers(NO_ETAG, HTTP_CLIENT_REQUEST_GET, false);
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)); //does not fail
+    STRICT_EXPECTED_CALL(uhttp_client_dowork(IGNORED_PTR_ARG)); //checks the idle connection
+    STRICT_EXPECTED_CALL(uhttp_client_dowork(IGNORED_PTR_ARG)); //does not fail
+    STRICT_EXPECTED_CALL(uhttp_client_execute_request(IGNORED_PTR_ARG, HTTP_CLIENT_REQUEST_GET, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uhttp_client_dowork(IGNORED_PTR_ARG)); //does not fail
+    STRICT_EXPECTED_CALL(HTTPHeaders_Clone(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(individualEnrollment_deserializeFromJson(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)); //does not fail
+    STRICT_EXPECTED_CALL(HTTPHeaders_Free(IGNORED_PTR_ARG)); //does not fail
+    STRICT_EXPECTED_CALL(HTTPHeaders_Free(IGNORED_PTR_ARG)); //does not fail
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)); //does not fail
+
+    //act
+    res = prov_sc_get_individual_enrollment(sc, TEST_REGID, &ie);
+
+    //assert
+    ASSERT_ARE_EQUAL(int, res, 0);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NOT_NULL(ie);
+
+    //cleanup
+    prov_sc_destroy(sc);
+    individualEnrollment_destroy(ie);
+}
+
+TEST_FUNCTION(prov_sc_set_keep_alive_false_closes_connection)
+{
+    //arrange
+    PROVISIONING_SERVICE_CLIENT_HANDLE sc = prov_sc_create_from_connection_string(TEST_CONNECTION_STRING);
+    INDIVIDUAL_ENROLLMENT_HANDLE ie = NULL;
+    prov_sc_set_keep_alive(sc, true);
+    int res = prov_sc_get_individual_enrollment(sc, TEST_REGID, &ie);
+    ASSERT_ARE_EQUAL(int, res, 0);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uhttp_client_close(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uhttp_client_destroy(IGNORED_PTR_ARG));
+
+    //act
+    prov_sc_set_keep_alive(sc, false);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    prov_sc_destroy(sc);
+    individualEnrollment_destroy(ie);
+}
+
+TEST_FUNCTION(prov_sc_set_max_concurrent_requests_ERROR_INPUT_NULL)
+{
+    //arrange
+    umock_c_reset_all_calls();
+
+    //act
+    int res = prov_sc_set_max_concurrent_requests(NULL, 2);
+
+    //assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, res);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(prov_sc_set_max_concurrent_requests_ERROR_INPUT_OUT_OF_RANGE)
+{
+    //arrange
+    PROVISIONING_SERVICE_CLIENT_HANDLE sc = prov_sc_create_from_connection_string(TEST_CONNECTION_STRING);
+    umock_c_reset_all_calls();
+
+    //act
+    int res_zero = prov_sc_set_max_concurrent_requests(sc, 0);
+    int res_too_big = prov_sc_set_max_concurrent_requests(sc, PROVISIONING_SC_MAX_CONCURRENT_REQUESTS + 1);
+
+    //assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, res_zero);
+    ASSERT_ARE_NOT_EQUAL(int, 0, res_too_big);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    prov_sc_destroy(sc);
+}
+
+TEST_FUNCTION(prov_sc_set_max_concurrent_requests_GOLDEN)
+{
+    //arrange
+    PROVISIONING_SERVICE_CLIENT_HANDLE sc = prov_sc_create_from_connection_string(TEST_CONNECTION_STRING);
+    umock_c_reset_all_calls();
+
+    //act
+    int res = prov_sc_set_max_concurrent_requests(sc, PROVISIONING_SC_MAX_CONCURRENT_REQUESTS);
+
+    //assert
+    ASSERT_ARE_EQUAL(int, 0, res);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    prov_sc_destroy(sc);
+}
+
+static void expected_calls_bulk_operation_chunk()
+{
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)); //does not fail
+    STRICT_EXPECTED_CALL(bulkOperation_serializeToJson(IGNORED_PTR_ARG));
+    expected_calls_construct_http_headers(NO_ETAG, HTTP_CLIENT_REQUEST_POST, false);
+    expected_calls_connect_to_service();
+    STRICT_EXPECTED_CALL(uhttp_client_dowork(IGNORED_PTR_ARG)); //does not fail
+    STRICT_EXPECTED_CALL(uhttp_client_execute_request(IGNORED_PTR_ARG, HTTP_CLIENT_REQUEST_POST, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uhttp_client_dowork(IGNORED_PTR_ARG)); //does not fail
+    STRICT_EXPECTED_CALL(HTTPHeaders_Clone(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(bulkOperationResult_deserializeFromJson(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(bulkOperationResult_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)); //response
+    STRICT_EXPECTED_CALL(HTTPHeaders_Free(IGNORED_PTR_ARG)); //response headers
+    STRICT_EXPECTED_CALL(uhttp_client_close(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG)); //does not fail
+    STRICT_EXPECTED_CALL(uhttp_client_destroy(IGNORED_PTR_ARG)); //does not fail
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)); //content
+    STRICT_EXPECTED_CALL(HTTPHeaders_Free(IGNORED_PTR_ARG)); //request headers
+}
+
+TEST_FUNCTION(prov_sc_run_individual_enrollment_bulk_operation_chunked_SUCCESS)
+{
+    //arrange
+    PROVISIONING_SERVICE_CLIENT_HANDLE sc = prov_sc_create_from_connection_string(TEST_CONNECTION_STRING);
+    INDIVIDUAL_ENROLLMENT_HANDLE ie_arr[PROVISIONING_BULK_OPERATION_MAX_ENROLLMENTS + 1];
+    PROVISIONING_BULK_OPERATION bulkop;
+    size_t i;
+    for (i = 0; i < PROVISIONING_BULK_OPERATION_MAX_ENROLLMENTS + 1; i++)
+    {
+        ie_arr[i] = TEST_INDIVIDUAL_ENROLLMENT_HANDLE;
+    }
+    bulkop.version = PROVISIONING_BULK_OPERATION_VERSION_1;
+    bulkop.enrollments.ie = ie_arr;
+    bulkop.num_enrollments = PROVISIONING_BULK_OPERATION_MAX_ENROLLMENTS + 1;
+    bulkop.mode = BULK_OP_CREATE;
+    bulkop.type = BULK_OP_INDIVIDUAL_ENROLLMENT;
+    PROVISIONING_BULK_OPERATION_RESULT* bulk_res = NULL;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    expected_calls_construct_registration_path(false);
+    expected_calls_bulk_operation_chunk();
+    expected_calls_bulk_operation_chunk();
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
+
+    //act
+    int res = prov_sc_run_individual_enrollment_bulk_operation(sc, &bulkop, &bulk_res);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, res);
+    ASSERT_IS_NOT_NULL(bulk_res);
+    ASSERT_IS_TRUE(bulk_res->is_successful);
+
+    //cleanup
+    prov_sc_destroy(sc);
+    bulkOperationResult_free(bulk_res);
+}
+
+TEST_FUNCTION(prov_sc_run_individual_enrollment_bulk_operation_chunked_ERROR)
+{
+    //arrange
+    PROVISIONING_SERVICE_CLIENT_HANDLE sc = prov_sc_create_from_connection_string(TEST_CONNECTION_STRING);
+    INDIVIDUAL_ENROLLMENT_HANDLE ie_arr[PROVISIONING_BULK_OPERATION_MAX_ENROLLMENTS + 1];
+    PROVISIONING_BULK_OPERATION bulkop;
+    size_t i;
+    for (i = 0; i < PROVISIONING_BULK_OPERATION_MAX_ENROLLMENTS + 1; i++)
+    {
+        ie_arr[i] = TEST_INDIVIDUAL_ENROLLMENT_HANDLE;
+    }
+    bulkop.version = PROVISIONING_BULK_OPERATION_VERSION_1;
+    bulkop.enrollments.ie = ie_arr;
+    bulkop.num_enrollments = PROVISIONING_BULK_OPERATION_MAX_ENROLLMENTS + 1;
+    bulkop.mode = BULK_OP_CREATE;
+    bulkop.type = BULK_OP_INDIVIDUAL_ENROLLMENT;
+    PROVISIONING_BULK_OPERATION_RESULT* bulk_res = NULL;
+    umock_c_reset_all_calls();
+
+    //the second chunk cannot be serialized
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    expected_calls_construct_registration_path(false);
+    expected_calls_bulk_operation_chunk();
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)); //does not fail
+    STRICT_EXPECTED_CALL(bulkOperation_serializeToJson(IGNORED_PTR_ARG)).SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)); //content
+    STRICT_EXPECTED_CALL(HTTPHeaders_Free(IGNORED_PTR_ARG)); //request headers
+    STRICT_EXPECTED_CALL(bulkOperationResult_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
+
+    //act
+    int res = prov_sc_run_individual_enrollment_bulk_operation(sc, &bulkop, &bulk_res);
+
+    //assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, res);
+    ASSERT_IS_NULL(bulk_res);
+
+    //cleanup
+    prov_sc_destroy(sc);
+}
+
+TEST_FUNCTION(prov_sc_create_individual_enrollment_query_iterator_ERROR_INPUT_NULL_PROV_SC)
+{
+    //arrange
+    PROVISIONING_QUERY_SPECIFICATION qs = { 0 };
+    qs.query_string = TEST_QUERY_STRING;
+    qs.version = PROVISIONING_QUERY_SPECIFICATION_VERSION_1;
+    umock_c_reset_all_calls();
+
+    //act
+    PROVISIONING_QUERY_ITERATOR_HANDLE iterator = prov_sc_create_individual_enrollment_query_iterator(NULL, &qs);
+
+    //assert
+    ASSERT_IS_NULL(iterator);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(prov_sc_create_individual_enrollment_query_iterator_ERROR_INPUT_INVALID_QUERY_SPEC)
+{
+    //arrange
+    PROVISIONING_SERVICE_CLIENT_HANDLE sc = prov_sc_create_from_connection_string(TEST_CONNECTION_STRING);
+    PROVISIONING_QUERY_SPECIFICATION qs = { 0 };
+    qs.query_string = TEST_QUERY_STRING;
+    qs.version = 0;
+    umock_c_reset_all_calls();
+
+    //act
+    PROVISIONING_QUERY_ITERATOR_HANDLE iterator_null = prov_sc_create_individual_enrollment_query_iterator(sc, NULL);
+    PROVISIONING_QUERY_ITERATOR_HANDLE iterator_version = prov_sc_create_individual_enrollment_query_iterator(sc, &qs);
+
+    //assert
+    ASSERT_IS_NULL(iterator_null);
+    ASSERT_IS_NULL(iterator_version);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    prov_sc_destroy(sc);
+}
+
+static void expected_calls_query_page_request(bool has_cont_token, bool is_connected)
+{
+    expected_calls_construct_http_headers(NO_ETAG, HTTP_CLIENT_REQUEST_POST, false);
+    expected_calls_add_query_headers(true, has_cont_token);
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)); //does not fail
+    if (is_connected)
+    {
+        STRICT_EXPECTED_CALL(uhttp_client_dowork(IGNORED_PTR_ARG)); //checks the idle connection
+    }
+    else
+    {
+        expected_calls_connect_to_service();
+    }
+    STRICT_EXPECTED_CALL(uhttp_client_dowork(IGNORED_PTR_ARG)); //does not fail
+    STRICT_EXPECTED_CALL(uhttp_client_execute_request(IGNORED_PTR_ARG, HTTP_CLIENT_REQUEST_POST, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+}
+
+static void expected_calls_query_page_response(const char* cont_token)
+{
+    STRICT_EXPECTED_CALL(uhttp_client_dowork(IGNORED_PTR_ARG)); //does not fail
+    STRICT_EXPECTED_CALL(HTTPHeaders_Clone(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(HTTPHeaders_FindHeaderValue(IGNORED_PTR_ARG, IGNORED_PTR_ARG)).SetReturn(cont_token); //cannot fail
+    if (cont_token != NULL)
+    {
+        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    }
+    STRICT_EXPECTED_CALL(HTTPHeaders_FindHeaderValue(IGNORED_PTR_ARG, IGNORED_PTR_ARG)).SetReturn(QUERY_RESPONSE_HEADER_ITEM_TYPE_VALUE_INDIVIDUAL_ENROLLMENT);
+    STRICT_EXPECTED_CALL(queryType_stringToEnum(QUERY_RESPONSE_HEADER_ITEM_TYPE_VALUE_INDIVIDUAL_ENROLLMENT)); //cannot fail
+    STRICT_EXPECTED_CALL(queryResponse_deserializeFromJson(IGNORED_PTR_ARG, QUERY_TYPE_INDIVIDUAL_ENROLLMENT));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)); //response
+    STRICT_EXPECTED_CALL(HTTPHeaders_Free(IGNORED_PTR_ARG)); //response headers
+    STRICT_EXPECTED_CALL(HTTPHeaders_Free(IGNORED_PTR_ARG)); //request headers
+}
+
+TEST_FUNCTION(prov_sc_create_individual_enrollment_query_iterator_GOLDEN)
+{
+    //arrange
+    PROVISIONING_SERVICE_CLIENT_HANDLE sc = prov_sc_create_from_connection_string(TEST_CONNECTION_STRING);
+    PROVISIONING_QUERY_SPECIFICATION qs = { 0 };
+    qs.page_size = 5;
+    qs.query_string = TEST_QUERY_STRING;
+    qs.version = PROVISIONING_QUERY_SPECIFICATION_VERSION_1;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(querySpecification_serializeToJson(&qs));
+    expected_calls_construct_registration_path(false);
+    expected_calls_query_page_request(false, false);
+
+    //act
+    PROVISIONING_QUERY_ITERATOR_HANDLE iterator = prov_sc_create_individual_enrollment_query_iterator(sc, &qs);
+
+    //assert
+    ASSERT_IS_NOT_NULL(iterator);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    prov_sc_query_iterator_destroy(iterator);
+    prov_sc_destroy(sc);
+}
+
+TEST_FUNCTION(prov_sc_query_iterator_get_next_ERROR_INPUT_NULL)
+{
+    //arrange
+    PROVISIONING_SERVICE_CLIENT_HANDLE sc = prov_sc_create_from_connection_string(TEST_CONNECTION_STRING);
+    PROVISIONING_QUERY_SPECIFICATION qs = { 0 };
+    qs.page_size = 5;
+    qs.query_string = TEST_QUERY_STRING;
+    qs.version = PROVISIONING_QUERY_SPECIFICATION_VERSION_1;
+    PROVISIONING_QUERY_ITERATOR_HANDLE iterator = prov_sc_create_individual_enrollment_query_iterator(sc, &qs);
+    PROVISIONING_QUERY_RESPONSE* query_resp = NULL;
+    umock_c_reset_all_calls();
+
+    //act
+    int res_iterator = prov_sc_query_iterator_get_next(NULL, &query_resp);
+    int res_resp = prov_sc_query_iterator_get_next(iterator, NULL);
+
+    //assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, res_iterator);
+    ASSERT_ARE_NOT_EQUAL(int, 0, res_resp);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    prov_sc_query_iterator_destroy(iterator);
+    prov_sc_destroy(sc);
+}
+
+TEST_FUNCTION(prov_sc_query_iterator_get_next_prefetches_next_page)
+{
+    //arrange
+    PROVISIONING_SERVICE_CLIENT_HANDLE sc = prov_sc_create_from_connection_string(TEST_CONNECTION_STRING);
+    PROVISIONING_QUERY_SPECIFICATION qs = { 0 };
+    qs.page_size = 5;
+    qs.query_string = TEST_QUERY_STRING;
+    qs.version = PROVISIONING_QUERY_SPECIFICATION_VERSION_1;
+    PROVISIONING_QUERY_ITERATOR_HANDLE iterator = prov_sc_create_individual_enrollment_query_iterator(sc, &qs);
+    PROVISIONING_QUERY_RESPONSE* query_resp = NULL;
+    umock_c_reset_all_calls();
+
+    expected_calls_query_page_response(TEST_CONT_TOKEN);
+    expected_calls_query_page_request(true, true);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)); //continuation token
+
+    //act
+    int res = prov_sc_query_iterator_get_next(iterator, &query_resp);
+
+    //assert
+    ASSERT_ARE_EQUAL(int, 0, res);
+    ASSERT_IS_NOT_NULL(query_resp);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    queryResponse_free(query_resp);
+    prov_sc_query_iterator_destroy(iterator);
+    prov_sc_destroy(sc);
+}
+
+TEST_FUNCTION(prov_sc_query_iterator_get_next_last_page)
+{
+    //arrange
+    PROVISIONING_SERVICE_CLIENT_HANDLE sc = prov_sc_create_from_connection_string(TEST_CONNECTION_STRING);
+    PROVISIONING_QUERY_SPECIFICATION qs = { 0 };
+    qs.page_size = 5;
+    qs.query_string = TEST_QUERY_STRING;
+    qs.version = PROVISIONING_QUERY_SPECIFICATION_VERSION_1;
+    PROVISIONING_QUERY_ITERATOR_HANDLE iterator = prov_sc_create_individual_enrollment_query_iterator(sc, &qs);
+    PROVISIONING_QUERY_RESPONSE* query_resp = NULL;
+    PROVISIONING_QUERY_RESPONSE* end_resp = (PROVISIONING_QUERY_RESPONSE*)0x1;
+    umock_c_reset_all_calls();
+
+    expected_calls_query_page_response(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)); //no continuation token
+
+    //act
+    int res = prov_sc_query_iterator_get_next(iterator, &query_resp);
+    int res_end = prov_sc_query_iterator_get_next(iterator, &end_resp);
+
+    //assert
+    ASSERT_ARE_EQUAL(int, 0, res);
+    ASSERT_IS_NOT_NULL(query_resp);
+    ASSERT_ARE_EQUAL(int, 0, res_end);
+    ASSERT_IS_NULL(end_resp);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //cleanup
+    queryResponse_free(query_resp);
+    prov_sc_query_iterator_destroy(iterator);
+    prov_sc_destroy(sc);
+}
+
 END_TEST_SUITE(provisioning_service_client_ut);
\ No newline at end of file